@@ -75,6 +75,7 @@
 #include "mathinst.h"
 #include "parentchild.h"
 #include "tmpnum.h"
+#include "instarena.h"
 #include "instmacro.h" /* some of this should move to relation.c */
 
 #if ATDEBUG
@@ -123,7 +124,7 @@ struct Instance *CopyAnonRelationInstance(struct Instance *newparent,
   assert(InstanceKind(protorel) == REL_INST);
   src = RELN_INST(protorel);
   size = GetByteSize(src->desc);
-  result = RELN_INST(ascmalloc((unsigned)size));
+  result = RELN_INST(AllocInstanceMemory(REL_INST,(unsigned)size));
   AssertMemory(result);
 
   ascbcopy((char *)src,(char *)result,(int)size);
@@ -220,7 +221,7 @@ CopyAnonRelationArrayInstance(struct Instance *newparent,
   struct ArrayInstance *ary,*result;
   AssertMemory(proto);
   ary = ARY_INST(proto);
-  result = ARY_INST(ASC_NEW(struct ArrayInstance));
+  result = ARY_INST(AllocInstanceMemory(ary->t,sizeof(struct ArrayInstance)));
   AssertMemory(result);
   result->t = ary->t;
   result->pending_entry = NULL;
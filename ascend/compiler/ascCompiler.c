@@ -238,6 +238,7 @@ void Asc_CompilerDestroy(void)
 
   importhandler_destroylibrary();
 
+  BlackBoxDestroyPool();        /* stop finite-difference threads */
   DestroyExtFuncLibrary();      /* deallocate external function nodes */
 
   /* some of the following calls are order dependent. see the headers.
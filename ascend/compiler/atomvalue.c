@@ -51,6 +51,9 @@
 #include "cmpfunc.h"
 #include "atomvalue.h"
 
+/* SetRealAtomValue calls made by this thread, see RealAtomWriteCounter */
+static ASC_THREAD_LOCAL unsigned long g_real_atom_writes = 0;
+
 unsigned AtomAssigned(CONST struct Instance *i){
   assert(i!=NULL);
   AssertMemory(i);
@@ -138,7 +141,8 @@ double RealAtomValue(CONST struct Instance *i){
 void SetRealAtomValue(struct Instance *i, double d, unsigned int depth){
   assert(i!=NULL);
   AssertMemory(i);
-  
+  g_real_atom_writes++;
+
   switch(i->t) {
   case REAL_CONSTANT_INST:
     if (AtomAssigned(i)) {
@@ -173,6 +177,10 @@ void SetRealAtomValue(struct Instance *i, double d, unsigned int depth){
   }
 }
 
+CONST unsigned long *RealAtomWriteCounter(void){
+  return &g_real_atom_writes;
+}
+
 void SetRealAtomDims(struct Instance *i, CONST dim_type *dim){
   assert(i!=NULL);
   AssertMemory(i);
@@ -93,6 +93,14 @@ ASC_DLLSPEC void SetRealAtomValue(struct Instance *i, double d, unsigned depth);
  *  precidence over every other assignment.
  */
 
+ASC_DLLSPEC CONST unsigned long *RealAtomWriteCounter(void);
+/**<
+ *  Return the address of the calling thread's count of SetRealAtomValue
+ *  calls. Copies of real values kept outside the instance tree (see
+ *  struct var_store in system/var.h) note the address and the count when
+ *  they are filled; if either differs later, an atom may have changed.
+ */
+
 ASC_DLLSPEC CONST dim_type*RealAtomDims(CONST struct Instance *i);
 /**<
  *  Return the dimensions attribute of instance i.  This works only on
@@ -32,6 +32,13 @@ TIMESTAMP = -DTIMESTAMP="\"by `whoami`@`hostname`\""
 #include "bintoken.h"
 
 #include <unistd.h> /* for getpid() */
+#include <errno.h>
+#ifndef WIN32
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <dirent.h>
+# include <utime.h>
+#endif
 
 #include <ascend/general/platform.h>
 #include <ascend/general/ascMalloc.h>
@@ -44,6 +51,7 @@ TIMESTAMP = -DTIMESTAMP="\"by `whoami`@`hostname`\""
 #include <ascend/general/pretty.h>
 #include <ascend/general/ospath.h>
 #include <ascend/utilities/ascEnvVar.h>
+#include <ascend/general/env.h>
 
 #include "functype.h"
 #include "expr_types.h"
@@ -91,6 +99,7 @@ struct bt_table {
   int btable; /* check id */
   int refcount; /* total number of relation shares with btable = our number */
   int size; /* may be larger than refcount. */
+  int cached; /* library is in the cache directory: never delete it */
 };
 
 /*
@@ -114,7 +123,13 @@ struct bt_data {
   unsigned long maxrels; /* no more than this many C relations per file */
   int verbose; /* comments in generated code */
   int housekeep; /* if !=0, generated src files are deleted sometimes. */
-} g_bt_data = {NULL,0,0,NULL,0,"ERRARCHIVE",NULL,NULL,NULL,NULL,NULL,1,0,0};
+  /* persistent cache of compiled shards */
+  char *cachedir; /* NULL if no cache */
+  unsigned long cachemax; /* size limit in bytes, 0 for none */
+} g_bt_data = {NULL,0,0,NULL,0,"ERRARCHIVE",NULL,NULL,NULL,NULL,NULL,1,0,0,NULL,0};
+
+/* default size limit of the bintoken cache */
+#define BT_CACHE_MAXBYTES (256UL*1024*1024)
 
 /**
  *  In the C++ interface, the arguments of BinTokenSetOptions need to be
@@ -200,6 +215,16 @@ int BinTokenSetOptionsDefault(){
   int res = BinTokenSetOptions(srcn,NULL,libn,buildcmd,rmcmd,1000,0/*verbose*/,1/*housekeep*/);
 #endif
   ASC_FREE(buildcmd);
+
+  /* cache compiled code, if a cache directory is given */
+  env_import(ASC_ENV_BTCACHE,getenv,Asc_PutEnv,0);
+  char *cachedir = Asc_GetEnv(ASC_ENV_BTCACHE);
+  if(cachedir != NULL){
+    if(strlen(cachedir)){
+      res += BinTokenSetCache(cachedir,BT_CACHE_MAXBYTES);
+    }
+    ASC_FREE(cachedir);
+  }
   return res;
 #endif
 }
@@ -234,6 +259,26 @@ int BinTokenSetOptions(CONST char *srcname,
   return err;
 }
 
+int BinTokenSetCache(CONST char *cachedir, unsigned long maxbytes){
+#ifdef WIN32
+  if(cachedir != NULL){
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"Bintoken cache not implemented for Windows");
+    return 1;
+  }
+#else
+  struct stat st;
+  if(cachedir != NULL && stat(cachedir,&st)){
+    if(errno != ENOENT || mkdir(cachedir,0777)){
+      ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to create bintoken cache directory '%s'",cachedir);
+      return 1;
+    }
+  }
+#endif
+  g_bt_data.cachemax = maxbytes;
+  MSG("cache = %s",cachedir);
+  return bt_string_replace(cachedir,&(g_bt_data.cachedir));
+}
+
 
 /*
  * grows the table when need be.
@@ -273,6 +318,7 @@ void BinTokenClearTables(void)
   g_bt_data.captables = 0;
   g_bt_data.nextid = 0;
   BinTokenSetOptions(NULL,NULL,NULL,NULL,NULL,1,0,0);
+  BinTokenSetCache(NULL,0);
 }
 
 /*
@@ -295,7 +341,7 @@ void BinTokenDeleteReference(int btable)
     MSG("Unloading btable=%d: %s",btable,g_bt_data.tables[btable].name);
     Asc_DynamicUnLoad(g_bt_data.tables[btable].name);
 
-    if(g_bt_data.housekeep){
+    if(g_bt_data.housekeep && !g_bt_data.tables[btable].cached){
       if(g_bt_data.libname && strlen(g_bt_data.libname)){
           char *cbuf;
           cbuf = ASC_NEW_ARRAY(char,strlen(g_bt_data.unlinkcommand)+1+strlen(g_bt_data.libname)+1);
@@ -661,6 +707,42 @@ void ResizeIndices(struct Instance *rel, struct reusable_rxnd *r)
   r->cap = newlen;
 }
 
+/*
+ * Collects the unique code strings of the relations in rellist into eql,
+ * which must have been initialised for gl_length(rellist) relations.
+ * error[c-1] is set to BTE_ok if the code for relation c was generated.
+ * Returns the number of relations for which code was generated.
+ */
+static
+int BinTokenUniqueEqns(struct gl_list_t *rellist,
+                       struct bintoken_eqlist *eql,
+                       int *error)
+{
+  struct Instance *i;
+  char *str;
+  int slen;
+  unsigned long c, len;
+  int eqns_done = 0;
+  struct reusable_rxnd rrd = {{"x[",NULL,"]"},0};
+
+  len = gl_length(rellist);
+  for (c=1; c <= len; c++) {
+    i = gl_fetch(rellist,c);
+    /* make space and configure for subscript translation from 1 to 0 */
+    ResizeIndices(i,&rrd);
+    error[c-1] = GetResidualString(i,(int)c,&(rrd.rd),relio_C,&slen,&str);
+    if (error[c-1] == BTE_ok) {
+      eqns_done++;
+      if (BinTokenAddUniqueEqn(eql,(int)c,str,slen) == 0) {
+        ASC_FREE(str);
+      } /* else string is kept in eql and killed later */
+    }
+    /* else { eql.rel2U[c] = -1; } needed? */
+  }
+  ResizeIndices(NULL,&rrd);
+  return eqns_done;
+}
+
 /*
  * generate code for a table of function pointers and the function
  * pointers also in an archive load function.
@@ -676,14 +758,11 @@ enum bintoken_error BinTokenSharesToC(struct Instance *root,
   int *error;
   FILE *fp;
   struct Instance *i;
-  char *str;
-  int slen;
   struct bintoken_unique_eqn *eqn;
   struct bintoken_eqlist eql;
   unsigned long c, len;
   int pid;
   int eqns_done;
-  struct reusable_rxnd rrd = {{"x[",NULL,"]"},0};
 
   if (root == NULL ||  rellist == NULL) {
     return BTE_ok;
@@ -696,7 +775,6 @@ enum bintoken_error BinTokenSharesToC(struct Instance *root,
   if (fp == NULL) {
     return BTE_write;
   }
-  eqns_done = 0;
   error = ASC_NEW_ARRAY(int,len);
   WritePrologue(fp,root,len,verbose);
 
@@ -714,20 +792,7 @@ enum bintoken_error BinTokenSharesToC(struct Instance *root,
   }
 
   /* get unique set of code strings. */
-  for (c=1; c <= len; c++) {
-    i = gl_fetch(rellist,c);
-    /* make space and configure for subscript translation from 1 to 0 */
-    ResizeIndices(i,&rrd);
-    error[c-1] = GetResidualString(i,(int)c,&(rrd.rd),relio_C,&slen,&str);
-    if (error[c-1] == BTE_ok) {
-      eqns_done++;
-      if (BinTokenAddUniqueEqn(&eql,(int)c,str,slen) == 0) {
-        ASC_FREE(str);
-      } /* else string is kept in eql and killed later */
-    }
-    /* else { eql.rel2U[c] = -1; } needed? */
-  }
-  ResizeIndices(NULL,&rrd);
+  eqns_done = BinTokenUniqueEqns(rellist,&eql,error);
   if (!eqns_done) {
     /* no generable code. clean up and leave. */
     fclose(fp);
@@ -808,6 +873,7 @@ void BinTokenHookToTable(int entry, enum bintoken_kind type)
   g_bt_data.tables[entry].size = g_bt_data.newtablesize;
   g_bt_data.tables[entry].btable = entry;
   g_bt_data.tables[entry].type = type;
+  g_bt_data.tables[entry].cached = 0;
   g_bt_data.newtable = NULL;
   g_bt_data.newtablesize = 0;
 }
@@ -884,6 +950,468 @@ void BinTokenErrorMessage(enum bintoken_error err,
   ERROR_REPORTER_HERE(ASC_PROG_ERR,"%s: %s",filename, mess);
 }
 
+/*
+ * Persistent cache of compiled code.
+ *
+ * The unique equations are split into shards by a hash of their code, and
+ * each shard is written, built and loaded as a library of its own, with a
+ * table indexed by the position of each equation within the shard. The
+ * library is kept in the cache directory under a name made from a hash of
+ * the code of the shard and of the build command, so it is found again
+ * whenever the same equations come up, in this run or a later one.
+ */
+
+#define BT_SHARD_EQNS 64 /* aim for no more equations than this per shard */
+#define BT_MAX_SHARDS 64 /* power of 2 */
+#define BT_CACHE_PREFIX "ascbt_"
+#define BT_CACHE_VERSION "1" /* change if the generated code changes */
+
+#define BT_HASH_INIT 14695981039346656037ULL
+
+/* 64-bit FNV-1a hash of len bytes at str, continuing from h */
+static
+unsigned long long BinTokenHash(unsigned long long h, CONST char *str,
+                                unsigned long len)
+{
+  unsigned long c;
+  for (c = 0; c < len; c++) {
+    h ^= (unsigned char)str[c];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/*
+ * hash of the build command with the source, object and library file
+ * names (which typically contain the process id) replaced by placeholders.
+ */
+static
+unsigned long long BinTokenHashCommand(unsigned long long h)
+{
+  static CONST char *placeholders[3] = {"$SRC","$OBJ","$LIB"};
+  CONST char *names[3];
+  CONST char *p = g_bt_data.buildcommand;
+  unsigned long n;
+  int k, matched;
+  names[0] = g_bt_data.srcname;
+  names[1] = g_bt_data.objname;
+  names[2] = g_bt_data.libname;
+  while (*p != '\0') {
+    matched = 0;
+    for (k = 0; k < 3; k++) {
+      if (names[k] == NULL) continue;
+      n = strlen(names[k]);
+      if (n && strncmp(p,names[k],n) == 0) {
+        h = BinTokenHash(h,placeholders[k],strlen(placeholders[k]));
+        p += n;
+        matched = 1;
+        break;
+      }
+    }
+    if (!matched) {
+      h = BinTokenHash(h,p,1);
+      p++;
+    }
+  }
+  return h;
+}
+
+/* hash identifying the library built from the n equations in eqns */
+static
+unsigned long long BinTokenHashShard(struct bintoken_unique_eqn **eqns, int n)
+{
+  unsigned long long h = BT_HASH_INIT;
+  int k;
+  h = BinTokenHash(h,BT_CACHE_VERSION,strlen(BT_CACHE_VERSION));
+#ifdef HAVE_ERF
+  h = BinTokenHash(h,"erf",3);
+#endif
+  h = BinTokenHashCommand(h);
+  for (k = 0; k < n; k++) {
+    h = BinTokenHash(h,"\n",1);
+    h = BinTokenHash(h,eqns[k]->str,(unsigned long)eqns[k]->len);
+  }
+  return h;
+}
+
+/*
+ * Writes the code for a shard of n equations, as functions r_0..r_{n-1}
+ * and a table with those at 1..n.
+ */
+static
+enum bintoken_error BinTokenShardToC(struct Instance *root,
+                                     struct gl_list_t *rellist,
+                                     struct bintoken_unique_eqn **eqns,
+                                     int n, char *srcname, char *regname,
+                                     int verbose)
+{
+  FILE *fp;
+  struct Instance *i;
+  int k;
+
+  fp = fopen(srcname,"w+");
+  if (fp == NULL) {
+    return BTE_write;
+  }
+  WritePrologue(fp,root,(unsigned long)n,verbose);
+  for (k = 0; k < n; k++) {
+    i = gl_fetch(rellist,eqns[k]->firstrel);
+    WriteResidualCode(fp,i,k,verbose,eqns[k]->str,eqns[k]->refcount);
+    WriteGradientCode(fp,i,k,verbose,eqns[k]->str,eqns[k]->refcount);
+  }
+  FPRINTF(fp,"\n\nint ASC_EXPORT %s(){\n",regname);
+  CLINE("\tint status;");
+  FPRINTF(fp,"\tstatic struct TableC g_ctable[%d] =\n",n+1);
+  CLINE("\t\t{ {NULL, NULL}");
+  for (k = 0; k < n; k++) {
+    FPRINTF(fp,"\t\t\t,{r_%d, NULL}\n",k);
+  }
+  CLINE("\t\t};");
+  FPRINTF(fp,"\tstatus = ExportBinTokenCTable(g_ctable,%d);\n",n+1);
+  CLINE("\treturn status;");
+  CLINE("}");
+  if (fclose(fp)) {
+    return BTE_write;
+  }
+  return BTE_ok;
+}
+
+/* deletes a file using the unlinkcommand */
+static
+void BinTokenUnlink(CONST char *name)
+{
+  char *cbuf;
+  int rc;
+  if (name == NULL || !strlen(name)) {
+    return;
+  }
+  cbuf = ASC_NEW_ARRAY(char,strlen(g_bt_data.unlinkcommand)+1+strlen(name)+1);
+  sprintf(cbuf,"%s %s",g_bt_data.unlinkcommand,name);
+  rc = system(cbuf); /* we don't care if the delete fails */
+  if (rc) {
+    MSG("delete failed: %d",rc);
+  }
+  ASC_FREE(cbuf);
+}
+
+/* returns the table holding the library at path, if loaded, else 0 */
+static
+int BinTokenFindLoaded(CONST char *path)
+{
+  int b;
+  for (b = 1; b <= g_bt_data.nextid; b++) {
+    if (g_bt_data.tables[b].type != BT_error && g_bt_data.tables[b].cached
+      && strcmp(g_bt_data.tables[b].name,path) == 0
+    ){
+      return b;
+    }
+  }
+  return 0;
+}
+
+#ifndef WIN32
+/*
+ * moves the library just built into the cache as path, via a temporary
+ * name so that other processes never see a partly written library.
+ */
+static
+int BinTokenCacheInstall(CONST char *libname, CONST char *path)
+{
+  char tmp[PATH_MAX];
+  char buf[BUFSIZ];
+  FILE *in, *out;
+  size_t n;
+  int err = 0;
+
+  if (snprintf(tmp,PATH_MAX,"%s.%d.tmp",path,(int)getpid()) >= PATH_MAX) {
+    return 1; /* path too long */
+  }
+  if (rename(libname,tmp)) {
+    /* eg on a different filesystem: copy it */
+    in = fopen(libname,"rb");
+    if (in == NULL) {
+      return 1;
+    }
+    out = fopen(tmp,"wb");
+    if (out == NULL) {
+      fclose(in);
+      return 1;
+    }
+    while ((n = fread(buf,1,BUFSIZ,in)) > 0) {
+      if (fwrite(buf,1,n,out) != n) {
+        err = 1;
+        break;
+      }
+    }
+    fclose(in);
+    if (fclose(out)) {
+      err = 1;
+    }
+    remove(libname);
+  }
+  if (err || rename(tmp,path)) {
+    remove(tmp);
+    return 1;
+  }
+  return 0;
+}
+
+struct bt_cachefile {
+  char *name;
+  time_t mtime;
+  unsigned long size;
+};
+
+static
+int CmpCacheFileTime(CONST void *a, CONST void *b)
+{
+  time_t ta = ((CONST struct bt_cachefile *)a)->mtime;
+  time_t tb = ((CONST struct bt_cachefile *)b)->mtime;
+  return (ta < tb) ? -1 : (ta > tb);
+}
+
+/*
+ * deletes the least recently used libraries (by modification time, which
+ * is updated on every use) until the cache is within its size limit.
+ * Libraries loaded by this process are kept.
+ */
+static
+void BinTokenCacheEvict(void)
+{
+  DIR *dir;
+  struct dirent *e;
+  struct stat st;
+  struct bt_cachefile *files = NULL;
+  int nfiles = 0, cap = 0, k;
+  unsigned long total = 0;
+  char path[PATH_MAX];
+  size_t plen = strlen(BT_CACHE_PREFIX);
+
+  if (g_bt_data.cachemax == 0) {
+    return;
+  }
+  dir = opendir(g_bt_data.cachedir);
+  if (dir == NULL) {
+    return;
+  }
+  while ((e = readdir(dir)) != NULL) {
+    if (strncmp(e->d_name,BT_CACHE_PREFIX,plen) != 0) continue;
+    snprintf(path,PATH_MAX,"%s/%s",g_bt_data.cachedir,e->d_name);
+    if (stat(path,&st) || !S_ISREG(st.st_mode)) continue;
+    if (nfiles == cap) {
+      cap = cap ? 2*cap : 64;
+      files = (struct bt_cachefile *)ascrealloc(files,cap*sizeof(struct bt_cachefile));
+    }
+    files[nfiles].name = ASC_STRDUP(path);
+    files[nfiles].mtime = st.st_mtime;
+    files[nfiles].size = (unsigned long)st.st_size;
+    total += files[nfiles].size;
+    nfiles++;
+  }
+  closedir(dir);
+
+  if (total > g_bt_data.cachemax) {
+    qsort(files,nfiles,sizeof(struct bt_cachefile),CmpCacheFileTime);
+    for (k = 0; k < nfiles && total > g_bt_data.cachemax; k++) {
+      if (BinTokenFindLoaded(files[k].name)) continue;
+      MSG("Evicting %s",files[k].name);
+      if (remove(files[k].name) == 0) {
+        total -= files[k].size;
+      }
+    }
+  }
+  for (k = 0; k < nfiles; k++) {
+    ASC_FREE(files[k].name);
+  }
+  if (files != NULL) {
+    ASC_FREE(files);
+  }
+}
+#endif /* WIN32 */
+
+/*
+ * loads the library of a shard into a new table.
+ * returns the table, or 0 on failure.
+ */
+static
+int BinTokenLoadShard(CONST char *path, CONST char *regname)
+{
+  int b;
+  ++(g_bt_data.nextid);
+  BinTokenCheckCapacity();
+  b = g_bt_data.nextid;
+  if (Asc_DynamicLoad(path,regname) != 0) {
+    error_reporter(ASC_PROG_WARNING,path,0,"Failed to load library (init function %s)",regname);
+    BinTokenResetHooks();
+    return 0;
+  }
+  BinTokenHookToTable(b,BT_C);
+  g_bt_data.tables[b].refcount = 0;
+  g_bt_data.tables[b].name = ASC_STRDUP((char *)path);
+  g_bt_data.tables[b].cached = 1;
+  return b;
+}
+
+/*
+ * finds the library for a shard of n equations in the cache, or builds it
+ * there, and loads it if it's not loaded already.
+ * returns the table for it, or 0 on failure. *built is incremented if the
+ * library had to be built.
+ */
+static
+int BinTokenCacheShard(struct Instance *root, struct gl_list_t *rellist,
+                       struct bintoken_unique_eqn **eqns, int n,
+                       int verbose, int *built)
+{
+#ifdef WIN32
+  return 0;
+#else
+  char path[PATH_MAX];
+  char regname[64];
+  struct stat st;
+  unsigned long long h;
+  enum bintoken_error status;
+  int b;
+
+  h = BinTokenHashShard(eqns,n);
+  snprintf(path,PATH_MAX,"%s/" BT_CACHE_PREFIX "%016llx" ASC_SHLIBSUFFIX,
+           g_bt_data.cachedir,h);
+  snprintf(regname,sizeof(regname),"BinTokenArch_%016llx",h);
+
+  b = BinTokenFindLoaded(path);
+  if (b) {
+    MSG("Shard %016llx already loaded",h);
+    return b;
+  }
+
+  if (stat(path,&st) == 0) {
+    MSG("Shard %016llx found in cache",h);
+    utime(path,NULL); /* mark as recently used */
+  } else {
+    MSG("Building shard %016llx (%d equations)",h,n);
+    status = BinTokenShardToC(root,rellist,eqns,n,g_bt_data.srcname,regname,verbose);
+    if (status != BTE_ok) {
+      BinTokenErrorMessage(status,root,g_bt_data.srcname,g_bt_data.buildcommand);
+      return 0;
+    }
+    status = BinTokenCompileC(g_bt_data.buildcommand);
+    if (status != BTE_ok) {
+      BinTokenErrorMessage(status,root,g_bt_data.srcname,g_bt_data.buildcommand);
+      return 0; /* leave source file there to debug */
+    }
+    if (g_bt_data.housekeep) {
+      BinTokenUnlink(g_bt_data.srcname);
+      BinTokenUnlink(g_bt_data.objname);
+    }
+    if (BinTokenCacheInstall(g_bt_data.libname,path)) {
+      BinTokenErrorMessage(BTE_write,root,path,g_bt_data.buildcommand);
+      return 0;
+    }
+    (*built)++;
+  }
+  return BinTokenLoadShard(path,regname);
+#endif
+}
+
+/*
+ * generates, builds or finds in the cache, and loads, the code for the
+ * relations in rellist, shard by shard, and attaches it to the relations.
+ * Relations in shards that fail are left without binary tokens.
+ */
+static
+enum bintoken_error BinTokenSharesToCache(struct Instance *root,
+                                          struct gl_list_t *rellist,
+                                          int verbose)
+{
+  struct bintoken_eqlist eql;
+  struct bintoken_unique_eqn *eqn, **eqns;
+  unsigned long c, len, nu;
+  int *error, *shardof, *localof, *start, *fill, *btable;
+  int nshards, s, u, built = 0;
+  enum bintoken_error status = BTE_ok;
+
+  len = gl_length(rellist);
+  if (g_bt_data.libname == NULL) {
+    return BTE_build;
+  }
+  if (InitEQData(&eql,(int)len) != 0) {
+    return BTE_mem;
+  }
+  error = ASC_NEW_ARRAY(int,len);
+  if (!BinTokenUniqueEqns(rellist,&eql,error)) {
+    ASC_FREE(error);
+    DestroyEQData(&eql);
+    return BTE_badrel;
+  }
+
+  /* share the unique equations out among the shards, keeping them in the
+   * (content-determined) order of eql.ue within each shard */
+  nu = gl_length(eql.ue);
+  for (nshards = 1; nshards < BT_MAX_SHARDS && (unsigned long)nshards * BT_SHARD_EQNS < nu; nshards *= 2);
+  shardof = ASC_NEW_ARRAY(int,nu);
+  localof = ASC_NEW_ARRAY(int,nu);
+  start = ASC_NEW_ARRAY_CLEAR(int,nshards+1);
+  fill = ASC_NEW_ARRAY(int,nshards);
+  eqns = ASC_NEW_ARRAY(struct bintoken_unique_eqn *,nu);
+  btable = ASC_NEW_ARRAY(int,nshards);
+  for (c = 1; c <= nu; c++) {
+    eqn = (struct bintoken_unique_eqn *)gl_fetch(eql.ue,c);
+    s = (int)(BinTokenHash(BT_HASH_INIT,eqn->str,(unsigned long)eqn->len) >> 40)
+        & (nshards - 1);
+    shardof[eqn->indexU] = s;
+    start[s+1]++;
+  }
+  for (s = 0; s < nshards; s++) {
+    start[s+1] += start[s];
+    fill[s] = start[s];
+  }
+  for (c = 1; c <= nu; c++) {
+    eqn = (struct bintoken_unique_eqn *)gl_fetch(eql.ue,c);
+    s = shardof[eqn->indexU];
+    localof[eqn->indexU] = fill[s] - start[s];
+    eqns[fill[s]++] = eqn;
+  }
+
+  for (s = 0; s < nshards; s++) {
+    btable[s] = 0;
+    if (start[s+1] > start[s]) {
+      btable[s] = BinTokenCacheShard(root,rellist,eqns + start[s],
+                                     start[s+1] - start[s],verbose,&built);
+      if (!btable[s]) {
+        status = BTE_build;
+      }
+    }
+  }
+  MSG("%lu unique equations in %d shards, %d built",nu,nshards,built);
+
+  for (c = 1; c <= len; c++) {
+    if (error[c-1] != BTE_ok) continue;
+    u = eql.rel2U[c];
+    s = shardof[u];
+    if (btable[s]) {
+      RelationSetBinTokens((struct Instance *)gl_fetch(rellist,c),
+                           btable[s],localof[u] + 1);
+      g_bt_data.tables[btable[s]].refcount++;
+    }
+  }
+
+#ifndef WIN32
+  if (built) {
+    BinTokenCacheEvict();
+  }
+#endif
+
+  ASC_FREE(btable);
+  ASC_FREE(eqns);
+  ASC_FREE(fill);
+  ASC_FREE(start);
+  ASC_FREE(localof);
+  ASC_FREE(shardof);
+  ASC_FREE(error);
+  DestroyEQData(&eql);
+  return status;
+}
+
 void BinTokensCreate(struct Instance *root, enum bintoken_kind method){
   struct gl_list_t *rellist;
   char *cbuf;
@@ -924,6 +1452,16 @@ void BinTokensCreate(struct Instance *root, enum bintoken_kind method){
 
   switch(method){
   case BT_C:
+    if(g_bt_data.cachedir != NULL){
+      /* find or build code in the cache */
+      status = BinTokenSharesToCache(root,rellist,verbose);
+      if(status != BTE_ok){
+        BinTokenErrorMessage(status,root,g_bt_data.cachedir,buildcommand);
+      }else{
+        MSG("BinTokenSharesToCache completed OK");
+      }
+      break;
+    }
     /* generate code */
     status = BinTokenSharesToC(root,rellist,srcname,verbose);
     if(status != BTE_ok){
@@ -91,7 +91,32 @@ ASC_DLLSPEC int BinTokenSetOptionsDefault();
 	This function sets bintoken parameters in an automated way that
 	should hopefully work on most standard systems. This approach
 	makes use of two env vars to help locate the btprolog.h and libascend.so
-	files during linking.
+	files during linking. If the env var ASCENDBTCACHE is set, compiled
+	code is cached in that directory (see BinTokenSetCache).
+*/
+
+ASC_DLLSPEC int BinTokenSetCache(CONST char *cachedir, unsigned long maxbytes);
+/**<
+	Keep compiled bintoken libraries in the directory cachedir, so that
+	they can be reused by later instantiations, in this or later runs,
+	without compiling again.
+
+	The unique equations of a model are split into shards by a hash of
+	their code, and each shard is compiled to its own library, named by a
+	hash of the code of its equations and of the build command. A change
+	to some equations of a model then only requires the shards containing
+	them to be recompiled.
+
+	Once the libraries in the cache total more than maxbytes, the least
+	recently used ones (that are not currently loaded) are deleted.
+
+	The build options from BinTokenSetOptions are still used to compile
+	each shard; the resulting library is then moved into the cache.
+
+	@param cachedir  cache directory (created if necessary), or NULL to
+	                 disable the cache.
+	@param maxbytes  size limit for the cache, or 0 for no limit.
+	@return 0 on success
 */
 
 /**
@@ -74,6 +74,7 @@
 #include "cmpfunc.h"
 #include "setinstval.h"
 #include "copyinst.h"
+#include "instarena.h"
 
 /*
  * This function simply makes a first pass at determining
@@ -152,7 +153,7 @@ struct Instance *CopyReal(CONST struct Instance *i)
     AssertMemory(i);
     src = RA_INST(i);
     size = GetByteSize(src->desc);
-    result = RA_INST(ascmalloc((unsigned)size));
+    result = RA_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_PARENTS);
     result->alike_ptr = INST(result);
@@ -171,7 +172,7 @@ struct Instance *CopyReal(CONST struct Instance *i)
     AssertMemory(i);
     src = RC_INST(i);
     size = GetByteSize(src->desc);
-    result = RC_INST(ascmalloc((unsigned)size));
+    result = RC_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_CONSTANT_PARENTS);
     result->alike_ptr = INST(result);
@@ -194,7 +195,7 @@ struct Instance *CopyInteger(CONST struct Instance *i)
     AssertMemory(i);
     src = IA_INST(i);
     size = GetByteSize(src->desc);
-    result = IA_INST(ascmalloc((unsigned)size));
+    result = IA_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_PARENTS);
     result->alike_ptr = INST(result);
@@ -214,7 +215,7 @@ struct Instance *CopyInteger(CONST struct Instance *i)
     AssertMemory(i);
     src = IC_INST(i);
     size = GetByteSize(src->desc);
-    result = IC_INST(ascmalloc((unsigned)size));
+    result = IC_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_ICONSTANT_PARENTS);
     result->alike_ptr = INST(result);
@@ -237,7 +238,7 @@ struct Instance *CopyBoolean(CONST struct Instance *i)
     AssertMemory(i);
     src = BA_INST(i);
     size = GetByteSize(src->desc);
-    result = BA_INST(ascmalloc((unsigned)size));
+    result = BA_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_PARENTS);
     result->alike_ptr = INST(result);
@@ -258,7 +259,7 @@ struct Instance *CopyBoolean(CONST struct Instance *i)
     AssertMemory(i);
     src = BC_INST(i);
     size = GetByteSize(src->desc);
-    result = BC_INST(ascmalloc((unsigned)size));
+    result = BC_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_PARENTS);
     result->alike_ptr = INST(result);
@@ -277,7 +278,7 @@ struct Instance *CopySetInst(CONST struct Instance *i)
   AssertMemory(i);
   src = SA_INST(i);
   size = GetByteSize(src->desc);
-  result = SA_INST(ascmalloc((unsigned)size));
+  result = SA_INST(AllocInstanceMemory(i->t,(unsigned)size));
   ascbcopy((char *)src,(char *)result,(int)size);
   if (src->list!=NULL)
     result->list = CopySet(src->list);
@@ -305,7 +306,7 @@ struct Instance *CopySymbolInst(CONST struct Instance *i)
     AssertMemory(i);
     src = SYMA_INST(i);
     size = GetByteSize(src->desc);
-    result = SYMA_INST(ascmalloc((unsigned)size));
+    result = SYMA_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_PARENTS);
     result->alike_ptr = INST(result);
@@ -324,7 +325,7 @@ struct Instance *CopySymbolInst(CONST struct Instance *i)
     AssertMemory(i);
     src = SYMC_INST(i);
     size = GetByteSize(src->desc);
-    result = SYMC_INST(ascmalloc((unsigned)size));
+    result = SYMC_INST(AllocInstanceMemory(i->t,(unsigned)size));
     ascbcopy((char *)src,(char *)result,(int)size);
     result->parents = gl_create(AVG_ICONSTANT_PARENTS);
     result->alike_ptr = INST(result);
@@ -343,7 +344,7 @@ struct Instance *CopyRelationInst(CONST struct Instance *i)
   AssertMemory(i);
   src = RELN_INST(i);
   size = GetByteSize(src->desc);
-  result = RELN_INST(ascmalloc((unsigned)size));
+  result = RELN_INST(AllocInstanceMemory(i->t,(unsigned)size));
   ascbcopy((char *)src,(char *)result,(int)size);
   result->parent[0] = NULL;
   result->parent[1] = NULL;
@@ -373,7 +374,7 @@ struct Instance *CopyLogRelInst(CONST struct Instance *i)
   AssertMemory(i);
   src = LRELN_INST(i);
   size = GetByteSize(src->desc);
-  result = LRELN_INST(ascmalloc((unsigned)size));
+  result = LRELN_INST(AllocInstanceMemory(i->t,(unsigned)size));
   ascbcopy((char *)src,(char *)result,(int)size);
   result->parent[0] = NULL;
   result->parent[1] = NULL;
@@ -403,7 +404,7 @@ struct Instance *CopyWhenInst(CONST struct Instance *i)
   AssertMemory(i);
   src = W_INST(i);
   size = sizeof(struct WhenInstance);
-  result = W_INST(ascmalloc((unsigned)size));
+  result = W_INST(AllocInstanceMemory(i->t,(unsigned)size));
   ascbcopy((char *)src,(char *)result,(int)size);
   result->parent[0] = NULL;
   result->parent[1] = NULL;
@@ -431,7 +432,8 @@ struct Instance *CopyModel(CONST struct Instance *i)
   type = mod->desc;
   CopyTypeDesc(type);
   num_children = ChildListLen(GetChildList(type));
-  result = MOD_INST(ascmalloc((unsigned)sizeof(struct ModelInstance)+
+  result = MOD_INST(AllocInstanceMemory(MODEL_INST,
+			      (unsigned)sizeof(struct ModelInstance)+
 			      (unsigned)num_children*
 			      (unsigned)sizeof(struct Instance *)));
   result->t = MODEL_INST;
@@ -481,7 +483,7 @@ static struct Instance *CopyArray(CONST struct Instance *i)
   struct ArrayInstance *ary,*result;
   AssertMemory(i);
   ary = ARY_INST(i);
-  result = ARY_INST(ascmalloc(sizeof(struct ArrayInstance)));
+  result = ARY_INST(AllocInstanceMemory(i->t,sizeof(struct ArrayInstance)));
   result->t = ary->t;
   result->pending_entry = NULL;
   result->desc = ary->desc;
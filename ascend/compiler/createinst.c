@@ -73,6 +73,7 @@
 #include "linkinst.h"
 #include "instmacro.h"
 #include "instquery.h"
+#include "instarena.h"
 
 void ZeroNewChildrenEntries(struct Instance **child_ary,
 			    unsigned long int num)
@@ -84,6 +85,18 @@ void ZeroNewChildrenEntries(struct Instance **child_ary,
   }
 }
 
+/*
+ * Prototypes outlive the simulation being built, so their copies are
+ * made on the heap rather than in the simulation's arena.
+ */
+static void AddPrototypeCopy(struct Instance *i)
+{
+  struct InstanceArena *old;
+  old = SetInstanceArena(NULL);
+  AddPrototype(CopyInstance(i));
+  SetInstanceArena(old);
+}
+
 /*
  * Create a new model instance. The semantics at this time is
  * as follows: We lookup for a prototype of the model in the
@@ -101,7 +114,7 @@ struct Instance *CreateModelInstance(struct TypeDescription *type)
     CopyTypeDesc(type);
     num_children = ChildListLen(GetChildList(type));
     stats = GetStatementList(type);
-    result = MOD_INST(ascmalloc(
+    result = MOD_INST(AllocInstanceMemory(MODEL_INST,
                 (unsigned)sizeof(struct ModelInstance)
                 + (unsigned)num_children * (unsigned)sizeof(struct Instance *)
     ));
@@ -174,6 +187,7 @@ struct Instance *CreateSimulationInstance(struct TypeDescription *type,
   result->name = name;
   result->extvars = NULL;
   result->slvreq_hooks = NULL;
+  result->arena = CreateInstanceArena();
   return INST(result);
 }
 
@@ -319,7 +333,7 @@ struct Instance *CreateRealInstance(struct TypeDescription *type){
     if ((result=RA_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
       num_children = ChildListLen(GetChildList(type));
-      result = RA_INST(ascmalloc(GetByteSize(type)));
+      result = RA_INST(AllocInstanceMemory(REAL_ATOM_INST,GetByteSize(type)));
       result->t = REAL_ATOM_INST;
       result->interface_ptr = NULL;
       result->parents = gl_create(AVG_PARENTS);
@@ -359,7 +373,7 @@ struct Instance *CreateRealInstance(struct TypeDescription *type){
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }else{ /* instance type has a prototype which can be copied */
       result = RA_INST(CopyInstance(INST(result)));
@@ -375,7 +389,7 @@ struct Instance *CreateRealInstance(struct TypeDescription *type){
   struct RealConstantInstance *result;
     if((result=RC_INST(LookupPrototype(GetName(type))))==NULL){
       CopyTypeDesc(type);
-      result = RC_INST(ascmalloc(GetByteSize(type)));
+      result = RC_INST(AllocInstanceMemory(REAL_CONSTANT_INST,GetByteSize(type)));
       result->t = REAL_CONSTANT_INST;
       result->parents = gl_create(AVG_CONSTANT_PARENTS);
       result->alike_ptr = INST(result);
@@ -397,7 +411,7 @@ struct Instance *CreateRealInstance(struct TypeDescription *type){
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     } else { /* instance type has a prototype which can be copied */
       return CopyInstance(INST(result));
@@ -414,7 +428,7 @@ struct Instance *CreateIntegerInstance(struct TypeDescription *type)
     if ((result=IA_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
       num_children = ChildListLen(GetChildList(type));
-      result = IA_INST(ascmalloc(GetByteSize(type)));
+      result = IA_INST(AllocInstanceMemory(INTEGER_ATOM_INST,GetByteSize(type)));
       result->t = INTEGER_ATOM_INST;
       result->interface_ptr = NULL;
       result->parents = gl_create(AVG_PARENTS);
@@ -443,7 +457,7 @@ struct Instance *CreateIntegerInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else {/* a prototype exists which can be copied */
@@ -454,7 +468,7 @@ struct Instance *CreateIntegerInstance(struct TypeDescription *type)
 
     if ((result=IC_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
-      result = IC_INST(ascmalloc(GetByteSize(type)));
+      result = IC_INST(AllocInstanceMemory(INTEGER_CONSTANT_INST,GetByteSize(type)));
       result->t = INTEGER_CONSTANT_INST;
       result->parents = gl_create(AVG_ICONSTANT_PARENTS);
       result->alike_ptr = INST(result);
@@ -475,7 +489,7 @@ struct Instance *CreateIntegerInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else {/* a prototype exists which can be copied */
@@ -493,7 +507,7 @@ struct Instance *CreateBooleanInstance(struct TypeDescription *type)
     if ((result=BA_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
       num_children = ChildListLen(GetChildList(type));
-      result = BA_INST(ascmalloc(GetByteSize(type)));
+      result = BA_INST(AllocInstanceMemory(BOOLEAN_ATOM_INST,GetByteSize(type)));
       result->t = BOOLEAN_ATOM_INST;
       result->interface_ptr = NULL;
       result->parents = gl_create(AVG_PARENTS);
@@ -524,7 +538,7 @@ struct Instance *CreateBooleanInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else {/* a prototype exists which can be copied */
@@ -535,7 +549,7 @@ struct Instance *CreateBooleanInstance(struct TypeDescription *type)
 
     if ((result=BC_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
-      result = BC_INST(ascmalloc(GetByteSize(type)));
+      result = BC_INST(AllocInstanceMemory(BOOLEAN_CONSTANT_INST,GetByteSize(type)));
       result->t = BOOLEAN_CONSTANT_INST;
       result->parents = gl_create(AVG_ICONSTANT_PARENTS);
       result->alike_ptr = INST(result);
@@ -555,7 +569,7 @@ struct Instance *CreateBooleanInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else {/* a prototype exists which can be copied */
@@ -573,7 +587,7 @@ struct Instance *CreateSetInstance(struct TypeDescription *type, int intset)
     if ((result=SA_INST(LookupPrototype(GetName(type))))==NULL) {
       CopyTypeDesc(type);
       num_children = ChildListLen(GetChildList(type));
-      result = SA_INST(ascmalloc(GetByteSize(type)));
+      result = SA_INST(AllocInstanceMemory(SET_ATOM_INST,GetByteSize(type)));
       result->t =  SET_ATOM_INST;
       result->interface_ptr = NULL;
       result->parents = gl_create(AVG_PARENTS);
@@ -594,7 +608,7 @@ struct Instance *CreateSetInstance(struct TypeDescription *type, int intset)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
     }
     else{ /* a prototype exists which may be copied */
       result = SA_INST(CopyInstance(INST(result)));
@@ -616,7 +630,7 @@ struct Instance *CreateSymbolInstance(struct TypeDescription *type)
     if ((result=SYMA_INST(LookupPrototype(GetName(type))))==NULL){
       CopyTypeDesc(type);
       num_children = ChildListLen(GetChildList(type));
-      result = SYMA_INST(ascmalloc(GetByteSize(type)));
+      result = SYMA_INST(AllocInstanceMemory(SYMBOL_ATOM_INST,GetByteSize(type)));
       result->t = SYMBOL_ATOM_INST;
       result->interface_ptr = NULL;
       result->parents = gl_create(AVG_PARENTS);
@@ -642,7 +656,7 @@ struct Instance *CreateSymbolInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else { /* a prototype exists which may be copied */
@@ -653,7 +667,7 @@ struct Instance *CreateSymbolInstance(struct TypeDescription *type)
 
     if ((result=SYMC_INST(LookupPrototype(GetName(type))))==NULL){
       CopyTypeDesc(type);
-      result = SYMC_INST(ascmalloc(GetByteSize(type)));
+      result = SYMC_INST(AllocInstanceMemory(SYMBOL_CONSTANT_INST,GetByteSize(type)));
       result->t = SYMBOL_CONSTANT_INST;
       result->parents = gl_create(AVG_ICONSTANT_PARENTS);
       result->alike_ptr = INST(result);
@@ -674,7 +688,7 @@ struct Instance *CreateSymbolInstance(struct TypeDescription *type)
         AddUniversalInstance(GetUniversalTable(),type,INST(result));
         return INST(result);
       }
-      AddPrototype(CopyInstance(INST(result)));
+      AddPrototypeCopy(INST(result));
       return INST(result);
     }
     else { /* a prototype exists which may be copied */
@@ -693,7 +707,7 @@ struct Instance *CreateRelationInstance(struct TypeDescription *type,
   if ((result=RELN_INST(LookupPrototype(GetName(type))))==NULL){
     CopyTypeDesc(type);
     num_children = ChildListLen(GetChildList(type));
-    result = RELN_INST(ascmalloc(GetByteSize(type)));
+    result = RELN_INST(AllocInstanceMemory(REL_INST,GetByteSize(type)));
     result->t = REL_INST;
     result->interface_ptr = NULL;
     result->parent[0] = NULL;	/* relations can have only two parents */
@@ -718,7 +732,7 @@ struct Instance *CreateRelationInstance(struct TypeDescription *type,
 		     BASE_ADDR(result,num_children,struct RelationInstance),
 		     CLIST(result,struct RelationInstance),
 		     GetChildDesc(type));
-    AddPrototype(CopyInstance(INST(result)));
+    AddPrototypeCopy(INST(result));
     AssertMemory(result);
     return INST(result);
   } else{			/* a prototype exists which may be copied */
@@ -736,7 +750,7 @@ struct Instance *CreateLogRelInstance(struct TypeDescription *type)
   if ((result=LRELN_INST(LookupPrototype(GetName(type))))==NULL){
     CopyTypeDesc(type);
     num_children = ChildListLen(GetChildList(type));
-    result = LRELN_INST(ascmalloc(GetByteSize(type)));
+    result = LRELN_INST(AllocInstanceMemory(LREL_INST,GetByteSize(type)));
     result->t = LREL_INST;
     result->interface_ptr = NULL;
     result->parent[0] = NULL;	/*logical relations can have only two parents*/
@@ -755,7 +769,7 @@ struct Instance *CreateLogRelInstance(struct TypeDescription *type)
 		     BASE_ADDR(result,num_children,struct LogRelInstance),
 		     CLIST(result,struct LogRelInstance),
 		     GetChildDesc(type));
-    AddPrototype(CopyInstance(INST(result)));
+    AddPrototypeCopy(INST(result));
     AssertMemory(result);
     return INST(result);
   }
@@ -771,7 +785,8 @@ struct Instance *CreateWhenInstance(struct TypeDescription *type)
   struct WhenInstance *result;
   if ((result=W_INST(LookupPrototype(GetName(type))))==NULL){
     CopyTypeDesc(type);
-    result = W_INST(ascmalloc((unsigned)sizeof(struct WhenInstance)));
+    result = W_INST(AllocInstanceMemory(WHEN_INST,
+                                     (unsigned)sizeof(struct WhenInstance)));
     result->t = WHEN_INST;
     result->interface_ptr = NULL;
     result->parent[0] = NULL;	/* relations can have only two parents */
@@ -784,7 +799,7 @@ struct Instance *CreateWhenInstance(struct TypeDescription *type)
     result->tmp_num = 0;
     result->anon_flags = 0x0;
 
-    AddPrototype(CopyInstance(INST(result)));
+    AddPrototypeCopy(INST(result));
     AssertMemory(result);
     return INST(result);
   }
@@ -808,7 +823,8 @@ struct Instance *CreateArrayInstance(struct TypeDescription *type,
   struct IndexType *ptr;
   assert(type!=NULL);
 
-  result = ARY_INST(ascmalloc((unsigned)sizeof(struct ArrayInstance)));
+  result = ARY_INST(AllocInstanceMemory(ARRAY_INT_INST,
+                                       (unsigned)sizeof(struct ArrayInstance)));
   list = GetArrayIndexList(type);
   if ((list==NULL)||(gl_length(list)==0)) {
     ASC_PANIC("An array without any indicies!\n");
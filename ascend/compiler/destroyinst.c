@@ -58,6 +58,7 @@
 #include "prototype.h"
 #include "pending.h"
 #include "rel_blackbox.h"
+#include "relprof.h"
 #include "vlist.h"
 #include "relation.h"
 #include "logical_relation.h"
@@ -71,6 +72,7 @@
 #include "instance_types.h"
 #include "cmpfunc.h"
 #include "slvreq.h"
+#include "instarena.h"
 
 
 static void DeleteIPtr(struct Instance *i){
@@ -321,6 +323,7 @@ static void DestroyInstanceParts(struct Instance *i){
   unsigned long c,length;
   struct gl_list_t *l;
   struct Instance *child;
+  struct InstanceArena *arena;
   AssertMemory(i);
   switch(i->t) {
   case SIM_INST:
@@ -331,7 +334,10 @@ static void DestroyInstanceParts(struct Instance *i){
     i->t = ERROR_INST;
     DeleteTypeDesc(SIM_INST(i)->desc);
     SIM_INST(i)->desc = NULL;
+    arena = SIM_INST(i)->arena;
+    SIM_INST(i)->arena = NULL;
     ascfree((char *)i);
+    ReleaseInstanceArena(arena);
     return;
   case MODEL_INST:
     gl_destroy(MOD_INST(i)->parents);
@@ -353,7 +359,7 @@ static void DestroyInstanceParts(struct Instance *i){
     DeleteTypeDesc(MOD_INST(i)->desc);
     MOD_INST(i)->desc = NULL;
 	gl_destroy(MOD_INST(i)->link_table);
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case REAL_CONSTANT_INST:
     /* continue delete the atom */
@@ -364,7 +370,7 @@ static void DestroyInstanceParts(struct Instance *i){
     RC_INST(i)->alike_ptr = NULL;
     /* children are automatically deleted by the following */
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case BOOLEAN_CONSTANT_INST:
     gl_destroy(BC_INST(i)->parents);
@@ -377,7 +383,7 @@ static void DestroyInstanceParts(struct Instance *i){
       BC_INST(i)->whens=NULL;
     }
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case INTEGER_CONSTANT_INST:
     gl_destroy(IC_INST(i)->parents);
@@ -390,7 +396,7 @@ static void DestroyInstanceParts(struct Instance *i){
       IC_INST(i)->whens=NULL;
     }
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case SYMBOL_CONSTANT_INST:
     gl_destroy(SYMC_INST(i)->parents);
@@ -404,7 +410,7 @@ static void DestroyInstanceParts(struct Instance *i){
       SYMC_INST(i)->whens=NULL;
     }
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case REAL_ATOM_INST:
     //CONSOLE_DEBUG("REMOVE PARTS OF VAR %p =========",i);
@@ -419,7 +425,7 @@ static void DestroyInstanceParts(struct Instance *i){
     RemoveRelationLinks(i);
     /* children are automatically deleted by the following  ----  EH??? how does that work? -JP */
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case BOOLEAN_ATOM_INST:
     /* deallocate dynamic memory used by children */
@@ -439,7 +445,7 @@ static void DestroyInstanceParts(struct Instance *i){
     }
     i->t = ERROR_INST;
     /* children are automatically deleted by the following */
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case INTEGER_ATOM_INST:
     /* deallocate dynamic memory used by children */
@@ -457,7 +463,7 @@ static void DestroyInstanceParts(struct Instance *i){
     }
     i->t = ERROR_INST;
     /* children are automatically deleted by the following */
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case SET_ATOM_INST:
     /* deallocate dynamic memory used by children */
@@ -472,7 +478,7 @@ static void DestroyInstanceParts(struct Instance *i){
     if (SA_INST(i)->list != NULL)
       DestroySet(SA_INST(i)->list);
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case SYMBOL_ATOM_INST:
     /* deallocate dynamic memory used by children */
@@ -490,10 +496,11 @@ static void DestroyInstanceParts(struct Instance *i){
     }
     SYMA_INST(i)->value = NULL;
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case REL_INST:
     //CONSOLE_DEBUG("REMOVE PARTS OF REL %p ===================",i);
+    relprof_forget_rel(i);
     /* deallocate dynamic memory used by children */
     DestroyAtomChildren(REL_CHILD(i,0),
     ChildListLen(GetChildList(RELN_INST(i)->desc)));
@@ -521,7 +528,7 @@ static void DestroyInstanceParts(struct Instance *i){
       ERROR_REPORTER_HERE(ASC_PROG_ERR,"Rel ptr not null where expected");
     }
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case LREL_INST:
     DestroyAtomChildren(LREL_CHILD(i,0),
@@ -544,7 +551,7 @@ static void DestroyInstanceParts(struct Instance *i){
     }
     LRELN_INST(i)->ptr = NULL;
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case WHEN_INST:
     DeleteTypeDesc(W_INST(i)->desc);
@@ -564,7 +571,7 @@ static void DestroyInstanceParts(struct Instance *i){
       W_INST(i)->cases = NULL;
     }
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case ARRAY_INT_INST:
   case ARRAY_ENUM_INST:
@@ -582,7 +589,7 @@ static void DestroyInstanceParts(struct Instance *i){
     }
     ARY_INST(i)->children = NULL;
     i->t = ERROR_INST;
-    ascfree((char *)i);
+    FreeInstanceMemory(i);
     return;
   case REAL_INST:
     i->t = ERROR_INST;
@@ -116,6 +116,8 @@ int CreateUserFunctionBlackBox(CONST char *name,
     efunc->u.black.final = DefaultExtBBoxFinalFunc;
   }
   efunc->u.black.inputTolerance = inputTolerance;
+  efunc->u.black.reentrant = 0;
+  efunc->u.black.fdgrouped = 0;
   if(help){
     if (efunc->help) ascfree((char *)efunc->help);
     efunc->help = ASC_STRDUP(help);
@@ -158,6 +160,36 @@ double GetValueFuncTolerance(struct ExternalFunc *efunc){
   return efunc->u.black.inputTolerance;
 }
 
+int GetValueFuncReentrant(struct ExternalFunc *efunc){
+  asc_assert(efunc!=NULL);
+  asc_assert(efunc->etype == efunc_BlackBox);
+  return efunc->u.black.reentrant;
+}
+
+int SetBlackBoxReentrant(CONST char *name, int reentrant){
+  struct ExternalFunc *efunc = LookupExtFunc(name);
+  if(efunc == NULL || efunc->etype != efunc_BlackBox){
+    return 1;
+  }
+  efunc->u.black.reentrant = reentrant;
+  return 0;
+}
+
+int GetValueFuncGroupedFD(struct ExternalFunc *efunc){
+  asc_assert(efunc!=NULL);
+  asc_assert(efunc->etype == efunc_BlackBox);
+  return efunc->u.black.fdgrouped;
+}
+
+int SetBlackBoxGroupedFD(CONST char *name, int grouped){
+  struct ExternalFunc *efunc = LookupExtFunc(name);
+  if(efunc == NULL || efunc->etype != efunc_BlackBox){
+    return 1;
+  }
+  efunc->u.black.fdgrouped = grouped;
+  return 0;
+}
+
 ExtBBoxFunc *GetDerivFunc(struct ExternalFunc *efunc){
   asc_assert(efunc!=NULL);
   asc_assert(efunc->etype == efunc_BlackBox);
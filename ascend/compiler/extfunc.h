@@ -231,6 +231,10 @@ struct BlackBoxExternalFunc {
   ExtBBoxFinalFunc *final; /**< cleanup function called at instance destruction. */
   double inputTolerance; /**< largest change in an input variable
 			that is allowable without recalculating. */
+  int reentrant; /**< value function may be called from several threads
+			at once; see SetBlackBoxReentrant. */
+  int fdgrouped; /**< finite differences may perturb several inputs at
+			once; see SetBlackBoxGroupedFD. */
 };
 
 
@@ -451,6 +455,10 @@ extern ExtBBoxFunc *GetDeriv2Func(struct ExternalFunc *efunc);
 extern ExtBBoxFinalFunc *GetFinalFunc(struct ExternalFunc *efunc);
 /** Fetch black inputTolerance. */
 extern double GetValueFuncTolerance(struct ExternalFunc *efunc);
+/** Fetch black reentrant flag. */
+extern int GetValueFuncReentrant(struct ExternalFunc *efunc);
+/** Fetch black grouped finite-difference flag. */
+extern int GetValueFuncGroupedFD(struct ExternalFunc *efunc);
 
 
 ASC_DLLSPEC int CreateUserFunctionBlackBox(CONST char *name,
@@ -508,6 +516,41 @@ ASC_DLLSPEC int CreateUserFunctionBlackBox(CONST char *name,
 */
 
 
+ASC_DLLSPEC int SetBlackBoxReentrant(CONST char *name, int reentrant);
+/**<
+	Declare that the value function of the blackbox called name (already
+	added with CreateUserFunctionBlackBox) may be called concurrently from
+	several threads, for example because it keeps no state between calls
+	other than what is in its user_data, and only reads that. Each thread
+	gets its own copy of the BBoxInterp, so the function may set its
+	status. Errors that it reports on a worker thread are held back, and
+	a call that fails is made again on the calling thread, so that its
+	messages are seen.
+
+	When finite-difference derivatives are needed for such a blackbox, the
+	perturbed evaluations are spread over a thread pool.
+
+	@return 0 on success, 1 if there is no blackbox of that name.
+*/
+
+ASC_DLLSPEC int SetBlackBoxGroupedFD(CONST char *name, int grouped);
+/**<
+	Declare that finite-difference derivatives of the blackbox called name
+	(which has no deriv function) may perturb several inputs in one call.
+	Each input is then perturbed on its own for the first few jacobians,
+	to find which outputs it affects, and after that the inputs that
+	affect no output in common are perturbed together (Curtis, Powell &
+	Reid), so that the jacobian takes fewer calls.
+
+	This is only right if the outputs that each input affects do not
+	depend on the point: an output such as y = x1*x2 would seem not to
+	depend on x2 wherever x1 = 0. A grouped call that changes an output
+	that none of its inputs was seen to affect makes the pattern be found
+	again, but a missed dependence can not always be noticed that way.
+
+	@return 0 on success, 1 if there is no blackbox of that name.
+*/
+
 ASC_DLLSPEC int DefaultExtBBoxInitFunc(struct BBoxInterp *interp
 		, struct Instance *data
 		, struct gl_list_t *arglist
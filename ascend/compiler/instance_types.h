@@ -641,6 +641,7 @@ struct SimulationInstance {
   unsigned int anon_flags;      /**< anonymous field to be manipulated */
   /* add other interesting stuff here */
   VOIDPTR slvreq_hooks;
+  struct InstanceArena *arena;  /**< where the instances of the tree live */
 };
 
 /** dummy instance for unselected children of models
@@ -75,6 +75,7 @@
 #include "extinst.h"
 #include "visitinst.h"
 #include "instquery.h"
+#include "instarena.h"
 #include "mathinst.h"
 #include "mergeinst.h"
 #include "parentchild.h"
@@ -12942,6 +12943,7 @@ struct Instance *NewInstantiate(symchar *type, symchar *name, int intset,
   struct Instance *result;	/* the SIM_INSTANCE */
   struct Instance *root;	/* the thing created by instantiate */
   struct TypeDescription *def;
+  struct InstanceArena *oldarena;
 
   ++g_compiler_counter;/*instance tree may change:increment compiler counter*/
   def = FindType(type);
@@ -12957,6 +12959,8 @@ struct Instance *NewInstantiate(symchar *type, symchar *name, int intset,
 
   ClearIteration();
   result = CreateSimulationInstance(def,name);
+  /* the instances of the new tree go in the simulation's arena */
+  oldarena = SetInstanceArena(GetSimulationArena(result));
   root = NewRealInstantiate(def,intset);
   LinkToParentByPos(result,root,1);
   if (g_ExtVariablesTable!=NULL) {
@@ -12965,6 +12969,7 @@ struct Instance *NewInstantiate(symchar *type, symchar *name, int intset,
   }
   ClearIteration();
   ExecDefMethod(root,name,defmethod);
+  SetInstanceArena(oldarena);
   return result;
 }
 
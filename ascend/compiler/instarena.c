@@ -0,0 +1,395 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Arena allocation of instances, see instarena.h.
+
+	The chunks of all the arenas are kept in one array sorted by address,
+	so that FreeInstanceMemory can find the chunk (and so the arena) that
+	an instance lies in with a binary search, or find that it came from
+	the heap. The chunks of each kind of instance start small and double
+	in size up to INSTARENA_CHUNK_MAX; instances too large to share a
+	chunk get one of their own.
+*/
+
+#include "instarena.h"
+
+#include <string.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+#include <ascend/general/mathmacros.h>
+
+#if defined(MALLOC_DEBUG) || defined(ASC_WITH_DMALLOC)
+# define INSTARENA_DISABLED
+#endif
+
+#define INSTARENA_CHUNK_MIN 4096UL
+#define INSTARENA_CHUNK_MAX (256UL*1024UL)
+#define INSTARENA_BIG (INSTARENA_CHUNK_MAX/8) /* larger instances get their own chunk */
+
+/** instances are aligned as strictly as any of their members */
+union instarena_align{
+	double d;
+	void *p;
+	long l;
+};
+#define INSTARENA_ALIGN (sizeof(union instarena_align))
+#define INSTARENA_ROUND(N) (((N) + INSTARENA_ALIGN - 1) & ~(INSTARENA_ALIGN - 1))
+
+struct InstanceArenaChunk{
+	struct InstanceArenaChunk *next; /**< next chunk of the same arena */
+	struct InstanceArena *arena;
+	char *start; /**< first cell */
+	char *top; /**< next free byte */
+	char *end; /**< end of the cell space */
+};
+
+struct InstanceArena{
+	struct InstanceArenaChunk *chunks; /**< all the chunks, newest first */
+	struct InstanceArenaChunk *cur[INSTARENA_NKINDS]; /**< chunk being filled for each kind */
+	unsigned long nextsize[INSTARENA_NKINDS]; /**< size of the next chunk for each kind */
+	struct InstanceArenaStats stats;
+	int released;
+	struct InstanceArena *prev, *next; /**< list of all arenas */
+};
+
+static struct InstanceArena *g_instarena_current = NULL;
+static struct InstanceArena *g_instarena_list = NULL;
+
+/* all chunks, sorted by address */
+static struct InstanceArenaChunk **g_instarena_chunks = NULL;
+static unsigned long g_instarena_nchunks = 0;
+static unsigned long g_instarena_capacity = 0;
+
+static enum instarena_kind instarena_kind(enum inst_t t){
+	switch(t){
+	case SIM_INST:
+	case MODEL_INST:
+		return INSTARENA_MODEL;
+	case REAL_ATOM_INST:
+		return INSTARENA_REAL_ATOM;
+	case INTEGER_ATOM_INST:
+	case BOOLEAN_ATOM_INST:
+	case SYMBOL_ATOM_INST:
+	case SET_ATOM_INST:
+		return INSTARENA_ATOM;
+	case REAL_CONSTANT_INST:
+	case INTEGER_CONSTANT_INST:
+	case BOOLEAN_CONSTANT_INST:
+	case SYMBOL_CONSTANT_INST:
+		return INSTARENA_CONSTANT;
+	case REL_INST:
+		return INSTARENA_RELATION;
+	case LREL_INST:
+		return INSTARENA_LOGREL;
+	case WHEN_INST:
+		return INSTARENA_WHEN;
+	case ARRAY_INT_INST:
+	case ARRAY_ENUM_INST:
+		return INSTARENA_ARRAY;
+	default:
+		return INSTARENA_OTHER;
+	}
+}
+
+/*------------------------------------------------------------------------------
+  CHUNK REGISTRY
+*/
+
+/** the chunk containing p, or NULL if p is not in any arena */
+static struct InstanceArenaChunk *instarena_find(CONST void *p){
+	unsigned long lo = 0, hi = g_instarena_nchunks, mid;
+	CONST char *c = (CONST char *)p;
+	struct InstanceArenaChunk *k;
+	while(lo < hi){
+		mid = (lo + hi) / 2;
+		k = g_instarena_chunks[mid];
+		if(c < k->start){
+			hi = mid;
+		}else if(c >= k->end){
+			lo = mid + 1;
+		}else{
+			return k;
+		}
+	}
+	return NULL;
+}
+
+static void instarena_register(struct InstanceArenaChunk *k){
+	unsigned long lo = 0, hi = g_instarena_nchunks, mid;
+	if(g_instarena_nchunks == g_instarena_capacity){
+		g_instarena_capacity = MAX(2 * g_instarena_capacity, 64);
+		g_instarena_chunks = (struct InstanceArenaChunk **)ASC_REALLOC(
+			g_instarena_chunks
+			,g_instarena_capacity * sizeof(struct InstanceArenaChunk *)
+		);
+		if(g_instarena_chunks == NULL){
+			ASC_PANIC("Insufficient memory.");
+		}
+	}
+	while(lo < hi){
+		mid = (lo + hi) / 2;
+		if(g_instarena_chunks[mid]->start < k->start){
+			lo = mid + 1;
+		}else{
+			hi = mid;
+		}
+	}
+	memmove(g_instarena_chunks + lo + 1, g_instarena_chunks + lo
+		,(g_instarena_nchunks - lo) * sizeof(struct InstanceArenaChunk *)
+	);
+	g_instarena_chunks[lo] = k;
+	++g_instarena_nchunks;
+}
+
+/** drop all the chunks of arena a from the registry */
+static void instarena_unregister(struct InstanceArena *a){
+	unsigned long i, j = 0;
+	for(i = 0; i < g_instarena_nchunks; ++i){
+		if(g_instarena_chunks[i]->arena != a){
+			g_instarena_chunks[j++] = g_instarena_chunks[i];
+		}
+	}
+	g_instarena_nchunks = j;
+	if(j == 0){
+		ASC_FREE(g_instarena_chunks);
+		g_instarena_chunks = NULL;
+		g_instarena_capacity = 0;
+	}
+}
+
+/*------------------------------------------------------------------------------
+  ARENAS
+*/
+
+struct InstanceArena *CreateInstanceArena(void){
+#ifdef INSTARENA_DISABLED
+	return NULL;
+#else
+	struct InstanceArena *a;
+	int k;
+	a = ASC_NEW_CLEAR(struct InstanceArena);
+	if(a == NULL){
+		ASC_PANIC("Insufficient memory.");
+	}
+	for(k = 0; k < INSTARENA_NKINDS; ++k){
+		a->nextsize[k] = INSTARENA_CHUNK_MIN;
+	}
+	a->next = g_instarena_list;
+	if(a->next != NULL)a->next->prev = a;
+	g_instarena_list = a;
+	return a;
+#endif
+}
+
+static void instarena_destroy(struct InstanceArena *a){
+	struct InstanceArenaChunk *k, *next;
+	if(g_instarena_current == a)g_instarena_current = NULL;
+	instarena_unregister(a);
+	for(k = a->chunks; k != NULL; k = next){
+		next = k->next;
+		ascfree(k);
+	}
+	if(a->prev != NULL){
+		a->prev->next = a->next;
+	}else{
+		g_instarena_list = a->next;
+	}
+	if(a->next != NULL)a->next->prev = a->prev;
+	ASC_FREE(a);
+}
+
+void ReleaseInstanceArena(struct InstanceArena *a){
+	if(a == NULL)return;
+	a->released = 1;
+	if(g_instarena_current == a)g_instarena_current = NULL;
+	if(a->stats.live == 0)instarena_destroy(a);
+}
+
+struct InstanceArena *SetInstanceArena(struct InstanceArena *a){
+	struct InstanceArena *old = g_instarena_current;
+	asc_assert(a == NULL || !a->released);
+	g_instarena_current = a;
+	return old;
+}
+
+struct InstanceArena *CurrentInstanceArena(void){
+	return g_instarena_current;
+}
+
+/*------------------------------------------------------------------------------
+  ALLOCATION
+*/
+
+static struct InstanceArenaChunk *instarena_new_chunk(struct InstanceArena *a
+		, unsigned long space
+){
+	struct InstanceArenaChunk *k;
+	unsigned long head = INSTARENA_ROUND(sizeof(struct InstanceArenaChunk));
+	k = (struct InstanceArenaChunk *)ascmalloc(head + space);
+	if(k == NULL){
+		ASC_PANIC("Insufficient memory.");
+	}
+	k->arena = a;
+	k->start = k->top = (char *)k + head;
+	k->end = k->start + space;
+	k->next = a->chunks;
+	a->chunks = k;
+	a->stats.chunks++;
+	a->stats.chunkbytes += head + space;
+	instarena_register(k);
+	return k;
+}
+
+static void *instarena_alloc(struct InstanceArena *a, enum instarena_kind kind
+		, size_t size
+){
+	struct InstanceArenaChunk *k;
+	char *p;
+	size = INSTARENA_ROUND(MAX(size,1));
+	if(size > INSTARENA_BIG){
+		k = instarena_new_chunk(a,size);
+	}else{
+		k = a->cur[kind];
+		if(k == NULL || k->top + size > k->end){
+			k = instarena_new_chunk(a,a->nextsize[kind]);
+			a->cur[kind] = k;
+			if(a->nextsize[kind] < INSTARENA_CHUNK_MAX)a->nextsize[kind] *= 2;
+		}
+	}
+	p = k->top;
+	k->top += size;
+	a->stats.count[kind]++;
+	a->stats.bytes[kind] += size;
+	a->stats.live++;
+	return p;
+}
+
+void *AllocInstanceMemory(enum inst_t t, size_t size){
+	void *p;
+	if(g_instarena_current == NULL){
+		p = ascmalloc(size);
+		if(p == NULL){
+			ASC_PANIC("Insufficient memory.");
+		}
+		return p;
+	}
+	return instarena_alloc(g_instarena_current,instarena_kind(t),size);
+}
+
+void *ReallocInstanceMemory(void *i, enum inst_t t
+		, size_t oldsize, size_t size
+){
+	struct InstanceArenaChunk *k;
+	void *p;
+	k = instarena_find(i);
+	if(k == NULL){
+		return ascrealloc(i,size);
+	}
+	if(k->arena->released){
+		p = ascmalloc(size);
+		if(p == NULL){
+			ASC_PANIC("Insufficient memory.");
+		}
+	}else{
+		p = instarena_alloc(k->arena,instarena_kind(t),size);
+	}
+	memcpy(p,i,MIN(oldsize,size));
+	FreeInstanceMemory(i);
+	return p;
+}
+
+void FreeInstanceMemory(void *i){
+	struct InstanceArenaChunk *k;
+	struct InstanceArena *a;
+	if(i == NULL)return;
+	k = instarena_find(i);
+	if(k == NULL){
+		ascfree(i);
+		return;
+	}
+	a = k->arena;
+	asc_assert(a->stats.live > 0);
+	a->stats.live--;
+	a->stats.freed++;
+	if(a->released && a->stats.live == 0)instarena_destroy(a);
+}
+
+/*------------------------------------------------------------------------------
+  STATISTICS
+*/
+
+static void instarena_add_stats(struct InstanceArenaStats *s
+		, CONST struct InstanceArenaStats *t
+){
+	int k;
+	for(k = 0; k < INSTARENA_NKINDS; ++k){
+		s->count[k] += t->count[k];
+		s->bytes[k] += t->bytes[k];
+	}
+	s->live += t->live;
+	s->freed += t->freed;
+	s->chunks += t->chunks;
+	s->chunkbytes += t->chunkbytes;
+}
+
+void InstanceArenaStatistics(CONST struct InstanceArena *a
+		, struct InstanceArenaStats *s
+){
+	memset(s,0,sizeof(struct InstanceArenaStats));
+	if(a != NULL)instarena_add_stats(s,&(a->stats));
+}
+
+unsigned long InstanceArenaMemInUse(CONST struct InstanceArena *a){
+	unsigned long n = 0;
+	if(a != NULL)return a->stats.chunkbytes;
+	for(a = g_instarena_list; a != NULL; a = a->next){
+		n += a->stats.chunkbytes;
+	}
+	return n;
+}
+
+static CONST char *g_instarena_kindnames[INSTARENA_NKINDS] = {
+	"models", "real atoms", "other atoms", "constants", "relations"
+	, "logical relations", "whens", "arrays", "other"
+};
+
+void InstanceArenaStatus(FILE *fp, CONST struct InstanceArena *a){
+	struct InstanceArenaStats s;
+	unsigned long used = 0;
+	int k;
+
+	if(a != NULL){
+		InstanceArenaStatistics(a,&s);
+	}else{
+		memset(&s,0,sizeof(struct InstanceArenaStats));
+		for(a = g_instarena_list; a != NULL; a = a->next){
+			instarena_add_stats(&s,&(a->stats));
+		}
+	}
+	FPRINTF(fp,"%-20s %12s %14s\n","Instance arena","instances","bytes");
+	for(k = 0; k < INSTARENA_NKINDS; ++k){
+		if(s.count[k] == 0)continue;
+		FPRINTF(fp,"%-20s %12lu %14lu\n",g_instarena_kindnames[k]
+			,s.count[k],s.bytes[k]
+		);
+		used += s.bytes[k];
+	}
+	FPRINTF(fp,"Live instances: %lu (%lu freed)\n",s.live,s.freed);
+	FPRINTF(fp,"Memory held in %lu chunks (bytes): %lu\n",s.chunks,s.chunkbytes);
+	FPRINTF(fp,"Memory density: %g\n"
+		,(double)used / (double)(s.chunkbytes ? s.chunkbytes : 1)
+	);
+}
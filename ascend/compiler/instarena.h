@@ -0,0 +1,142 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Arena allocation of instances.
+
+	Each simulation owns an arena, from which the instances created while
+	it is being instantiated are allocated (see NewInstantiate). Instances
+	are carved out of large chunks with a bump pointer, a separate series
+	of chunks for each kind of instance, so that eg all the real atoms of
+	a simulation lie together in the order they were created.
+
+	An instance can still be destroyed on its own (as happens when
+	instances are merged or refined); its memory is not reused, but is
+	counted as freed. When the simulation is destroyed, its arena is
+	released and all the chunks are returned to the heap at once. If any
+	instance from the arena is still alive at that point (a UNIVERSAL
+	instance also used by another simulation, for example), the chunks are
+	kept until the last such instance is destroyed.
+
+	Memory for instances must therefore be obtained with
+	AllocInstanceMemory and returned with FreeInstanceMemory, which fall
+	back to the heap when no arena is current, and tell arena memory from
+	heap memory by the address alone.
+
+	Arenas are disabled when memory debugging (MALLOC_DEBUG or dmalloc)
+	is in use, so that every instance can still be checked with
+	AssertMemory.
+*/
+
+#ifndef ASC_INSTARENA_H
+#define ASC_INSTARENA_H
+
+/**	@addtogroup compiler_inst Compiler Instance Hierarchy
+	@{
+*/
+
+#include <stdio.h>
+#include <ascend/general/platform.h>
+#include "instance_enum.h"
+
+/** Opaque arena of instance memory. */
+struct InstanceArena;
+
+/** The groups in which instances are placed together. */
+enum instarena_kind{
+	INSTARENA_MODEL = 0 /**< models and simulations */
+	,INSTARENA_REAL_ATOM /**< real atoms, ie variables */
+	,INSTARENA_ATOM /**< other atoms */
+	,INSTARENA_CONSTANT /**< constants of all types */
+	,INSTARENA_RELATION /**< relations */
+	,INSTARENA_LOGREL /**< logical relations */
+	,INSTARENA_WHEN /**< WHENs */
+	,INSTARENA_ARRAY /**< arrays */
+	,INSTARENA_OTHER /**< anything else */
+	,INSTARENA_NKINDS
+};
+
+/** Counts and sizes from an arena; see InstanceArenaStatistics. */
+struct InstanceArenaStats{
+	unsigned long count[INSTARENA_NKINDS]; /**< instances allocated */
+	unsigned long bytes[INSTARENA_NKINDS]; /**< bytes allocated for them */
+	unsigned long live; /**< instances allocated and not yet freed */
+	unsigned long freed; /**< instances freed before the arena was released */
+	unsigned long chunks; /**< number of chunks held */
+	unsigned long chunkbytes; /**< total size of the chunks */
+};
+
+extern struct InstanceArena *CreateInstanceArena(void);
+/**<
+	Create an empty arena. Returns NULL if arenas are disabled, which all
+	the routines below accept as 'no arena'.
+*/
+
+extern void ReleaseInstanceArena(struct InstanceArena *a);
+/**<
+	Called by the owner of a when it has no more use for it (normally
+	after destroying the instances of a simulation). The arena is freed
+	at once if none of its instances are still alive, else as soon as the
+	last of them is freed. a must not be used by the caller afterwards.
+*/
+
+extern struct InstanceArena *SetInstanceArena(struct InstanceArena *a);
+/**<
+	Make a the arena from which AllocInstanceMemory allocates (NULL for
+	the heap).
+	@return the arena that was current before, so that it can be restored.
+*/
+
+extern struct InstanceArena *CurrentInstanceArena(void);
+/**< The arena from which AllocInstanceMemory allocates, or NULL. */
+
+extern void *AllocInstanceMemory(enum inst_t t, size_t size);
+/**<
+	Memory for a new instance of kind t, of size bytes, from the current
+	arena or else the heap. Never returns NULL.
+*/
+
+extern void *ReallocInstanceMemory(void *i, enum inst_t t
+		, size_t oldsize, size_t size);
+/**<
+	Resize the memory of instance i, which has oldsize bytes, to size
+	bytes. An instance in an arena always moves (within the same arena);
+	one on the heap is passed to ascrealloc. The caller must fix up any
+	pointers to i if the result differs from i.
+*/
+
+extern void FreeInstanceMemory(void *i);
+/**< Return the memory of instance i, wherever it came from. */
+
+ASC_DLLSPEC void InstanceArenaStatistics(CONST struct InstanceArena *a
+		, struct InstanceArenaStats *s);
+/**< Fill s with the counts for arena a, or with zeros if a is NULL. */
+
+ASC_DLLSPEC unsigned long InstanceArenaMemInUse(CONST struct InstanceArena *a);
+/**<
+	Bytes of heap held by arena a, or by all the arenas (including those
+	released but still held by live instances) if a is NULL. This is the
+	arena counterpart of ascmeminuse.
+*/
+
+ASC_DLLSPEC void InstanceArenaStatus(FILE *fp, CONST struct InstanceArena *a);
+/**<
+	Write a table of the statistics of arena a (or of all the arenas if
+	a is NULL), in the manner of ascstatus.
+*/
+
+/* @} */
+
+#endif /* ASC_INSTARENA_H */
@@ -462,6 +462,11 @@ struct Instance *GetSimulationRoot(struct Instance *i){
   return *child_adr;
 }
 
+struct InstanceArena *GetSimulationArena(struct Instance *i){
+  assert(i&&InstanceKind(i)==SIM_INST);
+  return SIM_INST(i)->arena;
+}
+
 struct Instance *FindSimulationInstance(struct Instance *i){
 	struct gl_list_t *sims;
 	sims = FindSimulationAncestors(i);
@@ -353,6 +353,13 @@ ASC_DLLSPEC struct Instance*GetSimulationRoot(struct Instance *i);
  *  i must be a sim instance.
  */
 
+ASC_DLLSPEC struct InstanceArena *GetSimulationArena(struct Instance *i);
+/**<
+ *  Returns the arena holding the instances of the simulation, or NULL
+ *  if they are on the heap (see instarena.h).
+ *  i must be a sim instance.
+ */
+
 ASC_DLLSPEC struct Instance *FindSimulationInstance(struct Instance *i);
 /**<
 	Attempt to navigate up the Instance Tree until a SIM_INST SimulationInstance
@@ -71,6 +71,7 @@
 #include "extinst.h"
 #include "instmacro.h"
 #include "instquery.h"
+#include "instarena.h"
 #include "linkinst.h"
 #include "mergeinst.h"
 #include "parentchild.h"
@@ -630,7 +631,10 @@ struct Instance *RefineModel(struct ModelInstance *i,
   old_length = ChildListLen(GetChildList(i->desc));
   if (new_length > old_length){
     /* resize the instance */
-    result = MOD_INST(ascrealloc((char *)i,
+    result = MOD_INST(ReallocInstanceMemory(i,MODEL_INST,
+				 (unsigned)sizeof(struct ModelInstance)+
+				 (unsigned)old_length*
+				 (unsigned)sizeof(struct Instance *),
 				 (unsigned)sizeof(struct ModelInstance)+
 				 (unsigned)new_length*
 				 (unsigned)sizeof(struct Instance *)));
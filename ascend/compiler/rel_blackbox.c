@@ -19,6 +19,7 @@
 #include "rel_blackbox.h"
 
 #include <math.h>
+#include <string.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <ascend/general/ascMalloc.h>
@@ -46,6 +47,8 @@
 #include "extcall.h" /* for copy/destroy speciallist */
 #include "packages.h" /* for init slv interp */
 #include "name.h" /* for copy/destroy name */
+#include "relprof.h"
+#include <ascend/general/threadpool.h>
 
 //#define WARNEXPT // warn user that blackbox evaluation is experimental
 
@@ -60,6 +63,9 @@
 
 #define BBDEBUG 0 /* set 0 if not wanting spew */
 
+static int blackbox_eval(struct BlackBoxCache *b, double *inputs, double *outputs);
+static int blackbox_fdiff(struct BlackBoxCache *b, double *inputs, double *jac);
+
 static int32 ArgsDifferent(double new, double old, double tol){
 	if (fabs(new - old) > fabs(tol)) {
 		return 1;
@@ -166,7 +172,6 @@ int BlackBoxCalcResidual(struct Instance *i, double *res, struct relation *r){
 	unsigned long argToVarLen;
 	struct BlackBoxCache *common;
 	struct ExternalFunc *efunc;
-	ExtBBoxFunc *evalFunc;
 	int lhsVar;
 	int outputIndex;
 	struct Instance *arg;
@@ -191,7 +196,6 @@ int BlackBoxCalcResidual(struct Instance *i, double *res, struct relation *r){
 	argToVar = RBBOX(r).inputArgs;
 	lhsVar = RBBOX(r).lhsvar;
 	outputIndex = RBBOX(r).lhsindex;
-	evalFunc = GetValueFunc(efunc);
 	inputTolerance = GetValueFuncTolerance(efunc);
 	updateNeeded = 0;
 
@@ -220,14 +224,7 @@ int BlackBoxCalcResidual(struct Instance *i, double *res, struct relation *r){
 			value = RealAtomValue(arg);
 			common->inputs[c] = value;
 		}
-		common->interp.task = bb_func_eval;
-
-		nok = (*evalFunc)(&(common->interp),
-				common->inputsLen,
-				common->outputsLen,
-				common->inputs,
-				common->outputs,
-				common->jacobian);
+		nok = blackbox_eval(common,common->inputs,common->outputs);
 		if(nok)CONSOLE_DEBUG("Error '%d' returned by external relation '%s' eval.",nok,ExternalFuncName(efunc));
 		common->residCount++;
 	}
@@ -253,11 +250,6 @@ int BlackBoxCalcResidual(struct Instance *i, double *res, struct relation *r){
 		# if changed, recompute gradient in bbox.
 		# compute gradient per varlist from bbox row.
 */
-int blackbox_fdiff(ExtBBoxFunc *resfn, struct BBoxInterp *interp
-	, int ninputs, int noutputs
-	, double *inputs, double *outputs, double *jac
-);
-
 int BlackBoxCalcGradient(struct Instance *i, double *gradient
 		, struct relation *r
 ){
@@ -277,6 +269,7 @@ int BlackBoxCalcGradient(struct Instance *i, double *gradient
 	int updateNeeded, offset;
 	unsigned int k;
 	int nok = 0;
+	relprof_ticks_t t0;
 
 #ifdef WARNEXPT
     static int warnexpt, warnfdiff;
@@ -322,6 +315,7 @@ int BlackBoxCalcGradient(struct Instance *i, double *gradient
 		}
 		common->interp.task = bb_deriv_eval;
 
+		t0 = RELPROF_ENABLED ? relprof_ticks() : 0;
 		if(derivFunc){
 			nok = (*derivFunc)(
 				&(common->interp)
@@ -340,12 +334,12 @@ int BlackBoxCalcGradient(struct Instance *i, double *gradient
 			}
 #endif
 
-			nok = blackbox_fdiff(GetValueFunc(efunc), &(common->interp)
-				, common->inputsLen, common->outputsLen
-				, common->inputsJac, common->outputs, common->jacobian
-			);
+			nok = blackbox_fdiff(common, common->inputsJac, common->jacobian);
 			if(nok)CONSOLE_DEBUG("Error '%d' returned for finite difference gradient for '%s'.",nok,ExternalFuncName(efunc));		
 		}
+		if(RELPROF_ENABLED){
+			relprof_record_ext(efunc,RELPROF_GRAD,relprof_ticks() - t0,nok);
+		}
 		common->gradCount++;
 	}
 
@@ -445,10 +439,107 @@ void DestroyBlackBoxData(struct relation *rel, struct BlackBoxData *b){
 	ascfree(b);
 }
 
+/*------------------------------------------------------------------------------
+  MEMOISED EVALUATION
+*/
+
+#define BBOX_MEMO_SIZE 4 /* number of recent points remembered per cache */
+
+/**
+	Look for inputs among the points recently evaluated by b, comparing
+	exactly. Returns the stored outputs, or NULL.
+*/
+static double *blackbox_memo_find(struct BlackBoxCache *b, const double *inputs){
+	int k;
+	size_t w = b->inputsLen + b->outputsLen;
+	for(k = 0; k < b->memoLen; ++k){
+		double *m = b->memo + k * w;
+		if(0 == memcmp(m, inputs, b->inputsLen * sizeof(double))){
+			return m + b->inputsLen;
+		}
+	}
+	return NULL;
+}
+
+static void blackbox_memo_store(struct BlackBoxCache *b
+		, const double *inputs, const double *outputs
+){
+	size_t w = b->inputsLen + b->outputsLen;
+	double *m;
+	if(b->memo == NULL){
+		b->memo = ASC_NEW_ARRAY(double, BBOX_MEMO_SIZE * w);
+	}
+	m = b->memo + b->memoNext * w;
+	memcpy(m, inputs, b->inputsLen * sizeof(double));
+	memcpy(m + b->inputsLen, outputs, b->outputsLen * sizeof(double));
+	b->memoNext = (b->memoNext + 1) % BBOX_MEMO_SIZE;
+	if(b->memoLen < BBOX_MEMO_SIZE)b->memoLen++;
+}
+
+/**
+	Compute the outputs of the blackbox at inputs, unless that point has
+	been evaluated recently, in which case the outputs are copied.
+*/
+static int blackbox_eval(struct BlackBoxCache *b, double *inputs, double *outputs){
+	int nok;
+	relprof_ticks_t t0;
+	double *m = blackbox_memo_find(b, inputs);
+	if(m != NULL){
+		memcpy(outputs, m, b->outputsLen * sizeof(double));
+		return 0;
+	}
+	b->interp.task = bb_func_eval;
+	t0 = RELPROF_ENABLED ? relprof_ticks() : 0;
+	nok = (*GetValueFunc(b->efunc))(&(b->interp)
+		, b->inputsLen, b->outputsLen, inputs, outputs, b->jacobian
+	);
+	if(RELPROF_ENABLED){
+		relprof_record_ext(b->efunc,RELPROF_RESID,relprof_ticks() - t0,nok);
+	}
+	if(!nok)blackbox_memo_store(b, inputs, outputs);
+	return nok;
+}
+
 /*------------------------------------------------------------------------------
   BLACKBOX GRADIENT BY FINITE-DIFFERENCE
+
+  Each input is perturbed on its own, unless the blackbox allows grouping
+  (SetBlackBoxGroupedFD). Then the inputs are perturbed in groups of
+  columns that share no nonzero rows of the jacobian (Curtis, Powell &
+  Reid, 1974), so that one call gives a column of each. Until the pattern
+  is known, each input is perturbed on its own and every output that
+  changes is marked; the union of the patterns seen at
+  BBOX_FD_PATTERN_EVALS points is then taken as the sparsity of the
+  blackbox and grouped. An output that happened not to change at those
+  points is assumed not to depend on the input, but if a grouped call
+  changes an output that is in the pattern of none of its inputs, the
+  grouping is dropped, that jacobian is done again one input at a time,
+  and the pattern is found afresh (keeping what was seen before).
+
+  For blackboxes declared reentrant (SetBlackBoxReentrant), the
+  perturbed calls are shared out over a thread pool.
 */
 
+#define BBOX_FD_PATTERN_EVALS 2
+
+static threadpool_t *g_blackbox_pool = NULL;
+
+void BlackBoxDestroyPool(void){
+	threadpool_destroy(g_blackbox_pool);
+	g_blackbox_pool = NULL;
+}
+
+static threadpool_t *blackbox_get_pool(void){
+	int n;
+	if(g_blackbox_pool == NULL){
+		n = threadpool_default_size();
+		if(n <= 1)return NULL;
+		g_blackbox_pool = threadpool_create(n);
+	}
+	if(g_blackbox_pool == NULL || threadpool_size(g_blackbox_pool) <= 1)return NULL;
+	return g_blackbox_pool;
+}
+
 /**
 	This function works out what the peturbed value for a variable should be.
 
@@ -458,61 +549,235 @@ static double blackbox_peturbation(double varvalue){
   return 1.0e-05;
 }
 
+/* one perturbed evaluation per column group */
+struct blackbox_fd{
+	struct BlackBoxCache *b;
+	ExtBBoxFunc *fn;
+	int parallel;
+	const double *x; /* base point */
+	const double *h; /* perturbation of each input */
+	const int *gstart, *gcol; /* group g is gcol[gstart[g]..gstart[g+1]-1] */
+	double *xw, *yw; /* inputs and outputs of each group */
+	int *nok; /* result of each call */
+	int *held; /* call failed on a worker thread, messages not shown */
+};
+
+static void blackbox_fd_task(void *data, int g, int thread){
+	struct blackbox_fd *f = (struct blackbox_fd *)data;
+	int n = f->b->inputsLen, m = f->b->outputsLen, k;
+	double *x = f->xw + (size_t)g * n;
+	double *y = f->yw + (size_t)g * m;
+	struct BBoxInterp interp;
+
+	memcpy(x, f->x, n * sizeof(double));
+	for(k = f->gstart[g]; k < f->gstart[g+1]; ++k){
+		x[f->gcol[k]] += f->h[f->gcol[k]];
+	}
+	if(f->parallel){
+		/* each call has its own interp, and there's no jacobian to share */
+		interp = f->b->interp;
+		if(thread == 0){
+			f->nok[g] = (*f->fn)(&interp, n, m, x, y, NULL);
+		}else{
+			/* messages on a worker thread go to its own error tree and are
+			dropped; if the call fails it is made again by the caller */
+			error_reporter_tree_start();
+			f->nok[g] = (*f->fn)(&interp, n, m, x, y, NULL);
+			error_reporter_tree_clear();
+			f->held[g] = (f->nok[g] != 0);
+		}
+	}else{
+		/* note that the 'jac' parameter is just along for the ride */
+		f->nok[g] = (*f->fn)(&(f->b->interp), n, m, x, y, f->b->jacobian);
+	}
+}
+
+/**
+	Assign the inputs of b to groups with no output in common, using the
+	pattern in b->fdPattern and taking the columns in order, each into the
+	first group that it fits.
+*/
+static void blackbox_fd_group(struct BlackBoxCache *b){
+	int n = b->inputsLen, m = b->outputsLen, c, r, g;
+	unsigned char *used = ASC_NEW_ARRAY_CLEAR(unsigned char, (size_t)n * m + 1);
+	b->fdGroup = ASC_NEW_ARRAY(int, n);
+	b->fdNGroups = 0;
+	for(c = 0; c < n; ++c){
+		for(g = 0; g < b->fdNGroups; ++g){
+			for(r = 0; r < m; ++r){
+				if(b->fdPattern[r * n + c] && used[g * m + r])break;
+			}
+			if(r == m)break;
+		}
+		if(g == b->fdNGroups)b->fdNGroups++;
+		b->fdGroup[c] = g;
+		for(r = 0; r < m; ++r){
+			if(b->fdPattern[r * n + c])used[g * m + r] = 1;
+		}
+	}
+	ASC_FREE(used);
+	MSG("%d inputs in %d groups", n, b->fdNGroups);
+}
 
 /**
-	Blackbox derivatives estimated by finite difference (by evaluation at
-	peturbed value of each input in turn)
+	Forget the grouping of the inputs of b, so that the pattern is added
+	to over the next BBOX_FD_PATTERN_EVALS jacobians and grouped again.
+*/
+static void blackbox_fd_ungroup(struct BlackBoxCache *b){
+	if(b->fdGroup != NULL)ASC_FREE(b->fdGroup);
+	b->fdGroup = NULL;
+	b->fdNGroups = 0;
+	b->fdPatternCount = 0;
+}
 
-	Call signature as for ExtBBoxFunc (except for addition leading 'resfn' parameter)
+/**
+	Check the outputs y of the grouped call for group g against the
+	pattern: each one that changed must be in the pattern of one of the
+	inputs of the group.
+	@return 1 if an output changed that the pattern does not explain.
 */
-int blackbox_fdiff(ExtBBoxFunc *resfn, struct BBoxInterp *interp
-	, int ninputs, int noutputs
-	, double *inputs, double *outputs, double *jac
+static int blackbox_fd_unexplained(struct BlackBoxCache *b
+		, const int *gstart, const int *gcol, int g
+		, const double *y0, const double *y
 ){
-  long c,r;
-  int nok = 0;
-  double *tmp_outputs;
-  double *ptr;
-  double old_x,deltax,value;
-  enum Request_type old_task = interp->task;
-
-  MSG("NUMERICAL DERIVATIVE...");
-  interp->task = bb_func_eval;
-
-  tmp_outputs = ASC_NEW_ARRAY_CLEAR(double,noutputs);
-
-  for (c=0;c<ninputs;c++){
-    /* perturb each input in turn */
-    old_x = inputs[c];
-	deltax = blackbox_peturbation(old_x);
-    inputs[c] = old_x + deltax;
-	MSG("PETURBATED VALUE of input[%ld] = %f",c,inputs[c]);
-
-	/* call routine. note that the 'jac' parameter is just along for the ride */
-    nok = (*resfn)(interp, ninputs, noutputs, inputs, tmp_outputs, jac);
-    if(nok){
-	    MSG("External evaluation error (%d) for peturbed value %ld",nok,c);
-		break;
-	}
-
-	/* fill load jacobian */
-    ptr = &jac[c];
-    for(r=0;r<noutputs;r++){
-      value = (tmp_outputs[r] - outputs[r]) / deltax;
-	  /* CONSOLE_DEBUG("output[%ld]: value = %f, gradient = %f",r,tmp_outputs[r],value); */
-      *ptr = value;
-      ptr += ninputs;
-    }
-
-	/* now return this input to its old value */
-    inputs[c] = old_x;
-  }
-  ASC_FREE(tmp_outputs);
-  if(nok){
-    MSG("External evaluation error");
-  }
-  interp->task = old_task;
-  return nok;
+	int n = b->inputsLen, m = b->outputsLen, r, k;
+	for(r = 0; r < m; ++r){
+		if(y[r] == y0[r])continue;
+		for(k = gstart[g]; k < gstart[g+1]; ++k){
+			if(b->fdPattern[r * n + gcol[k]])break;
+		}
+		if(k == gstart[g+1])return 1;
+	}
+	return 0;
+}
+
+/**
+	Blackbox derivatives estimated by finite difference at inputs, which
+	are left unchanged, into jac (outputs x inputs, row major).
+*/
+static int blackbox_fdiff(struct BlackBoxCache *b, double *inputs, double *jac){
+	int n = b->inputsLen, m = b->outputsLen;
+	int c, r, g, k, ngroups, nok;
+	int grouped = GetValueFuncGroupedFD(b->efunc);
+	int settled = grouped && (b->fdGroup != NULL);
+	double *y0, *h;
+	int *gstart, *gcol;
+	struct blackbox_fd f;
+	threadpool_t *pool;
+	enum Request_type old_task = b->interp.task;
+
+	MSG("NUMERICAL DERIVATIVE...");
+	y0 = ASC_NEW_ARRAY(double, m + 1);
+	nok = blackbox_eval(b, inputs, y0);
+	if(nok){
+		MSG("External evaluation error (%d) at base point",nok);
+		ASC_FREE(y0);
+		b->interp.task = old_task;
+		return nok;
+	}
+
+	/* sort the columns by group */
+	ngroups = settled ? b->fdNGroups : n;
+	gstart = ASC_NEW_ARRAY_CLEAR(int, ngroups + 1);
+	gcol = ASC_NEW_ARRAY(int, n + 1);
+	h = ASC_NEW_ARRAY(double, n + 1);
+	for(c = 0; c < n; ++c){
+		gstart[(settled ? b->fdGroup[c] : c) + 1]++;
+		h[c] = blackbox_peturbation(inputs[c]);
+	}
+	for(g = 0; g < ngroups; ++g)gstart[g+1] += gstart[g];
+	for(c = 0; c < n; ++c){
+		/* gstart[g] is used as the fill position, then restored below */
+		gcol[gstart[settled ? b->fdGroup[c] : c]++] = c;
+	}
+	for(g = ngroups; g > 0; --g)gstart[g] = gstart[g-1];
+	gstart[0] = 0;
+
+	f.b = b;
+	f.fn = GetValueFunc(b->efunc);
+	f.x = inputs;
+	f.h = h;
+	f.gstart = gstart;
+	f.gcol = gcol;
+	f.xw = ASC_NEW_ARRAY(double, (size_t)ngroups * n + 1);
+	f.yw = ASC_NEW_ARRAY(double, (size_t)ngroups * m + 1);
+	f.nok = ASC_NEW_ARRAY_CLEAR(int, ngroups + 1);
+	f.held = ASC_NEW_ARRAY_CLEAR(int, ngroups + 1);
+
+	b->interp.task = bb_func_eval;
+	pool = (ngroups > 1 && GetValueFuncReentrant(b->efunc)) ? blackbox_get_pool() : NULL;
+	f.parallel = (pool != NULL);
+	if(pool != NULL){
+		threadpool_run(pool, ngroups, &blackbox_fd_task, &f);
+		f.parallel = 0;
+		for(g = 0; g < ngroups; ++g){
+			if(f.held[g]){
+				blackbox_fd_task(&f, g, 0);
+				break;
+			}
+		}
+	}else{
+		for(g = 0; g < ngroups; ++g){
+			blackbox_fd_task(&f, g, 0);
+			if(f.nok[g])break;
+		}
+	}
+	b->interp.task = old_task;
+
+	for(g = 0; g < ngroups && !nok; ++g){
+		nok = f.nok[g];
+	}
+	if(!nok && settled){
+		for(g = 0; g < ngroups; ++g){
+			if(blackbox_fd_unexplained(b, gstart, gcol, g, y0, f.yw + (size_t)g * m)){
+				MSG("Blackbox sparsity has changed; finding it again");
+				blackbox_fd_ungroup(b);
+				break;
+			}
+		}
+		if(g < ngroups){
+			/* again, one input at a time (the base point is remembered) */
+			nok = blackbox_fdiff(b, inputs, jac);
+			goto done;
+		}
+	}
+
+	if(nok){
+		MSG("External evaluation error (%d) for peturbed values",nok);
+	}else{
+		if(grouped && !settled && b->fdPattern == NULL){
+			b->fdPattern = ASC_NEW_ARRAY_CLEAR(unsigned char, (size_t)n * m + 1);
+		}
+		/* fill load jacobian */
+		for(g = 0; g < ngroups; ++g){
+			const double *y = f.yw + (size_t)g * m;
+			for(k = gstart[g]; k < gstart[g+1]; ++k){
+				c = gcol[k];
+				for(r = 0; r < m; ++r){
+					if(settled && !b->fdPattern[r * n + c]){
+						jac[r * n + c] = 0;
+						continue;
+					}
+					jac[r * n + c] = (y[r] - y0[r]) / h[c];
+					if(grouped && !settled && y[r] != y0[r])b->fdPattern[r * n + c] = 1;
+				}
+			}
+		}
+		if(grouped && !settled && ++(b->fdPatternCount) >= BBOX_FD_PATTERN_EVALS){
+			blackbox_fd_group(b);
+		}
+	}
+
+done:
+	ASC_FREE(f.held);
+	ASC_FREE(f.nok);
+	ASC_FREE(f.yw);
+	ASC_FREE(f.xw);
+	ASC_FREE(h);
+	ASC_FREE(gcol);
+	ASC_FREE(gstart);
+	ASC_FREE(y0);
+	return nok;
 }
 
 /*------------------------------------------------------------------------------
@@ -550,6 +815,13 @@ struct BlackBoxCache *CreateBlackBoxCache(
 	b->hessian = NULL;
 	b->residCount = 0;
 	b->gradCount = 0;
+	b->memo = NULL;
+	b->memoLen = 0;
+	b->memoNext = 0;
+	b->fdPattern = NULL;
+	b->fdPatternCount = 0;
+	b->fdGroup = NULL;
+	b->fdNGroups = 0;
 	b->refCount = 1;
 	b->efunc = efunc;
 	return b;
@@ -624,6 +896,12 @@ static void DestroyBlackBoxCache(struct relation *rel, struct BlackBoxCache *b){
 	ascfree(b->inputsJac);
 	ascfree(b->outputs);
 	ascfree(b->jacobian);
+	if(b->memo)ASC_FREE(b->memo);
+	if(b->fdPattern)ASC_FREE(b->fdPattern);
+	if(b->fdGroup)ASC_FREE(b->fdGroup);
+	b->memo = NULL;
+	b->fdPattern = NULL;
+	b->fdGroup = NULL;
 	DeepDestroySpecialList(b->argListNames,(DestroyFunc)DestroyName);
 	b->argListNames = NULL;
 	DestroyName(b->dataName);
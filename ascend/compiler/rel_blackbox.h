@@ -102,6 +102,13 @@ struct BlackBoxCache { /* was extrelcache, sort of. */
 	double *hessian; /**< undetermined format */
 	int residCount; /**< number of calls made for y output. */
 	int gradCount; /**< number of calls made for gradient. */
+	double *memo; /**< recently evaluated points, each inputs then outputs, reused on an exact match of the inputs */
+	int memoLen; /**< number of points in memo */
+	int memoNext; /**< slot in memo to be replaced next */
+	unsigned char *fdPattern; /**< outputs x inputs, nonzero where a finite-difference derivative has been seen */
+	int fdPatternCount; /**< number of full finite-difference jacobians merged into fdPattern */
+	int *fdGroup; /**< column group of each input, once fdPattern is settled; else NULL */
+	int fdNGroups; /**< number of column groups */
 	int refCount; /**< when to destroy */
 	int count; /**< serial number */
 };
@@ -165,6 +172,9 @@ extern void InitBBox(struct Instance *context, struct BlackBoxCache *b);
  */
 extern void DeleteRefBlackBoxCache(struct relation *rel, struct BlackBoxCache **b);
 
+/** Stop the threads used for finite differences of reentrant blackboxes. */
+extern void BlackBoxDestroyPool(void);
+
 /* @} */
 
 #endif /* ASC_REL_BLACKBOX_H */
@@ -0,0 +1,1158 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Compiled ('bytecode') form of token relations. See rel_bytecode.h.
+*/
+
+#include "rel_bytecode.h"
+
+#include <math.h>
+#include <ascend/general/config.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+#include <ascend/general/list.h>
+
+#include "func.h"
+#include "atomvalue.h"
+#include "vlist.h"
+#include "relation.h"
+#include "relation_util.h"
+
+#ifdef ASC_HAVE_PTHREADS
+# include <pthread.h>
+/* relations can be evaluated, and so compiled, from several threads */
+static pthread_mutex_t relbc_compile_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*
+	Access to the program pointer on the shared tokens. A program is stored
+	(with release order) only once it is complete, so a thread that loads
+	it (with acquire order) without the lock sees it whole. Without atomics,
+	RELBC_LOAD gives NULL so that the pointer is only read under the lock.
+*/
+#if defined(ASC_HAVE_PTHREADS) && defined(__GNUC__)
+# define RELBC_LOAD(P) __atomic_load_n(&(P),__ATOMIC_ACQUIRE)
+# define RELBC_STORE(P,V) __atomic_store_n(&(P),(V),__ATOMIC_RELEASE)
+#elif defined(ASC_HAVE_PTHREADS)
+# define RELBC_LOAD(P) NULL
+# define RELBC_STORE(P,V) ((P) = (V))
+#else
+# define RELBC_LOAD(P) (P)
+# define RELBC_STORE(P,V) ((P) = (V))
+#endif
+
+/* #define RELBC_DEBUG */
+#ifdef RELBC_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+/**
+	Number of registers (or variable values) that the evaluators keep on the
+	C stack before resorting to the heap. Most relations are far shorter.
+*/
+#define RELBC_LOCAL 128
+
+enum RelBCOp{
+	RBC_CONST, RBC_VAR,
+	RBC_ADD, RBC_SUB, RBC_MUL, RBC_DIV, RBC_POW, RBC_IPOW,
+	RBC_NEG, RBC_FUNC
+};
+
+/**
+	One instruction. The result goes to the register with the same index as
+	the instruction; a and b are operand registers (always lower than the
+	instruction's own index). 'dep' is set if the result depends on any
+	variable, which lets the reverse sweep skip constant subexpressions.
+*/
+struct RelBCInstr{
+	unsigned char op;
+	unsigned char dep;
+	unsigned a, b;
+	union{
+		double value;          /**< RBC_CONST */
+		unsigned long varnum;  /**< RBC_VAR, counting from 0 */
+		CONST struct Func *func; /**< RBC_FUNC */
+	} u;
+};
+
+struct RelationBytecode{
+	unsigned long len;   /**< number of instructions */
+	unsigned long nvars; /**< highest varnum referred to, plus one */
+	struct RelBCInstr code[];
+};
+
+/**
+	Stored on a TokenRelation that could not be compiled, so that we don't
+	keep trying. Never dereferenced by the evaluators.
+*/
+static struct RelationBytecode g_relbc_uncompilable;
+#define RELBC_FAILED (&g_relbc_uncompilable)
+
+/*------------------------------------------------------------------------------
+  COMPILATION
+*/
+
+/**
+	Append the instructions for one side of a relation.
+	@return 0 on success, with the side's result in the last register written.
+*/
+static int relbc_compile_side(struct RelationBytecode *bc
+		, CONST union RelationTermUnion *side, unsigned long len
+		, unsigned *rstack
+){
+	unsigned long t;
+	long top = -1;
+	CONST struct relation_term *term;
+	struct RelBCInstr *c;
+
+	for(t = 0; t < len; ++t){
+		term = A_TERM(&(side[t]));
+		c = &(bc->code[bc->len]);
+		c->dep = 0;
+		c->a = c->b = 0;
+		switch(term->t){
+		case e_zero:
+		case e_real:
+			c->op = RBC_CONST;
+			c->u.value = R_TERM(term)->value;
+			break;
+		case e_int:
+			c->op = RBC_CONST;
+			c->u.value = (double)I_TERM(term)->ivalue;
+			break;
+		case e_var:
+			c->op = RBC_VAR;
+			c->dep = 1;
+			c->u.varnum = V_TERM(term)->varnum - 1;
+			if(V_TERM(term)->varnum > bc->nvars){
+				bc->nvars = V_TERM(term)->varnum;
+			}
+			break;
+		case e_uminus:
+		case e_func:
+			if(top < 0)return 1;
+			c->a = rstack[top--];
+			c->dep = bc->code[c->a].dep;
+			if(term->t == e_func){
+				c->op = RBC_FUNC;
+				c->u.func = F_TERM(term)->fptr;
+			}else{
+				c->op = RBC_NEG;
+			}
+			break;
+		case e_plus:
+		case e_minus:
+		case e_times:
+		case e_divide:
+		case e_power:
+		case e_ipower:
+			if(top < 1)return 1;
+			c->b = rstack[top--];
+			c->a = rstack[top--];
+			c->dep = bc->code[c->a].dep || bc->code[c->b].dep;
+			switch(term->t){
+				case e_plus: c->op = RBC_ADD; break;
+				case e_minus: c->op = RBC_SUB; break;
+				case e_times: c->op = RBC_MUL; break;
+				case e_divide: c->op = RBC_DIV; break;
+				case e_power: c->op = RBC_POW; break;
+				default: c->op = RBC_IPOW; break;
+			}
+			break;
+		default:
+			MSG("unsupported token type %d",term->t);
+			return 1;
+		}
+		rstack[++top] = (unsigned)bc->len;
+		bc->len++;
+	}
+	return (top == 0) ? 0 : 1;
+}
+
+struct RelationBytecode *RelationBytecodeCompile(CONST struct relation *r){
+	struct RelationBytecode *bc;
+	unsigned long lhs_len, rhs_len, maxlen;
+	unsigned lroot = 0, rroot = 0;
+	unsigned *rstack;
+	struct RelBCInstr *c;
+	int err = 0;
+
+	asc_assert(r!=NULL);
+	lhs_len = RTOKEN(r).lhs!=NULL ? RTOKEN(r).lhs_len : 0;
+	rhs_len = RTOKEN(r).rhs!=NULL ? RTOKEN(r).rhs_len : 0;
+	if(lhs_len + rhs_len == 0){
+		return NULL;
+	}
+
+	bc = (struct RelationBytecode *)ascmalloc(sizeof(struct RelationBytecode)
+		+ (lhs_len + rhs_len + 1)*sizeof(struct RelBCInstr)
+	);
+	if(bc==NULL)return NULL;
+	bc->len = 0;
+	bc->nvars = 0;
+
+	maxlen = lhs_len > rhs_len ? lhs_len : rhs_len;
+	rstack = ASC_NEW_ARRAY(unsigned,maxlen);
+	if(rstack==NULL){
+		ascfree(bc);
+		return NULL;
+	}
+
+	if(lhs_len){
+		err = relbc_compile_side(bc,RTOKEN(r).lhs,lhs_len,rstack);
+		lroot = bc->len - 1;
+	}
+	if(!err && rhs_len){
+		err = relbc_compile_side(bc,RTOKEN(r).rhs,rhs_len,rstack);
+		rroot = bc->len - 1;
+	}
+	ASC_FREE(rstack);
+	if(err){
+		ascfree(bc);
+		return NULL;
+	}
+
+	/* residual is lhs - rhs, or -rhs if there is no lhs */
+	if(rhs_len){
+		c = &(bc->code[bc->len]);
+		if(lhs_len){
+			c->op = RBC_SUB;
+			c->a = lroot;
+			c->b = rroot;
+			c->dep = bc->code[lroot].dep || bc->code[rroot].dep;
+		}else{
+			c->op = RBC_NEG;
+			c->a = rroot;
+			c->b = 0;
+			c->dep = bc->code[rroot].dep;
+		}
+		bc->len++;
+	}
+	MSG("compiled %lu+%lu tokens into %lu instructions",lhs_len,rhs_len,bc->len);
+	return bc;
+}
+
+struct RelationBytecode *RelationBytecodeGet(CONST struct relation *r){
+	struct RelationBytecode *bc;
+	asc_assert(r!=NULL && r->share!=NULL);
+	bc = RELBC_LOAD(RTOKEN(r).bytecode);
+	if(bc==NULL){
+#ifdef ASC_HAVE_PTHREADS
+		pthread_mutex_lock(&relbc_compile_lock);
+		bc = RTOKEN(r).bytecode;
+		if(bc==NULL){
+#endif
+		bc = RelationBytecodeCompile(r);
+		if(bc==NULL)bc = RELBC_FAILED;
+		RELBC_STORE(RTOKEN(r).bytecode,bc);
+#ifdef ASC_HAVE_PTHREADS
+		}
+		pthread_mutex_unlock(&relbc_compile_lock);
+#endif
+	}
+	return (bc==RELBC_FAILED) ? NULL : bc;
+}
+
+void RelationBytecodeDestroy(struct RelationBytecode *bc){
+	if(bc!=NULL && bc!=RELBC_FAILED){
+		ascfree(bc);
+	}
+}
+
+void RelationBytecodeInvalidate(struct relation *r){
+	if(r==NULL || r->share==NULL)return;
+	RelationBytecodeDestroy(RTOKEN(r).bytecode);
+	RTOKEN(r).bytecode = NULL;
+}
+
+void RelationBytecodeDisable(struct relation *r){
+	if(r==NULL || r->share==NULL)return;
+	RelationBytecodeDestroy(RTOKEN(r).bytecode);
+	RTOKEN(r).bytecode = RELBC_FAILED;
+}
+
+unsigned long RelationBytecodeLength(CONST struct RelationBytecode *bc){
+	return bc->len;
+}
+
+unsigned long RelationBytecodeNumVars(CONST struct RelationBytecode *bc){
+	return bc->nvars;
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION
+*/
+
+/** Forward sweep, filling registers v[0..len-1] */
+static void relbc_forward(CONST struct RelationBytecode *bc
+		, CONST double *x, double *v
+){
+	unsigned long i;
+	CONST struct RelBCInstr *c = bc->code;
+	for(i = 0; i < bc->len; ++i, ++c){
+		switch(c->op){
+		case RBC_CONST: v[i] = c->u.value; break;
+		case RBC_VAR:   v[i] = x[c->u.varnum]; break;
+		case RBC_ADD:   v[i] = v[c->a] + v[c->b]; break;
+		case RBC_SUB:   v[i] = v[c->a] - v[c->b]; break;
+		case RBC_MUL:   v[i] = v[c->a] * v[c->b]; break;
+		case RBC_DIV:   v[i] = v[c->a] / v[c->b]; break;
+		case RBC_POW:   v[i] = pow(v[c->a], v[c->b]); break;
+		case RBC_IPOW:  v[i] = asc_ipow(v[c->a], (int)v[c->b]); break;
+		case RBC_NEG:   v[i] = -v[c->a]; break;
+		case RBC_FUNC:  v[i] = FuncEval(c->u.func, v[c->a]); break;
+		}
+	}
+}
+
+static void relbc_forward_safe(CONST struct RelationBytecode *bc
+		, CONST double *x, double *v, enum safe_err *serr
+){
+	unsigned long i;
+	CONST struct RelBCInstr *c = bc->code;
+	for(i = 0; i < bc->len; ++i, ++c){
+		switch(c->op){
+		case RBC_CONST: v[i] = c->u.value; break;
+		case RBC_VAR:   v[i] = x[c->u.varnum]; break;
+		case RBC_ADD:   v[i] = safe_add_D0(v[c->a], v[c->b], serr); break;
+		case RBC_SUB:   v[i] = safe_sub_D0(v[c->a], v[c->b], serr); break;
+		case RBC_MUL:   v[i] = safe_mul_D0(v[c->a], v[c->b], serr); break;
+		case RBC_DIV:   v[i] = safe_div_D0(v[c->a], v[c->b], serr); break;
+		case RBC_POW:   v[i] = safe_pow_D0(v[c->a], v[c->b], serr); break;
+		case RBC_IPOW:  v[i] = safe_ipow_D0(v[c->a], v[c->b], serr); break;
+		case RBC_NEG:   v[i] = -v[c->a]; break;
+		case RBC_FUNC:  v[i] = FuncEvalSafe(c->u.func, v[c->a], serr); break;
+		}
+	}
+}
+
+/**
+	Reverse sweep. On entry v holds the forward-sweep registers; w is
+	scratch for the adjoints. Only operands flagged 'dep' receive adjoints,
+	so eg the exponent of x^2.5 never has its (meaningless) partial taken.
+*/
+static void relbc_reverse(CONST struct RelationBytecode *bc
+		, CONST double *v, double *w, double *grad
+){
+	unsigned long i;
+	double d, p;
+	CONST struct RelBCInstr *c, *code = bc->code;
+
+	for(i = 0; i < bc->len; ++i)w[i] = 0.0;
+	w[bc->len - 1] = 1.0;
+	for(i = bc->len; i-- > 0;){
+		c = &(code[i]);
+		if(!c->dep)continue;
+		d = w[i];
+		switch(c->op){
+		case RBC_VAR:
+			grad[c->u.varnum] += d;
+			break;
+		case RBC_ADD:
+			if(code[c->a].dep)w[c->a] += d;
+			if(code[c->b].dep)w[c->b] += d;
+			break;
+		case RBC_SUB:
+			if(code[c->a].dep)w[c->a] += d;
+			if(code[c->b].dep)w[c->b] -= d;
+			break;
+		case RBC_MUL:
+			if(code[c->a].dep)w[c->a] += d * v[c->b];
+			if(code[c->b].dep)w[c->b] += d * v[c->a];
+			break;
+		case RBC_DIV:
+			/* d(u/v) = (1/v) * [du - (u/v)*dv] */
+			p = 1.0 / v[c->b];
+			if(code[c->a].dep)w[c->a] += d * p;
+			if(code[c->b].dep)w[c->b] -= d * v[i] * p;
+			break;
+		case RBC_POW:
+			/* d(u^v) = v * u^(v-1) * du + ln(u) * u^v * dv */
+			if(code[c->a].dep){
+				w[c->a] += d * v[c->b] * pow(v[c->a], v[c->b] - 1.0);
+			}
+			if(code[c->b].dep)w[c->b] += d * log(v[c->a]) * v[i];
+			break;
+		case RBC_IPOW:
+			if(code[c->a].dep){
+				w[c->a] += d * asc_d1ipow(v[c->a], (int)v[c->b]);
+			}
+			if(code[c->b].dep)w[c->b] += d * log(v[c->a]) * v[i];
+			break;
+		case RBC_NEG:
+			w[c->a] -= d;
+			break;
+		case RBC_FUNC:
+			w[c->a] += d * FuncDeriv(c->u.func, v[c->a]);
+			break;
+		}
+	}
+}
+
+static void relbc_reverse_safe(CONST struct RelationBytecode *bc
+		, CONST double *v, double *w, double *grad, enum safe_err *serr
+){
+	unsigned long i;
+	double d, p;
+	CONST struct RelBCInstr *c, *code = bc->code;
+
+	for(i = 0; i < bc->len; ++i)w[i] = 0.0;
+	w[bc->len - 1] = 1.0;
+	for(i = bc->len; i-- > 0;){
+		c = &(code[i]);
+		if(!c->dep)continue;
+		d = w[i];
+		switch(c->op){
+		case RBC_VAR:
+			grad[c->u.varnum] = safe_add_D0(grad[c->u.varnum], d, serr);
+			break;
+		case RBC_ADD:
+			if(code[c->a].dep)w[c->a] = safe_add_D0(w[c->a], d, serr);
+			if(code[c->b].dep)w[c->b] = safe_add_D0(w[c->b], d, serr);
+			break;
+		case RBC_SUB:
+			if(code[c->a].dep)w[c->a] = safe_add_D0(w[c->a], d, serr);
+			if(code[c->b].dep)w[c->b] = safe_sub_D0(w[c->b], d, serr);
+			break;
+		case RBC_MUL:
+			if(code[c->a].dep){
+				w[c->a] = safe_add_D0(w[c->a], safe_mul_D0(d, v[c->b], serr), serr);
+			}
+			if(code[c->b].dep){
+				w[c->b] = safe_add_D0(w[c->b], safe_mul_D0(d, v[c->a], serr), serr);
+			}
+			break;
+		case RBC_DIV:
+			p = safe_rec(v[c->b], serr);
+			if(code[c->a].dep){
+				w[c->a] = safe_add_D0(w[c->a], safe_mul_D0(d, p, serr), serr);
+			}
+			if(code[c->b].dep){
+				w[c->b] = safe_sub_D0(w[c->b]
+					, safe_mul_D0(d, safe_mul_D0(v[i], p, serr), serr), serr
+				);
+			}
+			break;
+		case RBC_POW:
+			if(code[c->a].dep){
+				p = safe_pow_D1(v[c->a], v[c->b], 0, serr);
+				w[c->a] = safe_add_D0(w[c->a], safe_mul_D0(d, p, serr), serr);
+			}
+			if(code[c->b].dep){
+				p = safe_pow_D1(v[c->a], v[c->b], 1, serr);
+				w[c->b] = safe_add_D0(w[c->b], safe_mul_D0(d, p, serr), serr);
+			}
+			break;
+		case RBC_IPOW:
+			/* integer exponents are taken as constant, see safe_ipow_D1 */
+			if(code[c->a].dep){
+				p = safe_ipow_D1(v[c->a], v[c->b], 0, serr);
+				w[c->a] = safe_add_D0(w[c->a], safe_mul_D0(d, p, serr), serr);
+			}
+			break;
+		case RBC_NEG:
+			w[c->a] = safe_sub_D0(w[c->a], d, serr);
+			break;
+		case RBC_FUNC:
+			p = FuncDerivSafe(c->u.func, v[c->a], serr);
+			w[c->a] = safe_add_D0(w[c->a], safe_mul_D0(d, p, serr), serr);
+			break;
+		}
+	}
+}
+
+double RelationBytecodeResidual(CONST struct RelationBytecode *bc
+		, CONST double *x
+){
+	double local[RELBC_LOCAL], *v, res;
+	v = (bc->len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(double,bc->len);
+	relbc_forward(bc,x,v);
+	res = v[bc->len - 1];
+	if(v!=local)ASC_FREE(v);
+	return res;
+}
+
+double RelationBytecodeResidualSafe(CONST struct RelationBytecode *bc
+		, CONST double *x, enum safe_err *serr
+){
+	double local[RELBC_LOCAL], *v, res;
+	v = (bc->len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(double,bc->len);
+	relbc_forward_safe(bc,x,v,serr);
+	res = v[bc->len - 1];
+	if(v!=local)ASC_FREE(v);
+	return res;
+}
+
+double RelationBytecodeResidGrad(CONST struct RelationBytecode *bc
+		, CONST double *x, double *grad, unsigned long nvars
+){
+	double local[2*RELBC_LOCAL], *v, res;
+	unsigned long j;
+	asc_assert(nvars >= bc->nvars);
+	v = (bc->len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(double,2*bc->len);
+	for(j = 0; j < nvars; ++j)grad[j] = 0.0;
+	relbc_forward(bc,x,v);
+	relbc_reverse(bc,v,v + bc->len,grad);
+	res = v[bc->len - 1];
+	if(v!=local)ASC_FREE(v);
+	return res;
+}
+
+double RelationBytecodeResidGradSafe(CONST struct RelationBytecode *bc
+		, CONST double *x, double *grad, unsigned long nvars, enum safe_err *serr
+){
+	double local[2*RELBC_LOCAL], *v, res;
+	unsigned long j;
+	asc_assert(nvars >= bc->nvars);
+	v = (bc->len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(double,2*bc->len);
+	for(j = 0; j < nvars; ++j)grad[j] = 0.0;
+	relbc_forward_safe(bc,x,v,serr);
+	relbc_reverse_safe(bc,v,v + bc->len,grad,serr);
+	res = v[bc->len - 1];
+	if(v!=local)ASC_FREE(v);
+	return res;
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION IN LANES
+
+  The same sweeps as above, but each register holds one value for each of
+  RELBC_LANES relations. With GCC and clang the registers are generic
+  vector types, so the arithmetic compiles to SIMD instructions (AVX2 or
+  AVX-512 when targeted); otherwise they are plain arrays and each
+  operation is a short loop. Operations with no SIMD form (powers,
+  functions and the guarded ones of safe.h) are done lane by lane with the
+  scalar routines. Every lane follows exactly the arithmetic of the scalar
+  sweeps, so the results do not depend on how the relations are grouped.
+*/
+
+#if defined(__GNUC__) && !defined(RELBC_NO_VECTOR)
+/* aligned to double only, so that heap arrays of these are safe to use */
+typedef double relbc_vec __attribute__((vector_size(RELBC_LANES*sizeof(double)),aligned(sizeof(double))));
+# define RELBC_LANE(V,L) ((V)[L])
+# define RELBC_VOP(R,A,OP,B) ((R) = (A) OP (B))
+# define RELBC_VNEG(R,A) ((R) = -(A))
+#else
+typedef struct{double d[RELBC_LANES];} relbc_vec;
+# define RELBC_LANE(V,L) ((V).d[L])
+# define RELBC_VOP(R,A,OP,B) do{ int l_; \
+		for(l_ = 0; l_ < RELBC_LANES; ++l_){ \
+			(R).d[l_] = (A).d[l_] OP (B).d[l_]; \
+		} \
+	}while(0)
+# define RELBC_VNEG(R,A) do{ int l_; \
+		for(l_ = 0; l_ < RELBC_LANES; ++l_)(R).d[l_] = -(A).d[l_]; \
+	}while(0)
+#endif
+
+#define RELBC_VSET(R,X) do{ int l_; \
+		for(l_ = 0; l_ < RELBC_LANES; ++l_)RELBC_LANE(R,l_) = (X); \
+	}while(0)
+
+/**
+	Forward sweep in lanes. serr is NULL for plain arithmetic, else an
+	array of RELBC_LANES flags for the safe versions.
+*/
+static void relbc_forward_lanes(CONST struct RelationBytecode *bc
+		, CONST relbc_vec *x, relbc_vec *v, enum safe_err *serr
+){
+	unsigned long i;
+	int l;
+	relbc_vec p;
+	CONST struct RelBCInstr *c = bc->code;
+	for(i = 0; i < bc->len; ++i, ++c){
+		CONST relbc_vec *a = &(v[c->a]), *b = &(v[c->b]);
+		switch(c->op){
+		case RBC_CONST: RELBC_VSET(v[i], c->u.value); break;
+		case RBC_VAR:   v[i] = x[c->u.varnum]; break;
+		case RBC_ADD:   RELBC_VOP(v[i], *a, +, *b); break;
+		case RBC_SUB:   RELBC_VOP(v[i], *a, -, *b); break;
+		case RBC_MUL:   RELBC_VOP(v[i], *a, *, *b); break;
+		case RBC_DIV:
+			if(serr == NULL){
+				RELBC_VOP(v[i], *a, /, *b);
+				break;
+			}
+			for(l = 0; l < RELBC_LANES; ++l){
+				RELBC_LANE(p,l) = safe_rec(RELBC_LANE(*b,l), &serr[l]);
+			}
+			RELBC_VOP(v[i], *a, *, p);
+			break;
+		case RBC_POW:
+			for(l = 0; l < RELBC_LANES; ++l){
+				RELBC_LANE(v[i],l) = serr
+					? safe_pow_D0(RELBC_LANE(*a,l), RELBC_LANE(*b,l), &serr[l])
+					: pow(RELBC_LANE(*a,l), RELBC_LANE(*b,l));
+			}
+			break;
+		case RBC_IPOW:
+			for(l = 0; l < RELBC_LANES; ++l){
+				RELBC_LANE(v[i],l) = serr
+					? safe_ipow_D0(RELBC_LANE(*a,l), RELBC_LANE(*b,l), &serr[l])
+					: asc_ipow(RELBC_LANE(*a,l), (int)RELBC_LANE(*b,l));
+			}
+			break;
+		case RBC_NEG:   RELBC_VNEG(v[i], *a); break;
+		case RBC_FUNC:
+			for(l = 0; l < RELBC_LANES; ++l){
+				RELBC_LANE(v[i],l) = serr
+					? FuncEvalSafe(c->u.func, RELBC_LANE(*a,l), &serr[l])
+					: FuncEval(c->u.func, RELBC_LANE(*a,l));
+			}
+			break;
+		}
+	}
+}
+
+/**
+	Reverse sweep in lanes, as relbc_reverse (serr NULL) or
+	relbc_reverse_safe. The gradient blocks g must be zeroed by the caller.
+*/
+static void relbc_reverse_lanes(CONST struct RelationBytecode *bc
+		, CONST relbc_vec *v, relbc_vec *w, relbc_vec *g, enum safe_err *serr
+){
+	unsigned long i;
+	int l;
+	relbc_vec d, p, t;
+	CONST struct RelBCInstr *c, *code = bc->code;
+
+	for(i = 0; i < bc->len; ++i)RELBC_VSET(w[i], 0.0);
+	RELBC_VSET(w[bc->len - 1], 1.0);
+	for(i = bc->len; i-- > 0;){
+		c = &(code[i]);
+		if(!c->dep)continue;
+		d = w[i];
+		switch(c->op){
+		case RBC_VAR:
+			RELBC_VOP(g[c->u.varnum], g[c->u.varnum], +, d);
+			break;
+		case RBC_ADD:
+			if(code[c->a].dep)RELBC_VOP(w[c->a], w[c->a], +, d);
+			if(code[c->b].dep)RELBC_VOP(w[c->b], w[c->b], +, d);
+			break;
+		case RBC_SUB:
+			if(code[c->a].dep)RELBC_VOP(w[c->a], w[c->a], +, d);
+			if(code[c->b].dep)RELBC_VOP(w[c->b], w[c->b], -, d);
+			break;
+		case RBC_MUL:
+			if(code[c->a].dep){
+				RELBC_VOP(t, d, *, v[c->b]);
+				RELBC_VOP(w[c->a], w[c->a], +, t);
+			}
+			if(code[c->b].dep){
+				RELBC_VOP(t, d, *, v[c->a]);
+				RELBC_VOP(w[c->b], w[c->b], +, t);
+			}
+			break;
+		case RBC_DIV:
+			if(serr == NULL){
+				RELBC_VSET(t, 1.0);
+				RELBC_VOP(p, t, /, v[c->b]);
+			}else{
+				for(l = 0; l < RELBC_LANES; ++l){
+					RELBC_LANE(p,l) = safe_rec(RELBC_LANE(v[c->b],l), &serr[l]);
+				}
+			}
+			if(code[c->a].dep){
+				RELBC_VOP(t, d, *, p);
+				RELBC_VOP(w[c->a], w[c->a], +, t);
+			}
+			if(code[c->b].dep){
+				/* associated as in the scalar sweeps */
+				if(serr == NULL){
+					RELBC_VOP(t, d, *, v[i]);
+					RELBC_VOP(t, t, *, p);
+				}else{
+					RELBC_VOP(t, v[i], *, p);
+					RELBC_VOP(t, d, *, t);
+				}
+				RELBC_VOP(w[c->b], w[c->b], -, t);
+			}
+			break;
+		case RBC_POW:
+			if(code[c->a].dep){
+				for(l = 0; l < RELBC_LANES; ++l){
+					RELBC_LANE(p,l) = serr
+						? safe_pow_D1(RELBC_LANE(v[c->a],l), RELBC_LANE(v[c->b],l), 0, &serr[l])
+						: pow(RELBC_LANE(v[c->a],l), RELBC_LANE(v[c->b],l) - 1.0);
+				}
+				if(serr == NULL){
+					RELBC_VOP(t, d, *, v[c->b]);
+					RELBC_VOP(t, t, *, p);
+				}else{
+					RELBC_VOP(t, d, *, p);
+				}
+				RELBC_VOP(w[c->a], w[c->a], +, t);
+			}
+			if(code[c->b].dep){
+				for(l = 0; l < RELBC_LANES; ++l){
+					RELBC_LANE(p,l) = serr
+						? safe_pow_D1(RELBC_LANE(v[c->a],l), RELBC_LANE(v[c->b],l), 1, &serr[l])
+						: log(RELBC_LANE(v[c->a],l));
+				}
+				RELBC_VOP(t, d, *, p);
+				if(serr == NULL)RELBC_VOP(t, t, *, v[i]);
+				RELBC_VOP(w[c->b], w[c->b], +, t);
+			}
+			break;
+		case RBC_IPOW:
+			if(code[c->a].dep){
+				for(l = 0; l < RELBC_LANES; ++l){
+					RELBC_LANE(p,l) = serr
+						? safe_ipow_D1(RELBC_LANE(v[c->a],l), RELBC_LANE(v[c->b],l), 0, &serr[l])
+						: asc_d1ipow(RELBC_LANE(v[c->a],l), (int)RELBC_LANE(v[c->b],l));
+				}
+				RELBC_VOP(t, d, *, p);
+				RELBC_VOP(w[c->a], w[c->a], +, t);
+			}
+			/* integer exponents are taken as constant in safe mode */
+			if(code[c->b].dep && serr == NULL){
+				for(l = 0; l < RELBC_LANES; ++l){
+					RELBC_LANE(p,l) = log(RELBC_LANE(v[c->a],l));
+				}
+				RELBC_VOP(t, d, *, p);
+				RELBC_VOP(t, t, *, v[i]);
+				RELBC_VOP(w[c->b], w[c->b], +, t);
+			}
+			break;
+		case RBC_NEG:
+			RELBC_VOP(w[c->a], w[c->a], -, d);
+			break;
+		case RBC_FUNC:
+			for(l = 0; l < RELBC_LANES; ++l){
+				RELBC_LANE(p,l) = serr
+					? FuncDerivSafe(c->u.func, RELBC_LANE(v[c->a],l), &serr[l])
+					: FuncDeriv(c->u.func, RELBC_LANE(v[c->a],l));
+			}
+			RELBC_VOP(t, d, *, p);
+			RELBC_VOP(w[c->a], w[c->a], +, t);
+			break;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------
+  SECOND DERIVATIVES
+*/
+
+unsigned long RelationBytecodeNonlinearVars(CONST struct RelationBytecode *bc
+		, unsigned char *nl
+){
+	unsigned char local[RELBC_LOCAL], *f;
+	unsigned long i, count = 0;
+	CONST struct RelBCInstr *c, *code = bc->code;
+
+	f = (bc->len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(unsigned char,bc->len);
+	for(i = 0; i < bc->len; ++i)f[i] = 0;
+	for(i = 0; i < bc->nvars; ++i)nl[i] = 0;
+
+	/*
+		f[i] is set if the value of register i enters the residual through
+		a nonlinear operation. Linear operations pass the flag down to
+		their operands; the rest set it on any operand that depends on a
+		variable. A product or quotient by a constant is linear.
+	*/
+	for(i = bc->len; i-- > 0;){
+		c = &(code[i]);
+		if(!c->dep)continue;
+		switch(c->op){
+		case RBC_VAR:
+			if(f[i] && !nl[c->u.varnum]){
+				nl[c->u.varnum] = 1;
+				count++;
+			}
+			break;
+		case RBC_ADD:
+		case RBC_SUB:
+			f[c->a] |= f[i];
+			f[c->b] |= f[i];
+			break;
+		case RBC_NEG:
+			f[c->a] |= f[i];
+			break;
+		case RBC_MUL:
+			if(code[c->a].dep && code[c->b].dep){
+				f[c->a] = f[c->b] = 1;
+			}else{
+				f[c->a] |= f[i];
+				f[c->b] |= f[i];
+			}
+			break;
+		case RBC_DIV:
+			if(code[c->b].dep){
+				f[c->a] = f[c->b] = 1;
+			}else{
+				f[c->a] |= f[i];
+			}
+			break;
+		case RBC_FUNC:
+			f[c->a] = 1;
+			break;
+		default: /* RBC_POW, RBC_IPOW */
+			f[c->a] = f[c->b] = 1;
+			break;
+		}
+	}
+	if(f!=local)ASC_FREE(f);
+	return count;
+}
+
+/**
+	Derivatives of u^n for integer n. Unlike asc_d1ipow and asc_d2ipow
+	these are exact (and silent) at u = 0 for small n, which matters for
+	the very common x^2 evaluated at a zero starting point.
+*/
+static double relbc_d1ipow(double u, int n){
+	return (n == 0) ? 0.0 : n * asc_ipow(u, n - 1);
+}
+
+static double relbc_d2ipow(double u, int n){
+	return (n == 0 || n == 1) ? 0.0 : n * (n - 1) * asc_ipow(u, n - 2);
+}
+
+/**
+	Forward tangent sweep in the direction of variable k: vd[i] receives
+	the derivative of register i with respect to x[k].
+*/
+static void relbc_tangent(CONST struct RelationBytecode *bc
+		, CONST double *v, unsigned long k, double *vd
+){
+	unsigned long i;
+	double p;
+	CONST struct RelBCInstr *c, *code = bc->code;
+	for(i = 0; i < bc->len; ++i){
+		c = &(code[i]);
+		if(!c->dep){
+			vd[i] = 0.0;
+			continue;
+		}
+		switch(c->op){
+		case RBC_VAR: vd[i] = (c->u.varnum == k) ? 1.0 : 0.0; break;
+		case RBC_ADD: vd[i] = vd[c->a] + vd[c->b]; break;
+		case RBC_SUB: vd[i] = vd[c->a] - vd[c->b]; break;
+		case RBC_NEG: vd[i] = -vd[c->a]; break;
+		case RBC_MUL: vd[i] = vd[c->a] * v[c->b] + v[c->a] * vd[c->b]; break;
+		case RBC_DIV: vd[i] = (vd[c->a] - v[i] * vd[c->b]) / v[c->b]; break;
+		case RBC_POW:
+			p = 0.0;
+			if(vd[c->a] != 0.0){
+				p = vd[c->a] * v[c->b] * pow(v[c->a], v[c->b] - 1.0);
+			}
+			if(vd[c->b] != 0.0){
+				p += vd[c->b] * log(v[c->a]) * v[i];
+			}
+			vd[i] = p;
+			break;
+		case RBC_IPOW:
+			vd[i] = vd[c->a] * relbc_d1ipow(v[c->a], (int)v[c->b]);
+			break;
+		case RBC_FUNC:
+			vd[i] = vd[c->a] * FuncDeriv(c->u.func, v[c->a]);
+			break;
+		default:
+			vd[i] = 0.0;
+		}
+	}
+}
+
+/**
+	Reverse sweep of the tangents (forward-over-reverse). v, w are the
+	values and adjoints, vd the tangents from relbc_tangent. On return
+	row[j] holds the second derivative with respect to x[j] and the
+	direction of the tangent sweep.
+*/
+static void relbc_reverse_tangent(CONST struct RelationBytecode *bc
+		, CONST double *v, CONST double *w, CONST double *vd
+		, double *wd, double *row
+){
+	unsigned long i;
+	double d, dd, q, p, pd, u, e;
+	int n;
+	CONST struct RelBCInstr *c, *code = bc->code;
+
+	for(i = 0; i < bc->len; ++i)wd[i] = 0.0;
+	for(i = bc->len; i-- > 0;){
+		c = &(code[i]);
+		if(!c->dep)continue;
+		d = w[i];
+		dd = wd[i];
+		switch(c->op){
+		case RBC_VAR:
+			row[c->u.varnum] += dd;
+			break;
+		case RBC_ADD:
+			wd[c->a] += dd;
+			wd[c->b] += dd;
+			break;
+		case RBC_SUB:
+			wd[c->a] += dd;
+			wd[c->b] -= dd;
+			break;
+		case RBC_NEG:
+			wd[c->a] -= dd;
+			break;
+		case RBC_MUL:
+			wd[c->a] += dd * v[c->b] + d * vd[c->b];
+			wd[c->b] += dd * v[c->a] + d * vd[c->a];
+			break;
+		case RBC_DIV:
+			q = v[c->b];
+			wd[c->a] += (dd - d * vd[c->b] / q) / q;
+			if(code[c->b].dep){
+				/* partial wrt q is -y/q; its tangent is -(yd - y*qd/q)/q */
+				wd[c->b] -= (dd * v[i] + d * (vd[i] - v[i] * vd[c->b] / q)) / q;
+			}
+			break;
+		case RBC_POW:
+			u = v[c->a];
+			e = v[c->b];
+			if(code[c->a].dep){
+				/* partial e*u^(e-1) */
+				p = e * pow(u, e - 1.0);
+				pd = vd[c->a] * e * (e - 1.0) * pow(u, e - 2.0);
+				if(code[c->b].dep){
+					pd += vd[c->b] * (pow(u, e - 1.0) + p * log(u));
+				}
+				wd[c->a] += dd * p + d * pd;
+			}
+			if(code[c->b].dep){
+				/* partial ln(u)*u^e */
+				p = log(u) * v[i];
+				pd = log(u) * vd[i];
+				if(code[c->a].dep)pd += vd[c->a] / u * v[i];
+				wd[c->b] += dd * p + d * pd;
+			}
+			break;
+		case RBC_IPOW:
+			n = (int)v[c->b];
+			wd[c->a] += dd * relbc_d1ipow(v[c->a], n)
+				+ d * relbc_d2ipow(v[c->a], n) * vd[c->a];
+			break;
+		case RBC_FUNC:
+			wd[c->a] += dd * FuncDeriv(c->u.func, v[c->a])
+				+ d * FuncDeriv2(c->u.func, v[c->a]) * vd[c->a];
+			break;
+		}
+	}
+}
+
+/**
+	Shared body of RelationBytecodeHessian(Safe). The value and adjoint
+	sweeps use safe arithmetic if serr is not NULL; the tangent sweeps
+	don't, but any non-finite result is then reported through *serr.
+*/
+static void relbc_hessian(CONST struct RelationBytecode *bc
+		, CONST double *x, CONST unsigned long *dirs, unsigned long ndirs
+		, double *hess, enum safe_err *serr
+){
+	double local[4*RELBC_LOCAL + 2*RELBC_LOCAL], *v, *w, *vd, *wd, *grad, *row;
+	unsigned long a, b, j, len = bc->len, nv = bc->nvars;
+	double *h = hess;
+
+	if(4*len + 2*nv <= sizeof(local)/sizeof(double)){
+		v = local;
+	}else{
+		v = ASC_NEW_ARRAY(double,4*len + 2*nv);
+	}
+	w = v + len;
+	vd = w + len;
+	wd = vd + len;
+	grad = wd + len;
+	row = grad + nv;
+
+	for(j = 0; j < nv; ++j)grad[j] = 0.0;
+	if(serr!=NULL){
+		relbc_forward_safe(bc,x,v,serr);
+		relbc_reverse_safe(bc,v,w,grad,serr);
+	}else{
+		relbc_forward(bc,x,v);
+		relbc_reverse(bc,v,w,grad);
+	}
+
+	for(a = 0; a < ndirs; ++a){
+		asc_assert(dirs[a] < nv);
+		for(j = 0; j < nv; ++j)row[j] = 0.0;
+		relbc_tangent(bc,v,dirs[a],vd);
+		relbc_reverse_tangent(bc,v,w,vd,wd,row);
+		for(b = 0; b <= a; ++b){
+			*h = row[dirs[b]];
+			if(serr!=NULL && !isfinite(*h)){
+				*h = 0.0;
+				*serr = safe_problem;
+			}
+			++h;
+		}
+	}
+
+	if(v!=local)ASC_FREE(v);
+}
+
+void RelationBytecodeHessian(CONST struct RelationBytecode *bc
+		, CONST double *x, CONST unsigned long *dirs, unsigned long ndirs
+		, double *hess
+){
+	relbc_hessian(bc,x,dirs,ndirs,hess,NULL);
+}
+
+void RelationBytecodeHessianSafe(CONST struct RelationBytecode *bc
+		, CONST double *x, CONST unsigned long *dirs, unsigned long ndirs
+		, double *hess, enum safe_err *serr
+){
+	relbc_hessian(bc,x,dirs,ndirs,hess,serr);
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION OF RELATIONS
+*/
+
+/**
+	Load the current values of the variables of r into an array, which is
+	'local' if it is long enough, otherwise a new heap array.
+*/
+static double *relbc_load_vars(CONST struct relation *r
+		, double *local, unsigned long *n
+){
+	unsigned long c, len;
+	double *x;
+	len = gl_length(r->vars);
+	x = (len <= RELBC_LOCAL) ? local : ASC_NEW_ARRAY(double,len);
+	for(c = 0; c < len; ++c){
+		x[c] = RealAtomValue((struct Instance *)gl_fetch(r->vars,c+1));
+	}
+	*n = len;
+	return x;
+}
+
+int RelationBytecodeCalcResidual(CONST struct relation *r, double *res){
+	double local[RELBC_LOCAL], *x;
+	unsigned long n;
+	struct RelationBytecode *bc = RelationBytecodeGet(r);
+	if(bc==NULL)return 1;
+	x = relbc_load_vars(r,local,&n);
+	*res = RelationBytecodeResidual(bc,x);
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
+
+int RelationBytecodeCalcResidualSafe(CONST struct relation *r
+		, double *res, enum safe_err *serr
+){
+	double local[RELBC_LOCAL], *x;
+	unsigned long n;
+	struct RelationBytecode *bc = RelationBytecodeGet(r);
+	if(bc==NULL)return 1;
+	x = relbc_load_vars(r,local,&n);
+	*res = RelationBytecodeResidualSafe(bc,x,serr);
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
+
+int RelationBytecodeCalcResidGrad(CONST struct relation *r
+		, double *res, double *grad
+){
+	double local[RELBC_LOCAL], *x;
+	unsigned long n;
+	struct RelationBytecode *bc = RelationBytecodeGet(r);
+	if(bc==NULL)return 1;
+	x = relbc_load_vars(r,local,&n);
+	*res = RelationBytecodeResidGrad(bc,x,grad,n);
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
+
+int RelationBytecodeCalcResidGradSafe(CONST struct relation *r
+		, double *res, double *grad, enum safe_err *serr
+){
+	double local[RELBC_LOCAL], *x;
+	unsigned long n;
+	struct RelationBytecode *bc = RelationBytecodeGet(r);
+	if(bc==NULL)return 1;
+	x = relbc_load_vars(r,local,&n);
+	*res = RelationBytecodeResidGradSafe(bc,x,grad,n,serr);
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
+
+int RelationBytecodeCalcHessian(CONST struct relation *r
+		, CONST unsigned long *dirs, unsigned long ndirs, double *hess
+		, enum safe_err *serr
+){
+	double local[RELBC_LOCAL], *x;
+	unsigned long n;
+	struct RelationBytecode *bc = RelationBytecodeGet(r);
+	if(bc==NULL)return 1;
+	x = relbc_load_vars(r,local,&n);
+	relbc_hessian(bc,x,dirs,ndirs,hess,serr);
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
+
+int RelationBytecodeCalcLanes(CONST struct relation **r, int n
+		, double *res, double **grad, enum safe_err *serr
+){
+	relbc_vec local[2*RELBC_LOCAL], *x, *v, *w = NULL, *g = NULL;
+	enum safe_err lerr[RELBC_LANES], *e = NULL;
+	struct RelationBytecode *bc;
+	unsigned long j, m, nv, need;
+	int k, l;
+
+	asc_assert(n >= 1 && n <= RELBC_LANES);
+	bc = RelationBytecodeGet(r[0]);
+	if(bc==NULL)return 1;
+	for(k = 1; k < n; ++k){
+		if(RelationBytecodeGet(r[k]) != bc)return 1;
+	}
+	nv = bc->nvars;
+	need = (grad == NULL) ? nv + bc->len : 2*(nv + bc->len);
+	x = (need <= 2*RELBC_LOCAL) ? local : ASC_NEW_ARRAY(relbc_vec,need);
+	v = x + nv;
+	if(grad != NULL){
+		w = v + bc->len;
+		g = w + bc->len;
+		for(j = 0; j < nv; ++j)RELBC_VSET(g[j], 0.0);
+	}
+
+	/* gather, repeating the last relation in any unused lanes */
+	for(k = 0; k < n; ++k){
+		for(j = 0; j < nv; ++j){
+			RELBC_LANE(x[j],k) = RealAtomValue((struct Instance *)gl_fetch(r[k]->vars,j+1));
+		}
+	}
+	for(l = n; l < RELBC_LANES; ++l){
+		for(j = 0; j < nv; ++j)RELBC_LANE(x[j],l) = RELBC_LANE(x[j],n-1);
+	}
+	if(serr != NULL){
+		for(l = 0; l < RELBC_LANES; ++l)lerr[l] = (l < n) ? serr[l] : safe_ok;
+		e = lerr;
+	}
+
+	relbc_forward_lanes(bc,x,v,e);
+	if(grad != NULL)relbc_reverse_lanes(bc,v,w,g,e);
+
+	for(k = 0; k < n; ++k){
+		res[k] = RELBC_LANE(v[bc->len - 1],k);
+		if(serr != NULL)serr[k] = lerr[k];
+		if(grad == NULL)continue;
+		m = gl_length(r[k]->vars);
+		for(j = 0; j < m; ++j){
+			grad[k][j] = (j < nv) ? RELBC_LANE(g[j],k) : 0.0;
+		}
+	}
+	if(x!=local)ASC_FREE(x);
+	return 0;
+}
@@ -0,0 +1,277 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Compiled ('bytecode') form of token relations.
+
+	The postfix token arrays of a TokenRelation are translated once into a
+	flat register program: instruction k stores its result in register k and
+	refers to its operands by register number, so the program can be run with
+	a simple loop instead of the recursive walkers in relation_util.c. The
+	gradient is obtained with a single reverse sweep over the same program,
+	which costs O(length) rather than O(length * number of variables).
+
+	The program is kept on the shared TokenRelation (see relation_type.h) so
+	it is built once per unique equation and reused by every relation
+	instance sharing those tokens. Variable operands refer to positions in
+	the relation's varlist, counting from 0, so a caller needs only supply
+	an array of values in varlist order.
+
+	The evaluation routines use no global or static state; they may be
+	called concurrently on the same program with different value arrays.
+
+	Relations sharing a program can also be evaluated several at once
+	(RelationBytecodeCalcLanes): each register then holds RELBC_LANES
+	values, one per relation, so that the arithmetic maps onto the SIMD
+	instructions of the target.
+
+	Unlike BinTokens (bintoken.h), no external C compiler is needed.
+*/
+
+#ifndef ASC_REL_BYTECODE_H
+#define ASC_REL_BYTECODE_H
+
+/**	@addtogroup compiler_rel Compiler Relations
+	@{
+*/
+
+#include <ascend/general/platform.h>
+#include "safe.h"
+#include "relation_type.h"
+
+/** Opaque compiled form of a token relation. */
+struct RelationBytecode;
+
+ASC_DLLSPEC struct RelationBytecode *RelationBytecodeCompile(CONST struct relation *r);
+/**<
+	Translate the postfix tokens of token relation r into a new program.
+	The result is not attached to r; see RelationBytecodeGet for that.
+
+	@return the new program, or NULL if r has no tokens on either side or
+	contains a token type that the bytecode does not support (in which case
+	callers should use the token walkers in relation_util.c instead).
+*/
+
+ASC_DLLSPEC struct RelationBytecode *RelationBytecodeGet(CONST struct relation *r);
+/**<
+	Return the program for token relation r, compiling it and storing it on
+	the shared TokenRelation the first time it is requested. Returns NULL
+	if r cannot be compiled; that outcome is remembered too, so repeated
+	calls stay cheap.
+
+	May be called from several threads at once: compilation is done under
+	a lock, and the program is published only when complete.
+*/
+
+ASC_DLLSPEC void RelationBytecodeDestroy(struct RelationBytecode *bc);
+/**<
+	Free a program. Safe to call with NULL and with the value that
+	RelationBytecodeGet stores for relations that could not be compiled.
+*/
+
+ASC_DLLSPEC void RelationBytecodeInvalidate(struct relation *r);
+/**<
+	Discard any program cached on the tokens of r. Must be called whenever
+	the token arrays or the varlist numbering of r are modified in place,
+	and not while r may be evaluated by another thread.
+*/
+
+ASC_DLLSPEC void RelationBytecodeDisable(struct relation *r);
+/**<
+	Mark r as if it could not be compiled, so that it is evaluated by the
+	token walkers of relation_util.c until RelationBytecodeInvalidate is
+	called. Used to compare the two evaluators.
+*/
+
+ASC_DLLSPEC unsigned long RelationBytecodeLength(CONST struct RelationBytecode *bc);
+/**< Number of instructions (and registers) in the program. */
+
+ASC_DLLSPEC unsigned long RelationBytecodeNumVars(CONST struct RelationBytecode *bc);
+/**<
+	One more than the highest varlist position referred to by the program,
+	ie the minimum length of the value array to be passed to the evaluators.
+*/
+
+/*------------------------------------------------------------------------------
+  EVALUATION ON ARRAYS OF VALUES
+*/
+
+ASC_DLLSPEC double RelationBytecodeResidual(CONST struct RelationBytecode *bc
+	, CONST double *x
+);
+/**<
+	Evaluate the residual (lhs - rhs) of the program.
+	@param x variable values in varlist order, counting from 0.
+*/
+
+ASC_DLLSPEC double RelationBytecodeResidGrad(CONST struct RelationBytecode *bc
+	, CONST double *x, double *grad, unsigned long nvars
+);
+/**<
+	Evaluate the residual and its gradient with respect to each variable.
+	@param x variable values in varlist order, counting from 0.
+	@param grad output array of length nvars; grad[j] receives dr/dx[j].
+	@param nvars length of grad, at least RelationBytecodeNumVars(bc).
+	@return the residual.
+*/
+
+ASC_DLLSPEC double RelationBytecodeResidualSafe(CONST struct RelationBytecode *bc
+	, CONST double *x, enum safe_err *serr
+);
+/**<
+	As RelationBytecodeResidual, but using the guarded arithmetic of safe.h.
+	*serr is set (not cleared) if an unsafe operation is encountered.
+*/
+
+ASC_DLLSPEC double RelationBytecodeResidGradSafe(CONST struct RelationBytecode *bc
+	, CONST double *x, double *grad, unsigned long nvars, enum safe_err *serr
+);
+/**<
+	As RelationBytecodeResidGrad, but using the guarded arithmetic of safe.h.
+	*serr is set (not cleared) if an unsafe operation is encountered.
+*/
+
+/*------------------------------------------------------------------------------
+  SECOND DERIVATIVES
+*/
+
+ASC_DLLSPEC unsigned long RelationBytecodeNonlinearVars(
+	CONST struct RelationBytecode *bc, unsigned char *nl
+);
+/**<
+	Structural analysis for Hessian sparsity. Sets nl[j] to 1 if variable j
+	enters the residual through a nonlinear operation, and to 0 otherwise;
+	only such variables can have nonzero second derivatives. Products and
+	quotients by constant subexpressions count as linear.
+	@param nl output array of length RelationBytecodeNumVars(bc).
+	@return the number of nonlinear variables.
+*/
+
+ASC_DLLSPEC void RelationBytecodeHessian(CONST struct RelationBytecode *bc
+	, CONST double *x, CONST unsigned long *dirs, unsigned long ndirs
+	, double *hess
+);
+/**<
+	Second derivatives of the residual with respect to a subset of the
+	variables, computed by forward-over-reverse sweeps (one per variable in
+	dirs), so the cost does not depend on the total number of variables.
+
+	@param x variable values in varlist order, counting from 0.
+	@param dirs varlist positions of the variables wanted, counting from 0.
+	@param ndirs length of dirs.
+	@param hess output, the packed lower triangle in the order of dirs:
+		hess[a*(a+1)/2 + b] = d2r/dx[dirs[a]]dx[dirs[b]] for b <= a.
+		Length ndirs*(ndirs+1)/2.
+*/
+
+ASC_DLLSPEC void RelationBytecodeHessianSafe(CONST struct RelationBytecode *bc
+	, CONST double *x, CONST unsigned long *dirs, unsigned long ndirs
+	, double *hess, enum safe_err *serr
+);
+/**<
+	As RelationBytecodeHessian, with the values and first derivatives
+	evaluated using safe.h. Non-finite second derivatives are returned as
+	zero and reported by setting *serr.
+*/
+
+/*------------------------------------------------------------------------------
+  EVALUATION OF RELATIONS
+*/
+
+ASC_DLLSPEC int RelationBytecodeCalcResidual(CONST struct relation *r, double *res);
+/**<
+	Residual of token relation r at the current values of its variables.
+	@return 0 on success, 1 if r could not be compiled.
+*/
+
+ASC_DLLSPEC int RelationBytecodeCalcResidGrad(CONST struct relation *r
+	, double *res, double *grad
+);
+/**<
+	Residual and gradient of token relation r at the current values of its
+	variables. grad must have room for NumberVariables(r) elements.
+	@return 0 on success, 1 if r could not be compiled.
+*/
+
+ASC_DLLSPEC int RelationBytecodeCalcResidualSafe(CONST struct relation *r
+	, double *res, enum safe_err *serr
+);
+/**<
+	Safe version of RelationBytecodeCalcResidual.
+	@return 0 if evaluated (check *serr for numerical trouble), 1 if r could
+	not be compiled.
+*/
+
+ASC_DLLSPEC int RelationBytecodeCalcResidGradSafe(CONST struct relation *r
+	, double *res, double *grad, enum safe_err *serr
+);
+/**<
+	Safe version of RelationBytecodeCalcResidGrad.
+	@return 0 if evaluated (check *serr for numerical trouble), 1 if r could
+	not be compiled.
+*/
+
+ASC_DLLSPEC int RelationBytecodeCalcHessian(CONST struct relation *r
+	, CONST unsigned long *dirs, unsigned long ndirs, double *hess
+	, enum safe_err *serr
+);
+/**<
+	Packed second derivatives of token relation r at the current values
+	of its variables; see RelationBytecodeHessian for dirs and hess. If
+	serr is not NULL the safe version is used.
+	@return 0 if evaluated, 1 if r could not be compiled.
+*/
+
+/*------------------------------------------------------------------------------
+  EVALUATION OF RELATIONS IN LANES
+*/
+
+/**
+	Number of relations evaluated at once by RelationBytecodeCalcLanes: 8
+	when compiling for AVX-512, else 4 (the width of AVX2 registers; two
+	SSE2 registers otherwise).
+*/
+#ifdef __AVX512F__
+# define RELBC_LANES 8
+#else
+# define RELBC_LANES 4
+#endif
+
+ASC_DLLSPEC int RelationBytecodeCalcLanes(CONST struct relation **r, int n
+	, double *res, double **grad, enum safe_err *serr
+);
+/**<
+	Residuals, and optionally gradients, of n token relations that share the
+	same program (ie the same TokenRelation), at the current values of
+	their variables. The values are gathered into one block per varlist
+	position holding a lane for each relation, and the program is run once
+	over the lanes. The results are the same as from n calls of
+	RelationBytecodeCalcResidual or RelationBytecodeCalcResidGrad (or their
+	safe versions).
+
+	@param r the relations, 1 <= n <= RELBC_LANES.
+	@param res output, n residuals.
+	@param grad NULL for residuals only, else n output arrays; grad[k] must
+		have room for NumberVariables(r[k]) elements.
+	@param serr NULL to use plain arithmetic, else n flags for the guarded
+		arithmetic of safe.h; serr[k] is set (not cleared) if an unsafe
+		operation is encountered in relation r[k].
+	@return 0 on success, 1 if r[0] could not be compiled or the relations
+		do not all share its program.
+*/
+
+/* @} */
+
+#endif /* ASC_REL_BYTECODE_H */
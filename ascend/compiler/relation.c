@@ -41,6 +41,7 @@
 #include "nameio.h"
 #include "instance_enum.h"
 #include "bintoken.h"
+#include "rel_bytecode.h"
 #include "exprs.h"
 #include "exprio.h"
 #include "value_type.h"
@@ -2071,6 +2072,7 @@ struct relation *CreateRelationStructure(enum Expr_enum relop,int copyunion)
     RTOKEN(newrelation).rhs_len = 0;
     RTOKEN(newrelation).btable = 0;
     RTOKEN(newrelation).bindex = 0;
+    RTOKEN(newrelation).bytecode = NULL;
 #else
     memset((char *)(newrelation->share),0,sizeof(union RelationUnion));
 #endif
@@ -3401,6 +3403,7 @@ void DestroyRelation(struct relation *rel, struct Instance *relinst){
       if (RTOKEN(rel).btable > 0) {
         BinTokenDeleteReference(RTOKEN(rel).btable);
       }
+      RelationBytecodeDestroy(RTOKEN(rel).bytecode);
       break;
 #if 0
     case e_opcode:
@@ -3517,6 +3520,7 @@ void DeleteAndChange(struct relation *rel,
   if (pos1 < pos2) Swap(&pos1,&pos2);
   /* pos1 > pos2 now */
   gl_delete(rel->vars,pos1,0);
+  RelationBytecodeInvalidate(rel);
   if (RTOKEN(rel).rhs) {
     ChangeTermSide(RTOKEN(rel).rhs,RTOKEN(rel).rhs_len,pos1,pos2);
   }
@@ -3559,6 +3563,9 @@ union RelationUnion *CopyRelationShareToken(union RelationUnion *ru)
   }
   result->relop = src->relop;
   result->ref_count = src->ref_count;
+  result->btable = 0;
+  result->bindex = 0;
+  result->bytecode = NULL;
 
   return (union RelationUnion *)result;
 }
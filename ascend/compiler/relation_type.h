@@ -177,6 +177,8 @@ struct SharedRelation {
   REFCOUNT_T ref_count; /**< number of instances looking here */
 };
 
+struct RelationBytecode; /* see rel_bytecode.h */
+
 /**  TokenRelations:
  *  Under NO CIRCUMSTANCES should you attempt to free any element
  *  of the infix trees. They share memory with the postfix arrays.
@@ -190,6 +192,7 @@ struct TokenRelation {
   union RelationTermUnion *lhs, *rhs;   /**< postfix arrays */
   struct relation_term *lhs_term, *rhs_term;    /**< infix trees */
   unsigned btable, bindex;  /**< indices to table and entry of machine code */
+  struct RelationBytecode *bytecode; /**< compiled form, built on first use */
 };
 
 #if 0
@@ -44,6 +44,7 @@
 #include "dimen_io.h"
 #include "instance_enum.h"
 #include "bintoken.h"
+#include "rel_bytecode.h"
 #include "find.h"
 #include "atomvalue.h"
 #include "instance_name.h"
@@ -77,8 +78,13 @@
 int g_check_dimensions_noisy = 1;
 #define GCDN g_check_dimensions_noisy
 
-/** global relation pointer to avoid passing a relation recursively */
-static struct relation *glob_rel;
+/**
+	global relation pointer to avoid passing a relation recursively.
+	This and the other evaluation globals below are per-thread, so that
+	relations may be evaluated from several threads at once (see
+	relman_eval_batch).
+*/
+static ASC_THREAD_LOCAL struct relation *glob_rel;
 
 /**
 	The following global variables are used thoughout the
@@ -87,8 +93,8 @@ static struct relation *glob_rel;
 	These should probably be located at the top of this
 	file alonge with glob_rel. [OK, let it be so then. -- JP]
 */
-static int glob_varnum;
-static int glob_done;
+static ASC_THREAD_LOCAL int glob_varnum;
+static ASC_THREAD_LOCAL int glob_done;
 
 /* some data structures...*/
 
@@ -2279,6 +2285,10 @@ RelationCalcResidualPostfixSafe(struct Instance *i, double *res){
 
   switch(reltype){
     case e_token:
+      if(!RelationBytecodeCalcResidualSafe(r,res,&status)){
+        safe_error_to_stderr(&status);
+        break;
+      }
       length_lhs = RelationLength(r, 1);
       length_rhs = RelationLength(r, 0);
 
@@ -2349,6 +2359,9 @@ RelationCalcResidualPostfix(struct Instance *i, double *res){
 
   switch(reltype){
 	case e_token:
+      if(!RelationBytecodeCalcResidual(r,res)){
+        return 0;
+      }
       length_lhs = RelationLength(r, 1);
       length_rhs = RelationLength(r, 0);
       if(length_lhs > 0){
@@ -2537,6 +2550,9 @@ int RelationCalcResidGrad(struct Instance *i, double *residual, double *gradient
   }
 
   if(reltype == e_token ){
+    if(!RelationBytecodeCalcResidGrad(r, residual, gradient)){
+      return 0;
+    }
     return RelationEvaluateResidualGradient(r, residual, gradient);
   }
 
@@ -2590,7 +2606,9 @@ enum safe_err RelationCalcResidGradSafe(struct Instance *i
     if(BinTokenCalcGradient(int btable, int bindex, double *vars,
                                 double *residual, double *gradient);
 #endif
-    RelationEvaluateResidualGradientSafe(r, residual, gradient, &not_safe);
+    if(RelationBytecodeCalcResidGradSafe(r, residual, gradient, &not_safe)){
+      RelationEvaluateResidualGradientSafe(r, residual, gradient, &not_safe);
+    }
     MSG("Relation Type: e_token");
     return not_safe;
   }
@@ -2659,7 +2677,10 @@ int RelationCalcResidGradRev(struct Instance *i, double *residual, double *gradi
 	}
 
 	if(reltype == e_token ){
-		RelationEvaluateResidualGradientRev(r, residual, gradient,0);
+		/* the compiled form also uses a reverse sweep, but without recursion */
+		if(RelationBytecodeCalcResidGrad(r, residual, gradient)){
+			RelationEvaluateResidualGradientRev(r, residual, gradient,0);
+		}
 		return 0;
 	}
 
@@ -2705,7 +2726,9 @@ enum safe_err RelationCalcResidGradRevSafe(struct Instance *i
 	}
 
 	if( reltype == e_token ) {
-		RelationEvaluateResidualGradientRevSafe(r, residual, gradient,0, &not_safe);
+		if(RelationBytecodeCalcResidGradSafe(r, residual, gradient, &not_safe)){
+			RelationEvaluateResidualGradientRevSafe(r, residual, gradient,0, &not_safe);
+		}
 		//CONSOLE_DEBUG("Relation Type: e_token");
 		return not_safe;
 	}
@@ -4296,10 +4319,11 @@ double RootFind(struct relation *rel,
 	not be freed, but the next call to this function will reuse the
 	previous allocation. Memory returned will NOT be zeroed.
 	Calling with nbytes==0 will free any memory allocated.
+	Each thread has its own buffer.
 */
 char *tmpalloc(int nbytes){
-  static char *ptr = NULL;
-  static int cap = 0;
+  static ASC_THREAD_LOCAL char *ptr = NULL;
+  static ASC_THREAD_LOCAL int cap = 0;
 
   if( nbytes > 0 ) {
     if( nbytes > cap ) {
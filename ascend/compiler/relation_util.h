@@ -444,6 +444,7 @@ extern char *tmpalloc(int nbytes);
 	not be freed, but the next call to this function will reuse the
 	previous allocation. Memory returned will NOT be zeroed.
 	Calling with nbytes==0 will free any memory allocated.
+	Each thread has its own buffer.
 */
 
 #define tmpalloc_array(nelts,type)  ((type *)tmpalloc((nelts)*sizeof(type)))
@@ -0,0 +1,428 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Per-relation evaluation profiler, see relprof.h.
+
+	Records are kept in two open-addressing tables (linear probing, deletion
+	by backward shift) keyed by the relation instance or ExternalFunc
+	pointer. Names, types and statements are only looked up when a summary
+	is requested.
+*/
+
+#include "relprof.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+
+#include "symtab.h"
+#include "functype.h"
+#include "expr_types.h"
+#include "instance_types.h"
+#include "instquery.h"
+#include "instance_io.h"
+#include "parentchild.h"
+#include "child.h"
+#include "type_desc.h"
+#include "statement.h"
+#include "module.h"
+
+int g_relprof_enabled = 0;
+
+/*------------------------------------------------------------------------------
+  TIMING
+*/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define RELPROF_TSC
+#endif
+
+/* wall-clock time in seconds, only used to calibrate the tick counter */
+static double relprof_wall(void){
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+relprof_ticks_t relprof_ticks(void){
+#if defined(RELPROF_TSC)
+	return (relprof_ticks_t)__builtin_ia32_rdtsc();
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (relprof_ticks_t)ts.tv_sec * 1000000000ULL + (relprof_ticks_t)ts.tv_nsec;
+#else
+	return (relprof_ticks_t)clock();
+#endif
+}
+
+static relprof_ticks_t relprof_ticks0;
+static double relprof_wall0;
+
+double relprof_ticks_per_second(void){
+#if defined(RELPROF_TSC)
+	double dt = relprof_wall() - relprof_wall0;
+	if(relprof_wall0 == 0 || dt < 1e-3){
+		return 1e9; /* not calibrated yet; a plausible clock rate */
+	}
+	return (double)(relprof_ticks() - relprof_ticks0) / dt;
+#elif defined(CLOCK_MONOTONIC)
+	return 1e9;
+#else
+	return CLOCKS_PER_SEC;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+  RECORD TABLES
+*/
+
+struct relprof_rec{
+	const void *key; /* NULL for an empty slot */
+	struct relprof_counts c;
+};
+
+struct relprof_table{
+	struct relprof_rec *rec;
+	unsigned long size; /* power of 2, or 0 */
+	unsigned long n;
+};
+
+static struct relprof_table relprof_rels = {NULL,0,0};
+static struct relprof_table relprof_exts = {NULL,0,0};
+
+static unsigned long relprof_hash(const void *key, unsigned long size){
+	unsigned long long h = (unsigned long long)(size_t)key;
+	h ^= h >> 4;
+	h *= 0x9E3779B97F4A7C15ULL;
+	return (unsigned long)(h >> 32) & (size - 1);
+}
+
+static void relprof_table_clear(struct relprof_table *t){
+	if(t->rec)ASC_FREE(t->rec);
+	t->rec = NULL;
+	t->size = t->n = 0;
+}
+
+static struct relprof_rec *relprof_table_find(struct relprof_table *t, const void *key){
+	unsigned long i;
+	if(t->size == 0)return NULL;
+	for(i = relprof_hash(key,t->size); t->rec[i].key != NULL; i = (i + 1) & (t->size - 1)){
+		if(t->rec[i].key == key)return &(t->rec[i]);
+	}
+	return NULL;
+}
+
+static struct relprof_rec *relprof_table_get(struct relprof_table *t, const void *key){
+	unsigned long i, j;
+	struct relprof_rec *r = relprof_table_find(t,key);
+	if(r != NULL)return r;
+
+	if(2 * (t->n + 1) > t->size){
+		struct relprof_rec *old = t->rec;
+		unsigned long oldsize = t->size;
+		t->size = oldsize ? 2 * oldsize : 1024;
+		t->rec = ASC_NEW_ARRAY_CLEAR(struct relprof_rec,t->size);
+		for(j = 0; j < oldsize; ++j){
+			if(old[j].key == NULL)continue;
+			for(i = relprof_hash(old[j].key,t->size); t->rec[i].key != NULL; i = (i + 1) & (t->size - 1));
+			t->rec[i] = old[j];
+		}
+		if(old)ASC_FREE(old);
+	}
+	for(i = relprof_hash(key,t->size); t->rec[i].key != NULL; i = (i + 1) & (t->size - 1));
+	memset(&(t->rec[i]),0,sizeof(struct relprof_rec));
+	t->rec[i].key = key;
+	t->n++;
+	return &(t->rec[i]);
+}
+
+static void relprof_table_remove(struct relprof_table *t, const void *key){
+	unsigned long i, j, h, mask;
+	struct relprof_rec *r = relprof_table_find(t,key);
+	if(r == NULL)return;
+	mask = t->size - 1;
+	i = (unsigned long)(r - t->rec);
+	/* shift back any later records of the same probe sequence */
+	for(j = (i + 1) & mask; t->rec[j].key != NULL; j = (j + 1) & mask){
+		h = relprof_hash(t->rec[j].key,t->size);
+		if(((j - h) & mask) >= ((j - i) & mask)){
+			t->rec[i] = t->rec[j];
+			i = j;
+		}
+	}
+	t->rec[i].key = NULL;
+	t->n--;
+}
+
+static void relprof_add(struct relprof_counts *c, enum relprof_op op
+		, relprof_ticks_t ticks, int failed, int fpe
+){
+	c->calls[op]++;
+	c->ticks[op] += ticks;
+	if(failed)c->fails[op]++;
+	if(fpe)c->fpes[op]++;
+}
+
+static void relprof_sum(struct relprof_counts *to, const struct relprof_counts *from){
+	int op;
+	for(op = 0; op < RELPROF_NOPS; ++op){
+		to->calls[op] += from->calls[op];
+		to->fails[op] += from->fails[op];
+		to->fpes[op] += from->fpes[op];
+		to->ticks[op] += from->ticks[op];
+	}
+}
+
+relprof_ticks_t relprof_total_ticks(const struct relprof_counts *c){
+	return c->ticks[RELPROF_RESID] + c->ticks[RELPROF_GRAD];
+}
+
+/*------------------------------------------------------------------------------
+  RECORDING
+*/
+
+void relprof_enable(int on){
+	if(on && !g_relprof_enabled){
+		relprof_ticks0 = relprof_ticks();
+		relprof_wall0 = relprof_wall();
+	}
+	g_relprof_enabled = on;
+}
+
+void relprof_reset(void){
+	relprof_table_clear(&relprof_rels);
+	relprof_table_clear(&relprof_exts);
+}
+
+void relprof_record_rel(struct Instance *rel, enum relprof_op op
+		, relprof_ticks_t ticks, int failed, int fpe
+){
+	relprof_add(&(relprof_table_get(&relprof_rels,rel)->c),op,ticks,failed,fpe);
+}
+
+void relprof_record_ext(struct ExternalFunc *efunc, enum relprof_op op
+		, relprof_ticks_t ticks, int failed
+){
+	relprof_add(&(relprof_table_get(&relprof_exts,efunc)->c),op,ticks,failed,0);
+}
+
+void relprof_forget_rel(struct Instance *rel){
+	relprof_table_remove(&relprof_rels,rel);
+}
+
+/*------------------------------------------------------------------------------
+  SUMMARIES
+*/
+
+/* is i root or a descendant of it (following first parents)? */
+static int relprof_below(CONST struct Instance *i, CONST struct Instance *root){
+	if(root == NULL)return 1;
+	while(i != NULL){
+		if(i == root)return 1;
+		i = NumberParents(i) ? InstanceParent(i,1) : NULL;
+	}
+	return 0;
+}
+
+/**
+	Find the model containing the statement that created rel, climbing out
+	of any arrays, and that statement.
+*/
+static void relprof_locate(CONST struct Instance *rel
+		, CONST struct Instance **model, CONST struct Statement **stat
+){
+	CONST struct Instance *child = rel, *p = NULL;
+	unsigned long n;
+	*model = NULL;
+	*stat = NULL;
+	while(NumberParents(child)){
+		p = InstanceParent(child,1);
+		if(!IsArrayInstance(p))break;
+		child = p;
+		p = NULL;
+	}
+	if(p == NULL)return;
+	*model = p;
+	n = ChildIndex(p,child);
+	if(n > 0){
+		*stat = ChildStatement(GetChildList(InstanceTypeDesc(p)),n);
+	}
+}
+
+static void relprof_set_source(struct relprof_entry *e, CONST struct Instance *model
+		, CONST struct Statement *stat
+){
+	e->type = model ? SCP(InstanceType(model)) : NULL;
+	e->file = (stat && StatementModule(stat)) ? Asc_ModuleBestName(StatementModule(stat)) : NULL;
+	e->line = stat ? StatementLineNum(stat) : 0;
+}
+
+static int relprof_cmp(const void *a, const void *b){
+	relprof_ticks_t ta = relprof_total_ticks(&(((const struct relprof_entry *)a)->c));
+	relprof_ticks_t tb = relprof_total_ticks(&(((const struct relprof_entry *)b)->c));
+	return (ta < tb) - (ta > tb);
+}
+
+struct relprof_entry *relprof_summary(enum relprof_entry_kind kind
+		, struct Instance *root, unsigned long *n
+){
+	struct relprof_entry *e;
+	struct relprof_table stats = {NULL,0,0}; /* statement -> index + 1, in c.calls[0] */
+	CONST struct Instance *model;
+	CONST struct Statement *stat;
+	const void *key;
+	unsigned long j, k = 0;
+	struct relprof_table *t = (kind == RELPROF_EXTFUNC) ? &relprof_exts : &relprof_rels;
+
+	e = ASC_NEW_ARRAY_CLEAR(struct relprof_entry,t->n + 1);
+	for(j = 0; j < t->size; ++j){
+		struct relprof_rec *r = &(t->rec[j]);
+		if(r->key == NULL)continue;
+		if(kind == RELPROF_EXTFUNC){
+			e[k].kind = kind;
+			e[k].name = ExternalFuncName((struct ExternalFunc *)r->key);
+			e[k].c = r->c;
+			++k;
+			continue;
+		}
+		if(!relprof_below((struct Instance *)r->key,root))continue;
+		relprof_locate((struct Instance *)r->key,&model,&stat);
+		if(kind == RELPROF_STATEMENT){
+			/* relations whose statement can't be found are lumped by type */
+			struct relprof_rec *s;
+			key = stat ? (const void *)stat : (const void *)model;
+			s = relprof_table_get(&stats,key ? key : (const void *)&stats);
+			if(s->c.calls[0] == 0){
+				s->c.calls[0] = k + 1;
+				e[k].kind = kind;
+				relprof_set_source(&(e[k]),model,stat);
+				++k;
+			}
+			e[s->c.calls[0] - 1].nrels++;
+			relprof_sum(&(e[s->c.calls[0] - 1].c),&(r->c));
+		}else{
+			e[k].kind = kind;
+			e[k].name = WriteInstanceNameString((struct Instance *)r->key,root);
+			e[k].nrels = 1;
+			relprof_set_source(&(e[k]),model,stat);
+			e[k].c = r->c;
+			++k;
+		}
+	}
+	relprof_table_clear(&stats);
+	qsort(e,k,sizeof(struct relprof_entry),relprof_cmp);
+	*n = k;
+	return e;
+}
+
+void relprof_summary_destroy(struct relprof_entry *e, unsigned long n){
+	unsigned long j;
+	if(e == NULL)return;
+	for(j = 0; j < n; ++j){
+		if(e[j].kind == RELPROF_RELATION && e[j].name != NULL){
+			ASC_FREE((char *)e[j].name);
+		}
+	}
+	ASC_FREE(e);
+}
+
+/*------------------------------------------------------------------------------
+  OUTPUT
+*/
+
+static void relprof_report_section(FILE *fp, enum relprof_entry_kind kind
+		, struct Instance *root, unsigned long nmax, double ms
+){
+	static const char *heading[] = {"STATEMENT","RELATION","EXTERNAL FUNCTION"};
+	struct relprof_entry *e;
+	unsigned long j, n;
+
+	e = relprof_summary(kind,root,&n);
+	if(nmax == 0 || nmax > n)nmax = n;
+	FPRINTF(fp,"\n%-40s %8s %10s %10s %6s %6s %10s %10s %6s %6s\n"
+		,heading[kind],"rels","resid ms","calls","fails","fpe","grad ms","calls","fails","fpe"
+	);
+	for(j = 0; j < nmax; ++j){
+		const struct relprof_counts *c = &(e[j].c);
+		if(kind == RELPROF_EXTFUNC){
+			FPRINTF(fp,"%-40s %8s",e[j].name,"");
+		}else{
+			if(kind == RELPROF_RELATION){
+				FPRINTF(fp,"%s\n  ",e[j].name);
+			}
+			FPRINTF(fp,"%-40.40s %8lu"
+				,e[j].type ? e[j].type : "?",e[j].nrels
+			);
+			if(e[j].file){
+				FPRINTF(fp,"  (%s:%lu)",e[j].file,e[j].line);
+			}
+			FPRINTF(fp,"\n%-49s","");
+		}
+		FPRINTF(fp," %10.3f %10lu %6lu %6lu %10.3f %10lu %6lu %6lu\n"
+			,c->ticks[RELPROF_RESID] * ms,c->calls[RELPROF_RESID]
+			,c->fails[RELPROF_RESID],c->fpes[RELPROF_RESID]
+			,c->ticks[RELPROF_GRAD] * ms,c->calls[RELPROF_GRAD]
+			,c->fails[RELPROF_GRAD],c->fpes[RELPROF_GRAD]
+		);
+	}
+	if(nmax < n){
+		FPRINTF(fp,"(%lu more)\n",n - nmax);
+	}
+	relprof_summary_destroy(e,n);
+}
+
+void relprof_report(FILE *fp, struct Instance *root, unsigned long nmax){
+	double ms = 1000. / relprof_ticks_per_second();
+	relprof_report_section(fp,RELPROF_STATEMENT,root,nmax,ms);
+	relprof_report_section(fp,RELPROF_RELATION,root,nmax,ms);
+	relprof_report_section(fp,RELPROF_EXTFUNC,root,nmax,ms);
+}
+
+void relprof_write_folded(FILE *fp, struct Instance *root){
+	static const char *opname[] = {"residual","gradient"};
+	unsigned long j;
+	int op, depth;
+	char *name, *s;
+
+	for(j = 0; j < relprof_rels.size; ++j){
+		struct relprof_rec *r = &(relprof_rels.rec[j]);
+		if(r->key == NULL || !relprof_below((struct Instance *)r->key,root))continue;
+		name = WriteInstanceNameString((struct Instance *)r->key,root);
+		/* path separators (outside subscripts) become frame separators */
+		for(s = name, depth = 0; *s; ++s){
+			if(*s == '[')depth++;
+			else if(*s == ']')depth--;
+			else if(*s == '.' && depth == 0)*s = ';';
+			else if(*s == ' ' || *s == ';')*s = '_';
+		}
+		for(op = 0; op < RELPROF_NOPS; ++op){
+			if(r->c.calls[op] == 0)continue;
+			if(r->c.fpes[op]){
+				FPRINTF(fp,"%s;%s(fpe=%lu) %llu\n",name,opname[op],r->c.fpes[op],r->c.ticks[op]);
+			}else{
+				FPRINTF(fp,"%s;%s %llu\n",name,opname[op],r->c.ticks[op]);
+			}
+		}
+		ASC_FREE(name);
+	}
+}
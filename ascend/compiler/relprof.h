@@ -0,0 +1,160 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Per-relation evaluation profiler.
+
+	When enabled, relman_eval and relman_diffs record, for each relation
+	instance, the number of residual and gradient evaluations, the clock
+	ticks spent in them, the number that failed with a calculation error
+	and, separately, the number that raised a floating point exception
+	(division by zero, overflow or an invalid operation, found from the
+	exception flags). Calls of blackbox external functions are likewise
+	recorded per ExternalFunc, without the exceptions.
+
+	The results can be summarised by the source statement that defines the
+	relations (with the MODEL type containing it), by relation, or by
+	external function, and written in the 'folded stacks' format read by
+	flamegraph.pl and similar tools, where the stack of each relation is its
+	path in the instance tree.
+
+	Profiling is off by default, and then costs one test per evaluation.
+	While it is on, relman does not evaluate relations on worker threads
+	(see relman_threadable), since the profile tables are not locked.
+
+	Records refer to relation instances; a relation's record is dropped
+	when the instance is destroyed.
+*/
+
+#ifndef ASC_RELPROF_H
+#define ASC_RELPROF_H
+
+/**	@addtogroup compiler_rel Compiler Relations
+	@{
+*/
+
+#include <stdio.h>
+#include <ascend/general/platform.h>
+#include "instance_enum.h"
+#include "extfunc.h"
+
+/** Clock ticks, as counted by relprof_ticks. */
+typedef unsigned long long relprof_ticks_t;
+
+enum relprof_op{
+	RELPROF_RESID = 0 /**< residual only */
+	,RELPROF_GRAD = 1 /**< gradient (and residual) */
+	,RELPROF_NOPS
+};
+
+/** Counters for one relation or external function. */
+struct relprof_counts{
+	unsigned long calls[RELPROF_NOPS];
+	unsigned long fails[RELPROF_NOPS]; /**< calculation errors */
+	unsigned long fpes[RELPROF_NOPS]; /**< floating point exceptions raised */
+	relprof_ticks_t ticks[RELPROF_NOPS];
+};
+
+ASC_DLLSPEC relprof_ticks_t relprof_total_ticks(const struct relprof_counts *c);
+/**< Ticks spent in residuals and gradients together. */
+
+ASC_DLLSPEC int g_relprof_enabled;
+/**< Nonzero while profiling; test with RELPROF_ENABLED rather than directly. */
+#define RELPROF_ENABLED (g_relprof_enabled)
+
+ASC_DLLSPEC void relprof_enable(int on);
+/**<
+	Switch profiling on or off. Switching it on does not clear the counts
+	already recorded; see relprof_reset.
+*/
+
+ASC_DLLSPEC void relprof_reset(void);
+/**< Discard all recorded counts (profiling stays on or off as it was). */
+
+ASC_DLLSPEC relprof_ticks_t relprof_ticks(void);
+/**<
+	Current value of a fast monotonic counter: the CPU timestamp counter
+	where available, else a clock in nanoseconds.
+*/
+
+ASC_DLLSPEC double relprof_ticks_per_second(void);
+/**<
+	Estimated rate of relprof_ticks, measured since profiling was enabled.
+*/
+
+ASC_DLLSPEC void relprof_record_rel(struct Instance *rel, enum relprof_op op
+		, relprof_ticks_t ticks, int failed, int fpe);
+/**<
+	Add one evaluation of relation instance rel to the profile, which
+	failed with a calculation error if failed is nonzero and raised a
+	floating point exception if fpe is nonzero.
+*/
+
+ASC_DLLSPEC void relprof_record_ext(struct ExternalFunc *efunc, enum relprof_op op
+		, relprof_ticks_t ticks, int failed);
+/**< Add one call of external function efunc to the profile. */
+
+ASC_DLLSPEC void relprof_forget_rel(struct Instance *rel);
+/**< Drop any record for rel (called as relation instances are destroyed). */
+
+/** What a relprof_entry summarises. */
+enum relprof_entry_kind{
+	RELPROF_STATEMENT /**< all the relations from one statement */
+	,RELPROF_RELATION /**< a single relation */
+	,RELPROF_EXTFUNC /**< an external function */
+};
+
+/** One line of a profile summary. */
+struct relprof_entry{
+	enum relprof_entry_kind kind;
+	const char *name; /**< relation name (relative to the root), or external function name; NULL for statements */
+	const char *type; /**< name of the MODEL type whose statement created the relation(s) */
+	const char *file; /**< source file of that statement */
+	unsigned long line; /**< line of that statement */
+	unsigned long nrels; /**< number of relations included */
+	struct relprof_counts c;
+};
+
+ASC_DLLSPEC struct relprof_entry *relprof_summary(enum relprof_entry_kind kind
+		, struct Instance *root, unsigned long *n);
+/**<
+	Summarise the profile by statement, by relation or by external function.
+	Relations not in the tree below root are left out (all relations if root
+	is NULL). Entries are sorted by decreasing total ticks.
+
+	@param n set to the number of entries returned
+	@return array of entries, to be freed with relprof_summary_destroy
+*/
+
+ASC_DLLSPEC void relprof_summary_destroy(struct relprof_entry *e, unsigned long n);
+
+ASC_DLLSPEC void relprof_report(FILE *fp, struct Instance *root, unsigned long nmax);
+/**<
+	Write a table of the nmax most expensive statements, relations and
+	external functions (all of them if nmax is 0).
+*/
+
+ASC_DLLSPEC void relprof_write_folded(FILE *fp, struct Instance *root);
+/**<
+	Write the profile of the relations below root as folded stacks, one line
+	'frame;frame;...;relation;op ticks' per relation and operation, where the
+	frames are the names of the instances between root and the relation.
+	If the operation raised floating point exceptions, their number is
+	appended to its frame, as in 'residual(fpe=3)'.
+*/
+
+/* @} */
+
+#endif /* ASC_RELPROF_H */
@@ -109,8 +109,8 @@ static double *alloc_poly(int order)
  ***  called again until the old polynominal is not needed anymore.
  **/
 {
-   static double *poly = NULL;
-   static int poly_cap = 0;
+   static ASC_THREAD_LOCAL double *poly = NULL;
+   static ASC_THREAD_LOCAL int poly_cap = 0;
 
    if( order + 1 > poly_cap ) {
       poly_cap = order+1;
@@ -546,7 +546,7 @@ double safe_sinh_D1(double x,enum safe_err *safe)
 double safe_cos_D1(double x,enum safe_err *safe)
 {
   (void)safe;
-   return( sin(x) );
+   return( dcos(x) );
 }
 
 double safe_cosh_D1(double x,enum safe_err *safe)
@@ -655,8 +655,7 @@ double safe_cbrt_D1(double x,enum safe_err *safe)
 double safe_fabs_D1(double x,enum safe_err *safe)
 {
   (void)safe;
-  (void)x;  /* stop gcc whine about unused parameter */
-  return( 1.0 );
+  return( dfabs(x) );
 }
 
 double safe_hold_D1(double x,enum safe_err *safe)
@@ -25,6 +25,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <stdarg.h>
+#include <limits.h>
 #include <ascend/general/platform.h>
 #include <ascend/general/panic.h>
 #include <ascend/general/ascMalloc.h>
@@ -107,6 +108,284 @@ void ReportSetManager(FILE *f)
 #define FREESET(set) ascfree(set)
 #endif /* SETINST_USES_POOL */
 
+
+/*
+ * Integer sets as sorted runs of consecutive integers.
+ * The runs are disjoint and never adjacent, so the representation of a
+ * given set is unique. Each run records the number of members in the
+ * runs before it, so that the n-th member is found by binary search.
+ */
+struct set_range {
+  long lo, hi;              /* lo <= hi */
+  unsigned long before;     /* number of members in the preceding runs */
+};
+
+struct set_ranges {
+  unsigned long len, cap;
+  struct set_range *r;
+};
+
+/*
+ * A ranges set with more than SR_MINFRAG runs averaging fewer than
+ * SR_FRAGRATIO members each is converted to an explicit list.
+ */
+#define SR_MINFRAG 16
+#define SR_FRAGRATIO 4
+
+#define RUNLEN(rp) ((unsigned long)(rp)->hi - (unsigned long)(rp)->lo + 1)
+/* b directly follows a */
+#define ADJACENT(a,b) ((a)!=LONG_MAX && (a)+1==(b))
+
+static
+struct set_ranges *RangesCreate(unsigned long cap)
+{
+  struct set_ranges *rs;
+  if (cap < 4) cap = 4;
+  rs = ASC_NEW(struct set_ranges);
+  rs->len = 0;
+  rs->cap = cap;
+  rs->r = ASC_NEW_ARRAY(struct set_range,cap);
+  return rs;
+}
+
+static
+void RangesDestroy(struct set_ranges *rs)
+{
+  if (rs!=NULL) {
+    ascfree(rs->r);
+    ascfree(rs);
+  }
+}
+
+static
+struct set_ranges *RangesCopy(CONST struct set_ranges *rs)
+{
+  struct set_ranges *result;
+  result = RangesCreate(rs->len);
+  memcpy(result->r,rs->r,rs->len*sizeof(struct set_range));
+  result->len = rs->len;
+  return result;
+}
+
+static
+void RangesGrow(struct set_ranges *rs, unsigned long need)
+{
+  if (need > rs->cap) {
+    rs->cap = (2*rs->cap > need) ? 2*rs->cap : need;
+    rs->r = (struct set_range *)ascrealloc(rs->r,
+                                           rs->cap*sizeof(struct set_range));
+  }
+}
+
+static
+unsigned long RangesCount(CONST struct set_ranges *rs)
+{
+  if (rs==NULL || rs->len==0) return 0;
+  return rs->r[rs->len-1].before + RUNLEN(&rs->r[rs->len-1]);
+}
+
+/* fix up the member counts of runs k and after */
+static
+void RangesRecount(struct set_ranges *rs, unsigned long k)
+{
+  unsigned long before;
+  before = (k > 0) ? rs->r[k-1].before + RUNLEN(&rs->r[k-1]) : 0;
+  for (; k < rs->len; k++) {
+    rs->r[k].before = before;
+    before += RUNLEN(&rs->r[k]);
+  }
+}
+
+/*
+ * Add lo..hi at the end of rs. lo must be no less than the lo of the
+ * last run; overlapping or adjacent runs are merged.
+ */
+static
+void RangesAppend(struct set_ranges *rs, long lo, long hi)
+{
+  struct set_range *last;
+  if (rs->len > 0) {
+    last = &rs->r[rs->len-1];
+    if (lo <= last->hi || ADJACENT(last->hi,lo)) {
+      if (hi > last->hi) last->hi = hi;
+      return;
+    }
+  }
+  RangesGrow(rs,rs->len+1);
+  rs->r[rs->len].lo = lo;
+  rs->r[rs->len].hi = hi;
+  rs->r[rs->len].before = RangesCount(rs);
+  rs->len++;
+}
+
+/* index of the first run with hi >= i, or rs->len if none */
+static
+unsigned long RangesFind(CONST struct set_ranges *rs, long i)
+{
+  unsigned long low = 0, high = rs->len, mid;
+  while (low < high) {
+    mid = low + (high-low)/2;
+    if (rs->r[mid].hi < i) low = mid+1;
+    else high = mid;
+  }
+  return low;
+}
+
+/* add lo..hi anywhere in rs, merging with the runs it overlaps or touches */
+static
+void RangesInsert(struct set_ranges *rs, long lo, long hi)
+{
+  unsigned long start, end, k;
+  start = RangesFind(rs,lo);
+  if (start > 0 && ADJACENT(rs->r[start-1].hi,lo)) start--;
+  end = start;
+  while (end < rs->len && (rs->r[end].lo <= hi || ADJACENT(hi,rs->r[end].lo))) {
+    end++;
+  }
+  if (end == start) {
+    /* no overlap: open a gap for a new run */
+    RangesGrow(rs,rs->len+1);
+    memmove(&rs->r[start+1],&rs->r[start],
+            (rs->len-start)*sizeof(struct set_range));
+    rs->len++;
+    rs->r[start].lo = lo;
+    rs->r[start].hi = hi;
+  } else {
+    /* runs start..end-1 collapse into one */
+    if (rs->r[start].lo < lo) lo = rs->r[start].lo;
+    if (rs->r[end-1].hi > hi) hi = rs->r[end-1].hi;
+    rs->r[start].lo = lo;
+    rs->r[start].hi = hi;
+    k = end - start - 1;
+    if (k > 0) {
+      memmove(&rs->r[start+1],&rs->r[end],
+              (rs->len-end)*sizeof(struct set_range));
+      rs->len -= k;
+    }
+  }
+  RangesRecount(rs,start);
+}
+
+static
+int RangesFragmented(CONST struct set_ranges *rs)
+{
+  return rs->len > SR_MINFRAG && RangesCount(rs) < SR_FRAGRATIO*rs->len;
+}
+
+static
+struct gl_list_t *RangesToList(CONST struct set_ranges *rs)
+{
+  struct gl_list_t *list;
+  unsigned long k;
+  long i;
+  list = gl_create(RangesCount(rs));
+  for (k = 0; k < rs->len; k++) {
+    for (i = rs->r[k].lo; ; i++) {
+      gl_append_ptr(list,(VOIDPTR)i);
+      if (i == rs->r[k].hi) break;
+    }
+  }
+  gl_set_sorted(list,TRUE);
+  return list;
+}
+
+/*
+ * Runs for an integer list, or NULL if the list is not strictly
+ * increasing (an ordered set) or the runs would be fragmented.
+ */
+static
+struct set_ranges *ListToRanges(CONST struct gl_list_t *list)
+{
+  struct set_ranges *rs;
+  unsigned long c,len;
+  long i, prev = 0;
+  len = gl_length(list);
+  rs = RangesCreate(0);
+  for (c = 1; c <= len; c++) {
+    i = (long)(asc_intptr_t)gl_fetch(list,c);
+    if (c > 1 && i <= prev) {
+      RangesDestroy(rs);
+      return NULL;
+    }
+    RangesAppend(rs,i,i);
+    prev = i;
+  }
+  if (RangesFragmented(rs)) {
+    RangesDestroy(rs);
+    return NULL;
+  }
+  return rs;
+}
+
+/* switch a ranges set to a list if it has become fragmented */
+static
+void SetCheckFragmented(struct set_t *set)
+{
+  if (set->ranges!=NULL && RangesFragmented(set->ranges)) {
+    set->list = RangesToList(set->ranges);
+    RangesDestroy(set->ranges);
+    set->ranges = NULL;
+  }
+}
+
+/* switch a ranges set to a list, for ordered set processing */
+static
+void SetUseList(struct set_t *set)
+{
+  if (set->ranges!=NULL) {
+    set->list = RangesToList(set->ranges);
+    RangesDestroy(set->ranges);
+    set->ranges = NULL;
+  }
+}
+
+/* switch a sorted integer list set to ranges, if they are not fragmented */
+static
+void SetTryRanges(struct set_t *set)
+{
+  struct set_ranges *rs;
+  if (set->kind==integer_set && set->list!=NULL && gl_length(set->list)>0) {
+    rs = ListToRanges(set->list);
+    if (rs!=NULL) {
+      gl_destroy(set->list);
+      set->list = NULL;
+      set->ranges = rs;
+    }
+  }
+}
+
+/* a new set of the given kind holding rs, which it takes over */
+static
+struct set_t *SetFromRanges(enum set_kind kind, struct set_ranges *rs)
+{
+  struct set_t *result;
+  MALLOCSET(result);
+  result->kind = kind;
+  result->list = NULL;
+  if (rs->len==0) {
+    RangesDestroy(rs);
+    result->ranges = NULL;
+  } else {
+    result->ranges = rs;
+    SetCheckFragmented(result);
+  }
+  return result;
+}
+
+/*
+ * The members of s as a list: s->list itself, or a new list built
+ * from the runs, which the caller must destroy, or NULL if none.
+ */
+static
+struct gl_list_t *SetMemberList(CONST struct set_t *s)
+{
+  if (s->ranges!=NULL) return RangesToList(s->ranges);
+  return s->list;
+}
+
+#define SetFreeMemberList(s,l) \
+  if ((l)!=NULL && (l)!=(s)->list) gl_destroy(l)
+
 static
 int SetIntCmp(long int i1, long int i2)
 {
@@ -128,6 +407,7 @@ struct set_t *CreateEmptySet(void)
   MALLOCSET(result);
   result->kind = empty_set;
   result->list = NULL;
+  result->ranges = NULL;
   return result;
 }
 
@@ -153,13 +433,14 @@ void InsertInteger(struct set_t *set, asc_intptr_t i){
     set->kind = integer_set;
   else if (set->kind==string_set)
     StringViolation("InsertInteger");
-  if(set->list==NULL) {
-    set->list = gl_create(5L);
-    gl_insert_sorted(set->list,(VOIDPTR)i,(CmpFunc)SetIntCmp);
-  }else{
+  if(set->list!=NULL) {
     if(gl_search(set->list,(VOIDPTR)i,(CmpFunc)SetIntCmp)==0)
       gl_insert_sorted(set->list,(VOIDPTR)i,(CmpFunc)SetIntCmp);
+    return;
   }
+  if(set->ranges==NULL) set->ranges = RangesCreate(0);
+  RangesInsert(set->ranges,(long)i,(long)i);
+  SetCheckFragmented(set);
 }
 
 
@@ -180,135 +461,270 @@ void InsertString(struct set_t *set, symchar *str){
 }
 
 
+/*
+ * Merge lower..upper into the sorted integer list of set in one pass,
+ * then go back to runs if the set is no longer fragmented.
+ */
+static
+void ListInsertRange(struct set_t *set, long lower, long upper)
+{
+  struct gl_list_t *old, *merged;
+  unsigned long c, len;
+  long i = lower, j = 0;
+  int done = 0;
+  old = set->list;
+  len = gl_length(old);
+  merged = gl_create(len + ((unsigned long)upper - (unsigned long)lower) + 1);
+  c = 1;
+  while (c <= len || !done) {
+    if (c <= len) j = (long)(asc_intptr_t)gl_fetch(old,c);
+    if (done || (c <= len && j < i)) {
+      gl_append_ptr(merged,(VOIDPTR)j);
+      c++;
+    } else {
+      if (c <= len && j == i) c++;
+      gl_append_ptr(merged,(VOIDPTR)i);
+      if (i == upper) done = 1;
+      else i++;
+    }
+  }
+  gl_set_sorted(merged,TRUE);
+  gl_destroy(old);
+  set->list = merged;
+  SetTryRanges(set);
+}
+
 void InsertIntegerRange(struct set_t *set, long int lower, long int upper)
 {
-  long i;
   assert(set&&((set->kind==integer_set)||(set->kind==empty_set)));
-  for(i=lower;i<=upper;InsertInteger(set,i++));
+  if (lower > upper) return;
+  if(set->kind==empty_set)
+    set->kind = integer_set;
+  else if (set->kind==string_set)
+    StringViolation("InsertIntegerRange");
+  if(set->list!=NULL) {
+    ListInsertRange(set,lower,upper);
+    return;
+  }
+  if(set->ranges==NULL) set->ranges = RangesCreate(0);
+  RangesInsert(set->ranges,lower,upper);
+  SetCheckFragmented(set);
 }
 
-struct set_t *SetUnion(CONST struct set_t *s1, CONST struct set_t *s2)
+static
+struct set_ranges *RangesUnion(CONST struct set_ranges *a,
+                               CONST struct set_ranges *b)
+{
+  struct set_ranges *rs;
+  CONST struct set_range *r;
+  unsigned long i=0,j=0;
+  rs = RangesCreate(a->len+b->len);
+  while ((i<a->len)||(j<b->len)) {
+    if ((j>=b->len)||((i<a->len)&&(a->r[i].lo<=b->r[j].lo)))
+      r = &a->r[i++];
+    else
+      r = &b->r[j++];
+    RangesAppend(rs,r->lo,r->hi);
+  }
+  return rs;
+}
+
+static
+struct set_ranges *RangesIntersection(CONST struct set_ranges *a,
+                                      CONST struct set_ranges *b)
+{
+  struct set_ranges *rs;
+  unsigned long i=0,j=0;
+  long lo,hi;
+  rs = RangesCreate(MYMIN(a->len,b->len));
+  while ((i<a->len)&&(j<b->len)) {
+    lo = (a->r[i].lo > b->r[j].lo) ? a->r[i].lo : b->r[j].lo;
+    hi = MYMIN(a->r[i].hi,b->r[j].hi);
+    if (lo<=hi) RangesAppend(rs,lo,hi);
+    if (a->r[i].hi < b->r[j].hi) i++;
+    else j++;
+  }
+  return rs;
+}
+
+static
+struct set_ranges *RangesDifference(CONST struct set_ranges *a,
+                                    CONST struct set_ranges *b)
+{
+  struct set_ranges *rs;
+  unsigned long i,j=0,k;
+  long cur;
+  int done;
+  rs = RangesCreate(a->len);
+  for (i=0;i<a->len;i++) {
+    cur = a->r[i].lo;
+    done = 0;
+    while ((j<b->len)&&(b->r[j].hi<cur)) j++;
+    for (k=j;(!done)&&(k<b->len)&&(b->r[k].lo<=a->r[i].hi);k++) {
+      if (b->r[k].lo > cur) RangesAppend(rs,cur,b->r[k].lo-1);
+      if (b->r[k].hi >= a->r[i].hi) done = 1;
+      else cur = b->r[k].hi+1;
+    }
+    if (!done) RangesAppend(rs,cur,a->r[i].hi);
+  }
+  return rs;
+}
+
+static
+struct set_t *ListUnion(enum set_kind kind,
+                        CONST struct gl_list_t *l1, CONST struct gl_list_t *l2)
 {
   struct set_t *result;
-  unsigned long c1,l1,c2,l2;
+  unsigned long c1,len1,c2,len2;
   int cmp;
   CmpFunc func;
-  assert(s1&&s2);
-  if (s1->kind==empty_set) return CopySet(s2);
-  if (s2->kind==empty_set) return CopySet(s1);
-  assert(s1->kind==s2->kind);
-  if (s1->list==NULL) {
-    if (s2->list==NULL) {
-      MALLOCSET(result);
-      result->kind = s1->kind;
-      result->list = NULL;
-      return result;
-    }
-    return CopySet(s2);
-  }
-  if (s2->list==NULL) return CopySet(s1);
-  /* prepare for union */
   c1=c2=1;
-  l1=gl_length(s1->list);
-  l2=gl_length(s2->list);
+  len1=gl_length(l1);
+  len2=gl_length(l2);
   MALLOCSET(result);
-  result->kind = s1->kind;
-  if ((l1==0)&&(l2==0)) {
+  result->kind = kind;
+  result->ranges = NULL;
+  if ((len1==0)&&(len2==0)) {
     result->list = NULL;
     return result;
   }
-  result->list = gl_create(l1+l2);
-  if (s1->kind == integer_set) func = (CmpFunc)SetIntCmp;
+  result->list = gl_create(len1+len2);
+  if (kind == integer_set) func = (CmpFunc)SetIntCmp;
   else func = (CmpFunc)SetStrCmp;
-  while((c1<=l1)||(c2<=l2)) {
-    if (c1>l1)
-      gl_append_ptr(result->list,gl_fetch(s2->list,c2++));
-    else if (c2>l2)
-      gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
+  while((c1<=len1)||(c2<=len2)) {
+    if (c1>len1)
+      gl_append_ptr(result->list,gl_fetch(l2,c2++));
+    else if (c2>len2)
+      gl_append_ptr(result->list,gl_fetch(l1,c1++));
     else {
-      cmp = (*func)(gl_fetch(s1->list,c1),gl_fetch(s2->list,c2));
-      if (cmp<0) gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
-      else if (cmp>0) gl_append_ptr(result->list,gl_fetch(s2->list,c2++));
+      cmp = (*func)(gl_fetch(l1,c1),gl_fetch(l2,c2));
+      if (cmp<0) gl_append_ptr(result->list,gl_fetch(l1,c1++));
+      else if (cmp>0) gl_append_ptr(result->list,gl_fetch(l2,c2++));
       else { /* equal */
-	gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
+	gl_append_ptr(result->list,gl_fetch(l1,c1++));
 	c2++;
       }
     }
   }
   gl_sort(result->list,func);
+  SetTryRanges(result);
   return result;
 }
 
-struct set_t *SetIntersection(CONST struct set_t *s1, CONST struct set_t *s2)
+struct set_t *SetUnion(CONST struct set_t *s1, CONST struct set_t *s2)
 {
   struct set_t *result;
-  unsigned long c1,l1,c2,l2;
-  int cmp;
-  CmpFunc func;
+  struct gl_list_t *l1,*l2;
   assert(s1&&s2);
-  if (s1->kind==empty_set) return CreateEmptySet();
-  if (s2->kind==empty_set) return CreateEmptySet();
+  if (s1->kind==empty_set) return CopySet(s2);
+  if (s2->kind==empty_set) return CopySet(s1);
   assert(s1->kind==s2->kind);
-  if ((s1->list==NULL)||(s2->list==NULL)){
-    MALLOCSET(result);
-    result->kind = s1->kind;
-    result->list = NULL;
-    return result;
+  if (NullSet(s1)) {
+    if (NullSet(s2)) {
+      MALLOCSET(result);
+      result->kind = s1->kind;
+      result->list = NULL;
+      result->ranges = NULL;
+      return result;
+    }
+    return CopySet(s2);
   }
-  /* prepare for intersection */
+  if (NullSet(s2)) return CopySet(s1);
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL))
+    return SetFromRanges(s1->kind,RangesUnion(s1->ranges,s2->ranges));
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
+  result = ListUnion(s1->kind,l1,l2);
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
+  return result;
+}
+
+static
+struct set_t *ListIntersection(enum set_kind kind,
+                               CONST struct gl_list_t *l1,
+                               CONST struct gl_list_t *l2)
+{
+  struct set_t *result;
+  unsigned long c1,len1,c2,len2;
+  int cmp;
+  CmpFunc func;
   c1=c2=1;
-  l1=gl_length(s1->list);
-  l2=gl_length(s2->list);
+  len1=gl_length(l1);
+  len2=gl_length(l2);
   MALLOCSET(result);
-  result->kind = s1->kind;
-  if ((l1==0)&&(l2==0)) {
+  result->kind = kind;
+  result->ranges = NULL;
+  if ((len1==0)&&(len2==0)) {
     result->list = NULL;
     return result;
   }
-  result->list = gl_create(MYMIN(l1,l2));
-  if (s1->kind == integer_set) func = (CmpFunc)SetIntCmp;
+  result->list = gl_create(MYMIN(len1,len2));
+  if (kind == integer_set) func = (CmpFunc)SetIntCmp;
   else func = (CmpFunc)SetStrCmp;
-  while((c1<=l1)&&(c2<=l2)) {
-    cmp = (*func)(gl_fetch(s1->list,c1),gl_fetch(s2->list,c2));
+  while((c1<=len1)&&(c2<=len2)) {
+    cmp = (*func)(gl_fetch(l1,c1),gl_fetch(l2,c2));
     if (cmp<0) c1++;
     else if (cmp>0) c2++;
     else { /* equal */
-      gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
+      gl_append_ptr(result->list,gl_fetch(l1,c1++));
       c2++;
     }
   }
   gl_sort(result->list,func);
+  SetTryRanges(result);
   return result;
 }
 
-struct set_t *SetDifference(CONST struct set_t *s1, CONST struct set_t *s2)
+struct set_t *SetIntersection(CONST struct set_t *s1, CONST struct set_t *s2)
 {
   struct set_t *result;
-  unsigned long c1,l1,c2,l2;
-  int cmp;
-  CmpFunc func;
+  struct gl_list_t *l1,*l2;
   assert(s1&&s2);
   if (s1->kind==empty_set) return CreateEmptySet();
-  if (s2->kind==empty_set) return CopySet(s1);
+  if (s2->kind==empty_set) return CreateEmptySet();
   assert(s1->kind==s2->kind);
-  if ((s1->list==NULL)||(s2->list==NULL)||(gl_length(s2->list)==0)||
-      (gl_length(s1->list)==0))
-    return CopySet(s1);
-  /* prepare for difference */
+  if (NullSet(s1)||NullSet(s2)){
+    MALLOCSET(result);
+    result->kind = s1->kind;
+    result->list = NULL;
+    result->ranges = NULL;
+    return result;
+  }
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL))
+    return SetFromRanges(s1->kind,RangesIntersection(s1->ranges,s2->ranges));
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
+  result = ListIntersection(s1->kind,l1,l2);
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
+  return result;
+}
+
+static
+struct set_t *ListDifference(enum set_kind kind,
+                             CONST struct gl_list_t *l1,
+                             CONST struct gl_list_t *l2)
+{
+  struct set_t *result;
+  unsigned long c1,len1,c2,len2;
+  int cmp;
+  CmpFunc func;
   c1=c2=1;
-  l1=gl_length(s1->list);
-  l2=gl_length(s2->list);
+  len1=gl_length(l1);
+  len2=gl_length(l2);
   MALLOCSET(result);
-  result->kind = s1->kind;
-  result->list = gl_create(l1);
-  if (s1->kind == integer_set) func = (CmpFunc)SetIntCmp;
+  result->kind = kind;
+  result->ranges = NULL;
+  result->list = gl_create(len1);
+  if (kind == integer_set) func = (CmpFunc)SetIntCmp;
   else func = (CmpFunc)SetStrCmp;
-  while(c1<=l1) {
-    if (c2>l2)
-      gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
+  while(c1<=len1) {
+    if (c2>len2)
+      gl_append_ptr(result->list,gl_fetch(l1,c1++));
     else {
-      cmp = (*func)(gl_fetch(s1->list,c1),gl_fetch(s2->list,c2));
-      if (cmp<0) gl_append_ptr(result->list,gl_fetch(s1->list,c1++));
+      cmp = (*func)(gl_fetch(l1,c1),gl_fetch(l2,c2));
+      if (cmp<0) gl_append_ptr(result->list,gl_fetch(l1,c1++));
       else if (cmp>0) c2++;
       else { /* equal */
 	c1++;
@@ -317,6 +733,27 @@ struct set_t *SetDifference(CONST struct set_t *s1, CONST struct set_t *s2)
     }
   }
   gl_sort(result->list,func);
+  SetTryRanges(result);
+  return result;
+}
+
+struct set_t *SetDifference(CONST struct set_t *s1, CONST struct set_t *s2)
+{
+  struct set_t *result;
+  struct gl_list_t *l1,*l2;
+  assert(s1&&s2);
+  if (s1->kind==empty_set) return CreateEmptySet();
+  if (s2->kind==empty_set) return CopySet(s1);
+  assert(s1->kind==s2->kind);
+  if (NullSet(s1)||NullSet(s2))
+    return CopySet(s1);
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL))
+    return SetFromRanges(s1->kind,RangesDifference(s1->ranges,s2->ranges));
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
+  result = ListDifference(s1->kind,l1,l2);
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
   return result;
 }
 
@@ -326,16 +763,23 @@ struct set_t *CopySet(CONST struct set_t *set)
   assert(set!=NULL);
   MALLOCSET(result);
   result->kind = set->kind;
+  result->list = NULL;
+  result->ranges = NULL;
   if (set->list!=NULL)
     result->list = gl_copy(set->list);
-  else
-    result->list = NULL;
+  else if (set->ranges!=NULL)
+    result->ranges = RangesCopy(set->ranges);
   return result;
 }
 
 int IntMember(asc_intptr_t i, CONST struct set_t *set)
 {
+  unsigned long k;
   assert(set&&((set->kind==integer_set)||(set->kind==empty_set)));
+  if (set->ranges!=NULL) {
+    k = RangesFind(set->ranges,(long)i);
+    return (k < set->ranges->len && set->ranges->r[k].lo <= (long)i);
+  }
   if (set->list==NULL) return 0;
   return (gl_search(set->list,(VOIDPTR)i,(CmpFunc)SetIntCmp)!=0);
 }
@@ -352,6 +796,8 @@ void DestroySet(struct set_t *set)
   if (set!=NULL) {
     if (set->list!=NULL) gl_destroy(set->list);
     set->list=NULL;
+    RangesDestroy(set->ranges);
+    set->ranges=NULL;
     FREESET(set);
   }
 }
@@ -360,12 +806,14 @@ void DestroySet(struct set_t *set)
 int NullSet(CONST struct set_t *s)
 {
   assert(s!=NULL);
+  if (s->ranges!=NULL) return (s->ranges->len==0);
   return (s->list==NULL)||(gl_length(s->list)==0);
 }
 
 unsigned long Cardinality(CONST struct set_t *s)
 {
   assert(s!=NULL);
+  if (s->ranges!=NULL) return RangesCount(s->ranges);
   if (s->list==NULL) return 0;
   else return gl_length(s->list);
 }
@@ -377,14 +825,36 @@ symchar *FetchStrMember(CONST struct set_t *s, unsigned long int i)
 }
 
 asc_intptr_t FetchIntMember(CONST struct set_t *s, unsigned long int i){
-  assert(s&&s->list&&(s->kind==integer_set));
-  return (asc_intptr_t)gl_fetch(s->list,i);
+  CONST struct set_ranges *rs;
+  unsigned long low,high,mid;
+  assert(s&&(s->list||s->ranges)&&(s->kind==integer_set));
+  if (s->ranges==NULL) return (asc_intptr_t)gl_fetch(s->list,i);
+  rs = s->ranges;
+  assert(i>=1 && i<=RangesCount(rs));
+  /* last run with fewer than i members before it */
+  low = 0;
+  high = rs->len-1;
+  while (low < high) {
+    mid = high - (high-low)/2;
+    if (rs->r[mid].before < i) low = mid;
+    else high = mid-1;
+  }
+  return (asc_intptr_t)(rs->r[low].lo + (long)(i - 1 - rs->r[low].before));
 }
 
 void SetIterate(struct set_t *s, void (*func) (/* ??? */))
 {
+  unsigned long k;
+  long i;
   assert(s!=NULL);
-  if (s->list!=NULL)
+  if (s->ranges!=NULL) {
+    for (k=0;k<s->ranges->len;k++) {
+      for (i=s->ranges->r[k].lo; ; i++) {
+        (*func)((VOIDPTR)i);
+        if (i==s->ranges->r[k].hi) break;
+      }
+    }
+  } else if (s->list!=NULL)
     gl_iterate(s->list,(IterateFunc)func);
 }
 
@@ -394,52 +864,66 @@ enum set_kind SetKind(CONST struct set_t *s)
   return s->kind;
 }
 
-int SetsEqual(CONST struct set_t *s1, CONST struct set_t *s2)
+static
+int ListsEqual(enum set_kind kind,
+               CONST struct gl_list_t *l1, CONST struct gl_list_t *l2)
 {
   unsigned long c,length;
-  assert(s1&&s2);
-  if (s1->kind!=s2->kind) return 0;
-  if (s1->list==NULL) {
-    if ((s2->list==NULL)||(gl_length(s2->list)==0)) return 1;
-    else return 0;
-  }
-  if (s2->list==NULL){
-    if (gl_length(s1->list)==0) return 1;
-    else return 0;
-  }
-  length = gl_length(s1->list);
-  if (length != gl_length(s2->list)) return 0;
-  if (s1->kind == integer_set) {
+  length = gl_length(l1);
+  if (length != gl_length(l2)) return 0;
+  if (kind == integer_set) {
     for(c=1;c<=length;c++) {
-      if ((asc_intptr_t)gl_fetch(s1->list,c) != (asc_intptr_t)gl_fetch(s2->list,c)) return 0;
+      if ((asc_intptr_t)gl_fetch(l1,c) != (asc_intptr_t)gl_fetch(l2,c)) return 0;
     }
   }else{
     /* symbol set */
     for(c=1;c<=length;c++) {
-      if (gl_fetch(s1->list,c) != gl_fetch(s2->list,c)) return 0;
+      if (gl_fetch(l1,c) != gl_fetch(l2,c)) return 0;
     }
   }
   return 1;
 }
 
-int Subset(CONST struct set_t *s1, CONST struct set_t *s2)
+int SetsEqual(CONST struct set_t *s1, CONST struct set_t *s2)
 {
-  asc_intptr_t c1,c2,length1,length2;
+  struct gl_list_t *l1,*l2;
+  unsigned long k;
+  int result;
   assert(s1&&s2);
-  if (s1->kind==empty_set) return 1;
-  if (s2->kind==empty_set) return 0;
   if (s1->kind!=s2->kind) return 0;
-  if ((s1->list==NULL)||(gl_length(s1->list)==0)) return 1;
-  if (s2->list==NULL) return 0;
-  length1=gl_length(s1->list);
-  length2=gl_length(s2->list);
+  if (NullSet(s1)) return NullSet(s2);
+  if (NullSet(s2)) return 0;
+  if (Cardinality(s1)!=Cardinality(s2)) return 0;
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL)) {
+    if (s1->ranges->len!=s2->ranges->len) return 0;
+    for (k=0;k<s1->ranges->len;k++) {
+      if ((s1->ranges->r[k].lo!=s2->ranges->r[k].lo)||
+          (s1->ranges->r[k].hi!=s2->ranges->r[k].hi)) return 0;
+    }
+    return 1;
+  }
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
+  result = ListsEqual(s1->kind,l1,l2);
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
+  return result;
+}
+
+static
+int ListSubset(enum set_kind kind,
+               CONST struct gl_list_t *l1, CONST struct gl_list_t *l2)
+{
+  unsigned long c1,c2,length1,length2;
+  length1=gl_length(l1);
+  length2=gl_length(l2);
   if (length1>length2) return 0;
   c1=c2=1;
-  if (s1->kind == integer_set) {
+  if (kind == integer_set) {
   long i1,i2;
     while((c1<=length1)&&(c2<=length2)) {
-      i1 = (asc_intptr_t)gl_fetch(s1->list,c1);
-      i2 = (asc_intptr_t)gl_fetch(s2->list,c2);
+      i1 = (asc_intptr_t)gl_fetch(l1,c1);
+      i2 = (asc_intptr_t)gl_fetch(l2,c2);
       if (i1 == i2) {
         c1++;
         c2++;
@@ -451,8 +935,8 @@ int Subset(CONST struct set_t *s1, CONST struct set_t *s2)
   char *str1,*str2;
   int cmp;
     while((c1<=length1)&&(c2<=length2)) {
-      str1 = gl_fetch(s1->list,c1);
-      str2 = gl_fetch(s2->list,c2);
+      str1 = gl_fetch(l1,c1);
+      str2 = gl_fetch(l2,c2);
       cmp = strcmp(str1,str2);
       if (cmp==0) {
         c1++;
@@ -465,11 +949,61 @@ int Subset(CONST struct set_t *s1, CONST struct set_t *s2)
   else return 0;
 }
 
+int Subset(CONST struct set_t *s1, CONST struct set_t *s2)
+{
+  struct gl_list_t *l1,*l2;
+  CONST struct set_ranges *a,*b;
+  unsigned long i,j;
+  int result;
+  assert(s1&&s2);
+  if (s1->kind==empty_set) return 1;
+  if (s2->kind==empty_set) return 0;
+  if (s1->kind!=s2->kind) return 0;
+  if (NullSet(s1)) return 1;
+  if (NullSet(s2)) return 0;
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL)) {
+    /* each run of s1 must lie within a single run of s2 */
+    a = s1->ranges;
+    b = s2->ranges;
+    j = 0;
+    for (i=0;i<a->len;i++) {
+      while ((j<b->len)&&(b->r[j].hi<a->r[i].lo)) j++;
+      if ((j>=b->len)||(b->r[j].lo>a->r[i].lo)||(b->r[j].hi<a->r[i].hi))
+        return 0;
+    }
+    return 1;
+  }
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
+  result = ListSubset(s1->kind,l1,l2);
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
+  return result;
+}
+
+static
+int CmpRanges(CONST struct set_ranges *a, CONST struct set_ranges *b)
+{
+  unsigned long k;
+  /* a and b have the same number of members */
+  for (k=0;k<a->len;k++) {
+    if (a->r[k].lo != b->r[k].lo) {
+      return (a->r[k].lo < b->r[k].lo) ? 1 : -1;
+    }
+    if (a->r[k].hi != b->r[k].hi) {
+      /* the next member of the set whose run ends first is the larger */
+      return (a->r[k].hi < b->r[k].hi) ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
 int CmpSetInstVal(CONST struct set_t *s1, CONST struct set_t *s2)
 {
   unsigned long c,len;
+  struct gl_list_t *l1,*l2;
   symchar *str1, *str2;
-  int cmp;
+  int cmp = 0;
   if (s1==s2) {
     return 0;
   }
@@ -488,27 +1022,39 @@ int CmpSetInstVal(CONST struct set_t *s1, CONST struct set_t *s2)
   if (SetKind(s1)!=SetKind(s2)) {
     return (SetKind(s1)==integer_set) ? 1 : -1;
   }
-  if (gl_length(s1->list) != gl_length(s2->list)) {
-    return  (gl_length(s1->list) < gl_length(s2->list)) ? 1 : -1;
+  len = Cardinality(s1);
+  if (len != Cardinality(s2)) {
+    return  (len < Cardinality(s2)) ? 1 : -1;
   }
-  len = gl_length(s1->list);
+  if ((s1->ranges!=NULL)&&(s2->ranges!=NULL)) {
+    return CmpRanges(s1->ranges,s2->ranges);
+  }
+  if (len==0) {
+    return 0;
+  }
+  l1 = SetMemberList(s1);
+  l2 = SetMemberList(s2);
   if (s1->kind == integer_set) {
     for (c = 1; c <= len; c++) {
-      if (gl_fetch(s1->list,c) != gl_fetch(s2->list,c)) {
-        return  (gl_fetch(s1->list,c) < gl_fetch(s2->list,c)) ? 1 : -1;
+      if (gl_fetch(l1,c) != gl_fetch(l2,c)) {
+        cmp = ((long)(asc_intptr_t)gl_fetch(l1,c) <
+               (long)(asc_intptr_t)gl_fetch(l2,c)) ? 1 : -1;
+        break;
       }
     }
   } else {
     for (c = 1; c <= len; c++) {
-      str1 = gl_fetch(s1->list,c);
-      str2 = gl_fetch(s2->list,c);
+      str1 = gl_fetch(l1,c);
+      str2 = gl_fetch(l2,c);
       cmp = CmpSymchar(str1,str2);
       if (cmp!=0) {
-        return cmp;
+        break;
       }
     }
   }
-  return 0;
+  SetFreeMemberList(s1,l1);
+  SetFreeMemberList(s2,l2);
+  return cmp;
 }
 
 /*********************************************************************\
@@ -523,6 +1069,7 @@ void AppendIntegerElement(struct set_t *set, asc_intptr_t i){
     set->kind = integer_set;
   else if(set->kind==string_set)
     StringViolation("InsertInteger");
+  SetUseList(set);
   if(set->list==NULL) {
     set->list = gl_create(5L);
     gl_append_ptr(set->list,(VOIDPTR)i);
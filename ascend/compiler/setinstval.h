@@ -52,10 +52,23 @@ enum set_kind {
   empty_set     /**< set with nothing in it */
 };
 
-/** Do not confuse this set with the struct Set in types.h */
+struct set_ranges;
+
+/**
+	Do not confuse this set with the struct Set in types.h
+
+	Integer sets are normally held as sorted runs of consecutive integers
+	(ranges), so that a set such as [1..n] takes constant space, membership
+	is a binary search over the runs and union, intersection and difference
+	are linear in the number of runs. A set that becomes fragmented, with few
+	members per run, is held as an explicit sorted list instead, as are
+	string sets and the ordered sets built by AppendIntegerElement.
+	At most one of list and ranges is non-NULL; both NULL is an empty set.
+*/
 struct set_t {
   enum set_kind kind;
-  struct gl_list_t *list;
+  struct gl_list_t *list;      /**< members, if held as a list */
+  struct set_ranges *ranges;   /**< integer members, if held as ranges */
 };
 
 extern void InitSetManager(void);
@@ -99,8 +112,10 @@ extern void InsertInteger(struct set_t *set, asc_intptr_t i);
 extern void InsertIntegerRange(struct set_t *set, long lower, long upper);
 /**<
  *  Insert the elements i such that i >= lower and i <= upper.  Note if
- *  lower > upper, no elements are inserted.  This will coerce an empty
- *  set type into an integer set type.
+ *  lower > upper, no elements are inserted (and the set type is left
+ *  alone).  Otherwise this will coerce an empty set type into an integer
+ *  set type.  Unless the set has become fragmented, the cost does not
+ *  depend on upper - lower.
  */
 
 extern void InsertString(struct set_t *set, symchar *str);
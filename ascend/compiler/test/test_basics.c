@@ -31,6 +31,7 @@
 #include <ascend/compiler/symtab.h>
 #include <ascend/compiler/simlist.h>
 #include <ascend/compiler/instquery.h>
+#include <ascend/compiler/instarena.h>
 #include <ascend/compiler/parentchild.h>
 #include <ascend/compiler/atomvalue.h>
 #include <ascend/compiler/childio.h>
@@ -497,6 +498,81 @@ static void test_badalias(void){
 }
 
 
+static void test_arena(void){
+
+	const char *model = "(* instances placed in the arena of the simulation *)\n\
+		DEFINITION relation\n\
+		    included IS_A boolean;\n\
+		    message	IS_A symbol;\n\
+		    included := TRUE;\n\
+		    message := 'none';\n\
+		END relation;\n\
+		MODEL cell;\n\
+			x, y IS_A real;\n\
+			e: x = 2*y;\n\
+		END cell;\n\
+		MODEL bigcell REFINES cell;\n\
+			z IS_A real;\n\
+			f: z = x + y;\n\
+		END bigcell;\n\
+		MODEL arenatest;\n\
+			c[1..50] IS_A cell;\n\
+			c[1] IS_REFINED_TO bigcell;\n\
+			c[2].x, c[3].x ARE_THE_SAME;\n\
+		END arenatest;\n";
+
+	struct InstanceArena *arena;
+	struct InstanceArenaStats stats;
+	unsigned long before;
+	int status;
+
+	Asc_CompilerInit(1);
+
+	Asc_OpenStringModule(model, &status, "");
+	CU_ASSERT_FATAL(status==0);
+
+	status = zz_parse();
+	CU_ASSERT_FATAL(status==0);
+
+	before = InstanceArenaMemInUse(NULL);
+
+	struct Instance *sim = SimsCreateInstance(AddSymbol("arenatest"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(sim!=NULL);
+
+	arena = GetSimulationArena(sim);
+#if !defined(MALLOC_DEBUG) && !defined(ASC_WITH_DMALLOC)
+	CU_ASSERT_FATAL(arena!=NULL);
+	CU_ASSERT(CurrentInstanceArena()==NULL);
+
+	InstanceArenaStatistics(arena,&stats);
+	CU_ASSERT(stats.count[INSTARENA_MODEL] >= 51);
+	CU_ASSERT(stats.count[INSTARENA_REAL_ATOM] >= 100);
+	CU_ASSERT(stats.count[INSTARENA_RELATION] >= 51);
+	CU_ASSERT(stats.count[INSTARENA_ARRAY] >= 1);
+	CU_ASSERT(stats.freed > 0); /* the merged atom and the refined model */
+	CU_ASSERT(stats.live > 0);
+	CU_ASSERT(InstanceArenaMemInUse(arena) >= stats.chunkbytes);
+	CU_ASSERT(InstanceArenaMemInUse(NULL) > before);
+#else
+	CU_ASSERT(arena==NULL);
+#endif
+
+	/* check the refined and merged instances came through intact */
+	struct Instance *root = GetSimulationRoot(sim);
+	struct Instance *c = ChildByChar(root,AddSymbol("c"));
+	CU_ASSERT_FATAL(c!=NULL);
+	struct Instance *c1 = InstanceChild(c,1);
+	CU_ASSERT_FATAL(c1!=NULL);
+	CU_ASSERT(InstanceTypeDesc(c1)==FindType(AddSymbol("bigcell")));
+	CU_ASSERT(InstanceKind(ChildByChar(c1,AddSymbol("f")))==REL_INST);
+	CU_ASSERT(ChildByChar(InstanceChild(c,2),AddSymbol("x"))
+		== ChildByChar(InstanceChild(c,3),AddSymbol("x")));
+
+	sim_destroy(sim);
+	CU_ASSERT(InstanceArenaMemInUse(NULL)==before);
+	Asc_CompilerDestroy();
+}
+
 /*===========================================================================*/
 /* Registration information */
 
@@ -515,7 +591,8 @@ static void test_badalias(void){
 	T(stoponfailedassert) \
 	T(badassign) \
 	T(type_info) \
-	T(badalias)
+	T(badalias) \
+	T(arena)
 
 REGISTER_TESTS_SIMPLE(compiler_basics, TESTS)
 
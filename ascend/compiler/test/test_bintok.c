@@ -1,6 +1,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <ascend/general/env.h>
 #include <ascend/general/ospath.h>
@@ -44,9 +47,10 @@
 #include <test/common.h>
 
 /*
-	Test solving a simple model with 'bintoken' support
+	Test solving a simple model with 'bintoken' support, optionally with
+	compiled code cached in the directory cachedir.
 */
-static void test_bintok(char *filenamestem,int usebintok){
+static void test_bintok_cache(char *filenamestem,int usebintok,const char *cachedir){
 	Asc_CompilerInit(1);
 	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
 	Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv");
@@ -71,6 +75,9 @@ static void test_bintok(char *filenamestem,int usebintok){
 	/* instantiate it */
 	if(usebintok){
 		CU_TEST(0==BinTokenSetOptionsDefault());
+		if(cachedir){
+			CU_TEST(0==BinTokenSetCache(cachedir,0));
+		}
 	}else{
 		CU_TEST(0==BinTokenClearOptions());
 	}
@@ -120,6 +127,72 @@ static void test_bintok(char *filenamestem,int usebintok){
 	Asc_CompilerDestroy();
 }
 
+static void test_bintok(char *filenamestem,int usebintok){
+	test_bintok_cache(filenamestem,usebintok,NULL);
+}
+
+/* number of files in the cache dir, and the sum of their inode numbers */
+static int cache_contents(const char *cachedir, unsigned long *inodes){
+	DIR *d = opendir(cachedir);
+	struct dirent *e;
+	struct stat st;
+	char path[PATH_MAX];
+	int n = 0;
+	*inodes = 0;
+	if(d == NULL)return 0;
+	while((e = readdir(d)) != NULL){
+		if(e->d_name[0] == '.')continue;
+		snprintf(path,PATH_MAX,"%s/%s",cachedir,e->d_name);
+		if(stat(path,&st))continue;
+		*inodes += (unsigned long)st.st_ino;
+		n++;
+	}
+	closedir(d);
+	return n;
+}
+
+static void clear_cache(const char *cachedir){
+	DIR *d = opendir(cachedir);
+	struct dirent *e;
+	char path[PATH_MAX];
+	if(d == NULL)return;
+	while((e = readdir(d)) != NULL){
+		if(e->d_name[0] == '.')continue;
+		if(snprintf(path,PATH_MAX,"%s/%s",cachedir,e->d_name) < PATH_MAX){
+			remove(path);
+		}
+	}
+	closedir(d);
+	rmdir(cachedir);
+}
+
+/*
+	The second instantiation of a model must reuse the code compiled for
+	the first, rather than building it again.
+*/
+static void test_cache(){
+	char cachedir[PATH_MAX];
+	unsigned long inodes1, inodes2;
+	int n1, n2;
+	snprintf(cachedir,PATH_MAX,"/tmp/ascend-btcache-test-%d",(int)getpid());
+
+	test_bintok_cache("test1",1,cachedir);
+	n1 = cache_contents(cachedir,&inodes1);
+	CU_TEST(n1 > 0);
+
+	test_bintok_cache("test1",1,cachedir);
+	n2 = cache_contents(cachedir,&inodes2);
+	CU_TEST(n2 == n1);
+	CU_TEST(inodes2 == inodes1);
+
+	/* another model adds its own code alongside */
+	test_bintok_cache("gradient",1,cachedir);
+	n2 = cache_contents(cachedir,&inodes2);
+	CU_TEST(n2 > n1);
+
+	clear_cache(cachedir);
+}
+
 static void test_test1(){
 	test_bintok("test1",1);
 }
@@ -146,7 +219,8 @@ static void test_gradient_nobintok(){
 	T(test1) \
 	T(nobintok) \
 	T(gradient) \
-	T(gradient_nobintok)
+	T(gradient_nobintok) \
+	T(cache)
 
 REGISTER_TESTS_SIMPLE(compiler_bintok, TESTS)
 
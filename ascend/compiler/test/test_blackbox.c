@@ -18,7 +18,9 @@
 	Unit test functions for blackbox parsing/loading/evaluating.
 */
 #include <string.h>
+#include <math.h>
 
+#include <ascend/general/config.h>
 #include <ascend/general/env.h>
 #include <ascend/general/platform.h>
 #include <ascend/utilities/ascEnvVar.h>
@@ -34,6 +36,15 @@
 #include <ascend/compiler/parentchild.h>
 #include <ascend/compiler/atomvalue.h>
 #include <ascend/compiler/pending.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/extfunc.h>
+#include <ascend/compiler/rel_blackbox.h>
+#include <ascend/general/threadpool.h>
+#ifdef ASC_HAVE_PTHREADS
+# include <pthread.h>
+# include <time.h>
+#endif
 
 #include <ascend/compiler/initialize.h>
 
@@ -218,6 +229,304 @@ static void test_pass23(void){
 }
 
 
+/*---------------------------------------------------------------------------
+  Finite-difference derivatives of blackboxes without a deriv function,
+  using the blackboxes of models/test/blackbox/fdiff.a4c, registered here.
+*/
+
+#define FD_TOL 1e-6
+
+static int fd_calls; /* calls of fdtest_value */
+static volatile int fd_parallel; /* fdpool_value was called from the pool */
+static double fd_fail_sum = HUGE_VAL; /* fdpool_value fails for larger x1+x2+x3 */
+
+static void fd_outputs(const double *x, double *y){
+	y[0] = x[0] + x[2];
+	y[1] = x[0]*x[2] + x[2];
+	y[2] = x[1];
+}
+
+static int fdtest_value(struct BBoxInterp *interp, int ninputs, int noutputs
+		, double *inputs, double *outputs, double *jacobian
+){
+	(void)interp; (void)ninputs; (void)noutputs; (void)jacobian;
+	fd_calls++;
+	fd_outputs(inputs,outputs);
+	return 0;
+}
+
+static int fdpool_value(struct BBoxInterp *interp, int ninputs, int noutputs
+		, double *inputs, double *outputs, double *jacobian
+){
+	(void)interp; (void)ninputs; (void)noutputs;
+	/* the pool passes no jacobian */
+	if(jacobian == NULL)fd_parallel = 1;
+	if(inputs[0] + inputs[1] + inputs[2] > fd_fail_sum){
+#ifdef ASC_HAVE_PTHREADS
+		/* slow, so that the worker threads get some of the calls even on
+		one processor */
+		struct timespec ts = {0, 2000000};
+		nanosleep(&ts,NULL);
+#endif
+		ERROR_REPORTER_HERE(ASC_USER_ERROR,"fdpool failed at x = (%g, %g, %g)"
+			,inputs[0],inputs[1],inputs[2]
+		);
+		return 1;
+	}
+	fd_outputs(inputs,outputs);
+	return 0;
+}
+
+static struct Instance *load_fdiff(const char *modelname){
+	int status;
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	CU_TEST(0 == CreateUserFunctionBlackBox("fdtest",DefaultExtBBoxInitFunc
+		,fdtest_value,NULL,NULL,DefaultExtBBoxFinalFunc,3,3,NULL,0.0
+	));
+	CU_TEST(0 == CreateUserFunctionBlackBox("fdpool",DefaultExtBBoxInitFunc
+		,fdpool_value,NULL,NULL,DefaultExtBBoxFinalFunc,3,3,NULL,0.0
+	));
+	CU_TEST(0 == SetBlackBoxReentrant("fdpool",1));
+	Asc_OpenModule("test/blackbox/fdiff.a4c",&status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(0 == zz_parse());
+	return SimsCreateInstance(AddSymbol(modelname), AddSymbol("sim1"), e_normal, NULL);
+}
+
+/** element i (from 1) of the array called name */
+static struct Instance *fd_elem(struct Instance *root, const char *name, unsigned long i){
+	struct Instance *a = ChildByChar(root,AddSymbol(name));
+	CU_TEST(a != NULL && NumberChildren(a) == 3);
+	if(a == NULL || NumberChildren(a) < i)return NULL;
+	return InstanceChild(a,i);
+}
+
+static void fd_set_x(struct Instance *root, double x1, double x2, double x3){
+	SetRealAtomValue(fd_elem(root,"x",1),x1,0);
+	SetRealAtomValue(fd_elem(root,"x",2),x2,0);
+	SetRealAtomValue(fd_elem(root,"x",3),x3,0);
+}
+
+/** index of the output of relation k of the blackbox */
+static int fd_output(struct Instance *root, unsigned long k){
+	struct relation *r = (struct relation *)GetInstanceRelationOnly(fd_elem(root,"bbox",k));
+	struct Instance *y = BlackBoxGetOutputVar(r);
+	int j;
+	for(j = 0; j < 3; ++j){
+		if(y == fd_elem(root,"y",j + 1))return j;
+	}
+	CU_FAIL("blackbox output not found");
+	return 0;
+}
+
+/** the outputs, from the residuals y - yhat with y = 0 */
+static void fd_residuals(struct Instance *root, double *yhat){
+	unsigned long k;
+	double resid;
+	for(k = 1; k <= 3; ++k){
+		SetRealAtomValue(fd_elem(root,"y",k),0.0,0);
+	}
+	for(k = 1; k <= 3; ++k){
+		CU_TEST(0 == RelationCalcResidual(fd_elem(root,"bbox",k),&resid));
+		yhat[fd_output(root,k)] = -resid;
+	}
+}
+
+/** dyhat/dx, from the gradients of the residuals y - yhat */
+static void fd_jacobian(struct Instance *root, double jac[3][3]){
+	struct Instance *reli;
+	struct relation *r;
+	unsigned long k, v;
+	int j, c;
+	double resid, grad[6];
+	for(k = 1; k <= 3; ++k){
+		reli = fd_elem(root,"bbox",k);
+		r = (struct relation *)GetInstanceRelationOnly(reli);
+		CU_TEST(NumberVariables(r) <= 6);
+		CU_TEST(0 == RelationCalcResidGrad(reli,&resid,grad));
+		j = fd_output(root,k);
+		for(c = 0; c < 3; ++c){
+			jac[j][c] = 0;
+			for(v = 1; v <= NumberVariables(r); ++v){
+				if(RelationVariable(r,v) == fd_elem(root,"x",c + 1))jac[j][c] = -grad[v - 1];
+			}
+		}
+	}
+}
+
+/**
+	Check the jacobian of the blackbox at x, and that it took 'calls'
+	calls of fdtest_value (unless calls < 0).
+*/
+static void fd_check(struct Instance *root, double x1, double x2, double x3, int calls){
+	double jac[3][3];
+	double expect[3][3] = {{1, 0, 1}, {x3, 0, x1 + 1}, {0, 1, 0}};
+	int n0 = fd_calls, j, c;
+	fd_set_x(root,x1,x2,x3);
+	fd_jacobian(root,jac);
+	if(calls >= 0){
+		if(fd_calls - n0 != calls)CONSOLE_DEBUG("%d calls, expected %d",fd_calls - n0,calls);
+		CU_TEST(fd_calls - n0 == calls);
+	}
+	for(j = 0; j < 3; ++j){
+		for(c = 0; c < 3; ++c){
+			CU_TEST(fabs(jac[j][c] - expect[j][c]) < FD_TOL);
+		}
+	}
+}
+
+/* by default, each input is perturbed on its own: 1 + 3 calls each time */
+static void test_fdiff(void){
+	struct Instance *sim = load_fdiff("fdiff");
+	CU_ASSERT_FATAL(sim != NULL);
+	fd_check(GetSimulationRoot(sim),0.5,0.7,0.0,4);
+	fd_check(GetSimulationRoot(sim),0.8,0.7,0.0,4);
+	fd_check(GetSimulationRoot(sim),0.9,0.6,0.0,4);
+	fd_check(GetSimulationRoot(sim),0.9,0.6,1.0,4);
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+}
+
+static void test_fdgroup(void){
+	struct Instance *sim = load_fdiff("fdiff");
+	struct Instance *root;
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+	CU_TEST(0 == SetBlackBoxGroupedFD("fdtest",1));
+	CU_TEST(1 == SetBlackBoxGroupedFD("nosuchbox",1));
+
+	/* the pattern is found one input at a time, where y2 misses x1 */
+	fd_check(root,0.5,0.7,0.0,4);
+	fd_check(root,0.8,0.7,0.0,4);
+	/* then x1 and x2 are perturbed together */
+	fd_check(root,0.9,0.6,0.0,3);
+	/* until that changes y2: the jacobian is done again one at a time */
+	fd_check(root,0.9,0.6,1.0,6);
+	fd_check(root,1.1,0.6,2.0,4);
+	/* and the pattern found again gives the same groups, now right */
+	fd_check(root,1.2,0.5,1.5,3);
+	fd_check(root,1.3,0.5,-1.0,3);
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+}
+
+/* recent points are not evaluated again, for residuals or derivatives */
+static void test_memo(void){
+	struct Instance *sim = load_fdiff("fdiff");
+	struct Instance *root;
+	double x[2][3] = {{0.5, 0.7, 0.3}, {0.8, 0.2, 1.4}};
+	double y[3], yhat[3];
+	int i, j, n0;
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+
+	for(i = 0; i < 4; ++i){
+		n0 = fd_calls;
+		fd_set_x(root,x[i%2][0],x[i%2][1],x[i%2][2]);
+		fd_residuals(root,yhat);
+		CU_TEST(fd_calls - n0 == (i < 2 ? 1 : 0));
+		fd_outputs(x[i%2],y);
+		for(j = 0; j < 3; ++j){
+			CU_TEST(fabs(yhat[j] - y[j]) < FD_TOL);
+		}
+	}
+	/* only the perturbed inputs are new */
+	fd_check(root,x[0][0],x[0][1],x[0][2],3);
+	fd_check(root,x[1][0],x[1][1],x[1][2],3);
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+}
+
+/* a reentrant blackbox gives the same derivatives from the thread pool */
+static void test_pool(void){
+	static char nthreads[] = "ASCEND_NUM_THREADS=4";
+	static char nthreads_default[] = "ASCEND_NUM_THREADS=";
+	struct Instance *sim;
+	struct Instance *root;
+
+	CU_TEST(0 == putenv(nthreads));
+	sim = load_fdiff("fdpool");
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+
+	fd_parallel = 0;
+	fd_check(root,0.5,0.7,0.0,-1);
+	fd_check(root,0.9,0.6,1.0,-1);
+	CU_TEST(0 == SetBlackBoxGroupedFD("fdpool",1));
+	fd_check(root,1.1,0.6,2.0,-1);
+	fd_check(root,1.2,0.5,0.0,-1);
+	fd_check(root,1.3,0.5,-1.0,-1);
+	fd_check(root,1.4,0.4,0.5,-1);
+#ifdef ASC_HAVE_PTHREADS
+	if(threadpool_default_size() > 1){
+		CU_TEST(fd_parallel);
+	}
+#endif
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+	CU_TEST(0 == putenv(nthreads_default));
+}
+
+static int fd_messages; /* messages from fdpool_value */
+static volatile int fd_elsewhere; /* ...that came from another thread */
+#ifdef ASC_HAVE_PTHREADS
+static pthread_t fd_caller;
+#endif
+
+static int fd_count_messages(ERROR_REPORTER_CALLBACK_ARGS){
+	(void)sev; (void)filename; (void)line; (void)funcname; (void)args;
+	if(strstr(fmt,"fdpool failed") == NULL)return 0;
+#ifdef ASC_HAVE_PTHREADS
+	if(!pthread_equal(pthread_self(),fd_caller)){
+		fd_elsewhere = 1;
+		return 0;
+	}
+#endif
+	fd_messages++;
+	return 0;
+}
+
+/*
+	calls that fail in the thread pool are only reported by the calling
+	thread: messages on the worker threads are held back, and one failed
+	call is made again to report them
+*/
+static void test_poolfail(void){
+	static char nthreads[] = "ASCEND_NUM_THREADS=4";
+	static char nthreads_default[] = "ASCEND_NUM_THREADS=";
+	struct Instance *sim;
+	struct Instance *root;
+	double resid, grad[6];
+
+	CU_TEST(0 == putenv(nthreads));
+	sim = load_fdiff("fdpool");
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+
+	/* the base point is fine, but every perturbed one fails */
+	fd_set_x(root,0.5,0.7,0.3);
+	fd_fail_sum = 1.5;
+	fd_messages = 0;
+	fd_elsewhere = 0;
+#ifdef ASC_HAVE_PTHREADS
+	fd_caller = pthread_self();
+#endif
+	error_reporter_set_callback(fd_count_messages);
+	CU_TEST(0 != RelationCalcResidGrad(fd_elem(root,"bbox",1),&resid,grad));
+	error_reporter_set_callback(NULL);
+	fd_fail_sum = HUGE_VAL;
+	CU_TEST(fd_messages >= 1);
+	CU_TEST(!fd_elsewhere);
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+	CU_TEST(0 == putenv(nthreads_default));
+}
+
 /*===========================================================================*/
 /* Registration information */
 
@@ -241,7 +550,12 @@ static void test_pass23(void){
 	T(pass14) \
 	T(pass20) \
 	T(pass22) \
-	T(pass23)
+	T(pass23) \
+	T(fdiff) \
+	T(fdgroup) \
+	T(memo) \
+	T(pool) \
+	T(poolfail)
 
 REGISTER_TESTS_SIMPLE(compiler_blackbox, TESTS)
 
@@ -34,7 +34,9 @@
 	T(qlfdid) \
 	T(func) \
 	T(notes) \
-	T(chkdim)
+	T(chkdim) \
+	T(setinstval) \
+	T(relbytecode)
 
 
 #define PROTO_TEST(NAME) PROTO(compiler,NAME)
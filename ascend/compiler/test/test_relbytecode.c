@@ -0,0 +1,263 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Unit tests for the compiled form of token relations (rel_bytecode.h),
+	comparing it with the token walkers of relation_util.c that it replaces
+	and with finite differences.
+*/
+#include <string.h>
+#include <math.h>
+
+#include <ascend/general/env.h>
+#include <ascend/general/platform.h>
+#include <ascend/utilities/ascEnvVar.h>
+#include <ascend/utilities/error.h>
+
+#include <ascend/compiler/ascCompiler.h>
+#include <ascend/compiler/module.h>
+#include <ascend/compiler/parser.h>
+#include <ascend/compiler/library.h>
+#include <ascend/compiler/symtab.h>
+#include <ascend/compiler/simlist.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/parentchild.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/rel_bytecode.h>
+#include <ascend/compiler/safe.h>
+
+#include <test/common.h>
+
+/* relative agreement expected between the two evaluators */
+#define TOL_EXACT 1e-12
+/* and with central differences */
+#define TOL_FD 1e-6
+
+/* check_rel options */
+#define NO_WALKER_GRAD 1 /**< walkers' unsafe gradient is NaN here; don't compare */
+#define NO_FD 2 /**< gradient is not the derivative (hold); don't compare */
+
+static struct Instance *load_sim(void){
+	int status;
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	Asc_OpenModule("test/compiler/relbytecode.a4c",&status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(0 == zz_parse());
+	return SimsCreateInstance(AddSymbol("relbytecode"), AddSymbol("sim1"), e_normal, NULL);
+}
+
+static void set_var(struct Instance *root, const char *name, double value){
+	struct Instance *v = ChildByChar(root,AddSymbol(name));
+	CU_ASSERT_FATAL(v != NULL);
+	SetRealAtomValue(v,value,0);
+}
+
+static void set_xyz(struct Instance *root, double x, double y, double z){
+	set_var(root,"x",x);
+	set_var(root,"y",y);
+	set_var(root,"z",z);
+}
+
+static struct Instance *get_rel(struct Instance *root, const char *name){
+	struct Instance *i = ChildByChar(root,AddSymbol(name));
+	CU_ASSERT(i != NULL);
+	return i;
+}
+
+static int close_to(double a, double b, double tol){
+	return fabs(a - b) <= tol * (1.0 + fabs(a) + fabs(b));
+}
+
+/** residual by central differences in each variable, using the walkers */
+static void fd_gradient(struct Instance *reli, CONST struct relation *r
+		, unsigned long n, double *fd
+){
+	unsigned long j;
+	struct Instance *v;
+	double x0, h, rp, rm;
+	for(j = 0; j < n; ++j){
+		v = RelationVariable(r,j+1);
+		x0 = RealAtomValue(v);
+		h = 1e-6 * (1.0 + fabs(x0));
+		SetRealAtomValue(v,x0 + h,0);
+		RelationCalcResidual(reli,&rp);
+		SetRealAtomValue(v,x0 - h,0);
+		RelationCalcResidual(reli,&rm);
+		SetRealAtomValue(v,x0,0);
+		fd[j] = (rp - rm) / (2*h);
+	}
+}
+
+/**
+	Compare the compiled and token-walker evaluations of relation 'name'
+	through the public RelationCalc* routines, plain and safe. The
+	gradient from the compiled form is also checked against finite
+	differences, subject to 'opts'.
+*/
+static void check_rel(struct Instance *root, const char *name, int opts){
+	struct Instance *reli = get_rel(root,name);
+	struct relation *r;
+	struct RelationBytecode *bc;
+	unsigned long n, j;
+	double rb, rbs, rp, rps, rd, tmp;
+	double gb[8], gbs[8], gp[8], gps[8], fd[8], x[8];
+	enum safe_err sb, sp;
+
+	CU_ASSERT_FATAL(reli != NULL);
+	r = (struct relation *)GetInstanceRelationOnly(reli);
+	CU_ASSERT_FATAL(r != NULL);
+	n = NumberVariables(r);
+	CU_ASSERT_FATAL(n > 0 && n <= 8);
+
+	/* compiled */
+	bc = RelationBytecodeGet(r);
+	CU_ASSERT_FATAL(bc != NULL);
+	CU_TEST(RelationBytecodeNumVars(bc) <= n);
+	CU_TEST(0 == RelationCalcResidGrad(reli,&rb,gb));
+	sb = RelationCalcResidGradSafe(reli,&rbs,gbs);
+	CU_TEST(sb == safe_ok);
+	CU_TEST(close_to(rb,rbs,TOL_EXACT));
+
+	/* the array interface gives the same */
+	for(j = 0; j < n; ++j)x[j] = RealAtomValue(RelationVariable(r,j+1));
+	CU_TEST(close_to(RelationBytecodeResidual(bc,x),rb,TOL_EXACT));
+
+	fd_gradient(reli,r,n,fd);
+	for(j = 0; j < n; ++j){
+		CU_TEST(close_to(gb[j],gbs[j],TOL_EXACT));
+		if(opts & NO_FD)continue;
+		if(!close_to(gb[j],fd[j],TOL_FD)){
+			CONSOLE_DEBUG("%s: var %lu: grad %g, finite difference %g",name,j+1,gb[j],fd[j]);
+		}
+		CU_TEST(close_to(gb[j],fd[j],TOL_FD));
+	}
+
+	/* token walkers: the fallback for a relation that does not compile */
+	RelationBytecodeDisable(r);
+	CU_TEST(RelationBytecodeGet(r) == NULL);
+	CU_TEST(1 == RelationBytecodeCalcResidual(r,&tmp));
+	CU_TEST(1 == RelationBytecodeCalcResidGrad(r,&tmp,gp));
+
+	CU_TEST(0 == RelationCalcResidual(reli,&rp));
+	CU_TEST(safe_ok == RelationCalcResidualSafe(reli,&rps));
+	CU_TEST(0 == RelationCalcResidGrad(reli,&rd,gp));
+	sp = RelationCalcResidGradSafe(reli,&rps,gps);
+	CU_TEST(sp == sb);
+	CU_TEST(close_to(rb,rp,TOL_EXACT));
+	CU_TEST(close_to(rb,rd,TOL_EXACT));
+	CU_TEST(close_to(rbs,rps,TOL_EXACT));
+	for(j = 0; j < n; ++j){
+		if(!(opts & NO_WALKER_GRAD)){
+			CU_TEST(close_to(gb[j],gp[j],TOL_EXACT));
+		}
+		CU_TEST(close_to(gbs[j],gps[j],TOL_EXACT));
+	}
+
+	/* and back again */
+	RelationBytecodeInvalidate(r);
+	CU_TEST(RelationBytecodeGet(r) != NULL);
+	CU_TEST(0 == RelationCalcResidGrad(reli,&rd,gp));
+	CU_TEST(close_to(rb,rd,TOL_EXACT));
+}
+
+static void test_compare(void){
+	struct Instance *sim = load_sim();
+	struct Instance *root;
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+
+	set_xyz(root,0.3,-1.7,1.2);
+
+	/*
+		Powers of the negative y: the unsafe walkers include the ln(y) term
+		of the constant exponent and give NaN; the compiled form does not.
+	*/
+	check_rel(root,"r_ipow",NO_WALKER_GRAD);
+	check_rel(root,"r_negpow",NO_WALKER_GRAD);
+
+	check_rel(root,"r_varpow",0);
+	check_rel(root,"r_div",0);
+	check_rel(root,"r_neg",0);
+	check_rel(root,"r_f1",0);
+	check_rel(root,"r_f2",0);
+	check_rel(root,"r_f3",0);
+	check_rel(root,"r_f4",0);
+	check_rel(root,"r_f5",0);
+	check_rel(root,"r_f6",0);
+	check_rel(root,"r_f7",0);
+	check_rel(root,"r_hold",NO_FD);
+	check_rel(root,"r_sing",0);
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+}
+
+/**
+	Safe evaluation must report the same error from both evaluators, and
+	plain evaluation must give the same non-finite values.
+*/
+static void check_unsafe(struct Instance *root, const char *name, enum safe_err expect){
+	struct Instance *reli = get_rel(root,name);
+	struct relation *r;
+	double rb, rp, gb[8], gp[8];
+	enum safe_err sb, sp;
+
+	CU_ASSERT_FATAL(reli != NULL);
+	r = (struct relation *)GetInstanceRelationOnly(reli);
+	RelationBytecodeInvalidate(r);
+
+	sb = RelationCalcResidGradSafe(reli,&rb,gb);
+	CU_TEST(sb == expect);
+	CU_TEST(RelationCalcResidualSafe(reli,&rb) == expect);
+
+	RelationBytecodeDisable(r);
+	sp = RelationCalcResidGradSafe(reli,&rp,gp);
+	CU_TEST(sp == sb);
+	CU_TEST(RelationCalcResidualSafe(reli,&rp) == expect);
+	CU_TEST(close_to(rb,rp,TOL_EXACT));
+
+	RelationCalcResidual(reli,&rp);
+	RelationBytecodeInvalidate(r);
+	RelationCalcResidual(reli,&rb);
+	CU_TEST(isfinite(rb) == isfinite(rp));
+}
+
+static void test_safe(void){
+	struct Instance *sim = load_sim();
+	struct Instance *root;
+	CU_ASSERT_FATAL(sim != NULL);
+	root = GetSimulationRoot(sim);
+
+	/* 1/(x - 0.5) */
+	set_xyz(root,0.5,-1.7,1.2);
+	check_unsafe(root,"r_sing",safe_div_by_zero);
+
+	/* ln(z) */
+	set_xyz(root,0.3,-1.7,-1.0);
+	check_unsafe(root,"r_sing",safe_range_error);
+
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+}
+
+#define TESTS(T) \
+	T(compare) \
+	T(safe)
+
+REGISTER_TESTS_SIMPLE(compiler_relbytecode, TESTS)
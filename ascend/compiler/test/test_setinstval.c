@@ -0,0 +1,273 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Unit tests for set instance values, in particular integer sets held as
+	runs of consecutive integers.
+*/
+#include <limits.h>
+#include <time.h>
+
+#include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/compiler/ascCompiler.h>
+#include <ascend/compiler/setinstval.h>
+#include <ascend/utilities/error.h>
+
+#include <test/common.h>
+
+//#define TEST_SETINSTVAL_DEBUG
+#ifdef TEST_SETINSTVAL_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+/* members are drawn from LO..LO+N-1 */
+#define LO (-40)
+#define N 120
+
+/* check that set s has exactly the members flagged in m */
+static int set_matches(CONST struct set_t *s, CONST char *m){
+	unsigned long card = 0, c;
+	long i, prev = LONG_MIN;
+	for(i = 0; i < N; ++i){
+		if(m[i]){
+			card++;
+			if(!IntMember(LO + i, s))return 0;
+		}else{
+			if(IntMember(LO + i, s))return 0;
+		}
+	}
+	if(IntMember(LO - 1, s) || IntMember(LO + N, s))return 0;
+	if(Cardinality(s) != card)return 0;
+	/* members in increasing order */
+	for(c = 1; c <= card; ++c){
+		i = (long)FetchIntMember(s, c);
+		if(i <= prev || !m[i - LO])return 0;
+		prev = i;
+	}
+	return 1;
+}
+
+/* pseudo-random set with runs of varying length, built by single inserts
+	and by ranges, mirrored in the flags m */
+static struct set_t *random_set(unsigned *seed, char *m){
+	struct set_t *s = CreateEmptySet();
+	int k, nruns, len, i, start;
+	memset(m, 0, N);
+	*seed = *seed * 1103515245u + 12345u;
+	nruns = (*seed >> 16) % 12;
+	for(k = 0; k < nruns; ++k){
+		*seed = *seed * 1103515245u + 12345u;
+		start = (*seed >> 16) % N;
+		*seed = *seed * 1103515245u + 12345u;
+		len = 1 + (*seed >> 16) % (k % 2 ? 3 : 25);
+		if(start + len > N)len = N - start;
+		if(len == 1){
+			InsertInteger(s, (asc_intptr_t)(LO + start));
+		}else{
+			InsertIntegerRange(s, LO + start, LO + start + len - 1);
+		}
+		for(i = start; i < start + len; ++i)m[i] = 1;
+	}
+	return s;
+}
+
+static void test_ranges(void){
+	struct set_t *s, *t;
+	Asc_CompilerInit(0);
+
+	s = CreateEmptySet();
+	InsertIntegerRange(s, 5, 4);
+	CU_TEST(SetKind(s) == empty_set);
+	CU_TEST(NullSet(s));
+
+	InsertIntegerRange(s, 1, 1000000);
+	CU_TEST(SetKind(s) == integer_set);
+	CU_TEST(Cardinality(s) == 1000000);
+	CU_TEST(IntMember(1, s) && IntMember(1000000, s) && IntMember(500000, s));
+	CU_TEST(!IntMember(0, s) && !IntMember(1000001, s));
+	CU_TEST(FetchIntMember(s, 1) == 1);
+	CU_TEST(FetchIntMember(s, 777777) == 777777);
+
+	/* overlapping and adjacent inserts merge */
+	InsertIntegerRange(s, 1000001, 1000010);
+	InsertInteger(s, 0);
+	InsertIntegerRange(s, 20, 30);
+	CU_TEST(Cardinality(s) == 1000011);
+	CU_TEST(FetchIntMember(s, 1) == 0);
+	CU_TEST(FetchIntMember(s, 1000011) == 1000010);
+
+	/* copy and compare */
+	t = CopySet(s);
+	CU_TEST(SetsEqual(s, t));
+	CU_TEST(CmpSetInstVal(s, t) == 0);
+	CU_TEST(Subset(t, s) && Subset(s, t));
+	DestroySet(t);
+
+	/* extremes */
+	t = CreateEmptySet();
+	InsertIntegerRange(t, LONG_MAX - 2, LONG_MAX);
+	InsertIntegerRange(t, LONG_MIN, LONG_MIN + 1);
+	CU_TEST(Cardinality(t) == 5);
+	CU_TEST((long)FetchIntMember(t, 5) == LONG_MAX);
+	CU_TEST((long)FetchIntMember(t, 1) == LONG_MIN);
+	CU_TEST(IntMember((asc_intptr_t)LONG_MAX, t));
+	DestroySet(t);
+
+	DestroySet(s);
+	Asc_CompilerDestroy();
+}
+
+static void test_operations(void){
+	char m1[N], m2[N], m[N];
+	struct set_t *s1, *s2, *s, *e;
+	unsigned seed = 12345;
+	int trial, i;
+	Asc_CompilerInit(0);
+
+	for(trial = 0; trial < 400; ++trial){
+		s1 = random_set(&seed, m1);
+		s2 = random_set(&seed, m2);
+		CU_TEST(set_matches(s1, m1));
+		CU_TEST(set_matches(s2, m2));
+
+		s = SetUnion(s1, s2);
+		for(i = 0; i < N; ++i)m[i] = m1[i] || m2[i];
+		CU_TEST(set_matches(s, m));
+		CU_TEST(Subset(s1, s) && Subset(s2, s));
+		DestroySet(s);
+
+		s = SetIntersection(s1, s2);
+		for(i = 0; i < N; ++i)m[i] = m1[i] && m2[i];
+		CU_TEST(set_matches(s, m));
+		CU_TEST(Subset(s, s1) && Subset(s, s2));
+		DestroySet(s);
+
+		s = SetDifference(s1, s2);
+		for(i = 0; i < N; ++i)m[i] = m1[i] && !m2[i];
+		CU_TEST(set_matches(s, m));
+		DestroySet(s);
+
+		CU_TEST(SetsEqual(s1, s2) == !memcmp(m1, m2, N));
+		if(!NullSet(s1) && !NullSet(s2)){
+			CU_TEST(CmpSetInstVal(s1, s2) == -CmpSetInstVal(s2, s1));
+		}
+
+		/* the same members held as a list compare the same way */
+		e = CreateEmptySet();
+		for(i = 0; i < N; ++i){
+			if(m1[i])AppendIntegerElement(e, LO + i);
+		}
+		if(!NullSet(s1)){
+			CU_TEST(SetsEqual(e, s1));
+			CU_TEST(CmpSetInstVal(e, s2) == CmpSetInstVal(s1, s2));
+			CU_TEST(Subset(e, s1) && Subset(s1, e));
+		}
+		DestroySet(e);
+
+		DestroySet(s1);
+		DestroySet(s2);
+	}
+	Asc_CompilerDestroy();
+}
+
+static void test_fragmented(void){
+	char m[N];
+	struct set_t *s, *t;
+	long i;
+	Asc_CompilerInit(0);
+
+	/* every other integer: held as a list, but behaves the same */
+	s = CreateEmptySet();
+	memset(m, 0, N);
+	for(i = N - 2; i >= 0; i -= 2){
+		InsertInteger(s, LO + i);
+		m[i] = 1;
+	}
+	CU_TEST(set_matches(s, m));
+
+	/* filling in the gaps */
+	t = CreateEmptySet();
+	InsertIntegerRange(t, LO, LO + N - 1);
+	CU_TEST(Subset(s, t) && !Subset(t, s));
+	InsertIntegerRange(s, LO, LO + N - 1);
+	CU_TEST(SetsEqual(s, t));
+	CU_TEST(CmpSetInstVal(s, t) == 0);
+
+	DestroySet(s);
+	DestroySet(t);
+	Asc_CompilerDestroy();
+}
+
+static void test_timing(void){
+	struct set_t *s, *t, *u;
+	clock_t c0, c1;
+	long i, n = 1000000;
+	Asc_CompilerInit(0);
+
+	/* building [1..n] one member at a time, as for an array's index set,
+	then the usual operations, must all be quick */
+	c0 = clock();
+	s = CreateEmptySet();
+	for(i = 1; i <= n; ++i)InsertInteger(s, i);
+	t = CreateEmptySet();
+	InsertIntegerRange(t, n/2, 2*n);
+	u = SetUnion(s, t);
+	CU_TEST(Cardinality(u) == 2*n);
+	DestroySet(u);
+	u = SetIntersection(s, t);
+	CU_TEST(Cardinality(u) == n - n/2 + 1);
+	DestroySet(u);
+	u = SetDifference(s, t);
+	CU_TEST(Cardinality(u) == n/2 - 1);
+	DestroySet(u);
+	for(i = 1; i <= n; ++i){
+		if(!IntMember(i, s))break;
+	}
+	CU_TEST(i == n + 1);
+	DestroySet(t);
+
+	/* a range into a fragmented set (a list) is merged in one pass */
+	t = CreateEmptySet();
+	for(i = 2; i <= n; i += 2)AppendIntegerElement(t, i);
+	InsertIntegerRange(t, n/2, n + n/2);
+	CU_TEST(Cardinality(t) == n/4 + n);
+	CU_TEST(FetchIntMember(t, 1) == 2);
+	CU_TEST(FetchIntMember(t, n/4) == n/2);
+	CU_TEST(FetchIntMember(t, n/4 + n) == n + n/2);
+	c1 = clock();
+	MSG("%ld-member set operations: %.3f s", n, (double)(c1 - c0)/CLOCKS_PER_SEC);
+	CU_TEST((double)(c1 - c0)/CLOCKS_PER_SEC < 1.0);
+
+	DestroySet(s);
+	DestroySet(t);
+	Asc_CompilerDestroy();
+}
+
+/*===========================================================================*/
+/* Registration information */
+
+/* the list of tests */
+
+#define TESTS(T) \
+	T(ranges) \
+	T(operations) \
+	T(fragmented) \
+	T(timing)
+
+REGISTER_TESTS_SIMPLE(compiler_setinstval, TESTS)
@@ -26,6 +26,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <math.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <ascend/general/platform.h>
 #include <ascend/general/ascMalloc.h>
@@ -175,6 +176,7 @@ struct value_t CreateSetFromList(struct value_t value)
   struct set_t *sptr,*tmp;
   struct gl_list_t *list;
   unsigned long c,len;
+  long lo,hi;
   IVAL(result);
   if (value.t == error_value) return value;
   result.t = set_value;
@@ -195,7 +197,15 @@ struct value_t CreateSetFromList(struct value_t value)
 	    DestroySet(sptr);
 	    return result;
 	  }
-	  InsertInteger(sptr,vptr->u.i);
+	  /* insert runs of consecutive integers, eg from a range 1..n, whole */
+	  lo = hi = vptr->u.i;
+	  while ((c<len)&&(hi!=LONG_MAX)){
+	    vptr = (struct value_t *)gl_fetch(list,c+1);
+	    if ((vptr->t!=integer_value)||(vptr->u.i!=hi+1)) break;
+	    hi++;
+	    c++;
+	  }
+	  InsertIntegerRange(sptr,lo,hi);
 	  break;
 	case symbol_value:
 	  if (SetKind(sptr)==integer_set){
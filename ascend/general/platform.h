@@ -168,6 +168,21 @@
 # define NORETURN /* nothing */
 #endif
 
+/**
+	Define 'ASC_THREAD_LOCAL' as the storage-class qualifier that gives
+	each thread its own copy of a static variable. Where the compiler
+	offers no such thing it is empty, and the variable is shared as before.
+*/
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+# define ASC_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+# define ASC_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+# define ASC_THREAD_LOCAL __declspec(thread)
+#else
+# define ASC_THREAD_LOCAL /* nothing */
+#endif
+
 /*
  *  Make certain we have proper limits defined
  */
@@ -33,31 +33,213 @@
 #include "hashpjw.h"
 #include "table.h"
 
+/*
+ * Entries are kept in a contiguous array in the order they were added,
+ * which is also the order of TableApplyAll. Removed entries leave a hole
+ * (id == NULL) until the array is compacted.
+ *
+ * The index is an open-addressed (linear probing) array of slots, each
+ * holding the full hash of its entry, so that most mismatches are
+ * rejected without a strcmp. Its capacity is a power of two, kept below
+ * TABLE_MAXLOAD.
+ *
+ * When the index fills up, a new one of twice the size is allocated and
+ * the entries are moved across TABLE_MIGRATE at a time, on each
+ * subsequent add or lookup, so that no single call pays for rehashing
+ * the whole table. Until that is done both indexes are searched.
+ */
+
 struct TableEntry {
-  char *id;                 /* id string used to hash entry */
+  char *id;                 /* id string used to hash entry, NULL if removed */
   void *data;               /* the actual data */
-  struct TableEntry *next;  /* pointer to next entry in linked list */
+  unsigned long hash;       /* full hash of id */
 };
 
+struct TableSlot {
+  unsigned long hash;       /* full hash of the entry */
+  unsigned long entry;      /* entry number + 1, or SLOT_EMPTY, SLOT_DELETED */
+};
+
+#define SLOT_EMPTY 0UL
+#define SLOT_DELETED (~0UL)
+
+struct TableIndex {
+  unsigned long mask;       /* capacity - 1 */
+  unsigned long used;       /* slots not empty, including deleted ones */
+  struct TableSlot *slots;
+};
 
 struct Table {
-  unsigned long hashsize;       /* number of buckets */
+  unsigned long hashsize;       /* size requested at creation */
   unsigned long size;           /* the current number of entries */
-  struct TableEntry **buckets;  /* the actual buckets */
-  struct TableEntry *lastfind;  /* a cached pointer into the last thing found */
+  struct TableEntry *entries;   /* entries, in the order added */
+  unsigned long nentries;       /* entries used, including removed ones */
+  unsigned long capentries;     /* entries allocated */
+  struct TableIndex index;      /* index of the entries */
+  struct TableIndex old;        /* index being migrated from, if slots!=NULL */
+  unsigned long moved;          /* entries before this are in index */
+  unsigned long moveend;        /* entries from here on are in index too */
+  unsigned long lastfind;       /* entry number + 1 of the last thing found */
 };
 
+#define TABLE_MINSLOTS 8
+/* grow the index when more than 3/4 full */
+#define TABLE_MAXLOAD(cap) ((cap) - ((cap)>>2))
+/* entries moved to the new index per call while growing */
+#define TABLE_MIGRATE 16
+
+static unsigned long TableHash(CONST char *id)
+{
+  unsigned long h;
+  /* hashpjw leaves the low bits to the last few characters; mix them up,
+     as we use the low bits to index */
+  h = hashpjw(id,ULONG_MAX);
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return h;
+}
+
+static void IndexCreate(struct TableIndex *index, unsigned long cap)
+{
+  index->mask = cap - 1;
+  index->used = 0;
+  index->slots = ASC_NEW_ARRAY_CLEAR(struct TableSlot,cap);
+}
+
+static void IndexDestroy(struct TableIndex *index)
+{
+  if (index->slots != NULL) {
+    ascfree((char *)index->slots);
+    index->slots = NULL;
+  }
+}
+
+/* smallest power of two capacity holding n entries within the load limit */
+static unsigned long IndexCapacity(unsigned long n)
+{
+  unsigned long cap = TABLE_MINSLOTS;
+  while (TABLE_MAXLOAD(cap) < n) cap <<= 1;
+  return cap;
+}
+
+/* add entry e (number, not + 1), known not to be in the index */
+static void IndexInsert(struct TableIndex *index, unsigned long hash,
+                        unsigned long e)
+{
+  unsigned long c;
+  c = hash & index->mask;
+  while (index->slots[c].entry != SLOT_EMPTY) {
+    c = (c + 1) & index->mask;
+  }
+  index->slots[c].hash = hash;
+  index->slots[c].entry = e + 1;
+  index->used++;
+}
+
+/* slot number holding id, or -1 */
+static long IndexFind(CONST struct Table *table, CONST struct TableIndex *index,
+                      unsigned long hash, CONST char *id)
+{
+  unsigned long c, e;
+  c = hash & index->mask;
+  while ((e = index->slots[c].entry) != SLOT_EMPTY) {
+    if (e != SLOT_DELETED && index->slots[c].hash == hash) {
+      e--;
+      if (table->entries[e].id != NULL && strcmp(id,table->entries[e].id)==0) {
+        return (long)c;
+      }
+    }
+    c = (c + 1) & index->mask;
+  }
+  return -1;
+}
+
+/* move up to n entries from the old index into the new one */
+static void TableMigrate(struct Table *table, unsigned long n)
+{
+  struct TableEntry *ptr;
+  if (table->old.slots == NULL) return;
+  for (; n > 0 && table->moved < table->moveend; table->moved++) {
+    ptr = &table->entries[table->moved];
+    if (ptr->id != NULL) {
+      IndexInsert(&table->index,ptr->hash,table->moved);
+      n--;
+    }
+  }
+  if (table->moved == table->moveend) {
+    IndexDestroy(&table->old);
+  }
+}
+
+/*
+ * Remove the holes left in the entries by RemoveTableData and rebuild
+ * the index in one go. Only done once there are at least as many holes
+ * as entries, so the cost is covered by the removals.
+ */
+static void TableCompact(struct Table *table)
+{
+  unsigned long c, n = 0;
+  TableMigrate(table,ULONG_MAX);
+  for (c = 0; c < table->nentries; c++) {
+    if (table->entries[c].id != NULL) {
+      if (table->lastfind == c + 1) table->lastfind = n + 1;
+      table->entries[n++] = table->entries[c];
+    }
+  }
+  table->nentries = n;
+  IndexDestroy(&table->index);
+  IndexCreate(&table->index,IndexCapacity(n + 1));
+  for (c = 0; c < n; c++) {
+    IndexInsert(&table->index,table->entries[c].hash,c);
+  }
+  table->moved = table->moveend = n;
+}
+
+/* make room in the index for one more entry */
+static void TableGrow(struct Table *table)
+{
+  if (table->index.used + 1 <= TABLE_MAXLOAD(table->index.mask + 1)) return;
+  if (table->nentries >= 2 * table->size + TABLE_MINSLOTS) {
+    /* mostly holes */
+    TableCompact(table);
+    return;
+  }
+  /* a previous migration must be finished first */
+  TableMigrate(table,ULONG_MAX);
+  table->old = table->index;
+  IndexCreate(&table->index,IndexCapacity(2 * (table->size + 1)));
+  table->moved = 0;
+  table->moveend = table->nentries;
+  TableMigrate(table,TABLE_MIGRATE);
+}
+
+/* entry number of id, or -1 */
+static long TableFind(struct Table *table, unsigned long hash, CONST char *id)
+{
+  long c;
+  c = IndexFind(table,&table->index,hash,id);
+  if (c >= 0) return (long)table->index.slots[c].entry - 1;
+  if (table->old.slots != NULL) {
+    c = IndexFind(table,&table->old,hash,id);
+    if (c >= 0) return (long)table->old.slots[c].entry - 1;
+  }
+  return -1;
+}
 
 struct Table *CreateTable(unsigned long hashsize)
 {
   struct Table *result;
-  struct TableEntry **buckets;
   result = ASC_NEW(struct Table);
-  buckets = ASC_NEW_ARRAY_CLEAR(struct TableEntry *,hashsize);
-  result->buckets = buckets;
-  result->size = 0;
   result->hashsize = hashsize;
-  result->lastfind = NULL;
+  result->size = 0;
+  result->capentries = (hashsize > TABLE_MINSLOTS) ? hashsize : TABLE_MINSLOTS;
+  result->entries = ASC_NEW_ARRAY(struct TableEntry,result->capentries);
+  result->nentries = 0;
+  IndexCreate(&result->index,IndexCapacity(hashsize));
+  result->old.slots = NULL;
+  result->moved = result->moveend = 0;
+  result->lastfind = 0;
   return result;
 }
 
@@ -69,98 +251,91 @@ static void DestroyTableData(void *data, int dispose)
 
 void DestroyTable(struct Table *table, int dispose)
 {
-  struct TableEntry *ptr, *next;
-  unsigned long hashsize,c;
+  unsigned long c;
 
   if (table==NULL) return;
-  hashsize = table->hashsize;
-  for (c=0 ; c<hashsize ; c++) {
-    if (table->buckets[c] != NULL) {
-      ptr = table->buckets[c];
-      while(ptr!=NULL) {
-        DestroyTableData(ptr->data, dispose); /* deallocate the data */
-        next = ptr->next;
-        ascfree((char *)ptr->id);             /* deallocate the string */
-        ascfree((char *)ptr);                 /* deallocate the node */
-        table->size--;
-        ptr = next;
-      }
-      table->buckets[c] = NULL;
+  for (c=0 ; c<table->nentries ; c++) {
+    if (table->entries[c].id != NULL) {
+      DestroyTableData(table->entries[c].data, dispose); /* deallocate the data */
+      ascfree((char *)table->entries[c].id);             /* deallocate the string */
     }
   }
-  ascfree((char *)table->buckets);            /* deallocate the table */
+  ascfree((char *)table->entries);            /* deallocate the entries */
+  IndexDestroy(&table->index);                /* deallocate the indexes */
+  IndexDestroy(&table->old);
   ascfree((char *)table);                     /* deallocate the head */
 }
 
 
 void AddTableData(struct Table *table, void *data, CONST char *id)
 {
-  unsigned long c;
+  unsigned long hash, e;
   struct TableEntry *ptr;
 
   asc_assert((NULL != table) && (NULL != id));
-  c = hashpjw(id,table->hashsize);
-  ptr = table->buckets[c];
+  hash = TableHash(id);
   /* search for name collisions */
-  while (ptr) {
-    if (strcmp(id,ptr->id)==0)
-      return;
-    ptr = ptr->next;
+  if (TableFind(table,hash,id) >= 0)
+    return;
+  TableGrow(table);
+  if (table->nentries == table->capentries) {
+    table->capentries *= 2;
+    table->entries = (struct TableEntry *)ascrealloc(table->entries,
+                      table->capentries*sizeof(struct TableEntry));
   }
-  /* add new information node to the head of the list. */
-  ptr = ASC_NEW(struct TableEntry);
+  e = table->nentries++;
+  ptr = &table->entries[e];
   ptr->id = ASC_NEW_ARRAY(char,strlen(id)+1);
   strcpy(ptr->id,id);      /* we will copy the string */
-  ptr->next = table->buckets[c];
   ptr->data = data;
-  table->buckets[c] = ptr;
+  ptr->hash = hash;
+  IndexInsert(&table->index,hash,e);
+  TableMigrate(table,TABLE_MIGRATE);
   table->size++;
-  table->lastfind = ptr;
+  table->lastfind = e + 1;
 }
 
 void *LookupTableData(struct Table *table, CONST char *id)
 {
-  unsigned long c;
-  struct TableEntry *ptr;
+  long e;
 
   asc_assert((NULL != table) && (NULL != id));
-  c = hashpjw(id,table->hashsize);
-  ptr = table->buckets[c];
-  while (ptr) {
-    if (strcmp(id,ptr->id)==0) {
-      table->lastfind = ptr;
-      return ptr->data;
-    }
-    ptr = ptr->next;
+  e = TableFind(table,TableHash(id),id);
+  TableMigrate(table,TABLE_MIGRATE);
+  if (e < 0) {
+    table->lastfind = 0;
+    return NULL;    /* id not found */
   }
-  table->lastfind = NULL;
-  return NULL;    /* id not found */
+  table->lastfind = (unsigned long)e + 1;
+  return table->entries[e].data;
 }
 
 void *RemoveTableData(struct Table *table, char *id)
 {
-  unsigned long c;
-  struct TableEntry *ptr, **tmp;
+  unsigned long hash;
+  long c;
+  struct TableIndex *index;
+  struct TableEntry *ptr;
   void *result;
 
   asc_assert((NULL != table) && (NULL != id));
-  c = hashpjw(id,table->hashsize);
-  tmp = &table->buckets[c];
-  ptr = table->buckets[c];
-  while (ptr) {
-    if (strcmp(id,ptr->id)==0) {
-      *tmp = ptr->next;
-      result = ptr->data;
-      if (table->lastfind==ptr)	table->lastfind = NULL;
-      ascfree((char *)ptr->id); /* deallocate the string */
-      ascfree((char *)ptr);     /* deallocate the node */
-      table->size--;
-      return result;
-    }
-    tmp = &ptr->next;
-    ptr = ptr->next;
+  hash = TableHash(id);
+  index = &table->index;
+  c = IndexFind(table,index,hash,id);
+  if (c < 0 && table->old.slots != NULL) {
+    index = &table->old;
+    c = IndexFind(table,index,hash,id);
   }
-  return NULL; /* node id not found */
+  if (c < 0) return NULL; /* node id not found */
+  ptr = &table->entries[index->slots[c].entry - 1];
+  if (table->lastfind == index->slots[c].entry) table->lastfind = 0;
+  index->slots[c].entry = SLOT_DELETED;
+  result = ptr->data;
+  ascfree((char *)ptr->id); /* deallocate the string */
+  ptr->id = NULL;
+  ptr->data = NULL;
+  table->size--;
+  return result;
 }
 
 /*
@@ -172,11 +347,13 @@ void TableApplyOne(struct Table *table,
                    char *id)
 {
   void *data;
+  struct TableEntry *ptr;
 
   asc_assert((NULL != table) && (NULL != applyfunc) && (NULL != id));
   if (table->lastfind) {
-    if (strcmp(table->lastfind->id,id)==0) {
-      (*applyfunc)(table->lastfind->data);
+    ptr = &table->entries[table->lastfind - 1];
+    if (strcmp(ptr->id,id)==0) {
+      (*applyfunc)(ptr->data);
       return;
     }
   }
@@ -188,17 +365,13 @@ void TableApplyOne(struct Table *table,
 
 void TableApplyAll(struct Table *table, TableIteratorOne applyfunc)
 {
-  unsigned long c,hashsize;
-  struct TableEntry *ptr;
+  unsigned long c;
 
   asc_assert((NULL != table) && (NULL != applyfunc));
 
-  hashsize = table->hashsize;
-  for (c=0;c<hashsize;c++) {
-    ptr = table->buckets[c];
-    while (ptr) {
-      (*applyfunc)(ptr->data);
-      ptr = ptr->next;
+  for (c=0;c<table->nentries;c++) {
+    if (table->entries[c].id != NULL) {
+      (*applyfunc)(table->entries[c].data);
     }
   }
 }
@@ -207,36 +380,29 @@ void TableApplyAllTwo(struct Table *table,
                       TableIteratorTwo applyfunc,
                       void *arg2)
 {
-  unsigned long c,hashsize;
-  struct TableEntry *ptr;
+  unsigned long c;
 
   asc_assert((NULL != table) && (NULL != applyfunc));
 
-  hashsize = table->hashsize;
-  for (c=0;c<hashsize;c++) {
-    ptr = table->buckets[c];
-    while (ptr) {
-      (*applyfunc)(ptr->data,arg2);
-      ptr = ptr->next;
+  for (c=0;c<table->nentries;c++) {
+    if (table->entries[c].id != NULL) {
+      (*applyfunc)(table->entries[c].data,arg2);
     }
   }
 }
 
 void PrintTable(FILE *f, struct Table *table)
 {
-  unsigned long c,hashsize;
-  struct TableEntry *ptr;
+  unsigned long c;
   unsigned long entrynum = 1;
 
   asc_assert((NULL != table) && (NULL != f));
 
-  hashsize = table->hashsize;
-  for (c=0;c<hashsize;c++) {
-    ptr = table->buckets[c];
-    while (ptr) {
+  for (c=0;c<table->nentries;c++) {
+    if (table->entries[c].id != NULL) {
       FPRINTF(f,"Entry %lu\tBucket %lu\tId %s\n",
-                 entrynum++,c,ptr->id);
-      ptr = ptr->next;
+                 entrynum++,table->entries[c].hash & table->index.mask,
+                 table->entries[c].id);
     }
   }
 }
@@ -256,7 +422,6 @@ unsigned long TableHashSize(struct Table *table)
 void *TableLastFind(struct Table *table)
 {
   asc_assert(table!=NULL);
-  return (NULL == table->lastfind) ?
-          NULL : table->lastfind->data;
+  return (0 == table->lastfind) ?
+          NULL : table->entries[table->lastfind - 1].data;
 }
-
@@ -17,11 +17,14 @@
 *//** @defgroup general_table General Hash Table
 	Many hash tables are used throughout the implementation of a compiler
 	and/or interpreter. This module (in the spirit of the list module)
-	attempts to provide a generic table implementation, based on the classic
-	*bucket and chains* for resolving collisions. Nothing fancy is done,
-	except that we cache a ptr to the last thing found, so that access to
-	it if required is fast. We append the new element to the front of the
-	chain. The hashpjw algorithm is used.
+	attempts to provide a generic table implementation. Entries are stored
+	contiguously in the order they are added, and found through an
+	open-addressed index that keeps the full hash of each entry. The index
+	grows as the table fills, so the size given at creation is only a hint;
+	growing is done incrementally, a few entries at a time over the calls
+	that follow, rather than all at once. We also cache the last thing
+	found, so that access to it if required is fast. The hashpjw algorithm
+	is used.
 	
 	This module is appropriate for hash tables keyed with arbitrary strings.
 	It is not appropriate for use with symbol table entry keys.
@@ -54,19 +57,17 @@ typedef  void (*TableIteratorTwo)(void *,void *);
 
 ASC_DLLSPEC struct Table *CreateTable(unsigned long hashsize);
 /**<
- *  Creates a new hash table with the specified hashsize.
- *  This ideally should be a prime number.  A good choice will give
- *  better performance without wasting too much memory.  Some good
- *  prime numbers are: 31, 97, 113, 229, 541, 1023, 3571.
+ *  Creates a new hash table with room for about hashsize entries.
+ *  The table grows as needed, so this need only be a rough guess; a
+ *  good one saves some resizing without wasting too much memory.
  *  Everything is appropriately initialized.<br><br>
  *
  *  The function returns a pointer to the newly created hash table.
  *  Deallocation of the table is the responsibility of the caller 
  *  using DestroyTable().
  *
- *  @param hashsize The number of buckets in the new hash table.
+ *  @param hashsize The expected number of entries in the new hash table.
  *  @return A pointer to the new hash table.
- *  @todo Should general/table:CreateTable have lower limit on hashsize?
  */
 
 ASC_DLLSPEC void DestroyTable(struct Table *table, int dispose);
@@ -143,9 +144,8 @@ ASC_DLLSPEC void TableApplyOne(struct Table *table,
 
 ASC_DLLSPEC void TableApplyAll(struct Table *table, TableIteratorOne applyfunc);
 /**<
- *  Calls the specified function for each data item stored in the table.
- *  The order of operation dependends on internal table structure, so is
- *  not predictable and should not be relied upon.  Using this function
+ *  Calls the specified function for each data item stored in the table,
+ *  in the order the items were added.  Using this function
  *  should be a lot faster than fetching each element independently and 
  *  applying applyfunc to it.  The function must be able to handle NULL 
  *  pointers gracefully.  Neither table nor applyfunc may be NULL 
@@ -161,9 +161,8 @@ ASC_DLLSPEC void TableApplyAllTwo(struct Table *table,
 /**<
  *  Calls the specified function for each data item stored in the table.
  *  This is the same as TableApplyAll(), except that arg2 is passed as a
- *  second argument to applyfunc allowing a closure.  The order of 
- *  operation dependends on internal table structure, so is not 
- *  predictable and should not be relied upon.  Using this function
+ *  second argument to applyfunc allowing a closure.  Items are visited
+ *  in the order they were added.  Using this function
  *  should be a lot faster than fetching each element independently and
  *  applying applyfunc to it.  The function must be able to handle NULL
  *  pointers gracefully.  Neither table nor applyfunc may be NULL
@@ -177,8 +176,9 @@ ASC_DLLSPEC void TableApplyAllTwo(struct Table *table,
 extern void PrintTable(FILE *file, struct Table *table);
 /**<
  *  Prints information about the table to the given file.  This
- *  information currently includes an ordered list of bucket
- *  numbers and id strings for each data item in the table.
+ *  information currently includes a list of the home slot numbers
+ *  in the index and id strings for each data item in the table,
+ *  in the order the items were added.
  *  The file must be opened and ready for writing.  Neither table
  *  nor file may be NULL (checked by assertion).
  *
@@ -196,11 +196,10 @@ ASC_DLLSPEC unsigned long TableSize(struct Table *table);
 
 ASC_DLLSPEC unsigned long TableHashSize(struct Table *table);
 /**<
- *  Returns the current hashsize of the table.  If internally we 
- *  change the hashing/collision algorithm, this may be useful 
- *  information to someone.  At the moment it is the size 
- *  requested and hence is not very useful.  The specified table 
- *  may not be NULL (checked by assertion).
+ *  Returns the hashsize the table was created with.  The index
+ *  itself is resized as entries are added, so this is not very
+ *  useful.  The specified table may not be NULL (checked by
+ *  assertion).
  *
  *  @param table Pointer to the hash table to query (non-NULL).
  */
@@ -37,6 +37,7 @@
 	T(ospath) \
 	T(env) \
 	T(ltmatrix) \
+	T(threadpool) \
 	T(ascMalloc)
 /* 	T(qsort1) */
 
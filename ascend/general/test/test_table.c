@@ -22,14 +22,21 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <time.h>
 #include <ascend/general/platform.h>
 #include <ascend/general/ascMalloc.h>
 #include <ascend/utilities/ascPrint.h>
+#include <ascend/utilities/error.h>
 #include <ascend/general/table.h>
+#include <ascend/general/hashpjw.h>
 
 #include <test/common.h>
 #include <test/assertimpl.h>
 
+/* run the lookup benchmark up to 10^7 entries, rather than 10^5 */
+//#define TABLE_BENCH_FULL
+
 /* transform function used in test_list(). */
 static
 void mult_by_2(VOIDPTR p)
@@ -448,11 +455,188 @@ static void test_table(void)
   CU_TEST(prior_meminuse == ascmeminuse());   /* make sure we cleaned up after ourselves */
 }
 
+/* iterator used in test_grow(), checks that items come in the order added */
+static
+void check_order(VOIDPTR p, VOIDPTR next)
+{
+  if (*(unsigned long *)p != *(unsigned long *)next) {
+    *(unsigned long *)next = ULONG_MAX;
+  }else{
+    *(unsigned long *)next += 3;
+  }
+}
+
+static void test_grow(void)
+{
+  struct Table *p_table1;
+  unsigned long i, n = 20000, next;
+  unsigned long *data;
+  char str50[50];
+  unsigned long prior_meminuse;
+
+  prior_meminuse = ascmeminuse();
+
+  data = ASC_NEW_ARRAY(unsigned long,n);
+  p_table1 = CreateTable(1);            /* far too small to start with */
+  for (i=0 ; i<n ; ++i) {
+    data[i] = i;
+    sprintf(str50, "key_%lu", i);
+    AddTableData(p_table1, &data[i], str50);
+    CU_TEST(&data[i] == TableLastFind(p_table1));
+    if (i % 997 == 0) {                 /* everything so far is still found */
+      unsigned long j;
+      for (j=0 ; j<=i ; j+=7) {
+        sprintf(str50, "key_%lu", j);
+        CU_TEST(&data[j] == LookupTableData(p_table1, str50));
+      }
+    }
+  }
+  CU_TEST(n == TableSize(p_table1));
+  CU_TEST(1 == TableHashSize(p_table1));
+
+  for (i=0 ; i<n ; ++i) {               /* keep only every third item */
+    if (i % 3 != 0) {
+      sprintf(str50, "key_%lu", i);
+      CU_TEST(&data[i] == RemoveTableData(p_table1, str50));
+    }
+  }
+  CU_TEST((n+2)/3 == TableSize(p_table1));
+  for (i=0 ; i<n ; ++i) {
+    sprintf(str50, "key_%lu", i);
+    CU_TEST(((i % 3 == 0) ? &data[i] : NULL) == LookupTableData(p_table1, str50));
+  }
+
+  for (i=n ; i<2*n ; ++i) {             /* refill, reusing the removed space */
+    sprintf(str50, "key_%lu", i);
+    AddTableData(p_table1, &data[i - n], str50);
+  }
+  CU_TEST((n+2)/3 + n == TableSize(p_table1));
+  sprintf(str50, "key_%lu", 2*n - 3);
+  CU_TEST(NULL != LookupTableData(p_table1, str50));
+  sprintf(str50, "key_%d", 2);
+  CU_TEST(NULL == LookupTableData(p_table1, str50));
+
+  DestroyTable(p_table1, FALSE);
+
+  /* items are visited in the order they were added */
+  p_table1 = CreateTable(31);
+  for (i=0 ; i<n ; ++i) {
+    sprintf(str50, "key_%lu", i);
+    AddTableData(p_table1, &data[i], str50);
+  }
+  for (i=0 ; i<n ; ++i) {
+    if (i % 3 != 0) {
+      sprintf(str50, "key_%lu", i);
+      RemoveTableData(p_table1, str50);
+    }
+  }
+  next = 0;
+  TableApplyAllTwo(p_table1, check_order, &next);
+  CU_TEST(next == 3*((n+2)/3));
+  DestroyTable(p_table1, FALSE);
+
+  ascfree(data);
+  CU_TEST(prior_meminuse == ascmeminuse());
+}
+
+/*
+ * A bucket-and-chain table with a fixed number of buckets, as general/table
+ * used to be, for comparison in test_benchmark().
+ */
+struct ChainEntry {
+  char *id;
+  void *data;
+  struct ChainEntry *next;
+};
+
+#define CHAIN_BUCKETS 1023
+
+static
+void *chain_lookup(struct ChainEntry **buckets, CONST char *id)
+{
+  struct ChainEntry *ptr;
+  for (ptr = buckets[hashpjw(id,CHAIN_BUCKETS)]; ptr != NULL; ptr = ptr->next) {
+    if (strcmp(id,ptr->id)==0) return ptr->data;
+  }
+  return NULL;
+}
+
+#define BENCH_LOOKUPS 100000
+
+static void test_benchmark(void)
+{
+  struct Table *p_table1;
+  struct ChainEntry **buckets, *chain, *ptr;
+  char (*keys)[24];
+  char str50[50];
+  unsigned long n, i, c, found, cfound;
+  double tbuild, tlookup, tchain;
+  clock_t c0;
+#ifdef TABLE_BENCH_FULL
+  unsigned long nmax = 10000000;
+#else
+  unsigned long nmax = 100000;
+#endif
+
+  keys = (char (*)[24])ascmalloc(BENCH_LOOKUPS*sizeof(*keys));
+  for (n=1000 ; n<=nmax ; n*=10) {
+    c0 = clock();
+    p_table1 = CreateTable(31);
+    for (i=0 ; i<n ; ++i) {
+      sprintf(str50, "model_%lu.x", i);
+      AddTableData(p_table1, (VOIDPTR)(i+1), str50);
+    }
+    tbuild = (double)(clock() - c0)/CLOCKS_PER_SEC;
+
+    buckets = ASC_NEW_ARRAY_CLEAR(struct ChainEntry *,CHAIN_BUCKETS);
+    chain = ASC_NEW_ARRAY(struct ChainEntry,n);
+    for (i=0 ; i<n ; ++i) {
+      sprintf(str50, "model_%lu.x", i);
+      ptr = &chain[i];
+      ptr->id = ASC_STRDUP(str50);
+      ptr->data = (VOIDPTR)(i+1);
+      c = hashpjw(ptr->id,CHAIN_BUCKETS);
+      ptr->next = buckets[c];
+      buckets[c] = ptr;
+    }
+
+    /* 3/4 of lookups are hits */
+    for (i=0 ; i<BENCH_LOOKUPS ; ++i) {
+      c = (i * 2654435761UL + 12345) % (n + n/3);
+      sprintf(keys[i], "model_%lu.x", c);
+    }
+    found = cfound = 0;
+    c0 = clock();
+    for (i=0 ; i<BENCH_LOOKUPS ; ++i) {
+      if (NULL != LookupTableData(p_table1, keys[i])) found++;
+    }
+    tlookup = (double)(clock() - c0)/CLOCKS_PER_SEC;
+    c0 = clock();
+    for (i=0 ; i<BENCH_LOOKUPS ; ++i) {
+      if (NULL != chain_lookup(buckets, keys[i])) cfound++;
+    }
+    tchain = (double)(clock() - c0)/CLOCKS_PER_SEC;
+    CU_TEST(found == cfound);
+
+    CONSOLE_DEBUG("%8lu entries: build %.3f s, lookup %.3f us (chained, %d buckets: %.3f us)"
+      ,n, tbuild, 1e6*tlookup/BENCH_LOOKUPS, CHAIN_BUCKETS, 1e6*tchain/BENCH_LOOKUPS
+    );
+
+    for (i=0 ; i<n ; ++i) ascfree(chain[i].id);
+    ascfree(chain);
+    ascfree(buckets);
+    DestroyTable(p_table1, FALSE);
+  }
+  ascfree(keys);
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T) \
-	T(table)
+	T(table) \
+	T(grow) \
+	T(benchmark)
 
 REGISTER_TESTS_SIMPLE(general_table, TESTS)
 
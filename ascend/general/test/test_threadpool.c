@@ -0,0 +1,100 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Test functions for general/threadpool.c
+*/
+
+#include <ascend/general/threadpool.h>
+#include <ascend/general/ascMalloc.h>
+
+#include "test/common.h"
+
+#define NTASKS 1000
+
+struct pooltest{
+	int count[NTASKS];
+	int thread[NTASKS];
+};
+
+static void count_task(void *data, int task, int thread){
+	struct pooltest *pt = (struct pooltest *)data;
+	pt->count[task]++;
+	pt->thread[task] = thread;
+}
+
+static void check_run(threadpool_t *pool, int ntasks){
+	struct pooltest pt;
+	int i, size = threadpool_size(pool);
+	for(i=0; i<NTASKS; ++i){
+		pt.count[i] = 0;
+		pt.thread[i] = -1;
+	}
+	threadpool_run(pool,ntasks,&count_task,&pt);
+	for(i=0; i<ntasks; ++i){
+		CU_TEST(pt.count[i]==1);
+		CU_TEST(pt.thread[i]>=0 && pt.thread[i]<size);
+	}
+	for(; i<NTASKS; ++i){
+		CU_TEST(pt.count[i]==0);
+	}
+}
+
+static void test_serial(void){
+	unsigned long prior_meminuse = ascmeminuse();
+	threadpool_t *pool = threadpool_create(1);
+	CU_TEST_FATAL(pool!=NULL);
+	CU_TEST(threadpool_size(pool)==1);
+	check_run(pool,NTASKS);
+	check_run(pool,0);
+	threadpool_destroy(pool);
+	CU_TEST(prior_meminuse == ascmeminuse());
+}
+
+static void test_parallel(void){
+	unsigned long prior_meminuse = ascmeminuse();
+	int i;
+	threadpool_t *pool = threadpool_create(4);
+	CU_TEST_FATAL(pool!=NULL);
+#ifdef ASC_HAVE_PTHREADS
+	CU_TEST(threadpool_size(pool)==4);
+#else
+	CU_TEST(threadpool_size(pool)==1);
+#endif
+	/* the pool must be reusable, and cope with fewer tasks than threads */
+	for(i=0; i<50; ++i){
+		check_run(pool,NTASKS);
+		check_run(pool,1);
+		check_run(pool,3);
+	}
+	threadpool_destroy(pool);
+	threadpool_destroy(NULL);
+	CU_TEST(prior_meminuse == ascmeminuse());
+}
+
+static void test_cpucount(void){
+	CU_TEST(threadpool_cpu_count() >= 1);
+}
+
+/*===========================================================================*/
+/* Registration information */
+
+#define TESTS(T) \
+	T(serial) \
+	T(parallel) \
+	T(cpucount)
+
+REGISTER_TESTS_SIMPLE(general_threadpool, TESTS);
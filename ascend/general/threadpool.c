@@ -0,0 +1,263 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Fixed-size thread pool, see threadpool.h.
+*/
+
+#include "threadpool.h"
+#include <stdlib.h>
+#include "ascMalloc.h"
+#include "panic.h"
+#include <ascend/utilities/error.h>
+
+#ifdef ASC_HAVE_PTHREADS
+# include <pthread.h>
+# include <signal.h>
+# include <unistd.h>
+# ifdef HAVE_C99FPE
+#  include <fenv.h>
+# endif
+#endif
+
+#ifdef __WIN32__
+# include <windows.h>
+#endif
+
+int threadpool_cpu_count(void){
+#if defined(__WIN32__)
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#elif defined(ASC_HAVE_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#else
+	return 1;
+#endif
+}
+
+int threadpool_default_size(void){
+	const char *env;
+	int n;
+#if defined(MALLOC_DEBUG) || defined(ASC_WITH_DMALLOC)
+	/* the allocation tracking is not thread-safe */
+	return 1;
+#endif
+	env = getenv("ASCEND_NUM_THREADS");
+	if(env != NULL && (n = atoi(env)) > 0)return n;
+	return threadpool_cpu_count();
+}
+
+#ifdef ASC_HAVE_PTHREADS
+
+struct threadpool_worker{
+	threadpool_t *pool;
+	int id;
+	pthread_t thread;
+};
+
+struct threadpool_struct{
+	int size; /**< number of threads working on tasks, including the caller */
+	struct threadpool_worker *workers; /**< size-1 of them */
+	pthread_mutex_t lock;
+	pthread_cond_t work; /**< signalled when a job is posted or on shutdown */
+	pthread_cond_t done; /**< signalled when the last task of a job completes */
+	int stop;
+	/* the current job, all protected by lock */
+	threadpool_task_fn *fn;
+	void *data;
+	int ntasks;
+	int next; /**< next task to hand out */
+	int finished; /**< number of tasks completed */
+};
+
+/**
+	Take and run tasks of the current job until there are none left.
+	Called and returns with pool->lock held.
+*/
+static void threadpool_work(threadpool_t *pool, int id){
+	threadpool_task_fn *fn = pool->fn;
+	void *data = pool->data;
+	int task;
+	while(pool->next < pool->ntasks){
+		task = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+		(*fn)(data,task,id);
+		pthread_mutex_lock(&pool->lock);
+		if(++pool->finished == pool->ntasks){
+			pthread_cond_signal(&pool->done);
+		}
+	}
+}
+
+static void *threadpool_main(void *arg){
+	struct threadpool_worker *w = (struct threadpool_worker *)arg;
+	threadpool_t *pool = w->pool;
+	sigset_t all;
+
+	/* leave signal handling to the thread(s) that installed the handlers */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK,&all,NULL);
+#ifdef HAVE_C99FPE
+	/* threads inherit the creator's FP environment, which may have traps on */
+	fesetenv(FE_DFL_ENV);
+#endif
+
+	pthread_mutex_lock(&pool->lock);
+	for(;;){
+		while(!pool->stop && pool->next >= pool->ntasks){
+			pthread_cond_wait(&pool->work,&pool->lock);
+		}
+		if(pool->stop)break;
+		threadpool_work(pool,w->id);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+threadpool_t *threadpool_create(int nthreads){
+	threadpool_t *pool;
+	int i;
+
+	if(nthreads < 1)nthreads = 1;
+	pool = ASC_NEW_CLEAR(threadpool_t);
+	if(pool==NULL)return NULL;
+	pthread_mutex_init(&pool->lock,NULL);
+	pthread_cond_init(&pool->work,NULL);
+	pthread_cond_init(&pool->done,NULL);
+	pool->size = 1;
+	if(nthreads > 1){
+		pool->workers = ASC_NEW_ARRAY(struct threadpool_worker,nthreads-1);
+		if(pool->workers==NULL){
+			threadpool_destroy(pool);
+			return NULL;
+		}
+		for(i=1; i<nthreads; ++i){
+			struct threadpool_worker *w = &pool->workers[i-1];
+			w->pool = pool;
+			w->id = i;
+			if(pthread_create(&w->thread,NULL,&threadpool_main,w)){
+				ERROR_REPORTER_HERE(ASC_PROG_WARNING
+					,"Unable to start worker thread %d of %d",i,nthreads-1
+				);
+				break;
+			}
+			pool->size = i+1;
+		}
+	}
+	return pool;
+}
+
+int threadpool_size(CONST threadpool_t *pool){
+	return pool==NULL ? 1 : pool->size;
+}
+
+void threadpool_run(threadpool_t *pool, int ntasks
+		, threadpool_task_fn *fn, void *data
+){
+	int t;
+#ifdef HAVE_C99FPE
+	fenv_t env;
+#endif
+	if(ntasks <= 0)return;
+	if(pool==NULL || pool->size==1 || ntasks==1){
+		for(t=0; t<ntasks; ++t){
+			(*fn)(data,t,0);
+		}
+		return;
+	}
+	pthread_mutex_lock(&pool->lock);
+	if(pool->finished < pool->ntasks){
+		/* pool busy with a job from another thread (or from a task of that
+		job): don't wait for it, just do the work ourselves */
+		pthread_mutex_unlock(&pool->lock);
+		for(t=0; t<ntasks; ++t){
+			(*fn)(data,t,0);
+		}
+		return;
+	}
+	pool->fn = fn;
+	pool->data = data;
+	pool->ntasks = ntasks;
+	pool->next = 0;
+	pool->finished = 0;
+	pthread_cond_broadcast(&pool->work);
+#ifdef HAVE_C99FPE
+	/* run our share of the tasks under the same conditions as the workers */
+	fegetenv(&env);
+	fesetenv(FE_DFL_ENV);
+#endif
+	threadpool_work(pool,0);
+	while(pool->finished < pool->ntasks){
+		pthread_cond_wait(&pool->done,&pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+#ifdef HAVE_C99FPE
+	feclearexcept(FE_ALL_EXCEPT);
+	fesetenv(&env);
+#endif
+}
+
+void threadpool_destroy(threadpool_t *pool){
+	int i;
+	if(pool==NULL)return;
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+	for(i=1; i<pool->size; ++i){
+		pthread_join(pool->workers[i-1].thread,NULL);
+	}
+	if(pool->workers!=NULL)ASC_FREE(pool->workers);
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	ASC_FREE(pool);
+}
+
+#else /* no threads: everything runs on the caller */
+
+struct threadpool_struct{
+	int size;
+};
+
+threadpool_t *threadpool_create(int nthreads){
+	threadpool_t *pool = ASC_NEW(threadpool_t);
+	(void)nthreads;
+	if(pool!=NULL)pool->size = 1;
+	return pool;
+}
+
+int threadpool_size(CONST threadpool_t *pool){
+	(void)pool;
+	return 1;
+}
+
+void threadpool_run(threadpool_t *pool, int ntasks
+		, threadpool_task_fn *fn, void *data
+){
+	int t;
+	(void)pool;
+	for(t=0; t<ntasks; ++t){
+		(*fn)(data,t,0);
+	}
+}
+
+void threadpool_destroy(threadpool_t *pool){
+	if(pool!=NULL)ASC_FREE(pool);
+}
+
+#endif /* ASC_HAVE_PTHREADS */
@@ -0,0 +1,101 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @defgroup general_threadpool General Thread Pool
+
+	A small fixed-size pool of worker threads for data-parallel loops.
+
+	threadpool_run hands out the task numbers 0..ntasks-1 to the workers
+	and to the calling thread, and returns once every task has finished.
+	Tasks are handed out one at a time in increasing order, so callers
+	wanting coarser scheduling should make each task cover a range of
+	items. Only one job runs on a pool at a time: if threadpool_run is
+	called while the pool is busy (from another thread, or from within a
+	task), the new job's tasks are run in order on the calling thread, as
+	thread 0, rather than waiting for the pool.
+
+	Without POSIX threads (see ASC_HAVE_PTHREADS in config.h) the pool has
+	no workers and threadpool_run simply runs the tasks in order on the
+	calling thread.
+
+	Worker threads start with the default floating-point environment, ie
+	with all floating-point exceptions masked, and are not covered by the
+	signal traps of ascSignal.h. Task functions must not longjmp.
+*/
+
+#ifndef ASC_THREADPOOL_H
+#define ASC_THREADPOOL_H
+
+#include <ascend/general/config.h>
+#include "platform.h"
+
+/**	@addtogroup general_threadpool General Thread Pool
+	@{
+*/
+
+typedef struct threadpool_struct threadpool_t;
+
+typedef void threadpool_task_fn(void *data, int task, int thread);
+/**<
+	Function run for each task.
+	@param data the pointer given to threadpool_run.
+	@param task task number, 0..ntasks-1.
+	@param thread number of the thread running the task, 0..size-1, with
+		0 being the thread that called threadpool_run. Useful for indexing
+		per-thread scratch space.
+*/
+
+ASC_DLLSPEC threadpool_t *threadpool_create(int nthreads);
+/**<
+	Create a pool in which up to nthreads threads (including the caller of
+	threadpool_run) work on tasks, ie nthreads-1 worker threads are
+	started. Values below 1 are taken as 1.
+	@return the new pool, or NULL if it could not be created.
+*/
+
+ASC_DLLSPEC int threadpool_size(CONST threadpool_t *pool);
+/**<
+	Number of threads that take part in threadpool_run, including the
+	caller. Always 1 when threads are not supported.
+*/
+
+ASC_DLLSPEC void threadpool_run(threadpool_t *pool, int ntasks
+	, threadpool_task_fn *fn, void *data
+);
+/**<
+	Run fn(data,task,thread) for task = 0..ntasks-1, spread over the pool,
+	and wait for all of them to complete.
+*/
+
+ASC_DLLSPEC void threadpool_destroy(threadpool_t *pool);
+/**<
+	Stop and join the worker threads and free the pool. Safe with NULL.
+*/
+
+ASC_DLLSPEC int threadpool_cpu_count(void);
+/**<
+	Number of processors currently online, or 1 if it cannot be determined.
+*/
+
+ASC_DLLSPEC int threadpool_default_size(void);
+/**<
+	Number of threads to use when the caller has no better idea: the value
+	of the environment variable ASCEND_NUM_THREADS if set, else the number
+	of processors. Always 1 in builds that track memory allocations.
+*/
+
+/* @} */
+
+#endif /* ASC_THREADPOOL_H */
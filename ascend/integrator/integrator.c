@@ -24,6 +24,13 @@
 */
 #include <time.h>
 #include <string.h>
+#include <math.h>
+
+#include <ascend/utilities/config.h>
+#include <ascend/general/config.h>
+#ifdef ASC_SIGNAL_TRAPS
+# include <ascend/utilities/ascSignal.h>
+#endif
 
 #include <ascend/general/panic.h>
 #include <ascend/general/ascMalloc.h>
@@ -34,6 +41,7 @@
 #include <ascend/system/slv_common.h>
 #include <ascend/system/slv_stdcalls.h>
 #include <ascend/system/block.h>
+#include <ascend/system/relman.h>
 
 #include <ascend/solver/solver.h>
 
@@ -45,6 +53,7 @@
 /* #define CLASSIFY_DEBUG */
 /* #define DESTROY_DEBUG */
 /* #define ATOL_DEBUG */
+/* #define STATS_DEBUG */
 
 /*------------------------------------------------------------------------------
    The following names are of solver_var children or attributes
@@ -115,6 +124,11 @@ static long DynamicVarInfo(struct var_variable *v,long *vindex, IntegratorSystem
 static struct var_variable *ObservationVar(struct var_variable *v, long *oindex);
 static void IntegInitSymbols(void);
 
+static IntegratorJacobian *integrator_jacobian_create(IntegratorSystem *sys);
+static void integrator_jacobian_destroy(IntegratorJacobian *jac);
+
+static void integrator_algebraic_reset(IntegratorAlgebraic *alg);
+
 /*------------------------------------------------------------------------------
   INSTANTIATION AND DESTRUCTION
 */
@@ -146,6 +160,8 @@ IntegratorSystem *integrator_new(slv_system_t slvsys, struct Instance *inst){
 	sys->ydot = NULL;
 	sys->obs = NULL;
 	sys->n_y = 0;
+	sys->jacobian = NULL;
+	sys->algebraic = NULL;
 	return sys;
 }
 
@@ -176,6 +192,11 @@ void integrator_free(IntegratorSystem *sys){
 	if(sys->y != NULL)ASC_FREE(sys->y);
 	if(sys->ydot != NULL)ASC_FREE(sys->ydot);
 	if(sys->obs != NULL)ASC_FREE(sys->obs);
+	integrator_jacobian_destroy(sys->jacobian);
+	if(sys->algebraic != NULL){
+		integrator_algebraic_reset(sys->algebraic);
+		ASC_FREE(sys->algebraic);
+	}
 
 	slv_destroy_parms(&(sys->params));
 
@@ -526,6 +547,19 @@ int integrator_analyse(IntegratorSystem *sys){
 	}
 
 	res = (sys->internals->analysefn)(sys);
+	if(!res){
+		integrator_jacobian_destroy(sys->jacobian);
+		sys->jacobian = integrator_jacobian_create(sys);
+		if(sys->jacobian == NULL){
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to allocate Jacobian workspace");
+			res = 3;
+		}
+		if(sys->algebraic != NULL){
+			integrator_algebraic_reset(sys->algebraic);
+			ASC_FREE(sys->algebraic);
+		}
+		sys->algebraic = ASC_NEW_CLEAR(IntegratorAlgebraic);
+	}
 #ifdef ANALYSE_DEBUG
 	CONSOLE_DEBUG("integrator_analyse returning %d",res);
 #endif
@@ -1065,6 +1099,7 @@ static struct var_variable *ObservationVar(struct var_variable *v, long *index){
 int integrator_solve(IntegratorSystem *sys, long i0, long i1){
 
 	long nstep;
+	int res;
 	unsigned long start_index=0, finish_index=0;
 	asc_assert(sys!=NULL);
 
@@ -1104,7 +1139,636 @@ int integrator_solve(IntegratorSystem *sys, long i0, long i1){
 
 	CONSOLE_DEBUG("RUNNING INTEGRATION...");
 
-	return (sys->internals->solvefn)(sys,start_index,finish_index);
+	/* the problem may have been changed since the last run, maybe on
+	another thread */
+	if(sys->algebraic != NULL)integrator_algebraic_reset(sys->algebraic);
+	slv_var_store_gather(sys->system);
+
+	res = (sys->internals->solvefn)(sys,start_index,finish_index);
+
+#ifdef STATS_DEBUG
+	if(sys->algebraic != NULL && sys->algebraic->ncalls){
+		CONSOLE_DEBUG("Algebraic solves: %lu (%lu direct, %lu with %lu solver iterations, %lu failed)"
+			,sys->algebraic->ncalls,sys->algebraic->nexplicit,sys->algebraic->nsolves
+			,sys->algebraic->niterations,sys->algebraic->nfailed
+		);
+		CONSOLE_DEBUG("Block by block: %lu (%lu block factorisations)"
+			,sys->algebraic->nblocked,sys->algebraic->nfactors
+		);
+	}
+
+	if(sys->jacobian != NULL && sys->jacobian->nsetups){
+		CONSOLE_DEBUG("Jacobian setups: %lu (%lu full and %lu numeric-only factorisations)"
+			,sys->jacobian->nsetups,sys->jacobian->nfull,sys->jacobian->nnumeric
+		);
+	}
+#endif
+	return res;
+}
+
+/*------------------------------------------------------------------------------
+  JACOBIAN WORKSPACE
+*/
+
+/**
+	Allocate the index maps of the Jacobian workspace for the states and
+	derivatives found by the engine's analysis. They are filled in by
+	integrator_jacobian_begin. The scratch vectors are left for
+	integrator_jacobian_reserve, as their length depends on the matrix
+	the engine uses.
+*/
+static IntegratorJacobian *integrator_jacobian_create(IntegratorSystem *sys){
+	IntegratorJacobian *jac;
+
+	jac = ASC_NEW_CLEAR(IntegratorJacobian);
+	if(jac == NULL)return NULL;
+	jac->n = sys->n_y;
+	jac->y = sys->y;
+	jac->ydot = sys->ydot;
+	if(jac->n > 0){
+		jac->y_sindex = ASC_NEW_ARRAY(int,jac->n);
+		jac->ydot_sindex = ASC_NEW_ARRAY(int,jac->n);
+		if(jac->y_sindex == NULL || jac->ydot_sindex == NULL){
+			integrator_jacobian_destroy(jac);
+			return NULL;
+		}
+	}
+	return jac;
+}
+
+static void integrator_jacobian_destroy(IntegratorJacobian *jac){
+	if(jac == NULL)return;
+	if(jac->y_sindex != NULL)ASC_FREE(jac->y_sindex);
+	if(jac->ydot_sindex != NULL)ASC_FREE(jac->ydot_sindex);
+	if(jac->rhs != NULL)ASC_FREE(jac->rhs);
+	if(jac->solution != NULL)ASC_FREE(jac->solution);
+	ASC_FREE(jac);
+}
+
+int integrator_jacobian_reserve(IntegratorJacobian *jac, int32 capacity){
+	real64 *rhs, *solution;
+	asc_assert(jac != NULL);
+	if(capacity <= jac->capacity)return 0;
+	rhs = ASC_NEW_ARRAY_CLEAR(real64,capacity);
+	solution = ASC_NEW_ARRAY_CLEAR(real64,capacity);
+	if(rhs == NULL || solution == NULL){
+		if(rhs != NULL)ASC_FREE(rhs);
+		if(solution != NULL)ASC_FREE(solution);
+		return 1;
+	}
+	if(jac->rhs != NULL)ASC_FREE(jac->rhs);
+	if(jac->solution != NULL)ASC_FREE(jac->solution);
+	jac->rhs = rhs;
+	jac->solution = solution;
+	jac->capacity = capacity;
+	return 0;
+}
+
+void integrator_jacobian_begin(IntegratorJacobian *jac, linsolqr_system_t L){
+	int32 fallbacks;
+	int i;
+	asc_assert(jac != NULL);
+	jac->nsetups++;
+	for(i = 0; i < jac->n; ++i){
+		jac->y_sindex[i] = var_sindex(jac->y[i]);
+		jac->ydot_sindex[i] = (jac->ydot != NULL && jac->ydot[i] != NULL)
+			? var_sindex(jac->ydot[i]) : -1;
+	}
+	jac->L = L;
+	jac->refactors = 0;
+	if(L != NULL)linsolqr_refactor_stats(L, &(jac->refactors), &fallbacks);
+}
+
+void integrator_jacobian_end(IntegratorJacobian *jac){
+	int32 refactors = 0, fallbacks;
+	asc_assert(jac != NULL);
+	if(jac->L != NULL)linsolqr_refactor_stats(jac->L, &refactors, &fallbacks);
+	if(refactors > jac->refactors){
+		jac->nnumeric++;
+	}else{
+		jac->nfull++;
+	}
+	jac->L = NULL;
+}
+
+void integrator_jacobian_stats(const IntegratorSystem *sys
+	, unsigned long *setups, unsigned long *full, unsigned long *numeric
+){
+	asc_assert(sys != NULL);
+	*setups = *full = *numeric = 0;
+	if(sys->jacobian != NULL){
+		*setups = sys->jacobian->nsetups;
+		*full = sys->jacobian->nfull;
+		*numeric = sys->jacobian->nnumeric;
+	}
+}
+
+/*------------------------------------------------------------------------------
+  ALGEBRAIC SUB-SOLVE
+*/
+
+#define INTEGRATOR_DIRECT_TOL 1e-8
+
+/* largest ratio of successive Newton steps before a block is refactored */
+#define INTEGRATOR_CONTRACTION 0.3
+#define INTEGRATOR_NEWTON_MAXIT 10
+/* calls in a row failing block by block before the solver takes over */
+#define INTEGRATOR_BLOCKED_FAILS 3
+
+static void integrator_algebraic_free_blocks(IntegratorAlgebraic *alg){
+	int32 b;
+	for(b = 0; alg->blk != NULL && b < alg->nblk; ++b){
+		if(alg->blk[b].lsys != NULL){
+			linsolqr_set_matrix(alg->blk[b].lsys,NULL);
+			linsolqr_destroy(alg->blk[b].lsys);
+		}
+		if(alg->blk[b].mtx != NULL)mtx_destroy(alg->blk[b].mtx);
+		if(alg->blk[b].rhs != NULL)ASC_FREE(alg->blk[b].rhs);
+	}
+	if(alg->blk != NULL)ASC_FREE(alg->blk);
+	if(alg->rows != NULL)ASC_FREE(alg->rows);
+	if(alg->cols != NULL)ASC_FREE(alg->cols);
+	if(alg->mcol != NULL)ASC_FREE(alg->mcol);
+	if(alg->res != NULL)ASC_FREE(alg->res);
+	if(alg->grad != NULL)ASC_FREE(alg->grad);
+	if(alg->gmaster != NULL)ASC_FREE(alg->gmaster);
+	if(alg->gsolver != NULL)ASC_FREE(alg->gsolver);
+	alg->blk = NULL; alg->rows = NULL; alg->cols = NULL; alg->mcol = NULL;
+	alg->res = NULL; alg->grad = NULL; alg->gmaster = NULL; alg->gsolver = NULL;
+	alg->nblk = 0;
+	alg->is_blocked = 0;
+	alg->nfails = 0;
+}
+
+/**
+	Forget the structure and history of the last run, keeping the counters.
+*/
+static void integrator_algebraic_reset(IntegratorAlgebraic *alg){
+	integrator_algebraic_free_blocks(alg);
+	if(alg->brel != NULL)ASC_FREE(alg->brel);
+	if(alg->bvar != NULL)ASC_FREE(alg->bvar);
+	if(alg->z != NULL)ASC_FREE(alg->z);
+	if(alg->z0 != NULL)ASC_FREE(alg->z0);
+	if(alg->z1 != NULL)ASC_FREE(alg->z1);
+	alg->brel = NULL; alg->bvar = NULL;
+	alg->z = NULL; alg->z0 = NULL; alg->z1 = NULL;
+	alg->nblocks = 0;
+	alg->nz = 0;
+	alg->nhist = 0;
+	alg->analysed = 0;
+	alg->is_explicit = 0;
+	alg->needpresolve = 0;
+}
+
+/**
+	Set up the blocks of the solver's partition for integrator_algebraic_newton,
+	with a linear system for each block larger than 1x1. The relations and
+	variables are copied, as the solver may reorder its lists within the
+	blocks when it is next used. On failure alg->is_blocked stays 0.
+*/
+static void integrator_algebraic_blocks(IntegratorSystem *sys, IntegratorAlgebraic *alg
+		, const mtx_block_t *bl
+){
+	struct rel_relation **rl;
+	struct var_variable **vl;
+	IntegratorAlgBlock *b;
+	int32 k, c, n, nmax = 1, ninc = 1, nmaster;
+
+	rl = slv_get_solvers_rel_list(sys->system);
+	vl = slv_get_solvers_var_list(sys->system);
+	n = bl->block[bl->nblocks-1].row.high + 1;
+	nmaster = slv_get_num_master_vars(sys->system);
+
+	alg->blk = ASC_NEW_ARRAY_CLEAR(IntegratorAlgBlock,bl->nblocks);
+	alg->rows = ASC_NEW_ARRAY(struct rel_relation *,n);
+	alg->cols = ASC_NEW_ARRAY(struct var_variable *,n);
+	alg->mcol = ASC_NEW_ARRAY(int32,nmaster);
+	if(alg->blk == NULL || alg->rows == NULL || alg->cols == NULL || alg->mcol == NULL){
+		integrator_algebraic_free_blocks(alg);
+		return;
+	}
+	alg->nblk = bl->nblocks;
+	for(c = 0; c < nmaster; ++c)alg->mcol[c] = -1;
+	for(c = 0; c < n; ++c){
+		alg->rows[c] = rl[c];
+		alg->cols[c] = vl[c];
+		alg->mcol[var_mindex(vl[c])] = c;
+		ninc = MAX(ninc,rel_n_incidences(rl[c]));
+	}
+
+	for(k = 0; k < alg->nblk; ++k){
+		b = &(alg->blk[k]);
+		b->lo = bl->block[k].row.low;
+		b->n = bl->block[k].row.high - b->lo + 1;
+		nmax = MAX(nmax,b->n);
+		if(b->n == 1)continue;
+		b->mtx = mtx_create();
+		b->lsys = linsolqr_create();
+		b->rhs = ASC_NEW_ARRAY_CLEAR(real64,b->n);
+		if(b->mtx == NULL || b->lsys == NULL || b->rhs == NULL){
+			integrator_algebraic_free_blocks(alg);
+			return;
+		}
+		mtx_set_order(b->mtx,b->n);
+		linsolqr_set_matrix(b->lsys,b->mtx);
+		/* ranki_ba2 keeps its workspace in a global, so use kw2 */
+		linsolqr_prep(b->lsys,linsolqr_fmethod_to_fclass(ranki_kw2));
+		linsolqr_add_rhs(b->lsys,b->rhs,FALSE);
+	}
+
+	alg->res = ASC_NEW_ARRAY(real64,nmax);
+	alg->grad = ASC_NEW_ARRAY(real64,ninc);
+	alg->gmaster = ASC_NEW_ARRAY(int32,ninc);
+	alg->gsolver = ASC_NEW_ARRAY(int32,ninc);
+	if(alg->res == NULL || alg->grad == NULL || alg->gmaster == NULL
+		|| alg->gsolver == NULL
+	){
+		integrator_algebraic_free_blocks(alg);
+		return;
+	}
+	alg->is_blocked = 1;
+}
+
+/**
+	Residuals of the relations of block b into alg->res.
+	@return 0 if they could be calculated
+*/
+static int integrator_algebraic_residuals(IntegratorAlgebraic *alg
+		, IntegratorAlgBlock *b, int *converged
+){
+	int32 i, calc_ok;
+	*converged = 1;
+	for(i = 0; i < b->n; ++i){
+		calc_ok = 1;
+		alg->res[i] = relman_eval(alg->rows[b->lo + i],&calc_ok,1);
+		if(!calc_ok || !asc_finite(alg->res[i]))return 1;
+		if(fabs(alg->res[i]) > INTEGRATOR_DIRECT_TOL)*converged = 0;
+	}
+	return 0;
+}
+
+/**
+	Evaluate the Jacobian of block b at the present values and factor it.
+	@return 0 on success, 1 if it is singular or can't be calculated
+*/
+static int integrator_algebraic_factor(IntegratorAlgebraic *alg, IntegratorAlgBlock *b){
+	var_filter_t vf;
+	mtx_region_t reg;
+	mtx_coord_t coord;
+	real64 resid;
+	int32 i, k, count;
+
+	vf.matchbits = (VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE | VAR_FIXED);
+	vf.matchvalue = (VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE);
+	b->factored = 0;
+	alg->nfactors++;
+	b->pivot = 0;
+	if(b->n > 1)mtx_clear_region(b->mtx,mtx_ENTIRE_MATRIX);
+	for(i = 0; i < b->n; ++i){
+		/* its return value is not a status: look at the numbers instead */
+		relman_diff_grad(alg->rows[b->lo + i],&vf,alg->grad,alg->gmaster
+			,alg->gsolver,&count,&resid,1
+		);
+		coord.row = i;
+		for(k = 0; k < count; ++k){
+			coord.col = alg->mcol[alg->gmaster[k]] - b->lo;
+			if(coord.col < 0 || coord.col >= b->n)continue;
+			if(!asc_finite(alg->grad[k]))return 1;
+			if(b->n == 1)b->pivot = alg->grad[k];
+			else mtx_fill_org_value(b->mtx,&coord,alg->grad[k]);
+		}
+	}
+	if(b->n == 1){
+		if(b->pivot == 0 || !asc_finite(b->pivot))return 1;
+	}else{
+		mtx_region(&reg,0,b->n-1,0,b->n-1);
+		linsolqr_matrix_was_changed(b->lsys);
+		if(linsolqr_reorder(b->lsys,&reg,spk1))return 1;
+		if(linsolqr_factor(b->lsys,ranki_kw2))return 1;
+		if(linsolqr_rank(b->lsys) < b->n)return 1;
+	}
+	b->factored = 1;
+	return 0;
+}
+
+/**
+	Solve block b by a simplified Newton method: the factors from an
+	earlier call are used for as long as each step is at most
+	INTEGRATOR_CONTRACTION times the last, and the block is refactored at
+	the present point once they are not.
+
+	@return 0 on success, 1 on failure (the factors are then dropped)
+*/
+static int integrator_algebraic_block(IntegratorAlgebraic *alg, IntegratorAlgBlock *b){
+	struct var_variable *v;
+	real64 step, norm, last = -1, xn;
+	int32 i, it;
+	int converged, fresh = 0;
+
+	if(integrator_algebraic_residuals(alg,b,&converged))goto fail;
+	if(converged)return 0;
+	if(!b->factored){
+		if(integrator_algebraic_factor(alg,b))goto fail;
+		fresh = 1;
+	}
+	for(it = 0; it < INTEGRATOR_NEWTON_MAXIT; ++it){
+		if(b->n > 1){
+			for(i = 0; i < b->n; ++i)b->rhs[i] = -alg->res[i];
+			linsolqr_rhs_was_changed(b->lsys,b->rhs);
+			if(linsolqr_solve(b->lsys,b->rhs))goto fail;
+		}
+		norm = 0;
+		for(i = 0; i < b->n; ++i){
+			v = alg->cols[b->lo + i];
+			step = (b->n > 1) ? linsolqr_var_value(b->lsys,b->rhs,i)
+				: -alg->res[0] / b->pivot;
+			xn = var_value(v) + step;
+			if(xn < var_lower_bound(v))xn = var_lower_bound(v);
+			else if(xn > var_upper_bound(v))xn = var_upper_bound(v);
+			step = (xn - var_value(v)) / var_nominal(v);
+			norm += step * step;
+			var_set_value(v,xn);
+		}
+		norm = sqrt(norm);
+		if(integrator_algebraic_residuals(alg,b,&converged))goto fail;
+		if(converged)return 0;
+		if(last > 0 && norm > INTEGRATOR_CONTRACTION * last){
+			if(fresh){
+				/* not even contracting with a new Jacobian */
+				if(norm >= last)goto fail;
+			}else{
+				if(integrator_algebraic_factor(alg,b))goto fail;
+				fresh = 1;
+				last = -1;
+				continue;
+			}
+		}
+		last = norm;
+	}
+fail:
+	b->factored = 0;
+	return 1;
+}
+
+/**
+	Solve the blocks in order with their kept factors.
+	@return 0 on success, 1 if some block failed
+*/
+static int integrator_algebraic_newton(IntegratorAlgebraic *alg){
+	int32 k;
+	int res = 0;
+#ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
+#endif
+	for(k = 0; k < alg->nblk && !res; ++k){
+		res = integrator_algebraic_block(alg,&(alg->blk[k]));
+	}
+#ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalHandlerPop(SIGFPE,SIG_IGN);
+#endif
+	return res;
+}
+
+/**
+	Look at the system as partitioned by the solver's last presolve. Collect
+	the unknowns of the nonlinear system for the warm start, and decide
+	whether every block is one relation in one variable, in which case the
+	equations can be solved directly, one at a time, in block order.
+*/
+static void integrator_algebraic_analyse(IntegratorSystem *sys, IntegratorAlgebraic *alg){
+	const mtx_block_t *bl;
+	dof_t *dof;
+	struct rel_relation **rl;
+	struct var_variable **vl;
+	var_filter_t vf;
+	int32 b, c, nv;
+
+	alg->analysed = 1;
+	alg->is_explicit = 0;
+
+	vl = slv_get_solvers_var_list(sys->system);
+	nv = slv_get_num_solvers_vars(sys->system);
+	vf.matchbits = (VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE | VAR_FIXED);
+	vf.matchvalue = (VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE);
+	alg->nz = 0;
+	if(nv > 0){
+		alg->z = ASC_NEW_ARRAY(struct var_variable *,nv);
+		alg->z0 = ASC_NEW_ARRAY(real64,nv);
+		alg->z1 = ASC_NEW_ARRAY(real64,nv);
+		if(alg->z == NULL || alg->z0 == NULL || alg->z1 == NULL)return;
+		for(c = 0; c < nv; ++c){
+			if(var_apply_filter(vl[c],&vf))alg->z[alg->nz++] = vl[c];
+		}
+	}
+
+	/* conditional models may be re-partitioned at any time */
+	if(slv_get_num_solvers_whens(sys->system) > 0)return;
+
+	bl = slv_get_solvers_blocks(sys->system);
+	dof = slv_get_dofdata(sys->system);
+	if(bl == NULL || bl->nblocks <= 0 || dof == NULL)return;
+	/* variables left over (if under-specified) keep their values, as in the solver */
+	if(dof->structural_rank != dof->n_rows)return;
+	for(b = 0; b < bl->nblocks; ++b){
+		if(bl->block[b].row.low != bl->block[b].col.low
+			|| bl->block[b].row.high != bl->block[b].col.high
+			|| bl->block[b].row.low != (b ? bl->block[b-1].row.high + 1 : 0)
+		)return;
+	}
+	if(bl->block[bl->nblocks-1].row.high + 1 != dof->n_rows)return;
+	if(bl->nblocks != dof->n_rows){
+		integrator_algebraic_blocks(sys,alg,bl);
+		return;
+	}
+
+	alg->brel = ASC_NEW_ARRAY(struct rel_relation *,bl->nblocks);
+	alg->bvar = ASC_NEW_ARRAY(struct var_variable *,bl->nblocks);
+	if(alg->brel == NULL || alg->bvar == NULL)return;
+	rl = slv_get_solvers_rel_list(sys->system);
+	for(b = 0; b < bl->nblocks; ++b){
+		alg->brel[b] = rl[bl->block[b].row.low];
+		alg->bvar[b] = vl[bl->block[b].col.low];
+	}
+	alg->nblocks = bl->nblocks;
+	alg->is_explicit = 1;
+}
+
+/**
+	Solve each block for its variable in turn. Where a relation has more
+	than one root within the bounds, take the one nearest the variable's
+	present value, which is where Newton's method would most likely have
+	gone.
+
+	@return 0 on success, 1 if some relation could not be solved this way.
+*/
+static int integrator_algebraic_direct(IntegratorAlgebraic *alg){
+	struct var_variable *v;
+	real64 *slist, val, best = 0;
+	int32 b;
+	int able, nsolns, found, res = 0;
+
+#ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
+#endif
+	for(b = 0; b < alg->nblocks && !res; ++b){
+		v = alg->bvar[b];
+		slist = relman_directly_solve_new(alg->brel[b],v,&able,&nsolns
+			,INTEGRATOR_DIRECT_TOL
+		);
+		if(!able || slist == NULL){
+			res = 1;
+			break;
+		}
+		val = var_value(v);
+		found = 0;
+		while(--nsolns >= 0){
+			if(!asc_finite(slist[nsolns]))continue;
+			if(slist[nsolns] < var_lower_bound(v) || slist[nsolns] > var_upper_bound(v))continue;
+			if(!found || fabs(slist[nsolns] - val) < fabs(best - val)){
+				best = slist[nsolns];
+				found = 1;
+			}
+		}
+		if(!found){
+			res = 1;
+			break;
+		}
+		var_set_value(v,best);
+	}
+#ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalHandlerPop(SIGFPE,SIG_IGN);
+#endif
+	return res;
+}
+
+/**
+	Set the unknowns by linear extrapolation from the last two solved
+	points, within their bounds. The step is limited so that a bad
+	history can't throw the solver far from where it last converged.
+*/
+static void integrator_algebraic_extrapolate(IntegratorAlgebraic *alg, real64 t){
+	real64 s, val;
+	int32 i;
+
+	if(alg->nhist < 2 || alg->t1 == alg->t0 || t == alg->t1)return;
+	s = (t - alg->t1) / (alg->t1 - alg->t0);
+	if(s > 2.0)s = 2.0;
+	else if(s < -1.0)s = -1.0;
+	for(i = 0; i < alg->nz; ++i){
+		val = alg->z1[i] + s * (alg->z1[i] - alg->z0[i]);
+		if(val < var_lower_bound(alg->z[i]))val = var_lower_bound(alg->z[i]);
+		else if(val > var_upper_bound(alg->z[i]))val = var_upper_bound(alg->z[i]);
+		var_set_value(alg->z[i],val);
+	}
+}
+
+/**
+	Record the solved unknowns at t. Repeated calls at the same t (as when
+	a corrector iterates) replace the last point rather than adding one.
+*/
+static void integrator_algebraic_record(IntegratorAlgebraic *alg, real64 t){
+	real64 *tmp;
+	int32 i;
+
+	if(alg->z1 == NULL)return;
+	if(alg->nhist == 0 || t != alg->t1){
+		tmp = alg->z0; alg->z0 = alg->z1; alg->z1 = tmp;
+		alg->t0 = alg->t1;
+		alg->t1 = t;
+		if(alg->nhist < 2)alg->nhist++;
+	}
+	for(i = 0; i < alg->nz; ++i){
+		alg->z1[i] = var_value(alg->z[i]);
+	}
+}
+
+int integrator_solve_algebraic(IntegratorSystem *sys, int restart){
+	IntegratorAlgebraic *alg;
+	slv_status_t status;
+	real64 t;
+	int res;
+
+	asc_assert(sys != NULL);
+	alg = sys->algebraic;
+	asc_assert(alg != NULL);
+	alg->ncalls++;
+	if(restart)alg->needpresolve = 1;
+
+	if(alg->is_explicit){
+		if(!integrator_algebraic_direct(alg)){
+			alg->nexplicit++;
+			return 0;
+		}
+		ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Unable to solve the derivative"
+			" equations directly; using the solver from now on"
+		);
+		alg->is_explicit = 0;
+		alg->needpresolve = 1;
+	}
+
+	t = (sys->x != NULL) ? var_value(sys->x) : 0;
+	if(alg->is_blocked){
+		integrator_algebraic_extrapolate(alg,t);
+		if(!integrator_algebraic_newton(alg)){
+			alg->nblocked++;
+			alg->nfails = 0;
+			integrator_algebraic_record(alg,t);
+			return 0;
+		}
+		if(++alg->nfails >= INTEGRATOR_BLOCKED_FAILS){
+			ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Unable to solve the derivative"
+				" equations block by block; using the solver from now on"
+			);
+			integrator_algebraic_free_blocks(alg);
+		}
+	}
+
+	if(!alg->analysed || alg->needpresolve){
+		slv_presolve(sys->system);
+		alg->needpresolve = 0;
+	}else{
+		integrator_algebraic_extrapolate(alg,t);
+		slv_resolve(sys->system);
+	}
+	if((res = slv_solve(sys->system))){
+		CONSOLE_DEBUG("solver returns error %d",res);
+	}
+	slv_get_status(sys->system,&status);
+	alg->nsolves++;
+	alg->niterations += status.iteration;
+
+	res = integrator_checkstatus(status);
+	if(res){
+		alg->nfailed++;
+		return res;
+	}
+	if(!alg->analysed)integrator_algebraic_analyse(sys,alg);
+	integrator_algebraic_record(alg,t);
+	return 0;
+}
+
+void integrator_algebraic_factor_stats(const IntegratorSystem *sys
+	, unsigned long *blocked_calls, unsigned long *factors
+){
+	asc_assert(sys != NULL);
+	*blocked_calls = *factors = 0;
+	if(sys->algebraic != NULL){
+		*blocked_calls = sys->algebraic->nblocked;
+		*factors = sys->algebraic->nfactors;
+	}
+}
+
+void integrator_algebraic_stats(const IntegratorSystem *sys
+	, unsigned long *calls, unsigned long *explicit_calls
+	, unsigned long *iterations
+){
+	asc_assert(sys != NULL);
+	*calls = *explicit_calls = *iterations = 0;
+	if(sys->algebraic != NULL){
+		*calls = sys->algebraic->ncalls;
+		*explicit_calls = sys->algebraic->nexplicit;
+		*iterations = sys->algebraic->niterations;
+	}
 }
 
 /*---------------------------------------------------------------
@@ -1445,9 +2109,13 @@ int integrator_output_init(IntegratorSystem *sys){
 
 int integrator_output_write(IntegratorSystem *sys){
 	static int reported_already=0;
+	int res;
 	asc_assert(sys!=NULL);
 	if(sys->reporter->write!=NULL){
-		return (*(sys->reporter->write))(sys);
+		/* the reporter may have written to the model */
+		res = (*(sys->reporter->write))(sys);
+		slv_var_store_sync(sys->system);
+		return res;
 	}
 	if(!reported_already){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"No integrator reporter write method (this message only shown once)");
@@ -1458,9 +2126,13 @@ int integrator_output_write(IntegratorSystem *sys){
 
 int integrator_output_write_obs(IntegratorSystem *sys){
 	static int reported_already=0;
+	int res;
 	asc_assert(sys!=NULL);
 	if(sys->reporter->write_obs!=NULL){
-		return (*(sys->reporter->write_obs))(sys);
+		/* the reporter may have written to the model */
+		res = (*(sys->reporter->write_obs))(sys);
+		slv_var_store_sync(sys->system);
+		return res;
 	}
 	if(!reported_already){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"No integrator reporter write_obs method (this message only shown once)");
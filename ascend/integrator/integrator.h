@@ -28,6 +28,17 @@
 
 	There's nothing here yet to explicitly support DAEs -- that's the next task.
 
+	Threads: integrator_solve may be called for distinct IntegratorSystems
+	(of distinct simulations) on separate threads at once, with any of the
+	engines. The Fortran COMMON blocks of LSODE and RADAU5 are
+	threadprivate, and LSODE keeps its copy in the IntegratorSystem between
+	calls.
+	Everything else here, in particular integrator_new and
+	integrator_analyse, and the compiler itself, must be used from one
+	thread at a time. Off the thread that called Asc_SignalInit,
+	floating-point errors are not trapped but found from the exception
+	flags, with Asc_SignalFPECheck (see ascSignal.h).
+
 	(old annotation:)
 	The following functions fetch and set parts with names specific to
 	the type definitions in ivp.lib, the ASCEND initial value problem
@@ -62,6 +73,7 @@
 #include <ascend/compiler/atomvalue.h>
 
 #include <ascend/linear/mtx.h>
+#include <ascend/linear/linsolqr.h>
 
 #include <ascend/system/slv_client.h>
 
@@ -224,6 +236,100 @@ typedef struct IntegratorInternalsStruct{
 	const char *name;
 } IntegratorInternals;
 
+/*------------------------------------*/
+/**
+	Persistent Jacobian workspace, shared by the integration engines. It is
+	built by integrator_analyse once the states and derivatives are known,
+	and lives until integrator_free, so that engines evaluating and
+	factoring a Jacobian on every setup call need not rebuild their index
+	maps or reallocate their scratch vectors each time.
+
+	The engines keep their matrices frozen (mtx_freeze) once the sparsity
+	pattern is known, and linsolqr replays the pivot sequence of the last
+	full factorisation where it can (linsolqr_set_pivot_reuse), so most
+	setups are numeric-only refactorisations. The counters record how
+	often that works; see integrator_jacobian_begin/end.
+*/
+typedef struct IntegratorJacobianStruct{
+	int n;                /**< number of states, n_y */
+	struct var_variable **y;    /**< the states (the IntegratorSystem's) */
+	struct var_variable **ydot; /**< their derivatives, or NULL */
+	int *y_sindex;        /**< solver's var index (var_sindex) of each state */
+	int *ydot_sindex;     /**< solver's var index of each derivative, or -1 */
+	int32 capacity;       /**< length of rhs and solution */
+	real64 *rhs;          /**< scratch right-hand side */
+	real64 *solution;     /**< scratch solution */
+
+	linsolqr_system_t L;  /**< linear system of the setup in progress */
+	int32 refactors;      /**< its replay count when the setup began */
+
+	unsigned long nsetups;   /**< Jacobian setups (evaluate and factor) */
+	unsigned long nfull;     /**< factorisations with a full pivot search */
+	unsigned long nnumeric;  /**< numeric-only refactorisations */
+} IntegratorJacobian;
+
+/*------------------------------------*/
+/**
+	State of the algebraic sub-solve done by the engines on each call of
+	their right-hand side function (see integrator_solve_algebraic). It is
+	built by integrator_analyse and reset at the start of each
+	integrator_solve.
+
+	If the solver's block partitioning shows every equation to be in a
+	block of its own, the derivatives and algebraic variables are explicit
+	functions of the states and are found by solving each relation
+	directly, in block order. Otherwise the blocks are solved in turn by
+	a simplified Newton method, with the LU factors of each block's
+	Jacobian kept from one call to the next; a block is refactored only
+	when its iterations stop contracting quickly. The unknowns are first
+	extrapolated from their values at the last two points where the
+	system was solved. The nonlinear solver takes any call where that
+	fails.
+*/
+typedef struct IntegratorAlgBlockStruct{
+	int32 lo;             /**< first row and column of the block in rows and cols */
+	int32 n;              /**< size of the block */
+	int factored;         /**< the factors are those of a recent Jacobian */
+	real64 pivot;         /**< the Jacobian, if n is 1 */
+	mtx_matrix_t mtx;     /**< the Jacobian, if n > 1, in org rows and cols 0..n-1 */
+	linsolqr_system_t lsys; /**< its factors */
+	real64 *rhs;          /**< right-hand side and solution for lsys */
+} IntegratorAlgBlock;
+
+typedef struct IntegratorAlgebraicStruct{
+	int analysed;         /**< structure has been looked at since the last reset */
+	int is_explicit;      /**< solve block by block rather than with the solver */
+	int needpresolve;     /**< next solver call must presolve, not resolve */
+
+	int32 nblocks;        /**< number of (1x1) blocks, if is_explicit */
+	struct rel_relation **brel; /**< relation of each block, in solving order */
+	struct var_variable **bvar; /**< variable of each block */
+
+	int is_blocked;       /**< solve block by block with kept factors */
+	int nfails;           /**< calls in a row where that failed */
+	int32 nblk;           /**< number of blocks, if is_blocked */
+	IntegratorAlgBlock *blk; /**< the blocks, in solving order */
+	struct rel_relation **rows; /**< the relations of the blocks */
+	struct var_variable **cols; /**< the variables assigned to them */
+	int32 *mcol;          /**< index in cols of each master var, or -1 */
+	real64 *res, *grad;   /**< scratch: residuals of a block, a gradient */
+	int32 *gmaster, *gsolver; /**< scratch: var indices of the gradient */
+
+	int32 nz;             /**< number of unknowns of the nonlinear system */
+	struct var_variable **z; /**< the unknowns */
+	real64 *z0, *z1;      /**< their values at the last two solved points */
+	real64 t0, t1;        /**< independent variable at those points */
+	int nhist;            /**< how many of those points are recorded (0..2) */
+
+	unsigned long ncalls;      /**< calls of integrator_solve_algebraic */
+	unsigned long nexplicit;   /**< calls done block by block */
+	unsigned long nsolves;     /**< calls that used the nonlinear solver */
+	unsigned long niterations; /**< total iterations of the solver in those */
+	unsigned long nfailed;     /**< calls that did not converge */
+	unsigned long nblocked;    /**< calls done block by block with kept factors */
+	unsigned long nfactors;    /**< block factorisations in those */
+} IntegratorAlgebraic;
+
 /*------------------------------------*/
 /**
 	Initial Value Problem description struct. Anyone making a copy of
@@ -270,6 +376,8 @@ struct IntegratorSystemStruct{
   int n_obs;
   int n_diffeqs;              /**< number of differential equations (used by idaanalyse) */
   int currentstep;            /**< current step number (also @see integrator_getnsamples) */
+  IntegratorJacobian *jacobian;/**< persistent Jacobian workspace, built by integrator_analyse */
+  IntegratorAlgebraic *algebraic;/**< state of the algebraic sub-solve, built by integrator_analyse */
 
   /** @TODO move the following to the 'params' structure? Or maybe better not to? */
   int maxsubsteps;            /**< most steps between mesh poins */
@@ -305,6 +413,8 @@ ASC_DLLSPEC int integrator_solve(IntegratorSystem *blsys, long i0, long i1);
 	Takes the type of integrator and sets up the global variables into the
 	current integration instance.
 
+	Safe to call for different blsys on different threads; see above.
+
 	@return 0 on success, else error
 */
 
@@ -327,6 +437,81 @@ ASC_DLLSPEC void integrator_free(IntegratorSystem *blsys);
 	Deallocates any memory used and sets all integration global points to NULL.
 */
 
+ASC_DLLSPEC void integrator_jacobian_stats(const IntegratorSystem *blsys
+	, unsigned long *setups, unsigned long *full, unsigned long *numeric
+);
+/**<
+	Report the Jacobian setups done since integrator_analyse, and how many
+	of the factorisations needed a full pivot search versus how many were
+	numeric-only refactorisations in the recorded pivot order. A setup
+	that failed before factoring counts in neither, so full + numeric may
+	be less than setups. All three are 0 if the system was not analysed.
+*/
+
+ASC_DLLSPEC int integrator_jacobian_reserve(IntegratorJacobian *jac, int32 capacity);
+/**<
+	Make sure the rhs and solution vectors of the workspace hold at least
+	capacity values; they keep their size (and contents) otherwise.
+	@return 0 on success, 1 if memory ran out.
+*/
+
+ASC_DLLSPEC void integrator_jacobian_begin(IntegratorJacobian *jac, linsolqr_system_t L);
+/**<
+	Called by an engine when it starts a Jacobian setup that will be
+	factored with L. Counts the setup, and brings y_sindex and ydot_sindex
+	up to date: the solver reorders its var list when it presolves, which
+	may happen during the integration.
+*/
+
+ASC_DLLSPEC void integrator_jacobian_end(IntegratorJacobian *jac);
+/**<
+	Called after the factorisation of the setup begun with
+	integrator_jacobian_begin succeeded, to count it as a full or a
+	numeric-only factorisation.
+*/
+
+ASC_DLLSPEC int integrator_solve_algebraic(IntegratorSystem *blsys, int restart);
+/**<
+	Solve the algebraic equations for the derivatives (and any algebraic
+	variables) at the independent variable and states already set with
+	integrator_set_t and integrator_set_y. This is the common body of the
+	engines' right-hand side functions.
+
+	The first call after integrator_solve starts uses the nonlinear solver
+	from scratch, and then looks at the block structure to see whether the
+	equations can be solved directly in later calls. Should a direct solve
+	fail, the solver is used from then on. If they can't be solved
+	directly, later calls solve the blocks with the factors kept from
+	earlier calls (see IntegratorAlgebraic), using the solver for any call
+	where that fails, and from then on if it fails repeatedly.
+
+	@param restart nonzero if the solver must be presolved rather than
+		resolved, eg because the engine has changed the system since the
+		last call.
+	@return 0 on success, else as integrator_checkstatus.
+*/
+
+ASC_DLLSPEC void integrator_algebraic_stats(const IntegratorSystem *blsys
+	, unsigned long *calls, unsigned long *explicit_calls
+	, unsigned long *iterations
+);
+/**<
+	Report the calls of integrator_solve_algebraic since integrator_analyse,
+	how many of them were done by direct solution, and the total number of
+	iterations of the nonlinear solver in the rest. All three are 0 if the
+	system was not analysed.
+*/
+
+ASC_DLLSPEC void integrator_algebraic_factor_stats(const IntegratorSystem *blsys
+	, unsigned long *blocked_calls, unsigned long *factors
+);
+/**<
+	Report how many calls of integrator_solve_algebraic since
+	integrator_analyse were done block by block with kept factors, and how
+	many block factorisations they took. Both are 0 if the system was not
+	analysed.
+*/
+
 ASC_DLLSPEC const struct gl_list_t *integrator_get_engines();
 /**<
 	Return a {INTEG_UNKNOWN,NULL} terminated list of integrator currently
@@ -418,13 +418,148 @@ static void test_integ1(){
 }
 
 
+/* index of an IDA parameter, found by name */
+static int test_ida_param(slv_parameters_t *p, const char *name){
+	int i;
+	for(i = 0; i < p->num_parms; ++i){
+		if(0 == strcmp(p->parms[i].name,name))return i;
+	}
+	CONSOLE_DEBUG("No parameter '%s'",name);
+	CU_FAIL(parameter not found);
+	return -1;
+}
+
+/* HIRES reference solution at t = 321.8122, see models/test/hires.a4c */
+static const double hires_y[8] = {
+	0.7371312573325668e-3, 0.1442485726316185e-3
+	, 0.5888729740967575e-4, 0.1175651343283149e-2
+	, 0.2386356198831331e-2, 0.6238968252742796e-2
+	, 0.2849998395185769e-2, 0.2850001604814231e-2
+};
+
+/*
+	Integrate the HIRES problem with the given IDA linear solver, returning
+	the final states, and the Jacobian setups done in the workspace shared
+	with the ASCEND sparse solver (none for the others).
+*/
+static void test_ida_hires(const char *linsolver, double *y, unsigned long *setups){
+	unsigned long full, numeric;
+	slv_parameters_t p;
+	int i;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/ida");
+
+	{
+		int status;
+		Asc_OpenModule("test/hires.a4c", &status);
+		CU_ASSERT_FATAL(status == 0);
+	}
+	CU_ASSERT(0 == zz_parse());
+
+	struct Instance *siminst = SimsCreateInstance(AddSymbol("hires"),
+		AddSymbol("sim1"), e_normal, NULL
+	);
+	CU_ASSERT_FATAL(siminst!=NULL);
+
+	struct Name *name = CreateIdName(AddSymbol("on_load"));
+	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst), name, "sim1",
+		ASCERR, WP_STOPONERR, NULL, NULL
+	);
+	CU_ASSERT(pe==Proc_all_ok);
+
+	slv_system_t sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+
+	IntegratorSystem *integ = integrator_new(sys,siminst);
+	if(0 != integrator_set_engine(integ,"IDA")){
+		system_destroy(sys);
+		solver_destroy_engines();
+		integrator_free_engines();
+		sim_destroy(siminst);
+		Asc_CompilerDestroy();
+		CU_FAIL_FATAL("integrator_set_engine(integ,\"IDA\") failed");
+	}
+
+	/* tight enough for the two linear solvers to agree closely */
+	CU_ASSERT(0 == integrator_params_get(integ,&p));
+	if((i = test_ida_param(&p,"linsolver")) >= 0){
+		slv_set_char_parameter(&(SLV_PARAM_CHAR(&p,i)),linsolver);
+	}
+	if((i = test_ida_param(&p,"atolvect")) >= 0)SLV_PARAM_BOOL(&p,i) = 0;
+	if((i = test_ida_param(&p,"atol")) >= 0)SLV_PARAM_REAL(&p,i) = 1e-12;
+	if((i = test_ida_param(&p,"rtol")) >= 0)SLV_PARAM_REAL(&p,i) = 1e-9;
+	CU_ASSERT(0 == integrator_params_set(integ,&p));
+
+	CU_ASSERT_FATAL(0 == integrator_analyse(integ));
+	CU_ASSERT_FATAL(integ->n_y == 8);
+
+	integrator_set_reporter(integ, &test_ida_reporter);
+	integrator_set_minstep(integ, 0);
+	integrator_set_maxstep(integ, 0);
+	integrator_set_stepzero(integ, 1e-6);
+	integrator_set_maxsubsteps(integ, 5000);
+
+	dim_type d;
+	SetDimFraction(d,D_TIME,CreateFraction(1,1));
+	SampleList *samplelist = samplelist_new(2, &d);
+	samplelist_set(samplelist, 0, 0);
+	samplelist_set(samplelist, 1, 321.8122);
+	integrator_set_samples(integ, samplelist);
+
+	CU_ASSERT(0 == integrator_solve(integ, 0, samplelist_length(samplelist)-1));
+
+	/* the states are in order of ode_id */
+	for(i = 0; i < 8; ++i){
+		y[i] = var_value(integ->y[i]);
+	}
+	integrator_jacobian_stats(integ, setups, &full, &numeric);
+	CONSOLE_DEBUG("%s: %lu Jacobian setups, %lu full and %lu numeric factorisations"
+		,linsolver, *setups, full, numeric
+	);
+
+	integrator_free(integ);
+	samplelist_free(samplelist);
+	system_destroy(sys);
+	system_free_reused_mem();
+
+	solver_destroy_engines();
+	integrator_free_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/*
+	The ASCEND sparse linear solver (idalinear.c) gives the same answer as
+	IDA's dense one, on a problem with a sparse and stiff Jacobian.
+*/
+static void test_sparse(){
+	double ydense[8], ysparse[8];
+	unsigned long setups_dense, setups_sparse;
+	int i;
+
+	test_ida_hires("DENSE", ydense, &setups_dense);
+	test_ida_hires("ASCEND", ysparse, &setups_sparse);
+
+	CU_TEST(setups_dense == 0);
+	CU_TEST(setups_sparse > 0);
+
+	for(i = 0; i < 8; ++i){
+		CU_TEST(fabs(ysparse[i] - ydense[i]) <= 1e-6 * hires_y[i]);
+		CU_TEST(fabs(ydense[i] - hires_y[i]) <= 1e-4 * hires_y[i]);
+		CU_TEST(fabs(ysparse[i] - hires_y[i]) <= 1e-4 * hires_y[i]);
+	}
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T) \
 	T(shm) \
 	T(boundary) \
-	T(integ1)
+	T(integ1) \
+	T(sparse)
 
 REGISTER_TESTS_SIMPLE(integrator_ida, TESTS)
 
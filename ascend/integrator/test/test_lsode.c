@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #include <ascend/general/env.h>
 #include <ascend/general/ospath.h>
@@ -8,6 +9,7 @@
 #include <ascend/general/ltmatrix.h>
 
 #include <ascend/general/platform.h>
+#include <ascend/general/config.h>
 #include <ascend/utilities/ascEnvVar.h>
 #include <ascend/utilities/error.h>
 
@@ -45,6 +47,10 @@
 
 #include <test/common.h>
 
+#ifdef ASC_HAVE_PTHREADS
+# include <pthread.h>
+#endif
+
 /* a simple integrator reporter for testing */
 static int test_lsode_reporter_init(struct IntegratorSystemStruct *integ){
 	return 0;
@@ -180,11 +186,406 @@ static void test_bounds(){
 	Asc_CompilerDestroy();
 }
 
+/*
+	Test normal completion of LSODE, on the same model without the bound.
+	The derivative is an explicit function of the independent variable, so
+	after the first call the derivative equation should be solved directly
+	rather than with QRSlv.
+*/
+static void test_normal(){
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv" OSPATH_DIV "solvers/lsode"));
+	CU_TEST_FATAL(0 == package_load("qrslv",NULL));
+
+	{
+		int status;
+		Asc_OpenModule("test/lsode/bounds.a4c",&status);
+		CU_ASSERT_FATAL(status == 0);
+	}
+	CU_ASSERT(0 == zz_parse());
+	CU_ASSERT(FindType(AddSymbol("bounds"))!=NULL);
+
+	struct Instance *siminst = SimsCreateInstance(AddSymbol("bounds"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst!=NULL);
+
+	struct Name *name = CreateIdName(AddSymbol("on_load"));
+	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst),name,"sim1", ASCERR, WP_STOPONERR, NULL, NULL);
+	CU_ASSERT(pe==Proc_all_ok);
+
+	int index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(index != -1);
+	slv_system_t sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,index));
+
+	IntegratorSystem *integ = integrator_new(sys,siminst);
+	CU_ASSERT_FATAL(0 == integrator_set_engine(integ,"LSODE"));
+	CU_ASSERT_FATAL(0 == integrator_analyse(integ));
+
+	integrator_set_reporter(integ, &test_lsode_reporter);
+	integrator_set_minstep(integ,0);
+	integrator_set_maxstep(integ,0);
+	integrator_set_stepzero(integ,0);
+	integrator_set_maxsubsteps(integ,0);
+
+	dim_type d;
+	SetDimFraction(d,D_TIME,CreateFraction(1,1));
+	int num = 20;
+	SampleList *samplelist = samplelist_new(num+1, &d);
+	unsigned long i;
+	for(i=0; i<=num; ++i){
+		samplelist_set(samplelist,i,10.0*i/num);
+	}
+	integrator_set_samples(integ,samplelist);
+
+	CU_ASSERT(0 == integrator_solve(integ, 0, samplelist_length(samplelist)-1));
+
+	/* x = t^2/2 */
+	CU_ASSERT_DOUBLE_EQUAL(var_value(integ->x), 10.0, 1e-8);
+	CU_ASSERT_DOUBLE_EQUAL(var_value(integ->y[0]), 50.0, 1e-3);
+
+	unsigned long calls, explicit_calls, iterations;
+	integrator_algebraic_stats(integ, &calls, &explicit_calls, &iterations);
+	CONSOLE_DEBUG("%lu RHS calls, %lu direct, %lu solver iterations",calls,explicit_calls,iterations);
+	CU_ASSERT(calls > 1);
+	CU_ASSERT(explicit_calls == calls - 1);
+
+	integrator_free(integ);
+	samplelist_free(samplelist);
+	system_destroy(sys);
+	system_free_reused_mem();
+
+	solver_destroy_engines();
+	integrator_free_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/*
+	The derivative comes from a 2x2 nonlinear block. After the first call
+	the block should be solved with the factors kept from earlier calls,
+	so there are fewer factorisations than right-hand side evaluations.
+*/
+static void test_implicit(){
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv" OSPATH_DIV "solvers/lsode"));
+	CU_TEST_FATAL(0 == package_load("qrslv",NULL));
+
+	{
+		int status;
+		Asc_OpenModule("test/lsode/implicit.a4c",&status);
+		CU_ASSERT_FATAL(status == 0);
+	}
+	CU_ASSERT(0 == zz_parse());
+	CU_ASSERT(FindType(AddSymbol("implicit"))!=NULL);
+
+	struct Instance *siminst = SimsCreateInstance(AddSymbol("implicit"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst!=NULL);
+
+	struct Name *name = CreateIdName(AddSymbol("on_load"));
+	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst),name,"sim1", ASCERR, WP_STOPONERR, NULL, NULL);
+	CU_ASSERT(pe==Proc_all_ok);
+
+	int index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(index != -1);
+	slv_system_t sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,index));
+
+	IntegratorSystem *integ = integrator_new(sys,GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(0 == integrator_set_engine(integ,"LSODE"));
+	CU_ASSERT_FATAL(0 == integrator_analyse(integ));
+
+	integrator_set_reporter(integ, &test_lsode_reporter);
+	integrator_set_minstep(integ,0);
+	integrator_set_maxstep(integ,0);
+	integrator_set_stepzero(integ,0);
+	integrator_set_maxsubsteps(integ,0);
+
+	dim_type d;
+	SetDimFraction(d,D_TIME,CreateFraction(1,1));
+	int num = 10;
+	SampleList *samplelist = samplelist_new(num+1, &d);
+	unsigned long i;
+	for(i=0; i<=num; ++i){
+		samplelist_set(samplelist,i,5.0*i/num);
+	}
+	integrator_set_samples(integ,samplelist);
+
+	CU_ASSERT(0 == integrator_solve(integ, 0, samplelist_length(samplelist)-1));
+	CU_ASSERT_DOUBLE_EQUAL(var_value(integ->x), 5.0, 1e-8);
+
+	/* b stays close to 1, so y is close to 0.1 + 0.9*exp(-t) */
+	struct Instance *inst;
+	double y, a, b;
+	y = var_value(integ->y[0]);
+	inst = ChildByChar(GetSimulationRoot(siminst),AddSymbol("a"));
+	CU_ASSERT_FATAL(inst != NULL);
+	a = RealAtomValue(inst);
+	inst = ChildByChar(GetSimulationRoot(siminst),AddSymbol("b"));
+	CU_ASSERT_FATAL(inst != NULL);
+	b = RealAtomValue(inst);
+	CONSOLE_DEBUG("y = %g, a = %g, b = %g",y,a,b);
+	CU_ASSERT_DOUBLE_EQUAL(y, 0.1 + 0.9*exp(-5.0), 1e-3);
+	CU_ASSERT_DOUBLE_EQUAL(b + 0.1*a*a*a, 1.0, 1e-6);
+
+	unsigned long calls, explicit_calls, iterations, blocked_calls, factors;
+	integrator_algebraic_stats(integ, &calls, &explicit_calls, &iterations);
+	integrator_algebraic_factor_stats(integ, &blocked_calls, &factors);
+	CONSOLE_DEBUG("%lu RHS calls, %lu block by block with %lu factorisations"
+		,calls,blocked_calls,factors
+	);
+	CU_ASSERT(blocked_calls > 0);
+	CU_ASSERT(blocked_calls >= calls - 1);
+	CU_ASSERT(factors < blocked_calls);
+
+	integrator_free(integ);
+	samplelist_free(samplelist);
+	system_destroy(sys);
+	system_free_reused_mem();
+
+	solver_destroy_engines();
+	integrator_free_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/* integrate 'jacobian' from t = 0 to 1, returning y1 and y2 at the end */
+static void test_jacobian_run(struct Instance *siminst, IntegratorSystem *integ
+		, SampleList *samplelist, double *y
+){
+	struct Name *name = CreateIdName(AddSymbol("values"));
+	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst),name,"sim1", ASCERR, WP_STOPONERR, NULL, NULL);
+	CU_ASSERT(pe==Proc_all_ok);
+	CU_ASSERT(0 == integrator_solve(integ, 0, samplelist_length(samplelist)-1));
+	CU_ASSERT_DOUBLE_EQUAL(var_value(integ->x), 1.0, 1e-8);
+	y[0] = var_value(integ->y[0]);
+	y[1] = var_value(integ->y[1]);
+}
+
+static IntegratorSystem *test_jacobian_new(slv_system_t sys, struct Instance *siminst
+		, SampleList *samplelist
+){
+	IntegratorSystem *integ = integrator_new(sys,siminst);
+	CU_ASSERT_FATAL(0 == integrator_set_engine(integ,"LSODE"));
+	CU_ASSERT_FATAL(0 == integrator_analyse(integ));
+	CU_ASSERT_FATAL(integ->n_y == 2 && integ->jacobian != NULL);
+	integrator_set_reporter(integ, &test_lsode_reporter);
+	integrator_set_minstep(integ,0);
+	integrator_set_maxstep(integ,0);
+	integrator_set_stepzero(integ,0);
+	integrator_set_maxsubsteps(integ,0);
+	integrator_set_samples(integ,samplelist);
+	return integ;
+}
+
+/*
+	A second integration with the same IntegratorSystem keeps its Jacobian
+	workspace, refactors in the recorded pivot order, and gives the same
+	numbers as a newly analysed IntegratorSystem.
+*/
+static void test_jacobian(){
+	IntegratorSystem *integ;
+	IntegratorJacobian *jac;
+	real64 *rhs;
+	unsigned long setups1, full1, numeric1, setups2, full2, numeric2;
+	double y1[2], y2[2], y3[2];
+	dim_type d;
+	int i, num = 10;
+
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv" OSPATH_DIV "solvers/lsode"));
+	CU_TEST_FATAL(0 == package_load("qrslv",NULL));
+
+	{
+		int status;
+		Asc_OpenModule("test/lsode/jacobian.a4c",&status);
+		CU_ASSERT_FATAL(status == 0);
+	}
+	CU_ASSERT(0 == zz_parse());
+
+	struct Instance *siminst = SimsCreateInstance(AddSymbol("jacobian"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst!=NULL);
+	struct Name *name = CreateIdName(AddSymbol("on_load"));
+	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst),name,"sim1", ASCERR, WP_STOPONERR, NULL, NULL);
+	CU_ASSERT(pe==Proc_all_ok);
+
+	int index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(index != -1);
+	slv_system_t sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,index));
+
+	SetDimFraction(d,D_TIME,CreateFraction(1,1));
+	SampleList *samplelist = samplelist_new(num+1, &d);
+	for(i=0; i<=num; ++i){
+		samplelist_set(samplelist,i,1.0*i/num);
+	}
+
+	integ = test_jacobian_new(sys,siminst,samplelist);
+	test_jacobian_run(siminst,integ,samplelist,y1);
+	integrator_jacobian_stats(integ,&setups1,&full1,&numeric1);
+	CONSOLE_DEBUG("%lu setups, %lu full and %lu numeric factorisations",setups1,full1,numeric1);
+	CU_ASSERT(setups1 > 1);
+	CU_ASSERT(numeric1 > 0);
+	jac = integ->jacobian;
+	rhs = jac->rhs;
+	CU_ASSERT(rhs != NULL);
+
+	/* y2 = exp(-t), y1 = (exp(-t) + 998*exp(-1000*t))/999 */
+	CU_ASSERT_DOUBLE_EQUAL(y1[0], exp(-1.0)/999, 1e-5);
+	CU_ASSERT_DOUBLE_EQUAL(y1[1], exp(-1.0), 1e-3);
+
+	/* again, in the same workspace, with no new full factorisation */
+	test_jacobian_run(siminst,integ,samplelist,y2);
+	integrator_jacobian_stats(integ,&setups2,&full2,&numeric2);
+	CU_ASSERT(integ->jacobian == jac);
+	CU_ASSERT(jac->rhs == rhs);
+	CU_ASSERT(setups2 == 2*setups1);
+	CU_ASSERT(full2 == full1);
+	CU_ASSERT(numeric2 == numeric1 + setups1);
+	CU_ASSERT_DOUBLE_EQUAL(y2[0], y1[0], 1e-12);
+	CU_ASSERT_DOUBLE_EQUAL(y2[1], y1[1], 1e-12);
+	integrator_free(integ);
+
+	/* and from scratch */
+	integ = test_jacobian_new(sys,siminst,samplelist);
+	test_jacobian_run(siminst,integ,samplelist,y3);
+	CU_ASSERT_DOUBLE_EQUAL(y3[0], y1[0], 1e-12);
+	CU_ASSERT_DOUBLE_EQUAL(y3[1], y1[1], 1e-12);
+	integrator_free(integ);
+
+	samplelist_free(samplelist);
+	system_destroy(sys);
+	system_free_reused_mem();
+
+	solver_destroy_engines();
+	integrator_free_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+#ifdef ASC_HAVE_PTHREADS
+
+#define NSIMS 2
+
+struct test_lsode_thread{
+	IntegratorSystem *integ;
+	SampleList *samplelist;
+	int res;
+};
+
+static void *test_lsode_thread_main(void *arg){
+	struct test_lsode_thread *t = (struct test_lsode_thread *)arg;
+	t->res = integrator_solve(t->integ, 0, samplelist_length(t->samplelist)-1);
+	return NULL;
+}
+
+/*
+	Integrate two simulations of the 'bounds' model on two threads at once.
+	Everything up to integrator_solve is done here on the main thread.
+*/
+static void test_threads(){
+	struct Instance *siminst[NSIMS];
+	slv_system_t sys[NSIMS];
+	struct test_lsode_thread t[NSIMS];
+	pthread_t thread[NSIMS];
+	char simname[20];
+	dim_type d;
+	int i, j, num = 20, index;
+
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv" OSPATH_DIV "solvers/lsode"));
+	CU_TEST_FATAL(0 == package_load("qrslv",NULL));
+
+	{
+		int status;
+		Asc_OpenModule("test/lsode/bounds.a4c",&status);
+		CU_ASSERT_FATAL(status == 0);
+	}
+	CU_ASSERT(0 == zz_parse());
+	CU_ASSERT(FindType(AddSymbol("bounds"))!=NULL);
+
+	index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(index != -1);
+	SetDimFraction(d,D_TIME,CreateFraction(1,1));
+
+	for(i=0; i<NSIMS; ++i){
+		sprintf(simname,"sim%d",i+1);
+		siminst[i] = SimsCreateInstance(AddSymbol("bounds"), AddSymbol(simname), e_normal, NULL);
+		CU_ASSERT_FATAL(siminst[i]!=NULL);
+
+		struct Name *name = CreateIdName(AddSymbol("on_load"));
+		enum Proc_enum pe = Initialize(GetSimulationRoot(siminst[i]),name,simname, ASCERR, WP_STOPONERR, NULL, NULL);
+		CU_ASSERT(pe==Proc_all_ok);
+
+		sys[i] = system_build(GetSimulationRoot(siminst[i]));
+		CU_ASSERT_FATAL(sys[i] != NULL);
+		CU_ASSERT_FATAL(slv_select_solver(sys[i],index));
+
+		t[i].integ = integrator_new(sys[i],siminst[i]);
+		CU_ASSERT_FATAL(0 == integrator_set_engine(t[i].integ,"LSODE"));
+		CU_ASSERT_FATAL(0 == integrator_analyse(t[i].integ));
+
+		integrator_set_reporter(t[i].integ, &test_lsode_reporter);
+		integrator_set_minstep(t[i].integ,0);
+		integrator_set_maxstep(t[i].integ,0);
+		integrator_set_stepzero(t[i].integ,0);
+		integrator_set_maxsubsteps(t[i].integ,0);
+
+		t[i].samplelist = samplelist_new(num+1, &d);
+		for(j=0; j<=num; ++j){
+			samplelist_set(t[i].samplelist,j,10.0*j/num);
+		}
+		integrator_set_samples(t[i].integ,t[i].samplelist);
+		t[i].res = -1;
+	}
+
+	for(i=0; i<NSIMS; ++i){
+		CU_ASSERT_FATAL(0 == pthread_create(&thread[i],NULL,&test_lsode_thread_main,&t[i]));
+	}
+	for(i=0; i<NSIMS; ++i){
+		CU_ASSERT(0 == pthread_join(thread[i],NULL));
+	}
+
+	for(i=0; i<NSIMS; ++i){
+		CU_ASSERT(0 == t[i].res);
+		/* x = t^2/2, as in test_normal */
+		CU_ASSERT_DOUBLE_EQUAL(var_value(t[i].integ->x), 10.0, 1e-8);
+		CU_ASSERT_DOUBLE_EQUAL(var_value(t[i].integ->y[0]), 50.0, 1e-3);
+
+		integrator_free(t[i].integ);
+		samplelist_free(t[i].samplelist);
+		system_destroy(sys[i]);
+	}
+	system_free_reused_mem();
+
+	solver_destroy_engines();
+	integrator_free_engines();
+	for(i=0; i<NSIMS; ++i){
+		sim_destroy(siminst[i]);
+	}
+	Asc_CompilerDestroy();
+}
+
+# define TESTS_THREADS(T) T(threads)
+#else
+# define TESTS_THREADS(T)
+#endif
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T) \
-	T(bounds)
+	T(bounds) \
+	T(normal) \
+	T(implicit) \
+	T(jacobian) \
+	TESTS_THREADS(T)
 
 REGISTER_TESTS_SIMPLE(integrator_lsode, TESTS)
 
@@ -111,7 +111,7 @@ int g_linsolqr_timing = 1;
 */
 
 char *linsolqr_rmethods() {
-  static char names[]="Natural, SPK1, TSPK1";
+  static char names[]="Natural, SPK1, TSPK1, AMD, COLAMD";
   return names;
 }
 
@@ -126,6 +126,8 @@ enum reorder_method linsolqr_rmethod_to_enum(char *name) {
   if (strcmp(name,"SPK1")==0) return spk1;
   if (strcmp(name,"TSPK1")==0) return tspk1;
   if (strcmp(name,"Natural")==0) return natural;
+  if (strcmp(name,"AMD")==0) return amd;
+  if (strcmp(name,"COLAMD")==0) return colamd;
   return unknown_r;
 }
 
@@ -173,6 +175,8 @@ char *linsolqr_enum_to_rmethod(enum reorder_method meth) {
 		case spk1: return "SPK1";
 		case tspk1: return "TSPK1";
 		case natural: return "Natural";
+		case amd: return "AMD";
+		case colamd: return "COLAMD";
 		default: return "<unknown reordering method>";
 	}
 }
@@ -196,6 +200,8 @@ const char *linsolqr_rmethod_description(const enum reorder_method meth) {
 		case spk1: return "SPK1 reordering ala Stadtherr";
 		case tspk1: return "SPK1 reordering column wise a la Stadtherr";
 		case natural: return "Ordering as received from user";
+		case amd: return "Approximate minimum degree ordering a la Amestoy, Davis and Duff";
+		case colamd: return "Column approximate minimum degree ordering a la Davis et al";
 		default: return "<unknown reordering method>";
 	}
 }
@@ -299,6 +305,11 @@ static void destroy_ludata(struct lu_auxdata *d) {
     d->pivlist=NULL;
     if (NOTNULL(d->tmp))  ascfree(d->tmp);
     d->tmp=NULL;
+    if (NOTNULL(d->seqrow)) ascfree(d->seqrow);
+    if (NOTNULL(d->seqcol)) ascfree(d->seqcol);
+    if (NOTNULL(d->seqstep)) ascfree(d->seqstep);
+    if (NOTNULL(d->heap)) ascfree(d->heap);
+    if (NOTNULL(d->mark)) ascfree(d->mark);
     ascfree(d);
   }
 }
@@ -335,6 +346,7 @@ linsolqr_system_t linsolqr_create(){
 	sys->ptol = 0.1;                   /* default value */
 	sys->ctol = 0.1;                   /* default value */
 	sys->dtol = LINQR_DROP_TOLERANCE;  /* default value */
+	sys->reuse_pivots = TRUE;          /* default value */
 	sys->factors = NULL;
 	sys->inverse = NULL;
 	sys->factored = FALSE;
@@ -603,6 +615,32 @@ real64 linsolqr_smallest_pivot(linsolqr_system_t sys){
    return(sys->smallest_pivot);
 }
 
+void linsolqr_set_pivot_reuse(linsolqr_system_t sys, boolean reuse){
+   if(CHECK_SYSTEM(sys)) {
+     ERROR_REPORTER_HERE(ASC_PROG_ERR,"Bad linsolqr_system_t found. set_pivot_reuse ignored.");
+     return;
+   }
+   sys->reuse_pivots = reuse;
+   if (!reuse && NOTNULL(sys->ludata)) {
+     sys->ludata->recorded = FALSE;
+   }
+}
+
+boolean linsolqr_pivot_reuse(linsolqr_system_t sys){
+   CHECK_SYSTEM(sys);
+   return( sys->reuse_pivots );
+}
+
+void linsolqr_refactor_stats(linsolqr_system_t sys,
+                             int32 *refactors, int32 *fallbacks){
+   CHECK_SYSTEM(sys);
+   *refactors = *fallbacks = 0;
+   if (NOTNULL(sys->ludata)) {
+     *refactors = sys->ludata->refactors;
+     *fallbacks = sys->ludata->fallbacks;
+   }
+}
+
 /*-----------------------------------------------------------------------------
   Commonly used internal functions for sparse linear solvers based on mtx.
    void ensure_capacity(sys)
@@ -765,6 +803,18 @@ void ensure_lu_capacity(linsolqr_system_t sys){
       raise_capacity(sys->ludata->pivlist,sys->ludata->cap,req_cap);
     sys->ludata->tmp =
       raise_capacity(sys->ludata->tmp,sys->ludata->cap,req_cap);
+    /* the recorded pivot sequence is not worth carrying over a resize */
+    if (NOTNULL(sys->ludata->seqrow)) ascfree(sys->ludata->seqrow);
+    if (NOTNULL(sys->ludata->seqcol)) ascfree(sys->ludata->seqcol);
+    if (NOTNULL(sys->ludata->seqstep)) ascfree(sys->ludata->seqstep);
+    if (NOTNULL(sys->ludata->heap)) ascfree(sys->ludata->heap);
+    if (NOTNULL(sys->ludata->mark)) ascfree(sys->ludata->mark);
+    sys->ludata->seqrow = ASC_NEW_ARRAY(int32,req_cap);
+    sys->ludata->seqcol = ASC_NEW_ARRAY(int32,req_cap);
+    sys->ludata->seqstep = ASC_NEW_ARRAY(int32,req_cap);
+    sys->ludata->heap = ASC_NEW_ARRAY(int32,req_cap);
+    sys->ludata->mark = ASC_NEW_ARRAY_CLEAR(int32,req_cap);
+    sys->ludata->recorded = FALSE;
     sys->ludata->cap = req_cap;
   }
 }
@@ -1768,6 +1818,26 @@ static int tranki_reorder(linsolqr_system_t sys,mtx_region_t *region)
    return 0;
 }
 
+static int amd_reorder(linsolqr_system_t sys,mtx_region_t *region,
+                       enum mtx_reorder_method rmeth)
+/**
+	As for ranki_reorder, but the work is done by mtx_reorder. COLAMD
+	is also a sensible column order for sparse QR.
+ **/
+{
+   mtx_region_t reg;
+   CHECK_SYSTEM(sys);
+   if ( !(sys->fclass==ranki || sys->fclass==s_qr) ) {
+     ERROR_REPORTER_HERE(ASC_PROG_ERR,"reorder called on system with inappropriate factor method");
+     return 1;
+   }
+   if( region == mtx_ENTIRE_MATRIX ) determine_pivot_range(sys);
+   else square_region(sys,region);
+
+   reg.row = reg.col = sys->rng;
+   return mtx_reorder(sys->coef,&reg,rmeth);
+}
+
 /*
   End of reordering functions for SPK1.
 */
@@ -2926,6 +2996,12 @@ int linsolqr_reorder(linsolqr_system_t sys,mtx_region_t *region,
    case tspk1:
       reostatus=tranki_reorder(sys,region);
       break;
+   case amd:
+      reostatus=amd_reorder(sys,region,mtx_AMD);
+      break;
+   case colamd:
+      reostatus=amd_reorder(sys,region,mtx_COLAMD);
+      break;
    case natural:
       square_region(sys,region);
       break;
@@ -2933,6 +3009,10 @@ int linsolqr_reorder(linsolqr_system_t sys,mtx_region_t *region,
       reostatus=1;
       break;
    }
+   if (method != natural && NOTNULL(sys->ludata)) {
+      /* a new ordering asks for a new pivot search */
+      sys->ludata->recorded = FALSE;
+   }
    if (reostatus) {
       ERROR_REPORTER_HERE(ASC_PROG_ERR,"Error %d in reordering with %s",reostatus,
         linsolqr_enum_to_rmethod(method));
@@ -3717,6 +3797,8 @@ size_t linsolqr_size(linsolqr_system_t sys)
       s += sizeof(real64) * sys->ludata->cap;
     if (NOTNULL(sys->ludata->tmp))
       s += sizeof(real64) * sys->ludata->cap;
+    if (NOTNULL(sys->ludata->seqrow))
+      s += 5 * sizeof(int32) * sys->ludata->cap;
   }
   if (NOTNULL(sys->qrdata)) {
     s += sizeof(struct qr_auxdata);
@@ -236,7 +236,9 @@ enum reorder_method {
   unknown_r,       /**< error handling method */
   natural = 1000,  /**< do nothing reorder */
   spk1 = 2000,     /**< Stadtherr's SPK1 reordering */
-  tspk1 = 3000     /**< transpose of Stadtherr's SPK1 reordering good for gauss */
+  tspk1 = 3000,    /**< transpose of Stadtherr's SPK1 reordering good for gauss */
+  amd = 4000,      /**< approximate minimum degree, on A+A' */
+  colamd = 5000    /**< column approximate minimum degree, on A'A */
   /* future work:
   invspk1,      spk1 then diagonally inverted
   invtspk1,     tspk1 then diagonally inverted
@@ -543,6 +545,36 @@ ASC_DLLSPEC real64 linsolqr_smallest_pivot(linsolqr_system_t sys);
  *  MAXDOUBLE is returned.
  */
 
+ASC_DLLSPEC void linsolqr_set_pivot_reuse(linsolqr_system_t sys, boolean reuse);
+/**< See discussion under linsolqr_pivot_reuse(). */
+ASC_DLLSPEC boolean linsolqr_pivot_reuse(linsolqr_system_t sys);
+/**<
+ *  Sets/gets whether ranki_ba2 and ranki_kw2 may refactor with the pivot
+ *  sequence of their last full factorization. Default is TRUE.
+ *
+ *  When a full rank factorization is found, the pivot sequence (which
+ *  org row and org col were pivoted at each position) is recorded. The
+ *  next factorization over the same pivot range with the same method
+ *  then permutes the copy of coef straight into that order and does only
+ *  the numeric elimination: no pivot search, spike test or row drags.
+ *  Fill is found as the elimination goes, so the incidence need not be
+ *  identical to the recorded one. Each pivot must still pass pivot_zero
+ *  and ptol as it would have in the full search (against the elements
+ *  of its row of L in cols that were not yet pivoted); if any fails, the replay is abandoned and a full factorization with
+ *  pivot search is done (and its sequence recorded) instead.
+ *
+ *  The sequence is forgotten by any reorder other than natural, by
+ *  rank deficient factorizations and by turning reuse off.
+ */
+
+ASC_DLLSPEC void linsolqr_refactor_stats(linsolqr_system_t sys,
+                                         int32 *refactors, int32 *fallbacks);
+/**<
+ *  Reports how many factorizations were done by replaying a recorded
+ *  pivot sequence and how many replays fell back to a full factorization
+ *  since the system was prepped for ranki. Both are 0 for other classes.
+ */
+
 ASC_DLLSPEC int linsolqr_prep(linsolqr_system_t sys, enum factor_class fclass);
 /**<
  *  This function is analogous to slv_select_solver. It
@@ -605,6 +637,10 @@ ASC_DLLSPEC int linsolqr_reorder(linsolqr_system_t sys,
  *               are considered structurally (therefore numerically) dependent.
  *     Natural:  Blesses the system and does nothing.
  *               Again, the rows/cols not in the diagonal are dependent.
+ *     AMD:      Fill-reducing orderings, for large blocks that are far
+ *     COLAMD:   from triangular. Rows/cols not in the diagonal are
+ *               treated as for SPK1. See mtx_reorder(), and
+ *               mtx_reorder_fill() to compare orderings.
  *  </pre>
  */
 
@@ -87,6 +87,17 @@ struct lu_auxdata { /* all indexed by cur row or cur col number */
   real64 *pivlist;  /* vector of pivots (diagonal of L for ranki) */
   real64 *tmp;      /* row elimination, dependency buffer */
   int32 cap;        /* current capacity of the vectors if not null */
+  /* pivot sequence of the last full ranki2 factorization, for refactoring */
+  int32 *seqrow;    /* org row pivoted at each cur position of seqrng */
+  int32 *seqcol;    /* org col pivoted at each cur position of seqrng */
+  int32 *seqstep;   /* org col indexed: row of the pivot search that took it */
+  int32 *heap;      /* refactor scratch: pending U columns, max on top */
+  int32 *mark;      /* refactor scratch: cols nonzero in tmp, kept 0 */
+  mtx_range_t seqrng;             /* pivot range of the sequence */
+  enum factor_method seqmethod;   /* method that found it */
+  boolean recorded; /* ? seqrow/seqcol hold a full rank sequence */
+  int32 refactors;  /* factorizations done by replaying the sequence */
+  int32 fallbacks;  /* replays abandoned for a full factorization */
 };
 /* structure for lu algorithms */
 
@@ -120,6 +131,7 @@ struct linsolqr_header {
    real64 ptol;                  /* Pivot selection tolerance */
    real64 ctol;                  /* Condition selection tolerance */
    real64 dtol;                  /* Matrix entry drop tolerance */
+   boolean reuse_pivots;         /* ? refactor with the last pivot sequence */
    mtx_matrix_t factors;         /* Matrix with UL and dependence info (ranki),
                                     or L and dependence info  (ranki2),
                                     or R and dependence info (qr methods)  */
@@ -217,6 +217,7 @@ static mtx_matrix_t alloc_header(void){
    mtx_matrix_t mtx;
    mtx = (mtx_matrix_t)ascmalloc( sizeof(struct mtx_header) );
    mtx->integrity = OK;
+   mtx->frozen = NULL;
    return(mtx);
 }
 
@@ -249,6 +250,17 @@ static void copy_nz_header(struct element_t **tarhdr,
 	Frees a row or column header
  **/
 
+/**
+	Frees packed storage made by mtx_freeze. Safe with NULL.
+	The caller must already have unlinked or discarded the slots.
+*/
+static void free_frozen(struct frozen_data_t *fz){
+  if (ISNULL(fz)) return;
+  free_unless_null((POINTER)fz->elts);
+  free_unless_null((POINTER)fz->rowptr);
+  ascfree(fz);
+}
+
 
 /********************************************************************/
 /*
@@ -274,8 +286,11 @@ Excuses for this kluge:
 3) it is faster than passing the mtx
 up and down through the functions listed above, and we do a LOT of
 these operations.
+
+It is per-thread, so that different matrices can be worked on in
+different threads.
 */
-static mtx_matrix_t last_value_matrix = NULL;
+static ASC_THREAD_LOCAL mtx_matrix_t last_value_matrix = NULL;
 
 /**
 	Indicates that one of the row or column (it doesn't matter) in which
@@ -337,6 +352,8 @@ static void nuke_fishnet(mtx_matrix_t mtx){
   }
   if (mtx->capacity<1) return;
   mtx->last_value = NULL;
+  free_frozen(mtx->frozen);
+  mtx->frozen = NULL;
   mem_clear_store(mtx->ms);
   zero(mtx->hdr.row,mtx->capacity,struct element_t *);
   zero(mtx->hdr.col,mtx->capacity,struct element_t *);
@@ -349,24 +366,35 @@ static void nuke_fishnet(mtx_matrix_t mtx){
 /**
 	Destroys all elements in the given row with (current)
 	col index in the given col range: if rng == mtx_ALL_COLS,
-	entire row is destroyed.
+	entire row is destroyed. The packed slots of a frozen matrix
+	are only zeroed.
 	NOTE WELL: last_value_mtx must be set before this function is called.
 */
 static void blast_row( mtx_matrix_t mtx, int32 org, mtx_range_t *rng){
   struct element_t **link;
+  struct frozen_data_t *fz = mtx->frozen;
 
   link = &(mtx->hdr.row[org]);
   if( rng == mtx_ALL_COLS ) {
-    while( NOTNULL(*link) )
-      delete_from_row(link);
+    while( NOTNULL(*link) ) {
+      if( IS_FROZEN_ELT(fz,*link) ) {
+        (*link)->value = D_ZERO;
+        link = &((*link)->next.col);
+      } else
+        delete_from_row(link);
+    }
   } else {
     int32 *tocur = mtx->perm.col.org_to_cur;
     int32 col;
     while( NOTNULL(*link) ) {
       col = (*link)->col;
-      if( col == mtx_NONE || in_range(rng,tocur[col]) )
-        delete_from_row(link);
-      else
+      if( col == mtx_NONE || in_range(rng,tocur[col]) ) {
+        if( IS_FROZEN_ELT(fz,*link) ) {
+          (*link)->value = D_ZERO;
+          link = &((*link)->next.col);
+        } else
+          delete_from_row(link);
+      } else
         link = &((*link)->next.col);
     }
   }
@@ -375,24 +403,35 @@ static void blast_row( mtx_matrix_t mtx, int32 org, mtx_range_t *rng){
 /**
 	Destroys all elements in the given col with (current)
 	row index in the given row range: if rng == mtx_ALL_ROWS,
-	entire col is destroyed.
+	entire col is destroyed. The packed slots of a frozen matrix
+	are only zeroed.
 	NOTE WELL: last_value_mtx must be set before this function is called.
 */
 static void blast_col( mtx_matrix_t mtx, int32 org, mtx_range_t *rng){
   struct element_t **link;
+  struct frozen_data_t *fz = mtx->frozen;
 
   link = &(mtx->hdr.col[org]);
   if( rng == mtx_ALL_ROWS ) {
-    while( NOTNULL(*link) )
-      delete_from_col(link);
+    while( NOTNULL(*link) ) {
+      if( IS_FROZEN_ELT(fz,*link) ) {
+        (*link)->value = D_ZERO;
+        link = &((*link)->next.row);
+      } else
+        delete_from_col(link);
+    }
   } else {
     int32 *tocur = mtx->perm.row.org_to_cur, row;
 
     while( NOTNULL(*link) ) {
       row = (*link)->row;
-      if( row == mtx_NONE || in_range(rng,tocur[row]) )
-        delete_from_col(link);
-      else
+      if( row == mtx_NONE || in_range(rng,tocur[row]) ) {
+        if( IS_FROZEN_ELT(fz,*link) ) {
+          (*link)->value = D_ZERO;
+          link = &((*link)->next.row);
+        } else
+          delete_from_col(link);
+      } else
         link = &((*link)->next.row);
     }
   }
@@ -458,7 +497,7 @@ void mtx_debug_redirect_freeze(){
 }
 
 static void mtx_redirectErrors(FILE *f){
-  if (!g_mtx_debug_redirect) {
+  if (!g_mtx_debug_redirect && g_mtxerr != f) {
     assert(f != NULL);
     g_mtxerr = f;
   }
@@ -508,6 +547,7 @@ mtx_matrix_t mtx_create_slave(mtx_matrix_t master){
   int32 newcnt;
   mtx_redirectErrors(stderr); /* call mtx_debug_redirect_freeze() to bypass */
   if(!mtx_check_matrix(master) || ISSLAVE(master)) return NULL;
+  if (NOTNULL(master->frozen)) mtx_thaw(master);
 
   mtx = alloc_header();
   if (ISNULL(mtx)) return mtx;
@@ -938,6 +978,7 @@ static void trim_incidence(mtx_matrix_t mtx, int32 order){
    int32 ndx;
    int32 *toorg;
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    toorg = mtx->perm.col.cur_to_org;
    for( ndx = order ; ndx < mtx->order ; ++ndx )
@@ -997,6 +1038,7 @@ void mtx_set_order( mtx_matrix_t mtx, int32 order){
     int32 *newperm;
     int32 ndx;
 
+    if (NOTNULL(mtx->frozen)) mtx_thaw(mtx); /* rowptr is capacity long */
     enlarge_nzheaders(mtx,order);
     for (i = 0; i < mtx->nslaves; i++) {
       enlarge_nzheaders(mtx->slaves[i],order);
@@ -1055,6 +1097,7 @@ void mtx_clear_coord(mtx_matrix_t mtx, int32 row, int32 col){
    if( !mtx_check_matrix(mtx) ) return; /*ben*/
 #endif
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    org_row = mtx->perm.row.cur_to_org[row];
    org_col = mtx->perm.col.cur_to_org[col];
@@ -1077,6 +1120,7 @@ void mtx_clear_row( mtx_matrix_t mtx, int32 row, mtx_range_t *rng){
    if( !mtx_check_matrix(mtx) ) return; /*ben*/
 #endif
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    org_row = mtx->perm.row.cur_to_org[row];
    rlink = &(mtx->hdr.row[org_row]);
@@ -1110,6 +1154,7 @@ void mtx_clear_col( mtx_matrix_t mtx, int32 col, mtx_range_t *rng){
    if( !mtx_check_matrix(mtx) ) return;
 #endif
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    org_col = mtx->perm.col.cur_to_org[col];
    clink = &(mtx->hdr.col[org_col]);
@@ -1200,6 +1245,168 @@ void mtx_clear(mtx_matrix_t mtx){
   mtx_reset_perm(mtx);
 }
 
+int mtx_freeze(mtx_matrix_t mtx){
+  struct frozen_data_t *fz;
+  struct element_t *elt, *next, *slot, **link;
+  int32 org, nnz, cap;
+
+  if(!mtx_check_matrix(mtx)) return 1;
+  if (ISSLAVE(mtx) || mtx->nslaves > 0 || mtx->capacity < 1) return 1;
+  cap = mtx->capacity;
+
+  fz = (struct frozen_data_t *)ascmalloc(sizeof(struct frozen_data_t));
+  if (ISNULL(fz)) return 1;
+  fz->elts = NULL;
+  fz->rowptr = ASC_NEW_ARRAY(int32,cap+1);
+  if (ISNULL(fz->rowptr)) {
+    free_frozen(fz);
+    return 1;
+  }
+  nnz = 0;
+  for (org = ZERO; org < cap; org++) {
+    fz->rowptr[org] = nnz;
+    for (elt = mtx->hdr.row[org]; NOTNULL(elt); elt = elt->next.col) {
+      nnz++;
+    }
+  }
+  fz->rowptr[cap] = nnz;
+  fz->nnz = nnz;
+  fz->misses = 0;
+  if (nnz > 0) {
+    fz->elts = ASC_NEW_ARRAY(struct element_t,nnz);
+    if (ISNULL(fz->elts)) {
+      FPRINTF(g_mtxerr,"mtx_freeze: Insufficient memory.\n");
+      free_frozen(fz);
+      return 1;
+    }
+  }
+
+  /* Rows are built with the newest element at the head, so fill each
+   * row's slots from the back to keep them in the order in which they
+   * were created, and thus in the order in which they will be refilled.
+   * The old element's next.col is left pointing at its slot so that the
+   * columns can be relinked below in their present order.
+   */
+  for (org = ZERO; org < cap; org++) {
+    slot = fz->elts + fz->rowptr[org+1];
+    link = &(mtx->hdr.row[org]);
+    for (elt = *link; NOTNULL(elt); elt = next) {
+      next = elt->next.col;
+      --slot;
+      slot->value = elt->value;
+      slot->row = elt->row;
+      slot->col = elt->col;
+      *link = slot;
+      link = &(slot->next.col);
+      elt->next.col = slot;
+    }
+    *link = NULL;
+  }
+  for (org = ZERO; org < cap; org++) {
+    link = &(mtx->hdr.col[org]);
+    for (elt = *link; NOTNULL(elt); elt = next) {
+      next = elt->next.row;
+      *link = elt->next.col;
+      link = &((*link)->next.row);
+    }
+    *link = NULL;
+  }
+
+  /* the old elements are all garbage now, wherever they lived */
+  free_frozen(mtx->frozen);
+  mtx->frozen = fz;
+  mem_clear_store(mtx->ms);
+  mtx->last_value = NULL;
+  return 0;
+}
+
+void mtx_thaw(mtx_matrix_t mtx){
+  struct frozen_data_t *fz;
+  struct element_t **map, **link;
+  int32 k, org;
+
+  if(!mtx_check_matrix(mtx)) return;
+  fz = mtx->frozen;
+  if (ISNULL(fz)) return;
+  map = NULL;
+  if (fz->nnz > 0) {
+    map = ASC_NEW_ARRAY(struct element_t *,fz->nnz);
+    if (ISNULL(map)) {
+      FPRINTF(g_mtxerr,"mtx_thaw: Insufficient memory.\n");
+      return;
+    }
+  }
+  for (k = ZERO; k < fz->nnz; k++) {
+    map[k] = (struct element_t *)mem_get_element(mtx->ms);
+    *(map[k]) = fz->elts[k];
+  }
+  /* point everything that refers to a slot at its copy instead */
+  for (org = ZERO; org < mtx->capacity; org++) {
+    for (link = &(mtx->hdr.row[org]); NOTNULL(*link);
+         link = &((*link)->next.col)) {
+      if (IS_FROZEN_ELT(fz,*link)) *link = map[*link - fz->elts];
+    }
+    for (link = &(mtx->hdr.col[org]); NOTNULL(*link);
+         link = &((*link)->next.row)) {
+      if (IS_FROZEN_ELT(fz,*link)) *link = map[*link - fz->elts];
+    }
+  }
+  free_unless_null((POINTER)map);
+  free_frozen(fz);
+  mtx->frozen = NULL;
+  mtx->last_value = NULL;
+}
+
+boolean mtx_is_frozen(mtx_matrix_t mtx){
+  if(!mtx_check_matrix(mtx)) return FALSE;
+  return NOTNULL(mtx->frozen);
+}
+
+int32 mtx_frozen_nnz(mtx_matrix_t mtx){
+  if(!mtx_check_matrix(mtx) || ISNULL(mtx->frozen)) return 0;
+  return mtx->frozen->nnz;
+}
+
+int32 mtx_frozen_misses(mtx_matrix_t mtx){
+  if(!mtx_check_matrix(mtx) || ISNULL(mtx->frozen)) return 0;
+  return mtx->frozen->misses;
+}
+
+int32 mtx_frozen_org_slot(mtx_matrix_t mtx, const mtx_coord_t *coord,
+                          int32 hint){
+  struct frozen_data_t *fz;
+  struct element_t *elts;
+  int32 k, low, high;
+
+#if MTX_DEBUG
+  if(!mtx_check_matrix(mtx)) return -1;
+#endif
+  fz = mtx->frozen;
+  if (ISNULL(fz)) return -1;
+  elts = fz->elts;
+  low = fz->rowptr[coord->row];
+  high = fz->rowptr[coord->row+1];
+  if (not_in_range(low,high-1,hint)) hint = low;
+  for (k = hint; k < high; k++) {
+    if (elts[k].col == coord->col) return k;
+  }
+  for (k = low; k < hint; k++) {
+    if (elts[k].col == coord->col) return k;
+  }
+  return -1;
+}
+
+void mtx_frozen_set_slot(mtx_matrix_t mtx, int32 slot, real64 value){
+#if MTX_DEBUG
+  if(!mtx_check_matrix(mtx)) return;
+  if (ISNULL(mtx->frozen) || not_in_range(0,mtx->frozen->nnz-1,slot)) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"Bad slot %d.\n",slot);
+    return;
+  }
+#endif
+  mtx->frozen->elts[slot].value = value;
+}
+
 real64 mtx_value(mtx_matrix_t mtx, mtx_coord_t *coord){
    struct element_t *elt;
    int32 org_row,org_col;
@@ -1315,6 +1522,7 @@ int32 mtx_assemble(mtx_matrix_t mtx){
   lowmark=-1;
   highmark=-2;
   dup = 0;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   for (orgrow=0; orgrow < mtx->order; orgrow++) {
     elt = mtx->hdr.row[orgrow];
@@ -1394,6 +1602,7 @@ void mtx_del_zr_in_row(mtx_matrix_t mtx, int32 row){
    org = mtx->perm.row.cur_to_org[row];
    rlink = &(mtx->hdr.row[org]);
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    while( NOTNULL(*rlink) )
       if( (*rlink)->value == D_ZERO ) {
@@ -1416,6 +1625,7 @@ void mtx_del_zr_in_col(mtx_matrix_t mtx, int32 col){
    org = mtx->perm.col.cur_to_org[col];
    clink = &(mtx->hdr.col[org]);
 
+   if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
    last_value_matrix = mtx;
    while( NOTNULL(*clink) )
       if( (*clink)->value == D_ZERO ) {
@@ -1437,6 +1647,7 @@ void mtx_del_zr_in_rowrange(mtx_matrix_t mtx, mtx_range_t *rng){
 #endif
   rowhi=rng->high;
   toorg= mtx->perm.row.cur_to_org;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   for (row=rng->low; row <=rowhi; row++) {
     org = toorg[row];
@@ -1466,6 +1677,7 @@ void mtx_del_zr_in_colrange(mtx_matrix_t mtx, mtx_range_t *rng){
 #endif
   colhi=rng->high;
   toorg= mtx->perm.col.cur_to_org;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   for (col=rng->low; col <=colhi; col++) {
     org = toorg[col];
@@ -1496,6 +1708,7 @@ void mtx_steal_org_row_vec(mtx_matrix_t mtx, int32 row
   if( !mtx_check_matrix(mtx) ) return;
 #endif
 
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_row = mtx->perm.row.cur_to_org[row];
   rlink = &(mtx->hdr.row[org_row]);
@@ -1536,6 +1749,7 @@ void mtx_steal_org_col_vec(mtx_matrix_t mtx, int32 col
   if( !mtx_check_matrix(mtx) ) return;
 #endif
 
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_col = mtx->perm.col.cur_to_org[col];
   clink = &(mtx->hdr.col[org_col]);
@@ -1577,6 +1791,7 @@ void mtx_steal_cur_row_vec(mtx_matrix_t mtx, int32 row
 #endif
 
   tocur = mtx->perm.col.org_to_cur;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_row = mtx->perm.row.cur_to_org[row];
   rlink = &(mtx->hdr.row[org_row]);
@@ -1616,6 +1831,7 @@ void mtx_steal_cur_col_vec(mtx_matrix_t mtx, int32 col
 #endif
 
   tocur = mtx->perm.row.org_to_cur;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_col = mtx->perm.col.cur_to_org[col];
   clink = &(mtx->hdr.col[org_col]);
@@ -1717,6 +1933,7 @@ boolean mtx_steal_org_row_sparse(mtx_matrix_t mtx, int32 row
     return TRUE;
   }
 
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_row = mtx->perm.row.cur_to_org[row];
   rlink = &(mtx->hdr.row[org_row]);
@@ -1780,6 +1997,7 @@ boolean mtx_steal_org_col_sparse(mtx_matrix_t mtx, int32 col
     return TRUE;
   }
 
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_col = mtx->perm.col.cur_to_org[col];
   clink = &(mtx->hdr.col[org_col]);
@@ -1844,6 +2062,7 @@ boolean mtx_steal_cur_row_sparse(mtx_matrix_t mtx, int32 row
   }
 
   tocur = mtx->perm.col.org_to_cur;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_row = mtx->perm.row.cur_to_org[row];
   rlink = &(mtx->hdr.row[org_row]);
@@ -1906,6 +2125,7 @@ boolean mtx_steal_cur_col_sparse(mtx_matrix_t mtx, int32 col
   }
 
   tocur = mtx->perm.row.org_to_cur;
+  if (NOTNULL(mtx->frozen)) mtx_thaw(mtx);
   last_value_matrix = mtx;
   org_col = mtx->perm.col.cur_to_org[col];
   clink = &(mtx->hdr.col[org_col]);
@@ -2770,6 +2990,12 @@ size_t mtx_size(mtx_matrix_t mtx) {
     size += sizeof(mtx_region_t)*(size_t)(mtx->data->nblocks-1);
   /* permutations */
   size += (size_t)4*(sizeof(int32)*(size_t)mtx->capacity);
+  /* packed elements */
+  if (NOTNULL(mtx->frozen)) {
+    size += sizeof(struct frozen_data_t) +
+      (size_t)mtx->frozen->nnz*sizeof(struct element_t) +
+      (size_t)(mtx->capacity+1)*sizeof(int32);
+  }
   return size;
 }
 
@@ -2792,6 +3018,8 @@ size_t mtx_chattel_size(mtx_matrix_t mtx) {
 }
 
 void mtx_free_reused_mem(void){
+  (void)mtx_null_index((int32)0);
+  (void)mtx_null_sum((int32)0);
   (void)mtx_null_mark((int32)0);
   (void)mtx_null_vector((int32)0);
   (void)mtx_null_row_vector((int32)0);
@@ -345,7 +345,7 @@ ASC_DLLSPEC void mtx_clear_region(mtx_matrix_t matrix, mtx_region_t *region);
  ***  @see mtx_clear() for more about matrix clearing functions.
  **/
 
-extern void mtx_reset_perm(mtx_matrix_t matrix);
+ASC_DLLSPEC void mtx_reset_perm(mtx_matrix_t matrix);
 /**<
  ***  Restores the original row/column ordering.
  -$-  Does nothing to a bad matrix if MTX_DEBUG is defined.<br><br>
@@ -371,6 +371,71 @@ ASC_DLLSPEC void mtx_clear(mtx_matrix_t matrix);
  ***  mtx_clear(master or slave) passes up to the master.
  **/
 
+ASC_DLLSPEC int mtx_freeze(mtx_matrix_t matrix);
+/**<
+ ***  Packs all elements of a master matrix into one contiguous array,
+ ***  grouped by org row, for matrices such as jacobians whose incidence
+ ***  pattern is refilled over and over. While frozen:
+ ***  - mtx_clear_region() of anything less than mtx_ENTIRE_MATRIX just
+ ***    zeroes the packed elements in the region, keeping the pattern;
+ ***  - mtx_fill_value() and friends store into the existing packed
+ ***    element where there is one, and create a linked element as usual
+ ***    where there is not (see mtx_frozen_misses()). Note that repeated
+ ***    fills of one coordinate therefore overwrite rather than sum.
+ ***  - mtx_frozen_org_slot()/mtx_frozen_set_slot() give direct access
+ ***    to the packed values.
+ ***  Everything else works as usual; operations that delete elements
+ ***  or restructure the matrix (mtx_clear_row/col/coord, mtx_del_zr_*,
+ ***  mtx_steal_*, mtx_assemble, mtx_transpose, mtx_create_slave and
+ ***  enlarging mtx_set_order) first call mtx_thaw(). Clearing
+ ***  mtx_ENTIRE_MATRIX discards the pattern altogether.<br><br>
+ ***  Freezing an already frozen matrix repacks it, taking in any
+ ***  elements created since. Copies made with mtx_copy* are not frozen.
+ ***  Returns 0 if ok, 1 if the matrix is bad, is or has a slave, has no
+ ***  capacity or memory ran out, in which case it is left unchanged.
+ **/
+
+ASC_DLLSPEC void mtx_thaw(mtx_matrix_t matrix);
+/**<
+ ***  Returns a frozen matrix to ordinary linked storage, keeping its
+ ***  values and permutation. Does nothing to an unfrozen matrix.
+ **/
+
+ASC_DLLSPEC boolean mtx_is_frozen(mtx_matrix_t matrix);
+/**<
+ ***  Returns TRUE if the matrix is in the packed form made by mtx_freeze().
+ **/
+
+ASC_DLLSPEC int32 mtx_frozen_nnz(mtx_matrix_t matrix);
+/**<
+ ***  Returns the number of packed elements of a frozen matrix, else 0.
+ **/
+
+ASC_DLLSPEC int32 mtx_frozen_misses(mtx_matrix_t matrix);
+/**<
+ ***  Returns the number of elements created outside the packed storage
+ ***  since the matrix was (last) frozen, else 0. A caller may use this to
+ ***  decide when to repack with mtx_freeze().
+ **/
+
+ASC_DLLSPEC int32 mtx_frozen_org_slot(mtx_matrix_t matrix,
+                                      const mtx_coord_t *coord, int32 hint);
+/**<
+ ***  Returns the index of the packed element at the given ORIGINAL
+ ***  coordinate of a frozen matrix, or -1 if there is none.
+ ***  The row's slots are searched starting from hint, so passing one more
+ ***  than the slot last returned for the same row makes a fill in the
+ ***  original creation order cost O(1) per element. Any hint outside the
+ ***  row is taken as the start of the row.
+ **/
+
+ASC_DLLSPEC void mtx_frozen_set_slot(mtx_matrix_t matrix,
+                                     int32 slot, real64 value);
+/**<
+ ***  Sets the value of packed element slot, as returned by
+ ***  mtx_frozen_org_slot(). No checking unless MTX_DEBUG.
+ **/
+
 
 ASC_DLLSPEC real64 mtx_value(mtx_matrix_t matrix, mtx_coord_t *coord);
 /**<
@@ -1181,11 +1246,13 @@ extern size_t mtx_chattel_size(mtx_matrix_t mtx);
  ***  that is not shared with the master. Returns 0 from a slave.
  **/
 
-extern void mtx_free_reused_mem(void);
+ASC_DLLSPEC void mtx_free_reused_mem(void);
 /**<
  ***  Deallocates any memory that mtx may be squirrelling away for
  ***  internal reuse. Calling this while any slv_system_t exists
  ***  is likely to be fatal: handle with care.
+ ***  Each thread has its own such memory; only that of the calling
+ ***  thread is freed.
  **/
 
 /* ********************************************************************* *\
@@ -1109,6 +1109,8 @@ int32 mtx_transpose(mtx_matrix_t mtx)
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"Matrix given is 0 order.\n");
     return mtx_NONE;
   }
+  /* the packed slots are grouped by row, which is about to become col */
+  if (NOTNULL(master->frozen)) mtx_thaw(master);
   master->perm.transpose = !(master->perm.transpose);
   /* swap perms on master */
   permtmp = mtx->perm.col.org_to_cur;  /* do o2v */
@@ -691,6 +691,543 @@ static int tranki_reorder(mtx_matrix_t mtx,mtx_region_t *region)
   End of reordering functions for SPK1.
 \***************************************************************************/
 
+/*********************************
+ begin of amd stuff
+*********************************/
+/*
+ * Approximate minimum degree orderings, after Amestoy, Davis and Duff
+ * (SIAM J. Matrix Anal. Appl. 17(4), 1996) and, for the column version,
+ * Davis, Gilbert, Larimore and Ng (ACM TOMS 30(3), 2004).
+ *
+ * Elimination is simulated on a quotient graph: a variable that has been
+ * eliminated becomes an element, standing for the clique of variables
+ * that it connects, so the graph never grows. Each variable keeps a list
+ * of the elements it is in and of the variables it is still directly
+ * adjacent to. Degrees are not computed exactly but bounded from above
+ * using the sizes |Le \ Lp| of the elements around the new element Lp,
+ * and variables that become indistinguishable are merged into
+ * supervariables which are then eliminated together.
+ *
+ * For AMD the variables are the diagonal positions of the region and the
+ * graph is that of A+A'. For COLAMD the variables are the columns, and
+ * each row is taken as an element to begin with, so that what is ordered
+ * is A'A, without ever forming it.
+ *
+ * Either way each row is moved with the column it meets on the diagonal,
+ * so that if the region has a full diagonal it keeps one.
+ */
+
+struct amd_list {               /* growable list of node numbers */
+   int32 *a;
+   int32 len;
+   int32 cap;
+};
+
+#define AMD_VAR 0               /* variable, or principal supervariable */
+#define AMD_ELEMENT 1           /* eliminated variable, or row for COLAMD */
+#define AMD_DEAD 2              /* absorbed element or merged variable */
+#define AMD_DENSE 3             /* variable left out, to be ordered last */
+
+struct amd_vars {
+   int32 n;                     /* variables 0..n-1 */
+   int32 nn;                    /* plus initial elements n..nn-1 */
+   struct amd_list *adj;        /* variables adjacent to a variable */
+   struct amd_list *el;         /* elements of a var, or vars of an element */
+   int32 *status;
+   int32 *nv;                   /* size of supervariable */
+   int32 *esize;                /* total size of vars in element */
+   int32 *deg;                  /* approximate external degree */
+   int32 *head, *next, *prev;   /* lists of vars by degree */
+   int32 mindeg;
+   int32 *svnext, *svlast;      /* chains of merged variables */
+   int32 *w;                    /* |Le \ Lp| or -1 */
+   int32 *wlist;                /* elements where w is set */
+   int32 *mark;
+   int32 tag;
+   uint32 *hash;                /* hashes for supervariable detection */
+   int32 *hhead, *hnext;
+};
+
+static int amd_push(struct amd_list *l, int32 x)
+{
+   if (l->len == l->cap) {
+      int32 cap = (l->cap < 4) ? 4 : 2*l->cap;
+      int32 *a = (int32 *)ascrealloc(l->a,cap*sizeof(int32));
+      if (ISNULL(a)) return 1;
+      l->a = a;
+      l->cap = cap;
+   }
+   l->a[l->len++] = x;
+   return 0;
+}
+
+static void amd_list_free(struct amd_list *l)
+{
+   if (NOTNULL(l->a)) ascfree(l->a);
+   l->a = NULL;
+   l->len = l->cap = 0;
+}
+
+static int32 amd_newtag(struct amd_vars *v)
+/**
+ ***  Returns a value not yet used in mark.
+ **/
+{
+   if (v->tag >= INT_MAX - 1) {
+      int32 i;
+      for (i = 0; i < v->nn; i++) v->mark[i] = 0;
+      v->tag = 0;
+   }
+   return ++(v->tag);
+}
+
+static void amd_list_insert(struct amd_vars *v, int32 i)
+{
+   int32 d = v->deg[i];
+   v->prev[i] = -1;
+   v->next[i] = v->head[d];
+   if (v->head[d] >= 0) v->prev[v->head[d]] = i;
+   v->head[d] = i;
+   if (d < v->mindeg) v->mindeg = d;
+}
+
+static void amd_list_remove(struct amd_vars *v, int32 i)
+{
+   if (v->next[i] >= 0) v->prev[v->next[i]] = v->prev[i];
+   if (v->prev[i] >= 0) {
+      v->next[v->prev[i]] = v->next[i];
+   } else {
+      v->head[v->deg[i]] = v->next[i];
+   }
+}
+
+static void amd_destroy(struct amd_vars *v)
+{
+   int32 i;
+   if (NOTNULL(v->adj)) {
+      for (i = 0; i < v->n; i++) amd_list_free(&(v->adj[i]));
+      ascfree(v->adj);
+   }
+   if (NOTNULL(v->el)) {
+      for (i = 0; i < v->nn; i++) amd_list_free(&(v->el[i]));
+      ascfree(v->el);
+   }
+   if (NOTNULL(v->status)) ascfree(v->status);
+   if (NOTNULL(v->hash)) ascfree(v->hash);
+}
+
+static int amd_create(struct amd_vars *v, int32 n, int32 nn)
+/**
+ ***  Allocates the workspace for n variables and nn nodes in all, with
+ ***  empty lists. All the int32 arrays share one block.
+ **/
+{
+   int32 i, *p;
+   v->n = n;
+   v->nn = nn;
+   v->adj = ASC_NEW_ARRAY_CLEAR(struct amd_list,MAX(n,1));
+   v->el = ASC_NEW_ARRAY_CLEAR(struct amd_list,MAX(nn,1));
+   v->status = ASC_NEW_ARRAY(int32,9*nn + 7*n + 1);
+   v->hash = ASC_NEW_ARRAY(uint32,MAX(n,1));
+   if (ISNULL(v->adj) || ISNULL(v->el) || ISNULL(v->status)
+       || ISNULL(v->hash)) {
+      amd_destroy(v);
+      return 1;
+   }
+   p = v->status;
+   v->esize = (p += nn);
+   v->w = (p += nn);
+   v->wlist = (p += nn);
+   v->mark = (p += nn);
+   v->nv = (p += nn);
+   v->svnext = (p += nn);
+   v->svlast = (p += nn);
+   v->deg = (p += nn);
+   v->head = (p += nn);
+   v->next = (p += n + 1);
+   v->prev = (p += n);
+   v->hhead = (p += n);
+   v->hnext = (p += n);
+   for (i = 0; i < nn; i++) {
+      v->status[i] = (i < n) ? AMD_VAR : AMD_ELEMENT;
+      v->esize[i] = 0;
+      v->w[i] = -1;
+      v->mark[i] = 0;
+      v->nv[i] = 1;
+      v->svnext[i] = -1;
+      v->svlast[i] = i;
+      v->deg[i] = 0;
+   }
+   for (i = 0; i <= n; i++) v->head[i] = -1;
+   for (i = 0; i < n; i++) v->hhead[i] = -1;
+   v->tag = 0;
+   v->mindeg = n;
+   return 0;
+}
+
+static int amd_graph(mtx_matrix_t mtx, mtx_range_t *rng, struct amd_list *adj)
+/**
+ ***  Fills adj with the graph of A+A' on the square region rng x rng,
+ ***  numbering from rng->low and without the diagonal. A pair may be
+ ***  listed twice.
+ **/
+{
+   mtx_coord_t nz;
+   int32 r;
+   for (r = rng->low; r <= rng->high; r++) {
+      nz.row = r;
+      nz.col = mtx_FIRST;
+      while (mtx_next_in_row(mtx,&nz,rng), nz.col != mtx_LAST) {
+         if (nz.col == r) continue;
+         if (amd_push(&(adj[r - rng->low]),nz.col - rng->low)
+             || amd_push(&(adj[nz.col - rng->low]),r - rng->low)) {
+            return 1;
+         }
+      }
+   }
+   return 0;
+}
+
+static int amd_init_sym(struct amd_vars *v, mtx_matrix_t mtx,
+                        mtx_range_t *rng, int32 dense)
+/**
+ ***  Sets up the quotient graph for AMD: no elements, and each variable
+ ***  adjacent to its neighbours in A+A'. Variables with more than dense
+ ***  neighbours are taken out.
+ **/
+{
+   int32 i, j, k, m, tag;
+   struct amd_list *l;
+   if (amd_graph(mtx,rng,v->adj)) return 1;
+   for (i = 0; i < v->n; i++) {
+      l = &(v->adj[i]);
+      tag = amd_newtag(v);
+      v->mark[i] = tag;
+      for (k = m = 0; k < l->len; k++) {
+         j = l->a[k];
+         if (v->mark[j] != tag) {
+            v->mark[j] = tag;
+            l->a[m++] = j;
+         }
+      }
+      l->len = m;
+      if (m > dense) v->status[i] = AMD_DENSE;
+   }
+   for (i = 0; i < v->n; i++) {
+      if (v->status[i] != AMD_VAR) continue;
+      l = &(v->adj[i]);
+      for (k = m = 0; k < l->len; k++) {
+         if (v->status[l->a[k]] == AMD_VAR) l->a[m++] = l->a[k];
+      }
+      l->len = v->deg[i] = m;
+   }
+   return 0;
+}
+
+static int amd_init_col(struct amd_vars *v, mtx_matrix_t mtx,
+                        mtx_range_t *rng, int32 dense)
+/**
+ ***  Sets up the quotient graph for COLAMD: the rows are elements n..nn-1
+ ***  and each column is in the rows it has entries in. Rows with more
+ ***  than dense entries are ignored, and columns in more than dense of the
+ ***  rows left are taken out.
+ **/
+{
+   mtx_coord_t nz;
+   struct amd_list *l;
+   int32 r, e, i, k, m, d;
+   for (r = rng->low; r <= rng->high; r++) {
+      e = v->n + r - rng->low;
+      nz.row = r;
+      nz.col = mtx_FIRST;
+      while (mtx_next_in_row(mtx,&nz,rng), nz.col != mtx_LAST) {
+         if (amd_push(&(v->el[e]),nz.col - rng->low)) return 1;
+      }
+      if (v->el[e].len > dense) {
+         v->status[e] = AMD_DEAD;
+         amd_list_free(&(v->el[e]));
+         continue;
+      }
+      for (k = 0; k < v->el[e].len; k++) {
+         if (amd_push(&(v->el[v->el[e].a[k]]),e)) return 1;
+      }
+   }
+   for (i = 0; i < v->n; i++) {
+      if (v->el[i].len > dense) v->status[i] = AMD_DENSE;
+   }
+   for (e = v->n; e < v->nn; e++) {
+      if (v->status[e] != AMD_ELEMENT) continue;
+      l = &(v->el[e]);
+      for (k = m = 0; k < l->len; k++) {
+         if (v->status[l->a[k]] == AMD_VAR) l->a[m++] = l->a[k];
+      }
+      l->len = v->esize[e] = m;
+   }
+   for (i = 0; i < v->n; i++) {
+      if (v->status[i] != AMD_VAR) continue;
+      for (k = d = 0; k < v->el[i].len; k++) {
+         d += v->esize[v->el[i].a[k]] - 1;
+      }
+      v->deg[i] = MIN(d,v->n - 1);
+   }
+   return 0;
+}
+
+static void amd_supervariables(struct amd_vars *v, struct amd_list *lp)
+/**
+ ***  Merges the variables of the new element lp that have the same
+ ***  elements and neighbours. Their hashes have been set.
+ **/
+{
+   int32 k, h, i, j, q, tag, same;
+   for (k = 0; k < lp->len; k++) {
+      i = lp->a[k];
+      if (v->status[i] != AMD_VAR) continue;
+      h = (int32)(v->hash[i] % (uint32)v->n);
+      v->hnext[i] = v->hhead[h];
+      v->hhead[h] = i;
+   }
+   for (k = 0; k < lp->len; k++) {
+      h = (int32)(v->hash[lp->a[k]] % (uint32)v->n);
+      for (i = v->hhead[h]; i >= 0; i = v->hnext[i]) {
+         if (v->status[i] != AMD_VAR) continue;
+         tag = -1;
+         for (j = v->hnext[i]; j >= 0; j = v->hnext[j]) {
+            if (v->status[j] != AMD_VAR || v->hash[j] != v->hash[i]
+                || v->el[j].len != v->el[i].len
+                || v->adj[j].len != v->adj[i].len) {
+               continue;
+            }
+            if (tag < 0) {
+               tag = amd_newtag(v);
+               for (q = 0; q < v->el[i].len; q++) v->mark[v->el[i].a[q]] = tag;
+               for (q = 0; q < v->adj[i].len; q++) v->mark[v->adj[i].a[q]] = tag;
+            }
+            same = 1;
+            for (q = 0; same && q < v->el[j].len; q++) {
+               same = (v->mark[v->el[j].a[q]] == tag);
+            }
+            for (q = 0; same && q < v->adj[j].len; q++) {
+               same = (v->mark[v->adj[j].a[q]] == tag);
+            }
+            if (!same) continue;
+            /* j is indistinguishable from i, so follows it everywhere */
+            v->nv[i] += v->nv[j];
+            v->deg[i] = MAX(v->deg[i] - v->nv[j],0);
+            v->nv[j] = 0;
+            v->status[j] = AMD_DEAD;
+            v->svnext[v->svlast[i]] = j;
+            v->svlast[i] = v->svlast[j];
+            amd_list_free(&(v->el[j]));
+            amd_list_free(&(v->adj[j]));
+         }
+      }
+      v->hhead[h] = -1;
+   }
+}
+
+static int amd_eliminate(struct amd_vars *v, int32 p, int32 nleft)
+/**
+ ***  Eliminates supervariable p, making it the element Lp, and updates the
+ ***  degrees of the variables in Lp. nleft is the size of the variables
+ ***  not yet eliminated, p included.
+ **/
+{
+   struct amd_list lp, *l;
+   int32 k, q, i, e, j, m, tag, dlp, de, da, d, nw;
+   uint32 h;
+
+   /* Lp is everything reachable from p through its elements and edges */
+   lp.a = NULL;
+   lp.len = lp.cap = 0;
+   tag = amd_newtag(v);
+   v->mark[p] = tag;
+   dlp = 0;
+   l = &(v->el[p]);
+   for (k = 0; k < l->len; k++) {
+      e = l->a[k];
+      if (v->status[e] != AMD_ELEMENT) continue;
+      for (q = 0; q < v->el[e].len; q++) {
+         i = v->el[e].a[q];
+         if (v->status[i] != AMD_VAR || v->mark[i] == tag) continue;
+         v->mark[i] = tag;
+         if (amd_push(&lp,i)) {
+            amd_list_free(&lp);
+            return 1;
+         }
+         dlp += v->nv[i];
+      }
+      /* e is absorbed into p */
+      v->status[e] = AMD_DEAD;
+      amd_list_free(&(v->el[e]));
+   }
+   l = &(v->adj[p]);
+   for (k = 0; k < l->len; k++) {
+      i = l->a[k];
+      if (v->status[i] != AMD_VAR || v->mark[i] == tag) continue;
+      v->mark[i] = tag;
+      if (amd_push(&lp,i)) {
+         amd_list_free(&lp);
+         return 1;
+      }
+      dlp += v->nv[i];
+   }
+   amd_list_free(&(v->el[p]));
+   amd_list_free(&(v->adj[p]));
+   v->el[p] = lp;
+   v->status[p] = AMD_ELEMENT;
+   v->esize[p] = dlp;
+
+   /* w(e) = |Le \ Lp| for the other elements met from Lp */
+   nw = 0;
+   for (k = 0; k < lp.len; k++) {
+      i = lp.a[k];
+      amd_list_remove(v,i);
+      l = &(v->el[i]);
+      for (q = 0; q < l->len; q++) {
+         e = l->a[q];
+         if (v->status[e] != AMD_ELEMENT) continue;
+         if (v->w[e] < 0) {
+            v->w[e] = v->esize[e];
+            v->wlist[nw++] = e;
+         }
+         v->w[e] -= v->nv[i];
+      }
+   }
+
+   /* prune the lists of the vars in Lp and bound their degrees */
+   for (k = 0; k < lp.len; k++) {
+      i = lp.a[k];
+      h = 0;
+      de = 0;
+      l = &(v->el[i]);
+      for (q = m = 0; q < l->len; q++) {
+         e = l->a[q];
+         if (v->status[e] != AMD_ELEMENT) continue;
+         if (v->w[e] == 0) {
+            /* Le is inside Lp: aggressive absorption */
+            v->status[e] = AMD_DEAD;
+            amd_list_free(&(v->el[e]));
+            continue;
+         }
+         l->a[m++] = e;
+         de += v->w[e];
+         h += (uint32)e;
+      }
+      l->len = m;
+      if (amd_push(l,p)) return 1;
+      h += (uint32)p;
+      da = 0;
+      l = &(v->adj[i]);
+      for (q = m = 0; q < l->len; q++) {
+         j = l->a[q];
+         if (v->status[j] != AMD_VAR || v->mark[j] == tag) continue;
+         l->a[m++] = j;
+         da += v->nv[j];
+         h += (uint32)j;
+      }
+      l->len = m;
+      d = MIN(v->deg[i],da + de) + dlp - v->nv[i];
+      d = MIN(d,nleft - v->nv[p] - v->nv[i]);
+      v->deg[i] = MAX(d,0);
+      v->hash[i] = h;
+   }
+   for (k = 0; k < nw; k++) v->w[v->wlist[k]] = -1;
+
+   amd_supervariables(v,&(v->el[p]));
+
+   /* put the vars left in Lp back on the degree lists */
+   l = &(v->el[p]);
+   for (k = m = 0; k < l->len; k++) {
+      i = l->a[k];
+      if (v->status[i] != AMD_VAR) continue;
+      l->a[m++] = i;
+      amd_list_insert(v,i);
+   }
+   l->len = m;
+   return 0;
+}
+
+static int amd_order(struct amd_vars *v, int32 *order)
+/**
+ ***  Orders the variables by approximate minimum degree, dense ones last.
+ **/
+{
+   int32 i, p, k, nleft;
+   nleft = 0;
+   for (i = 0; i < v->n; i++) {
+      if (v->status[i] == AMD_VAR) {
+         amd_list_insert(v,i);
+         nleft++;
+      }
+   }
+   k = 0;
+   while (nleft > 0) {
+      while (v->head[v->mindeg] < 0) v->mindeg++;
+      p = v->head[v->mindeg];
+      amd_list_remove(v,p);
+      for (i = p; i >= 0; i = v->svnext[i]) order[k++] = i;
+      if (amd_eliminate(v,p,nleft)) return 1;
+      nleft -= v->nv[p];
+   }
+   for (i = 0; i < v->n; i++) {
+      if (v->status[i] == AMD_DENSE) order[k++] = i;
+   }
+   return 0;
+}
+
+static int amd_reorder(mtx_matrix_t mtx, mtx_region_t *region, int cols)
+/**
+ ***  The region is truncated to the largest square on the diagonal, and
+ ***  reordered by AMD on A+A' or, if cols, by COLAMD.
+ **/
+{
+   struct amd_vars v;
+   mtx_range_t rng;
+   int32 n, k, j, q, dense, *order, *pos, *at;
+
+   square_region(region,&rng);
+   n = rng.high - rng.low + 1;
+   if (n < 2) return 0;
+   if (amd_create(&v,n,cols ? 2*n : n)) return 2;
+   order = ASC_NEW_ARRAY(int32,3*n);
+   if (ISNULL(order)) {
+      amd_destroy(&v);
+      return 2;
+   }
+   dense = MAX(16,(int32)(10.0*sqrt((double)n)));
+   if ((cols ? amd_init_col(&v,mtx,&rng,dense)
+        : amd_init_sym(&v,mtx,&rng,dense))
+       || amd_order(&v,order)) {
+      ascfree(order);
+      amd_destroy(&v);
+      return 2;
+   }
+   amd_destroy(&v);
+
+   /* move the k-th variable chosen to rng.low+k */
+   pos = order + n;
+   at = pos + n;
+   for (k = 0; k < n; k++) pos[k] = at[k] = k;
+   for (k = 0; k < n; k++) {
+      j = order[k];
+      q = pos[j];
+      if (q == k) continue;
+      mtx_swap_rows(mtx,rng.low + k,rng.low + q);
+      mtx_swap_cols(mtx,rng.low + k,rng.low + q);
+      at[q] = at[k];
+      pos[at[q]] = q;
+      at[k] = j;
+      pos[j] = k;
+   }
+   ascfree(order);
+   return 0;
+}
+
+/*********************************
+ end of amd stuff
+*********************************/
+
 
 int mtx_reorder(mtx_matrix_t mtx,mtx_region_t *region,
                 enum mtx_reorder_method m)
@@ -708,6 +1245,10 @@ int mtx_reorder(mtx_matrix_t mtx,mtx_region_t *region,
     return ranki_reorder(mtx,region);
   case mtx_TSPK1:
     return tranki_reorder(mtx,region);
+  case mtx_AMD:
+    return amd_reorder(mtx,region,0);
+  case mtx_COLAMD:
+    return amd_reorder(mtx,region,1);
   case mtx_NATURAL:
     return 0;
   default:
@@ -715,4 +1256,91 @@ int mtx_reorder(mtx_matrix_t mtx,mtx_region_t *region,
     return 1;
   }
 }
+
+real64 mtx_reorder_fill(mtx_matrix_t mtx,mtx_region_t *region,real64 limit)
+{
+   struct amd_list *u;
+   mtx_range_t rng;
+   mtx_coord_t nz;
+   int32 n, i, j, c, k, q, m, top, *mark, *stack, *lrow, *pruned, nl;
+   real64 count;
+
+   if (!mtx_check_matrix(mtx) || region==NULL) {
+      FPRINTF(g_mtxerr,"mtx_reorder_fill called with bad matrix or region\n");
+      return -1.0;
+   }
+   square_region(region,&rng);
+   n = rng.high - rng.low + 1;
+   if (n < 1) return 0.0;
+   u = ASC_NEW_ARRAY_CLEAR(struct amd_list,n);
+   mark = ASC_NEW_ARRAY(int32,4*n);
+   if (ISNULL(u) || ISNULL(mark)) {
+      if (NOTNULL(u)) ascfree(u);
+      if (NOTNULL(mark)) ascfree(mark);
+      return -1.0;
+   }
+   stack = mark + n;
+   lrow = stack + n;
+   pruned = lrow + n;
+   for (k = 0; k < n; k++) mark[k] = pruned[k] = -1;
+
+   /*
+    * Symbolic LU by rows, with pivots on the diagonal: the structure of
+    * row i of L and U is everything reachable from A(i,:) through the rows
+    * of U already found. Once L(i,j) and U(j,i) are both nonzero, the
+    * entries of U(j,:) beyond i are reachable through row i and can be
+    * pruned from the search (Eisenstat and Liu, 1993).
+    */
+   count = 0.0;
+   for (i = 0; i < n && (limit <= 0.0 || count <= limit); i++) {
+      mark[i] = i;
+      count += 1.0;
+      top = nl = 0;
+      nz.row = rng.low + i;
+      nz.col = mtx_FIRST;
+      while (mtx_next_in_row(mtx,&nz,&rng), nz.col != mtx_LAST) {
+         c = nz.col - rng.low;
+         if (mark[c] == i) continue;
+         mark[c] = i;
+         count += 1.0;
+         if (c < i) {
+            stack[top++] = lrow[nl++] = c;
+         } else if (amd_push(&(u[i]),c)) {
+            count = -1.0;
+            break;
+         }
+      }
+      while (top > 0 && count >= 0.0) {
+         j = stack[--top];
+         for (q = 0; q < u[j].len; q++) {
+            c = u[j].a[q];
+            if (c == i) pruned[j] = (pruned[j] < 0) ? -2 : pruned[j];
+            if (mark[c] == i) continue;
+            mark[c] = i;
+            count += 1.0;
+            if (c < i) {
+               stack[top++] = lrow[nl++] = c;
+            } else if (amd_push(&(u[i]),c)) {
+               count = -1.0;
+               break;
+            }
+         }
+      }
+      if (count < 0.0) break;
+      for (k = 0; k < nl; k++) {
+         j = lrow[k];
+         if (pruned[j] != -2) continue;
+         for (q = m = 0; q < u[j].len; q++) {
+            if (u[j].a[q] <= i) u[j].a[m++] = u[j].a[q];
+         }
+         u[j].len = m;
+         pruned[j] = i;
+      }
+   }
+   for (k = 0; k < n; k++) amd_list_free(&(u[k]));
+   ascfree(u);
+   ascfree(mark);
+   return count;
+}
+
 #undef __MTX_C_SEEN__
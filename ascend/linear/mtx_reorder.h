@@ -47,7 +47,9 @@ enum mtx_reorder_method {
   mtx_UNKNOWN,  /**< junk method */
   mtx_SPK1,     /**< Stadtherr's SPK1 reordering */
   mtx_TSPK1,    /**< transpose of Stadtherr's SPK1 reordering */
-  mtx_NATURAL   /**< kinda pointless, don't you think? */
+  mtx_NATURAL,  /**< kinda pointless, don't you think? */
+  mtx_AMD,      /**< approximate minimum degree on A+A' */
+  mtx_COLAMD    /**< approximate minimum degree on A'A, column-wise */
 };
 
 ASC_DLLSPEC int mtx_reorder(mtx_matrix_t mtx,
@@ -82,6 +84,15 @@ ASC_DLLSPEC int mtx_reorder(mtx_matrix_t mtx,
  ***            decent of it, but good results are improbable.
  ***   - Natural: Blesses the system and does nothing.
  ***              Again, the rows/cols not in the diagonal are dependent.
+ ***   - AMD:
+ ***   - COLAMD: Fill-reducing orderings for large blocks that are not
+ ***            nearly triangular, as from discretised models, where
+ ***            SPK1 leaves a great many spikes. AMD is approximate
+ ***            minimum degree on the pattern of A+A', COLAMD the same on
+ ***            A'A (formed implicitly), which suits very unsymmetric
+ ***            patterns. Both permute the rows and columns of the square
+ ***            region symmetrically, so a full diagonal stays full.
+ ***            Very dense rows/columns are left to the end.
  ***
  ***  On reordering in general: 'Optimal' reordering is an NP complete
  ***  task. Real reordering methods are heuristic and tend to break down
@@ -91,6 +102,23 @@ ASC_DLLSPEC int mtx_reorder(mtx_matrix_t mtx,
  ***  Return 0 if ok, 1 if bad input detected, 2 if unable to do.
  **/
 
+ASC_DLLSPEC real64 mtx_reorder_fill(mtx_matrix_t mtx, mtx_region_t *region,
+                                   real64 limit);
+/**<
+ ***  Predicts the number of nonzeros in the L and U factors (diagonal
+ ***  included) of the largest square of the region on the diagonal,
+ ***  as it is currently ordered, from a symbolic factorization with the
+ ***  pivots taken on the diagonal. Numerical pivoting will change this
+ ***  somewhat, but the count is a fair basis on which to choose between
+ ***  orderings (eg SPK1 and AMD) for each block, after mtx_reorder.
+ ***
+ ***  The time taken grows with the count, though it is well short of that
+ ***  taken to factor. If limit is positive, counting stops as soon as
+ ***  limit is passed, and a number greater than limit is returned.
+ ***
+ ***  Returns -1 if the matrix or region is bad or memory runs out.
+ **/
+
 /** @} */
 
 #endif /* ASC_MTX_REORDER_H */
@@ -56,6 +56,21 @@ struct element_t *mtx_find_element(mtx_matrix_t mtx, int32 org_row,
    return(elt);
 }
 
+struct element_t *mtx_frozen_find(mtx_matrix_t mtx,
+                                  int32 org_row, int32 org_col)
+{
+  struct frozen_data_t *fz = mtx->frozen;
+  struct element_t *elt, *end;
+
+  if( ISNULL(fz) ) return NULL;
+  elt = fz->elts + fz->rowptr[org_row];
+  end = fz->elts + fz->rowptr[org_row+1];
+  for( ; elt < end ; ++elt )
+    if( elt->col == org_col )
+      return elt;
+  return NULL;
+}
+
 struct element_t *mtx_create_element(mtx_matrix_t mtx,
                                      int32 org_row, int32 org_col)
 /**
@@ -65,6 +80,13 @@ struct element_t *mtx_create_element(mtx_matrix_t mtx,
 {
   struct element_t *elt;
 
+  if( NOTNULL(mtx->frozen) ) {
+    if( NOTNULL(elt = mtx_frozen_find(mtx,org_row,org_col)) ) {
+      elt->value = 0.0;
+      return elt;
+    }
+    mtx->frozen->misses++;
+  }
 #if MTX_DEBUG
   if( NOTNULL(mtx_find_element(mtx,org_row,org_col)) ) {
 
@@ -90,6 +112,13 @@ struct element_t *mtx_create_element_value(mtx_matrix_t mtx,
 {
   struct element_t *elt;
 
+  if( NOTNULL(mtx->frozen) ) {
+    if( NOTNULL(elt = mtx_frozen_find(mtx,org_row,org_col)) ) {
+      elt->value = val;
+      return elt;
+    }
+    mtx->frozen->misses++;
+  }
 #if MTX_DEBUG
   if( NOTNULL(mtx_find_element(mtx,org_row,org_col)) ) {
 
@@ -170,8 +199,8 @@ void mtx_free_perm(int32 *perm)
 }
 
 /* some local scope globals to keep memory so we aren't constantly
-   reallocating */
-struct reusable_data_vector
+   reallocating. Each thread has its own. */
+ASC_THREAD_LOCAL struct reusable_data_vector
   g_mtx_null_index_data = {NULL,0,sizeof(int32),0},
   g_mtx_null_sum_data = {NULL,0,sizeof(real64),0},
   g_mtx_null_mark_data = {NULL,0,sizeof(char),0},
@@ -208,6 +208,25 @@ struct structural_data_t {
  ***  A matrix of capacity 0 doesn't have a mem_store_t yet and elements
  ***  cannot be queried about without a core dump.
  **/
+/**<
+ *** Packed storage of a matrix whose incidence pattern has been frozen by
+ *** mtx_freeze. The elements of each org row occupy the contiguous slots
+ *** rowptr[row]..rowptr[row+1]-1 of elts, in the order in which they were
+ *** originally filled. The slots remain linked into the usual row and
+ *** column lists, so everything that walks the fishnet works unchanged.
+ *** Elements created after the freeze (eg fill-in) come from ms as usual.
+ **/
+struct frozen_data_t {
+  int32 nnz;                      /**< Number of slots */
+  struct element_t *elts;         /**< The slots, grouped by org row */
+  int32 *rowptr;                  /**< capacity+1 slot offsets */
+  int32 misses;                   /**< elements created outside the slots */
+};
+
+#define IS_FROZEN_ELT(fz,e) \
+  ((fz)!=NULL && (e)>=(fz)->elts && (e)<(fz)->elts+(fz)->nnz)
+/**<  Returns 1 if e is one of the packed slots of frozen data fz. */
+
 struct mtx_header {
   int integrity;                  /**< Integrity integer */
   int32 order;                    /**< Order of the matrix */
@@ -220,6 +239,7 @@ struct mtx_header {
   struct structural_data_t *data; /**< Pointer to structural information */
   mtx_matrix_t master;            /**< the master of this mtx, if slave */
   mtx_matrix_t *slaves;           /**< array of slave matrices */
+  struct frozen_data_t *frozen;   /**< packed elements, if frozen */
 };
 
 /**<
@@ -317,6 +337,15 @@ struct element_t *mtx_find_element(mtx_matrix_t mtx,
  ***  and org_col are legal indices. May crash if they are not.
  **/
 
+struct element_t *mtx_frozen_find(mtx_matrix_t mtx,
+                                  int32 org_row,
+                                  int32 org_col);
+/**<
+ ***  Searches the packed slots of the given org row of a frozen matrix
+ ***  for org_col, returning NULL if it is not there or mtx is not frozen.
+ ***  It is *ASSUMED* that org_row and org_col are legal indices.
+ **/
+
 struct element_t *mtx_create_element(mtx_matrix_t mtx,
                                      int32 org_row,
                                      int32 org_col);
@@ -327,6 +356,8 @@ struct element_t *mtx_create_element(mtx_matrix_t mtx,
  ***  and org_col are legal indices. May crash if they are not.
  ***  If mtx_DEBUG is TRUE, then we will whine if the element already
  ***  exists, but go ahead and create it anyway.
+ ***  If the matrix is frozen and has a slot for the element, the slot
+ ***  is reused instead.
  **/
 
 struct element_t *mtx_create_element_value(mtx_matrix_t mtx,
@@ -340,6 +371,8 @@ struct element_t *mtx_create_element_value(mtx_matrix_t mtx,
  ***  and org_col are legal indices. May crash if they are not.
  ***  If mtx_DEBUG is TRUE, then we will whine if the element already
  ***  exists, but go ahead and create it anyway.
+ ***  If the matrix is frozen and has a slot for the element, the slot
+ ***  is reused instead.
  **/
 
 /* ************************************************************************ *\
@@ -401,7 +434,7 @@ struct reusable_data_vector {
                          should be 0 if the array is not in use. */
 };
 
-extern struct reusable_data_vector
+extern ASC_THREAD_LOCAL struct reusable_data_vector
   g_mtx_null_index_data,      /**< bunch of int32 */
   g_mtx_null_sum_data,        /**< bunch of mtx_value_t */
   g_mtx_null_mark_data,       /**< bunch of char */
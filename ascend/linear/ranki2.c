@@ -187,6 +187,7 @@ static void rankikw2_factor(linsolqr_system_t sys)
       if( pivot < sys->smallest_pivot )  {
         sys->smallest_pivot = pivot;
       }
+      sys->ludata->seqstep[mtx_col_to_org(mtx,nz.row)] = nz.row;
 #if RBADEBUG
       FPRINTF(gscr,"Cheap pivot col %d (org %d)\n",
         nz.row, mtx_col_to_org(mtx,nz.row));
@@ -231,6 +232,7 @@ static void rankikw2_factor(linsolqr_system_t sys)
     } else {
       /* Independent row: nz contains selected pivot */
       mtx_swap_cols(mtx, nz.row, nz.col);   /* this Fixes U as well */
+      sys->ludata->seqstep[mtx_col_to_org(mtx,nz.row)] = nz.row;
       /* Move pivot to diagonal */
       mtx_drag(mtx, nz.row, sys->rng.low ); /* this Fix U as well */
       number_drag(pivots, nz.row, sys->rng.low);
@@ -588,6 +590,221 @@ int kirk1_factor(linsolqr_system_t sys,
 
 #endif /* BUILD_KIRK_CODE */
 
+/*
+ * Refactoring with a recorded pivot sequence.
+ *
+ * In the final ordering of a ranki2 factorization the copy of coef
+ * satisfies A = U * L, with L (sys->factors, the pivots kept apart in
+ * pivlist) lower triangular and U (sys->inverse, multipliers only) unit
+ * upper triangular. Given the order, row k of L is row k of A less the
+ * rows j > k of L times the multipliers U(k,j), taking j from the bottom
+ * up. That is all ranki2_refactor does; the pivot sequence found by
+ * rankiba2_factor or rankikw2_factor is recorded by ranki2_record, with
+ * ludata->seqstep noted by the factor routines as they accept pivots.
+ */
+
+/*
+ * Max-heap of the cur cols waiting to be eliminated from a row, so they
+ * are taken bottom-up without a dense sweep over the range.
+ */
+static void refactor_heap_push(int32 *heap, int32 *len, int32 col)
+{
+  int32 i, parent;
+  i = (*len)++;
+  while (i > 0) {
+    parent = (i-1)/2;
+    if (heap[parent] >= col) break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = col;
+}
+
+static int32 refactor_heap_pop(int32 *heap, int32 *len)
+{
+  int32 top, last, i, child;
+  top = heap[0];
+  last = heap[--(*len)];
+  i = 0;
+  while ((child = 2*i+1) < *len) {
+    if (child+1 < *len && heap[child+1] > heap[child]) child++;
+    if (last >= heap[child]) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+/*
+ * Saves the pivot order of a full rank factorization just completed.
+ */
+static void ranki2_record(linsolqr_system_t sys)
+{
+  struct lu_auxdata *lu = sys->ludata;
+  int32 k;
+
+  lu->recorded = FALSE;
+  if (!sys->reuse_pivots || ISNULL(lu->seqrow) ||
+      sys->rank != sys->rng.high - sys->rng.low + 1) {
+    return;
+  }
+  for (k = sys->rng.low; k <= sys->rng.high; k++) {
+    lu->seqrow[k] = mtx_row_to_org(sys->factors,k);
+    lu->seqcol[k] = mtx_col_to_org(sys->factors,k);
+  }
+  lu->seqrng = sys->rng;
+  lu->seqmethod = sys->fmethod;
+  lu->recorded = TRUE;
+}
+
+static boolean ranki2_can_refactor(linsolqr_system_t sys)
+{
+  struct lu_auxdata *lu = sys->ludata;
+  return (sys->reuse_pivots && lu->recorded &&
+          lu->seqmethod == sys->fmethod &&
+          lu->seqrng.low == sys->rng.low &&
+          lu->seqrng.high == sys->rng.high);
+}
+
+/*
+ * Factors the fresh copy in sys->factors in the recorded order.
+ * Returns 0 if done, or 1 if the copy does not fit the sequence or a
+ * pivot fails the tolerances, in which case sys->factors and
+ * sys->inverse are left partly factored and must be recopied.
+ * tmp and mark are left clean either way.
+ */
+static int ranki2_refactor(linsolqr_system_t sys, mtx_sparse_t *sp)
+{
+  struct lu_auxdata *lu = sys->ludata;
+  mtx_matrix_t mtx = sys->factors;
+  mtx_matrix_t upper_mtx = sys->inverse;
+  real64 *tmp = lu->tmp;
+  real64 *pivots = lu->pivlist;
+  int32 *heap = lu->heap;
+  int32 *mark = lu->mark;
+  int32 low = sys->rng.low, high = sys->rng.high;
+  int32 k, i, j, c, len, nheap, nleft, step;
+  real64 mult, pivot, rowmax;
+  mtx_coord_t nz;
+
+  /* permute the copy into the recorded order */
+  for (k = low; k <= high; k++) {
+    i = mtx_org_to_row(mtx,lu->seqrow[k]);
+    j = mtx_org_to_col(mtx,lu->seqcol[k]);
+    if (i < k || i > high || j < k || j > high) {
+      return 1;
+    }
+    if (i != k) mtx_swap_rows(mtx,k,i);
+    if (j != k) mtx_swap_cols(mtx,k,j);
+  }
+
+  sys->smallest_pivot = MAXDOUBLE;
+  for (k = high; k >= low; k--) {
+    /* row k of A. cols right of k go on the heap, which cannot grow
+     * past high-k entries; the rest, the row of L, are listed from the
+     * top end of the same array down. */
+    mtx_steal_cur_row_sparse(mtx,k,sp,mtx_ALL_COLS);
+    nheap = nleft = 0;
+    for (i = 0; i < sp->len; i++) {
+      c = sp->idata[i];
+      tmp[c] = sp->data[i];
+      mark[c] = 1;
+      if (c > k) {
+        refactor_heap_push(heap,&nheap,c);
+      } else {
+        heap[high - nleft++] = c;
+      }
+    }
+    nz.row = k;
+    while (nheap > 0) {
+      j = refactor_heap_pop(heap,&nheap);
+      if (tmp[j] != D_ZERO) {
+        mult = tmp[j] / pivots[j];
+        mtx_cur_row_sparse(mtx,j,sp,mtx_ALL_COLS,mtx_IGNORE_ZEROES);
+        for (i = 0; i < sp->len; i++) {
+          c = sp->idata[i];
+          if (mark[c]) {
+            tmp[c] -= mult * sp->data[i];
+          } else {
+            tmp[c] = -mult * sp->data[i];
+            mark[c] = 1;
+            if (c > k) {
+              refactor_heap_push(heap,&nheap,c);
+            } else {
+              heap[high - nleft++] = c;
+            }
+          }
+        }
+        nz.col = j;
+        mtx_fill_value(upper_mtx,&nz,mult);
+      }
+      mark[j] = 0;
+    }
+    /* as in the full search, ptol applies over the cols that were still
+     * unpivoted when row k took its pivot */
+    pivot = mark[k] ? tmp[k] : D_ZERO;
+    rowmax = D_ZERO;
+    step = lu->seqstep[lu->seqcol[k]];
+    for (i = 0; i < nleft; i++) {
+      c = heap[high - i];
+      if (lu->seqstep[lu->seqcol[c]] >= step && fabs(tmp[c]) > rowmax) {
+        rowmax = fabs(tmp[c]);
+      }
+    }
+    len = nleft;
+    if (fabs(pivot) <= sys->pivot_zero || fabs(pivot) < sys->ptol * rowmax) {
+      for (i = 0; i < len; i++) {
+        mark[heap[high - i]] = 0;
+      }
+      return 1;
+    }
+    for (i = 0; i < len; i++) {
+      c = heap[high - i];
+      mark[c] = 0;
+      if (c != k && fabs(tmp[c]) > sys->dtol) {
+        nz.col = c;
+        mtx_fill_value(mtx,&nz,tmp[c]);
+      }
+    }
+    pivots[k] = pivot;
+    if (fabs(pivot) < sys->smallest_pivot) {
+      sys->smallest_pivot = fabs(pivot);
+    }
+  }
+  sys->rank = high - low + 1;
+  return 0;
+}
+
+/*
+ * Replays the recorded sequence on the fresh copy in sys->factors.
+ * Returns 0 if that factored it, otherwise forgets the sequence, puts
+ * back a clean copy of the region and returns 1 so that the caller
+ * does a full factorization.
+ */
+static int ranki2_try_refactor(linsolqr_system_t sys, mtx_region_t *region)
+{
+  mtx_sparse_t *sp;
+  int failed;
+
+  sp = mtx_create_sparse(sys->capacity);
+  failed = (sp == NULL || ranki2_refactor(sys,sp));
+  if (sp != NULL) mtx_destroy_sparse(sp);
+  if (!failed) {
+    sys->ludata->refactors++;
+    return 0;
+  }
+  sys->ludata->fallbacks++;
+  sys->ludata->recorded = FALSE;
+  mtx_destroy(sys->inverse);
+  mtx_destroy(sys->factors);
+  sys->factors = mtx_copy_region(sys->coef,region);
+  sys->inverse = mtx_create_slave(sys->factors);
+  sys->rank = -1;
+  sys->smallest_pivot = MAXDOUBLE;
+  return 1;
+}
+
 /*
  * This is the entry point for all the ranki2_* schemes
  * which make use of a 2 bodied matrix.
@@ -633,25 +850,29 @@ int ranki2_entry(linsolqr_system_t sys, mtx_region_t *region){
   ensure_lu_capacity(sys);
 
   comptime = tm_cpu_time();
-  switch(sys->fmethod) {
-  case ranki_ba2:
-    rankiba2_factor(sys);
-    break;
-  case ranki_kw2:
-    rankikw2_factor(sys);
-    break;
-  case ranki_jz2:
-    rankijz2_factor(sys);
-    break;
+  if (!ranki2_can_refactor(sys) || ranki2_try_refactor(sys,region)) {
+    switch(sys->fmethod) {
+    case ranki_ba2:
+      rankiba2_factor(sys);
+      ranki2_record(sys);
+      break;
+    case ranki_kw2:
+      rankikw2_factor(sys);
+      ranki2_record(sys);
+      break;
+    case ranki_jz2:
+      rankijz2_factor(sys);
+      break;
 
 #ifdef BUILD_KIRK_CODE
-  case ranki_ka:
-    kirk1_factor(sys,region,2);
-    break;
+    case ranki_ka:
+      kirk1_factor(sys,region,2);
+      break;
 #endif /* BUILD_KIRK_CODE */
 
-  default:
-    return 1;
+    default:
+      return 1;
+    }
   }
   sys->factored = TRUE;
 
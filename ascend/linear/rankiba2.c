@@ -996,6 +996,7 @@ void rankiba2_factor(linsolqr_system_t sys){
         pdata[org.col].relative_location = 0;
       }
       pivots[org.col] = pivot;
+      sys->ludata->seqstep[org.col] = nz.row;
 #if RBADEBUG
       FPRINTF(gscr,"Cheap pivot col %d (org %d)\n",nz.row,org.col);
 #endif
@@ -1106,6 +1107,7 @@ void rankiba2_factor(linsolqr_system_t sys){
       if( pivotsize < sys->smallest_pivot ) {
 	sys->smallest_pivot = pivotsize;
       }
+      sys->ludata->seqstep[org.col] = nz.row;
       ++(nz.row);
     }
     pivots[org.col] = pivot;
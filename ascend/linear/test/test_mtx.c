@@ -21,6 +21,7 @@
 
 #include <ascend/general/platform.h>
 #include <ascend/linear/mtx_csparse.h>
+#include <ascend/general/ascMalloc.h>
 
 #include <test/common.h>
 #include <test/assertimpl.h>
@@ -77,11 +78,212 @@ static void test_csparse(void){
 #endif
 }
 
+/*
+	Test packed ('frozen') storage: values and incidence must look the same
+	as before packing, clearing a region must keep the pattern, and the
+	slots must be found in the order in which they were first filled.
+*/
+static void test_freeze(void){
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_region_t G;
+	int32 s, t;
+	unsigned long prior_meminuse = ascmeminuse();
+
+	M = mtx_create();
+	CU_TEST(mtx_freeze(M)==1); /* no capacity yet */
+	mtx_set_order(M,3);
+	/* fill rows out of order, columns in the order 2, 0 */
+	mtx_fill_org_value(M,mtx_coord(&C,1,2), 4.0);
+	mtx_fill_org_value(M,mtx_coord(&C,1,0), 2.0);
+	mtx_fill_org_value(M,mtx_coord(&C,0,0), 1.0);
+	mtx_fill_org_value(M,mtx_coord(&C,2,1), 6.0);
+	mtx_fill_org_value(M,mtx_coord(&C,2,2), 7.0);
+	CU_TEST(!mtx_is_frozen(M));
+
+	CU_TEST(mtx_freeze(M)==0);
+	CU_TEST(mtx_is_frozen(M));
+	CU_TEST(mtx_frozen_nnz(M)==5);
+	CU_TEST(mtx_frozen_misses(M)==0);
+	CU_TEST(mtx_nonzeros_in_region(M,mtx_ENTIRE_MATRIX)==5);
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,2))==4.0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,2,1))==6.0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,0,1))==0.0);
+	CU_TEST(mtx_nonzeros_in_col(M,0,mtx_ALL_ROWS)==2);
+
+	/* slots of row 1 are in fill order, so hints make single compares */
+	s = mtx_frozen_org_slot(M,mtx_coord(&C,1,2),-1);
+	CU_TEST(s>=0);
+	t = mtx_frozen_org_slot(M,mtx_coord(&C,1,0),s+1);
+	CU_TEST(t==s+1);
+	CU_TEST(mtx_frozen_org_slot(M,mtx_coord(&C,1,2),t+1)==s); /* wraps */
+	CU_TEST(mtx_frozen_org_slot(M,mtx_coord(&C,1,1),s)==-1);
+
+	/* clearing zeroes the region but keeps the pattern */
+	mtx_region(&G,1,2,0,2);
+	mtx_clear_region(M,&G);
+	CU_TEST(mtx_is_frozen(M));
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,2))==0.0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,0,0))==1.0);
+	mtx_frozen_set_slot(M,t,-2.0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,0))==-2.0);
+
+	/* refill reuses the slots; new incidence counts as a miss */
+	mtx_fill_org_value(M,mtx_coord(&C,1,2), 5.0);
+	mtx_fill_org_value(M,mtx_coord(&C,1,1), 3.0);
+	CU_TEST(mtx_frozen_misses(M)==1);
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,2))==5.0);
+	CU_TEST(mtx_nonzeros_in_row(M,1,mtx_ALL_COLS)==3);
+
+	/* repacking takes in the new element */
+	CU_TEST(mtx_freeze(M)==0);
+	CU_TEST(mtx_frozen_nnz(M)==6);
+	CU_TEST(mtx_frozen_misses(M)==0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,1))==3.0);
+
+	/* deleting an element unpacks the matrix */
+	mtx_clear_coord(M,1,1);
+	CU_TEST(!mtx_is_frozen(M));
+	CU_TEST(mtx_nonzeros_in_region(M,mtx_ENTIRE_MATRIX)==5);
+	CU_TEST(mtx_numbers_in_region(M,mtx_ENTIRE_MATRIX)==3);
+	CU_TEST(mtx_value(M,mtx_coord(&C,1,2))==5.0);
+	CU_TEST(mtx_value(M,mtx_coord(&C,0,0))==1.0);
+
+	/* clearing everything discards the packing */
+	CU_TEST(mtx_freeze(M)==0);
+	mtx_clear_region(M,mtx_ENTIRE_MATRIX);
+	CU_TEST(!mtx_is_frozen(M));
+	CU_TEST(mtx_nonzeros_in_region(M,mtx_ENTIRE_MATRIX)==0);
+
+	mtx_fill_org_value(M,mtx_coord(&C,0,1), 1.0);
+	CU_TEST(mtx_freeze(M)==0);
+	mtx_destroy(M);
+	CU_TEST(prior_meminuse == ascmeminuse());
+}
+
+/* k x k grid, 5-point stencil, numbered row by row */
+static mtx_matrix_t grid_mtx(int32 k){
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	int32 i, j, p;
+	M = mtx_create();
+	mtx_set_order(M,k*k);
+	for(i=0;i<k;++i){
+		for(j=0;j<k;++j){
+			p = i*k + j;
+			mtx_fill_org_value(M,mtx_coord(&C,p,p), 4.0);
+			if(j>0)mtx_fill_org_value(M,mtx_coord(&C,p,p-1), -1.0);
+			if(j<k-1)mtx_fill_org_value(M,mtx_coord(&C,p,p+1), -1.0);
+			if(i>0)mtx_fill_org_value(M,mtx_coord(&C,p,p-k), -1.0);
+			if(i<k-1)mtx_fill_org_value(M,mtx_coord(&C,p,p+k), -1.0);
+		}
+	}
+	return M;
+}
+
+/* rows must have moved with their diagonal columns, values unchanged */
+static int symmetric_perm_ok(mtx_matrix_t M, mtx_region_t *G){
+	mtx_coord_t C;
+	int32 i;
+	for(i=G->row.low;i<=G->row.high;++i){
+		if(mtx_row_to_org(M,i) != mtx_col_to_org(M,i))return 0;
+		if(mtx_value(M,mtx_coord(&C,i,i)) == 0.0)return 0;
+	}
+	return 1;
+}
+
+/*
+	Test the fill-reducing orderings and the fill prediction.
+*/
+static void test_reorder(void){
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_region_t G;
+	int32 i, n = 12, k = 30;
+	real64 natural, reordered, amdfill, spk1;
+	unsigned long prior_meminuse = ascmeminuse();
+
+	/* arrow with its head first fills in completely, unless moved last */
+	M = mtx_create();
+	mtx_set_order(M,n);
+	for(i=0;i<n;++i){
+		mtx_fill_org_value(M,mtx_coord(&C,i,i), 1.0);
+		if(i){
+			mtx_fill_org_value(M,mtx_coord(&C,0,i), 1.0);
+			mtx_fill_org_value(M,mtx_coord(&C,i,0), 1.0);
+		}
+	}
+	mtx_region(&G,0,n-1,0,n-1);
+	CU_TEST(mtx_reorder_fill(M,&G,0.0) == (real64)(n*n));
+	CU_TEST(mtx_reorder(M,&G,mtx_AMD)==0);
+	CU_TEST(symmetric_perm_ok(M,&G));
+	CU_TEST(mtx_reorder_fill(M,&G,0.0) == (real64)(3*n-2));
+	CU_TEST(mtx_row_to_org(M,n-1)==0 || mtx_row_to_org(M,n-2)==0);
+	mtx_destroy(M);
+
+	/* no fill in a lower triangle, except below a spike in the last column */
+	M = mtx_create();
+	mtx_set_order(M,n);
+	for(i=0;i<n;++i){
+		mtx_fill_org_value(M,mtx_coord(&C,i,i), 1.0);
+		if(i)mtx_fill_org_value(M,mtx_coord(&C,i,0), 1.0);
+		if(i>1)mtx_fill_org_value(M,mtx_coord(&C,i,i-1), 1.0);
+	}
+	CU_TEST(mtx_reorder_fill(M,&G,0.0) == (real64)(3*n-3));
+	mtx_fill_org_value(M,mtx_coord(&C,1,n-1), 1.0);
+	CU_TEST(mtx_reorder_fill(M,&G,0.0) == (real64)(3*n-3 + n-2));
+	CU_TEST(mtx_reorder_fill(M,&G,n) > n);
+	mtx_destroy(M);
+
+	/* grid: minimum degree does much better than the band */
+	M = grid_mtx(k);
+	mtx_region(&G,0,k*k-1,0,k*k-1);
+	natural = mtx_reorder_fill(M,&G,0.0);
+	CU_TEST(natural > 2.0*k*k*k - 4.0*k*k); /* band fills in */
+	CU_TEST(mtx_reorder(M,&G,mtx_AMD)==0);
+	CU_TEST(symmetric_perm_ok(M,&G));
+	reordered = mtx_reorder_fill(M,&G,0.0);
+	CONSOLE_DEBUG("grid %dx%d: natural fill %g, AMD %g",k,k,natural,reordered);
+	CU_TEST(reordered > 0 && reordered < 0.5*natural);
+	amdfill = reordered;
+	mtx_destroy(M);
+
+	M = grid_mtx(k);
+	CU_TEST(mtx_reorder(M,&G,mtx_COLAMD)==0);
+	CU_TEST(symmetric_perm_ok(M,&G));
+	reordered = mtx_reorder_fill(M,&G,0.0);
+	CONSOLE_DEBUG("grid %dx%d: COLAMD %g",k,k,reordered);
+	/* ordering A'A is not as good for the symmetric case, but still helps */
+	CU_TEST(reordered > 0 && reordered < 0.75*natural);
+	mtx_destroy(M);
+
+	M = grid_mtx(k);
+	CU_TEST(mtx_reorder(M,&G,mtx_SPK1)==0);
+	spk1 = mtx_reorder_fill(M,&G,0.0);
+	CONSOLE_DEBUG("grid %dx%d: SPK1 %g",k,k,spk1);
+	CU_TEST(spk1 > amdfill);
+	mtx_destroy(M);
+
+	/* orderings work on a region within a bigger matrix */
+	M = grid_mtx(k);
+	mtx_region(&G,k,2*k*k/3,k,2*k*k/3);
+	CU_TEST(mtx_reorder(M,&G,mtx_AMD)==0);
+	CU_TEST(symmetric_perm_ok(M,&G));
+	for(i=0;i<k;++i){
+		CU_TEST(mtx_row_to_org(M,i)==i && mtx_col_to_org(M,i)==i);
+	}
+	mtx_destroy(M);
+
+	CU_TEST(prior_meminuse == ascmeminuse());
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T) \
-	T(csparse)
+	T(csparse) \
+	T(freeze) \
+	T(reorder)
 
 REGISTER_TESTS_SIMPLE(linear_mtx, TESTS)
 
@@ -18,6 +18,7 @@
 	Unit test functions for linear/linsolqr.c
 */
 #include <string.h>
+#include <math.h>
 
 #include <ascend/general/platform.h>
 #include <ascend/linear/linsolqr.h>
@@ -161,13 +162,119 @@ static void test_qr3x3(void){
 	mtx_destroy(M);
 }
 
+static void set_org_value(mtx_matrix_t M, int32 row, int32 col, real64 value){
+	mtx_coord_t C;
+	mtx_set_value(M,mtx_coord(&C,mtx_org_to_row(M,row),mtx_org_to_col(M,col)),value);
+}
+
+/* solve with rhs = A*[1 2 3 4] and return the largest error in x */
+static real64 solve_error(linsolqr_system_t L, real64 A[4][4]){
+	real64 b[4], x[4], err = 0.0;
+	int i,j;
+	for(i=0;i<4;++i){
+		b[i] = 0.0;
+		for(j=0;j<4;++j)b[i] += A[i][j]*(j+1);
+	}
+	linsolqr_add_rhs(L,b,FALSE);
+	linsolqr_solve(L,b);
+	linsolqr_copy_solution(L,b,x);
+	linsolqr_remove_rhs(L,b);
+	for(i=0;i<4;++i){
+		if(fabs(x[i]-(i+1)) > err)err = fabs(x[i]-(i+1));
+	}
+	return err;
+}
+
+/*
+	Refactoring with the pivot sequence of the previous factorization,
+	and falling back to a full factorization when a pivot becomes too small.
+	The matrix has a spike in its last column, so U is not empty.
+
+	[ 4 0 0 1
+	  1 3 0 1
+	  0 1 5 1
+	  2 0 1 2 ]
+*/
+static void test_refactor(void){
+	real64 A[4][4] = {{4,0,0,1},{1,3,0,1},{0,1,5,1},{2,0,1,2}};
+	linsolqr_system_t L;
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_region_t G;
+	int32 refactors, fallbacks, pc;
+	int i,j;
+
+	M = mtx_create();
+	mtx_set_order(M,4);
+	for(i=0;i<4;++i)for(j=0;j<4;++j){
+		if(A[i][j]!=0)mtx_fill_org_value(M,mtx_coord(&C,i,j),A[i][j]);
+	}
+	mtx_region(&G,0,3,0,3);
+
+	L = linsolqr_create_default();
+	CU_TEST(linsolqr_pivot_reuse(L));
+	linsolqr_set_matrix(L,M);
+	linsolqr_set_region(L,G);
+	linsolqr_prep(L,linsolqr_fmethod_to_fclass(linsolqr_fmethod(L)));
+	linsolqr_reorder(L, &G, linsolqr_rmethod(L));
+	linsolqr_factor(L,linsolqr_fmethod(L));
+	CU_TEST(linsolqr_rank(L)==4);
+	CU_TEST(solve_error(L,A) < 1e-12);
+	linsolqr_refactor_stats(L,&refactors,&fallbacks);
+	CU_TEST(refactors==0 && fallbacks==0);
+
+	/* new values, same structure: the recorded sequence is replayed */
+	for(i=0;i<4;++i)for(j=0;j<4;++j){
+		if(A[i][j]!=0){
+			A[i][j] *= 1.0 + 0.01*(i+2*j);
+			set_org_value(M,i,j,A[i][j]);
+		}
+	}
+	linsolqr_matrix_was_changed(L);
+	linsolqr_factor(L,linsolqr_fmethod(L));
+	linsolqr_refactor_stats(L,&refactors,&fallbacks);
+	CU_TEST(refactors==1 && fallbacks==0);
+	CU_TEST(linsolqr_rank(L)==4);
+	CU_TEST(solve_error(L,A) < 1e-12);
+
+	/* make the pivot of row 0 useless: a full pivot search is needed */
+	pc = linsolqr_org_row_to_org_col(L,0);
+	A[0][pc] = 1e-14;
+	set_org_value(M,0,pc,A[0][pc]);
+	linsolqr_matrix_was_changed(L);
+	linsolqr_factor(L,linsolqr_fmethod(L));
+	linsolqr_refactor_stats(L,&refactors,&fallbacks);
+	CU_TEST(refactors==1 && fallbacks==1);
+	CU_TEST(linsolqr_rank(L)==4);
+	CU_TEST(solve_error(L,A) < 1e-10);
+
+	/* that found a new sequence, which is used from then on */
+	linsolqr_matrix_was_changed(L);
+	linsolqr_factor(L,linsolqr_fmethod(L));
+	linsolqr_refactor_stats(L,&refactors,&fallbacks);
+	CU_TEST(refactors==2 && fallbacks==1);
+	CU_TEST(solve_error(L,A) < 1e-10);
+
+	/* unless reuse is turned off */
+	linsolqr_set_pivot_reuse(L,FALSE);
+	linsolqr_matrix_was_changed(L);
+	linsolqr_factor(L,linsolqr_fmethod(L));
+	linsolqr_refactor_stats(L,&refactors,&fallbacks);
+	CU_TEST(refactors==2 && fallbacks==1);
+	CU_TEST(solve_error(L,A) < 1e-10);
+
+	linsolqr_destroy(L);
+	mtx_destroy(M);
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T)\
 	T(qr1x1) \
 	T(qr2x2) \
-	T(qr3x3)
+	T(qr3x3) \
+	T(refactor)
 
 REGISTER_TESTS_SIMPLE(linear_qrrank, TESTS)
 
@@ -192,6 +192,7 @@ int Compute_J(slv_system_t sys)
   struct rel_relation **rlist;
   int nrows;
   real64 resid;
+  mtx_region_t region;
 
   /*
    * Get the linear system from the solve system.
@@ -208,16 +209,24 @@ int Compute_J(slv_system_t sys)
   vfilter.matchvalue =  vfilter.matchbits ;
 
   /*
-   * Clear the entire matrix and then compute
-   * the gradients at the current point.
+   * Clear the matrix and then compute the gradients at the current point.
+   * The region covers the whole matrix but, unlike mtx_ENTIRE_MATRIX,
+   * keeps a frozen pattern, so repeated calls (one per LSODE Jacobian)
+   * just overwrite the packed elements. Freeze it once the pattern is
+   * known, and repack when the solver has added enough elements outside
+   * it, as QRSlv does for its blocks.
    */
-  mtx_clear_region(mtx,mtx_ENTIRE_MATRIX);
+  mtx_region(&region,0,mtx_order(mtx)-1,0,mtx_order(mtx)-1);
+  mtx_clear_region(mtx,&region);
   for(row=0; row<nrows; row++) {
     struct rel_relation *rel;
     rel = rlist[mtx_row_to_org(mtx,row)];
 	asc_assert(rel!=NULL);
     (void)relman_diffs(rel,&vfilter,mtx,&resid,1);
   }
+  if(!mtx_is_frozen(mtx) || 4*mtx_frozen_misses(mtx) > mtx_frozen_nnz(mtx)){
+    mtx_freeze(mtx);
+  }
   linsolqr_matrix_was_changed(lqr_sys);
 
   return(!calc_ok);
@@ -432,10 +432,34 @@ DEFINE_SLV_PROXY_METHOD(get_linsolqr_sys, getlinsys, linsolqr_system_t, NULL) /*
 
 DEFINE_SLV_PROXY_METHOD(get_sys_mtx, get_sys_mtx, mtx_matrix_t, NULL) /*;*/
 
-DEFINE_SLV_PROXY_METHOD(presolve,presolve,int,-1) /*;*/
-DEFINE_SLV_PROXY_METHOD(resolve,resolve,int,-1) /*;*/
-DEFINE_SLV_PROXY_METHOD(iterate,iterate,int,-1) /*;*/
-DEFINE_SLV_PROXY_METHOD(solve,solve,int,-1) /*;*/
+/**
+	Define a method like DEFINE_SLV_PROXY_METHOD, but do BEFORE before
+	calling the solver and AFTER once it returns. These are the points at
+	which the variable value store is filled from the instance tree (see
+	slv_var_store_gather and slv_var_store_sync).
+*/
+#define DEFINE_SLV_PROXY_METHOD_STORE(METHOD,PROP,RETTYPE,ERRVAL,BEFORE,AFTER) \
+	RETTYPE slv_ ## METHOD (slv_system_t sys){ \
+		RETTYPE res; \
+		asc_assert(sys->internals); \
+		if(sys->internals->PROP==NULL){ \
+			printinfo(sys, #METHOD); \
+			return ERRVAL; \
+		} \
+		BEFORE; \
+		res = (sys->internals->PROP)(sys,sys->ct); \
+		AFTER; \
+		return res; \
+	}
+
+DEFINE_SLV_PROXY_METHOD_STORE(presolve,presolve,int,-1
+	,slv_var_store_gather(sys),(void)0) /*;*/
+DEFINE_SLV_PROXY_METHOD_STORE(resolve,resolve,int,-1
+	,slv_var_store_sync(sys),(void)0) /*;*/
+DEFINE_SLV_PROXY_METHOD_STORE(iterate,iterate,int,-1
+	,(void)0,slv_var_store_sync(sys)) /*;*/
+DEFINE_SLV_PROXY_METHOD_STORE(solve,solve,int,-1
+	,(void)0,slv_var_store_sync(sys)) /*;*/
 
 int slv_eligible_solver(slv_system_t sys)
 {
@@ -1,6 +1,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 
 #include <ascend/general/env.h>
 #include <ascend/general/ospath.h>
@@ -33,6 +34,9 @@
 #include <ascend/compiler/qlfdid.h>
 #include <ascend/compiler/instance_io.h>
 #include <ascend/compiler/packages.h>
+#include <ascend/compiler/relprof.h>
+#include <ascend/compiler/rel_bytecode.h>
+#include <ascend/compiler/instantiate.h>
 
 #include <ascend/compiler/slvreq.h>
 
@@ -40,15 +44,39 @@
 #include <ascend/system/slv_client.h>
 #include <ascend/solver/solver.h>
 #include <ascend/system/slv_server.h>
+#include <ascend/system/relman.h>
+#include <ascend/system/slv_stdcalls.h>
 
 #include <test/common.h>
 
+/* if nonzero, the 'parblocksize' given to QRSlv by load_solve_test_qrslv */
+static int qrslv_parblocksize = 0;
+
+/** set integer solver parameter 'name' of sys */
+static void set_int_parameter(slv_system_t sys, const char *name, int value){
+	slv_parameters_t pp;
+	int i;
+	slv_get_parameters(sys,&pp);
+	for(i = 0; i < pp.num_parms; ++i){
+		if(0 == strcmp(pp.parms[i].name,name)){
+			CU_ASSERT(SLV_PARAM_TYPE(&pp,i) == int_parm);
+			SLV_PARAM_INT(&pp,i) = value;
+			slv_set_parameters(sys,&pp);
+			return;
+		}
+	}
+	CU_FAIL(parameter not found);
+}
+
 /**
 	Reusable function for the standard process of loading, initialising, solving
 	and testing a model using QRSlv. Any error from loading, solving, testing
-	will result in the test failing.
+	will result in the test failing. If given, 'check' is called with the
+	simulation root after the self-test, before the instances are destroyed.
 */
-static void load_solve_test_qrslv(const char *librarypath, const char *modelfile, const char *modelname, int simplify){
+static void load_solve_test_qrslv(const char *librarypath, const char *modelfile, const char *modelname, int simplify
+		, void (*check)(struct Instance *root)
+){
 	char env1[2*PATH_MAX];
 	int status;
 	int qrslv_index;
@@ -102,6 +130,9 @@ static void load_solve_test_qrslv(const char *librarypath, const char *modelfile
 	/* assign the solver to the system */
 	CU_ASSERT_FATAL(slv_select_solver(sys,qrslv_index));
 	CONSOLE_DEBUG("Assigned solver '%s'...",slv_solver_name(slv_get_selected_solver(sys)));
+	if(qrslv_parblocksize){
+		set_int_parameter(sys,"parblocksize",qrslv_parblocksize);
+	}
 
 	/* presolve, check it's ready, then solve */
 	CU_ASSERT_FATAL(0 == slv_presolve(sys));
@@ -124,6 +155,8 @@ static void load_solve_test_qrslv(const char *librarypath, const char *modelfile
 	pe = Initialize(GetSimulationRoot(siminst),name,"sim1", ASCERR, WP_STOPONERR, NULL, NULL);
 	CU_ASSERT(pe==Proc_all_ok);
 
+	if(check)(*check)(GetSimulationRoot(siminst));
+
 	/* destroy the compiler data structures, hopefully all dynamically allocated memory */
 	CONSOLE_DEBUG("Destroying instance tree");
 	CU_ASSERT(siminst != NULL);
@@ -143,7 +176,7 @@ static void test_qrslv(const char *filenamestem, int simplify){
 	strncat(modelpath, filenamestem, PATH_MAX - strlen(modelpath));
 	strncat(modelpath, ".a4c", PATH_MAX - strlen(modelpath));
 	
-	load_solve_test_qrslv("models",modelpath,filenamestem,simplify);
+	load_solve_test_qrslv("models",modelpath,filenamestem,simplify,NULL);
 }
 
 static void test_fixedbug513_simplify(void){
@@ -197,7 +230,502 @@ static void test_fixedbug567(void){
 }
 
 static void test_fixedbug564(void){
-	load_solve_test_qrslv("models","test/qrslv/akash_eos.a4c","akash_eos",1);
+	load_solve_test_qrslv("models","test/qrslv/akash_eos.a4c","akash_eos",1,NULL);
+}
+
+#define PARBLOCKS_N 200
+static const char *parblocks_vars[] = {"x","y","z","s"};
+/* solution of parblocks.a4c from each run of test_parblocks */
+static double parblocks_soln[3][4][PARBLOCKS_N];
+static int parblocks_run;
+
+static void record_parblocks(struct Instance *root){
+	struct Instance *arr;
+	unsigned long i;
+	int k;
+	for(k = 0; k < 4; ++k){
+		arr = ChildByChar(root,AddSymbol(parblocks_vars[k]));
+		CU_ASSERT_FATAL(arr != NULL);
+		CU_ASSERT_FATAL(NumberChildren(arr) == PARBLOCKS_N);
+		for(i = 0; i < PARBLOCKS_N; ++i){
+			parblocks_soln[parblocks_run][k][i] = RealAtomValue(InstanceChild(arr,i+1));
+		}
+	}
+}
+
+/**
+	many independent blocks, solved in turn and then at the same time; the
+	concurrent solves give the same answer on any number of threads, and
+	agree with the serial solve to within the solver tolerance
+*/
+static void test_parblocks(void){
+	int k, i;
+	relman_set_threads(1);
+	parblocks_run = 0;
+	load_solve_test_qrslv("models","test/qrslv/parblocks.a4c","parblocks",1,&record_parblocks);
+
+	qrslv_parblocksize = 50;
+	relman_set_threads(2);
+	parblocks_run = 1;
+	load_solve_test_qrslv("models","test/qrslv/parblocks.a4c","parblocks",1,&record_parblocks);
+	relman_set_threads(4);
+	parblocks_run = 2;
+	load_solve_test_qrslv("models","test/qrslv/parblocks.a4c","parblocks",1,&record_parblocks);
+	qrslv_parblocksize = 0;
+	relman_set_threads(0);
+
+	for(k = 0; k < 4; ++k){
+		for(i = 0; i < PARBLOCKS_N; ++i){
+			CU_TEST(parblocks_soln[1][k][i] == parblocks_soln[2][k][i]);
+			CU_ASSERT_DOUBLE_EQUAL(parblocks_soln[0][k][i],parblocks_soln[1][k][i],1e-8);
+		}
+	}
+}
+
+static void check_profile(struct Instance *root){
+	struct relprof_entry *e;
+	unsigned long j, n, nrels = 0, calls = 0;
+
+	/* every relation is from one of the statements of parblocks.a4c */
+	e = relprof_summary(RELPROF_STATEMENT,root,&n);
+	CU_TEST(n > 0 && n <= 6);
+	for(j = 0; j < n; ++j){
+		CU_TEST(e[j].type != NULL && 0 == strcmp(e[j].type,"parblocks"));
+		CU_TEST(e[j].line > 0);
+		nrels += e[j].nrels;
+		calls += e[j].c.calls[RELPROF_RESID] + e[j].c.calls[RELPROF_GRAD];
+	}
+	relprof_summary_destroy(e,n);
+	CU_TEST(calls >= nrels);
+
+	e = relprof_summary(RELPROF_RELATION,root,&n);
+	CU_TEST(n == nrels);
+	for(j = 1; j < n; ++j){
+		CU_TEST(relprof_total_ticks(&(e[j-1].c)) >= relprof_total_ticks(&(e[j].c)));
+	}
+	relprof_summary_destroy(e,n);
+}
+
+/* evaluations are recorded by relation and forgotten with the instances */
+static void test_profile(void){
+	unsigned long n;
+	struct relprof_entry *e;
+	relprof_reset();
+	relprof_enable(1);
+	load_solve_test_qrslv("models","test/qrslv/parblocks.a4c","parblocks",1,&check_profile);
+	relprof_enable(0);
+	e = relprof_summary(RELPROF_RELATION,NULL,&n);
+	CU_TEST(n == 0);
+	relprof_summary_destroy(e,n);
+}
+
+/* set the variables of the first cells of sharedrels.a4c to distinct values */
+static void set_lanes_values(struct Instance *cells, int divzero){
+	static const char *vars[] = {"x","y","z","w"};
+	struct Instance *cell;
+	int k, j;
+	double val;
+	for(k = 0; k < RELBC_LANES; ++k){
+		cell = InstanceChild(cells,k + 1);
+		for(j = 0; j < 4; ++j){
+			val = 0.5 + 0.25*k - 0.125*j;
+			/* in e4, x/(2 + z) */
+			if(divzero && k == 1 && j == 2)val = -2.0;
+			SetRealAtomValue(ChildByChar(cell,AddSymbol(vars[j])),val,0);
+		}
+	}
+}
+
+/* relations evaluated in lanes give exactly what they give one at a time */
+static void check_lanes_rel(struct Instance *cells, const char *name, int safe){
+	CONST struct relation *r[RELBC_LANES];
+	double res[RELBC_LANES], g[RELBC_LANES][4], *grad[RELBC_LANES];
+	double res1, g1[4];
+	enum safe_err serr[RELBC_LANES], serr1;
+	int n, k;
+	unsigned long j;
+
+	for(k = 0; k < RELBC_LANES; ++k){
+		r[k] = GetInstanceRelationOnly(
+			ChildByChar(InstanceChild(cells,k + 1),AddSymbol(name))
+		);
+		CU_ASSERT_FATAL(r[k] != NULL && NumberVariables(r[k]) <= 4);
+		grad[k] = g[k];
+	}
+	/* a full pack, and a partly filled one */
+	for(n = RELBC_LANES; n >= RELBC_LANES - 1; --n){
+		for(k = 0; k < n; ++k)serr[k] = safe_ok;
+		CU_TEST(0 == RelationBytecodeCalcLanes(r,n,res,grad,(safe ? serr : NULL)));
+		for(k = 0; k < n; ++k){
+			serr1 = safe_ok;
+			if(safe){
+				CU_TEST(0 == RelationBytecodeCalcResidGradSafe(r[k],&res1,g1,&serr1));
+				CU_TEST(serr[k] == serr1);
+			}else{
+				CU_TEST(0 == RelationBytecodeCalcResidGrad(r[k],&res1,g1));
+			}
+			CU_TEST(res[k] == res1);
+			for(j = 0; j < NumberVariables(r[k]); ++j){
+				CU_TEST(g[k][j] == g1[j]);
+			}
+		}
+		if(safe)continue;
+		CU_TEST(0 == RelationBytecodeCalcLanes(r,n,res,NULL,NULL));
+		for(k = 0; k < n; ++k){
+			CU_TEST(0 == RelationBytecodeCalcResidual(r[k],&res1));
+			CU_TEST(res[k] == res1);
+		}
+	}
+}
+
+static void check_lanes(struct Instance *root){
+	struct Instance *cells;
+	CONST struct relation *r[2];
+	double res[2];
+	int safe;
+
+	cells = ChildByChar(root,AddSymbol("cell"));
+	CU_ASSERT_FATAL(cells != NULL && NumberChildren(cells) >= RELBC_LANES);
+	for(safe = 0; safe <= 1; ++safe){
+		/* division by zero only with the guarded arithmetic */
+		set_lanes_values(cells,safe);
+		check_lanes_rel(cells,"e1",safe);
+		check_lanes_rel(cells,"e2",safe);
+		check_lanes_rel(cells,"e3",safe);
+		check_lanes_rel(cells,"e4",safe);
+	}
+
+	/* relations from different statements can't share lanes */
+	r[0] = GetInstanceRelationOnly(ChildByChar(InstanceChild(cells,1),AddSymbol("e1")));
+	r[1] = GetInstanceRelationOnly(ChildByChar(InstanceChild(cells,1),AddSymbol("e2")));
+	CU_TEST(1 == RelationBytecodeCalcLanes(r,2,res,NULL,NULL));
+}
+
+/* relations shared by many cells, solved with and without worker threads */
+static void test_lanes(void){
+	relman_set_threads(1);
+	load_solve_test_qrslv("models","test/qrslv/sharedrels.a4c","sharedrels",1,&check_lanes);
+	relman_set_threads(4);
+	test_qrslv("sharedrels",1);
+	relman_set_threads(0);
+}
+
+static struct Instance *update_child(struct Instance *i, const char *name){
+	struct Instance *c = ChildByChar(i,AddSymbol(name));
+	CU_ASSERT_FATAL(c != NULL);
+	return c;
+}
+
+static struct var_variable *update_var(slv_system_t sys, struct Instance *i){
+	struct var_variable **vl = slv_get_master_var_list(sys);
+	int c;
+	for(c = 0; vl[c] != NULL; ++c){
+		if(var_instance(vl[c]) == i)return vl[c];
+	}
+	CU_FAIL_FATAL(variable not in system);
+	return NULL;
+}
+
+static void update_solve(slv_system_t sys){
+	slv_status_t status;
+	CU_ASSERT_FATAL(0 == slv_presolve(sys));
+	slv_get_status(sys, &status);
+	CU_ASSERT_FATAL(status.ready_to_solve);
+	slv_solve(sys);
+	slv_get_status(sys, &status);
+	CU_TEST(status.ok);
+}
+
+#define UPDATE_CHECK(I,V) CU_TEST(fabs(RealAtomValue(I) - (V)) < 1e-8)
+
+/* respecifying a model after its system is built, without building it again */
+static void test_update(void){
+	struct Instance *siminst, *root, *x, *y, *z, *s, *e3;
+	slv_system_t sys;
+	int qrslv_index, status;
+
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv"));
+	package_load("qrslv",NULL);
+	qrslv_index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(qrslv_index != -1);
+
+	Asc_OpenModule("test/qrslv/respecify.a4c",&status);
+	CU_ASSERT_FATAL(status == 0);
+	status = zz_parse();
+	CU_ASSERT_FATAL(status == 0);
+	siminst = SimsCreateInstance(AddSymbol("respecify"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst != NULL);
+	root = GetSimulationRoot(siminst);
+	CU_ASSERT(Proc_all_ok == Initialize(root,CreateIdName(AddSymbol("on_load"))
+		,"sim1", ASCERR, WP_STOPONERR, NULL, NULL)
+	);
+	x = update_child(root,"x");
+	y = update_child(root,"y");
+	z = update_child(root,"z");
+	s = update_child(root,"s");
+	e3 = update_child(root,"e3");
+
+	sys = system_build(root);
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,qrslv_index));
+	update_solve(sys);
+	UPDATE_CHECK(x,2.0);
+	UPDATE_CHECK(z,1.0);
+
+	/* free y, fix z; a mark on the 'fixed' flag stands for the variable */
+	SetBooleanAtomValue(update_child(y,"fixed"),FALSE,0);
+	SetBooleanAtomValue(update_child(z,"fixed"),TRUE,0);
+	SetRealAtomValue(z,2.0,0);
+	system_mark_dirty(sys,update_child(y,"fixed"));
+	system_mark_dirty(sys,z);
+	CU_TEST(var_flagbit(update_var(sys,y),VAR_FIXED));
+	CU_TEST(0 == system_update(sys));
+	CU_TEST(!var_flagbit(update_var(sys,y),VAR_FIXED));
+	CU_TEST(var_flagbit(update_var(sys,z),VAR_FIXED));
+	update_solve(sys);
+	UPDATE_CHECK(x,2.5);
+	UPDATE_CHECK(y,0.5);
+
+	/* include e3 and free s, this time without marking anything */
+	SetBooleanAtomValue(update_child(e3,"included"),TRUE,0);
+	SetBooleanAtomValue(update_child(s,"fixed"),FALSE,0);
+	CU_TEST(0 == system_update(sys));
+	CU_TEST(!var_flagbit(update_var(sys,s),VAR_FIXED));
+	update_solve(sys);
+	UPDATE_CHECK(x,1.0);
+	UPDATE_CHECK(y,-1.0);
+	UPDATE_CHECK(s,0.0);
+
+	/* once the instance tree has been worked on, a new system is needed */
+	ReInstantiate(root);
+	CU_TEST(1 == system_update(sys));
+	sys = system_rebuild(sys,root);
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_TEST(slv_get_selected_solver(sys) == qrslv_index);
+	CU_TEST(0 == system_update(sys));
+	update_solve(sys);
+	UPDATE_CHECK(x,1.0);
+
+	system_destroy(sys);
+	system_free_reused_mem();
+	solver_destroy_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/* the block of sys holding the relation inst, with its rels and vars */
+struct repart_block{
+	int n;
+	struct rel_relation *rels[4];
+	struct var_variable *vars[4];
+};
+
+static void repart_find(slv_system_t sys, struct Instance *inst, struct repart_block *pb){
+	const mtx_block_t *b = slv_get_solvers_blocks(sys);
+	struct rel_relation **rl = slv_get_solvers_rel_list(sys);
+	struct var_variable **vl = slv_get_solvers_var_list(sys);
+	int k, r;
+	for(k = 0; k < b->nblocks; ++k){
+		for(r = b->block[k].row.low; r <= b->block[k].row.high; ++r){
+			if(rel_instance(rl[r]) != inst)continue;
+			pb->n = b->block[k].row.high - b->block[k].row.low + 1;
+			CU_ASSERT_FATAL(pb->n <= 4);
+			for(r = 0; r < pb->n; ++r){
+				pb->rels[r] = rl[b->block[k].row.low + r];
+				pb->vars[r] = vl[b->block[k].col.low + r];
+			}
+			return;
+		}
+	}
+	CU_FAIL_FATAL(relation not in any block);
+}
+
+static int repart_same(struct repart_block *b1, struct repart_block *b2){
+	int r;
+	if(b1->n != b2->n)return 0;
+	for(r = 0; r < b1->n; ++r){
+		if(b1->rels[r] != b2->rels[r] || b1->vars[r] != b2->vars[r])return 0;
+	}
+	return 1;
+}
+
+/*
+	after a system_update, only the block holding the edit is partitioned
+	again; the others keep their rows and columns in the order they had
+*/
+static void test_repartition(void){
+	struct Instance *siminst, *root, *p, *t;
+	struct Instance *r1, *r3, *r4, *r5, *r6;
+	struct repart_block ab, c, uw, ab2, c2, uw2, d, e;
+	struct rel_relation **rl;
+	struct var_variable **vl, *v;
+	slv_system_t sys;
+	int qrslv_index, status;
+
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv"));
+	package_load("qrslv",NULL);
+	qrslv_index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(qrslv_index != -1);
+
+	Asc_OpenModule("test/qrslv/repartition.a4c",&status);
+	CU_ASSERT_FATAL(status == 0);
+	status = zz_parse();
+	CU_ASSERT_FATAL(status == 0);
+	siminst = SimsCreateInstance(AddSymbol("repartition"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst != NULL);
+	root = GetSimulationRoot(siminst);
+	CU_ASSERT(Proc_all_ok == Initialize(root,CreateIdName(AddSymbol("on_load"))
+		,"sim1", ASCERR, WP_STOPONERR, NULL, NULL)
+	);
+	p = update_child(root,"p");
+	t = update_child(root,"t");
+	r1 = update_child(root,"r1");
+	r3 = update_child(root,"r3");
+	r4 = update_child(root,"r4");
+	r5 = update_child(root,"r5");
+	r6 = update_child(root,"r6");
+
+	sys = system_build(root);
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,qrslv_index));
+	update_solve(sys);
+	UPDATE_CHECK(update_child(root,"d"),2.0);
+	CU_TEST(slv_get_solvers_blocks(sys)->nblocks == 4);
+	repart_find(sys,r4,&d);
+	CU_TEST(d.n == 2);
+
+	/* reverse the rows and columns of the u,w block, as a solver may */
+	repart_find(sys,r6,&uw);
+	CU_ASSERT_FATAL(uw.n == 2);
+	rl = slv_get_solvers_rel_list(sys);
+	vl = slv_get_solvers_var_list(sys);
+	status = rel_sindex(uw.rels[0]);
+	rl[status] = uw.rels[1];
+	rl[status + 1] = uw.rels[0];
+	rel_set_sindex(rl[status],status);
+	rel_set_sindex(rl[status + 1],status + 1);
+	v = vl[status];
+	vl[status] = vl[status + 1];
+	vl[status + 1] = v;
+	var_set_sindex(vl[status],status);
+	var_set_sindex(vl[status + 1],status + 1);
+	repart_find(sys,r1,&ab);
+	repart_find(sys,r3,&c);
+	repart_find(sys,r6,&uw);
+
+	/* fix p and free t: the d,p block splits, the others are untouched */
+	SetBooleanAtomValue(update_child(p,"fixed"),TRUE,0);
+	SetBooleanAtomValue(update_child(t,"fixed"),FALSE,0);
+	SetRealAtomValue(p,0.5,0);
+	system_mark_dirty(sys,p);
+	system_mark_dirty(sys,t);
+	CU_TEST(0 == system_update(sys));
+	update_solve(sys);
+	UPDATE_CHECK(update_child(root,"d"),2.5);
+	UPDATE_CHECK(t,2.0);
+	UPDATE_CHECK(update_child(root,"u"),3.0);
+	CU_TEST(slv_get_solvers_blocks(sys)->nblocks == 5);
+	repart_find(sys,r1,&ab2);
+	repart_find(sys,r3,&c2);
+	repart_find(sys,r6,&uw2);
+	CU_TEST(repart_same(&ab,&ab2));
+	CU_TEST(repart_same(&c,&c2));
+	CU_TEST(repart_same(&uw,&uw2));
+	repart_find(sys,r4,&d);
+	repart_find(sys,r5,&e);
+	CU_TEST(d.n == 1 && e.n == 1);
+	CU_TEST(var_instance(e.vars[0]) == t);
+
+	system_destroy(sys);
+	system_free_reused_mem();
+	solver_destroy_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/*
+	after presolve the var_variable accessors read the system's value store,
+	but changes made to the ATOMs (by a METHOD, say) are still seen at once
+*/
+static void test_varattrs(void){
+	struct Instance *siminst, *root, *x;
+	struct var_variable *v;
+	struct var_store *vs;
+	slv_system_t sys;
+	int qrslv_index, status;
+
+	Asc_CompilerInit(1);
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_LIBRARY "=models"));
+	CU_TEST(0 == Asc_PutEnv(ASC_ENV_SOLVERS "=solvers/qrslv"));
+	package_load("qrslv",NULL);
+	qrslv_index = slv_lookup_client("QRSlv");
+	CU_ASSERT_FATAL(qrslv_index != -1);
+
+	Asc_OpenModule("test/qrslv/respecify.a4c",&status);
+	CU_ASSERT_FATAL(status == 0);
+	status = zz_parse();
+	CU_ASSERT_FATAL(status == 0);
+	siminst = SimsCreateInstance(AddSymbol("respecify"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(siminst != NULL);
+	root = GetSimulationRoot(siminst);
+	CU_ASSERT(Proc_all_ok == Initialize(root,CreateIdName(AddSymbol("on_load"))
+		,"sim1", ASCERR, WP_STOPONERR, NULL, NULL)
+	);
+	x = update_child(root,"x");
+
+	sys = system_build(root);
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT_FATAL(slv_select_solver(sys,qrslv_index));
+	update_solve(sys);
+	UPDATE_CHECK(x,2.0);
+	v = update_var(sys,x);
+	vs = slv_get_var_store(sys);
+	CU_ASSERT_FATAL(vs != NULL && var_store(v) == vs);
+	CU_TEST(var_store_current(vs));
+	CU_TEST(vs->value[var_store_index(v)] == 2.0);
+	CU_TEST(0 == slv_check_bounds(sys,0,-1,"varattrs"));
+
+	/* writing through the variable keeps the store current */
+	var_set_value(v,3.0);
+	CU_TEST(var_store_current(vs));
+	CU_TEST(vs->value[var_store_index(v)] == 3.0);
+	CU_TEST(RealAtomValue(x) == 3.0);
+
+	/* as a METHOD would */
+	SetRealAtomValue(x,2.0,0);
+	CU_TEST(!var_store_current(vs));
+	CU_TEST(var_value(v) == 2.0);
+	CU_TEST(var_store_current(vs));
+	SetRealAtomValue(update_child(x,"lower_bound"),10.0,0);
+	SetRealAtomValue(update_child(x,"upper_bound"),20.0,0);
+	SetRealAtomValue(update_child(x,"nominal"),4.0,0);
+	CU_TEST(var_lower_bound(v) == 10.0);
+	CU_TEST(var_upper_bound(v) == 20.0);
+	CU_TEST(var_nominal(v) == 4.0);
+	CU_TEST(0 != slv_check_bounds(sys,0,-1,"varattrs"));
+	CU_TEST(vs->lower[var_store_index(v)] == 10.0);
+
+	/* and the setters write the ATOMs */
+	var_set_lower_bound(v,-5.0);
+	var_set_nominal(v,0.5);
+	CU_TEST(RealAtomValue(update_child(x,"lower_bound")) == -5.0);
+	CU_TEST(RealAtomValue(update_child(x,"nominal")) == 0.5);
+	CU_TEST(0 == slv_check_bounds(sys,0,-1,"varattrs"));
+
+	CU_ASSERT_FATAL(0 == slv_presolve(sys));
+	CU_TEST(var_lower_bound(v) == -5.0);
+	CU_TEST(var_upper_bound(v) == 20.0);
+	CU_TEST(var_nominal(v) == 0.5);
+
+	system_destroy(sys);
+	system_free_reused_mem();
+	solver_destroy_engines();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
 }
 
 /*===========================================================================*/
@@ -207,7 +735,13 @@ static void test_fixedbug564(void){
 	T(fixedbug513_no_simplify) \
 	X T(fixedbug513_simplify) \
 	X T(fixedbug567) \
-	X T(fixedbug564)
+	X T(fixedbug564) \
+	X T(parblocks) \
+	X T(profile) \
+	X T(lanes) \
+	X T(update) \
+	X T(repartition) \
+	X T(varattrs)
 
 #define X
 #define TESTS(T) TESTS1(T,X)
@@ -27,6 +27,7 @@
 	T(fprops) \
 	T(lrslv) \
 	T(slvdof) \
+	T(relman) \
 	T(datareader) \
 	T(sunpos) \
 	T(cmslv)
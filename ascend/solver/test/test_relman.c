@@ -0,0 +1,307 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Unit tests for the sparse Hessians of relman.h (relman_hess_pattern and
+	relman_hess_sparse, as used for the Hessian of the Lagrangian by IPOPT),
+	against central differences of the gradients from relman_diffs, and
+	for the profiling of relman_eval and relman_diffs.
+*/
+#include <string.h>
+#include <math.h>
+
+#include <ascend/general/config.h>
+#include <ascend/general/env.h>
+#include <ascend/general/platform.h>
+#include <ascend/utilities/ascEnvVar.h>
+#include <ascend/utilities/error.h>
+
+#include <ascend/compiler/ascCompiler.h>
+#include <ascend/compiler/module.h>
+#include <ascend/compiler/parser.h>
+#include <ascend/compiler/library.h>
+#include <ascend/compiler/symtab.h>
+#include <ascend/compiler/simlist.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/initialize.h>
+#include <ascend/compiler/name.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/rel_bytecode.h>
+#include <ascend/compiler/relprof.h>
+#include <ascend/compiler/parentchild.h>
+#include <ascend/compiler/atomvalue.h>
+
+#include <ascend/linear/mtx.h>
+#include <ascend/system/system.h>
+#include <ascend/system/slv_client.h>
+#include <ascend/system/relman.h>
+
+#include <test/common.h>
+
+#define MAXINC 8
+#define PACKED(A,B) ((A)*((A)+1)/2 + (B))
+
+/* agreement with central differences */
+#define TOL_FD 1e-6
+/* between the compiled and token Hessians */
+#define TOL_EXACT 1e-12
+
+static int close_to(double a, double b, double tol){
+	return fabs(a - b) <= tol * (1.0 + fabs(a) + fabs(b));
+}
+
+/** gradient of rel at the current point, by incidence position */
+static void gradient(struct rel_relation *rel, const var_filter_t *vfilter
+		, mtx_matrix_t mtx, double *g
+){
+	const struct var_variable **vlist = rel_incidence_list(rel);
+	int32 i, len = rel_n_incidences(rel);
+	mtx_coord_t coord;
+	real64 resid;
+
+	mtx_clear_region(mtx,mtx_ENTIRE_MATRIX);
+	CU_TEST(0 == relman_diffs(rel,vfilter,mtx,&resid,0));
+	coord.row = rel_sindex(rel);
+	for(i = 0; i < len; ++i){
+		coord.col = var_sindex(vlist[i]);
+		g[i] = mtx_value(mtx,&coord);
+	}
+}
+
+/** Hessian of rel by central differences of its gradient */
+static void fd_hessian(struct rel_relation *rel, const var_filter_t *vfilter
+		, mtx_matrix_t mtx, double h[MAXINC][MAXINC]
+){
+	struct var_variable **vlist = (struct var_variable **)rel_incidence_list(rel);
+	int32 i, j, len = rel_n_incidences(rel);
+	double gp[MAXINC], gm[MAXINC], x0, dx;
+
+	for(j = 0; j < len; ++j){
+		x0 = var_value(vlist[j]);
+		dx = 1e-5 * (1.0 + fabs(x0));
+		var_set_value(vlist[j],x0 + dx);
+		gradient(rel,vfilter,mtx,gp);
+		var_set_value(vlist[j],x0 - dx);
+		gradient(rel,vfilter,mtx,gm);
+		var_set_value(vlist[j],x0);
+		for(i = 0; i < len; ++i){
+			h[i][j] = (gp[i] - gm[i]) / (2*dx);
+		}
+	}
+}
+
+/**
+	Check the pattern and the packed values of the Hessian of rel, from
+	the compiled relation and from the token fallback.
+	@return the number of incidences left out of the pattern
+*/
+static int32 check_hess(struct rel_relation *rel, const var_filter_t *vfilter
+		, mtx_matrix_t mtx
+){
+	struct relation *r = (struct relation *)GetInstanceRelationOnly((struct Instance *)rel_instance(rel));
+	unsigned long pos[MAXINC], allpos[MAXINC];
+	double h[MAXINC][MAXINC];
+	double values[PACKED(MAXINC,0)], safevalues[PACKED(MAXINC,0)];
+	double tokvalues[PACKED(MAXINC,0)];
+	int32 len, count, nall, a, b, i;
+	int inpattern[MAXINC];
+
+	len = rel_n_incidences(rel);
+	CU_TEST(len > 0 && len <= MAXINC);
+	if(len <= 0 || len > MAXINC)return 0;
+
+	CU_TEST(RelationBytecodeGet(r) != NULL);
+	count = relman_hess_pattern(rel,vfilter,pos);
+	CU_TEST(count > 0 && count <= len);
+	CU_TEST(0 == relman_hess_sparse(rel,pos,count,values,0));
+	CU_TEST(0 == relman_hess_sparse(rel,pos,count,safevalues,1));
+
+	fd_hessian(rel,vfilter,mtx,h);
+
+	/* the packed values are the second derivatives */
+	for(a = 0; a < count; ++a){
+		for(b = 0; b <= a; ++b){
+			CU_TEST(close_to(values[PACKED(a,b)],safevalues[PACKED(a,b)],TOL_EXACT));
+			if(!close_to(values[PACKED(a,b)],h[pos[a]][pos[b]],TOL_FD)){
+				CONSOLE_DEBUG("incidences %lu, %lu: Hessian %g, finite difference %g"
+					,pos[a],pos[b],values[PACKED(a,b)],h[pos[a]][pos[b]]
+				);
+			}
+			CU_TEST(close_to(values[PACKED(a,b)],h[pos[a]][pos[b]],TOL_FD));
+		}
+	}
+
+	/* and there are none outside the pattern */
+	for(i = 0; i < len; ++i)inpattern[i] = 0;
+	for(a = 0; a < count; ++a)inpattern[pos[a]] = 1;
+	for(i = 0; i < len; ++i){
+		if(inpattern[i])continue;
+		for(a = 0; a < len; ++a){
+			CU_TEST(fabs(h[i][a]) < TOL_FD && fabs(h[a][i]) < TOL_FD);
+		}
+	}
+
+	/*
+		The token fallback: the pattern is then all the incidences, and the
+		values picked from the full token Hessian agree.
+	*/
+	RelationBytecodeDisable(r);
+	nall = relman_hess_pattern(rel,vfilter,allpos);
+	CU_TEST(nall == len);
+	CU_TEST(0 == relman_hess_sparse(rel,pos,count,tokvalues,0));
+	for(a = 0; a < count; ++a){
+		for(b = 0; b <= a; ++b){
+			CU_TEST(close_to(values[PACKED(a,b)],tokvalues[PACKED(a,b)],TOL_EXACT));
+		}
+	}
+	RelationBytecodeInvalidate(r);
+	CU_TEST(RelationBytecodeGet(r) != NULL);
+	return len - count;
+}
+
+/** load test16 and build its system, or return NULL */
+static slv_system_t load_test16(struct Instance **siminst){
+	int status;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	Asc_OpenModule("test/ipopt/test16.a4c",&status);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(0 == zz_parse());
+
+	*siminst = SimsCreateInstance(AddSymbol("test16"), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT(*siminst != NULL);
+	if(*siminst == NULL)return NULL;
+	CU_ASSERT(Proc_all_ok == Initialize(GetSimulationRoot(*siminst)
+		,CreateIdName(AddSymbol("on_load")),"sim1", ASCERR, WP_STOPONERR, NULL, NULL
+	));
+	return system_build(GetSimulationRoot(*siminst));
+}
+
+static void test_hessian(void){
+	struct Instance *siminst;
+	slv_system_t sys;
+	struct rel_relation **rlist, *obj;
+	struct var_variable **vlist;
+	var_filter_t vfilter;
+	mtx_matrix_t mtx;
+	int32 i, nrels, nvars, nlinear = 0;
+
+	sys = load_test16(&siminst);
+	CU_ASSERT_FATAL(sys != NULL);
+
+	/* as for IPOPT's Hessian of the Lagrangian */
+	vfilter.matchbits = (VAR_ACTIVE | VAR_INCIDENT | VAR_SVAR | VAR_FIXED);
+	vfilter.matchvalue = (VAR_ACTIVE | VAR_INCIDENT | VAR_SVAR);
+
+	vlist = slv_get_solvers_var_list(sys);
+	nvars = slv_get_num_solvers_vars(sys);
+	rlist = slv_get_solvers_rel_list(sys);
+	nrels = slv_get_num_solvers_rels(sys);
+	CU_TEST(nvars == 6 && nrels == 3);
+
+	/* away from the solution, where no term vanishes */
+	for(i = 0; i < nvars; ++i){
+		var_set_value(vlist[i],0.6 + 0.15*i);
+	}
+
+	mtx = mtx_create();
+	mtx_set_order(mtx,nvars > nrels ? nvars : nrels);
+	for(i = 0; i < nrels; ++i){
+		nlinear += check_hess(rlist[i],&vfilter,mtx);
+	}
+	obj = slv_get_obj_relation(sys);
+	CU_ASSERT(obj != NULL);
+	if(obj != NULL){
+		nlinear += check_hess(obj,&vfilter,mtx);
+	}
+	mtx_destroy(mtx);
+	/* only x4 in cons16_2 */
+	CU_TEST(nlinear == 1);
+
+	system_destroy(sys);
+	system_free_reused_mem();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+/*
+	The profile counts floating point exceptions apart from calculation
+	errors: at x3 = 0, x6/x3 in cons16_2 divides by zero when evaluated
+	directly, and is a calculation error when evaluated safely.
+*/
+static void test_profile(void){
+	struct Instance *siminst, *reli;
+	slv_system_t sys;
+	struct rel_relation **rlist, *rel = NULL;
+	struct relprof_entry *e;
+	unsigned long j, n;
+	int32 i, nrels, ok;
+	var_filter_t vfilter;
+	mtx_matrix_t mtx;
+	real64 resid;
+
+	sys = load_test16(&siminst);
+	CU_ASSERT_FATAL(sys != NULL);
+	reli = ChildByChar(GetSimulationRoot(siminst),AddSymbol("cons16_2"));
+	rlist = slv_get_solvers_rel_list(sys);
+	nrels = slv_get_num_solvers_rels(sys);
+	for(i = 0; i < nrels; ++i){
+		if(rel_instance(rlist[i]) == reli)rel = rlist[i];
+	}
+	CU_ASSERT_FATAL(rel != NULL);
+	SetRealAtomValue(ChildByChar(GetSimulationRoot(siminst),AddSymbol("x3")),0.0,0);
+
+	vfilter.matchbits = VAR_SVAR;
+	vfilter.matchvalue = VAR_SVAR;
+	mtx = mtx_create();
+	mtx_set_order(mtx,slv_get_num_solvers_vars(sys));
+
+	relprof_reset();
+	relprof_enable(1);
+	relman_eval(rel,&ok,0);
+	relman_eval(rel,&ok,1);
+	CU_TEST(!ok);
+	relman_diffs(rel,&vfilter,mtx,&resid,0);
+	relman_diffs(rel,&vfilter,mtx,&resid,1);
+	relprof_enable(0);
+	mtx_destroy(mtx);
+
+	e = relprof_summary(RELPROF_RELATION,GetSimulationRoot(siminst),&n);
+	CU_TEST(n == 1);
+	for(j = 0; j < n; ++j){
+		CU_TEST(0 == strcmp(e[j].name,"cons16_2"));
+		CU_TEST(e[j].c.calls[RELPROF_RESID] == 2 && e[j].c.calls[RELPROF_GRAD] == 2);
+		CU_TEST(e[j].c.fails[RELPROF_RESID] == 1 && e[j].c.fails[RELPROF_GRAD] == 1);
+#ifdef HAVE_C99FPE
+		CU_TEST(e[j].c.fpes[RELPROF_RESID] == 1 && e[j].c.fpes[RELPROF_GRAD] == 1);
+#endif
+	}
+	relprof_summary_destroy(e,n);
+	relprof_reset();
+
+	system_destroy(sys);
+	system_free_reused_mem();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+#define TESTS(T) \
+	T(hessian) \
+	T(profile)
+
+REGISTER_TESTS_SIMPLE(solver_relman, TESTS)
@@ -94,6 +94,7 @@
 #include <ascend/compiler/case.h>
 #include <ascend/compiler/when_util.h>
 #include <ascend/compiler/link.h>
+#include <ascend/compiler/instantiate.h>
 
 #include "slv_server.h"
 #include "cond_config.h"
@@ -139,6 +140,7 @@ struct gl_list_t *g_symbol_values_list = NULL;
 */
 static void ProcessModelsInWhens(struct Instance *, struct gl_list_t *,
                                  struct gl_list_t *, struct gl_list_t *);
+static void analyze_init_update(slv_system_t sys);
 
 /*------------------------------------------------------------------------------
   SOME STUFF WITH INTERFACE POINTERS
@@ -1980,6 +1982,7 @@ int analyze_make_solvers_lists(struct problem_t *p_data){
     vip = SIP(gl_fetch(p_data->vars,v+1));
     vip->u.v.data = var;
     var_set_instance(var,vip->i);
+    var_set_store(var,NULL,-1);
     var_set_mindex(var,v);
     var_set_sindex(var,v);
     flags = 0; /* all init to FALSE */
@@ -2007,6 +2010,7 @@ int analyze_make_solvers_lists(struct problem_t *p_data){
     vip = SIP(gl_fetch(p_data->pars,v+1));
     vip->u.v.data = var;
     var_set_instance(var,vip->i);
+    var_set_store(var,NULL,-1);
     var_set_mindex(var,v);
     var_set_sindex(var,v);
     flags = 0; /* all init to FALSE */
@@ -2031,6 +2035,7 @@ int analyze_make_solvers_lists(struct problem_t *p_data){
     vip = SIP(gl_fetch(p_data->unas,v+1));
     vip->u.v.data = var;
     var_set_instance(var,vip->i);
+    var_set_store(var,NULL,-1);
     var_set_mindex(var,v);
     var_set_sindex(var,v);
     flags = 0; /* all init to FALSE */
@@ -2748,9 +2753,334 @@ int analyze_make_problem(slv_system_t sys, struct Instance *inst){
   /* configure must set nulls in p_data for anything we want to keep */
   /* blow the temporary lists away */
   analyze_free_lists(p_data);
+  analyze_init_update(sys);
   return 0;
 }
 
+/*------------------------------------------------------------------------------
+  UPDATING A SYSTEM IN PLACE
+
+	After a system is built, the user may fix and free variables, include
+	and exclude relations or change the values that control WHENs. None of
+	these change which objects are in the system or their incidence, so
+	rather than building the system again we just refresh the flags of
+	the objects whose instances were edited. Edits to the instance tree
+	itself (refining, merging, reinstantiating) are detected through
+	g_compiler_counter and need a new system.
+*/
+
+/* what a master list entry found for an instance is */
+enum update_kind {
+  UPD_VAR, UPD_REL, UPD_OBJ, UPD_LOGREL, UPD_DIS
+};
+
+struct update_entry {
+  struct Instance *i;
+  enum update_kind kind;
+  void *obj;
+};
+
+struct analyze_update {
+  long counter;             /* g_compiler_counter when the system was built */
+  int rebuild;              /* an edit was seen that needs a new system */
+  int resync;               /* a mark could not be matched to one object */
+  struct gl_list_t *dirty;  /* instances marked since the last update */
+  struct gl_list_t *dvars;  /* vars refreshed since the last partition */
+  struct gl_list_t *drels;  /* rels refreshed since the last partition */
+  int dall;                 /* dvars and drels do not cover every edit */
+  const mtx_region_t *blocks; /* block list the partition was left with */
+  int32 nblocks;
+  unsigned long hsize;      /* size of table (a power of 2), 0 until made */
+  struct update_entry *table; /* master list entries by instance */
+};
+
+#define UPD_HASH(u,i) \
+  ((((unsigned long)(size_t)(i) >> 4) * 2654435761UL) & ((u)->hsize - 1))
+
+static
+void analyze_init_update(slv_system_t sys){
+  struct analyze_update *u;
+  u = ASC_NEW_CLEAR(struct analyze_update);
+  u->counter = g_compiler_counter;
+  u->dirty = gl_create(10L);
+  u->dvars = gl_create(10L);
+  u->drels = gl_create(10L);
+  u->dall = 1;
+  slv_set_update(sys,u);
+}
+
+void analyze_free_update(slv_system_t sys){
+  struct analyze_update *u;
+  u = (struct analyze_update *)slv_get_update(sys);
+  if(u == NULL)return;
+  gl_destroy(u->dirty);
+  gl_destroy(u->dvars);
+  gl_destroy(u->drels);
+  if(u->table != NULL)ASC_FREE(u->table);
+  ASC_FREE(u);
+  slv_set_update(sys,NULL);
+}
+
+static
+void update_table_add(struct analyze_update *u, struct Instance *i
+		, enum update_kind kind, void *obj
+){
+  unsigned long h;
+  h = UPD_HASH(u,i);
+  while(u->table[h].i != NULL && u->table[h].i != i){
+    h = (h + 1) & (u->hsize - 1);
+  }
+  u->table[h].i = i;
+  u->table[h].kind = kind;
+  u->table[h].obj = obj;
+}
+
+static
+struct update_entry *update_table_find(struct analyze_update *u
+		, struct Instance *i
+){
+  unsigned long h;
+  h = UPD_HASH(u,i);
+  while(u->table[h].i != NULL){
+    if(u->table[h].i == i)return &(u->table[h]);
+    h = (h + 1) & (u->hsize - 1);
+  }
+  return NULL;
+}
+
+/* index all the master lists by instance (done once, on first use) */
+static
+void update_make_table(slv_system_t sys, struct analyze_update *u){
+  struct var_variable **vl[3];
+  struct rel_relation **rl[3];
+  struct logrel_relation **ll[2];
+  struct dis_discrete **dl[2];
+  unsigned long n;
+  int k, c;
+
+  vl[0] = slv_get_master_var_list(sys);
+  vl[1] = slv_get_master_par_list(sys);
+  vl[2] = slv_get_master_unattached_list(sys);
+  rl[0] = slv_get_master_rel_list(sys);
+  rl[1] = slv_get_master_condrel_list(sys);
+  rl[2] = slv_get_master_obj_list(sys);
+  ll[0] = slv_get_master_logrel_list(sys);
+  ll[1] = slv_get_master_condlogrel_list(sys);
+  dl[0] = slv_get_master_dvar_list(sys);
+  dl[1] = slv_get_master_disunatt_list(sys);
+
+  n = slv_get_num_master_vars(sys) + slv_get_num_master_pars(sys)
+    + slv_get_num_master_unattached(sys) + slv_get_num_master_rels(sys)
+    + slv_get_num_master_condrels(sys) + slv_get_num_master_objs(sys)
+    + slv_get_num_master_logrels(sys) + slv_get_num_master_condlogrels(sys)
+    + slv_get_num_master_dvars(sys) + slv_get_num_master_disunatt(sys);
+  u->hsize = 16;
+  while(u->hsize < 2 * n)u->hsize *= 2;
+  u->table = ASC_NEW_ARRAY_CLEAR(struct update_entry,u->hsize);
+
+  for(k = 0; k < 3; k++){
+    for(c = 0; vl[k] != NULL && vl[k][c] != NULL; c++){
+      update_table_add(u,(struct Instance *)var_instance(vl[k][c])
+        ,UPD_VAR,vl[k][c]);
+    }
+    for(c = 0; rl[k] != NULL && rl[k][c] != NULL; c++){
+      update_table_add(u,(struct Instance *)rel_instance(rl[k][c])
+        ,(k == 2 ? UPD_OBJ : UPD_REL),rl[k][c]);
+    }
+  }
+  for(k = 0; k < 2; k++){
+    for(c = 0; ll[k] != NULL && ll[k][c] != NULL; c++){
+      update_table_add(u,(struct Instance *)logrel_instance(ll[k][c])
+        ,UPD_LOGREL,ll[k][c]);
+    }
+    for(c = 0; dl[k] != NULL && dl[k][c] != NULL; c++){
+      update_table_add(u,(struct Instance *)dis_instance(dl[k][c])
+        ,UPD_DIS,dl[k][c]);
+    }
+  }
+}
+
+void analyze_mark_dirty(slv_system_t sys, struct Instance *inst){
+  struct analyze_update *u;
+  u = (struct analyze_update *)slv_get_update(sys);
+  if(u == NULL || inst == NULL)return;
+  gl_append_ptr(u->dirty,(VOIDPTR)inst);
+}
+
+/*
+	Find the object for a marked instance. A mark on a flag such as
+	'fixed' or 'included' stands for a mark on its owner; a mark on the
+	'ode_type', 'ode_id' or 'obs_id' of a variable changes the derivative
+	chains, so the system must be rebuilt. Anything else that is not in
+	the system (a model, say) makes us refresh every object.
+*/
+static
+struct update_entry *update_lookup(struct analyze_update *u
+		, struct Instance *inst
+){
+  struct update_entry *e;
+  struct Instance *parent;
+  e = update_table_find(u,inst);
+  if(e != NULL)return e;
+  if(NumberParents(inst) == 1){
+    parent = InstanceParent(inst,1);
+    if(InstanceKind(parent) == REAL_ATOM_INST
+      && (ChildByChar(parent,DERIV_A) == inst
+        || ChildByChar(parent,ODEID_A) == inst
+        || ChildByChar(parent,OBSID_A) == inst)
+    ){
+      u->rebuild = 1;
+      return NULL;
+    }
+    e = update_table_find(u,parent);
+    if(e != NULL)return e;
+  }
+  u->resync = 1;
+  return NULL;
+}
+
+/*
+	Refresh the flags of one object from its instance.
+	@return 1 if it is a discrete variable used by a WHEN, else 0
+*/
+static
+int update_refresh(enum update_kind kind, void *obj){
+  struct var_variable *var;
+  struct rel_relation *rel;
+  struct dis_discrete *dis;
+  switch(kind){
+  case UPD_VAR:
+    var = (struct var_variable *)obj;
+    if(var_flagbit(var,VAR_SVAR))(void)var_fixed(var);
+    return 0;
+  case UPD_REL:
+    (void)rel_included((struct rel_relation *)obj);
+    return 0;
+  case UPD_OBJ:
+    rel = (struct rel_relation *)obj;
+    rel_set_flagbit(rel,REL_ACTIVE,rel_included(rel));
+    return 0;
+  case UPD_LOGREL:
+    (void)logrel_included((struct logrel_relation *)obj);
+    return 0;
+  case UPD_DIS:
+    dis = (struct dis_discrete *)obj;
+    if(dis_flags(dis) & DIS_BVAR)(void)dis_fixed(dis);
+    return dis_inwhen(dis) ? 1 : 0;
+  }
+  return 0;
+}
+
+/* refresh everything in the master lists */
+static
+int update_refresh_all(slv_system_t sys){
+  struct var_variable **vl;
+  struct rel_relation **rl;
+  struct logrel_relation **ll;
+  struct dis_discrete **dl;
+  int c, inwhen = 0;
+
+#define R(GET,KIND) \
+  for(c = 0; (GET) != NULL && (GET)[c] != NULL; c++){ \
+    inwhen |= update_refresh(KIND,(GET)[c]); \
+  }
+  vl = slv_get_master_var_list(sys);         R(vl,UPD_VAR);
+  vl = slv_get_master_unattached_list(sys);  R(vl,UPD_VAR);
+  rl = slv_get_master_rel_list(sys);         R(rl,UPD_REL);
+  rl = slv_get_master_condrel_list(sys);     R(rl,UPD_REL);
+  rl = slv_get_master_obj_list(sys);         R(rl,UPD_OBJ);
+  ll = slv_get_master_logrel_list(sys);      R(ll,UPD_LOGREL);
+  ll = slv_get_master_condlogrel_list(sys);  R(ll,UPD_LOGREL);
+  dl = slv_get_master_dvar_list(sys);        R(dl,UPD_DIS);
+  dl = slv_get_master_disunatt_list(sys);    R(dl,UPD_DIS);
+#undef R
+  return inwhen || slv_get_num_master_whens(sys) > 0;
+}
+
+int analyze_update_problem(slv_system_t sys){
+  struct analyze_update *u;
+  struct update_entry *e;
+  struct rel_relation **ol;
+  unsigned long c, len;
+  int inwhen = 0, objs = 0;
+
+  u = (struct analyze_update *)slv_get_update(sys);
+  if(u == NULL)return 1;
+  if(u->counter != g_compiler_counter){
+    gl_reset(u->dirty);
+    return 1;
+  }
+
+  len = gl_length(u->dirty);
+  if(len > 0){
+    if(u->table == NULL)update_make_table(sys,u);
+    for(c = 1; c <= len && !u->resync && !u->rebuild; c++){
+      e = update_lookup(u,(struct Instance *)gl_fetch(u->dirty,c));
+      if(e == NULL)continue;
+      inwhen |= update_refresh(e->kind,e->obj);
+      if(e->kind == UPD_OBJ)objs = 1;
+      if(e->kind == UPD_VAR)gl_append_ptr(u->dvars,e->obj);
+      if(e->kind == UPD_REL)gl_append_ptr(u->drels,e->obj);
+    }
+  }
+  gl_reset(u->dirty);
+  if(u->rebuild)return 1;
+
+  if(len == 0 || u->resync){
+    /* no record of what changed: refresh the lot */
+    inwhen = update_refresh_all(sys);
+    objs = 1;
+    u->resync = 0;
+    u->dall = 1;
+  }
+
+  if(objs){
+    /* the objective is the first included one, as in analyze_make_problem */
+    slv_set_obj_relation(sys,NULL);
+    ol = slv_get_master_obj_list(sys);
+    for(c = 0; ol != NULL && ol[c] != NULL; c++){
+      if(rel_included(ol[c])){
+        slv_set_obj_relation(sys,ol[c]);
+        break;
+      }
+    }
+  }
+
+  if(inwhen){
+    reanalyze_solver_lists(sys);
+    u->dall = 1;
+  }
+  return 0;
+}
+
+int analyze_dirty_set(slv_system_t sys
+		, struct gl_list_t **vars, struct gl_list_t **rels
+){
+  struct analyze_update *u;
+  const mtx_block_t *b;
+  u = (struct analyze_update *)slv_get_update(sys);
+  if(u == NULL || u->dall)return 1;
+  /* a solver may have put its own blocks in place (slv_block_unify) */
+  b = slv_get_solvers_blocks(sys);
+  if(b == NULL || b->block != u->blocks || b->nblocks != u->nblocks)return 1;
+  *vars = u->dvars;
+  *rels = u->drels;
+  return 0;
+}
+
+void analyze_clear_dirty_set(slv_system_t sys){
+  struct analyze_update *u;
+  const mtx_block_t *b;
+  u = (struct analyze_update *)slv_get_update(sys);
+  if(u == NULL)return;
+  gl_reset(u->dvars);
+  gl_reset(u->drels);
+  b = slv_get_solvers_blocks(sys);
+  u->blocks = (b != NULL) ? b->block : NULL;
+  u->nblocks = (b != NULL) ? b->nblocks : 0;
+  u->dall = (u->blocks == NULL);
+}
+
 extern void analyze_free_reused_mem(void){
   resize_ipbuf((size_t)0,0);
 }
@@ -78,6 +78,51 @@ extern int analyze_make_problem(slv_system_t sys, struct Instance *inst);
 		back end.
 */
 
+extern void analyze_mark_dirty(slv_system_t sys, struct Instance *inst);
+/**<
+	Record that inst (a variable, relation, logical relation or discrete
+	variable in sys, or one of their 'fixed' or 'included' flags) has been
+	edited since sys was built or last updated. Called by
+	system_mark_dirty.
+*/
+
+extern int analyze_update_problem(slv_system_t sys);
+/**<
+	Bring the flags of sys (fixed variables, included relations, the
+	objective, and the active parts of WHENs) up to date with the instance
+	tree, without rebuilding it. Only the objects marked with
+	analyze_mark_dirty are refreshed; if none were marked, all of them
+	are. Called by system_update.
+
+	@return 0 if sys was updated, 1 if the instance tree has been changed
+		(or a variable's derivative chain edited) so that sys must be
+		built again.
+*/
+
+extern int analyze_dirty_set(slv_system_t sys
+		, struct gl_list_t **vars, struct gl_list_t **rels);
+/**<
+	Get the variables and relations refreshed by analyze_update_problem
+	since the block partition of sys was last made, so that only the
+	blocks holding them need to be partitioned again. The lists belong to
+	sys and are emptied by analyze_clear_dirty_set.
+
+	@return 0 if the lists cover every edit, 1 if they do not (no
+		partition made yet, everything refreshed, WHENs switched, or the
+		solver has replaced the blocks since) and the whole system must be
+		partitioned.
+*/
+
+extern void analyze_clear_dirty_set(slv_system_t sys);
+/**<
+	Empty the lists returned by analyze_dirty_set and note the current
+	blocks of sys as the partition later edits are relative to. Called
+	by slv_block_partition once the blocks are made.
+*/
+
+extern void analyze_free_update(slv_system_t sys);
+/**< Free the record of edits kept for sys. Called by system_destroy. */
+
 extern void analyze_free_reused_mem(void);
 /**< 
 	Resets all internal memory recycles.
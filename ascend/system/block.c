@@ -27,9 +27,13 @@
 #include <ascend/utilities/ascPrint.h>
 #include <ascend/general/panic.h>
 #include <ascend/general/mathmacros.h>
+#include <ascend/general/list.h>
 #include "slv_client.h"
 #include "slv_stdcalls.h"
 #include "model_reorder.h"
+#include "analyze.h"
+
+#include <string.h>
 
 /* #define REINDEX_DEBUG */
 /* #define BLOCKPARTITION_DEBUG */
@@ -125,10 +129,448 @@ static int reindex_rels_from_mtx(slv_system_t sys, int32 lo, int32 hi,
   return 0;
 }
 
+/*------------------------------------------------------------------------------
+  PARTITIONING AGAIN AFTER A SYSTEM UPDATE
+*/
+
+/*
+	After system_update has fixed or freed some variables and included or
+	excluded some relations, the blocks that hold none of them are still
+	square, still have their output assignment and are still strongly
+	connected. We keep each of those whole, in the order the solver left
+	it, assign the rows that lost their column by looking for augmenting
+	paths, and find the strongly connected components of the graph in
+	which each kept block is a single node. A kept block whose assignment
+	is taken over by an augmenting path is partitioned again along with
+	the blocks holding the edits; one that lies on a new cycle is merged
+	into a larger block, as it would be by mtx_partition.
+*/
+
+struct repart {
+  int32 rlen, vlen;
+  int32 rank0;           /* rows 0..rank0-1 are in the old blocks */
+  int32 nb;              /* number of old blocks */
+  const mtx_region_t *blk;
+  int32 *astart, *adj;   /* free incident columns of each included row */
+  int32 *rmatch, *cmatch;
+  int32 *cmark, stamp;
+  int32 *bof;            /* old block of each row 0..rank0-1 */
+  char *redo;            /* old blocks to be partitioned again */
+  int32 *stack, *via, *it;
+};
+
+/* the node of the reduced graph a row belongs to */
+#define RP_NODE(p,r) (((r) < (p)->rank0 && !(p)->redo[(p)->bof[r]]) \
+  ? (p)->bof[r] : (p)->nb + (r))
+#define RP_FIRST(p,n) ((n) < (p)->nb ? (p)->blk[n].row.low : (n) - (p)->nb)
+#define RP_LAST(p,n) ((n) < (p)->nb ? (p)->blk[n].row.high : (n) - (p)->nb)
+
+/**
+	Look for an augmenting path from the unassigned row r0 through the
+	columns lo..hi, and flip it if found. If redo, the old blocks of
+	the rows whose column changed are marked to be partitioned again.
+
+	@return 1 if r0 was assigned, else 0
+*/
+static int repart_augment(struct repart *p, int32 r0
+		, int32 lo, int32 hi, int redo
+){
+  int32 sp, r, c, i;
+
+  p->stamp++;
+  p->stack[0] = r0;
+  p->it[r0] = p->astart[r0];
+  sp = 1;
+  while (sp > 0) {
+    r = p->stack[sp-1];
+    if (p->it[r] == p->astart[r+1]) {
+      sp--;
+      continue;
+    }
+    c = p->adj[p->it[r]++];
+    if (c < lo || c > hi || p->cmark[c] == p->stamp) continue;
+    p->cmark[c] = p->stamp;
+    p->via[sp-1] = c;
+    if (p->cmatch[c] < 0) {
+      for (i = 0; i < sp; i++) {
+        r = p->stack[i];
+        p->rmatch[r] = p->via[i];
+        p->cmatch[p->via[i]] = r;
+        if (redo && r < p->rank0) p->redo[p->bof[r]] = 1;
+      }
+      return 1;
+    }
+    r = p->cmatch[c];
+    p->stack[sp++] = r;
+    p->it[r] = p->astart[r];
+  }
+  return 0;
+}
+
+static int repart_cmp(const void *a, const void *b){
+  return *(const int32 *)a - *(const int32 *)b;
+}
+
+/**
+	Find the strongly connected components of the reduced graph (Tarjan),
+	writing the rows of each into order[] and the position of its first
+	row into bstart[]. Components come out with those they depend on
+	first, which is block lower triangular order.
+
+	@return the number of components
+*/
+static int32 repart_components(struct repart *p, int32 *order, int32 *bstart){
+  int32 nn, n, t, r, c, f, top, sp, tp, count, nscc, len, k, i;
+  int32 *index, *low, *fnode, *frow, *fpos, *tstack;
+  char *onstack;
+
+  nn = p->nb + p->rlen;
+  index = ASC_NEW_ARRAY(int32,nn);
+  low = ASC_NEW_ARRAY(int32,nn);
+  fnode = ASC_NEW_ARRAY(int32,nn);
+  frow = ASC_NEW_ARRAY(int32,nn);
+  fpos = ASC_NEW_ARRAY(int32,nn);
+  tstack = ASC_NEW_ARRAY(int32,nn);
+  onstack = ASC_NEW_ARRAY_CLEAR(char,nn);
+  if (index == NULL || low == NULL || fnode == NULL || frow == NULL
+      || fpos == NULL || tstack == NULL || onstack == NULL) {
+    nscc = -1;
+    goto done;
+  }
+  for (n = 0; n < nn; n++) index[n] = -1;
+
+#define RP_PUSH(N) \
+  index[N] = low[N] = count++; \
+  tstack[tp++] = (N); onstack[N] = 1; \
+  fnode[sp] = (N); frow[sp] = RP_FIRST(p,N); fpos[sp] = p->astart[frow[sp]]; \
+  sp++
+
+  count = sp = tp = nscc = len = 0;
+  for (r = 0; r < p->rlen; r++) {
+    if (p->rmatch[r] < 0) continue;
+    n = RP_NODE(p,r);
+    if (index[n] >= 0) continue;
+    RP_PUSH(n);
+    while (sp > 0) {
+      top = sp - 1;
+      n = fnode[top];
+      /* the next node that n depends on */
+      t = -1;
+      while (frow[top] <= RP_LAST(p,n)) {
+        if (fpos[top] == p->astart[frow[top]+1]) {
+          frow[top]++;
+          if (frow[top] <= RP_LAST(p,n)) fpos[top] = p->astart[frow[top]];
+          continue;
+        }
+        c = p->adj[fpos[top]++];
+        if (p->cmatch[c] < 0) continue;
+        t = RP_NODE(p,p->cmatch[c]);
+        if (t != n) break;
+        t = -1;
+      }
+      if (t >= 0) {
+        if (index[t] < 0) {
+          RP_PUSH(t);
+        } else if (onstack[t]) {
+          low[n] = MIN(low[n],index[t]);
+        }
+        continue;
+      }
+      if (low[n] == index[n]) {
+        /* n is the root of a component; keep its nodes in row order */
+        k = tp;
+        do {
+          f = tstack[--tp];
+          onstack[f] = 0;
+        } while (f != n);
+        for (i = k - 1; i >= tp; i--) tstack[i] = RP_FIRST(p,tstack[i]);
+        qsort(tstack + tp,(size_t)(k - tp),sizeof(int32),repart_cmp);
+        bstart[nscc++] = len;
+        for (i = tp; i < k; i++) {
+          f = RP_NODE(p,tstack[i]);
+          for (c = RP_FIRST(p,f); c <= RP_LAST(p,f); c++) order[len++] = c;
+        }
+      }
+      sp--;
+      if (sp > 0) low[fnode[sp-1]] = MIN(low[fnode[sp-1]],low[n]);
+    }
+  }
+  bstart[nscc] = len;
+#undef RP_PUSH
+
+done:
+  if (index != NULL) ascfree(index);
+  if (low != NULL) ascfree(low);
+  if (fnode != NULL) ascfree(fnode);
+  if (frow != NULL) ascfree(frow);
+  if (fpos != NULL) ascfree(fpos);
+  if (tstack != NULL) ascfree(tstack);
+  if (onstack != NULL) ascfree(onstack);
+  return nscc;
+}
+
+/**
+	Partition sys again, keeping the blocks that hold none of the objects
+	in the dirty set from system_update. Solvers also fix and free
+	variables themselves (an integrator, say), so the flags of the rows
+	and columns of the other blocks are checked too.
+
+	@return 0 on success, 2 on out-of-memory, -1 if the whole system must
+		be partitioned instead
+*/
+static int block_repartition(slv_system_t sys, int32 *rankp){
+  struct gl_list_t *dvars, *drels;
+  struct rel_relation **rp, **rtmp = NULL;
+  struct var_variable **vp, **vtmp = NULL;
+  const struct var_variable **list;
+  const mtx_block_t *b;
+  mtx_region_t *newblocks;
+  struct repart p;
+  var_filter_t vf;
+  rel_filter_t rf;
+  int32 *order = NULL, *bstart = NULL;
+  int32 r, c, k, len, nnz, rank, nscc, pass;
+  unsigned long i;
+  int status = -1;
+
+  *rankp = 0;
+  if (analyze_dirty_set(sys,&dvars,&drels)) return -1;
+  b = slv_get_solvers_blocks(sys);
+  if (b->nblocks < 1 || b->block == NULL) return -1;
+
+  memset(&p,0,sizeof(struct repart));
+  rp = slv_get_solvers_rel_list(sys);
+  vp = slv_get_solvers_var_list(sys);
+  p.rlen = slv_get_num_solvers_rels(sys);
+  p.vlen = slv_get_num_solvers_vars(sys);
+  p.nb = b->nblocks;
+  p.blk = b->block;
+
+  /* the old blocks must be square and tile rows 0..rank0-1 */
+  for (k = 0; k < p.nb; k++) {
+    if (p.blk[k].row.low != p.rank0 || p.blk[k].col.low != p.rank0
+        || p.blk[k].row.high != p.blk[k].col.high
+        || p.blk[k].row.high < p.blk[k].row.low) {
+      return -1;
+    }
+    p.rank0 = p.blk[k].row.high + 1;
+  }
+  if (p.rank0 > p.rlen || p.rank0 > p.vlen) return -1;
+  for (r = 0; r < p.rlen; r++) {
+    if (rel_sindex(rp[r]) != r) return -1;
+  }
+  for (c = 0; c < p.vlen; c++) {
+    if (var_sindex(vp[c]) != c) return -1;
+  }
+
+  rf.matchbits = (REL_INCLUDED | REL_EQUALITY | REL_ACTIVE);
+  rf.matchvalue = (REL_INCLUDED | REL_EQUALITY | REL_ACTIVE);
+  vf.matchbits = (VAR_INCIDENT | VAR_SVAR | VAR_FIXED | VAR_ACTIVE);
+  vf.matchvalue = (VAR_INCIDENT | VAR_SVAR | VAR_ACTIVE);
+
+  status = 2;
+  p.astart = ASC_NEW_ARRAY(int32,p.rlen + 1);
+  p.rmatch = ASC_NEW_ARRAY(int32,p.rlen);
+  p.cmatch = ASC_NEW_ARRAY(int32,p.vlen);
+  p.cmark = ASC_NEW_ARRAY_CLEAR(int32,p.vlen);
+  p.bof = ASC_NEW_ARRAY(int32,p.rank0 + 1);
+  p.redo = ASC_NEW_ARRAY_CLEAR(char,p.nb);
+  p.stack = ASC_NEW_ARRAY(int32,p.rlen + 1);
+  p.via = ASC_NEW_ARRAY(int32,p.rlen + 1);
+  p.it = ASC_NEW_ARRAY(int32,p.rlen);
+  order = ASC_NEW_ARRAY(int32,p.rlen + 1);
+  bstart = ASC_NEW_ARRAY(int32,p.rlen + 1);
+  if (p.astart == NULL || p.rmatch == NULL || p.cmatch == NULL
+      || p.cmark == NULL || p.bof == NULL || p.redo == NULL
+      || p.stack == NULL || p.via == NULL || p.it == NULL
+      || order == NULL || bstart == NULL) {
+    goto done;
+  }
+
+  /* free incident columns of the included rows, counted then filled */
+  for (pass = 0; pass < 2; pass++) {
+    nnz = 0;
+    for (r = 0; r < p.rlen; r++) {
+      p.astart[r] = nnz;
+      if (!rel_apply_filter(rp[r],&rf)) continue;
+      list = rel_incidence_list(rp[r]);
+      len = rel_n_incidences(rp[r]);
+      for (k = 0; k < len; k++) {
+        if (var_apply_filter(list[k],&vf)) {
+          c = var_sindex(list[k]);
+          if (c < 0 || c >= p.vlen || vp[c] != list[k]) {
+            status = -1; /* not in the solvers list: stale indices */
+            goto done;
+          }
+          if (pass) p.adj[nnz] = c;
+          nnz++;
+        }
+      }
+    }
+    p.astart[p.rlen] = nnz;
+    if (!pass) {
+      p.adj = ASC_NEW_ARRAY(int32,nnz + 1);
+      if (p.adj == NULL) goto done;
+    }
+  }
+
+  /* the old blocks holding an edit */
+  for (k = 0; k < p.nb; k++) {
+    for (r = p.blk[k].row.low; r <= p.blk[k].row.high; r++) p.bof[r] = k;
+  }
+  for (i = 1; i <= gl_length(dvars); i++) {
+    c = var_sindex((struct var_variable *)gl_fetch(dvars,i));
+    if (c >= 0 && c < p.rank0) p.redo[p.bof[c]] = 1;
+  }
+  for (i = 1; i <= gl_length(drels); i++) {
+    r = rel_sindex((struct rel_relation *)gl_fetch(drels,i));
+    if (r >= 0 && r < p.rank0) p.redo[p.bof[r]] = 1;
+  }
+  for (r = 0; r < p.rank0; r++) {
+    if (!rel_apply_filter(rp[r],&rf) || !var_apply_filter(vp[r],&vf)) {
+      p.redo[p.bof[r]] = 1;
+    }
+  }
+
+  /* keep the old assignment where it stands */
+  for (r = 0; r < p.rlen; r++) p.rmatch[r] = -1;
+  for (c = 0; c < p.vlen; c++) p.cmatch[c] = -1;
+  for (r = 0; r < p.rank0; r++) {
+    for (k = p.astart[r]; k < p.astart[r+1]; k++) {
+      if (p.adj[k] == r) {
+        p.rmatch[r] = p.cmatch[r] = r;
+        break;
+      }
+    }
+  }
+  /* a block reordered by the solver may have lost its full diagonal */
+  for (k = 0; k < p.nb; k++) {
+    if (p.redo[k]) continue;
+    for (r = p.blk[k].row.low; r <= p.blk[k].row.high; r++) {
+      if (p.rmatch[r] < 0
+          && !repart_augment(&p,r,p.blk[k].col.low,p.blk[k].col.high,0)) {
+        p.redo[k] = 1;
+        break;
+      }
+    }
+  }
+  for (r = 0; r < p.rlen; r++) {
+    if (p.rmatch[r] < 0 && p.astart[r] < p.astart[r+1]) {
+      (void)repart_augment(&p,r,0,p.vlen - 1,1);
+    }
+  }
+  rank = 0;
+  for (r = 0; r < p.rlen; r++) {
+    if (p.rmatch[r] >= 0) rank++;
+  }
+  if (rank == 0) {
+    status = -1;
+    goto done;
+  }
+
+  nscc = repart_components(&p,order,bstart);
+  if (nscc < 0) goto done;
+  assert(bstart[nscc] == rank);
+
+  /* rows: assigned in block order, then the rest as slv_block_partition */
+  rtmp = ASC_NEW_ARRAY(struct rel_relation *,p.rlen);
+  vtmp = ASC_NEW_ARRAY(struct var_variable *,p.vlen);
+  newblocks = ASC_NEW_ARRAY(mtx_region_t,nscc);
+  if (rtmp == NULL || vtmp == NULL || newblocks == NULL) {
+    if (newblocks != NULL) ascfree(newblocks);
+    goto done;
+  }
+  for (k = 0; k < rank; k++) {
+    rtmp[k] = rp[order[k]];
+    vtmp[k] = vp[p.rmatch[order[k]]];
+  }
+  len = rank;
+  for (pass = 0; pass < 3; pass++) {
+    for (r = 0; r < p.rlen; r++) {
+      if (p.rmatch[r] >= 0) continue;
+      if ((pass == 0 && rel_active(rp[r]) && rel_included(rp[r]))
+          || (pass == 1 && rel_active(rp[r]) && !rel_included(rp[r]))
+          || (pass == 2 && !rel_active(rp[r]))) {
+        rtmp[len++] = rp[r];
+      }
+    }
+  }
+  /* columns: assigned, free, fixed, inactive and then nonvars */
+  len = rank;
+  for (pass = 0; pass < 4; pass++) {
+    for (c = 0; c < p.vlen; c++) {
+      if (p.cmatch[c] >= 0) continue;
+      if ((pass == 0 && var_apply_filter(vp[c],&vf))
+          || (pass == 1 && var_flagbit(vp[c],VAR_SVAR) && !var_apply_filter(vp[c],&vf)
+              && var_fixed(vp[c]) && var_active(vp[c]))
+          || (pass == 2 && var_flagbit(vp[c],VAR_SVAR) && !var_apply_filter(vp[c],&vf)
+              && !(var_fixed(vp[c]) && var_active(vp[c])))
+          || (pass == 3 && !var_flagbit(vp[c],VAR_SVAR))) {
+        vtmp[len++] = vp[c];
+      }
+    }
+  }
+  for (r = 0; r < p.rlen; r++) {
+    rp[r] = rtmp[r];
+    rel_set_sindex(rp[r],r);
+  }
+  for (c = 0; c < p.vlen; c++) {
+    vp[c] = vtmp[c];
+    var_set_sindex(vp[c],c);
+  }
+  for (k = 0; k < nscc; k++) {
+    newblocks[k].row.low = newblocks[k].col.low = bstart[k];
+    newblocks[k].row.high = newblocks[k].col.high = bstart[k+1] - 1;
+  }
+  slv_set_solvers_blocks(sys,nscc,newblocks); /* give it to the system */
+  *rankp = rank;
+  status = 0;
+
+done:
+  if (p.astart != NULL) ascfree(p.astart);
+  if (p.adj != NULL) ascfree(p.adj);
+  if (p.rmatch != NULL) ascfree(p.rmatch);
+  if (p.cmatch != NULL) ascfree(p.cmatch);
+  if (p.cmark != NULL) ascfree(p.cmark);
+  if (p.bof != NULL) ascfree(p.bof);
+  if (p.redo != NULL) ascfree(p.redo);
+  if (p.stack != NULL) ascfree(p.stack);
+  if (p.via != NULL) ascfree(p.via);
+  if (p.it != NULL) ascfree(p.it);
+  if (order != NULL) ascfree(order);
+  if (bstart != NULL) ascfree(bstart);
+  if (rtmp != NULL) ascfree(rtmp);
+  if (vtmp != NULL) ascfree(vtmp);
+  return status;
+}
+
 /*------------------------------------------------------------------------------
   PARTITIONING INTO BLOCK LOWER/UPPER TRIANGULAR FORM
 */
 
+/* lot of whining about dof */
+static void block_whine_dof(int32 rank, int32 nrow, int32 ncol){
+  if (rank < nrow) {
+    ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient (%d dependent equations)",
+            nrow - rank);
+  }
+  if (rank < ncol) {
+    if ( nrow != rank) {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient with %d excess columns.",
+              ncol - rank);
+    } else {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System has %d degrees of freedom.", ncol - rank);
+    }
+  }
+  if (ncol == nrow) {
+    if (ncol != rank) {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is (%d) square but rank deficient.",ncol);
+    } else {
+      ERROR_REPORTER_NOLINE(ASC_USER_NOTE,"System is (%d) square.",ncol);
+    }
+  }
+}
+
 /**
 	Perform var and rel reordering to achieve block form.
 
@@ -182,6 +624,26 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
   nrow = slv_count_solvers_rels(sys,&rf);
   ncol = slv_count_solvers_vars(sys,&vf);
 
+  /* after a system_update, redo only the blocks that were edited */
+  if (!uppertriangular) {
+    c = block_repartition(sys,&rank);
+    if (c >= 0) {
+      analyze_clear_dirty_set(sys);
+      if (c) return c;
+      block_whine_dof(rank,nrow,ncol);
+      d = slv_get_dofdata(sys);
+      d->structural_rank = rank;
+      d->n_rows = nrow;
+      d->n_cols = ncol;
+      d->n_fixed = ncolpfix - ncol;
+      d->n_unincluded = nrowpun - nrow;
+      d->reorder.partition = 1;
+      d->reorder.basis_selection = 0;
+      d->reorder.block_reordering = 0;
+      return 0;
+    }
+  }
+
   mtx = mtx_create();
   mtx_set_order(mtx,order);
 
@@ -199,26 +661,7 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
 
   /* CONSOLE_DEBUG("FIRST REL = %p",rp[0]); */
 
-  /* lot of whining about dof */
-  if (rank < nrow) {
-    ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient (%d dependent equations)",
-            nrow - rank);
-  }
-  if (rank < ncol) {
-    if ( nrow != rank) {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient with %d excess columns.",
-              ncol - rank);
-    } else {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System has %d degrees of freedom.", ncol - rank);
-    }
-  }
-  if (ncol == nrow) {
-    if (ncol != rank) {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is (%d) square but rank deficient.",ncol);
-    } else {
-      ERROR_REPORTER_NOLINE(ASC_USER_NOTE,"System is (%d) square.",ncol);
-    }
-  }
+  block_whine_dof(rank,nrow,ncol);
   if (uppertriangular) {
     mtx_ut_partition(mtx);
   } else {
@@ -235,6 +678,7 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
     mtx_block(mtx,c,&(newblocks[c]));
   }
   slv_set_solvers_blocks(sys,len,newblocks); /* give it to the system */
+  analyze_clear_dirty_set(sys);
   d = slv_get_dofdata(sys);
   d->structural_rank = rank;
   d->n_rows = nrow;
@@ -736,25 +1180,29 @@ int slv_set_up_block(slv_system_t sys,int bnum)
   return 0;
 }
 
-/* returns 0 if ok, OTHERWISE if madness detected.
- */
-int slv_spk1_reorder_block(slv_system_t sys,int bnum,int transpose)
-{
+/**
+	Sets the in-block flags for block bnum and makes the incidence matrix
+	of the system, in which the block is the region reg.
+
+	@return the matrix, or NULL if the block is bad (not square, or with an
+	empty row or column).
+*/
+static mtx_matrix_t block_incidence_mtx(slv_system_t sys,int32 bnum
+		,mtx_region_t *reg
+){
   struct rel_relation **rp;
   struct var_variable **vp;
-  mtx_region_t reg;
   const mtx_block_t *b;
   mtx_matrix_t mtx;
   mtx_coord_t coord;
   int32 c,vlen,rlen;
   var_filter_t vf;
   rel_filter_t rf;
-  dof_t *d;
 
-  if (sys==NULL) return 1;
+  if (sys==NULL) return NULL;
   rlen = slv_get_num_solvers_rels(sys);
   vlen = slv_get_num_solvers_vars(sys);
-  if (rlen ==0 || vlen == 0) return 1;
+  if (rlen ==0 || vlen == 0) return NULL;
 
   rp = slv_get_solvers_rel_list(sys);
   vp = slv_get_solvers_var_list(sys);
@@ -765,66 +1213,131 @@ int slv_spk1_reorder_block(slv_system_t sys,int bnum,int transpose)
   vf.matchbits =(VAR_INCIDENT |VAR_SVAR | VAR_FIXED |VAR_INBLOCK | VAR_ACTIVE);
   vf.matchvalue = (VAR_INCIDENT | VAR_SVAR | VAR_INBLOCK | VAR_ACTIVE);
 
-  mtx = mtx_create();
-  mtx_set_order(mtx,MAX(rlen,vlen));
   b = slv_get_solvers_blocks(sys);
   assert(b!=NULL);
-  if (bnum <0 || bnum >= b->nblocks || b->block == NULL) return 1;
-  reg = b->block[bnum];
-  for (c=reg.col.low; c<=reg.col.high; c++) {
+  if (bnum <0 || bnum >= b->nblocks || b->block == NULL) return NULL;
+  *reg = b->block[bnum];
+  for (c=reg->col.low; c<=reg->col.high; c++) {
     var_set_in_block(vp[c],1);
   }
-  for (c=reg.row.low; c<=reg.row.high; c++) {
+  for (c=reg->row.low; c<=reg->row.high; c++) {
     rel_set_in_block(rp[c],1);
   }
-  if (reg.row.low != reg.col.low || reg.row.high != reg.col.high) {
-    return 1; /* must be square */
+  if (reg->row.low != reg->col.low || reg->row.high != reg->col.high) {
+    return NULL; /* must be square */
     /* could also enforce minsize 3x3, but someone my call with a
      * partitionable region, so don't want to.
      */
   }
 
+  mtx = mtx_create();
+  mtx_set_order(mtx,MAX(rlen,vlen));
   if (slv_make_incidence_mtx(sys,mtx,&vf,&rf)) {
     FPRINTF(stderr,
-      "slv_spk1_reorder_block: failure in creating incidence matrix.\n");
+      "slv_reorder_block: failure in creating incidence matrix.\n");
     mtx_destroy(mtx);
-    return 1;
+    return NULL;
   }
   /* verify that block has no empty columns, though not checking diagonal */
-  for (c = reg.row.low; c <= reg.row.high; c++) {
+  for (c = reg->row.low; c <= reg->row.high; c++) {
     coord.col = mtx_FIRST;
     coord.row = c;
     if (mtx_next_in_row(mtx,&coord,mtx_ALL_COLS), coord.col == mtx_LAST) {
       mtx_destroy(mtx);
-      FPRINTF(stderr, "slv_spk1_reorder_block: empty row (%d) found.\n",c);
-      return 1;
+      FPRINTF(stderr, "slv_reorder_block: empty row (%d) found.\n",c);
+      return NULL;
     }
     coord.row = mtx_FIRST;
     coord.col = c;
     if (mtx_next_in_col(mtx,&coord,mtx_ALL_ROWS), coord.row == mtx_LAST) {
-      FPRINTF(stderr, "slv_spk1_reorder_block: empty col (%d) found.\n",c);
+      FPRINTF(stderr, "slv_reorder_block: empty col (%d) found.\n",c);
       mtx_destroy(mtx);
-      return 1;
+      return NULL;
     }
   }
-  if (transpose) {
-    mtx_reorder(mtx,&reg,mtx_TSPK1);
-  } else {
-    mtx_reorder(mtx,&reg,mtx_SPK1);
-  }
-  if (reindex_vars_from_mtx(sys,reg.col.low,reg.col.high,mtx)) {
-    mtx_destroy(mtx);
+  return mtx;
+}
+
+/**
+	Reorders the solvers var and rel lists within reg to match mtx, and
+	records the kind of block reordering done.
+*/
+static int reindex_block_from_mtx(slv_system_t sys,mtx_region_t *reg
+		,mtx_matrix_t mtx,enum mtx_reorder_method rmeth
+){
+  dof_t *d;
+  if (reindex_vars_from_mtx(sys,reg->col.low,reg->col.high,mtx)) {
     return 2;
   }
-  if (reindex_rels_from_mtx(sys,reg.row.low,reg.row.high,mtx)) {
-    mtx_destroy(mtx);
+  if (reindex_rels_from_mtx(sys,reg->row.low,reg->row.high,mtx)) {
     return 2;
   }
   d = slv_get_dofdata(sys);
-  d->reorder.block_reordering = 1;	/* spk1 */
+  if (rmeth == mtx_AMD || rmeth == mtx_COLAMD) {
+    d->reorder.block_reordering = 3; /* amd */
+  } else {
+    d->reorder.block_reordering = 1;	/* spk1 */
+  }
+  return 0;
+}
 
+/* returns 0 if ok, OTHERWISE if madness detected.
+ */
+int slv_reorder_block(slv_system_t sys,int32 bnum
+		,enum mtx_reorder_method rmeth,real64 *fill
+){
+  mtx_region_t reg;
+  mtx_matrix_t mtx;
+  int status;
+
+  mtx = block_incidence_mtx(sys,bnum,&reg);
+  if (mtx == NULL) return 1;
+  if (mtx_reorder(mtx,&reg,rmeth)) {
+    mtx_destroy(mtx);
+    return 1;
+  }
+  if (fill != NULL) {
+    *fill = mtx_reorder_fill(mtx,&reg,0.0);
+  }
+  status = reindex_block_from_mtx(sys,&reg,mtx,rmeth);
   mtx_destroy(mtx);
-  return 0;
+  return status;
+}
+
+int slv_spk1_reorder_block(slv_system_t sys,int bnum,int transpose)
+{
+  return slv_reorder_block(sys,bnum,(transpose ? mtx_TSPK1 : mtx_SPK1),NULL);
+}
+
+int slv_least_fill_reorder_block(slv_system_t sys,int32 bnum,int32 cutoff
+		,enum mtx_reorder_method *rmeth
+){
+  mtx_region_t reg;
+  mtx_matrix_t mtx, amdmtx = NULL;
+  real64 fill, amdfill;
+  int status;
+
+  mtx = block_incidence_mtx(sys,bnum,&reg);
+  if (mtx == NULL) return 1;
+  mtx_reorder(mtx,&reg,mtx_SPK1);
+  *rmeth = mtx_SPK1;
+  if (reg.row.high - reg.row.low + 1 >= cutoff) {
+    /* SPK1 is cheap, so only large blocks are worth a second look */
+    amdmtx = block_incidence_mtx(sys,bnum,&reg);
+    if (amdmtx != NULL && !mtx_reorder(amdmtx,&reg,mtx_AMD)) {
+      amdfill = mtx_reorder_fill(amdmtx,&reg,0.0);
+      fill = mtx_reorder_fill(mtx,&reg,amdfill);
+      if (amdfill >= 0.0 && (fill < 0.0 || amdfill < fill)) {
+        *rmeth = mtx_AMD;
+      }
+    }
+  }
+  status = reindex_block_from_mtx(sys,&reg
+    ,(*rmeth == mtx_AMD ? amdmtx : mtx),*rmeth
+  );
+  mtx_destroy(mtx);
+  if (amdmtx != NULL) mtx_destroy(amdmtx);
+  return status;
 }
 
 /*
@@ -958,6 +1471,97 @@ int slv_tear_drop_reorder_block(slv_system_t sys, int32 bnum,
   return 0;
 }
 
+/*------------------------------------------------------------------------------
+  BLOCK DEPENDENCIES
+*/
+
+slv_block_dag_t *slv_block_dag_create(slv_system_t sys){
+  struct rel_relation **rp;
+  const struct var_variable **incid;
+  const mtx_block_t *b;
+  slv_block_dag_t *dag;
+  int32 *colblock, *mark, vlen, ndep, cap, bnum, a, r, k, c, lev;
+
+  if (sys==NULL) return NULL;
+  b = slv_get_solvers_blocks(sys);
+  if (b==NULL || b->nblocks <= 0 || b->block == NULL) return NULL;
+  rp = slv_get_solvers_rel_list(sys);
+  vlen = slv_get_num_solvers_vars(sys);
+
+  dag = ASC_NEW(slv_block_dag_t);
+  if (dag == NULL) return NULL;
+  colblock = ASC_NEW_ARRAY(int32,MAX(vlen,1));
+  mark = ASC_NEW_ARRAY(int32,b->nblocks);
+  cap = b->nblocks + 16;
+  dag->nblocks = b->nblocks;
+  dag->start = ASC_NEW_ARRAY(int32,b->nblocks+1);
+  dag->level = ASC_NEW_ARRAY(int32,b->nblocks);
+  dag->dep = ASC_NEW_ARRAY(int32,cap);
+  dag->nlevels = 0;
+  if (colblock==NULL || mark==NULL || dag->start==NULL || dag->level==NULL
+      || dag->dep==NULL) goto fail;
+
+  for (c = 0; c < vlen; c++) colblock[c] = -1;
+  for (bnum = 0; bnum < b->nblocks; bnum++) {
+    mark[bnum] = -1;
+    for (c = b->block[bnum].col.low; c <= b->block[bnum].col.high; c++) {
+      if (c >= 0 && c < vlen) colblock[c] = bnum;
+    }
+  }
+
+  ndep = 0;
+  for (bnum = 0; bnum < b->nblocks; bnum++) {
+    dag->start[bnum] = ndep;
+    lev = 0;
+    for (r = b->block[bnum].row.low; r <= b->block[bnum].row.high; r++) {
+      incid = rel_incidence_list(rp[r]);
+      for (k = 0; k < rel_n_incidences(rp[r]); k++) {
+        c = var_sindex(incid[k]);
+        if (c < 0 || c >= vlen) continue;
+        a = colblock[c];
+        if (a < 0 || a == bnum || mark[a] == bnum) continue;
+        if (a > bnum) goto fail; /* not BLT */
+        mark[a] = bnum;
+        if (ndep == cap) {
+          cap *= 2;
+          dag->dep = (int32 *)ascrealloc(dag->dep,cap*sizeof(int32));
+          if (dag->dep == NULL) goto fail;
+        }
+        dag->dep[ndep++] = a;
+        lev = MAX(lev,dag->level[a] + 1);
+      }
+    }
+    /* few deps per block, so insertion sort */
+    for (k = dag->start[bnum] + 1; k < ndep; k++) {
+      a = dag->dep[k];
+      for (c = k; c > dag->start[bnum] && dag->dep[c-1] > a; c--) {
+        dag->dep[c] = dag->dep[c-1];
+      }
+      dag->dep[c] = a;
+    }
+    dag->level[bnum] = lev;
+    dag->nlevels = MAX(dag->nlevels,lev + 1);
+  }
+  dag->start[b->nblocks] = ndep;
+  ascfree(colblock);
+  ascfree(mark);
+  return dag;
+
+fail:
+  if (colblock != NULL) ascfree(colblock);
+  if (mark != NULL) ascfree(mark);
+  slv_block_dag_destroy(dag);
+  return NULL;
+}
+
+void slv_block_dag_destroy(slv_block_dag_t *dag){
+  if (dag == NULL) return;
+  if (dag->start != NULL) ascfree(dag->start);
+  if (dag->dep != NULL) ascfree(dag->dep);
+  if (dag->level != NULL) ascfree(dag->level);
+  ascfree(dag);
+}
+
 /*------------------------------------------------------------------------------
   DEBUG OUTPUT for BLOCK STRUCTURE
 
@@ -69,6 +69,12 @@ ASC_DLLSPEC int slv_block_partition_real(slv_system_t sys, int uppertriangular);
 	we move to using only the bit flags.  Currently var_fixed and
 	rel_included are in charge of the syncronization.
 
+	After a system_update that left a dirty set (see analyze_dirty_set),
+	the BLT form is made by partitioning again only the blocks that hold
+	the edited variables and relations, and those whose assignment the
+	edits take over; the other blocks are kept, in the order the solver
+	left them.
+
 	@param upppertriangular if 1, partition into BUT form. If 0, partitition into BLT for.
 	@return 0 on success, 2 on out-of-memory, 1 on any other failure
 */
@@ -126,6 +132,29 @@ ASC_DLLSPEC int slv_spk1_reorder_block(slv_system_t sys,
  *  @todo Revisit design of slv_set_up_block() - take user matrix?
  */
 
+ASC_DLLSPEC int slv_reorder_block(slv_system_t sys,
+		int32 block, enum mtx_reorder_method rmeth, real64 *fill);
+/**<
+ *  As slv_spk1_reorder_block, but with the block reordered by any of the
+ *  methods of mtx_reorder (SPK1, TSPK1, AMD, COLAMD). If fill is not
+ *  NULL, the number of nonzeros predicted in the LU factors of the block
+ *  as reordered (see mtx_reorder_fill) is returned in it.
+ *
+	@return 0 on success, 2 on out-of-memory, 1 on any other failure.
+ */
+
+ASC_DLLSPEC int slv_least_fill_reorder_block(slv_system_t sys,
+		int32 block, int32 cutoff, enum mtx_reorder_method *rmeth);
+/**<
+ *  As slv_spk1_reorder_block, except that blocks of size cutoff or more
+ *  are also ordered by AMD, and whichever of the SPK1 and AMD orderings
+ *  is predicted to give less fill in the LU factors is kept. SPK1 suits
+ *  the nearly triangular blocks of flowsheets, AMD the large irreducible
+ *  blocks of discretised models. The method used is returned in rmeth.
+ *
+	@return 0 on success, 2 on out-of-memory, 1 on any other failure.
+ */
+
 ASC_DLLSPEC int slv_tear_drop_reorder_block(slv_system_t sys,
                                        int32 blockindex,
                                        int32 cutoff,
@@ -153,6 +182,37 @@ ASC_DLLSPEC int slv_tear_drop_reorder_block(slv_system_t sys,
 	@return ???
  */
 
+/*------------------------------------------------------------------------------
+  BLOCK DEPENDENCIES
+*/
+
+/**
+	Dependencies between the diagonal blocks of a BLT-partitioned system.
+	Block b depends on block a if a relation of b is incident on a
+	variable of a, in which case a < b. Blocks with no path between them
+	in this graph can be solved in any order, or at the same time.
+*/
+typedef struct slv_block_dag_structure{
+	int32 nblocks;
+	int32 *start; /**< deps of block b are dep[start[b]] .. dep[start[b+1]-1] */
+	int32 *dep;   /**< blocks depended upon, in increasing order for each block */
+	int32 *level; /**< 0 for blocks with no deps, else 1 + highest level of its deps */
+	int32 nlevels; /**< 1 + highest level */
+} slv_block_dag_t;
+
+ASC_DLLSPEC slv_block_dag_t *slv_block_dag_create(slv_system_t sys);
+/**<
+	Find the dependencies between the blocks of the system, which must
+	have been partitioned into BLT form by slv_block_partition, using the
+	incidence of the solver's relations.
+
+	@return the graph, or NULL if there are no blocks, if the blocks are not
+	in BLT order, or if out of memory.
+*/
+
+ASC_DLLSPEC void slv_block_dag_destroy(slv_block_dag_t *dag);
+/**< Free a graph from slv_block_dag_create. Safe with NULL. */
+
 ASC_DLLSPEC int system_block_debug(slv_system_t sys, FILE *fp);
 /**<
 	Create debug output detailing the current block structure of the system.
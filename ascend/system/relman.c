@@ -46,11 +46,21 @@
 #include <ascend/compiler/relation.h>
 #include <ascend/compiler/relation_util.h>
 #include <ascend/compiler/relation_io.h>
+#include <ascend/compiler/rel_bytecode.h>
+#include <ascend/compiler/relprof.h>
 
 #include <ascend/general/ltmatrix.h>
+#include <ascend/general/threadpool.h>
+#ifdef ASC_HAVE_PTHREADS
+# include <pthread.h>
+#endif
 
 #include "slv_server.h"
 
+#ifdef HAVE_C99FPE
+# include <fenv.h>
+#endif
+
 //#define DIFF_DEBUG
 //#define EVAL_DEBUG
 /* #define DSOLVE_DEBUG */
@@ -66,11 +76,12 @@
 	not be freed, but the next call to this function will reuse the
 	previous allocation. Memory returned will NOT be zeroed.
 	Calling with nbytes==0 will free any memory allocated.
+	Each thread has its own buffer.
 */
 static
 void *rel_tmpalloc(int nbytes){
-	static char *ptr = NULL;
-	static int cap = 0;
+	static ASC_THREAD_LOCAL char *ptr = NULL;
+	static ASC_THREAD_LOCAL int cap = 0;
 
 	if(nbytes){
 		if(nbytes > cap){
@@ -102,9 +113,12 @@ void *rel_tmpalloc(int nbytes){
 */
 
 
+static void relman_pool_destroy(void);
+
 void relman_free_reused_mem(void){
   rel_tmpalloc(0); /* restoring this call, to avoid minor memory leaks; not sure why it was commented out ages ago -- JP*/
   RelationFindRoots(NULL,0,0,0,0,NULL,NULL,NULL);
+  relman_pool_destroy();
 }
 
 
@@ -360,7 +374,61 @@ real64 relman_glassbox_diffs( struct rel_relation *rel,
 #endif
 
 
+/*
+	For the profile, a floating point exception raised by an evaluation is
+	told apart from a calculation error by the exception flags, which are
+	cleared before the evaluation and then set back as they were, plus any
+	that it raised.
+*/
+#ifdef HAVE_C99FPE
+# define RELMAN_FPE (FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW)
+typedef fexcept_t relman_fpe_t;
+#else
+typedef int relman_fpe_t;
+#endif
+
+static void relman_fpe_begin(relman_fpe_t *saved){
+#ifdef HAVE_C99FPE
+	fegetexceptflag(saved,RELMAN_FPE);
+	feclearexcept(RELMAN_FPE);
+#else
+	(void)saved;
+#endif
+}
+
+/** @return nonzero if an exception was raised since relman_fpe_begin */
+static int relman_fpe_end(const relman_fpe_t *saved){
+#ifdef HAVE_C99FPE
+	int raised = fetestexcept(RELMAN_FPE);
+	if(RELMAN_FPE & ~raised){
+		fesetexceptflag(saved,RELMAN_FPE & ~raised);
+	}
+	return raised != 0;
+#else
+	(void)saved;
+	return 0;
+#endif
+}
+
+static real64 relman_eval_inner(struct rel_relation *rel, int32 *calc_ok, int safe);
+
 real64 relman_eval(struct rel_relation *rel, int32 *calc_ok, int safe){
+	if(RELPROF_ENABLED){
+		real64 res;
+		relman_fpe_t fpe;
+		relprof_ticks_t t0;
+		relman_fpe_begin(&fpe);
+		t0 = relprof_ticks();
+		res = relman_eval_inner(rel,calc_ok,safe);
+		relprof_record_rel(IPTR(rel->instance),RELPROF_RESID
+			,relprof_ticks() - t0,!*calc_ok,relman_fpe_end(&fpe)
+		);
+		return res;
+	}
+	return relman_eval_inner(rel,calc_ok,safe);
+}
+
+static real64 relman_eval_inner(struct rel_relation *rel, int32 *calc_ok, int safe){
 	real64 res;
 	asc_assert(calc_ok!=NULL);
 	asc_assert(rel!=NULL);
@@ -631,6 +699,81 @@ int relman_hess(struct rel_relation *rel, const var_filter_t *filter
 	return status;
 }
 
+int32 relman_hess_pattern(struct rel_relation *rel, const var_filter_t *filter
+		,unsigned long *positions
+){
+	const struct var_variable **vlist;
+	struct RelationBytecode *bc = NULL;
+	unsigned char *nl = NULL;
+	unsigned long nvars = 0;
+	int32 len,i,count = 0;
+
+	assert(rel!=NULL && filter!=NULL && positions!=NULL);
+	len = rel_n_incidences(rel);
+	vlist = rel_incidence_list(rel);
+
+	if(rel->type == e_rel_token){
+		bc = RelationBytecodeGet(GetInstanceRelationOnly(IPTR(rel->instance)));
+	}
+	if(bc!=NULL){
+		nvars = RelationBytecodeNumVars(bc);
+		nl = ASC_NEW_ARRAY(unsigned char,nvars + 1);
+		RelationBytecodeNonlinearVars(bc,nl);
+	}
+
+	for(i=0;i<len;i++){
+		if(!var_apply_filter(vlist[i],filter))continue;
+		if(bc!=NULL && ((unsigned long)i >= nvars || !nl[i]))continue;
+		positions[count++] = (unsigned long)i;
+	}
+
+	if(nl!=NULL)ASC_FREE(nl);
+	return count;
+}
+
+int relman_hess_sparse(struct rel_relation *rel, const unsigned long *positions
+		,int32 count, real64 *values, int32 safe
+){
+	enum safe_err serr = safe_ok;
+	ltmatrix *matrix;
+	int32 len,a,b;
+	int status;
+
+	assert(rel!=NULL && (count==0 || (positions!=NULL && values!=NULL)));
+	if(count==0)return 0;
+
+	if(rel->type == e_rel_token){
+		if(0==RelationBytecodeCalcHessian(
+				GetInstanceRelationOnly(IPTR(rel->instance))
+				,positions,(unsigned long)count,values,safe ? &serr : NULL
+		)){
+			if(safe){
+				safe_error_to_stderr(&serr);
+				return (serr == safe_ok) ? 0 : 1;
+			}
+			return 0;
+		}
+	}
+
+	/* not compilable: evaluate the full local matrix and pick from it */
+	len = rel_n_incidences(rel);
+	matrix = ltmatrix_create(LTMATRIX_LOWER,len);
+	asc_assert(matrix!=NULL);
+	if(safe){
+		status = (int)RelationCalcHessianMtxSafe(rel_instance(rel),matrix,len);
+		safe_error_to_stderr((enum safe_err *)&status);
+	}else{
+		status = RelationCalcHessianMtx(rel_instance(rel),matrix,len);
+	}
+	for(a=0;a<count;a++){
+		for(b=0;b<=a;b++){
+			*values++ = ltmatrix_get_element(matrix,positions[a],positions[b]);
+		}
+	}
+	ltmatrix_destroy(matrix);
+	return status;
+}
+
 /* return 0 on success */
 int relman_diff3(struct rel_relation *rel
 		, const var_filter_t *filter
@@ -873,21 +1016,76 @@ int32 relman_hessian_count(struct rel_relation **rlist, int32 rlen
 }
 #endif
 
+/**
+	Store the gradient of rel, in incidence list order, into its row of mtx
+	for the variables passing filter. If mtx is frozen the values go
+	straight into the packed slots, which are found in the order in which
+	they were first filled, so each lookup is normally a single compare.
+*/
+static void relman_map_row(struct rel_relation *rel
+		, const var_filter_t *filter, mtx_matrix_t mtx
+		, const real64 *gradient
+){
+	const struct var_variable **vlist;
+	mtx_coord_t coord;
+	int32 len, c, slot = -1;
+	boolean frozen;
+
+	len = rel_n_incidences(rel);
+	vlist = rel_incidence_list(rel);
+	coord.row = rel_sindex(rel);
+	assert(coord.row >= 0 && coord.row < mtx_order(mtx));
+	frozen = mtx_is_frozen(mtx);
+	for(c = 0; c < len; c++){
+		if(var_apply_filter(vlist[c],filter)){
+			coord.col = var_sindex(vlist[c]);
+			assert(coord.col >= 0 && coord.col < mtx_order(mtx));
+			if(frozen){
+				slot = mtx_frozen_org_slot(mtx,&coord,slot + 1);
+				if(slot >= 0){
+					mtx_frozen_set_slot(mtx,slot,gradient[c]);
+					continue;
+				}
+			}
+			mtx_fill_org_value(mtx,&coord,gradient[c]);
+		}
+	}
+}
+
+static int relman_diffs_inner(struct rel_relation *rel
+		, const var_filter_t *filter
+		, mtx_matrix_t mtx, real64 *resid, int safe
+);
+
 int relman_diffs(struct rel_relation *rel
 		, const var_filter_t *filter
 		, mtx_matrix_t mtx, real64 *resid, int safe
 ){
-  const struct var_variable **vlist=NULL;
+	if(RELPROF_ENABLED){
+		int status;
+		relman_fpe_t fpe;
+		relprof_ticks_t t0;
+		relman_fpe_begin(&fpe);
+		t0 = relprof_ticks();
+		status = relman_diffs_inner(rel,filter,mtx,resid,safe);
+		relprof_record_rel(IPTR(rel->instance),RELPROF_GRAD
+			,relprof_ticks() - t0,status != 0,relman_fpe_end(&fpe)
+		);
+		return status;
+	}
+	return relman_diffs_inner(rel,filter,mtx,resid,safe);
+}
+
+static int relman_diffs_inner(struct rel_relation *rel
+		, const var_filter_t *filter
+		, mtx_matrix_t mtx, real64 *resid, int safe
+){
   real64 *gradient;
-  int32 len,c;
-  mtx_coord_t coord;
+  int32 len;
   int status,map;
 
   assert(rel!=NULL && filter!=NULL && mtx != NULL);
   len = rel_n_incidences(rel);
-  vlist = rel_incidence_list(rel);
-  coord.row = rel_sindex(rel);
-  assert(coord.row>=0 && coord.row < mtx_order(mtx));
 
   gradient = (real64 *)rel_tmpalloc(len*sizeof(real64));
   assert(gradient !=NULL);
@@ -913,17 +1111,422 @@ int relman_diffs(struct rel_relation *rel
   }
   if(map){
     // successful calculation, map results if safe made
-    for (c=0; c < len; c++) {
-      if (var_apply_filter(vlist[c],filter)) {
-        coord.col = var_sindex(vlist[c]);
-        assert(coord.col >= 0 && coord.col < mtx_order(mtx));
-        mtx_fill_org_value(mtx,&coord,gradient[c]);
-      }
-    }
+    relman_map_row(rel,filter,mtx,gradient);
   }
   return status;
 }
 
+/*------------------------------------------------------------------------------
+  BATCH EVALUATION
+
+  Each batch is done in two phases. In the first, the worker threads
+  evaluate the residuals (and gradients) of the token relations that have
+  a bytecode program into private arrays, using only the reentrant
+  routines of rel_bytecode.h. In the second, the calling thread goes
+  through the list in order, storing residuals, reporting errors and
+  filling the matrix, and evaluating the remaining relations with
+  relman_eval or relman_diffs. Only the calling thread ever touches the
+  relations, the matrix or the error reporter, and the SIGFPE traps of
+  the caller remain in force for everything done in the second phase.
+
+  For the first phase, relations that share a program (such as the same
+  relation in each member of an array of models) are gathered into packs
+  of up to RELBC_LANES, which are evaluated together by
+  RelationBytecodeCalcLanes.
+  The packing is worth having even with only one thread, so then the
+  first phase runs on the calling thread, with floating point exceptions
+  masked as they are in the workers.
+*/
+
+#define RELMAN_BATCH_MIN 128 /* below this many relations, just loop */
+#define RELMAN_BATCH_CHUNK 32 /* relations per pool task (at least) */
+#define RELMAN_BATCH_SERIAL (-1) /* status: leave for the calling thread */
+
+/** relations evaluated together: rel[0..n-1] index the batch's rlist */
+struct relman_pack{
+	int n;
+	int32 rel[RELBC_LANES];
+};
+
+static threadpool_t *relman_pool = NULL;
+static int relman_nthreads = 0; /* 0 = use the default */
+#ifdef ASC_HAVE_PTHREADS
+/* systems may be solved on several threads at once, all sharing the pool */
+static pthread_mutex_t relman_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+struct relman_batch{
+	struct rel_relation **rlist;
+	int32 nrels;
+	int safe;
+	real64 *res; /* nrels residuals */
+	int *status; /* nrels: safe_err, 1 (unsafe error) or RELMAN_BATCH_SERIAL */
+	real64 *grad; /* gradients, at goff[i]; NULL for residuals only */
+	int32 *goff;
+	struct relman_pack *pack; /* packs of the relations not SERIAL */
+	int32 *task; /* ntasks+1: task t does packs task[t]..task[t+1]-1 */
+	int32 ntasks;
+};
+
+static void relman_pool_destroy(void){
+#ifdef ASC_HAVE_PTHREADS
+	pthread_mutex_lock(&relman_pool_lock);
+#endif
+	threadpool_destroy(relman_pool);
+	relman_pool = NULL;
+#ifdef ASC_HAVE_PTHREADS
+	pthread_mutex_unlock(&relman_pool_lock);
+#endif
+}
+
+void relman_set_threads(int nthreads){
+	relman_pool_destroy();
+	relman_nthreads = nthreads < 0 ? 0 : nthreads;
+}
+
+int relman_get_threads(void){
+#if defined(MALLOC_DEBUG) || defined(ASC_WITH_DMALLOC)
+	/* the allocation tracking is not thread-safe */
+	return 1;
+#endif
+	if(relman_nthreads > 0)return relman_nthreads;
+	return threadpool_default_size();
+}
+
+threadpool_t *relman_get_pool(void){
+	threadpool_t *pool;
+	int n;
+#ifdef ASC_HAVE_PTHREADS
+	pthread_mutex_lock(&relman_pool_lock);
+#endif
+	if(relman_pool == NULL){
+		n = relman_get_threads();
+		if(n > 1)relman_pool = threadpool_create(n);
+	}
+	pool = relman_pool;
+#ifdef ASC_HAVE_PTHREADS
+	pthread_mutex_unlock(&relman_pool_lock);
+#endif
+	if(threadpool_size(pool) <= 1)return NULL;
+	return pool;
+}
+
+/*
+	Relations with a BinToken form are left to the usual routines so that
+	the results do not depend on the number of threads. Nothing is threaded
+	while profiling, so that every evaluation goes through relman_eval or
+	relman_diffs.
+*/
+int relman_threadable(struct rel_relation *rel){
+	CONST struct relation *r;
+	if(rel->type != e_rel_token || RELPROF_ENABLED)return 0;
+	r = GetInstanceRelationOnly(IPTR(rel->instance));
+	if(r == NULL || RTOKEN(r).btable > 0)return 0;
+	return RelationBytecodeGet(r) != NULL;
+}
+
+/** status of an unsafe evaluation: nonzero if anything is not finite */
+static int relman_unsafe_status(struct rel_relation *rel, real64 resid
+		, real64 *grad
+){
+	int32 k, status;
+	status = !asc_finite(resid);
+	if(grad == NULL)return status;
+	for(k = 0; k < rel_n_incidences(rel) && !status; ++k){
+		status = !asc_finite(grad[k]);
+	}
+	return status;
+}
+
+int relman_eval_threaded(struct rel_relation *rel, real64 *resid
+		, real64 *grad, int safe
+){
+	CONST struct relation *r;
+	enum safe_err serr = safe_ok;
+
+	r = GetInstanceRelationOnly(IPTR(rel->instance));
+	if(grad == NULL){
+		if(safe){
+			RelationBytecodeCalcResidualSafe(r,resid,&serr);
+			return (int)serr;
+		}
+		RelationBytecodeCalcResidual(r,resid);
+		return relman_unsafe_status(rel,*resid,NULL);
+	}
+	if(safe){
+		RelationBytecodeCalcResidGradSafe(r,resid,grad,&serr);
+		return (int)serr;
+	}
+	RelationBytecodeCalcResidGrad(r,resid,grad);
+	return relman_unsafe_status(rel,*resid,grad);
+}
+
+/** evaluate a pack of relations sharing a program, as relman_eval_threaded */
+static void relman_eval_pack(struct relman_batch *b, CONST struct relman_pack *pk){
+	CONST struct relation *r[RELBC_LANES];
+	real64 res[RELBC_LANES], *grad[RELBC_LANES];
+	enum safe_err serr[RELBC_LANES];
+	int32 i;
+	int k;
+
+	for(k = 0; k < pk->n; ++k){
+		i = pk->rel[k];
+		r[k] = GetInstanceRelationOnly(IPTR(b->rlist[i]->instance));
+		grad[k] = (b->grad == NULL) ? NULL : b->grad + b->goff[i];
+		serr[k] = safe_ok;
+	}
+	RelationBytecodeCalcLanes(r,pk->n,res,(b->grad == NULL ? NULL : grad)
+		,(b->safe ? serr : NULL)
+	);
+	for(k = 0; k < pk->n; ++k){
+		i = pk->rel[k];
+		b->res[i] = res[k];
+		b->status[i] = b->safe ? (int)serr[k]
+			: relman_unsafe_status(b->rlist[i],res[k],grad[k]);
+	}
+}
+
+/** pool task: evaluate one chunk of packs */
+static void relman_batch_task(void *data, int task, int thread){
+	struct relman_batch *b = (struct relman_batch *)data;
+	CONST struct relman_pack *pk;
+	int32 p, i;
+	(void)thread;
+
+	for(p = b->task[task]; p < b->task[task + 1]; ++p){
+		pk = &(b->pack[p]);
+		if(pk->n > 1){
+			relman_eval_pack(b,pk);
+			continue;
+		}
+		i = pk->rel[0];
+		b->status[i] = relman_eval_threaded(b->rlist[i],&b->res[i]
+			,(b->grad == NULL ? NULL : b->grad + b->goff[i]),b->safe
+		);
+	}
+}
+
+/**
+	Put the relations that are not SERIAL into packs, so that those sharing
+	a program end up together, and divide the packs among the tasks. The
+	open pack of each program is found through a small hash table.
+
+	@return the number of packs of more than one relation.
+*/
+static int32 relman_batch_pack(struct relman_batch *b){
+	CONST struct RelationBytecode *bc, **key;
+	int32 *open, i, p, npacks = 0, nmulti = 0, count;
+	unsigned long h, hsize = 16;
+	struct relman_pack *pk;
+
+	while(hsize < 2 * (unsigned long)b->nrels)hsize *= 2;
+	key = ASC_NEW_ARRAY_CLEAR(CONST struct RelationBytecode *,hsize);
+	open = ASC_NEW_ARRAY(int32,hsize);
+	b->pack = ASC_NEW_ARRAY(struct relman_pack,b->nrels);
+
+	for(i = 0; i < b->nrels; ++i){
+		if(b->status[i] == RELMAN_BATCH_SERIAL)continue;
+		bc = RelationBytecodeGet(
+			GetInstanceRelationOnly(IPTR(b->rlist[i]->instance))
+		);
+		h = (((unsigned long)(size_t)bc >> 4) * 2654435761UL) & (hsize - 1);
+		while(key[h] != NULL && key[h] != bc)h = (h + 1) & (hsize - 1);
+		if(key[h] == NULL || b->pack[open[h]].n == RELBC_LANES){
+			key[h] = bc;
+			open[h] = npacks;
+			b->pack[npacks++].n = 0;
+		}
+		pk = &(b->pack[open[h]]);
+		if(pk->n == 1)++nmulti;
+		pk->rel[pk->n++] = i;
+	}
+	ASC_FREE(open);
+	ASC_FREE(key);
+
+	b->task = ASC_NEW_ARRAY(int32,npacks + 1);
+	b->ntasks = 0;
+	b->task[0] = 0;
+	for(p = 0, count = 0; p < npacks; ++p){
+		count += b->pack[p].n;
+		if(count >= RELMAN_BATCH_CHUNK || p == npacks - 1){
+			b->task[++b->ntasks] = p + 1;
+			count = 0;
+		}
+	}
+	return nmulti;
+}
+
+/**
+	Run the first phase on the calling thread, under the same floating
+	point environment as the pool workers.
+*/
+static void relman_batch_inline(struct relman_batch *b){
+	int32 t;
+#ifdef HAVE_C99FPE
+	fenv_t env;
+	fegetenv(&env);
+	fesetenv(FE_DFL_ENV);
+#endif
+	for(t = 0; t < b->ntasks; ++t){
+		relman_batch_task(b,t,0);
+	}
+#ifdef HAVE_C99FPE
+	feclearexcept(FE_ALL_EXCEPT);
+	fesetenv(&env);
+#endif
+}
+
+static void relman_batch_free(struct relman_batch *b){
+	if(b->task)ASC_FREE(b->task);
+	if(b->pack)ASC_FREE(b->pack);
+	if(b->grad)ASC_FREE(b->grad);
+	if(b->goff)ASC_FREE(b->goff);
+	ASC_FREE(b->status);
+	ASC_FREE(b->res);
+}
+
+/**
+	Set up the batch and run the first phase. Returns 0 if there is no
+	point (too few relations, nothing compilable, or only one thread and
+	no relations sharing a program), in which case nothing is allocated.
+*/
+static int relman_batch_run(struct relman_batch *b, struct rel_relation **rlist
+		, int32 nrels, int safe, int grad
+){
+	threadpool_t *pool;
+	int32 i, ncompiled = 0, ntotal = 0;
+
+	if(nrels < RELMAN_BATCH_MIN)return 0;
+	pool = relman_get_pool();
+
+	b->rlist = rlist;
+	b->nrels = nrels;
+	b->safe = safe;
+	b->res = ASC_NEW_ARRAY(real64,nrels);
+	b->status = ASC_NEW_ARRAY(int,nrels);
+	b->grad = NULL;
+	b->goff = grad ? ASC_NEW_ARRAY(int32,nrels+1) : NULL;
+	b->pack = NULL;
+	b->task = NULL;
+
+	/* compilation is not thread-safe, so make sure it is all done here */
+	for(i = 0; i < nrels; ++i){
+		if(grad)b->goff[i] = ntotal;
+		if(relman_threadable(rlist[i])){
+			b->status[i] = 0;
+			++ncompiled;
+			if(grad)ntotal += rel_n_incidences(rlist[i]);
+		}else{
+			b->status[i] = RELMAN_BATCH_SERIAL;
+		}
+	}
+	if(ncompiled == 0 || (relman_batch_pack(b) == 0 && pool == NULL)){
+		relman_batch_free(b);
+		return 0;
+	}
+	if(grad){
+		b->goff[nrels] = ntotal;
+		b->grad = ASC_NEW_ARRAY(real64,MAX(ntotal,1));
+	}
+
+	if(pool == NULL || b->ntasks == 1){
+		relman_batch_inline(b);
+	}else{
+		threadpool_run(pool,b->ntasks,&relman_batch_task,b);
+	}
+	return 1;
+}
+
+int32 relman_eval_batch(struct rel_relation **rlist, int32 nrels
+		, real64 *resid, int32 *calc_ok, int safe
+){
+	struct relman_batch b;
+	struct rel_relation *rel;
+	int32 i, ok, nfail = 0;
+	enum safe_err serr;
+
+	if(!relman_batch_run(&b,rlist,nrels,safe,0)){
+		for(i = 0; i < nrels; ++i){
+			resid[i] = relman_eval(rlist[i],&ok,safe);
+			if(calc_ok != NULL)calc_ok[i] = ok;
+			if(!ok)++nfail;
+		}
+		return nfail;
+	}
+
+	/* second phase: the same outcomes as relman_eval */
+	for(i = 0; i < nrels; ++i){
+		rel = rlist[i];
+		if(b.status[i] == RELMAN_BATCH_SERIAL){
+			resid[i] = relman_eval(rel,&ok,safe);
+		}else if(safe){
+			ok = 1;
+			if(b.status[i]){
+				serr = (enum safe_err)b.status[i];
+				safe_error_to_stderr(&serr);
+				ok = 0;
+			}
+			resid[i] = b.res[i];
+			rel_set_residual(rel,resid[i]);
+		}else if(b.status[i]){
+			ok = 0;
+			resid[i] = 1.0e8;
+			CONSOLE_DEBUG("RELMAN_EVAL WAS NOT OK");
+		}else{
+			ok = 1;
+			resid[i] = b.res[i];
+			rel_set_residual(rel,resid[i]);
+		}
+		if(calc_ok != NULL)calc_ok[i] = ok;
+		if(!ok)++nfail;
+	}
+	relman_batch_free(&b);
+	return nfail;
+}
+
+int32 relman_diffs_batch(struct rel_relation **rlist, int32 nrels
+		, const var_filter_t *filter, mtx_matrix_t mtx
+		, real64 *resid, int safe
+){
+	struct relman_batch b;
+	struct rel_relation *rel;
+	int32 i, nfail = 0;
+	real64 r;
+	enum safe_err serr;
+
+	assert(filter != NULL && mtx != NULL);
+	if(!relman_batch_run(&b,rlist,nrels,safe,1)){
+		for(i = 0; i < nrels; ++i){
+			if(relman_diffs(rlist[i],filter,mtx,&r,safe))++nfail;
+			if(resid != NULL)resid[i] = r;
+		}
+		return nfail;
+	}
+
+	/* second phase: the same outcomes as relman_diffs */
+	for(i = 0; i < nrels; ++i){
+		rel = rlist[i];
+		if(b.status[i] == RELMAN_BATCH_SERIAL){
+			if(relman_diffs(rel,filter,mtx,&r,safe))++nfail;
+			if(resid != NULL)resid[i] = r;
+			continue;
+		}
+		if(resid != NULL)resid[i] = b.res[i];
+		if(b.status[i]){
+			++nfail;
+			if(safe){
+				serr = (enum safe_err)b.status[i];
+				safe_error_to_stderr(&serr);
+			}else{
+				continue; /* for unsafe eval, only map if no error */
+			}
+		}
+		relman_map_row(rel,filter,mtx,b.grad + b.goff[i]);
+	}
+	relman_batch_free(&b);
+	return nfail;
+}
+
 #if 0 & REIMPLEMENT /* this needs to be reimplemented in the compiler */
 real64 relman_diffs_orig( struct rel_relation *rel, var_filter_t *filter
 		,mtx_matrix_t mtx
@@ -1022,9 +1625,10 @@ real64 *relman_directly_solve_new( struct rel_relation *rel,
 				{
 					/* FIXME bug 564 is caused somewhere in the code called 
 					from here, but only in some cases, on 64-bit machines. */
-					int nvars,n;
+					int nvars,n,current;
 					const struct var_variable **vlist;
 					int vindex; /* index to the compiler */
+					real64 lower, upper, nominal;
 					nvars = rel_n_incidences(rel);
 					vlist = rel_incidence_list(rel);
 					vindex = 0;
@@ -1036,12 +1640,18 @@ real64 *relman_directly_solve_new( struct rel_relation *rel,
 						    break;
 					    }
 					}
+					lower = var_lower_bound(solvefor);
+					upper = var_upper_bound(solvefor);
+					nominal = var_nominal(solvefor);
+					current = (var_store(solvefor) != NULL
+						&& var_store_current(var_store(solvefor)));
 					value = RelationFindRoots(IPTR(rel_instance(rel))
-							, var_lower_bound(solvefor)
-							, var_upper_bound(solvefor)
-							, var_nominal(solvefor)
+							, lower, upper, nominal
 							, tolerance, &(vindex), able, nsolns
 					);
+					/* the root finder leaves its trial values in the ATOM of
+					solvefor, and writes no other */
+					if(current)var_store_reread(solvefor);
 					return value;
 				}
 			case e_rel_blackbox:
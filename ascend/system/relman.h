@@ -36,6 +36,7 @@
 
 #include <ascend/linear/mtx.h>
 #include <ascend/general/ltmatrix.h>
+#include <ascend/general/threadpool.h>
 
 #include "var.h"
 #include "rel.h"
@@ -113,6 +114,9 @@ ASC_DLLSPEC real64 relman_eval(struct rel_relation *rel, int32 *calc_okp, int sa
 	@param calc_ok (returned) status of the calculation. 0=error, else ok.
 	@return residual (= LHS - RHS, regardless of comparison)
 
+	While profiling is enabled (see relprof.h), the call is recorded
+	against the relation, as are calls of relman_diffs.
+
 	@NOTE
 	This function should be surrounded by Asc_SignalHandlerPush/Pop both
 	with arguments (SIGFPE,SIG_IGN). If it is being called in a loop,
@@ -201,6 +205,39 @@ ASC_DLLSPEC int relman_hess(struct rel_relation *rel,
 	@return 0 on success, non-zero if an error is encountered in the calculation
 */
 
+ASC_DLLSPEC int32 relman_hess_pattern(struct rel_relation *rel,
+                        const var_filter_t *filter,
+                        unsigned long *positions);
+/**<
+	Structural sparsity of the Hessian of a relation.
+	Fills positions with the incidence-list positions (counting from 0) of
+	the variables that pass the filter and that can have nonzero second
+	derivatives, ie those appearing nonlinearly in the relation. The
+	Hessian of the relation is confined to the pairs of these variables.
+	If the structure of the relation can't be analysed, all the filtered
+	incidences are returned.
+
+	@param positions output array, at least rel_n_incidences(rel) long.
+	@return the number of positions filled.
+*/
+
+ASC_DLLSPEC int relman_hess_sparse(struct rel_relation *rel,
+                        const unsigned long *positions,
+                        int32 count,
+                        real64 *values,
+                        int32 safe);
+/**<
+	Evaluate the Hessian of a relation at the current variable values,
+	restricted to the incidence positions given (typically the output of
+	relman_hess_pattern). The cost grows with count, not with the number
+	of incidences.
+
+	@param values output, the packed lower triangle in the order of
+		positions: values[a*(a+1)/2 + b] is the second derivative with
+		respect to the variables at positions[a] and positions[b], b <= a.
+	@return 0 on success, non-zero if an error is encountered in the calculation
+*/
+
 ASC_DLLSPEC int relman_diff3(struct rel_relation *rel,
                         const var_filter_t *filter,
                         real64 *derivatives,
@@ -274,6 +311,9 @@ ASC_DLLSPEC int relman_diffs(struct rel_relation *rel,
 	@NOTE The row of the mtx corresponding to rel should be cleared
 	before calling this function, since this FILLS with the gradient.<br><br>
 
+	If mtx has been frozen (mtx_freeze) the gradient is written straight
+	into the existing packed elements of the row.<br><br>
+
 	@NOTE *changed* -- This operator used to just ADD on top of any incidence
 	already in the row. This is not TRUE now.
 
@@ -281,6 +321,101 @@ ASC_DLLSPEC int relman_diffs(struct rel_relation *rel,
 	harwellian matrices, glassbox rels and blackbox.
 */
 
+/*------------------------------------------------------------------------------
+  BATCH EVALUATION
+*/
+
+ASC_DLLSPEC int32 relman_eval_batch(struct rel_relation **rlist, int32 nrels
+		, real64 *resid, int32 *calc_ok, int safe);
+/**<
+	Evaluate the residuals of nrels relations, as relman_eval would for
+	each of them, spreading the work over the relman thread pool.
+
+	Token relations that can be compiled to bytecode (see rel_bytecode.h)
+	are evaluated by the worker threads, those sharing a program several
+	at a time in SIMD lanes (see RelationBytecodeCalcLanes). All other
+	relations, including blackbox and glassbox ones and token relations
+	with a BinToken form, are passed to relman_eval on the calling thread,
+	as are all relations when nrels is small. With only one thread, the
+	relations that share programs are still evaluated in lanes, by the
+	calling thread. Residual fields of the relations are set, and messages
+	issued, on the calling thread only.
+
+	Bytecode evaluation runs with floating-point exceptions masked, so in
+	unsafe mode a relation whose residual comes out non-finite is treated
+	as a calculation error (residual returned as 1e8 and not stored), which
+	is what a caught SIGFPE amounts to in the serial code.
+
+	@param rlist relations to evaluate
+	@param resid output, nrels residuals
+	@param calc_ok output, nrels flags, 0=error, else ok; may be NULL.
+	@param safe as for relman_eval
+	@return the number of relations for which the calculation failed.
+*/
+
+ASC_DLLSPEC int32 relman_diffs_batch(struct rel_relation **rlist, int32 nrels
+		, const var_filter_t *filter, mtx_matrix_t mtx
+		, real64 *resid, int safe);
+/**<
+	Calculate the residuals and Jacobian rows of nrels relations, as
+	relman_diffs would for each of them, using the relman thread pool in
+	the same way as relman_eval_batch. The matrix is filled only from the
+	calling thread.
+
+	@param resid output, nrels residuals; may be NULL.
+	@return the number of relations for which relman_diffs would have
+		returned nonzero status.
+*/
+
+ASC_DLLSPEC void relman_set_threads(int nthreads);
+/**<
+	Set the number of threads used by relman_eval_batch and
+	relman_diffs_batch, including the calling thread. 1 leaves all the
+	work to the calling thread; 0 restores the default, which is the value
+	of the environment variable ASCEND_NUM_THREADS if set, else the number
+	of processors online.
+*/
+
+ASC_DLLSPEC int relman_get_threads(void);
+/**<
+	Number of threads that the batch routines will use.
+*/
+
+ASC_DLLSPEC threadpool_t *relman_get_pool(void);
+/**<
+	The thread pool used by the batch routines, starting it if need be,
+	or NULL if only one thread is to be used. Solvers may run their own
+	tasks on it. The pool is shared by all systems, so a job posted while
+	it is busy (eg by a system being solved on another thread) is run on
+	the calling thread alone; see threadpool_run.
+*/
+
+ASC_DLLSPEC int relman_threadable(struct rel_relation *rel);
+/**<
+	Returns TRUE if rel can be evaluated by relman_eval_threaded, ie it is
+	a token relation with a bytecode form (see rel_bytecode.h). The
+	relation is compiled if need be. Compilation is serialised between
+	threads, but must still be done before any worker of a batch
+	evaluates rel.
+	Always FALSE while profiling is enabled (see relprof.h).
+*/
+
+ASC_DLLSPEC int relman_eval_threaded(struct rel_relation *rel, real64 *resid
+		, real64 *grad, int safe);
+/**<
+	Evaluate a relation for which relman_threadable is TRUE, from any
+	thread. Nothing is stored in rel and no messages are issued, so
+	several threads may evaluate relations at once, provided that none
+	of them changes the values of variables that another one reads.
+
+	@param resid output, the residual
+	@param grad output, the gradient in the order of rel_incidence_list,
+		or NULL for the residual only.
+	@param safe as for relman_eval
+	@return 0 if ok, else nonzero (a non-finite result counts as an
+		error in unsafe mode).
+*/
+
 #if 0 && THIS_IS_A_DISUSED_FUNCTION
 extern int32 relman_diff_harwell(struct rel_relation **rlist,
 		var_filter_t *vfilter, rel_filter_t *rfilter,
@@ -453,7 +588,11 @@ extern char *dummyrelstring(slv_system_t sys,
 #endif
 
 extern void relman_free_reused_mem(void);
-/**< Call when desired to free memory cached internally. */
+/**<
+	Call when desired to free memory cached internally. This also stops
+	the worker threads of the batch routines; they are restarted when next
+	needed.
+*/
 
 /* @} */
 
@@ -236,6 +236,8 @@ int slv_destroy(slv_system_t sys)
 	ERROR_REPORTER_HERE(ASC_PROG_FATAL,"slv_destroy: slv_system_t 0x%p not freed.",sys);
   } else {
 
+	slv_var_store_destroy(sys);
+
 	SLV_FREE_BUFS(SLV_FREE_BUF, SLV_FREE_BUF_GLOBAL)
 
 	DEFINE_SET_INCIDENCES(SLV_FREE_INCIDENCE,SLV_FREE_INCIDENCE)
@@ -528,6 +530,91 @@ void slv_bnd_initialization(slv_system_t sys)
   }
 }
 
+/*------------------------------------------------------------------------------
+  VARIABLE VALUE STORE
+*/
+
+/* attach the n variables of list to s, from position k on */
+static int32 slv_var_store_attach(struct var_store *s, int32 k
+		, struct var_variable **list, int32 n
+){
+  int32 c;
+  for(c = 0; c < n; c++, k++){
+    s->vars[k] = list[c];
+    var_set_store(list[c],s,k);
+  }
+  return k;
+}
+
+int slv_var_store_gather(slv_system_t sys){
+  struct var_store *s;
+  int32 n, k;
+
+  n = sys->vars.mnum + sys->pars.mnum + sys->unattached.mnum;
+  if(n <= 0 || sys->vars.master == NULL)return 1;
+
+  s = sys->varstore;
+  if(s != NULL && s->n != n){
+    slv_var_store_destroy(sys);
+    s = NULL;
+  }
+  if(s == NULL){
+    s = ASC_NEW(struct var_store);
+    if(s == NULL)return 1;
+    /* one block for all four arrays, so they stay close together */
+    s->value = ASC_NEW_ARRAY(real64,4*n);
+    s->vars = ASC_NEW_ARRAY(struct var_variable *,n);
+    if(s->value == NULL || s->vars == NULL){
+      if(s->value != NULL)ascfree(s->value);
+      if(s->vars != NULL)ascfree(s->vars);
+      ascfree(s);
+      return 1;
+    }
+    s->nominal = s->value + n;
+    s->lower = s->nominal + n;
+    s->upper = s->lower + n;
+    s->n = n;
+    sys->varstore = s;
+  }
+
+  k = slv_var_store_attach(s,0,sys->vars.master,sys->vars.mnum);
+  k = slv_var_store_attach(s,k,sys->pars.master,sys->pars.mnum);
+  k = slv_var_store_attach(s,k,sys->unattached.master,sys->unattached.mnum);
+  asc_assert(k == n);
+  var_store_refresh(s);
+  return 0;
+}
+
+int slv_var_store_sync(slv_system_t sys){
+  struct var_store *s = sys->varstore;
+  if(s == NULL)return 1;
+  if(!var_store_current(s)){
+    var_store_refresh(s);
+  }
+  return 0;
+}
+
+struct var_store *slv_get_var_store(slv_system_t sys){
+  return sys->varstore;
+}
+
+void slv_var_store_destroy(slv_system_t sys){
+  struct var_store *s;
+  int32 c;
+
+  s = sys->varstore;
+  if(s == NULL)return;
+  /* the var lists may already be gone (see system_destroy), but the
+  	buffers holding the variables are freed only after us */
+  for(c = 0; c < s->n; c++){
+    var_set_store(s->vars[c],NULL,-1);
+  }
+  ascfree(s->vars);
+  ascfree(s->value);
+  ascfree(s);
+  sys->varstore = NULL;
+}
+
 struct gl_list_t *slv_get_symbol_list(slv_system_t sys)
 {
   if (sys==NULL) {
@@ -970,3 +1057,12 @@ int slv_set_diffvars(slv_system_t sys,void *diffvars){
 	return 0;
 }
 
+void *slv_get_update(slv_system_t sys){
+	return sys->update;
+}
+
+int slv_set_update(slv_system_t sys,void *update){
+	sys->update = update;
+	return 0;
+}
+
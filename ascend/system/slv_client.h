@@ -527,6 +527,41 @@ ASC_DLLSPEC void slv_bnd_initialization(slv_system_t sys);
 	function provided in bndman.
 */
 
+ASC_DLLSPEC int slv_var_store_gather(slv_system_t sys);
+/**<
+	Copies the value, nominal and bounds of every real variable of the
+	system (master vars, parameters and unattached vars) into its
+	contiguous value store (see struct var_store in var.h), allocating it
+	on first use, and attaches the variables to it. Called by slv_presolve
+	and integrator_solve.
+
+	@return 0 on success, 1 if sys has no variables or memory ran out.
+*/
+
+ASC_DLLSPEC int slv_var_store_sync(slv_system_t sys);
+/**<
+	Fills the store again if any real ATOM has been written since it was
+	last filled, other than through the var_set_* functions. Called by
+	slv_resolve, after slv_iterate and slv_solve, and after each report
+	made by an integrator. The var_* getters do the same check themselves,
+	so this only brings the work forward to a point outside the loops.
+
+	@return 0 on success, 1 if there is no store.
+*/
+
+ASC_DLLSPEC struct var_store *slv_get_var_store(slv_system_t sys);
+/**<
+	Returns the system's value store, or NULL if slv_var_store_gather has
+	not yet been called. The arrays are indexed by var_store_index; call
+	slv_var_store_sync before reading them directly.
+*/
+
+ASC_DLLSPEC void slv_var_store_destroy(slv_system_t sys);
+/**<
+	Detaches the variables from the value store and frees it. The var_*
+	accessors then revert to reading the ATOMs. Called by slv_destroy.
+*/
+
 extern void slv_set_solvers_var_list(slv_system_t sys,
                                      struct var_variable **vlist,
                                      int size);
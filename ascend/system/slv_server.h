@@ -363,6 +363,12 @@ ASC_DLLSPEC int32 slv_far_from_nominals(slv_system_t sys, real64 bignum, int32 *
 int slv_set_diffvars(slv_system_t sys,void *diffvars);
 /**< @return 0 on success */
 
+void *slv_get_update(slv_system_t sys);
+/**< Record of edits kept by analyze.c for analyze_update_problem, or NULL. */
+
+int slv_set_update(slv_system_t sys,void *update);
+/**< @return 0 on success */
+
 /* @} */
 
 #endif  /* ASC_SLV_SERVER_H */
@@ -281,8 +281,9 @@ int slv_check_bounds(const slv_system_t sys
 	,int32 lo,int32 hi, const char *label
 ){
   real64 val,low,high;
-  int32 c,len;
+  int32 c,len,m;
   struct var_variable *var, **vp;
+  struct var_store *vs;
   int err = 0;
 
   //CONSOLE_DEBUG("Got lo = %d, hi =%d",lo,hi);
@@ -299,11 +300,20 @@ int slv_check_bounds(const slv_system_t sys
     return -1;
   }
 
+  vs = slv_get_var_store(sys);
+  if(vs!=NULL) slv_var_store_sync(sys);
   for (c= lo; c <= hi; c++) {
     var = vp[c];
-    low = var_lower_bound(var);
-    high = var_upper_bound(var);
-    val = var_value(var);
+    if(vs!=NULL && var_store(var)==vs){
+      m = var_store_index(var);
+      low = vs->lower[m];
+      high = vs->upper[m];
+      val = vs->value[m];
+    }else{
+      low = var_lower_bound(var);
+      high = var_upper_bound(var);
+      val = var_value(var);
+    }
     if( low > high ) {
       ERROR_REPORTER_START_NOLINE(ASC_USER_ERROR);
       FPRINTF(ASCERR,"Bounds for %s variable '",label);
@@ -41,6 +41,8 @@
 #include "analyze.h"
 #include "slv_common.h"
 
+#include <ascend/solver/solver.h>
+
 //#define ASC_SYSTEM_DEBUG
 #ifdef ASC_SYSTEM_DEBUG
 # define DOTIME 1
@@ -125,6 +127,7 @@ void system_destroy(slv_system_t sys){
 #undef FN
 
 	system_diffvars_destroy(sys);
+	analyze_free_update(sys);
 
 	symbollist=slv_get_symbol_list(sys);
 	if(symbollist != NULL)DestroySymbolValuesList(symbollist);
@@ -134,6 +137,29 @@ void system_destroy(slv_system_t sys){
 	slv_destroy(sys); /* frees buf data */
 }
 
+void system_mark_dirty(slv_system_t sys, SlvBackendToken inst){
+  analyze_mark_dirty(sys,IPTR(inst));
+}
+
+int system_update(slv_system_t sys){
+  return analyze_update_problem(sys);
+}
+
+slv_system_t system_rebuild(slv_system_t sys, SlvBackendToken inst){
+  int solver = -1;
+  if(sys != NULL){
+    if(!system_update(sys))return sys;
+    MSG("Instance tree has changed; building system again");
+    solver = slv_get_selected_solver(sys);
+    system_destroy(sys);
+  }
+  sys = system_build(inst);
+  if(sys != NULL && solver >= 0){
+    slv_select_solver(sys,solver);
+  }
+  return sys;
+}
+
 void system_free_reused_mem(){
   mtx_free_reused_mem();
   linsolqr_free_reused_mem();
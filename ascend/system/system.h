@@ -63,6 +63,38 @@ ASC_DLLSPEC void system_destroy(slv_system_t sys);
 	Destroys the latest model formulation.
 */
 
+ASC_DLLSPEC void system_mark_dirty(slv_system_t sys, SlvBackendToken inst);
+/**<
+	Tell sys that inst has been edited since sys was built, eg a variable
+	fixed or freed, a relation included or excluded (inst may be the
+	'fixed' or 'included' flag itself), or a value that controls a WHEN
+	changed. The edits are applied by system_update. Marking is optional:
+	system_update refreshes everything if nothing was marked.
+*/
+
+ASC_DLLSPEC int system_update(slv_system_t sys);
+/**<
+	Update sys in place after edits to the instance tree, refreshing only
+	the objects marked with system_mark_dirty, so that the cost depends
+	on the size of the edit and not of the model. The objects refreshed
+	are kept as a dirty set for the solver's next presolve, whose
+	slv_block_partition then partitions again only the blocks holding
+	them; the other blocks keep their rows and columns as they were. If
+	nothing was marked, the whole system is partitioned.
+
+	Edits that change the structure of the instance tree (refining,
+	merging, reinstantiating) can't be applied in place.
+
+	@return 0 if sys is up to date, 1 if it must be built again.
+*/
+
+ASC_DLLSPEC slv_system_t system_rebuild(slv_system_t sys, SlvBackendToken inst);
+/**<
+	Update sys in place if possible, else destroy it and build a new
+	system from inst, with the same solver selected.
+	@return the system to use from now on (NULL if the build failed).
+*/
+
 ASC_DLLSPEC void system_free_reused_mem(void);
 /**<
 	Deallocates any memory that solvers may be squirrelling away for
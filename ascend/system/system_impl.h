@@ -93,6 +93,9 @@ struct system_structure {
 		struct var_variable *buf;
 	} vars;
 
+	/** contiguous copies of master var data, see slv_var_store_gather */
+	struct var_store *varstore;
+
 	/** discrete-valued variabled (integers, booleans, enumerations) */
 	struct {
 		int snum;		        	/* length of the solver list */
@@ -198,6 +201,8 @@ struct system_structure {
 	/**< derivative chains, if present (NULL if not present) */
 	struct SolverDiffVarCollectionStruct *diffvars; 
 
+	void *update; /**< record of edits since the system was built, see analyze_update_problem */
+
 	/* ----- the data that follows is for internal consumption only.--------- */
 
 	/** external relations */
@@ -31,6 +31,7 @@
 
 #include <ascend/utilities/config.h>
 #include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
 #include <ascend/general/platform.h>
 #include <ascend/general/dstring.h>
 #include <ascend/general/list.h>
@@ -162,12 +163,81 @@ void var_set_sindexF(struct var_variable *var, int32 sindex)
   var->sindex = sindex;
 }
 
+/*------------------------------------------------------------------------------
+  VALUE STORE
+*/
+
+int var_store_current(const struct var_store *s){
+  const unsigned long *w = RealAtomWriteCounter();
+  return s->writes == w && s->nwrites == *w;
+}
+
+void var_store_refresh(struct var_store *s){
+  struct var_variable *var;
+  int32 c;
+  for(c = 0; c < s->n; c++){
+    var = s->vars[c];
+    asc_assert(var->store == s && var->vindex == c);
+    /* read through to the ATOMs, not from the stale store */
+    var->store = NULL;
+    s->value[c] = var_value(var);
+    s->nominal[c] = var_nominal(var);
+    s->lower[c] = var_lower_bound(var);
+    s->upper[c] = var_upper_bound(var);
+    var->store = s;
+  }
+  s->writes = RealAtomWriteCounter();
+  s->nwrites = *(s->writes);
+}
+
+void var_store_reread(struct var_variable *var){
+  struct var_store *s = var->store;
+  if(s == NULL)return;
+  s->value[var->vindex] = RealAtomValue(var->ratom);
+  s->writes = RealAtomWriteCounter();
+  s->nwrites = *(s->writes);
+}
+
+/* the store of var, filled again first if an ATOM was written behind it */
+static struct var_store *var_store_sync(const struct var_variable *var){
+  if(!var_store_current(var->store)){
+    var_store_refresh(var->store);
+  }
+  return var->store;
+}
+
+/*
+	Write a real ATOM of var (itself or a child), and its copy in the store
+	if var has one. The ATOM write is counted, but it is one the store knows
+	about, so a store that was current before stays current.
+*/
+static void var_write_real(struct var_variable *var, struct Instance *atom
+		, real64 *copy, real64 value
+){
+  struct var_store *s = var->store;
+  int current = (s != NULL && var_store_current(s));
+  SetRealAtomValue(atom,value,(unsigned)0);
+  if(s != NULL){
+    copy[var->vindex] = value;
+    if(current){
+      s->nwrites = *(s->writes);
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------
+  VALUE AND REAL ATTRIBUTES
+*/
+
 real64 var_value(const struct var_variable *var)
 {
   if (var==NULL || var->ratom==NULL) {
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"bad var (%s)",(var==NULL?"null":"null ratom"));
     return 0.0;
   }
+  if(var->store!=NULL){
+    return var_store_sync(var)->value[var->vindex];
+  }
   return( RealAtomValue(var->ratom) );
 }
 
@@ -177,7 +247,9 @@ void var_set_value(struct var_variable *var, real64 value)
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"bad var");
     return;
   }
-  SetRealAtomValue(var->ratom,value,(unsigned)0);
+  var_write_real(var,IPTR(var->ratom)
+    ,(var->store!=NULL ? var->store->value : NULL),value
+  );
 }
 
 real64 var_nominal(struct var_variable *var)
@@ -187,6 +259,9 @@ real64 var_nominal(struct var_variable *var)
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"bad var");
     return 1.0;
   }
+  if(var->store!=NULL){
+    return var_store_sync(var)->nominal[var->vindex];
+  }
   c = ChildByChar(var->ratom,NOMINAL_V);
   if( c == NULL ) {
     FPRINTF(ASCERR,"no 'nominal' field in variable");
@@ -209,7 +284,7 @@ void var_set_nominal(struct var_variable *var, real64 nominal)
     /* WriteInstance(stderr,IPTR(var->ratom)); */
     return;
   }
-  SetRealAtomValue(c,nominal,(unsigned)0);
+  var_write_real(var,c,(var->store!=NULL ? var->store->nominal : NULL),nominal);
 }
 
 real64 var_lower_bound(struct var_variable *var)
@@ -219,6 +294,9 @@ real64 var_lower_bound(struct var_variable *var)
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"bad var");
     return 0.0;
   }
+  if(var->store!=NULL){
+    return var_store_sync(var)->lower[var->vindex];
+  }
   c = ChildByChar(IPTR(var->ratom),LOWER_V);
   if( c == NULL ) {
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"no 'lower_bound' field");
@@ -241,7 +319,7 @@ void var_set_lower_bound(struct var_variable *var, real64 lower_bound)
     /* WriteInstance(stderr,IPTR(var->ratom)); */
     return;
   }
-  SetRealAtomValue(c,lower_bound,(unsigned)0);
+  var_write_real(var,c,(var->store!=NULL ? var->store->lower : NULL),lower_bound);
 }
 
 real64 var_upper_bound(struct var_variable *var)
@@ -251,6 +329,9 @@ real64 var_upper_bound(struct var_variable *var)
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"bad var");
     return 0.0;
   }
+  if(var->store!=NULL){
+    return var_store_sync(var)->upper[var->vindex];
+  }
   c = ChildByChar(IPTR(var->ratom),UPPER_V);
   if( c == NULL ) {
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"no 'upper_bound' field");
@@ -273,7 +354,7 @@ void var_set_upper_bound(struct var_variable *var, real64 upper_bound)
     /* WriteInstance(stderr,IPTR(var->ratom)); */
     return;
   }
-  SetRealAtomValue(c,upper_bound,(unsigned)0);
+  var_write_real(var,c,(var->store!=NULL ? var->store->upper : NULL),upper_bound);
 }
 
 double var_odeatol(struct var_variable *var){
@@ -130,6 +130,37 @@
 	WHEN statement ?. This is for purposes of simplfying the
 	analysis of conditional models */
 
+/**
+	Contiguous copies of the real data of the variables of a system (the
+	master var list, then the parameters, then the unattached variables),
+	so that solvers read them from a few arrays rather than from ATOMs
+	scattered over the instance tree. Each variable knows its position in
+	the arrays (var_store_index). Owned by the slv_system_t; see
+	slv_var_store_gather() in slv_client.h.
+
+	While a variable is attached to a store (var_store(var) != NULL), the
+	arrays are what var_value, var_nominal and the bound getters return.
+	var_set_value, var_set_nominal and the bound setters write the array
+	and the ATOM both, since relations are evaluated from the ATOMs.
+
+	Any other write to a real ATOM (by a METHOD, the Python layer, the root
+	finder...) goes through SetRealAtomValue, which counts it. The store
+	notes that count when it is filled, and is filled again before it is
+	next read if the count has moved. The count is per thread: writes made
+	on another thread are picked up at the next slv_presolve() or
+	integrator_solve().
+*/
+struct var_store {
+  int32 n;           /**< length of each array */
+  real64 *value;     /**< variable values */
+  real64 *nominal;   /**< nominal values */
+  real64 *lower;     /**< lower bounds */
+  real64 *upper;     /**< upper bounds */
+  struct var_variable **vars;  /**< the variable at each position */
+  const unsigned long *writes; /**< RealAtomWriteCounter() when filled */
+  unsigned long nwrites;       /**< the count it held then */
+};
+
 /**
 	Variable structure.
 	Finally, we have a real structure so that we aren't hanging stuff
@@ -146,6 +177,8 @@ struct var_variable {
   int32 sindex;           /**< index in the solver clients list (often column index) */
   int32 mindex;           /**< index in the slv_system_t master list */
   uint32 flags;           /**< batch of binary flags. The bit positions are as above */
+  struct var_store *store; /**< value store of the owning system, or NULL */
+  int32 vindex;           /**< position in the arrays of store */
 };
 
 /** Variable filter structure */
@@ -194,6 +227,45 @@ extern void var_set_instanceF(struct var_variable *var, SlvBackendToken i);
 	function directly - use var_set_instance() instead.
 */
 
+#define var_store(var) ((var)->store)
+/**<
+	Returns the value store the variable is attached to, or NULL.
+	@param var  const struct var_variable *, the variable to query.
+*/
+
+#define var_store_index(var) ((var)->vindex)
+/**<
+	Returns the position of the variable in the arrays of its value store.
+	@param var  const struct var_variable *, the variable to query.
+*/
+
+#define var_set_store(var,s,k) ((var)->store = (s), (var)->vindex = (k))
+/**<
+	Attaches the variable to a value store at position k (or detaches it,
+	if s is NULL). Only slv_var_store_gather() and the system builder
+	should need this.
+*/
+
+ASC_DLLSPEC int var_store_current(const struct var_store *s);
+/**<
+	Returns nonzero if the store was filled on this thread and no real ATOM
+	has been written on this thread since, other than through the var_set_*
+	functions of variables attached to it.
+*/
+
+ASC_DLLSPEC void var_store_refresh(struct var_store *s);
+/**<
+	Fills the store again from the ATOMs of s->vars.
+*/
+
+ASC_DLLSPEC void var_store_reread(struct var_variable *var);
+/**<
+	Copies the value of the ATOM of var into its store, and marks the store
+	current. Only for code that has written that ATOM directly, and no other
+	real ATOM, since var_store_current() was last true, such as the root
+	finder called by relman_directly_solve_new().
+*/
+
 extern char *var_make_xname(const struct var_variable *var);
 /**<
 	Returns the index name, eg x23 rather than full name.
@@ -75,15 +75,33 @@
   GLOBALS AND FOWARD DECS
 */
 
-/* test buf for initialization */
-JMP_BUF g_fpe_env;
-JMP_BUF g_seg_env;
-JMP_BUF g_int_env;
+/* each thread has its own, see Asc_SignalJmpBuf */
+static ASC_THREAD_LOCAL JMP_BUF f_fpe_env;
+static ASC_THREAD_LOCAL JMP_BUF f_seg_env;
+static ASC_THREAD_LOCAL JMP_BUF f_int_env;
+
+/*
+	Set on the thread that called Asc_SignalInit, which owns the stacks
+	below. Pushes and pops from other threads are ignored.
+*/
+static ASC_THREAD_LOCAL int f_owner = 0;
 
 #ifdef HAVE_C99FPE
 fexcept_t g_fenv;
+/* the exceptions that would raise SIGFPE if they were trapped */
+# define FPE_EXCEPTS (FE_DIVBYZERO | FE_INVALID | FE_OVERFLOW)
 #endif
 
+/*
+	Off the owner thread nothing is trapped, so SIGFPE pushes and pops
+	follow the exception flags of fenv.h instead. f_fpe_ign says for each
+	level pushed whether it was SIG_IGN, and f_fpe_raised collects the
+	flags raised while a level that isn't was on top.
+*/
+static ASC_THREAD_LOCAL int f_fpe_depth = 0;
+static ASC_THREAD_LOCAL char f_fpe_ign[MAX_TRAP_DEPTH];
+static ASC_THREAD_LOCAL int f_fpe_raised = 0;
+
 /* for future use */
 jmp_buf g_foreign_code_call_env;
 
@@ -111,6 +129,9 @@ typedef struct{
 
 static SignalStacks *f_traps = NULL;
 
+/** stacks initialised, but by some other thread */
+#define NOT_OWNER (f_traps != NULL && !f_owner)
+
 #if 0
 static SigHandlerFn **f_fpe_traps = NULL;  /**< array for pushed SIGFPE handlers */
 static int f_fpe_top_of_stack = -1;     /**< top of SIGFPE stack, -1 for empty */
@@ -131,6 +152,9 @@ static void initstack(int sig);
 static int pop_trap(int signum, SigHandlerFn *tp, char *name, char *file, int line);
 static int push_trap(int signum, SigHandlerFn *func, char *name, char *file, int line);
 static void reset_trap(int signum);
+static void fpe_flag_collect(void);
+static int fpe_flag_push(SigHandlerFn *func);
+static void fpe_flag_pop(void);
 
 #ifdef HAVE_C99FPE
 static int fenv_pop(fenv_t *stack, int *top);
@@ -170,6 +194,7 @@ int Asc_SignalInit(void){
     f_traps->int_top = -1;
     f_traps->seg_top = -1;
   }
+  f_owner = 1;
 
 #ifdef HAVE_C99FPE
   if(f_fenv_stack==NULL){ /* if we haven't already initialised this... */
@@ -211,6 +236,7 @@ void Asc_SignalDestroy(void){
   }
 #endif
   f_traps = NULL;
+  f_owner = 0;
   MSG("Destroyed signal stack");
 }
 
@@ -226,6 +252,7 @@ void Asc_SignalDestroy(void){
 	our push/pop, theirs is liable to be forgotten.
 */
 void Asc_SignalRecover(int force){
+	if(NOT_OWNER)return;
 #ifndef ASC_RESETNEEDED
 	if(force){
 #endif
@@ -257,6 +284,10 @@ int Asc_SignalHandlerPush_impl(int signum, SigHandlerFn *func, char *name
   if (func == NULL) {
     return -2;
   }
+  if(NOT_OWNER){
+    /* other threads run with FP exceptions masked; see ascSignal.h */
+    return (signum == SIGFPE) ? fpe_flag_push(func) : 0;
+  }
 
   MSG("Pushing handler %s for signal %s(%d)",name,SIGNAME(signum),signum);
   err = push_trap(signum, func, name, file, line);
@@ -301,6 +332,10 @@ int Asc_SignalHandlerPop_impl(int signum, SigHandlerFn *tp, char *name
 	, char *file, int line
 ){
   int err;
+  if(NOT_OWNER){
+    if(signum == SIGFPE)fpe_flag_pop();
+    return 0;
+  }
   MSG("(%s:%d) Popping signal stack for signal %s (%d) (expecting top to be %p '%s')",file,line,SIGNAME(signum),signum,tp,name);
 
   err = pop_trap(signum, tp, name, file, line);
@@ -339,8 +374,33 @@ int Asc_SignalHandlerPop_impl(int signum, SigHandlerFn *tp, char *name
 #endif
 }
 
+JMP_BUF *Asc_SignalJmpBuf(int signum){
+  switch(signum){
+  case SIGSEGV: return &f_seg_env;
+  case SIGINT: return &f_int_env;
+  default: return &f_fpe_env;
+  }
+}
+
+void Asc_SignalFPECheck(void){
+  if(!NOT_OWNER)return;
+  fpe_flag_collect();
+  if(f_fpe_raised){
+    f_fpe_raised = 0;
+    ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Floating point error caught");
+    LONGJMP(g_fpe_env,SIGFPE);
+  }
+}
+
 void Asc_SignalTrap(int sigval){
   MSG("Caught signal #%d",sigval);
+  if(NOT_OWNER){
+    /* no setjmp was armed for us on this thread */
+    if(sigval != SIGINT){
+      (void)signal(sigval,SIG_DFL);
+    }
+    return;
+  }
   switch(sigval) {
   case SIGFPE:
     ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Floating point error caught");
@@ -612,6 +672,43 @@ static int pop_trap(int signum, SigHandlerFn *func, char *name, char *file, int
 	return err;
 }
 
+/*------------------------------------------
+  FPE FLAGS, OFF THE OWNER THREAD
+*/
+
+/* collect the flags raised under the top level, and clear them */
+static void fpe_flag_collect(void){
+#ifdef HAVE_C99FPE
+  int raised = fetestexcept(FPE_EXCEPTS);
+  if(raised){
+    if(f_fpe_depth > 0 && !f_fpe_ign[f_fpe_depth - 1]){
+      f_fpe_raised |= raised;
+    }
+    feclearexcept(raised);
+  }
+#endif
+}
+
+static int fpe_flag_push(SigHandlerFn *func){
+  if(f_fpe_depth >= MAX_TRAP_DEPTH){
+    ERROR_REPORTER_HERE(ASC_PROG_ERROR,"SIGFPE flag stack is full");
+    return 1;
+  }
+  fpe_flag_collect();
+  f_fpe_ign[f_fpe_depth++] = (func == SIG_IGN);
+  return 0;
+}
+
+static void fpe_flag_pop(void){
+  if(f_fpe_depth == 0)return;
+  fpe_flag_collect();
+  if(--f_fpe_depth == 0 && f_fpe_raised){
+    /* nobody asked with Asc_SignalFPECheck */
+    f_fpe_raised = 0;
+    ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Floating point error caught");
+  }
+}
+
 /*------------------------------------------
   FPE ENV STACK
 */
@@ -26,7 +26,7 @@
 	This module implements limited support for managing signal handlers.
 	This includes:
 	  - a standard signal handler - Asc_SignalTrap()
-	  - global jmp_buf's for use with Asc_SignalTrap()
+	  - per-thread jmp_buf's for use with Asc_SignalTrap()
 	  - functions for managing nested signal handlers
 
 	The following signal types are currently supported:
@@ -91,7 +91,20 @@
 	Once Asc_SignalInit() has been called, use of signal() directly is likely
 	to be lost or to corrupt the managed handlers.<br><br>
 
-	Another warning: setjmp is expensive if called inside a fast loop.
+	Another warning: setjmp is expensive if called inside a fast loop.<br><br>
+
+	Threads: the handler stacks belong to the thread that called
+	Asc_SignalInit() (normally the main thread). On any other thread,
+	floating point exceptions are left masked, as they are by default, so
+	that a calculation error shows up as an infinite or NaN result rather
+	than as a signal. There, Asc_SignalHandlerPush() and
+	Asc_SignalHandlerPop() install nothing, but for SIGFPE they follow the
+	exception flags of fenv.h: flags raised while a handler other than
+	SIG_IGN is on top are reported when it is popped, or earlier by
+	Asc_SignalFPECheck(), which then takes the same way out through
+	g_fpe_env as Asc_SignalTrap() would have. Each thread has its own
+	g_fpe_env, g_seg_env and g_int_env, so code that uses setjmp on them
+	may run on several threads at once.
 
 	Requires:
 	#include "utilities/ascConfig.h"
@@ -151,9 +164,16 @@ typedef void SigHandlerFn(int);
 #define MAX_TRAP_DEPTH 40L
 /**< The maximum number of traps that can be nested. */
 
-ASC_DLLSPEC JMP_BUF g_fpe_env;   /**< Standard signal jmp_buf - floating point error. */
-ASC_DLLSPEC JMP_BUF g_seg_env;   /**< Standard signal jmp_buf - segmentation fault. */
-ASC_DLLSPEC JMP_BUF g_int_env;   /**< Standard signal jmp_buf - interactive attention (<CTRL>C). */
+ASC_DLLSPEC JMP_BUF *Asc_SignalJmpBuf(int signum);
+/**<
+	The calling thread's jmp_buf for signal signum (SIGFPE, SIGSEGV or
+	SIGINT), as used by Asc_SignalTrap(). Normally used through the names
+	below.
+*/
+
+#define g_fpe_env (*Asc_SignalJmpBuf(SIGFPE))  /**< Standard signal jmp_buf - floating point error. */
+#define g_seg_env (*Asc_SignalJmpBuf(SIGSEGV)) /**< Standard signal jmp_buf - segmentation fault. */
+#define g_int_env (*Asc_SignalJmpBuf(SIGINT))  /**< Standard signal jmp_buf - interactive attention (<CTRL>C). */
 
 #if 0
 extern jmp_buf g_foreign_code_call_env;
@@ -170,8 +190,8 @@ ASC_DLLSPEC void Asc_SignalTrap(int sigval);
  *  This is the trap that should be used for most applications in
  *  ASCEND.  It prints a message then calls longjmp(GLOBAL, sigval)
  *  where GLOBAL is one of g_fpe_env, g_seg_env, or g_int_env.
- *  Because the jmp_buf is global, so you can't nest calls to
- *  setjmp where both use this trap function.<br><br>
+ *  Because the jmp_buf is global (to the thread), you can't nest calls
+ *  to setjmp where both use this trap function.<br><br>
  *
  *  Trivial Example:
  *  <pre>
@@ -191,6 +211,10 @@ ASC_DLLSPEC void Asc_SignalTrap(int sigval);
  *  to use instead of AscSignalTrap() if need be.  The signals
  *  SIGFPE, SIGINT, SIGSEGV are understood.<br><br>
  *
+ *  Should a signal reach a thread other than the one that called
+ *  Asc_SignalInit(), SIGINT is ignored there (it is for that thread to
+ *  deal with) and any other signal is given its default action.<br><br>
+ *
  *  Note - this handler does not reinstall itself.  After an exception,
  *  you need to reinstall the handler (if desired) using
  *  Asc_SignalRecover().
@@ -201,6 +225,25 @@ ASC_DLLSPEC void Asc_SignalTrap(int sigval);
  *                an exception.
  */
 
+ASC_DLLSPEC void Asc_SignalFPECheck(void);
+/**<
+ *  On a thread other than the one that called Asc_SignalInit(), where
+ *  floating point errors are not trapped, report any raised since
+ *  Asc_SignalTrap() was pushed for SIGFPE (or since the last check) and
+ *  longjmp to g_fpe_env with SIGFPE, as the trap would have done. Does
+ *  nothing on the thread that called Asc_SignalInit(), or if no such
+ *  errors were flagged. Call it where the trap is armed, after the
+ *  calculation:
+ *  <pre>
+ *     Asc_SignalHandlerPush(SIGFPE,Asc_SignalTrap);
+ *     if (setjmp(g_fpe_env)==0) {
+ *       y = f(x);
+ *       Asc_SignalFPECheck();
+ *     } else {
+ *       ...
+ *  </pre>
+ */
+
 ASC_DLLSPEC int Asc_SignalInit(void);
 /**<
  *  Initializes the signal manager.
@@ -25,9 +25,9 @@ static error_reporter_callback_t g_error_reporter_callback;
 
 /**
 	Global variable which holds cached error info for
-	later output
+	later output. Each thread caches its own.
 */
-static error_reporter_meta_t g_error_reporter_cache;
+static ASC_THREAD_LOCAL error_reporter_meta_t g_error_reporter_cache;
 
 #ifdef ERROR_REPORTER_TREE_ACTIVE
 static error_reporter_meta_t *error_reporter_meta_new(){
@@ -93,12 +93,13 @@ int error_reporter_default_callback(ERROR_REPORTER_CALLBACK_ARGS){
 #ifdef ERROR_REPORTER_TREE_ACTIVE
 
 
-/* TREE will be a pointer to the start of the top layer of the tree, or NULL */
-static error_reporter_tree_t *g_error_reporter_tree = NULL;
+/* TREE will be a pointer to the start of the top layer of the tree, or NULL.
+	Trees are started and ended on one thread, so each thread has its own. */
+static ASC_THREAD_LOCAL error_reporter_tree_t *g_error_reporter_tree = NULL;
 # define TREECURRENT g_error_reporter_tree_current
 
 /* TREECURRENT will be a pointer to the most recently added entry, or NULL if empty (in which case TREE will also be null */
-static error_reporter_tree_t *g_error_reporter_tree_current = NULL;
+static ASC_THREAD_LOCAL error_reporter_tree_t *g_error_reporter_tree_current = NULL;
 # define TREE g_error_reporter_tree
 
 /* output the cached errors in their nested order */
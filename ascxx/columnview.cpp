@@ -0,0 +1,137 @@
+#include "columnview.h"
+
+#include <algorithm>
+using namespace std;
+
+ViewGuard::ViewGuard() : nviews(0){
+	// nothing else
+}
+
+void
+ViewGuard::acquire(){
+	++nviews;
+}
+
+void
+ViewGuard::release(){
+	if(--nviews == 0){
+		retired.clear();
+	}
+}
+
+bool
+ViewGuard::viewed() const{
+	return nviews > 0;
+}
+
+void
+ViewGuard::detach(vector<double> &v){
+	if(nviews == 0)return;
+	retired.push_back(vector<double>());
+	retired.back().swap(v); /* the array itself doesn't move */
+}
+
+void
+ViewGuard::reserve(vector<double> &v, size_t n){
+	if(n <= v.capacity())return;
+	if(nviews == 0){
+		/* as push_back would */
+		v.reserve(max(n, 2 * v.capacity()));
+		return;
+	}
+	vector<double> w;
+	w.reserve(max(n, 2 * v.capacity()));
+	w.assign(v.begin(), v.end());
+	detach(v);
+	v.swap(w);
+}
+
+#ifdef ASCXX_USE_PYTHON
+
+/*------------------------------------------------------------------------------
+  PYTHON BUFFER EXPORTER
+*/
+
+namespace{
+
+struct ColumnView{
+	PyObject_HEAD
+	PyObject *owner;
+	ViewGuard *guard;
+	const double *buf;
+	Py_ssize_t n;
+	Py_ssize_t itemsize;
+};
+
+int columnview_getbuffer(PyObject *self, Py_buffer *view, int flags){
+	ColumnView *c = (ColumnView *)self;
+	if(flags & PyBUF_WRITABLE){
+		PyErr_SetString(PyExc_BufferError, "Column view is read-only");
+		view->obj = NULL;
+		return -1;
+	}
+	view->obj = self;
+	Py_INCREF(self);
+	view->buf = (void *)c->buf;
+	view->len = c->n * c->itemsize;
+	view->readonly = 1;
+	view->itemsize = c->itemsize;
+	view->format = (flags & PyBUF_FORMAT) ? (char *)"d" : NULL;
+	view->ndim = 1;
+	view->shape = (flags & PyBUF_ND) ? &(c->n) : NULL;
+	view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? &(c->itemsize) : NULL;
+	view->suboffsets = NULL;
+	view->internal = NULL;
+	return 0;
+}
+
+void columnview_dealloc(PyObject *self){
+	ColumnView *c = (ColumnView *)self;
+	/* the guard belongs to the owner, so release it first */
+	c->guard->release();
+	Py_DECREF(c->owner);
+	PyObject_Del(self);
+}
+
+PyBufferProcs columnview_as_buffer;
+PyTypeObject columnview_type;
+
+int columnview_ready(){
+	if(columnview_type.tp_name != NULL)return 0;
+	columnview_as_buffer.bf_getbuffer = &columnview_getbuffer;
+	columnview_type.tp_name = "ascpy.ColumnView";
+	columnview_type.tp_basicsize = sizeof(ColumnView);
+	columnview_type.tp_flags = Py_TPFLAGS_DEFAULT;
+	columnview_type.tp_doc = "Values of a column held by an Integrator or Ensemble";
+	columnview_type.tp_dealloc = &columnview_dealloc;
+	columnview_type.tp_as_buffer = &columnview_as_buffer;
+	if(PyType_Ready(&columnview_type) < 0){
+		columnview_type.tp_name = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+} // namespace
+
+PyObject *
+ascxx_column_view(PyObject *owner, ViewGuard &guard, const double *buf, Py_ssize_t n){
+	static const double empty = 0;
+	ColumnView *c;
+	PyObject *mv;
+	if(columnview_ready() < 0)return NULL;
+	c = PyObject_New(ColumnView, &columnview_type);
+	if(c == NULL)return NULL;
+	Py_INCREF(owner);
+	c->owner = owner;
+	c->guard = &guard;
+	guard.acquire();
+	c->buf = buf ? buf : &empty;
+	c->n = buf ? n : 0;
+	c->itemsize = sizeof(double);
+	mv = PyMemoryView_FromObject((PyObject *)c);
+	Py_DECREF(c);
+	return mv;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Read-only Python views of columns of doubles held by an ObservationStore
+	or an Ensemble, without copying.
+
+	A view holds a reference to the Python object that owns the column, so
+	the owner outlives it, and is counted in the owner's ViewGuard. While
+	any views exist, the owner does not change or free the arrays they may
+	refer to: an array that would be cleared, refilled or reallocated is
+	handed to the ViewGuard instead, and a new one used in its place. A
+	view therefore keeps the values it had when it was taken, and the old
+	arrays are freed once the last view is gone.
+*/
+#ifndef ASCXX_COLUMNVIEW_H
+#define ASCXX_COLUMNVIEW_H
+
+#include <list>
+#include <vector>
+#include <cstddef>
+
+#include "config.h"
+
+#ifdef ASCXX_USE_PYTHON
+# include <Python.h>
+#endif
+
+class ViewGuard{
+public:
+	ViewGuard();
+
+	void acquire();
+	void release();
+	bool viewed() const;
+
+	/** If there are views, keep the array of v until they are gone and
+		leave v empty; otherwise do nothing. Call before clearing, filling
+		or resizing v. */
+	void detach(std::vector<double> &v);
+
+	/** Make room in v for n values. If there are views, the values are
+		copied to a new, larger array and the old one kept, rather than
+		letting the vector reallocate under them. */
+	void reserve(std::vector<double> &v, std::size_t n);
+
+private:
+	unsigned long nviews;
+	std::list<std::vector<double> > retired;
+};
+
+#ifdef ASCXX_USE_PYTHON
+/**
+	Return a read-only memoryview (format 'd') of the n values at buf,
+	which belong to the Python object owner and are guarded by guard.
+	@return a new reference, or NULL with a Python exception set.
+*/
+PyObject *ascxx_column_view(PyObject *owner, ViewGuard &guard
+	, const double *buf, Py_ssize_t n);
+#endif
+
+#endif
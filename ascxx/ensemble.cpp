@@ -0,0 +1,380 @@
+#include "ensemble.h"
+#include "integrator.h"
+#include "integratorreporter.h"
+
+extern "C"{
+#include <ascend/general/threadpool.h>
+#include <ascend/utilities/error.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/qlfdid.h>
+#include <ascend/system/var.h>
+#include <ascend/system/slv_client.h>
+#include <ascend/solver/solver.h>
+}
+
+#include <stdexcept>
+#include <sstream>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+
+#ifndef __WIN32__
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/wait.h>
+#endif
+using namespace std;
+
+Ensemble::Ensemble(Simulation &sim)
+		: sim(sim), integrator(NULL), nprocs(0)
+{
+	// nothing else
+}
+
+Ensemble::~Ensemble(){
+	// nothing else
+}
+
+/**
+	Look up an instance by its name relative to the simulation model.
+*/
+struct Instance *
+Ensemble::findReal(const string &name) const{
+	struct Instance *oldrel = g_relative_inst;
+	int notfound;
+	g_relative_inst = sim.getModel().getInternalType();
+	notfound = Asc_QlfdidSearch3(name.c_str(),1);
+	g_relative_inst = oldrel;
+	if(notfound || g_search_inst == NULL){
+		stringstream ss;
+		ss << "Instance '" << name << "' not found";
+		throw runtime_error(ss.str());
+	}
+	switch(InstanceKind(g_search_inst)){
+		case REAL_INST:
+		case REAL_ATOM_INST:
+		case REAL_CONSTANT_INST:
+			return g_search_inst;
+		default:{
+			stringstream ss;
+			ss << "Instance '" << name << "' is not real-valued";
+			throw runtime_error(ss.str());
+		}
+	}
+}
+
+void
+Ensemble::addParameter(const string &name){
+	struct Instance *i = findReal(name);
+	if(InstanceKind(i) != REAL_ATOM_INST){
+		stringstream ss;
+		ss << "Parameter '" << name << "' must be a real variable";
+		throw runtime_error(ss.str());
+	}
+	if(!cases.empty()){
+		throw runtime_error("Parameters must be added before any cases");
+	}
+	params.push_back(i);
+}
+
+void
+Ensemble::addOutput(const string &name){
+	outputs.push_back(findReal(name));
+	views.detach(results);
+	results.clear();
+	status.clear();
+}
+
+int
+Ensemble::getNumParameters() const{
+	return params.size();
+}
+
+int
+Ensemble::getNumOutputs() const{
+	return outputs.size();
+}
+
+void
+Ensemble::addCase(const vector<double> &values){
+	if(values.size() != params.size()){
+		stringstream ss;
+		ss << "Case has " << values.size() << " values but there are "
+			<< params.size() << " parameters";
+		throw range_error(ss.str());
+	}
+	cases.insert(cases.end(), values.begin(), values.end());
+}
+
+void
+Ensemble::clearCases(){
+	cases.clear();
+	views.detach(results);
+	results.clear();
+	status.clear();
+}
+
+unsigned long
+Ensemble::getNumCases() const{
+	return params.empty() ? 0 : cases.size() / params.size();
+}
+
+void
+Ensemble::setNumProcesses(const int &n){
+	if(n < 0)throw range_error("Number of processes can't be negative");
+	nprocs = n;
+}
+
+int
+Ensemble::getNumProcesses() const{
+	return nprocs > 0 ? nprocs : threadpool_default_size();
+}
+
+//------------------------------------------------------------------------------
+// RUNNING THE CASES
+
+void
+Ensemble::solve(Solver solver){
+	sim.setSolver(solver);
+	integrator = NULL;
+	run();
+}
+
+void
+Ensemble::integrate(Integrator &integrator){
+	this->integrator = &integrator;
+	try{
+		run();
+	}catch(...){
+		this->integrator = NULL;
+		throw;
+	}
+	this->integrator = NULL;
+}
+
+/**
+	Record the values of all the solver's variables (which include any
+	fixed ones), and of the parameters, so that every case starts from the
+	same point.
+*/
+void
+Ensemble::saveBase(){
+	slv_system_t sys = sim.getSystem();
+	struct var_variable **vl = slv_get_master_var_list(sys);
+	int nv = slv_get_num_master_vars(sys);
+	base.resize(nv + params.size());
+	for(int k = 0; k < nv; ++k){
+		base[k] = var_value(vl[k]);
+	}
+	for(unsigned k = 0; k < params.size(); ++k){
+		base[nv + k] = RealAtomValue(params[k]);
+	}
+}
+
+void
+Ensemble::restoreBase(){
+	slv_system_t sys = sim.getSystem();
+	struct var_variable **vl = slv_get_master_var_list(sys);
+	int nv = slv_get_num_master_vars(sys);
+	for(int k = 0; k < nv; ++k){
+		var_set_value(vl[k], base[k]);
+	}
+	for(unsigned k = 0; k < params.size(); ++k){
+		SetRealAtomValue(params[k], base[nv + k], 0);
+	}
+}
+
+/**
+	Run case j from the base state, putting the values of the outputs in
+	out[0..noutputs-1].
+
+	@return an EnsembleStatus
+*/
+int
+Ensemble::runCase(unsigned long j, double *out){
+	const double *v = &cases[j * params.size()];
+	int res = ASCXX_ENSEMBLE_OK;
+
+	restoreBase();
+	for(unsigned k = 0; k < params.size(); ++k){
+		SetRealAtomValue(params[k], v[k], 0);
+	}
+
+	if(integrator == NULL){
+		slv_system_t sys = sim.getSystem();
+		slv_status_t s;
+		if(slv_presolve(sys)){
+			res = ASCXX_ENSEMBLE_FAILED;
+		}else{
+			slv_get_status(sys, &s);
+			while(s.ready_to_solve){
+				if(slv_iterate(sys))break;
+				slv_get_status(sys, &s);
+			}
+			slv_get_status(sys, &s);
+			if(!s.ok)res = ASCXX_ENSEMBLE_FAILED;
+		}
+	}else{
+		try{
+			integrator->solve();
+		}catch(runtime_error &e){
+			res = ASCXX_ENSEMBLE_FAILED;
+		}
+	}
+
+	for(unsigned i = 0; i < outputs.size(); ++i){
+		out[i] = (res == ASCXX_ENSEMBLE_OK)
+			? RealAtomValue(outputs[i]) : numeric_limits<double>::quiet_NaN();
+	}
+	return res;
+}
+
+/**
+	Worker k of n takes cases k, k+n, k+2n, ... Each worker process has
+	its own copy of the simulation, so they can all start from the same
+	base state. The results are written to a block shared by all the
+	processes: the output columns, then a status for each case.
+*/
+void
+Ensemble::run(){
+	unsigned long ncases = getNumCases();
+	unsigned long nout = outputs.size();
+	unsigned long n = getNumProcesses();
+	vector<double> row(nout + 1);
+
+	if(params.empty()){
+		throw runtime_error("Ensemble has no parameters");
+	}
+	if(n > ncases)n = ncases;
+
+	saveBase();
+	views.detach(results);
+	results.assign(nout * ncases, numeric_limits<double>::quiet_NaN());
+	status.assign(ncases, ASCXX_ENSEMBLE_NOT_RUN);
+
+#ifndef __WIN32__
+	if(n > 1){
+		size_t len = nout * ncases * sizeof(double) + ncases * sizeof(int);
+		void *shared = mmap(NULL, len, PROT_READ | PROT_WRITE
+			, MAP_SHARED | MAP_ANONYMOUS, -1, 0
+		);
+		if(shared == MAP_FAILED){
+			ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unable to share memory with"
+				" worker processes; running ensemble in this process");
+		}else{
+			double *sres = (double *)shared;
+			int *sstatus = (int *)(sres + nout * ncases);
+			vector<pid_t> pids;
+			for(unsigned long j = 0; j < ncases; ++j){
+				sstatus[j] = ASCXX_ENSEMBLE_NOT_RUN;
+			}
+
+			/* don't let the workers repeat anything still buffered */
+			fflush(NULL);
+			for(unsigned long k = 0; k < n; ++k){
+				pid_t pid = fork();
+				if(pid == 0){
+					if(integrator){
+						IntegratorReporterNull *r = new IntegratorReporterNull(integrator);
+						integrator->setObservationFile("");
+						integrator->setReporter(r);
+					}
+					try{
+						for(unsigned long j = k; j < ncases; j += n){
+							int res = runCase(j, &row[0]);
+							for(unsigned long i = 0; i < nout; ++i){
+								sres[i * ncases + j] = row[i];
+							}
+							sstatus[j] = res;
+						}
+					}catch(...){
+						fflush(NULL);
+						_exit(1);
+					}
+					fflush(NULL);
+					_exit(0);
+				}else if(pid < 0){
+					ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unable to start worker"
+						" process %lu",k);
+					break;
+				}
+				pids.push_back(pid);
+			}
+			for(unsigned k = 0; k < pids.size(); ++k){
+				int ws;
+				while(waitpid(pids[k], &ws, 0) < 0 && errno == EINTR);
+			}
+
+			/* take the results of the cases that workers finished */
+			for(unsigned long j = 0; j < ncases; ++j){
+				status[j] = sstatus[j];
+				if(status[j] == ASCXX_ENSEMBLE_NOT_RUN)continue;
+				for(unsigned long i = 0; i < nout; ++i){
+					results[i * ncases + j] = sres[i * ncases + j];
+				}
+			}
+			munmap(shared, len);
+			if(pids.size() == n)return;
+
+			/* some workers could not be started: do their cases here */
+			for(unsigned long j = 0; j < ncases; ++j){
+				if(j % n < pids.size())continue;
+				status[j] = runCase(j, &row[0]);
+				for(unsigned long i = 0; i < nout; ++i){
+					results[i * ncases + j] = row[i];
+				}
+			}
+			restoreBase();
+			return;
+		}
+	}
+#endif
+
+	for(unsigned long j = 0; j < ncases; ++j){
+		status[j] = runCase(j, &row[0]);
+		for(unsigned long i = 0; i < nout; ++i){
+			results[i * ncases + j] = row[i];
+		}
+	}
+	restoreBase();
+}
+
+//------------------------------------------------------------------------------
+// RESULTS
+
+int
+Ensemble::getStatus(const unsigned long &j) const{
+	if(j >= status.size())throw range_error("Invalid case number");
+	return status[j];
+}
+
+unsigned long
+Ensemble::getNumOK() const{
+	unsigned long n = 0;
+	for(unsigned long j = 0; j < status.size(); ++j){
+		if(status[j] == ASCXX_ENSEMBLE_OK)++n;
+	}
+	return n;
+}
+
+const double *
+Ensemble::getOutputColumn(const int &i) const{
+	if(i < 0 || (unsigned)i >= outputs.size()){
+		throw range_error("Invalid output number");
+	}
+	if(status.empty())return NULL;
+	return &results[i * status.size()];
+}
+
+ViewGuard &
+Ensemble::getViews() const{
+	return views;
+}
+
+vector<double>
+Ensemble::getOutputValues(const int &i) const{
+	const double *c = getOutputColumn(i);
+	return c ? vector<double>(c, c + status.size()) : vector<double>();
+}
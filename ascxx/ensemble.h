@@ -0,0 +1,129 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Ensembles of solves or integrations of one Simulation, for parameter
+	sweeps and Monte Carlo studies.
+
+	The model is instantiated and built once. Each 'case' of the ensemble
+	starts from the state of the Simulation when the run starts, overrides
+	the values of the chosen parameters, then solves (or integrates) and
+	records the values of the chosen outputs. The outputs are collected
+	into one contiguous column per output variable.
+
+	Since the compiler and solver are not thread-safe, the cases are shared
+	out over worker processes rather than threads: each worker is forked
+	from the current process, so it starts with a copy-on-write clone of
+	the instance tree, the built solver system and the compiled relations,
+	and writes its results into memory shared with the parent. Where fork
+	is not available (or with one process), the cases are run in turn in
+	the current process. Either way the Simulation is left in the state it
+	had before the run.
+
+	Worker processes must not call back into Python, so no SolverReporter
+	is used, and integrations in workers use an IntegratorReporterNull and
+	do not write observation files.
+*/
+#ifndef ASCXX_ENSEMBLE_H
+#define ASCXX_ENSEMBLE_H
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "columnview.h"
+#include "simulation.h"
+#include "solver.h"
+
+class Integrator;
+
+/** Status of each case after a run */
+enum EnsembleStatus{
+	ASCXX_ENSEMBLE_OK = 0, /**< converged (or integrated to the end time) */
+	ASCXX_ENSEMBLE_FAILED = 1, /**< solver or integrator failed */
+	ASCXX_ENSEMBLE_NOT_RUN = 2 /**< not attempted, or its worker process died */
+};
+
+class Ensemble{
+public:
+	Ensemble(Simulation &sim);
+	~Ensemble();
+
+	/** Add a real-valued parameter to override in each case, by its name
+		relative to the simulation's model, eg 'fl1.feed.T' or 'x[2]'.
+		Parameters are normally fixed variables; constants can't be used. */
+	void addParameter(const std::string &name);
+	/** Add a real-valued instance whose value is recorded for each case. */
+	void addOutput(const std::string &name);
+	int getNumParameters() const;
+	int getNumOutputs() const;
+
+	/** Add a case, giving one value for each parameter in the order added. */
+	void addCase(const std::vector<double> &values);
+	void clearCases();
+	unsigned long getNumCases() const;
+
+	/** Number of worker processes; 0 (the default) uses ASCEND_NUM_THREADS
+		or else the number of CPUs. */
+	void setNumProcesses(const int &n);
+	int getNumProcesses() const;
+
+	/** Solve each case for steady state with the given solver, using the
+		solver parameters currently set on the Simulation. */
+	void solve(Solver solver);
+
+	/** Integrate each case with the given Integrator, which must already
+		have been analysed and had its timesteps set. The outputs are the
+		values at the end of the integration. */
+	void integrate(Integrator &integrator);
+
+	/** Status of case j from the last run (see EnsembleStatus). */
+	int getStatus(const unsigned long &j) const;
+	/** Number of cases that succeeded in the last run. */
+	unsigned long getNumOK() const;
+
+	/** Values of output i over all the cases of the last run; entries for
+		cases that did not succeed are NaN. The pointer is invalidated by
+		the next run. */
+	const double *getOutputColumn(const int &i) const;
+	std::vector<double> getOutputValues(const int &i) const;
+
+	/** Count of the Python views of the output columns, which are kept
+		unchanged while they exist (see columnview.h). */
+	ViewGuard &getViews() const;
+
+private:
+	struct Instance *findReal(const std::string &name) const;
+	void run();
+	void saveBase();
+	void restoreBase();
+	int runCase(unsigned long j, double *out);
+
+	Simulation &sim;
+	Integrator *integrator; /**< NULL for steady-state runs */
+	int nprocs;
+
+	std::vector<struct Instance *> params;
+	std::vector<struct Instance *> outputs;
+	std::vector<double> cases; /**< nparams values for each case */
+
+	std::vector<double> base; /**< solver vars, then parameters, at start of run */
+
+	std::vector<double> results; /**< output columns, each ncases long */
+	std::vector<int> status;
+	mutable ViewGuard views;
+};
+
+#endif
@@ -128,10 +128,6 @@ Integrator::analyse(){
 */
 void
 Integrator::solve(){
-	// clear previous values and reserve space for new ones in order to avoid memory reallocation
-	obs.clear();
-	obs.reserve((unsigned long) getNumSteps());
-
 	// check the integration limits
 	// trigger of the solution process
 	// report errors?
@@ -145,8 +141,12 @@ Integrator::solve(){
 
 	assert(blsys->clientdata!=NULL);
 
+	// clear previous values and reserve space for new ones in order to avoid memory reallocation
+	obs.reset(getNumObservedVars(), (unsigned long) getNumSteps());
+
 	int res;
 	res = integrator_solve(blsys, 0, samplelist_length(samplelist)-1);
+	obs.flush();
 
 	if(res){
 		stringstream ss;
@@ -261,19 +261,21 @@ Integrator::setLogTimesteps(UnitsM units, double start, double end, unsigned lon
 
 vector<double>
 Integrator::getCurrentObservations(){
-	double *d = ASC_NEW_ARRAY(double,getNumObservedVars());
-	integrator_get_observations(blsys,d);
-	vector<double> v=vector<double>(d,d+getNumObservedVars());
-	// do I need to free d?
-	// can I do this in such a way as I avoid all this memory-copying?
+	vector<double> v(getNumObservedVars());
+	if(!v.empty()){
+		integrator_get_observations(blsys,&v[0]);
+	}
 	return v;
 }
 
+/**
+	Record the current observed values and time as a new row of the
+	observation store. Intended to be called from the write_obs method of
+	the reporter.
+*/
 void
 Integrator::saveObservations() {
-	std::vector<double> v = getCurrentObservations();
-	v.push_back(getCurrentTime());
-	obs.push_back(v);
+	obs.append(blsys);
 }
 
 Variable
@@ -326,6 +328,36 @@ Integrator::getInternalType(){
 	return blsys;
 }
 
+/**
+	Return the saved observations as a list of rows, each being the observed
+	values followed by the time. This copies all the data; use
+	getObservationStore (or getObservationColumn from Python) to avoid that.
+*/
 std::vector<std::vector<double> > Integrator::getObservations() {
+	if(obs.getNumRows() != obs.getNumRowsInMemory()){
+		stringstream ss;
+		ss << "Observations were written to '" << obs.getSpillFile() << "'";
+		throw runtime_error(ss.str());
+	}
+	return obs.getRows();
+}
+
+/**
+	Write observations to the binary file at path, instead of keeping them in
+	memory, in blocks of chunk rows. See observations.h for the format. An
+	empty path returns to keeping them in memory.
+*/
+void
+Integrator::setObservationFile(const std::string &path, unsigned long chunk){
+	obs.setSpillFile(path,chunk);
+}
+
+unsigned long
+Integrator::getNumObservations(){
+	return obs.getNumRows();
+}
+
+const ObservationStore &
+Integrator::getObservationStore() const{
 	return obs;
 }
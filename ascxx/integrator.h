@@ -41,6 +41,7 @@ const int IDA = INTEG_IDA;
 #include "units.h"
 #include "integratorreporter.h"
 #include "variable.h"
+#include "observations.h"
 
 class Integrator{
 	friend class IntegratorReporterCxx;
@@ -69,6 +70,9 @@ public:
 	std::vector<double> getCurrentObservations();
 	void saveObservations();
 	std::vector<std::vector<double> > getObservations();
+	void setObservationFile(const std::string &path, unsigned long chunk=65536);
+	unsigned long getNumObservations();
+	const ObservationStore &getObservationStore() const;
 	Variable getObservedVariable(const long &i);
 	Variable getIndependentVariable();
 
@@ -92,7 +96,7 @@ private:
 	Simulation &simulation;
 	SampleList *samplelist;
 	IntegratorSystem *blsys;
-	std::vector<std::vector<double> > obs;
+	ObservationStore obs;
 };
 
 #endif
@@ -129,12 +129,19 @@ IntegratorReporterCxx::updateStatus(){
 	return ERROR_REPORTER_NOLINE(ASC_USER_NOTE,"t = %f",t);
 }
 
+/**
+	Save the observed values into the Integrator's observation store. We're
+	called from C here, so errors are reported rather than thrown.
+*/
 int
 IntegratorReporterCxx::recordObservedValues(){
-	// CONSOLE_DEBUG("...");
-	double *data = ASC_NEW_ARRAY(double,integrator->getNumObservedVars());
-	integrator_get_observations(integrator->getInternalType(),data);
-	return 0;
+	try{
+		integrator->saveObservations();
+	}catch(runtime_error &e){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"%s",e.what());
+		return 0;
+	}
+	return 1;
 }
 
 Integrator *
@@ -0,0 +1,182 @@
+#include "observations.h"
+
+extern "C"{
+#include <ascend/system/var.h>
+}
+
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+using namespace std;
+
+ObservationStore::ObservationStore()
+		: nobs(0), nrows(0), spillchunk(0), spillfile(NULL)
+{
+	// nothing else
+}
+
+ObservationStore::~ObservationStore(){
+	if(spillfile){
+		fclose(spillfile);
+	}
+}
+
+void
+ObservationStore::setSpillFile(const string &path, unsigned long chunk){
+	if(!path.empty() && chunk==0){
+		throw range_error("Spill chunk size must be positive");
+	}
+	spillpath = path;
+	spillchunk = chunk;
+}
+
+const string &
+ObservationStore::getSpillFile() const{
+	return spillpath;
+}
+
+/**
+	Columns are reserved for the expected number of rows (capped at the
+	spill chunk, if spilling) so that append doesn't normally allocate.
+	Any capacity from a previous run is kept.
+*/
+void
+ObservationStore::reset(long nobs, unsigned long nexpected){
+	this->nobs = nobs;
+	nrows = 0;
+
+	if(spillfile){
+		fclose(spillfile);
+		spillfile = NULL;
+	}
+	if(!spillpath.empty()){
+		spillfile = fopen(spillpath.c_str(),"wb");
+		if(spillfile==NULL){
+			stringstream ss;
+			ss << "Unable to open observation file '" << spillpath << "': " << strerror(errno);
+			throw runtime_error(ss.str());
+		}
+		if(nexpected > spillchunk)nexpected = spillchunk;
+		spillrow.resize(spillchunk * (nobs + 1));
+	}
+
+	detach();
+	t.clear();
+	t.reserve(nexpected);
+	cols.resize(nobs);
+	for(long i=0; i<nobs; ++i){
+		cols[i].clear();
+		cols[i].reserve(nexpected);
+	}
+}
+
+void
+ObservationStore::append(IntegratorSystem *sys){
+	if(spillfile && t.size() >= spillchunk){
+		spill();
+	}
+	views.reserve(t, t.size() + 1);
+	t.push_back(integrator_get_t(sys));
+	for(long i=0; i<nobs; ++i){
+		views.reserve(cols[i], cols[i].size() + 1);
+		cols[i].push_back(var_value(sys->obs[i]));
+	}
+	++nrows;
+}
+
+void
+ObservationStore::flush(){
+	if(spillfile){
+		spill();
+		fflush(spillfile);
+	}
+}
+
+/**
+	Transpose the rows held in memory into spillrow and write them out.
+*/
+void
+ObservationStore::spill(){
+	unsigned long n = t.size();
+	if(n==0)return;
+	long w = nobs + 1;
+	for(unsigned long j=0; j<n; ++j){
+		spillrow[j*w] = t[j];
+	}
+	for(long i=0; i<nobs; ++i){
+		const double *c = &(cols[i][0]);
+		for(unsigned long j=0; j<n; ++j){
+			spillrow[j*w + i + 1] = c[j];
+		}
+	}
+	if(fwrite(&spillrow[0], sizeof(double) * w, n, spillfile) != n){
+		stringstream ss;
+		ss << "Failed to write observations to '" << spillpath << "'";
+		throw runtime_error(ss.str());
+	}
+	detach();
+	t.clear();
+	for(long i=0; i<nobs; ++i){
+		cols[i].clear();
+	}
+}
+
+/**
+	Before the columns are cleared: any that may be viewed from Python are
+	kept by the ViewGuard, and replaced by new ones with the same capacity.
+*/
+void
+ObservationStore::detach(){
+	if(!views.viewed())return;
+	unsigned long cap = t.capacity();
+	views.detach(t);
+	t.reserve(cap);
+	for(unsigned long i=0; i<cols.size(); ++i){
+		views.detach(cols[i]);
+		cols[i].reserve(cap);
+	}
+}
+
+long
+ObservationStore::getNumObservedVars() const{
+	return nobs;
+}
+
+unsigned long
+ObservationStore::getNumRows() const{
+	return nrows;
+}
+
+unsigned long
+ObservationStore::getNumRowsInMemory() const{
+	return t.size();
+}
+
+const double *
+ObservationStore::getColumn(long i) const{
+	if(i < -1 || i >= nobs){
+		throw range_error("Invalid observation column");
+	}
+	const vector<double> &c = (i == -1) ? t : cols[i];
+	return c.empty() ? NULL : &c[0];
+}
+
+ViewGuard &
+ObservationStore::getViews() const{
+	return views;
+}
+
+vector<vector<double> >
+ObservationStore::getRows() const{
+	unsigned long n = t.size();
+	vector<vector<double> > rows(n, vector<double>(nobs + 1));
+	for(unsigned long j=0; j<n; ++j){
+		vector<double> &r = rows[j];
+		for(long i=0; i<nobs; ++i){
+			r[i] = cols[i][j];
+		}
+		r[nobs] = t[j];
+	}
+	return rows;
+}
@@ -0,0 +1,107 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Columnar storage for the observations recorded during an integration.
+
+	Each observed variable, and the independent variable, has its own
+	contiguous array of values, one per recorded timestep. The arrays are
+	reserved for the expected number of samples before the integration
+	starts and grow geometrically if more rows than that arrive, so that
+	recording a row does not allocate. The arrays can be handed to Python
+	(as memoryviews, see columnview.h) without copying; while any such
+	views exist, arrays are replaced rather than changed in place.
+
+	For runs whose output does not fit in memory, the store can instead
+	'spill' to a binary file: the rows are kept in memory only until
+	'chunk' of them have accumulated, then appended to the file. The file
+	contains native-endian doubles in row-major order, each row being
+	(t, obs[0], ..., obs[nobs-1]), so that it can be read back with eg
+	numpy.fromfile(path).reshape(-1, nobs+1).
+*/
+#ifndef ASCXX_OBSERVATIONS_H
+#define ASCXX_OBSERVATIONS_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "config.h"
+#include "columnview.h"
+extern "C"{
+#include <ascend/integrator/integrator.h>
+}
+
+class ObservationStore{
+public:
+	ObservationStore();
+	~ObservationStore();
+
+	/** Discard all stored rows and prepare for a run with nobs observed
+		variables and about nexpected rows. If spilling is enabled, the
+		spill file is truncated. */
+	void reset(long nobs, unsigned long nexpected);
+
+	/** Record the current time and observed values of sys as a new row. */
+	void append(IntegratorSystem *sys);
+
+	/** Write any rows still held in memory to the spill file (no-op if
+		spilling is not enabled). */
+	void flush();
+
+	/** Enable spilling to the file at path, writing every chunk rows.
+		An empty path disables spilling. Takes effect at the next reset. */
+	void setSpillFile(const std::string &path, unsigned long chunk);
+	const std::string &getSpillFile() const;
+
+	long getNumObservedVars() const;
+
+	/** Total number of rows recorded since the last reset, including any
+		already written to the spill file. */
+	unsigned long getNumRows() const;
+
+	/** Number of rows currently held in memory. */
+	unsigned long getNumRowsInMemory() const;
+
+	/** Values of observed variable i held in memory; i == -1 gives the
+		times. The pointer is invalidated by the next append or reset. */
+	const double *getColumn(long i) const;
+
+	/** Copy of the rows held in memory, each being the observed values
+		followed by the time. */
+	std::vector<std::vector<double> > getRows() const;
+
+	/** Count of the Python views of the columns (taking a view does not
+		change the stored values). */
+	ViewGuard &getViews() const;
+
+private:
+	void spill();
+	void detach();
+
+	long nobs;
+	unsigned long nrows;
+	std::vector<double> t;
+	std::vector<std::vector<double> > cols;
+
+	std::string spillpath;
+	unsigned long spillchunk;
+	FILE *spillfile;
+	std::vector<double> spillrow;
+
+	mutable ViewGuard views;
+};
+
+#endif
@@ -36,6 +36,7 @@ extern "C"{
 #include <ascend/compiler/instance_io.h>
 #include <ascend/compiler/instantiate.h>
 #include <ascend/compiler/bintoken.h>
+#include <ascend/compiler/relprof.h>
 #include <ascend/compiler/instance_enum.h>
 #include <ascend/compiler/instquery.h>
 #include <ascend/compiler/check.h>
@@ -193,6 +194,52 @@ Simulation::write(const char *fname, const char *type) const{
 	throw runtime_error(ss.str());
 }
 
+//------------------------------------------------------------------------------
+// PROFILING
+
+/**
+	Switch the recording of relation evaluation counts and times on or off.
+	The profile is global: it also collects evaluations from any other
+	simulation solved while it is on.
+*/
+void
+Simulation::setProfiling(const bool &on){
+	relprof_enable(on);
+}
+
+void
+Simulation::resetProfile(){
+	relprof_reset();
+}
+
+/**
+	Write a table of the nmax most expensive statements, relations and
+	external functions in this simulation (all if nmax is 0).
+*/
+void
+Simulation::writeProfile(const char *fname, const unsigned long &nmax) const{
+	FILE *fp = fopen(fname, "w");
+	if(!fp){
+		throw runtime_error("Unable to open file for writing");
+	}
+	relprof_report(fp, simroot.getInternalType(), nmax);
+	fclose(fp);
+}
+
+/**
+	Write the profile of this simulation in 'folded stacks' format, as read
+	by flamegraph.pl.
+*/
+void
+Simulation::writeProfileFolded(const char *fname) const{
+	FILE *fp = fopen(fname, "w");
+	if(!fp){
+		throw runtime_error("Unable to open file for writing");
+	}
+	relprof_write_folded(fp, simroot.getInternalType());
+	fclose(fp);
+}
+
 //------------------------------------------------------------------------------
 // RUNNING MODEL 'METHODS'
 
@@ -601,9 +648,16 @@ Simulation::getSolver() const{
 */
 void
 Simulation::build(){
+	int solver = -1;
 	if(sys){
 		//CONSOLE_DEBUG("System is already built (%p)",sys);
-		return;
+		// pick up any fixing/freeing etc done since the last build
+		if(!system_update(sys))return;
+		MSG("Instance tree has changed; rebuilding system...");
+		// copies of this Simulation may still refer to the old system, so
+		// it is not destroyed here (see ~Simulation)
+		solver = slv_get_selected_solver(sys);
+		sys = NULL;
 	}else{
 		MSG("Building system...");
 	}
@@ -623,6 +677,9 @@ Simulation::build(){
 		throw runtime_error("Unable to build system");
 	}
 
+	if(solver >= 0){
+		slv_select_solver(sys, solver);
+	}
 	MSG("System built OK");
 }
 
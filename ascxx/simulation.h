@@ -69,6 +69,7 @@ class Simulation : public Instanc{
 	friend class SolverStatus;
 	friend class Integrator;
 	friend class System;
+	friend class Ensemble;
 private:
 	Instanc simroot;
 	slv_system_t sys;
@@ -120,6 +121,12 @@ public:
 
 	void write(const char *fname,const char *type=NULL) const;
 
+	/* per-relation evaluation profiling, see ascend/compiler/relprof.h */
+	void setProfiling(const bool &on);
+	void resetProfile();
+	void writeProfile(const char *fname, const unsigned long &nmax=30) const;
+	void writeProfileFolded(const char *fname) const;
+
 	void setSolver(Solver &s);
 	const Solver getSolver() const;
 
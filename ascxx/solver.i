@@ -20,6 +20,7 @@
 #include "solverhooks.h"
 #include "curve.h"
 #include "matrix.h"
+#include "columnview.h"
 %}
 
 %pythoncode{
@@ -297,11 +298,29 @@ public:
 %apply SWIGTYPE *DISOWN { IntegratorReporterCxx *reporter };
 
 %feature("autodoc", "Return dict of available integration engines {id:name,...}") Integrator::getEngines;
+%ignore Integrator::getObservationStore;
 %include "integrator.h"
 /* findIndependentVar has changed to return void, throw exception */
 
 %extend Integrator{
+	/* see getObservationColumn below; owner is the Integrator itself */
+	PyObject *_getObservationColumn(long i, PyObject *owner){
+		const ObservationStore &S = $self->getObservationStore();
+		return ascxx_column_view(owner, S.getViews(), S.getColumn(i)
+			, S.getNumRowsInMemory()
+		);
+	}
 	%pythoncode{
+		def getObservationColumn(self,i):
+			""" Read-only memoryview (format 'd') of the values of observed
+			variable i held in memory, without copying; i == -1 gives the
+			times. Use numpy.asarray on the result to get an array. The view
+			keeps the values it had when it was taken, even after the next
+			solve, and keeps the Integrator alive. """
+			return self._getObservationColumn(i,self)
+		def getObservationTimes(self):
+			""" memoryview of the times of the saved observations (see getObservationColumn) """
+			return self.getObservationColumn(-1)
 		def setParameter(self,name,value):
 			""" set the value of a parameter for this integrator """
 			P = self.getParameters()
@@ -318,6 +337,31 @@ public:
 }
 
 
+%ignore Ensemble::getOutputColumn(const int &) const;
+%include "ensemble.h"
+
+%extend Ensemble{
+	/* see getOutputColumn below; owner is the Ensemble itself */
+	PyObject *_getOutputColumn(int i, PyObject *owner){
+		const double *c = $self->getOutputColumn(i);
+		return ascxx_column_view(owner, $self->getViews(), c
+			, c ? $self->getNumCases() : 0
+		);
+	}
+	%pythoncode{
+		def getOutputColumn(self,i):
+			""" Read-only memoryview (format 'd') of the values of output i
+			over the cases of the last run, without copying. The view keeps
+			the values it had when it was taken, even after the next run,
+			and keeps the Ensemble alive. """
+			return self._getOutputColumn(i,self)
+		def addCases(self,cases):
+			""" add a case for each sequence of parameter values in cases """
+			for c in cases:
+				self.addCase([float(v) for v in c])
+	}
+}
+
 %feature("director") IntegratorReporterCxx;
 %ignore ascxx_integratorreporter_init;
 %ignore ascxx_integratorreporter_write;
@@ -239,6 +239,7 @@ int datareader_acdb_header(DataReader *d){
 	d->ndata = data_rows;
 	d->i = 0;
 	d->ndata=8760;
+	d->nmaxoutputs = 5;
 	d->data = ASC_NEW_ARRAY(AcdbPoint,d->ndata);
 
 	/* every line contains the city name, so rewind the file now */
@@ -36,6 +36,7 @@
 #include <ascend/compiler/instquery.h>
 #include <ascend/compiler/instmacro.h>
 #include <ascend/compiler/instance_types.h>
+#include <ascend/compiler/atomvalue.h>
 
 #include <ascend/compiler/extfunc.h>
 
@@ -52,10 +53,11 @@
   GLOBALS
 */
 
-static symchar *dr_symbols[3];
+static symchar *dr_symbols[4];
 #define FILENAME_SYM dr_symbols[0]
 #define FORMAT_SYM dr_symbols[1]
 #define PARAM_SYM dr_symbols[2]
+#define CACHE_SYM dr_symbols[3]
 
 /*------------------------------------------------------------------------------
   BINDINGS FOR THE DATA READER TO THE ASCEND EXTERNAL FUNCTIONS API
@@ -97,6 +99,9 @@ ASC_EXPORT int datareader_register(){
 		, 0.0
 	); /* returns 0 on success */
 
+	/* evaluation only reads the DataReader (see datareader_func) */
+	result += SetBlackBoxReentrant("datareader",1);
+
 	if(result){
 		ERROR_REPORTER_HERE(ASC_PROG_NOTE,"CreateUserFunction result = %d\n",result);
 	}
@@ -111,8 +116,8 @@ int asc_datareader_prepare(struct BBoxInterp *slv_interp,
 	   struct Instance *data,
 	   struct gl_list_t *arglist
 ){
-	struct Instance *fninst, *fmtinst, *parinst;
-	const char *fn, *fmt, *par;
+	struct Instance *fninst, *fmtinst, *parinst, *cacheinst;
+	const char *fn, *fmt, *par, *cachefn = NULL;
 	DataReader *d;
 	//char *partok = NULL; //token parser string for initialising datareader
 	int noutputs; //number of outputs as per the arg file
@@ -120,6 +125,7 @@ int asc_datareader_prepare(struct BBoxInterp *slv_interp,
 	dr_symbols[0] = AddSymbol("filename");
 	dr_symbols[1] = AddSymbol("format");
 	dr_symbols[2] = AddSymbol("parameters");
+	dr_symbols[3] = AddSymbol("cachefile");
 
 		/* get the data file name (we will look for this file in the ASCENDLIBRARY path) */
 	fninst = ChildByChar(data,FILENAME_SYM);
@@ -185,6 +191,23 @@ int asc_datareader_prepare(struct BBoxInterp *slv_interp,
 		return 1;
 	}
 
+	/* optional binary cache of the data file, for faster loading next time.
+	Ascend syntax is
+		cachefile :== 'weather.drcache';
+	where a relative path is taken relative to the current directory. */
+	cacheinst = ChildByChar(data,CACHE_SYM);
+	if(cacheinst){
+		if(InstanceKind(cacheinst)!=SYMBOL_CONSTANT_INST){
+			ERROR_REPORTER_HERE(ASC_USER_ERROR,"'cachefile' must be a symbol_constant");
+			return 1;
+		}
+		if(AtomAssigned(cacheinst)){
+			cachefn = SCP(SYMC_INST(cacheinst)->value);
+			if(cachefn!=NULL && strlen(cachefn)==0)cachefn = NULL;
+		}
+		MSG("CACHE FILE: %s",cachefn);
+	}
+
 	/* obtain number of outputs from the paramater statement */
 	/* this enables to create a datareader object with the right size parameter tokens */
     /*
@@ -213,6 +236,9 @@ int asc_datareader_prepare(struct BBoxInterp *slv_interp,
 			return 1;
 		}
 	}
+	if(cachefn!=NULL){
+		datareader_set_cache(d,cachefn);
+	}
 	//initialise datareader object
 	if(datareader_init(d)){
 		CONSOLE_DEBUG("Error initialising data reader");
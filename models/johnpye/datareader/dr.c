@@ -19,6 +19,7 @@
 #include <math.h>
 
 #include "dr.h"
+#include "drtable.h"
 #include "tmy2.h"
 #include "tmy3.h"
 #include "acdb.h"
@@ -85,10 +86,10 @@ DataReader *datareader_new(const char *fn, int noutputs) {
         d->cols[i] = i+1;
         d->interp_t[i] = default_interp;
     }
-    d->a0 = ASC_NEW_ARRAY(double,noutputs);
-    d->a1 = ASC_NEW_ARRAY(double,noutputs);
-    d->a2 = ASC_NEW_ARRAY(double,noutputs);
-    d->a3 = ASC_NEW_ARRAY(double,noutputs);
+    d->data = NULL;
+    d->tab = NULL;
+    d->format = NULL;
+    d->cachefn = NULL;
 
     d->datafn = NULL;
     d->headerfn = NULL;
@@ -254,6 +255,20 @@ int datareader_set_format(DataReader *d, const char *format) {
         return 1;
     }
 
+    d->format = format;
+    return 0;
+}
+
+/**
+	Set a binary cache file for the data. If the cache was made from the
+	data file as it is now, datareader_init loads the data from the cache
+	instead of parsing the data file; otherwise it parses the data file and
+	then (re)writes the cache. Must be called before datareader_init.
+	@see drtable.h
+	@return 0 on success
+*/
+int datareader_set_cache(DataReader *d, const char *cachefn){
+    d->cachefn = cachefn;
     return 0;
 }
 
@@ -353,6 +368,19 @@ int datareader_init(DataReader *d){
             return 1;
         }
     }
+    if(d->cachefn){
+        d->tab = drtable_load(d->cachefn, d->fp, d->format);
+        if(d->tab){
+            MSG("Loaded data from cache '%s'", d->cachefn);
+            d->ndata = d->tab->n;
+            d->nmaxoutputs = d->tab->ncols;
+            d->ninputs = 1;
+            d->freefn = NULL; /* no format-specific data was loaded */
+            d->i = 0;
+            return 0;
+        }
+    }
+
     MSG("About to open the data file");
     d->f = ospath_fopen(d->fp, "r");
     if(d->f == NULL){
@@ -386,10 +414,17 @@ int datareader_init(DataReader *d){
 
     d->i = 0; /* set current position to zero */
 
-    /*	these values are set to ensure that the polynomial coefficients
-    	are at least computed once*/
-    d->prev_i_val = -1;
-    d->prev_i_der = -1;
+    /* tabulate the data and work out the spline coefficients, once */
+    d->tab = drtable_from_reader(d);
+    if(d->tab == NULL){
+        return 1;
+    }
+
+    if(d->cachefn){
+        if(drtable_save(d->tab, d->cachefn, d->fp, d->format)){
+            ERROR_REPORTER_HERE(ASC_PROG_WARNING, "Unable to write data cache '%s'", d->cachefn);
+        }
+    }
     return 0;
 }
 
@@ -411,10 +446,7 @@ int datareader_free(DataReader *d){
     }
 	ASC_FREE(d->cols);
 	ASC_FREE(d->interp_t);
-	ASC_FREE(d->a0);
-	ASC_FREE(d->a1);
-	ASC_FREE(d->a2);
-	ASC_FREE(d->a3);
+	drtable_free(d->tab);
 
     ASC_FREE(d);
     return 0;
@@ -437,38 +469,12 @@ int datareader_num_outputs(const DataReader *d){
 }
 
 
-int datareader_locate(DataReader *d, double t, double *t1, double *t2){
-    (*d->indepfn)(d, t1);
-    if(*t1 > t && d->i > 0){
-        /* start of current interval is too late */
-        do{
-            --(d->i);
-            (*d->indepfn)(d, t1);
-            /*CONSOLE_DEBUG("STEPPING BACK (d->i = %d currently), t1=%lf",d->i, *t1); */
-        }while (*t1 > t && d->i > 0);
-    }
-    /* now either d->i==0 or t1 < t*/
-    /* CONSOLE_DEBUG("d->i==%d, t1=%lf",d->i,*t1); */
-    ++d->i;
-    (*d->indepfn)(d, t2);
-    if(*t2 <= t){
-        /* end of current interface is too early */
-        do {
-            /* CONSOLE_DEBUG("STEPPING FORWARD (d->i = %d currently), t1=%lf, t2=%lf",d->i,*t1,*t2); */
-            (*d->indepfn)(d, t1);
-            ++(d->i);
-            (*d->indepfn)(d, t2);
-        } while (*t2 < t && d->i < d->ndata);
-    }
-    MSG("d->i==%d, t1[0] = %lf, t2[0] = %lf", d->i, t1[0], t2[0]);
-
-    if(d->i == d->ndata || d->i == 0){
-        return 1;
-    }
-
-    /* CONSOLE_DEBUG("INTERVAL OK"); */
-    return 0;
-}
+/*
+	Interval found by the last lookup on this thread, where the next one
+	starts. It's only a guess, so all the data readers can share it, and
+	being per thread it leaves the reader itself read-only during evaluation.
+*/
+static ASC_THREAD_LOCAL int dr_hint = 0;
 
 /**
 	Return an interpolated set of output values for the given input values.
@@ -478,78 +484,36 @@ int datareader_locate(DataReader *d, double t, double *t1, double *t2){
 	caller, and indicated by the pointers 'inputs' and 'outputs'.
 
 	@see datareader_deriv
-	@TODO implement this
 */
 int datareader_func(DataReader *d, double *inputs, double *outputs) {
-#ifdef DR_DEBUG
-    boolean AtStart, AtEnd; //keep track of dataset ends, they affect constrained spline calculations
-#endif
-    int i,j;
-    double t1[1], t2[1];
-    double v0[d->nmaxoutputs], v1[d->nmaxoutputs], v2[d->nmaxoutputs], v3[d->nmaxoutputs];
-    /** this is a fixed size...
-    the maximum size determined by the format handler, which is included in the datareader struct.
-    @TODO the TmyDataPoint has the output variables declared as float, why?**/
-
+    int i,j,k;
     double t = inputs[0];
 
     MSG("EVALUATING AT t = %lf", inputs[0]);
 
-    asc_assert(d->indepfn);
+    asc_assert(d->tab);
 
-    if(datareader_locate(d, t, t1, t2)){
+    k = drtable_locate(d->tab, t, &dr_hint);
+    if(k < 0){
         MSG("LOCATION ERROR");
         ERROR_REPORTER_HERE(ASC_USER_ERROR, "Time value t=%f is out of range", t);
         return 1;
     }
-
-    MSG("LOCATED AT t1 = %lf, t2 = %lf", t1[0], t2[0]);
-    if(d->i < d->ndata-1){
-        ++d->i; //go one step forward
-        (*d->valfn)(d, v3); //take a data sample at t1+2
-        --d->i; //go back one step
-#ifdef DR_DEBUG
-        AtEnd = FALSE; //index is not at the end of the dataset
-#endif
-    }
-#ifdef DR_DEBUG
-    else
-	AtEnd = TRUE;
-#endif
-
-    (*d->valfn)(d, v2);
-    --d->i;
-    (*d->valfn)(d, v1);
-
-    if(d->i > 0){
-        --d->i; //go one step backward
-        (*d->valfn)(d, v0); //take a data sample at t1-1
-        ++d->i; //should be positioned at v1 t1
-#ifdef DR_DEBUG
-        AtStart = FALSE;
-#endif
-    }
-#ifdef DR_DEBUG
-    else 
-		AtStart = TRUE;
-#endif
-
-    MSG("LOCATED OK, d->i = %d, t1 = %lf, t2 = %lf, v1=%lf, v2=%lf", d->i, t1[0], t2[0], v1[0], v2[0]);
+    MSG("LOCATED AT k = %d, t1 = %lf, t2 = %lf", k, d->tab->t[k], d->tab->t[k+1]);
 
     for(i = 0;i < d->noutputs;++i){
         j = d->cols[i]-1;
         switch(d->interp_t[i]){
         case linear:
-            outputs[i] = dr_linearinterp(t,t1,t2,v1[j],v2[j]);
+            outputs[i] = drtable_linear(d->tab,j,k,t);
             break;
         case default_interp:
         case sun:  //to be implemented as a refinement of the cubic spline
         case cubic:
-            outputs[i] = dr_cubicinterp(d,i,t,t1,t2,v0[j],v1[j],v2[j],v3[j]);
-
+            outputs[i] = drtable_cubic(d->tab,j,k,t);
             break;
         }
-        MSG("[%d]: START = %lf, END = %lf, VALUE=%lf", i, v1[j],v2[j], outputs[i]);
+        MSG("[%d]: VALUE=%lf", i, outputs[i]);
     }
 
     return 0;
@@ -561,193 +525,35 @@ int datareader_func(DataReader *d, double *inputs, double *outputs) {
 	values. These can be smooth if the cubic interpolation method is selected.
 */
 int datareader_deriv(DataReader *d, double *inputs, double *jacobian) {
-#ifdef DR_DEBUG
-    boolean AtStart, AtEnd; //keep track of dataset ends, they affect constrained spline calculations
-#endif
-    int i,j;
-    double t1[1], t2[1];
-    double v0[d->nmaxoutputs], v1[d->nmaxoutputs], v2[d->nmaxoutputs], v3[d->nmaxoutputs];
-    /** this is a fixed size...
-    the maximum size determined by the format handler, which is included in the datareader struct.
-    @TODO the TmyDataPoint has the output variables declared as float, why?**/
-
+    int i,j,k;
     double t = inputs[0];
 
     MSG("EVALUATING AT t = %lf", inputs[0]);
 
-    asc_assert(d->indepfn);
+    asc_assert(d->tab);
 
-    if(datareader_locate(d, t, t1, t2)){
+    k = drtable_locate(d->tab, t, &dr_hint);
+    if(k < 0){
         MSG("LOCATION ERROR");
         ERROR_REPORTER_HERE(ASC_USER_ERROR, "Time value t=%f is out of range", t);
         return 1;
     }
 
-    MSG("LOCATED AT t1 = %lf, t2 = %lf", t1[0], t2[0]);
-    if(d->i < d->ndata-1){
-        ++d->i; //go one step forward
-        (*d->valfn)(d, v3); //take a data sample at t1+2
-        --d->i; //go back one step
-#ifdef DR_DEBUG
-        AtEnd = FALSE; //index is not at the end of the dataset
-#endif
-    }
-#ifdef DR_DEBUG
-    else AtEnd = TRUE;
-#endif
-
-    (*d->valfn)(d, v2);
-    --d->i;
-    (*d->valfn)(d, v1);
-
-    if(d->i > 0){
-        --d->i; //go one step backward
-        (*d->valfn)(d, v0); //take a data sample at t1-1
-        ++d->i; //should be positioned at v1 t1
-#ifdef DR_DEBUG
-        AtStart = FALSE;
-#endif
-    }
-#ifdef DR_DEBUG
-    else AtStart = TRUE;
-#endif
-
-    MSG("LOCATED OK, d->i = %d, t1 = %lf, t2 = %lf, v1=%lf, v2=%lf", d->i, t1[0], t2[0], v1[0], v2[0]);
-
     for(i = 0;i < d->noutputs;++i){
         j = d->cols[i]-1;
         switch (d->interp_t[i]) {
         case linear:
-            jacobian[i] = dr_linearderiv(t,t1,t2,v1[j],v2[j]);
+            jacobian[i] = drtable_linear_deriv(d->tab,j,k,t);
             break;
         case default_interp:
         case sun:  //to be implemented as a refinement of the cubic spline
         case cubic:
-            jacobian[i] = dr_cubicderiv(d,i,t,t1,t2,v0[j],v1[j],v2[j],v3[j]);
+            jacobian[i] = drtable_cubic_deriv(d->tab,j,k,t);
             break;
         }
-        MSG("[%d]: START = %lf, VALUE=%lf", i, v1[j], jacobian[i]);
+        MSG("[%d]: VALUE=%lf", i, jacobian[i]);
     }
 
     return 0;
 }
 
-
-double dr_linearinterp(double t, double *t1, double *t2, double v1, double v2) {
-    double g, dt;
-    dt = (*t2)-(*t1);
-    g = (v2 - v1) / dt;
-    return v1 + g * (t - (*t1));
-}
-
-
-double dr_cubicinterp(DataReader *d, int j, double t, double *t1, double *t2, double v0, double v1, double v2, double v3) {
-    //constrained cubic spline by CJC Kruger http://www.korf.co.uk
-    boolean AtStart, AtEnd;
-    double dt;
-    double k0,k1,k2,k3; //gradients for cubic spline interpolation
-    double a0,a1,a2,a3;//polynomial coefficients for second spline segment
-    dt = t2[0] - t1[0];
-
-    if(d->i != d->prev_i_val){
-        /*if we are at a new interval, still wait for all coefficients to be
-          calculated before updating prev_i_val index */
-        if (j == d->noutputs-1) d->prev_i_val = d->i;
-
-        if (d->i < d->ndata-1) AtEnd = FALSE; //index is not at the end of the dataset
-        else AtEnd = TRUE; //index is at the end of the dataset
-        if (d->i > 0) AtStart = FALSE; //index is not at the beggining of the dataset
-        else AtStart = TRUE; //index is at the begginintg of the dataset
-
-        if((dt/(v3-v2)+dt/(v2-v1))==0 || (v3-v2)*(v2-v1)<0) k2 = 0;
-        else{
-            if (AtEnd) k2 = 3*(v2-v1)/2-1/(dt/(v2-v1)+dt/(v1-v0));
-            else k2 = 2/(dt/(v3-v2)+dt/(v2-v1));
-        }
-        if((dt/(v2-v1)+dt/(v1-v0))==0 || (v2-v1)*(v1-v0)<0) k1 = 0;
-        else {
-            if (AtStart) k1 = 3*(v2-v1)/2 - k2/2;
-            else k1 = 2/(dt/(v2-v1)+dt/(v1-v0));
-        }
-        k0 = -2*(k2+2*k1)/dt+6*(v2-v1)/pow(dt,2); //used as second derivative at t1
-        k3 = 2*(2*k2+k1)/dt-6*(v2-v1)/pow(dt,2); //used as second derivative at t2
-
-        //calculate polynomial coefficients
-        a3 = (k3-k0)/(6*dt);
-        a2 = (t2[0]*k0-t1[0]*k3)/(2*dt);
-        a1 = ((v2-v1)-a2*(pow(t2[0],2)-pow(t1[0],2))-a3*(pow(t2[0],3)-pow(t1[0],3)))/dt;
-        a0 = v1-a1*t1[0]-a2*pow(t1[0],2)-a3*pow(t1[0],3);
-
-        //store coefficients in the datareader structure
-        d->a0[j] = a0;
-        d->a1[j] = a1;
-        d->a2[j] = a2;
-        d->a3[j] = a3;
-#ifdef DR_DEBUG
-        if (j == 1 )MSG("Cubic spline coefficients recalculated");
-#endif
-    }
-    //calculate output value
-    MSG("v[%d]:%lf",j,d->a0[j] + d->a1[j]*t + d->a2[j]*pow(t,2) + d->a3[j]*pow(t,3));
-    return d->a0[j] + d->a1[j]*t + d->a2[j]*pow(t,2) + d->a3[j]*pow(t,3);
-}
-
-
-double dr_linearderiv(double t, double *t1, double *t2, double v1, double v2) {
-    return (v2 - v1) / ((*t2)-(*t1));
-}
-
-
-double dr_cubicderiv(DataReader *d, int j, double t, double *t1, double *t2, double v0, double v1, double v2, double v3) {
-    //constrained cubic spline by CJC Kruger http://www.korf.co.uk
-    boolean AtStart, AtEnd;
-    double dt;
-    double k0,k1,k2,k3; //gradients for cubic spline interpolation
-    double a0,a1,a2,a3;//polynomial coefficients for second spline segment
-    dt = t2[0] - t1[0];
-
-    if (d->i != d->prev_i_der) {
-		// FIXME TODO XXX find a way to avoid duplicated code here cf. in dr_cubicinterp
-
-        /*if we are at a new interval, still wait for all coefficients to be
-          calculated before updating prev_i_val index */
-        if (j == d->noutputs-1) d->prev_i_der = d->i;
-
-        if (d->i < d->ndata-1) AtEnd = FALSE; //index is not at the end of the dataset
-        else AtEnd = TRUE; //index is at the end of the dataset
-        if (d->i > 0) AtStart = FALSE; //index is not at the beggining of the dataset
-        else AtStart = TRUE; //index is at the begginintg of the dataset
-
-        if ((dt/(v3-v2)+dt/(v2-v1))==0 || (v3-v2)*(v2-v1)<0) k2 = 0;
-        else {
-            if (AtEnd) k2 = 3*(v2-v1)/2-1/(dt/(v2-v1)+dt/(v1-v0));
-            else k2 = 2/(dt/(v3-v2)+dt/(v2-v1));
-        }
-        if ((dt/(v2-v1)+dt/(v1-v0))==0 || (v2-v1)*(v1-v0)<0) k1 = 0;
-        else {
-            if (AtStart) k1 = 3*(v2-v1)/2 - k2/2;
-            else k1 = 2/(dt/(v2-v1)+dt/(v1-v0));
-        }
-        k0 = -2*(k2+2*k1)/dt+6*(v2-v1)/pow(dt,2); //used as second derivative at t1
-        k3 = 2*(2*k2+k1)/dt-6*(v2-v1)/pow(dt,2); //used as second derivative at t2
-
-        //calculate polynomial coefficients
-        a3 = (k3-k0)/(6*dt);
-        a2 = (t2[0]*k0-t1[0]*k3)/(2*dt);
-        a1 = ((v2-v1)-a2*(pow(t2[0],2)-pow(t1[0],2))-a3*(pow(t2[0],3)-pow(t1[0],3)))/dt;
-        a0 = v1-a1*t1[0]-a2*pow(t1[0],2)-a3*pow(t1[0],3);
-
-        //store coefficients in the datareader structure
-        d->a0[j] = a0;
-        d->a1[j] = a1;
-        d->a2[j] = a2;
-        d->a3[j] = a3;
-#ifdef DR_DEBUG
-        if (j == 1 )MSG("Cubic spline derivatives recalculated");
-#endif
-    }
-    //calculate output value
-    return d->a1[j] + 2*d->a2[j]*t + 3*d->a3[j]*pow(t,2);
-}
-
-
@@ -35,10 +35,14 @@
 struct DataReader_struct;
 typedef struct DataReader_struct DataReader;
 
+struct DataReaderTable_struct;
+typedef struct DataReaderTable_struct DataReaderTable;
+
 DataReader *datareader_new(const char *fn, int noutputs);
 int datareader_init(DataReader *d);
 int datareader_set_parameters(DataReader *d, char *parameters);
 int datareader_set_format(DataReader *d, const char *format);
+int datareader_set_cache(DataReader *d, const char *cachefn);
 int datareader_free(DataReader *d);
 
 int datareader_num_inputs(const DataReader *d);
@@ -47,10 +51,6 @@ int datareader_num_outputs(const DataReader *d);
 int datareader_func(DataReader *d, double *inputs, double *outputs);
 int datareader_deriv(DataReader *d, double *inputs, double *jacobian);
 
-double dr_linearinterp(double t, double *t1, double *t2, double v1, double v2);
-double dr_cubicinterp(DataReader *d, int j, double t, double *t1, double *t2, double v0, double v1, double v2, double v3);
-double dr_linearderiv(double t, double *t1, double *t2, double v1, double v2);
-double dr_cubicderiv(DataReader *d, int j, double t, double *t1, double *t2, double v0, double v1, double v2, double v3);
 /**
 	Function that can read a single data point from the open file.
 	Should return 0 on success.
@@ -147,16 +147,12 @@ struct DataReader_struct{
 	int nmaxoutputs;//maximum number of columns, as per format settings.
 	int ndata; /** number of data points in the raw data */
 	int i; /** 'current location' in the data array */
-	int prev_i_val; //previous location of the data array. For cubic interp value function
-	int prev_i_der; //previous location of the data array. For cubic interp deriv function
 	void *data; /**< stored data (form depends on what what loaded) */
-	//void *grad; /** stored gradients, for each data point a cubic spline gradient is calculated**/
+	DataReaderTable *tab; /**< sample times, values and spline coefficients, see drtable.h */
+	const char *format; /**< format name, as given to datareader_set_format */
+	const char *cachefn; /**< binary cache file for tab, or NULL for none */
 	int *cols; //columns required, as declared in parameter file
 	interp_t *interp_t; //interpolation types, as tokenised
-	double *a0; //cubic spline coefficient a0 array for all outputs;
-	double *a1; //cubic spline coefficient a0 array for all outputs;
-	double *a2; //cubic spline coefficient a0 array for all outputs;
-	double *a3; //cubic spline coefficient a0 array for all outputs;
 	DataReaderHeaderFn *headerfn;
 	DataReaderDataFn *datafn;
 	DataReaderEofFn *eoffn;
@@ -0,0 +1,430 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Columnar sample table and binary cache for the Data Reader.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#ifndef __WIN32__
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include "drtable.h"
+
+#include <ascend/general/ospath.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/utilities/error.h>
+
+//#define DRTABLE_DEBUG
+#ifdef DRTABLE_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+/*------------------------------------------------------------------------------
+  BUILDING THE TABLE
+*/
+
+/* number of doubles in the block holding t, v and c */
+static size_t drtable_ndoubles(int n, int ncols){
+	return (size_t)n + (size_t)ncols * n + (size_t)ncols * (n - 1) * 4;
+}
+
+/* point t, v and c into the block starting at p */
+static void drtable_setup(DataReaderTable *tab, const double *p){
+	tab->t = p;
+	tab->v = p + tab->n;
+	tab->c = p + tab->n + (size_t)tab->ncols * tab->n;
+}
+
+/* sample spacing if the sample times are uniform (to rounding), else 0 */
+static double drtable_uniform(const double *t, int n){
+	int k;
+	double dt = (t[n-1] - t[0]) / (n - 1);
+	for(k = 0; k < n - 1; ++k){
+		if(fabs(t[k+1] - t[k] - dt) > 1e-9 * dt)return 0;
+	}
+	return dt;
+}
+
+/**
+	Coefficients of the constrained cubic spline through (t[k], v[k]), as
+		v = c[4k] + c[4k+1] s + c[4k+2] s^2 + c[4k+3] s^3,  s = t - t[k]
+	on each interval k. The slope at an interior sample is the harmonic mean
+	of the slopes of the intervals either side, or zero where they differ in
+	sign, so the curve doesn't overshoot the data. The slopes at the ends
+	are chosen to give zero second derivative there.
+*/
+static void drtable_spline(const double *t, const double *v, int n, double *c){
+	int k;
+	double h, s0, s1, m0, m1;
+
+	/* node slopes, stored temporarily in c[4k+1] (and c[4(n-2)+2] for the last) */
+	for(k = 1; k < n - 1; ++k){
+		s0 = (v[k] - v[k-1]) / (t[k] - t[k-1]);
+		s1 = (v[k+1] - v[k]) / (t[k+1] - t[k]);
+		c[4*k+1] = (s0 * s1 <= 0) ? 0 : 2 / (1/s0 + 1/s1);
+	}
+	s0 = (v[1] - v[0]) / (t[1] - t[0]);
+	s1 = (v[n-1] - v[n-2]) / (t[n-1] - t[n-2]);
+	if(n == 2){
+		c[1] = s0;
+		c[2] = s0;
+	}else{
+		c[1] = 1.5 * s0 - 0.5 * c[5];
+		c[4*(n-2)+2] = 1.5 * s1 - 0.5 * c[4*(n-2)+1];
+	}
+
+	for(k = 0; k < n - 1; ++k){
+		h = t[k+1] - t[k];
+		s0 = (v[k+1] - v[k]) / h;
+		m0 = c[4*k+1];
+		m1 = (k == n - 2) ? c[4*k+2] : c[4*(k+1)+1];
+		c[4*k] = v[k];
+		c[4*k+2] = (3 * s0 - 2 * m0 - m1) / h;
+		c[4*k+3] = (m0 + m1 - 2 * s0) / (h * h);
+	}
+}
+
+typedef struct{
+	double t;
+	int i;
+} DrTableOrder;
+
+static int drtable_order_cmp(const void *a, const void *b){
+	const DrTableOrder *A = (const DrTableOrder *)a, *B = (const DrTableOrder *)b;
+	if(A->t < B->t)return -1;
+	if(A->t > B->t)return 1;
+	return A->i - B->i;
+}
+
+DataReaderTable *drtable_from_reader(DataReader *d){
+	DataReaderTable *tab;
+	DrTableOrder *ord;
+	double *rows, *p, *t, *v;
+	int n = d->ndata, ncols = d->nmaxoutputs, i, j, m, sorted = 1, save_i = d->i;
+
+	if(n < 2 || ncols < 1){
+		ERROR_REPORTER_HERE(ASC_USER_ERROR,"Data file '%s' contains too few"
+			" data points (%d) or columns (%d) for interpolation",d->fn,n,ncols
+		);
+		return NULL;
+	}
+
+	/* fetch all the data points from the format handler */
+	ord = ASC_NEW_ARRAY(DrTableOrder, n);
+	rows = ASC_NEW_ARRAY(double, (size_t)n * ncols);
+	for(i = 0; i < n; ++i){
+		d->i = i;
+		ord[i].i = i;
+		if((*d->indepfn)(d, &ord[i].t) || (*d->valfn)(d, rows + (size_t)i * ncols)){
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to read data point %d from '%s'",i,d->fn);
+			d->i = save_i;
+			ASC_FREE(ord);
+			ASC_FREE(rows);
+			return NULL;
+		}
+		if(i > 0 && !(ord[i].t > ord[i-1].t))sorted = 0;
+	}
+	d->i = save_i;
+
+	/* some data files (eg typical years spliced from different years) are
+	not quite in order: sort them, keeping the first of any repeated times */
+	if(!sorted){
+		ERROR_REPORTER_HERE(ASC_USER_WARNING,"Data in '%s' is not in order of"
+			" increasing time. It will be sorted, and points at repeated times"
+			" ignored.",d->fn
+		);
+		qsort(ord, n, sizeof(DrTableOrder), &drtable_order_cmp);
+		for(i = 1, m = 1; i < n; ++i){
+			if(ord[i].t > ord[m-1].t)ord[m++] = ord[i];
+		}
+		n = m;
+		if(n < 2){
+			ERROR_REPORTER_HERE(ASC_USER_ERROR,"Data file '%s' contains too few"
+				" distinct times for interpolation",d->fn
+			);
+			ASC_FREE(ord);
+			ASC_FREE(rows);
+			return NULL;
+		}
+	}
+
+	tab = ASC_NEW(DataReaderTable);
+	tab->n = n;
+	tab->ncols = ncols;
+	tab->memsize = drtable_ndoubles(n, ncols) * sizeof(double);
+	tab->mem = ASC_NEW_ARRAY(double, drtable_ndoubles(n, ncols));
+	tab->mapped = 0;
+	p = (double *)tab->mem;
+	drtable_setup(tab, p);
+	t = p;
+	v = p + n;
+
+	for(i = 0; i < n; ++i){
+		t[i] = ord[i].t;
+		for(j = 0; j < ncols; ++j){
+			v[(size_t)j * n + i] = rows[(size_t)ord[i].i * ncols + j];
+		}
+	}
+	ASC_FREE(ord);
+	ASC_FREE(rows);
+
+	for(j = 0; j < ncols; ++j){
+		drtable_spline(t, v + (size_t)j * n, n, p + n + (size_t)ncols * n + (size_t)j * (n - 1) * 4);
+	}
+	tab->dt = drtable_uniform(t, n);
+	MSG("Tabulated %d points x %d columns, dt = %f",n,ncols,tab->dt);
+	return tab;
+}
+
+void drtable_free(DataReaderTable *tab){
+	if(tab == NULL)return;
+#ifndef __WIN32__
+	if(tab->mapped){
+		munmap(tab->mem, tab->memsize);
+	}else
+#endif
+	{
+		ASC_FREE(tab->mem);
+	}
+	ASC_FREE(tab);
+}
+
+/*------------------------------------------------------------------------------
+  CACHE FILE
+*/
+
+#define DRTABLE_MAGIC "ASCDRTB"
+#define DRTABLE_VERSION 1
+#define DRTABLE_ENDIAN 0x01020304
+
+/* 64-byte header, followed by the t, v and c arrays */
+typedef struct{
+	char magic[8];
+	uint32_t version;
+	uint32_t endian;
+	int32_t n;
+	int32_t ncols;
+	double dt;
+	int64_t srcsize;
+	int64_t srcmtime;
+	char format[16];
+} DrTableHeader;
+
+/* fill in the part of the header that identifies the source */
+static int drtable_header(DrTableHeader *h, struct FilePath *src, const char *format){
+	ospath_stat_t s;
+	if(ospath_stat(src, &s))return 1;
+	memset(h, 0, sizeof(DrTableHeader));
+	memcpy(h->magic, DRTABLE_MAGIC, sizeof(DRTABLE_MAGIC));
+	h->version = DRTABLE_VERSION;
+	h->endian = DRTABLE_ENDIAN;
+	h->srcsize = (int64_t)s.st_size;
+	h->srcmtime = (int64_t)s.st_mtime;
+	strncpy(h->format, format, sizeof(h->format) - 1);
+	return 0;
+}
+
+int drtable_save(const DataReaderTable *tab, const char *cachefn, struct FilePath *src, const char *format){
+	DrTableHeader h;
+	FILE *f;
+	char *tmpfn;
+	size_t len = strlen(cachefn), ok;
+
+	if(drtable_header(&h, src, format))return 1;
+	h.n = tab->n;
+	h.ncols = tab->ncols;
+	h.dt = tab->dt;
+
+	/* write to a temporary file then rename it, so that a concurrent or
+	interrupted run never sees a partly written cache */
+	tmpfn = ASC_NEW_ARRAY(char, len + 5);
+	sprintf(tmpfn, "%s.tmp", cachefn);
+	f = fopen(tmpfn, "wb");
+	if(f == NULL){
+		ASC_FREE(tmpfn);
+		return 1;
+	}
+	ok = fwrite(&h, sizeof(h), 1, f) == 1
+		&& fwrite(tab->t, sizeof(double), drtable_ndoubles(tab->n, tab->ncols), f)
+			== drtable_ndoubles(tab->n, tab->ncols);
+	if(fclose(f))ok = 0;
+#ifdef __WIN32__
+	remove(cachefn);
+#endif
+	if(!ok || rename(tmpfn, cachefn)){
+		remove(tmpfn);
+		ASC_FREE(tmpfn);
+		return 1;
+	}
+	ASC_FREE(tmpfn);
+	MSG("Saved cache '%s'",cachefn);
+	return 0;
+}
+
+DataReaderTable *drtable_load(const char *cachefn, struct FilePath *src, const char *format){
+	DrTableHeader want;
+	const DrTableHeader *h;
+	DataReaderTable *tab;
+	void *mem;
+	size_t size;
+
+	if(drtable_header(&want, src, format))return NULL;
+
+#ifndef __WIN32__
+	{
+		struct stat s;
+		int fd = open(cachefn, O_RDONLY);
+		if(fd < 0)return NULL;
+		if(fstat(fd, &s) || (size_t)s.st_size < sizeof(DrTableHeader)){
+			close(fd);
+			return NULL;
+		}
+		size = (size_t)s.st_size;
+		mem = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if(mem == MAP_FAILED)return NULL;
+	}
+#else
+	{
+		FILE *f = fopen(cachefn, "rb");
+		long sz;
+		if(f == NULL)return NULL;
+		if(fseek(f, 0, SEEK_END) || (sz = ftell(f)) < (long)sizeof(DrTableHeader)){
+			fclose(f);
+			return NULL;
+		}
+		rewind(f);
+		size = (size_t)sz;
+		mem = ASC_NEW_ARRAY(char, size);
+		if(fread(mem, 1, size, f) != size){
+			ASC_FREE(mem);
+			fclose(f);
+			return NULL;
+		}
+		fclose(f);
+	}
+#endif
+
+	h = (const DrTableHeader *)mem;
+	if(memcmp(h->magic, want.magic, sizeof(h->magic))
+		|| h->version != want.version || h->endian != want.endian
+		|| h->srcsize != want.srcsize || h->srcmtime != want.srcmtime
+		|| strncmp(h->format, want.format, sizeof(h->format))
+		|| h->n < 2 || h->ncols < 1
+		|| size != sizeof(DrTableHeader) + drtable_ndoubles(h->n, h->ncols) * sizeof(double)
+	){
+		MSG("Cache '%s' is out of date or invalid",cachefn);
+#ifndef __WIN32__
+		munmap(mem, size);
+#else
+		ASC_FREE(mem);
+#endif
+		return NULL;
+	}
+
+	tab = ASC_NEW(DataReaderTable);
+	tab->n = h->n;
+	tab->ncols = h->ncols;
+	tab->dt = h->dt;
+	tab->mem = mem;
+	tab->memsize = size;
+#ifndef __WIN32__
+	tab->mapped = 1;
+#else
+	tab->mapped = 0;
+#endif
+	drtable_setup(tab, (const double *)((const char *)mem + sizeof(DrTableHeader)));
+	MSG("Loaded cache '%s': %d points x %d columns",cachefn,tab->n,tab->ncols);
+	return tab;
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION
+*/
+
+int drtable_locate(const DataReaderTable *tab, double t, int *hint){
+	const double *T = tab->t;
+	int n = tab->n, k = *hint, lo, hi, mid;
+
+	if(t > T[n-1])return -1;
+	if(k < 0 || k > n - 2)k = 0;
+	if(t < T[1]){
+		k = 0;
+	}else if(t >= T[n-2]){
+		k = n - 2;
+	}else if(T[k] <= t && t < T[k+1]){
+		/* same interval as last time */
+	}else if(k + 2 < n && T[k+1] <= t && t < T[k+2]){
+		/* next interval */
+		++k;
+	}else if(tab->dt > 0){
+		/* uniform grid: index directly, then correct for rounding */
+		k = (int)((t - T[0]) / tab->dt);
+		if(k > n - 2)k = n - 2;
+		while(k > 0 && T[k] > t)--k;
+		while(k < n - 2 && T[k+1] <= t)++k;
+	}else{
+		/* T[lo] <= t < T[hi] */
+		lo = 1;
+		hi = n - 2;
+		while(hi - lo > 1){
+			mid = lo + (hi - lo) / 2;
+			if(T[mid] <= t)lo = mid;
+			else hi = mid;
+		}
+		k = lo;
+	}
+	*hint = k;
+	return k;
+}
+
+#define COEFF(TAB,J,K) ((TAB)->c + ((size_t)(J) * ((TAB)->n - 1) + (K)) * 4)
+
+double drtable_cubic(const DataReaderTable *tab, int j, int k, double t){
+	const double *c = COEFF(tab, j, k);
+	double s = t - tab->t[k];
+	return c[0] + s * (c[1] + s * (c[2] + s * c[3]));
+}
+
+double drtable_cubic_deriv(const DataReaderTable *tab, int j, int k, double t){
+	const double *c = COEFF(tab, j, k);
+	double s = t - tab->t[k];
+	return c[1] + s * (2 * c[2] + s * 3 * c[3]);
+}
+
+double drtable_linear(const DataReaderTable *tab, int j, int k, double t){
+	const double *v = tab->v + (size_t)j * tab->n;
+	return v[k] + (v[k+1] - v[k]) / (tab->t[k+1] - tab->t[k]) * (t - tab->t[k]);
+}
+
+double drtable_linear_deriv(const DataReaderTable *tab, int j, int k, double t){
+	const double *v = tab->v + (size_t)j * tab->n;
+	(void)t;
+	return (v[k+1] - v[k]) / (tab->t[k+1] - tab->t[k]);
+}
@@ -0,0 +1,102 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Columnar sample table for the Data Reader.
+
+	Once a data file has been read by its format handler, the sample times
+	and the values of every column are copied into contiguous arrays, and
+	the constrained cubic spline (C J C Kruger, 'Constrained Cubic Spline
+	Interpolation for Chemical Engineering Applications') through each
+	column is worked out once, as per-interval coefficients. Evaluation is
+	then a lookup of the interval, by direct index on a uniform time grid
+	or by binary search otherwise, and a polynomial evaluation.
+
+	The table can be saved to a binary cache file and memory-mapped from it
+	on later runs, skipping the (slow) parsing of the original file. The
+	cache records the size and modification time of the original file and
+	the format it was read with, and is ignored if these don't match.
+	The cache is in the native byte order and is not meant to be portable.
+*/
+
+#ifndef DATAREADER_DRTABLE_H
+#define DATAREADER_DRTABLE_H
+
+#include "dr.h"
+
+struct FilePath;
+
+struct DataReaderTable_struct{
+	int n;             /**< number of samples */
+	int ncols;         /**< number of value columns */
+	const double *t;   /**< sample times, increasing [n] */
+	const double *v;   /**< values, column by column [ncols][n] */
+	const double *c;   /**< spline coefficients, [ncols][n-1][4] */
+	double dt;         /**< sample spacing if uniform, else 0 */
+	void *mem;         /**< allocated or mapped block holding t, v and c */
+	size_t memsize;    /**< size of mem */
+	int mapped;        /**< mem is mapped from a cache file */
+};
+
+/**
+	Build a table from the data loaded by the format handler of d, using its
+	indepfn and valfn for each sample in turn.
+	@return the new table, or NULL if the data could not be tabulated (eg
+	sample times not increasing).
+*/
+DataReaderTable *drtable_from_reader(DataReader *d);
+
+/**
+	Load a table from the cache file cachefn, provided that it was made from
+	the data file src (as it is now) in the given format.
+	@return the table, or NULL if there is no usable cache.
+*/
+DataReaderTable *drtable_load(const char *cachefn, struct FilePath *src, const char *format);
+
+/**
+	Save a table to the cache file cachefn, recording the state of the data
+	file src and the format it was read with.
+	@return 0 on success
+*/
+int drtable_save(const DataReaderTable *tab, const char *cachefn, struct FilePath *src, const char *format);
+
+void drtable_free(DataReaderTable *tab);
+
+/**
+	Find the interval k such that t[k] <= t < t[k+1], trying first the
+	interval *hint and the one after it, and setting *hint to the interval
+	found. The hint belongs to the caller, and may be any int (eg one left
+	from another table), so that the table is only read and lookups from
+	several threads at once are safe. Times before the first sample are
+	placed in the first interval, and t equal to the last sample in the
+	last interval.
+	@return the interval, or -1 if t is beyond the last sample.
+*/
+int drtable_locate(const DataReaderTable *tab, double t, int *hint);
+
+/** Value of column j at time t in interval k, by cubic spline */
+double drtable_cubic(const DataReaderTable *tab, int j, int k, double t);
+
+/** Derivative of drtable_cubic with respect to t */
+double drtable_cubic_deriv(const DataReaderTable *tab, int j, int k, double t);
+
+/** Value of column j at time t in interval k, by linear interpolation */
+double drtable_linear(const DataReaderTable *tab, int j, int k, double t);
+
+/** Derivative of drtable_linear with respect to t */
+double drtable_linear_deriv(const DataReaderTable *tab, int j, int k, double t);
+
+#endif
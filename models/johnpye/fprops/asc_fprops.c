@@ -40,6 +40,7 @@
 /* the code that we're wrapping... */
 #include "fprops.h"
 #include "sat.h"
+#include "sattable.h"
 #include "solve_ph.h"
 #include "thcond.h"
 #include "visc.h"
@@ -104,10 +105,11 @@ ExtBBoxFunc fprops_Tvsx_h_incomp_calc;
 */
 
 /* place to store symbols needed for accessing ASCEND's instance tree */
-static symchar *fprops_symbols[3];
+static symchar *fprops_symbols[4];
 #define COMPONENT_SYM fprops_symbols[0]
 #define TYPE_SYM fprops_symbols[1]
 #define SOURCE_SYM fprops_symbols[2]
+#define SAT_TOL_SYM fprops_symbols[3]
 
 static const char *fprops_p_Trho_help = "Calculate pressure from temperature and density, using FPROPS";
 static const char *fprops_u_Trho_help = "Calculate specific internal energy from temperature and density, using FPROPS";
@@ -197,6 +199,40 @@ ASC_EXPORT int fprops_register(){
 
 #undef CALCFN
 
+	/*
+		The functions without derivatives keep no state between calls, and
+		only read the fluid once asc_fprops_prepare has set it up, so their
+		finite differences can run concurrently and perturb several inputs
+		at once where the outputs allow.
+	*/
+#define FDFN(NAME) \
+	result += SetBlackBoxReentrant(#NAME,1); \
+	result += SetBlackBoxGroupedFD(#NAME,1)
+
+	FDFN(fprops_u_Trho);
+	FDFN(fprops_s_Trho);
+	FDFN(fprops_h_Trho);
+	FDFN(fprops_a_Trho);
+	FDFN(fprops_g_Trho);
+	FDFN(fprops_cp_Trho);
+	FDFN(fprops_cv_Trho);
+	FDFN(fprops_w_Trho);
+	FDFN(fprops_mu_Trho);
+	FDFN(fprops_lam_Trho);
+
+	FDFN(fprops_rho_Tp);
+	FDFN(fprops_cp_Tp);
+	FDFN(fprops_h_Tp);
+	FDFN(fprops_s_Tp);
+	FDFN(fprops_mu_T_incomp);
+	FDFN(fprops_lam_T_incomp);
+	FDFN(fprops_cp_T_incomp);
+	FDFN(fprops_phsx_vT);
+	FDFN(fprops_Tvsx_ph);
+	FDFN(fprops_Tvsx_h_incomp);
+
+#undef FDFN
+
 	if(result){
 		MSG("CreateUserFunction result = %d.",result);
 	}
@@ -211,12 +247,15 @@ int asc_fprops_prepare(struct BBoxInterp *bbox,
 	   struct Instance *data,
 	   struct gl_list_t *arglist
 ){
-	struct Instance *compinst, *typeinst, *srcinst;
+	struct Instance *compinst, *typeinst, *srcinst, *tolinst;
 	const char *comp, *type = NULL, *src = NULL;
+	double sat_tol = 0;
+	const PureFluid *P;
 
 	fprops_symbols[0] = AddSymbol("component");
 	fprops_symbols[1] = AddSymbol("type");
 	fprops_symbols[2] = AddSymbol("source");
+	fprops_symbols[3] = AddSymbol("sat_tol");
 
 	/* get the component name */
 	compinst = ChildByChar(data,COMPONENT_SYM);
@@ -258,12 +297,39 @@ int asc_fprops_prepare(struct BBoxInterp *bbox,
 		if(src && strlen(src)==0)src = NULL;
 	}
 
+	/* optional relative tolerance for a tabulated saturation curve (sattable.h) */
+	tolinst = ChildByChar(data,SAT_TOL_SYM);
+	if(tolinst){
+		if(InstanceKind(tolinst)!=REAL_CONSTANT_INST){
+			ERRMSG("DATA member 'sat_tol' must be a real_constant");
+			return 1;
+		}
+		sat_tol = RC_INST(tolinst)->value;
+	}
+
 	bbox->user_data = (void *)fprops_fluid(comp,type,src);
 	if(bbox->user_data == NULL){
 		ERRMSG("Unsupported component requested (name='%s',type='%s'). Check source-code for supported species.",comp,type);
 		return 1;
 	}
 
+	if(sat_tol > 0 && fprops_sat_table_enable((const PureFluid *)bbox->user_data, sat_tol)){
+		ERRMSG("Unable to use a saturation table for '%s', using exact routines.",comp);
+	}
+
+	/*
+		Set up now the fluid data that would otherwise be filled in on first
+		use (the triple point and any saturation table), so that evaluation,
+		which may be on several threads at once, only reads it.
+	*/
+	P = (const PureFluid *)bbox->user_data;
+	if((P->type == FPROPS_HELMHOLTZ || P->type == FPROPS_PENGROB) && P->data->T_t > 0){
+		double p_t, rhof_t, rhog_t;
+		FpropsError err = FPROPS_NO_ERROR;
+		fprops_triple_point(&p_t, &rhof_t, &rhog_t, P, &err);
+		fprops_sat_table(P);
+	}
+
 	MSG("Prepared component '%s'%s%s%s OK.",comp, type?" type '":"", type?type:"" ,type?"'":""
 	);
 	return 0;
@@ -675,18 +741,8 @@ int fprops_Tvsx_ph_calc(struct BBoxInterp *bbox,
 ){
 	CALCPREPARE(2,4);
 
-	static const PureFluid *last = NULL;
-	static double p,h,T,v,s,x;
-	if(last == FLUID && p == inputs[0] && h == inputs[1]){
-		outputs[0] = T;
-		outputs[1] = v;
-		outputs[2] = s;
-		outputs[3] = x;
-		return 0;
-	}
-
-	p = inputs[0];
-	h = inputs[1];
+	/* repeated calls at the same inputs are caught by the blackbox memo */
+	double p = inputs[0], h = inputs[1], T, v, s, x;
 	switch(FLUID->type){
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
@@ -746,7 +802,6 @@ int fprops_Tvsx_ph_calc(struct BBoxInterp *bbox,
 			x = (h - hf)  /(hg - hf);
 			v = vf + x * (vg-vf);
 			s = sf + x * (sg-sf);
-			last = FLUID;
 			outputs[0] = T;
 			outputs[1] = v;
 			outputs[2] = s;
@@ -767,7 +822,6 @@ int fprops_Tvsx_ph_calc(struct BBoxInterp *bbox,
 	v = 1./rho;
 			s = FLUID->s_fn(S.vals, FLUID->data, &err); // straight to EOS, no sat test req.
 	x = (v > 1./RHOCRIT(FLUID)) ? 1 : 0;
-	last = FLUID;
 	outputs[0] = T;
 	outputs[1] = v;
 	outputs[2] = s;
@@ -790,7 +844,6 @@ int fprops_Tvsx_ph_calc(struct BBoxInterp *bbox,
 				ERRMSGP("Failed to solve (p,h): %s (fluid '%s')",fprops_error(err),FLUID->name);
 				return 9;
 			}
-			last = FLUID;
 			outputs[0] = T;
 			outputs[1] = v;
 			outputs[2] = s;
@@ -817,18 +870,8 @@ int fprops_Tvsx_h_incomp_calc(struct BBoxInterp *bbox,
 ){
 	CALCPREPARE(1,4);
 
-	static const PureFluid *last = NULL;
 	double p = 1e5; // arbitrary!
-	static double h,T,v,s,x;
-	if(last == FLUID && h == inputs[1]){
-		outputs[0] = T;
-		outputs[1] = v;
-		outputs[2] = s;
-		outputs[3] = x;
-		return 0;
-	}
-
-	h = inputs[0];
+	double h = inputs[0], T, v, s, x;
 
 	MSG("hello!");
 
@@ -847,7 +890,6 @@ int fprops_Tvsx_h_incomp_calc(struct BBoxInterp *bbox,
 				ERRMSGP("Failed to solve (p,h): %s (fluid '%s')",fprops_error(err),FLUID->name);
 				return 9;
 			}
-			last = FLUID;
 			outputs[0] = T;
 			outputs[1] = v;
 			outputs[2] = s;
@@ -408,6 +408,70 @@ double fprops_x(FluidState2 state, FpropsError *err){
 	return 0;
 }
 
+/* single-phase properties at a state, using props_fn if the fluid has one */
+static void fprops_props_single(FluidState2 state, FluidProps *props, FpropsError *err){
+	const PureFluid *P = state.fluid;
+	if(P->props_fn){
+		P->props_fn(state.vals,P->data,props,err);
+		return;
+	}
+	props->T = fprops_T(state,err);
+	props->rho = fprops_rho(state,err);
+#define PROP(VAR) props->VAR = P->VAR##_fn(state.vals,P->data,err)
+	PROP(p); PROP(u); PROP(h); PROP(s); PROP(a); PROP(g);
+	PROP(cp); PROP(cv); PROP(w); PROP(dpdrho_T);
+#undef PROP
+	props->alphap = P->alphap_fn ? P->alphap_fn(state.vals,P->data,err) : NAN;
+	props->betap = P->betap_fn ? P->betap_fn(state.vals,P->data,err) : NAN;
+	props->dpdT_rho = props->alphap * props->p;
+}
+
+void fprops_props(FluidState2 state, FluidProps *props, FpropsError *err){
+	double T, rho, p, rho_f, rho_g, x;
+	FluidProps Pf, Pg;
+	props->x = NAN;
+	switch(state.fluid->type){
+	case FPROPS_HELMHOLTZ:
+	case FPROPS_PENGROB:
+		T = state.vals.Trho.T;
+		rho = state.vals.Trho.rho;
+		if(T >= state.fluid->data->T_t && T < state.fluid->data->T_c){
+			fprops_sat_T(T, &p, &rho_f, &rho_g, state.fluid, err);
+			if(*err){
+				MSG("Got error %d from saturation calc in %s\n",*err,__func__);
+				return;
+			}
+			if(rho_g < rho && rho < rho_f){
+				x = rho_g*(rho_f/rho - 1)/(rho_f - rho_g);
+				fprops_props_single((FluidState2){.vals={.Trho={T,rho_f}},.fluid=state.fluid},&Pf,err);
+				fprops_props_single((FluidState2){.vals={.Trho={T,rho_g}},.fluid=state.fluid},&Pg,err);
+				props->T = T;
+				props->rho = rho;
+				props->p = p;
+#define MIX(VAR) props->VAR = x*Pg.VAR + (1-x)*Pf.VAR
+				MIX(u); MIX(h); MIX(s); MIX(a); MIX(g);
+				MIX(alphap); MIX(betap); MIX(dpdrho_T);
+#undef MIX
+				/* Clapeyron */
+				props->dpdT_rho = (Pg.s - Pf.s)/(1/rho_g - 1/rho_f);
+				props->cp = props->cv = props->w = NAN;
+				props->x = x;
+				return;
+			}
+			props->x = (rho >= rho_f) ? 0 : 1;
+		}
+		break;
+	case FPROPS_INCOMP:
+	case FPROPS_IDEAL:
+		/* no phase change modelled for these fluids */
+		break;
+	default:
+		*err = FPROPS_INVALID_REQUEST;
+		return;
+	}
+	fprops_props_single(state,props,err);
+}
+
 double fprops_dpdT_rho(FluidState2 state, FpropsError *err){
 	*err = FPROPS_NOT_IMPLEMENTED;
 	return 0;
@@ -74,6 +74,21 @@ double fprops_dpdT_rho(FluidState2 state, FpropsError *err);
 /// return the fluid quality; 0 if subcooled, 1 if superheated, error if both T>T_c and p>p_c
 double fprops_x(FluidState2 state, FpropsError *err);
 
+/**
+	Evaluate all the properties in FluidProps at once. This gives the same
+	results as calling fprops_p, fprops_h, etc, in turn, but the saturation
+	state is found only once, and for Helmholtz fluids the residual function
+	and its derivatives are evaluated in a single sweep for all properties.
+
+	Inside the saturation dome, p is the saturation pressure; u, h, s, a, g,
+	alphap, betap and dpdrho_T are mass-weighted as for the individual
+	functions; dpdT_rho is the slope of the saturation curve; and cp, cv and w
+	are set to NAN (where the individual functions give FPROPS_VALUE_UNDEFINED).
+	x is the quality below T_c (0 for liquid, 1 for vapour, as for fprops_x)
+	and NAN otherwise.
+*/
+void fprops_props(FluidState2 state, FluidProps *props, FpropsError *err);
+
 #if 1
 double fprops_dpdrho_T(const FluidState2 state, FpropsError *err);
 double fprops_d2pdrho2_T(const FluidState2 state, FpropsError *err);
@@ -29,6 +29,7 @@
 #include "helmholtz.h"
 #include "ideal_impl.h"
 #include "sat.h"
+#include "sattable.h"
 #include "cp0.h"
 #include "refstate.h"
 
@@ -50,6 +51,7 @@ PropEvalFn2 helmholtz_dpdrho_T;
 PropEvalFn2 helmholtz_alphap;
 PropEvalFn2 helmholtz_betap;
 SatEvalFn helmholtz_sat;
+PropsEvalFn helmholtz_props;
 
 double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err);
 double helmholtz_d2pdrho2_T(FluidStateUnion vals, const FluidData *data, FpropsError *err);
@@ -123,6 +125,8 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 	MSG("Fluid '%s' with T_t = %f", E->name, E->data.helm->T_t);
 
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
+	P->data->triple_known = 0;
 	P->data->corr.helm = FPROPS_NEW(HelmholtzRunData);
 
 	/* metadata */
@@ -168,7 +172,7 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 	FN(T); FN(rho);
 	FN(p); FN(u); FN(h); FN(s); FN(a); FN(g); FN(cp); FN(cv); FN(w);
 	FN(alphap); FN(betap); FN(dpdrho_T);
-	FN(sat);
+	FN(sat); FN(props);
 #undef FN
 	P->setref_fn = refstate_set_for_phi0;
 
@@ -209,6 +213,7 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 
 void helmholtz_destroy(PureFluid *P){
 	assert(FPROPS_HELMHOLTZ == P->data);
+	fprops_sat_table_disable(P);
 	cp0_destroy(P->data->cp0);
 	FPROPS_FREE(P->data->corr.helm);
 	FPROPS_FREE(P->data);
@@ -322,8 +327,9 @@ double helmholtz_h(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	assert(!isnan(delta));
 	assert(!isnan(HD_R));
 //#endif
-	double h = HD_R * T * (1 + tau * (ideal_phi_tau(tau,HD_CP0) + helm_resid_tau(tau,delta,HD)) \
-		+ delta*helm_resid_del(tau,delta,HD));
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
+	double h = HD_R * T * (1 + tau * ideal_phi_tau(tau,HD_CP0) + r.tau + r.del);
 	assert(!isnan(h));
 	return h;
 }
@@ -351,9 +357,11 @@ double helmholtz_s(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	fprintf(stderr,"ideal_phi = %f\n",ideal_phi(tau,delta,HD_CP0));
 	fprintf(stderr,"helm_resid = %f\n",helm_resid(tau,delta,HD));
 #endif
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 	return HD_R * (
-		tau * (ideal_phi_tau(tau,HD_CP0) + helm_resid_tau(tau,delta,HD))
-		- (ideal_phi(tau,delta,HD_CP0) + helm_resid(tau,delta,HD))
+		tau * ideal_phi_tau(tau,HD_CP0) + r.tau
+		- (ideal_phi(tau,delta,HD_CP0) + r.phi)
 	);
 }
 
@@ -409,14 +417,13 @@ double helmholtz_cv(FluidStateUnion vals, const FluidData *data, FpropsError *er
 double helmholtz_cp(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 
 	/* note similarities with helmholtz_w */
-	double temp1 = 1 + 2*delta*phir_d + SQ(delta)*phir_dd;
-	double temp2 = 1 + delta*phir_d - delta*tau*phir_dt;
-	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + helm_resid_tautau(tau,delta,HD));
+	double temp1 = 1 + 2*r.del + r.deldel;
+	double temp2 = 1 + r.del - r.deltau;
+	double temp3 = -(SQ(tau)*ideal_phi_tautau(tau,HD_CP0) + r.tautau);
 
 	return HD_R * (temp3 + SQ(temp2)/temp1);
 }
@@ -433,14 +440,13 @@ double helmholtz_cp(FluidStateUnion vals, const FluidData *data, FpropsError *er
 double helmholtz_w(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 
 	/* note similarities with helmholtz_cp */
-	double temp1 = 1. + 2.*delta*phir_d + SQ(delta)*phir_dd;
-	double temp2 = 1. + delta*phir_d - delta*tau*phir_dt;
-	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + helm_resid_tautau(tau,delta,HD));
+	double temp1 = 1. + 2.*r.del + r.deldel;
+	double temp2 = 1. + r.del - r.deltau;
+	double temp3 = -(SQ(tau)*ideal_phi_tautau(tau,HD_CP0) + r.tautau);
 
 	return sqrt(HD_R * T * (temp1 + SQ(temp2)/temp3));
 
@@ -457,11 +463,11 @@ double helmholtz_w(FluidStateUnion vals, const FluidData *data, FpropsError *err
 double helmholtz_g(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir = helm_resid(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 	double phi0 = ideal_phi(tau,delta,HD_CP0);
 
-	return HD_R * T * (phi0 + phir + 1. + delta * phir_d);
+	return HD_R * T * (phi0 + r.phi + 1. + r.del);
 }
 
 /**
@@ -470,9 +476,9 @@ double helmholtz_g(FluidStateUnion vals, const FluidData *data, FpropsError *err
 */
 double helmholtz_alphap(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
-	return 1./T * (1. - delta*tau*phir_dt/(1 + delta*phir_d));
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
+	return 1./T * (1. - r.deltau/(1 + r.del));
 }
 
 /**
@@ -481,9 +487,46 @@ double helmholtz_alphap(FluidStateUnion vals, const FluidData *data, FpropsError
 */
 double helmholtz_betap(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	return rho*(1. + (delta*phir_d + SQ(delta)*phir_dd)/(1+delta*phir_d));
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
+	return rho*(1. + (r.del + r.deldel)/(1+r.del));
+}
+
+/**
+	Evaluate all of the properties in FluidProps at once, from a single
+	evaluation of phir and its derivatives (plus the ideal part), rather than
+	the several that calling the above functions one by one would need.
+*/
+void helmholtz_props(FluidStateUnion vals, const FluidData *data, FluidProps *props, FpropsError *err){
+	DEFINE_TD;
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
+
+	double phi0 = ideal_phi(tau,delta,HD_CP0);
+	double phi0_tau = tau * ideal_phi_tau(tau,HD_CP0);
+	double phi0_tautau = SQ(tau) * ideal_phi_tautau(tau,HD_CP0);
+	double RT = HD_R * T;
+
+	double temp1 = 1 + 2*r.del + r.deldel;
+	double temp2 = 1 + r.del - r.deltau;
+	double temp3 = -(phi0_tautau + r.tautau);
+
+	props->T = T;
+	props->rho = rho;
+	props->p = RT * rho * (1 + r.del);
+	props->u = RT * (phi0_tau + r.tau);
+	props->h = RT * (1 + phi0_tau + r.tau + r.del);
+	props->s = HD_R * (phi0_tau + r.tau - (phi0 + r.phi));
+	props->a = RT * (phi0 + r.phi);
+	props->g = RT * (phi0 + r.phi + 1. + r.del);
+	props->cv = HD_R * temp3;
+	props->cp = HD_R * (temp3 + SQ(temp2)/temp1);
+	props->w = sqrt(RT * (temp1 + SQ(temp2)/temp3));
+	props->alphap = 1./T * (1. - r.deltau/(1 + r.del));
+	props->betap = rho*(1. + (r.del + r.deldel)/(1+r.del));
+	props->dpdT_rho = HD_R * rho * temp2;
+	props->dpdrho_T = RT * temp1;
+	if(isnan(props->p))*err = FPROPS_NUMERIC_ERROR;
 }
 
 /*----------------------------------------------------------------------------
@@ -496,19 +539,19 @@ double helmholtz_betap(FluidStateUnion vals, const FluidData *data, FpropsError
 double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 #ifdef TEST
-	assert(!isinf(phir_del));
-	assert(!isinf(phir_deltau));
-	assert(!isnan(phir_del));
-	assert(!isnan(phir_deltau));
+	assert(!isinf(r.del));
+	assert(!isinf(r.deltau));
+	assert(!isnan(r.del));
+	assert(!isnan(r.deltau));
 	assert(!isnan(HD_R));
 	assert(!isnan(rho));
 	assert(!isnan(tau));
 #endif
 
-	double res = HD_R * rho * (1 + delta*phir_del - delta*tau*phir_deltau);
+	double res = HD_R * rho * (1 + r.del - r.deltau);
 
 #ifdef TEST
 	assert(!isnan(res));
@@ -523,13 +566,13 @@ double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dpdrho_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 	//MSG("...");
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deldel = helm_resid_deldel(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 #ifdef TEST
-	assert(!isinf(phir_del));
-	assert(!isinf(phir_deldel));
+	assert(!isinf(r.del));
+	assert(!isinf(r.deldel));
 #endif
-	return HD_R * T * (1 + 2*delta*phir_del + SQ(delta)*phir_deldel);
+	return HD_R * T * (1 + 2*r.del + r.deldel);
 }
 
 
@@ -554,15 +597,12 @@ double helmholtz_d2pdrho2_T(FluidStateUnion vals, const FluidData *data, FpropsE
 double helmholtz_dhdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
-	double phir_tautau = helm_resid_tautau(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 	double phi0_tautau = ideal_phi_tautau(tau,HD_CP0);
 
-	//fprintf(stderr,"phir_del = %f, phir_deltau = %f, phir_tautau = %f, phi0_tautau = %f\n",phir_del,phir_deltau,phir_tautau,phi0_tautau);
-
 	//return (helmholtz_h(T+0.01,rho,data) - helmholtz_h(T,rho,data)) / 0.01;
-	return HD_R * (1. + delta*phir_del - SQ(tau)*(phi0_tautau + phir_tautau) - delta*tau*phir_deltau);
+	return HD_R * (1. + r.del - (SQ(tau)*phi0_tautau + r.tautau) - r.deltau);
 }
 
 /**
@@ -571,11 +611,10 @@ double helmholtz_dhdT_rho(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dhdrho_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
-	double phir_deldel = helm_resid_deldel(tau,delta,HD);
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
 
-	return HD_R * T / rho * (tau*delta*(0 + phir_deltau) + delta * phir_del + SQ(delta)*phir_deldel);
+	return HD_R * T / rho * (r.deltau + r.del + r.deldel);
 }
 
 
@@ -604,6 +643,26 @@ double helmholtz_dudrho_T(FluidStateUnion vals, const FluidData *data, FpropsErr
 }
 
 
+/**
+	Pressure, Gibbs energy and dp/drho at (T,rho), as needed for each phase at
+	each iteration of helmholtz_sat, from a single evaluation of phir and its
+	derivatives.
+*/
+static void helmholtz_sat_eval(double T, double rho, const FluidData *data
+	, double *p, double *g, double *dpdrho, FpropsError *err
+){
+	double tau = HD->T_star / T;
+	double delta = rho / HD->rho_star;
+	HelmholtzResid r;
+	helm_resid_all(tau,delta,HD,&r);
+
+	double RT = HD_R * T;
+	*p = RT * rho * (1 + r.del);
+	if(isnan(*p))*err = FPROPS_NUMERIC_ERROR;
+	*g = RT * (ideal_phi(tau,delta,HD_CP0) + r.phi) + *p/rho;
+	*dpdrho = RT * (1 + 2*r.del + r.deldel);
+}
+
 /**
 	Solve saturation condition for a specified temperature using approach of
 	Akasaka, but adapted for general use to non-helmholtz property correlations.
@@ -657,12 +716,9 @@ double helmholtz_sat(double T, double *rhof_out, double * rhog_out, const FluidD
 		MSG("iter %d: T = %f, rhof = %f, rhog = %f",i,T, rhof, rhog);
 #endif
 
-		double pf = helmholtz_p((FluidStateUnion){.Trho={T,rhof}},data,err);
-		double pg = helmholtz_p((FluidStateUnion){.Trho={T,rhog}},data,err);
-		double gf = helmholtz_a((FluidStateUnion){.Trho={T,rhof}},data,err) + pf/rhof;
-		double gg = helmholtz_a((FluidStateUnion){.Trho={T,rhog}},data,err) + pg/rhog;
-		double dpdrf = helmholtz_dpdrho_T((FluidStateUnion){.Trho={T,rhof}},data,err);
-		double dpdrg = helmholtz_dpdrho_T((FluidStateUnion){.Trho={T,rhog}},data,err);
+		double pf, pg, gf, gg, dpdrf, dpdrg;
+		helmholtz_sat_eval(T,rhof,data,&pf,&gf,&dpdrf,err);
+		helmholtz_sat_eval(T,rhog,data,&pg,&gg,&dpdrg,err);
 
 		// jacobian for [F;G](rhof, rhog) --- derivatives wrt rhof and rhog
 		double F = (pf - pg)/pc;
@@ -1404,6 +1460,128 @@ double helm_resid_tautau(double tau, double delta, const HelmholtzRunData *HD){
 	return res;
 }
 
+/*=================== ALL AT ONCE =======================*/
+
+/**
+	Residual part of helmholtz function with all of its first and second
+	derivatives, in a single pass through the terms of the correlation. Each
+	term needs only one pow(tau,t) and one ipow/pow of delta, and each group of
+	power terms with the same 'l' and each gaussian term one exp; the
+	critical-term intermediates are likewise shared between derivatives.
+
+	The expressions are those of the individual helm_resid_* functions above,
+	multiplied through by the powers of delta and tau noted in HelmholtzResid.
+*/
+void helm_resid_all(double tau, double delta, const HelmholtzRunData *HD, HelmholtzResid *r){
+	double phi = 0, del = 0, tau_ = 0, deldel = 0, deltau = 0, tautau = 0;
+	double s0 = 0, s1 = 0, s2 = 0, s11 = 0, s12 = 0, s22 = 0;
+	double dell, ldell, E;
+	unsigned n, i, oldl;
+	const HelmholtzPowTerm *pt;
+	const HelmholtzGausTerm *gt;
+	const HelmholtzCritTerm *ct;
+
+	/* power terms */
+	n = HD->np;
+	pt = &(HD->pt[0]);
+	dell = ipow(delta,pt->l);
+	ldell = pt->l * dell;
+	for(i=0; i<n; ++i){
+		double term = pt->a * pow(tau, pt->t) * ipow(delta, pt->d);
+		double dl = pt->d - ldell;
+		double lpart = pt->l ? SQ(ldell) + ldell*(1. - 2*pt->d - pt->l) : 0;
+		s0 += term;
+		s1 += term * dl;
+		s11 += term * (pt->d*(pt->d - 1) + lpart);
+		s2 += term * pt->t;
+		s12 += term * pt->t * dl;
+		s22 += term * pt->t * (pt->t - 1);
+		oldl = pt->l;
+		++pt;
+		if(i+1==n || oldl != pt->l){
+			E = (oldl == 0) ? 1 : exp(-dell);
+			phi += s0 * E;
+			del += s1 * E;
+			deldel += s11 * E;
+			tau_ += s2 * E;
+			deltau += s12 * E;
+			tautau += s22 * E;
+			s0 = s1 = s2 = s11 = s12 = s22 = 0;
+			if(i+1<n){
+				dell = (delta==0 ? 0 : ipow(delta,pt->l));
+				ldell = pt->l*dell;
+			}
+		}
+	}
+
+	/* gaussian terms */
+	n = HD->ng;
+	gt = &(HD->gt[0]);
+	for(i=0; i<n; ++i){
+		double d1 = delta - gt->epsilon;
+		double t1 = tau - gt->gamma;
+		double e1 = -gt->alpha*SQ(d1) - gt->beta*SQ(t1);
+		double term = gt->n * pow(tau,gt->t) * pow(delta,gt->d) * exp(e1);
+		double f1 = gt->t - 2*gt->beta*tau*t1;
+		double g1 = gt->d - 2*gt->alpha*delta*d1;
+		phi += term;
+		del += term * g1;
+		deldel += term * (gt->d*(gt->d - 1)
+			+ 2.*gt->alpha*delta * (delta * (2. * gt->alpha * SQ(d1) - 1) - 2. * gt->d * d1)
+		);
+		tau_ += term * f1;
+		deltau += term * f1 * g1;
+		tautau += term * (gt->t*(gt->t - 1)
+			+ 4. * gt->beta * tau * (tau * (gt->beta*SQ(t1) - 0.5) - t1*gt->t)
+		);
+		++gt;
+	}
+
+	/* critical terms */
+	n = HD->nc;
+	ct = &(HD->ct[0]);
+	for(i=0; i<n; ++i){
+		DEFINE_DELTA;
+		DEFINE_DELB;
+		DEFINE_DPSIDDELTA;
+		DEFINE_DPSIDTAU;
+		DEFINE_DDELDDELTA;
+		DEFINE_DDELBDTAU;
+		DEFINE_DDELBDDELTA;
+		DEFINE_D2DELDDELTA2;
+		DEFINE_D2DELBDDELTA2;
+		DEFINE_D2PSIDDELTA2;
+
+		double d2DELbddeldtau = -ct->A * ct->b * 2./ct->beta * (DELB/DELTA)*d1*pow(d12,0.5/ct->beta-1) \
+			- 2. * theta * ct->b * (ct->b - 1) * (DELB/SQ(DELTA)) * dDELddelta;
+		double d2PSIddeldtau = 4. * ct->C*ct->D*d1*t1*PSI;
+		double d2DELbdtau2 = 2. * ct->b * (DELB/DELTA) + 4. * SQ(theta) * ct->b * (ct->b - 1) * (DELB/SQ(DELTA));
+		double d2PSIdtau2 = 2. * ct->D * PSI * (2. * ct->D * SQ(t1) -1.);
+
+		phi += ct->n * DELB * delta * PSI;
+		del += delta * ct->n * (DELB * (PSI + delta * dPSIddelta) + dDELbddelta * delta * PSI);
+		deldel += SQ(delta) * ct->n * (DELB*(2.*dPSIddelta + delta*d2PSIddelta2)
+			+ 2.*dDELbddelta*(PSI+delta*dPSIddelta) + d2DELbddelta2*delta*PSI
+		);
+		tau_ += tau * ct->n * delta * (dDELbdtau * PSI + DELB * dPSIdtau);
+		deltau += delta * tau * ct->n * (DELB * (dPSIdtau + delta * d2PSIddeldtau)
+			+ delta *dDELbdtau*dPSIdtau
+			+ dDELbdtau*(PSI+delta*dPSIddelta)
+			+ d2DELbddeldtau*delta*PSI
+		);
+		tautau += SQ(tau) * ct->n * delta * (d2DELbdtau2 * PSI + 2 * dDELbdtau*dPSIdtau + DELB * d2PSIdtau2);
+		++ct;
+	}
+
+	r->phi = phi;
+	r->del = del;
+	r->tau = tau_;
+	r->deldel = deldel;
+	r->deltau = deltau;
+	r->tautau = tautau;
+	assert(!__isnan(phi));
+}
+
 /* === THIRD DERIVATIVES (this is getting boring now) === */
 
 #ifdef INCLUDE_THIRD_DERIV_CODE
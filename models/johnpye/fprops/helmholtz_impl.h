@@ -35,6 +35,29 @@ double helm_resid_deltau(double tau, double delta, const HelmholtzRunData *data)
 double helm_resid_deldel(double tau, double delta, const HelmholtzRunData *data);
 double helm_resid_tautau(double tau, double delta, const HelmholtzRunData *data);
 
+/**
+	The residual Helmholtz function and all of its first and second derivatives
+	at a single (tau, delta), as returned by helm_resid_all. The derivatives
+	are held pre-multiplied by the matching powers of delta and tau, which is
+	the form in which they appear in the property expressions, and which stays
+	finite as delta goes to zero.
+*/
+typedef struct HelmholtzResid_struct{
+	double phi;    /**< phir */
+	double del;    /**< delta * d(phir)/d(delta) */
+	double tau;    /**< tau * d(phir)/d(tau) */
+	double deldel; /**< delta^2 * d2(phir)/d(delta)2 */
+	double deltau; /**< delta * tau * d2(phir)/d(delta)d(tau) */
+	double tautau; /**< tau^2 * d2(phir)/d(tau)2 */
+} HelmholtzResid;
+
+/**
+	Evaluate phir and its derivatives up to second order in a single sweep
+	through the power, gaussian and critical terms, sharing the pow/exp
+	evaluations that the individual helm_resid_* functions each repeat.
+*/
+void helm_resid_all(double tau, double delta, const HelmholtzRunData *data, HelmholtzResid *r);
+
 #ifdef INCLUDE_THIRD_DERIV_CODE
 double helm_resid_deldeldel(double tau, double delta, const HelmholtzRunData *data);
 #endif
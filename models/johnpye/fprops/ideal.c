@@ -60,6 +60,8 @@
 PureFluid *ideal_prepare(const EosData *E, const ReferenceState *ref){
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
+	P->data->triple_known = 0;
 #define D P->data
 
 	//MSG("...");
@@ -124,6 +126,8 @@ PureFluid *ideal_prepare(const EosData *E, const ReferenceState *ref){
 	FN(p); FN(u); FN(h); FN(s); FN(a); FN(g); FN(cp); FN(cv); FN(w);
 	FN(dpdrho_T);
 	FN(sat);
+	P->alphap_fn = NULL; P->betap_fn = NULL;
+	P->props_fn = NULL;
 	P->setref_fn = refstate_set_for_phi0;
 #undef FN
 
@@ -76,6 +76,8 @@ SatEvalFn incomp_sat;
 PureFluid *incomp_prepare(const EosData *E, const ReferenceState *ref){
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
+	P->data->triple_known = 0;
 #define D P->data
 #define I E->data.incomp
 
@@ -145,6 +147,8 @@ PureFluid *incomp_prepare(const EosData *E, const ReferenceState *ref){
 	FN(rho);
 	FN(dpdrho_T);
 	FN(sat);
+	P->alphap_fn = NULL; P->betap_fn = NULL;
+	P->props_fn = NULL;
 #undef FN
 	P->setref_fn = &refstate_set_for_incomp;
 
@@ -26,6 +26,7 @@
 #include "cubicroots.h"
 #include "fprops.h"
 #include "sat.h"
+#include "sattable.h"
 #include "ideal_impl.h"
 #include "refstate.h"
 #include "cp0.h"
@@ -80,6 +81,8 @@ PureFluid *pengrob_prepare(const EosData *E, const ReferenceState *ref){
 	MSG("Preparing PR fluid '%s'...",E->name);
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
+	P->data->triple_known = 0;
 
 	/* metadata */
 	// TODO should we copy this so that we can uncouple the filedata? */
@@ -217,6 +220,7 @@ PureFluid *pengrob_prepare(const EosData *E, const ReferenceState *ref){
 	FN(p); FN(u); FN(h); FN(s); FN(a); FN(g); FN(cp); FN(cv); FN(w);
 	FN(dpdrho_T); FN(alphap); FN(betap);
 	FN(sat);
+	P->props_fn = NULL;
 	P->setref_fn = refstate_set_for_phi0;
 #undef FN
 #undef I
@@ -229,6 +233,7 @@ PureFluid *pengrob_prepare(const EosData *E, const ReferenceState *ref){
 
 
 void pengrob_destroy(PureFluid *P){
+	fprops_sat_table_disable(P);
 	cp0_destroy(P->data->cp0);
 	FPROPS_FREE(P->data->corr.pengrob);
 	FPROPS_FREE(P->data);
@@ -9,6 +9,7 @@
 #include "../fprops.h"
 #include "../fluids.h"
 #include "../sat.h"
+#include "../sattable.h"
 #include "../common.h"
 #include "../solve_ph.h"
 #include "../solve_Tx.h"
@@ -109,6 +110,18 @@ int fprops_num_fluids();
 typedef struct{} FluidState2;
 typedef struct{} PureFluid;
 
+// all properties of a state at once, see FluidState2.props()
+%immutable;
+typedef struct{
+	double T, rho, p;
+	double u, h, s, a, g;
+	double cp, cv, w;
+	double alphap, betap;
+	double dpdT_rho, dpdrho_T;
+	double x;
+} FluidProps;
+%mutable;
+
 /* FIXME what should we do with ctors and dtors...? */
 //%nodefaultdtor PureFluid;
 %nodefaultctor PureFluid;
@@ -225,6 +238,11 @@ typedef struct{} PureFluid;
 		return T;
 	}
 
+	// use a tabulated saturation curve in sat_T and sat_p; returns 0 on success
+	int sat_table(double tol){
+		return fprops_sat_table_enable($self, tol);
+	}
+
 	// raise exception if user attempts to write to these variables
 	//%typemap(in) double{
 	//	SWIG_exception(SWIG_ValueError,"Read-only attribute");
@@ -322,6 +340,11 @@ exception types? */
 	double deriv(char *spec, FpropsError *err){
 		return fprops_deriv(*$self, spec, err);
 	}
+	FluidProps props(FpropsError *err){
+		FluidProps P;
+		fprops_props(*$self, &P, err);
+		return P;
+	}
 	%immutable;
 	double T, rho, v;
 	double x, p, u, h, s, a, cv, cp, w, g, alphap, betap, cp0, dpdT_rho;
@@ -30,6 +30,7 @@ Data declarations as provided in input files are given in filedata.h
 #include "filedata.h"
 
 typedef struct PureFluid_struct PureFluid;
+typedef struct SatTable_struct SatTable;
 
 /** Power terms for phi0 (including polynomial) */
 typedef struct Phi0RunPowTerm_struct{
@@ -99,9 +100,7 @@ correlation-type-ID, function pointers and metadata (URLs, publications etc)
 
 TODO FluidData (or PureFluid?) could/should be extended to include the following
 frequently-calculated items:
-	- fluid properties at triple point (rhoft, rhogt, pt...)
 	- fluid properties at critical point (hc, ...)
-	- accurate saturation curve data (interpolation/spline/something like that)
 	- solutions of iterative solver results, eg (p,h) pairs.
 
 This data would be held at this level unless it is correlation-specific in
@@ -131,6 +130,10 @@ typedef struct FluidData_struct{
 	ReferenceState ref0;
 	/* correlation-specific stuff here */
 	CorrelationUnion corr;
+	SatTable *sat; /**< tabulated saturation curve, or NULL; see sattable.h */
+	/* saturation state at T_t, once calculated by fprops_triple_point */
+	int triple_known; /**< non-zero once p_t, rhof_t, rhog_t are set */
+	double p_t, rhof_t, rhog_t;
 } FluidData;
 
 
@@ -184,6 +187,26 @@ typedef double PropEvalFn2(FluidStateUnion vals,const FluidData *data, FpropsErr
 
 //typedef double PropEvalFn(double T, double rho, const FluidData *data, FpropsError *err);
 
+/**
+	The common thermodynamic properties of a single state, as returned
+	together by fprops_props. Units are as for the individual fprops_*
+	functions.
+*/
+typedef struct FluidProps_struct{
+	double T, rho, p;
+	double u, h, s, a, g;
+	double cp, cv, w;
+	double alphap, betap;
+	double dpdT_rho, dpdrho_T;
+	double x; ///< quality, or NAN where not defined (see fprops_props)
+} FluidProps;
+
+/**
+	Evaluate all of FluidProps (except x) at a single-phase state in one go,
+	sharing the work between properties.
+*/
+typedef void PropsEvalFn(FluidStateUnion vals, const FluidData *data, FluidProps *props, FpropsError *err);
+
 /** @return psat */
 typedef double SatEvalFn(double T,double *rhof, double *rhog, const FluidData *data, FpropsError *err);
 
@@ -219,6 +242,7 @@ typedef struct PureFluid_struct{
 	PropEvalFn2 *betap_fn;
 	PropEvalFn2 *dpdrho_T_fn; // this derivative is required for saturation properties by Akasaka method
 	SatEvalFn *sat_fn; // function to return {psat,rhof,rhog}(T) for this pure fluid;
+	PropsEvalFn *props_fn; // optional: all properties at once, NULL to use the functions above
 	SetRefStateFn *setref_fn; // function to set reference state for this pure fluid
 
 	const ViscosityData *visc; // TODO should it be here? or inside FluidData?? probably yes, but needs review.
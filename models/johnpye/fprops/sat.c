@@ -25,6 +25,7 @@
 
 #include "rundata.h"
 #include "sat.h"
+#include "sattable.h"
 #include "fprops.h"
 #include "zeroin.h"
 
@@ -229,19 +230,21 @@ double fprops_rhog_T_chouaieb(double T, const FluidData *data){
 }
 
 void fprops_sat_T(double T, double *psat, double *rhof, double *rhog, const PureFluid *d, FpropsError *err){
+	if(d->data->sat && 0 == fprops_sat_table_T(T, psat, rhof, rhog, d))return;
 	*psat = d->sat_fn(T,rhof,rhog,d->data,err);
 }
 
 /**
 	Calculate the triple point pressure and densities using T_t from the FluidData.
+	The result is kept in the FluidData, so that later calls (which may be
+	from several threads at once) only read it.
 */
 void fprops_triple_point(double *p_t_out, double *rhof_t_out, double *rhog_t_out, const PureFluid *d, FpropsError *err){
-	static const PureFluid *d_last = NULL;
-	static double p_t, rhof_t, rhog_t;
-	if(d == d_last){
-		*p_t_out = p_t;
-		*rhof_t_out = rhof_t;
-		*rhog_t_out = rhog_t;
+	double p_t, rhof_t, rhog_t;
+	if(d->data->triple_known){
+		*p_t_out = d->data->p_t;
+		*rhof_t_out = d->data->rhof_t;
+		*rhog_t_out = d->data->rhog_t;
 		return;
 	}
 
@@ -252,7 +255,10 @@ void fprops_triple_point(double *p_t_out, double *rhof_t_out, double *rhog_t_out
 	MSG("Calculating for '%s' (type %d, T_t = %f, T_c = %f, p_c = %f)",d->name, d->type, d->data->T_t, d->data->T_c, d->data->p_c);
 	fprops_sat_T(d->data->T_t, &p_t, &rhof_t, &rhog_t,d,err);
 	if(*err)return;
-	d_last = d;
+	d->data->p_t = p_t;
+	d->data->rhof_t = rhof_t;
+	d->data->rhog_t = rhog_t;
+	d->data->triple_known = 1;
 	*p_t_out = p_t;
 	*rhof_t_out = rhof_t;
 	*rhog_t_out = rhog_t;
@@ -315,6 +321,9 @@ static double sat_p_resid(double rT, void *user_data){
 	the Akasaka algorithm that works with with rhof, rhog as the free variables,
 	see helmholtz.c...? Method above uses nested iteration on T inside p, so is
 	going to be slooooooow, even if it's fairly reliable.
+
+	If a saturation table has been enabled for the fluid (see sattable.h) and
+	p is within its range, the result comes from the table instead.
 */
 void fprops_sat_p(double p, double *T_sat, double *rho_f, double *rho_g, const PureFluid *P, FpropsError *err){
 	if(*err){
@@ -328,7 +337,8 @@ void fprops_sat_p(double p, double *T_sat, double *rho_f, double *rho_g, const P
 		return;
 	}
 	/* FIXME what about checking triple point pressure? */
-	
+
+	if(P->data->sat && 0 == fprops_sat_table_p(p, T_sat, rho_f, rho_g, P))return;
 
 	SatPResidData D = {
 		P, log(p), err, 0
@@ -0,0 +1,567 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Tabulated saturation curve, see sattable.h.
+*/
+
+#include "sattable.h"
+
+#include <math.h>
+#include <stdio.h>
+
+//#define SATTABLE_DEBUG
+#define SATTABLE_ERRORS
+
+#include "color.h"
+
+#ifdef SATTABLE_DEBUG
+# define MSG FPROPS_MSG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+#ifdef SATTABLE_ERRORS
+# define ERRMSG FPROPS_ERRMSG
+#else
+# define ERRMSG(ARGS...) ((void)0)
+#endif
+
+#define NY FPROPS_SATTABLE_NY
+
+/** nodes in the initial (uniform in u) table */
+#define SATTABLE_N0 9
+
+/** give up if the table needs more nodes than this */
+#define SATTABLE_NMAX 8192
+
+/** number of times an end of the range is pulled in if the exact routine fails there */
+#define SATTABLE_NENDTRY 8
+
+/**
+	Intervals are refined until the midpoint error is below tol divided by
+	this. The largest error between nodes can be up to about twice that at
+	the midpoint, where the fourth-order slopes are one-sided (at the ends of
+	the table) or have been limited for monotonicity.
+*/
+#define SATTABLE_SAFETY 4
+
+/*------------------------------------------------------------------------------
+  INTERPOLATION
+*/
+
+static double sattable_u(double T, const FluidData *D){
+	double x = 1. - T / D->T_c;
+	return x > 0 ? cbrt(x) : 0;
+}
+
+static double sattable_T(double u, const FluidData *D){
+	return D->T_c * (1. - u*u*u);
+}
+
+/** independent variable of curve k: x = T_c/T for ln(p_sat), u otherwise */
+#define COORD(T,K) ((K) == 0 ? (T)->x : (T)->u)
+
+/**
+	Slopes for a monotone piecewise-cubic Hermite fit to column k of the
+	n x NY arrays y and m, with nodes u (n >= 4).
+
+	Each slope is first taken from the cubic through the four nearest nodes,
+	so that the fit is fourth-order accurate; the plain PCHIP slopes (harmonic
+	means of the secants) would only give third order, and several times the
+	nodes for a given tolerance. The Fritsch-Carlson conditions are then
+	imposed on each interval so that the fit stays monotone wherever the data
+	are.
+*/
+static void sattable_slopes(unsigned n, const double *u, const double *y, double *m, int k){
+	unsigned i, j, l, j0;
+#define Y(I) y[(I)*NY + k]
+#define M(I) m[(I)*NY + k]
+	for(i = 0; i < n; ++i){
+		double d = 0;
+		j0 = i < 1 ? 0 : (i + 3 > n ? n - 4 : i - 1);
+		/* derivative at u[i] of the Lagrange cubic through nodes j0..j0+3 */
+		for(j = j0; j < j0 + 4; ++j){
+			double c;
+			if(j == i){
+				c = 0;
+				for(l = j0; l < j0 + 4; ++l){
+					if(l != i)c += 1. / (u[i] - u[l]);
+				}
+			}else{
+				c = 1;
+				for(l = j0; l < j0 + 4; ++l){
+					if(l != j)c /= u[j] - u[l];
+					if(l != j && l != i)c *= u[i] - u[l];
+				}
+			}
+			d += c * Y(j);
+		}
+		M(i) = d;
+	}
+	for(i = 0; i < n - 1; ++i){
+		double delta = (Y(i+1) - Y(i)) / (u[i+1] - u[i]);
+		double a, b, r;
+		if(delta == 0){
+			M(i) = M(i+1) = 0;
+			continue;
+		}
+		a = M(i) / delta;
+		b = M(i+1) / delta;
+		if(a < 0){M(i) = 0; a = 0;}
+		if(b < 0){M(i+1) = 0; b = 0;}
+		r = a*a + b*b;
+		if(r > 9){
+			r = 3. / sqrt(r);
+			M(i) = r * a * delta;
+			M(i+1) = r * b * delta;
+		}
+	}
+#undef Y
+#undef M
+}
+
+/**
+	Evaluate fitted curve k on interval i at v (x or u, according to k),
+	optionally with its slope.
+*/
+static double sattable_eval(const SatTable *t, unsigned i, int k, double v, double *dydv){
+	const double *c = COORD(t,k);
+	double v0 = c[i], h = c[i+1] - v0;
+	double s = (v - v0) / h, s1 = 1. - s;
+	double y0 = t->y[i*NY + k], y1 = t->y[(i+1)*NY + k];
+	double m0 = h * t->m[i*NY + k], m1 = h * t->m[(i+1)*NY + k];
+	if(dydv){
+		*dydv = ((6*s*s - 6*s)*(y0 - y1) + (3*s*s - 4*s + 1)*m0 + (3*s*s - 2*s)*m1) / h;
+	}
+	return (1 + 2*s)*s1*s1*y0 + s*s1*s1*m0 + s*s*(3 - 2*s)*y1 + s*s*(s - 1)*m1;
+}
+
+/**
+	Saturation state from the table on interval i at temperature T (given
+	as both u and x = T_c/T): ln(p_sat), ln(rho_f), ln(rho_g).
+*/
+static void sattable_state(const SatTable *t, unsigned i, double u, double x, double *lnp, double *lnrhof, double *lnrhog){
+	*lnp = sattable_eval(t, i, 0, x, NULL);
+	*lnrhof = sattable_eval(t, i, 1, u, NULL);
+	*lnrhog = *lnp + sattable_eval(t, i, 2, u, NULL);
+}
+
+/** interval containing u, which must lie within the table */
+static unsigned sattable_find_u(const SatTable *t, double u){
+	unsigned lo = 0, hi = t->n - 1;
+	while(hi - lo > 1){
+		unsigned mid = (lo + hi) / 2;
+		if(t->u[mid] > u)hi = mid;
+		else lo = mid;
+	}
+	return lo;
+}
+
+/**
+	Invert the ln(p_sat) fit, which decreases with x. lnp must lie within the
+	table. Safeguarded Newton iteration on the Hermite cubic of the interval.
+	@return x = T_c/T, with the interval in *ip.
+*/
+static double sattable_invert(const SatTable *t, double lnp, unsigned *ip){
+	unsigned lo = 0, hi = t->n - 1, i;
+	double a, b, x, f, df, dx;
+	int iter;
+	while(hi - lo > 1){
+		unsigned mid = (lo + hi) / 2;
+		if(t->y[mid*NY] < lnp)hi = mid;
+		else lo = mid;
+	}
+	i = lo;
+	a = t->x[i]; b = t->x[i+1];
+	f = t->y[i*NY] - t->y[(i+1)*NY];
+	x = f != 0 ? a + (b - a) * (t->y[i*NY] - lnp) / f : a;
+	for(iter = 0; iter < 60; ++iter){
+		f = sattable_eval(t, i, 0, x, &df) - lnp;
+		if(f == 0)break;
+		if(f > 0)a = x;
+		else b = x;
+		dx = df < 0 ? -f/df : 0;
+		if(df >= 0 || x + dx <= a || x + dx >= b){
+			dx = 0.5*(a + b) - x;
+		}
+		x += dx;
+		if(fabs(dx) <= 1e-15 * x || b - a <= 1e-15 * x)break;
+	}
+	*ip = i;
+	return x;
+}
+
+/*------------------------------------------------------------------------------
+  BUILDING THE TABLE
+*/
+
+/**
+	Exact saturation state at u, in the form that is tabulated: ln(p_sat),
+	ln(rho_f), ln(rho_g/p_sat).
+	@return 0 on success.
+*/
+static int sattable_exact(double u, double *y, const PureFluid *P){
+	FpropsError err = FPROPS_NO_ERROR;
+	double rhof, rhog, p;
+	p = P->sat_fn(sattable_T(u, P->data), &rhof, &rhog, P->data, &err);
+	if(err || !(p > 0) || !(rhof > 0) || !(rhog > 0) || !(rhof > rhog))return 1;
+	y[0] = log(p);
+	y[1] = log(rhof);
+	y[2] = log(rhog) - y[0];
+	return 0;
+}
+
+static double sattable_relerr(double y, double yexact){
+	return fabs(expm1(y - yexact));
+}
+
+#define MAXERR(E,EI) if((EI) > (E) || isnan(EI))(E) = (EI)
+
+/**
+	Largest relative error of the table at u, given the exact values ye
+	there: both the fitted values at u and the values at the T recovered by
+	inverting the exact ln(p_sat).
+*/
+static double sattable_check(const SatTable *t, unsigned i, double u, const double *ye, const FluidData *D){
+	double e = 0, ui, xi, lnp, lnrhof, lnrhog, T = sattable_T(u, D);
+	unsigned j;
+	sattable_state(t, i, u, D->T_c / T, &lnp, &lnrhof, &lnrhog);
+	MAXERR(e, sattable_relerr(lnp, ye[0]));
+	MAXERR(e, sattable_relerr(lnrhof, ye[1]));
+	MAXERR(e, sattable_relerr(lnrhog, ye[0] + ye[2]));
+	xi = sattable_invert(t, ye[0], &j);
+	MAXERR(e, fabs(D->T_c / xi - T) / T);
+	ui = sattable_u(D->T_c / xi, D);
+	sattable_state(t, j, ui, xi, &lnp, &lnrhof, &lnrhog);
+	MAXERR(e, sattable_relerr(lnrhof, ye[1]));
+	MAXERR(e, sattable_relerr(lnrhog, ye[0] + ye[2]));
+	return e;
+}
+
+static void sattable_clear(SatTable *t){
+	if(t->u)FPROPS_FREE(t->u);
+	if(t->x)FPROPS_FREE(t->x);
+	if(t->y)FPROPS_FREE(t->y);
+	if(t->m)FPROPS_FREE(t->m);
+	t->u = t->x = t->y = t->m = NULL;
+	t->n = 0;
+}
+
+/* set the x and slopes of the n nodes in t->u, t->y */
+static int sattable_fit(SatTable *t, unsigned n, const FluidData *D){
+	unsigned i;
+	int k;
+	if(t->x)FPROPS_FREE(t->x);
+	if(t->m)FPROPS_FREE(t->m);
+	t->n = n;
+	t->x = FPROPS_NEW_ARRAY(double, n);
+	t->m = FPROPS_NEW_ARRAY(double, n * NY);
+	if(!t->x || !t->m)return 1;
+	for(i = 0; i < n; ++i)t->x[i] = D->T_c / sattable_T(t->u[i], D);
+	for(k = 0; k < NY; ++k)sattable_slopes(n, COORD(t,k), t->y, t->m, k);
+	return 0;
+}
+
+/**
+	Build the table by repeated bisection (in u) of the intervals that fail
+	the midpoint check against tol/SATTABLE_SAFETY. The exact values at each midpoint are kept, so that
+	an interval that passes is never evaluated again, and a midpoint that
+	is split becomes a node at no extra cost.
+	@return 0 on success.
+*/
+static int sattable_build(SatTable *t, const PureFluid *P){
+	const FluidData *D = P->data;
+	double Tlo = D->T_t > 0 ? D->T_t : 0.2 * D->T_c;
+	double Thi = D->T_c * (1. - FPROPS_SATTABLE_DTC);
+	double ulo, uhi;
+	unsigned n, i, j, nmid, nsplit;
+	/* current intervals: midpoint exact values and whether they are known */
+	double *ym = NULL, *un = NULL, *yn = NULL, *ymn = NULL;
+	char *known = NULL, *knownn = NULL;
+	int k, ntry, round = 0;
+	double e;
+
+	sattable_clear(t);
+	t->nexact = 0;
+
+	/* make sure the exact routine works at both ends of the range */
+	t->u = FPROPS_NEW_ARRAY(double, SATTABLE_N0);
+	t->y = FPROPS_NEW_ARRAY(double, SATTABLE_N0 * NY);
+	if(!t->u || !t->y)goto fail;
+	for(ntry = 0; ; ++ntry){
+		ulo = sattable_u(Thi, D);
+		t->nexact++;
+		if(!sattable_exact(ulo, t->y, P))break;
+		if(ntry == SATTABLE_NENDTRY){
+			ERRMSG("Exact saturation failed at T = %f for '%s'",Thi,P->name);
+			goto fail;
+		}
+		Thi -= (D->T_c - Thi);
+	}
+	for(ntry = 0; ; ++ntry){
+		uhi = sattable_u(Tlo, D);
+		t->nexact++;
+		if(!sattable_exact(uhi, t->y + (SATTABLE_N0 - 1)*NY, P))break;
+		if(ntry == SATTABLE_NENDTRY){
+			ERRMSG("Exact saturation failed at T = %f for '%s'",Tlo,P->name);
+			goto fail;
+		}
+		Tlo += 0.05 * (Thi - Tlo);
+	}
+
+	/* initial nodes, uniform in u; stored in order of increasing u */
+	n = SATTABLE_N0;
+	for(i = 0; i < n; ++i){
+		t->u[i] = ulo + (uhi - ulo) * i / (n - 1);
+	}
+	t->u[n-1] = uhi;
+	for(i = 1; i < n - 1; ++i){
+		t->nexact++;
+		if(sattable_exact(t->u[i], t->y + i*NY, P)){
+			ERRMSG("Exact saturation failed at T = %f for '%s'",sattable_T(t->u[i],D),P->name);
+			goto fail;
+		}
+	}
+	ym = FPROPS_NEW_ARRAY(double, (n - 1) * NY);
+	known = FPROPS_NEW_ARRAY(char, n - 1);
+	if(!ym || !known)goto fail;
+	for(i = 0; i < n - 1; ++i)known[i] = 0;
+
+	while(1){
+		if(sattable_fit(t, n, D))goto fail;
+
+		/*
+			Exact values at the new midpoints. If the exact routine fails
+			(it can, close to the critical point), the table is cut short
+			at that interval, on whichever side leaves the most of it.
+		*/
+		for(i = 0; i < n - 1; ++i){
+			if(known[i])continue;
+			t->nexact++;
+			if(sattable_exact(0.5*(t->u[i] + t->u[i+1]), ym + i*NY, P)){
+				ERRMSG("Exact saturation failed at T = %f for '%s', truncating table"
+					,sattable_T(0.5*(t->u[i] + t->u[i+1]),D),P->name
+				);
+				if(2*i < n - 1){
+					j = i + 1;
+					memmove(t->u, t->u + j, (n - j) * sizeof(double));
+					memmove(t->y, t->y + j*NY, (n - j) * NY * sizeof(double));
+					memmove(ym, ym + j*NY, (n - 1 - j) * NY * sizeof(double));
+					memmove(known, known + j, n - 1 - j);
+					n -= j;
+				}else{
+					n = i + 1;
+				}
+				if(n < 4)goto fail;
+				break;
+			}
+			known[i] = 1;
+		}
+		if(n != t->n)continue;
+
+		/* check every interval; mark the failures for splitting */
+		t->err = 0;
+		nsplit = 0;
+		for(i = 0; i < n - 1; ++i){
+			e = sattable_check(t, i, 0.5*(t->u[i] + t->u[i+1]), ym + i*NY, D);
+			MAXERR(t->err, e);
+			if(!(e <= t->tol / SATTABLE_SAFETY)){
+				known[i] = 2;
+				nsplit++;
+			}
+		}
+		MSG("Round %d: %u nodes, %u intervals to split, max err %e",round,n,nsplit,t->err);
+		if(!nsplit)break;
+		if(n + nsplit > SATTABLE_NMAX){
+			ERRMSG("Saturation table for '%s' would need more than %d nodes for tol = %e"
+				" (max err %e with %u nodes)",P->name,SATTABLE_NMAX,t->tol,t->err,n
+			);
+			goto fail;
+		}
+
+		/* split: failed midpoints become nodes */
+		nmid = n - 1 + nsplit;
+		un = FPROPS_NEW_ARRAY(double, n + nsplit);
+		yn = FPROPS_NEW_ARRAY(double, (n + nsplit) * NY);
+		ymn = FPROPS_NEW_ARRAY(double, nmid * NY);
+		knownn = FPROPS_NEW_ARRAY(char, nmid);
+		if(!un || !yn || !ymn || !knownn)goto fail;
+		for(i = 0, j = 0; i < n - 1; ++i){
+			un[j] = t->u[i];
+			for(k = 0; k < NY; ++k)yn[j*NY + k] = t->y[i*NY + k];
+			if(known[i] == 2){
+				knownn[j++] = 0;
+				un[j] = 0.5*(t->u[i] + t->u[i+1]);
+				for(k = 0; k < NY; ++k)yn[j*NY + k] = ym[i*NY + k];
+				knownn[j++] = 0;
+			}else{
+				for(k = 0; k < NY; ++k)ymn[j*NY + k] = ym[i*NY + k];
+				knownn[j++] = 1;
+			}
+		}
+		un[j] = t->u[n-1];
+		for(k = 0; k < NY; ++k)yn[j*NY + k] = t->y[(n-1)*NY + k];
+		n += nsplit;
+
+		FPROPS_FREE(t->u); t->u = un; un = NULL;
+		FPROPS_FREE(t->y); t->y = yn; yn = NULL;
+		FPROPS_FREE(ym); ym = ymn; ymn = NULL;
+		FPROPS_FREE(known); known = knownn; knownn = NULL;
+		round++;
+	}
+
+	FPROPS_FREE(ym);
+	FPROPS_FREE(known);
+	t->T_min = sattable_T(t->u[n-1], D);
+	t->T_max = sattable_T(t->u[0], D);
+	t->lnp_min = t->y[(n-1)*NY];
+	t->lnp_max = t->y[0];
+	MSG("Saturation table for '%s': %u nodes, T = %f..%f K, max err %e, %u exact evaluations"
+		,P->name,n,t->T_min,t->T_max,t->err,t->nexact
+	);
+	return 0;
+
+fail:
+	if(ym)FPROPS_FREE(ym);
+	if(known)FPROPS_FREE(known);
+	if(un)FPROPS_FREE(un);
+	if(yn)FPROPS_FREE(yn);
+	if(ymn)FPROPS_FREE(ymn);
+	if(knownn)FPROPS_FREE(knownn);
+	sattable_clear(t);
+	return 1;
+}
+
+/*------------------------------------------------------------------------------
+  PUBLIC FUNCTIONS
+*/
+
+int fprops_sat_table_enable(const PureFluid *P, double tol){
+	SatTable *t;
+	switch(P->type){
+	case FPROPS_HELMHOLTZ:
+	case FPROPS_PENGROB:
+		break;
+	default:
+		ERRMSG("Fluid '%s' (type %d) has no saturation curve",P->name,P->type);
+		return 1;
+	}
+	if(!(tol > 0)){
+		ERRMSG("Invalid tolerance %e",tol);
+		return 1;
+	}
+	fprops_sat_table_disable(P);
+	t = FPROPS_NEW(SatTable);
+	if(!t)return 1;
+	t->state = FPROPS_SATTABLE_EMPTY;
+	t->polish = tol < FPROPS_SATTABLE_TOL_MIN;
+	t->tol = t->polish ? FPROPS_SATTABLE_TOL_MIN : tol;
+	t->n = 0;
+	t->u = t->x = t->y = t->m = NULL;
+	t->T_min = t->T_max = 0;
+	t->lnp_min = t->lnp_max = 0;
+	t->err = 0;
+	t->nexact = 0;
+	P->data->sat = t;
+	return 0;
+}
+
+void fprops_sat_table_disable(const PureFluid *P){
+	SatTable *t = P->data->sat;
+	if(t == NULL)return;
+	sattable_clear(t);
+	FPROPS_FREE(t);
+	P->data->sat = NULL;
+}
+
+const SatTable *fprops_sat_table(const PureFluid *P){
+	SatTable *t = P->data->sat;
+	if(t == NULL)return NULL;
+	if(t->state == FPROPS_SATTABLE_EMPTY){
+		if(sattable_build(t, P)){
+			ERRMSG("Unable to build saturation table for '%s', using exact routines",P->name);
+			t->state = FPROPS_SATTABLE_FAILED;
+		}else{
+			t->state = FPROPS_SATTABLE_READY;
+		}
+	}
+	return t->state == FPROPS_SATTABLE_READY ? t : NULL;
+}
+
+int fprops_sat_table_T(double T, double *p_sat, double *rho_f, double *rho_g, const PureFluid *P){
+	const SatTable *t = fprops_sat_table(P);
+	double u, lnp, lnrhof, lnrhog;
+	if(t == NULL || t->polish)return 1;
+	if(!(T >= t->T_min && T <= t->T_max))return 1;
+	u = sattable_u(T, P->data);
+	sattable_state(t, sattable_find_u(t, u), u, P->data->T_c / T, &lnp, &lnrhof, &lnrhog);
+	*p_sat = exp(lnp);
+	*rho_f = exp(lnrhof);
+	*rho_g = exp(lnrhog);
+	return 0;
+}
+
+int fprops_sat_table_p(double p, double *T_sat, double *rho_f, double *rho_g, const PureFluid *P){
+	const SatTable *t = fprops_sat_table(P);
+	const FluidData *D = P->data;
+	double lnp = log(p), lnrhof, lnrhog, x, T, dx, f, dydx, p1, rhof, rhog;
+	unsigned i;
+	int iter;
+	if(t == NULL)return 1;
+	if(!(lnp >= t->lnp_min && lnp <= t->lnp_max))return 1;
+	x = sattable_invert(t, lnp, &i);
+	T = D->T_c / x;
+	if(!t->polish){
+		sattable_state(t, i, sattable_u(T, D), x, &lnp, &lnrhof, &lnrhog);
+		*T_sat = T;
+		*rho_f = exp(lnrhof);
+		*rho_g = exp(lnrhog);
+		return 0;
+	}
+
+	/*
+		Newton iteration on ln(p_sat) versus x = T_c/T, starting from the
+		table and using the slope of the fit. The starting point is within
+		FPROPS_SATTABLE_TOL_MIN so this usually takes two exact evaluations,
+		where the Brent solver in fprops_sat_p takes ten or more.
+	*/
+	for(iter = 0; iter < 10; ++iter){
+		FpropsError err = FPROPS_NO_ERROR;
+		p1 = P->sat_fn(T, &rhof, &rhog, D, &err);
+		if(err || !(p1 > 0))return 1;
+		f = log(p1) - lnp;
+		if(fabs(f) <= 1e-13){
+			*T_sat = T;
+			*rho_f = rhof;
+			*rho_g = rhog;
+			return 0;
+		}
+		if(x < t->x[0] || x > t->x[t->n - 1])return 1;
+		sattable_eval(t, sattable_find_u(t, sattable_u(T, D)), 0, x, &dydx);
+		dx = -f / dydx;
+		if(fabs(dx) <= 1e-15 * x){
+			/* converged to roundoff in T but not in p; accept */
+			*T_sat = T;
+			*rho_f = rhof;
+			*rho_g = rhog;
+			return 0;
+		}
+		x += dx;
+		T = D->T_c / x;
+	}
+	MSG("Polishing did not converge at p = %f for '%s'",p,P->name);
+	return 1;
+}
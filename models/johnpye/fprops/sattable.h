@@ -0,0 +1,128 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Tabulated saturation curve for a pure fluid, as an optional fast path for
+	fprops_sat_T and fprops_sat_p.
+
+	Once enabled with fprops_sat_table_enable, the table is built on the first
+	saturation query for the fluid. It holds monotone piecewise-cubic (PCHIP)
+	fits, on a common set of temperature nodes, of
+		- ln(p_sat) against x = T_c/T, which is close to linear (Clapeyron);
+		- ln(rho_f) and ln(rho_g/p_sat) against u = (1 - T/T_c)^(1/3), which
+		  straightens out their critical-point behaviour, while rho_g/p_sat
+		  stays smooth in the dilute vapour at low T.
+	T_sat(p) is found by inverting the ln(p_sat) fit, which is strictly
+	monotone, so no separate fit is needed.
+
+	Nodes are added by bisection until, at the midpoint of every interval, the
+	fitted p_sat, rho_f and rho_g (and the T, rho_f, rho_g obtained back from
+	the exact p_sat there) agree with the exact saturation routine to within
+	a quarter of the requested relative tolerance. The error is only checked
+	at the midpoints, and can be up to about twice as large elsewhere in the
+	interval (near the ends of the table, and where the slopes are limited
+	for monotonicity), so the margin keeps it within the tolerance
+	everywhere; test/sattable.c samples between every pair of nodes to check
+	this.
+
+	The table can be no more accurate than the exact routine it is fitted to.
+	The Peng-Robinson saturation routine only converges the fugacity ratio to
+	1e-7, which leaves errors of a few times 1e-6 in the densities close to
+	the critical point; for those fluids a tighter tolerance makes the build
+	fail, and the exact routines are used instead.
+
+	The table covers T_t (or 0.2 T_c if T_t is not known) up to
+	(1 - FPROPS_SATTABLE_DTC)*T_c. Queries outside that range, including the
+	near-critical region, fall through to the exact routines.
+
+	If a tolerance tighter than FPROPS_SATTABLE_TOL_MIN is requested, the table
+	is built to FPROPS_SATTABLE_TOL_MIN and used as a starting point only:
+	fprops_sat_p then does a Newton iteration on ln(p) versus 1/T, with each
+	step costing one exact fprops_sat_T, and fprops_sat_T is exact.
+*/
+
+#ifndef FPROPS_SATTABLE_H
+#define FPROPS_SATTABLE_H
+
+#include "rundata.h"
+
+/** tightest tolerance the table itself is built to */
+#define FPROPS_SATTABLE_TOL_MIN 1e-10
+
+/** fraction of T_c just below the critical point not covered by the table */
+#define FPROPS_SATTABLE_DTC 1e-3
+
+/** number of fitted curves: ln(p_sat), ln(rho_f), ln(rho_g/p_sat) */
+#define FPROPS_SATTABLE_NY 3
+
+typedef enum{
+	FPROPS_SATTABLE_EMPTY = 0 /**< enabled, not yet built */
+	,FPROPS_SATTABLE_READY    /**< built, in use */
+	,FPROPS_SATTABLE_FAILED   /**< build failed, exact routines are used */
+} SatTableState;
+
+struct SatTable_struct{
+	SatTableState state;
+	double tol;     /**< relative tolerance the table is built to */
+	int polish;     /**< refine table results with the exact routines */
+	unsigned n;     /**< number of nodes */
+	double *u;      /**< nodes, u = (1 - T/T_c)^(1/3), increasing */
+	double *x;      /**< nodes, x = T_c/T */
+	double *y;      /**< n x FPROPS_SATTABLE_NY values at the nodes */
+	double *m;      /**< n x FPROPS_SATTABLE_NY slopes, dy/dx or dy/du */
+	double T_min, T_max;   /**< temperature range covered */
+	double lnp_min, lnp_max; /**< ln(p_sat) range covered */
+	double err;     /**< largest relative error seen at the midpoint checks */
+	unsigned nexact; /**< exact saturation evaluations used in the build */
+};
+
+/**
+	Enable the saturation table for a fluid. The table is built lazily, on
+	the first call to fprops_sat_T or fprops_sat_p that needs it. Calling
+	again with a different tolerance discards any existing table.
+
+	@param tol relative tolerance for p_sat, rho_f, rho_g and T_sat.
+	@return 0 on success, non-zero if the fluid has no saturation curve or
+	tol is not positive.
+*/
+int fprops_sat_table_enable(const PureFluid *P, double tol);
+
+/** Discard the saturation table, reverting to the exact routines. */
+void fprops_sat_table_disable(const PureFluid *P);
+
+/**
+	Look up saturation conditions at temperature T.
+	@return 0 if the results were set from the table, non-zero if the caller
+	should use the exact routine (table disabled, polishing, or T out of range).
+*/
+int fprops_sat_table_T(double T, double *p_sat, double *rho_f, double *rho_g, const PureFluid *P);
+
+/**
+	Look up saturation conditions at pressure p, polishing the result if the
+	table was enabled with a tolerance below FPROPS_SATTABLE_TOL_MIN.
+	@return 0 if the results were set, non-zero if the caller should use the
+	exact routine.
+*/
+int fprops_sat_table_p(double p, double *T_sat, double *rho_f, double *rho_g, const PureFluid *P);
+
+/**
+	Return the table for a fluid, building it first if necessary, or NULL if
+	it is not enabled or could not be built. Useful for reporting the size and
+	error of the table.
+*/
+const SatTable *fprops_sat_table(const PureFluid *P);
+
+#endif
+
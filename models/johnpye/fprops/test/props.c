@@ -0,0 +1,183 @@
+/* test the single-sweep evaluation of the residual helmholtz function and
+its derivatives (helm_resid_all), and the 'full state' fprops_props, against
+the individual property functions */
+
+#include "../fluids.h"
+#include "../fprops.h"
+#include "../helmholtz_impl.h"
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+#include "../color.h"
+
+#define MSG(FMT, ...) \
+	color_on(stderr,ASC_FG_BRIGHTRED);\
+	fprintf(stderr,"%s:%d: ",__FILE__,__LINE__);\
+	color_on(stderr,ASC_FG_BRIGHTBLUE);\
+	fprintf(stderr,"%s: ",__func__);\
+	color_off(stderr);\
+	fprintf(stderr,FMT "\n",##__VA_ARGS__)
+
+#define ERRMSG(STR,...) \
+	color_on(stderr,ASC_FG_BRIGHTRED);\
+	fprintf(stderr,"ERROR:");\
+	color_off(stderr);\
+	fprintf(stderr," %s:%d:" STR "\n", __func__, __LINE__ ,##__VA_ARGS__)
+
+/* number of (T,rho) test points per fluid */
+#define NP 400
+
+/* the fused and individual evaluations add up the same terms in a different
+order, so they differ by rounding, magnified where the terms cancel */
+#define TOL 1e-9
+
+/* compare A with B relative to the scale S */
+#define CHECK(NAME,A,B,S) \
+	if(!(fabs((A) - (B)) <= TOL * fabs((double)(S))) && !(isnan(A) && isnan(B))){\
+		ERRMSG("'%s': %s = %.12e, expected %.12e (T = %f K, rho = %f kg/m3)"\
+			,name,NAME,(double)(A),(double)(B),T,rho);\
+		nfail++;\
+	}
+
+/**
+	Compare helm_resid_all with the individual helm_resid_* functions.
+	@return number of failures
+*/
+static int test_resid(const char *name, const PureFluid *P){
+	const HelmholtzRunData *H = P->data->corr.helm;
+	HelmholtzResid r;
+	double T, rho, tau, delta;
+	int i, nfail = 0;
+
+	for(i = 0; i < NP; ++i){
+		T = P->data->T_c * (0.5 + 2.5 * fmod(i * 0.6180339887498949, 1.));
+		rho = P->data->rho_c * (1e-4 + 3. * fmod(0.5 + i * 0.4142135623730950, 1.));
+		tau = H->T_star / T;
+		delta = rho / H->rho_star;
+
+		helm_resid_all(tau, delta, H, &r);
+		/* the derivatives can all be small together, so scale by 1 + |phir| */
+		double sc = 1 + fabs(r.phi);
+		CHECK("phir", r.phi, helm_resid(tau,delta,H), sc);
+		CHECK("phir_del", r.del, delta*helm_resid_del(tau,delta,H), sc);
+		CHECK("phir_tau", r.tau, tau*helm_resid_tau(tau,delta,H), sc);
+		CHECK("phir_deldel", r.deldel, SQ(delta)*helm_resid_deldel(tau,delta,H), sc);
+		CHECK("phir_deltau", r.deltau, delta*tau*helm_resid_deltau(tau,delta,H), sc);
+		CHECK("phir_tautau", r.tautau, SQ(tau)*helm_resid_tautau(tau,delta,H), sc);
+	}
+
+	/* the zero-density limit stays finite */
+	helm_resid_all(1., 0., H, &r);
+	assert(r.phi == 0 && r.del == 0 && r.deldel == 0);
+	return nfail;
+}
+
+/**
+	Compare fprops_props with the individual fprops_* functions, at points
+	inside and outside the saturation dome.
+	@return number of failures
+*/
+static int test_props(const char *name, const char *corrtype){
+	const PureFluid *P = fprops_fluid(name,corrtype,NULL);
+	FpropsError err = FPROPS_NO_ERROR;
+	FluidProps F;
+	FluidState2 S;
+	double T, rho, x;
+	int i, nfail = 0, ndome = 0;
+	clock_t c0, c1, c2;
+
+	assert(P);
+	if(P->type == FPROPS_HELMHOLTZ){
+		nfail += test_resid(name, P);
+	}
+
+	for(i = 0; i < NP; ++i){
+		T = P->data->T_c * (0.6 + 0.9 * fmod(i * 0.6180339887498949, 1.));
+		if(T < P->data->T_t)T = P->data->T_t + 1;
+		rho = P->data->rho_c * (1e-3 + 2.5 * fmod(0.5 + i * 0.4142135623730950, 1.));
+		S = fprops_set_Trho(T, rho, P, &err);
+		err = FPROPS_NO_ERROR;
+		fprops_props(S, &F, &err);
+		if(err){
+			/* eg outside the range where the saturation curve can be solved */
+			err = FPROPS_NO_ERROR;
+			continue;
+		}
+		assert(F.T == T && F.rho == rho);
+
+#define PROP(VAR) CHECK(#VAR, F.VAR, fprops_##VAR(S,&err), fprops_##VAR(S,&err))
+		PROP(p); PROP(u); PROP(h); PROP(s); PROP(a); PROP(g);
+		PROP(alphap); PROP(betap); PROP(dpdrho_T);
+#undef PROP
+		err = FPROPS_NO_ERROR;
+		if(T < P->data->T_c){
+			x = fprops_x(S,&err);
+			assert(!err);
+			CHECK("x", F.x, x, 1);
+		}else{
+			assert(isnan(F.x));
+		}
+		if(!isnan(F.cp)){
+			CHECK("cp", F.cp, fprops_cp(S,&err), F.cp);
+			CHECK("cv", F.cv, fprops_cv(S,&err), F.cv);
+			CHECK("w", F.w, fprops_w(S,&err), F.w);
+			assert(!err);
+			/* dp/dT from the IAPWS AN3 relation */
+			CHECK("dpdT_rho", F.dpdT_rho, F.alphap * F.p, F.dpdT_rho);
+		}else{
+			/* in the dome, the individual functions report these as undefined */
+			fprops_cp(S,&err);
+			assert(err == FPROPS_VALUE_UNDEFINED);
+			err = FPROPS_NO_ERROR;
+			ndome++;
+		}
+	}
+	MSG("'%s' (%s): %d points, %d inside the saturation dome",name,corrtype,NP,ndome);
+
+	/* timing of fprops_props vs the individual functions, at supercritical
+	states so that no saturation calculations are involved */
+	if(!P->props_fn){
+		fprops_fluid_destroy((PureFluid *)P);
+		return nfail;
+	}
+	c0 = clock();
+	for(i = 0; i < NP; ++i){
+		S = fprops_set_Trho(P->data->T_c*(1.1 + 0.001*i), P->data->rho_c*0.5, P, &err);
+		fprops_props(S, &F, &err);
+	}
+	c1 = clock();
+	for(i = 0; i < NP; ++i){
+		S = fprops_set_Trho(P->data->T_c*(1.1 + 0.001*i), P->data->rho_c*0.5, P, &err);
+		F.p = fprops_p(S,&err); F.h = fprops_h(S,&err); F.s = fprops_s(S,&err);
+		F.cp = fprops_cp(S,&err); F.w = fprops_w(S,&err);
+	}
+	c2 = clock();
+	MSG("'%s': fprops_props %.3f us, p+h+s+cp+w %.3f us per state",name
+		,1e6*(c1-c0)/CLOCKS_PER_SEC/NP,1e6*(c2-c1)/CLOCKS_PER_SEC/NP
+	);
+
+	fprops_fluid_destroy((PureFluid *)P);
+	return nfail;
+}
+
+int main(void){
+	int nfail = 0;
+
+	nfail += test_props("water","helmholtz");
+	nfail += test_props("carbondioxide","helmholtz");
+	nfail += test_props("nitrogen","helmholtz");
+	/* no props_fn, so fprops_props falls back to the individual functions */
+	nfail += test_props("toluene","pengrob");
+
+	if(nfail){
+		ERRMSG("There were %d failures",nfail);
+		return nfail;
+	}
+
+	fprintf(stderr,"\n");
+	color_on(stderr,ASC_FG_BRIGHTGREEN);
+	fprintf(stderr,"SUCCESS (%s)",__FILE__);
+	color_off(stderr);
+	fprintf(stderr,"\n");
+	return 0;
+}
@@ -0,0 +1,184 @@
+/* test the tabulated saturation curve (sattable.c) against the exact
+saturation routines, for a few fluids and tolerances */
+
+#include "../fluids.h"
+#include "../fprops.h"
+#include "../sat.h"
+#include "../sattable.h"
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+#include "../color.h"
+
+#define MSG(FMT, ...) \
+	color_on(stderr,ASC_FG_BRIGHTRED);\
+	fprintf(stderr,"%s:%d: ",__FILE__,__LINE__);\
+	color_on(stderr,ASC_FG_BRIGHTBLUE);\
+	fprintf(stderr,"%s: ",__func__);\
+	color_off(stderr);\
+	fprintf(stderr,FMT "\n",##__VA_ARGS__)
+
+#define ERRMSG(STR,...) \
+	color_on(stderr,ASC_FG_BRIGHTRED);\
+	fprintf(stderr,"ERROR:");\
+	color_off(stderr);\
+	fprintf(stderr," %s:%d:" STR "\n", __func__, __LINE__ ,##__VA_ARGS__)
+
+/* number of test temperatures per fluid */
+#define NT 997
+
+/* number of test temperatures between each pair of nodes */
+#define NSUB 8
+
+#define RELERR(A,B) fabs(((A) - (B))/(B))
+
+/**
+	Largest relative error of table lookups at T, in both directions:
+	sat_T(T), and sat_p(p_sat(T)).
+*/
+static double test_error(const PureFluid *P, const SatTable *t, double T){
+	FpropsError err = FPROPS_NO_ERROR;
+	double p, rhof, rhog, pe, rhofe, rhoge, Tp, e;
+
+	pe = P->sat_fn(T, &rhofe, &rhoge, P->data, &err);
+	assert(!err);
+
+	fprops_sat_T(T, &p, &rhof, &rhog, P, &err);
+	assert(!err);
+	if(t->polish){
+		/* sat_T is exact when polishing */
+		assert(p == pe && rhof == rhofe && rhog == rhoge);
+	}
+	e = fmax(RELERR(p,pe), fmax(RELERR(rhof,rhofe), RELERR(rhog,rhoge)));
+
+	fprops_sat_p(pe, &Tp, &rhof, &rhog, P, &err);
+	assert(!err);
+	return fmax(e, fmax(RELERR(Tp,T), fmax(RELERR(rhof,rhofe), RELERR(rhog,rhoge))));
+}
+
+/**
+	Compare table lookups with the exact routine at NT temperatures spread
+	(irregularly, so as not to hit nodes) over the table range, and at NSUB
+	points between each pair of nodes, where the error is largest.
+	@return number of failures
+*/
+static int test_fluid(const char *name, const char *corrtype, double tol){
+	const PureFluid *P = fprops_fluid(name,corrtype,NULL);
+	const SatTable *t;
+	FpropsError err = FPROPS_NO_ERROR;
+	double T, p, rhof, rhog, pe, rhofe, rhoge, emax = 0, e, etol;
+	unsigned i, j;
+	int nfail = 0;
+	clock_t c0, c1, c2;
+
+	assert(P);
+	assert(0 == fprops_sat_table_enable(P, tol));
+	c0 = clock();
+	t = fprops_sat_table(P);
+	c1 = clock();
+	if(!t){
+		ERRMSG("Failed to build table for '%s' (%s) with tol = %e",name,corrtype,tol);
+		return 1;
+	}
+	MSG("'%s' (%s), tol = %.0e: %u nodes, %u exact evaluations, %.1f ms, T = %.3f..%.3f K, midpoint err %.2e"
+		,name,corrtype,tol,t->n,t->nexact,1e3*(c1-c0)/CLOCKS_PER_SEC,t->T_min,t->T_max,t->err
+	);
+	assert(t->err <= t->tol);
+
+	/* polishing is only converged to about 1e-13 in p */
+	etol = fmax(tol, 1e-11);
+
+	for(i = 0; i < NT; ++i){
+		double s = fmod(0.5 + i * 0.6180339887498949, 1.);
+		T = t->T_min + s * (t->T_max - t->T_min);
+		e = test_error(P, t, T);
+		if(e > emax)emax = e;
+		if(e > etol){
+			ERRMSG("'%s': error %e at T = %f K",name,e,T);
+			nfail++;
+		}
+	}
+	MSG("'%s': max error %.2e over %d points",name,emax,NT);
+
+	if(!t->polish){
+		emax = 0;
+		for(i = 0; i < t->n - 1; ++i){
+			for(j = 1; j <= NSUB; ++j){
+				/* nodes are uniform in u, so sample uniformly in u too */
+				double u = t->u[i] + (t->u[i+1] - t->u[i]) * j / (NSUB + 1);
+				T = P->data->T_c * (1. - u*u*u);
+				e = test_error(P, t, T);
+				if(e > emax)emax = e;
+				if(e > etol){
+					ERRMSG("'%s': error %e at T = %f K, between nodes %u and %u",name,e,T,i,i+1);
+					nfail++;
+				}
+			}
+		}
+		MSG("'%s': max error %.2e over %d points between each of %u nodes",name,emax,NSUB,t->n);
+	}
+
+	/* timing of table vs exact lookups */
+	if(!t->polish){
+		c0 = clock();
+		for(i = 0; i < NT; ++i){
+			T = t->T_min + (i + 0.5) / NT * (t->T_max - t->T_min);
+			fprops_sat_T(T, &p, &rhof, &rhog, P, &err);
+		}
+		c1 = clock();
+		for(i = 0; i < NT; ++i){
+			T = t->T_min + (i + 0.5) / NT * (t->T_max - t->T_min);
+			p = P->sat_fn(T, &rhof, &rhog, P->data, &err);
+		}
+		c2 = clock();
+		MSG("'%s': sat_T table %.3f us, exact %.3f us per call",name
+			,1e6*(c1-c0)/CLOCKS_PER_SEC/NT,1e6*(c2-c1)/CLOCKS_PER_SEC/NT
+		);
+	}
+
+	/* outside the table range we get the exact result */
+	T = 0.5*(t->T_max + P->data->T_c);
+	pe = P->sat_fn(T, &rhofe, &rhoge, P->data, &err);
+	if(!err){
+		fprops_sat_T(T, &p, &rhof, &rhog, P, &err);
+		assert(p == pe && rhof == rhofe && rhog == rhoge);
+	}
+	err = FPROPS_NO_ERROR;
+
+	fprops_fluid_destroy((PureFluid *)P);
+	return nfail;
+}
+
+int main(void){
+	int nfail = 0;
+	const PureFluid *P;
+
+	nfail += test_fluid("water","helmholtz",1e-6);
+	nfail += test_fluid("carbondioxide","helmholtz",1e-8);
+	nfail += test_fluid("ethanol","helmholtz",1e-5);
+	/* the Peng-Robinson saturation routine is only good to a few times 1e-6
+	close to the critical point, see sattable.h */
+	nfail += test_fluid("toluene","pengrob",1e-5);
+
+	/* polishing to full accuracy */
+	nfail += test_fluid("water","helmholtz",1e-14);
+
+	/* no saturation curve for an ideal gas */
+	P = fprops_fluid("nitrogen","ideal",NULL);
+	if(P){
+		assert(0 != fprops_sat_table_enable(P, 1e-6));
+		assert(NULL == fprops_sat_table(P));
+	}
+
+	if(nfail){
+		ERRMSG("There were %d failures",nfail);
+		return nfail;
+	}
+
+	fprintf(stderr,"\n");
+	color_on(stderr,ASC_FG_BRIGHTGREEN);
+	fprintf(stderr,"SUCCESS (%s)",__FILE__);
+	color_off(stderr);
+	fprintf(stderr,"\n");
+	return 0;
+}
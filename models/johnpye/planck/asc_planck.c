@@ -63,6 +63,9 @@ ASC_EXPORT int planck_register(){
 
 	CALCFN(planck,2,1);
 
+	/* planck_calc keeps no state, so finite differences can run concurrently */
+	result += SetBlackBoxReentrant("planck",1);
+
 #undef CALCFN
 
 	if(result){
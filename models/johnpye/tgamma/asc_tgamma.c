@@ -55,6 +55,9 @@ ASC_EXPORT int tgamma_register(){
 
 	CALCFN(tgamma,1,1);
 
+	/* tgamma_calc keeps no state, so finite differences can run concurrently */
+	result += SetBlackBoxReentrant("tgamma",1);
+
 #undef CALCFN
 
 	if(result){
@@ -412,11 +412,10 @@ static void integrator_dopri5_fex(
 		unsigned n_eq, double t, double *y, double *ydot
 		, void *user_data
 ){
-	slv_status_t status;
 	IntegratorSystem *blsys = (IntegratorSystem *)user_data;
 
 	int i;
-	unsigned long res;
+	int res;
 
 	//CONSOLE_DEBUG("Calling for a function evaluation");
 
@@ -427,25 +426,14 @@ static void integrator_dopri5_fex(
 
 	asc_assert(blsys->system);
 
-    slv_resolve(blsys->system);
-
-	if((res = slv_solve(blsys->system))){
-		CONSOLE_DEBUG("solver returns error %ld",res);
-	}
-
-	slv_get_status(blsys->system, &status);
-
+	/* solve for the derivatives, warm-started from the previous stages */
+	res = integrator_solve_algebraic(blsys, 0);
 
 	if(slv_check_bounds(blsys->system,0,-1,"")){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Variables went outside boundaries...");
 		// TODO relay that system has gone out of bounds
 	}
 
-	/* pass the NLA solver status to the integrator */
-	res = integrator_checkstatus(status);
-
-	integrator_output_write(blsys);
-
   	if(res){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Failed to solve for derivatives (%d)",res);
 #if 1
@@ -718,7 +706,10 @@ int integrator_dopri5_solve(IntegratorSystem *blsys
 			);
 
 # ifdef ASC_SIGNAL_TRAPS
+			Asc_SignalFPECheck();
 		}else{
+			Asc_SignalHandlerPopDefault(SIGFPE);
+			Asc_SignalHandlerPopDefault(SIGINT);
 			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Integration terminated due to float error in DOPRI5 call.");
 			//dopri5_free_mem(y,reltol,abtol,rwork,iwork,obs,dydx);
 			DOPRI5_FREE;
@@ -36,14 +36,18 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <memory.h>
+#include <ascend/general/platform.h>
 #include "dopri5.h"
 
-
-static long      nfcn, nstep, naccpt, nrejct;
-static double    hout, xold, xout;
-static unsigned  nrds, *indir;
-static double    *yy1, *k1, *k2, *k3, *k4, *k5, *k6, *ysti;
-static double    *rcont1, *rcont2, *rcont3, *rcont4, *rcont5;
+/*
+	State of the integration in progress. Each thread has its own, so that
+	separate systems can be integrated on separate threads at once (ASCEND).
+*/
+static ASC_THREAD_LOCAL long      nfcn, nstep, naccpt, nrejct;
+static ASC_THREAD_LOCAL double    hout, xold, xout;
+static ASC_THREAD_LOCAL unsigned  nrds, *indir;
+static ASC_THREAD_LOCAL double    *yy1, *k1, *k2, *k3, *k4, *k5, *k6, *ysti;
+static ASC_THREAD_LOCAL double    *rcont1, *rcont2, *rcont3, *rcont4, *rcont5;
 
 
 long nfcnRead (void){
@@ -131,11 +131,13 @@ static void integrator_ida_create(IntegratorSystem *integ) {
 	enginedata = ASC_NEW(IntegratorIdaData);
 	CONSOLE_DEBUG("enginedata = %p",enginedata);
 	enginedata->rellist = NULL;
+	enginedata->relok = NULL;
 	enginedata->safeeval = 0;
 	enginedata->vfilter.matchbits = VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE
 			| VAR_FIXED;
 	enginedata->vfilter.matchvalue = VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE | 0;
 	enginedata->pfree = NULL;
+	enginedata->sjac = NULL;
 
 	enginedata->rfilter.matchbits = REL_EQUALITY | REL_INCLUDED | REL_ACTIVE;
 	enginedata->rfilter.matchvalue = REL_EQUALITY | REL_INCLUDED | REL_ACTIVE;
@@ -167,6 +169,8 @@ static void integrator_ida_free(void *enginedata) {
 	}
 
 	ASC_FREE(d->rellist);
+	if(d->relok)ASC_FREE(d->relok);
+	integrator_ida_sjac_destroy(d->sjac);
 
 #ifdef DESTROY_DEBUG
 	CONSOLE_DEBUG("Now destroying the enginedata");
@@ -294,7 +298,8 @@ static int integrator_ida_params_default(IntegratorSystem *integ) {
 		,(SlvParameterInitChar) { {"linsolver"
 				,"Linear solver",1
 				,"See IDA manual, section 5.5.3. Choose 'ASCEND' to use the linsolqr"
-				" direct linear solver bundled with ASCEND, 'DENSE' to use the dense"
+				" sparse direct linear solver bundled with ASCEND (recommended for"
+				" large problems), 'DENSE' to use the dense"
 				" solver bundled with IDA, or one of the Krylov solvers SPGMR, SPBCG"
 				" or SPTFQMR (which still need preconditioners to be implemented"
 				" before they can be very useful."
@@ -369,9 +374,18 @@ int ida_load_rellist(IntegratorSystem *integ) {
 		ASC_FREE(enginedata->rellist);
 		enginedata->rellist = NULL;
 	}
+	if (enginedata->relok != NULL) {
+		ASC_FREE(enginedata->relok);
+		enginedata->relok = NULL;
+	}
+
+	/* sparse jacobian structure will be rebuilt for the new rellist */
+	integrator_ida_sjac_destroy(enginedata->sjac);
+	enginedata->sjac = NULL;
 
 	enginedata->rellist
 			= ASC_NEW_ARRAY(struct rel_relation *, n_active_rels);
+	enginedata->relok = ASC_NEW_ARRAY(int32, n_active_rels);
 
 #ifdef SOLVE_DEBUG
 	CONSOLE_DEBUG("rels matchbits:  0x%x",integrator_ida_rel.matchbits);
@@ -555,8 +569,13 @@ int ida_set_optional_inputs(IntegratorSystem *integ, void *ida_mem) {
 	CONSOLE_DEBUG("ASSIGNING LINEAR SOLVER '%s'",linsolver);
 	if (strcmp(linsolver, "ASCEND") == 0) {
 		CONSOLE_DEBUG("ASCEND DIRECT SOLVER, size = %d",integ->n_y);
-		IDAASCEND(ida_mem, integ->n_y);
+		flag = IDAASCEND(ida_mem, integ->n_y);
+		if (flag != IDAASCEND_SUCCESS) {
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Failed to set up IDAASCEND linear solver");
+			return 5;
+		}
 		IDAASCENDSetJacFn(ida_mem, &integrator_ida_sjex, (void *) integ);
+		IDAASCENDSetJacobianWorkspace(ida_mem, integ->jacobian);
 
 		enginedata->flagfntype = "IDAASCEND";
 		enginedata->flagfn = &IDAASCENDGetLastFlag;
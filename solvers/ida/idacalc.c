@@ -58,44 +58,13 @@
 /* #define FEX_DEBUG  */
 #define JEX_DEBUG
 /* #define DJEX_DEBUG */
+/* #define SJEX_DEBUG */
 /* #define ROOT_DEBUG */
 
 /*--------------------------------------------------
   RESIDUALS AND JACOBIAN AND IDAROOTFN
 */
 
-#if 0
-typedef void (SignalHandlerFn)(int);
-SignalHandlerFn integrator_ida_sig;
-SignalHandlerFn *integrator_ida_sig_old;
-jmp_buf integrator_ida_jmp_buf;
-fenv_t integrator_ida_fenv_old;
-
-
-void integrator_ida_write_feinfo(){
-	int f;
-	f = fegetexcept();
-	CONSOLE_DEBUG("Locating nature of exception...");
-	if(f & FE_DIVBYZERO)ERROR_REPORTER_HERE(ASC_PROG_ERR,"DIV BY ZERO");
-	if(f & FE_INEXACT)ERROR_REPORTER_HERE(ASC_PROG_ERR,"INEXACT");
-	if(f & FE_INVALID)ERROR_REPORTER_HERE(ASC_PROG_ERR,"INVALID");
-	if(f & FE_OVERFLOW)ERROR_REPORTER_HERE(ASC_PROG_ERR,"OVERFLOW");
-	if(f & FE_UNDERFLOW)ERROR_REPORTER_HERE(ASC_PROG_ERR,"UNDERFLOW");
-	if(f==0)ERROR_REPORTER_HERE(ASC_PROG_ERR,"FLAGS ARE CLEAR?!?");
-}
-
-void integrator_ida_sig(int sig){
-	/* the wrong signal: rethrow to the default handler */
-	if(sig!=SIGFPE){
-		signal(SIGFPE,SIG_DFL);
-		raise(sig);
-	}
-	integrator_ida_write_feinfo();
-	CONSOLE_DEBUG("Caught SIGFPE=%d (in signal handler). Jumping to...",sig);
-	longjmp(integrator_ida_jmp_buf,sig);
-}
-#endif
-
 /**
 	Function to evaluate system residuals, in the form required for IDA.
 
@@ -113,9 +82,8 @@ void integrator_ida_sig(int sig){
 int integrator_ida_fex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr, void *res_data){
 	IntegratorSystem *integ;
 	IntegratorIdaData *enginedata;
-	int i, calc_ok, is_error;
+	int i, is_error;
 	struct rel_relation** relptr;
-	double resid;
 	char *relname;
 #ifdef FEX_DEBUG
 	char *varname;
@@ -171,22 +139,19 @@ int integrator_ida_fex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr, void
 #endif
 
 
-	for(i=0, relptr = enginedata->rellist;
-				i< enginedata->nrels && relptr != NULL;
-				++i, ++relptr
+	/* the residuals may be computed in parallel, see relman_eval_batch */
+	if(relman_eval_batch(enginedata->rellist, enginedata->nrels
+			, NV_DATA_S(rr), enginedata->relok, enginedata->safeeval)
 	){
-		resid = relman_eval(*relptr, &calc_ok, enginedata->safeeval);
-
-		NV_Ith_S(rr,i) = resid;
-		if(!calc_ok){
-			relname = rel_make_name(integ->system, *relptr);
-			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Calculation error in rel '%s'",relname);
-			ASC_FREE(relname);
-			/* presumable some output already made? */
-			is_error = 1;
-		}/*else{
-			CONSOLE_DEBUG("Calc OK");
-		}*/
+		for(i=0, relptr = enginedata->rellist; i< enginedata->nrels; ++i, ++relptr){
+			if(!enginedata->relok[i]){
+				relname = rel_make_name(integ->system, *relptr);
+				ERROR_REPORTER_HERE(ASC_PROG_ERR,"Calculation error in rel '%s'",relname);
+				ASC_FREE(relname);
+				/* presumable some output already made? */
+				is_error = 1;
+			}
+		}
 	}
 
 	if(!is_error){
@@ -204,10 +169,9 @@ int integrator_ida_fex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr, void
 	}
 
 #ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalFPECheck();
 	}else{
-		relname = rel_make_name(integ->system, *relptr);
-		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Floating point error (SIGFPE) in rel '%s'",relname);
-		ASC_FREE(relname);
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Floating point error (SIGFPE) while evaluating residuals");
 		is_error = 1;
 	}
 
@@ -252,6 +216,7 @@ int integrator_ida_fex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr, void
 /**
 	Dense Jacobian evaluation. Only suitable for small problems!
 	Has been seen working for problems up to around 2000 vars, FWIW.
+	For anything larger, use linsolver 'ASCEND' (integrator_ida_sjex).
 */
 #if SUNDIALS_VERSION_MAJOR==2 && SUNDIALS_VERSION_MINOR>=4
 int integrator_ida_djex(int Neq, realtype tt, realtype c_j
@@ -589,10 +554,9 @@ int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
 #endif
 		}
 #ifdef ASC_SIGNAL_TRAPS
+		Asc_SignalFPECheck();
 	}else{
-		relname = rel_make_name(integ->system, *relptr);
-		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Floating point error (SIGFPE) in rel '%s'",relname);
-		ASC_FREE(relname);
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Floating point error (SIGFPE) while evaluating residuals");
 		is_error = 1;
 	}
 	Asc_SignalHandlerPopDefault(SIGFPE);
@@ -605,14 +569,248 @@ int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
 	return 0;
 }
 
-/* sparse jacobian evaluation for IDAASCEND sparse direct linear solver */
+/**
+	Column of the iteration matrix that receives the derivative of a
+	residual with respect to var: the y index for algebraic and
+	differential variables and for derivatives alike (the latter being
+	scaled by c_j), or -1 for the independent variable.
+*/
+static int integrator_ida_sjac_col(const IntegratorSystem *integ, struct var_variable *var){
+	if(var == integ->x)return -1;
+	if(var_deriv(var))return integrator_ida_diffindex(integ,var);
+	return var_sindex(var);
+}
+
+/**
+	Work out the sparsity structure of the iteration matrix from the
+	incidence of the active relations. Entries are collected column by
+	column in rellist order, so row indices come out sorted, and the
+	derivatives of a relation with respect to both y[k] and y'[k] are
+	merged into the single nonzero (i,k).
+*/
+static IntegratorIdaSparseJac *integrator_ida_sjac_create(IntegratorSystem *integ){
+	IntegratorIdaData *enginedata;
+	IntegratorIdaSparseJac *sj;
+	struct var_variable **vlist;
+	int i, j, k, c, n, len, total, maxlen, last;
+	int *entcol, *entrow, *order, *pos;
+
+	enginedata = integrator_ida_enginedata(integ);
+	n = enginedata->nrels;
+
+	sj = ASC_NEW_CLEAR(IntegratorIdaSparseJac);
+	sj->n = n;
+	sj->relstart = ASC_NEW_ARRAY(int,n+1);
+
+	/* count the filtered incidences of each relation */
+	total = 0;
+	maxlen = 1;
+	for(i = 0; i < n; ++i){
+		sj->relstart[i] = total;
+		len = rel_n_incidences(enginedata->rellist[i]);
+		if(len > maxlen)maxlen = len;
+		vlist = (struct var_variable **)rel_incidence_list(enginedata->rellist[i]);
+		for(j = 0; j < len; ++j){
+			if(var_apply_filter(vlist[j],&enginedata->vfilter))total++;
+		}
+	}
+	sj->relstart[n] = total;
+
+	entcol = ASC_NEW_ARRAY(int,total+1);
+	entrow = ASC_NEW_ARRAY(int,total+1);
+	order = ASC_NEW_ARRAY(int,total+1);
+	pos = ASC_NEW_ARRAY_CLEAR(int,n+1);
+	sj->slot = ASC_NEW_ARRAY(int,total+1);
+	sj->colptr = ASC_NEW_ARRAY(int,n+1);
+	sj->rowind = ASC_NEW_ARRAY(int,total+1);
+	sj->value = ASC_NEW_ARRAY(double,total+1);
+	sj->variables = ASC_NEW_ARRAY(struct var_variable *,maxlen);
+	sj->derivatives = ASC_NEW_ARRAY(double,maxlen);
+
+	/* column of each incidence, in the order relman_diff3 returns them */
+	for(i = 0, k = 0; i < n; ++i){
+		len = rel_n_incidences(enginedata->rellist[i]);
+		vlist = (struct var_variable **)rel_incidence_list(enginedata->rellist[i]);
+		for(j = 0; j < len; ++j){
+			if(!var_apply_filter(vlist[j],&enginedata->vfilter))continue;
+			c = integrator_ida_sjac_col(integ,vlist[j]);
+			asc_assert(c < n);
+			entcol[k] = c;
+			entrow[k] = i;
+			if(c >= 0)pos[c+1]++;
+			k++;
+		}
+	}
+
+	/* stable bucket sort by column */
+	for(c = 0; c < n; ++c)pos[c+1] += pos[c];
+	for(k = 0; k < total; ++k){
+		sj->slot[k] = -1;
+		if(entcol[k] >= 0)order[pos[entcol[k]]++] = k;
+	}
+
+	/* merge repeated rows within each column */
+	sj->nnz = 0;
+	for(c = 0, j = 0; c < n; ++c){
+		sj->colptr[c] = sj->nnz;
+		last = -1;
+		for(; j < pos[c]; ++j){
+			k = order[j];
+			if(entrow[k] != last){
+				sj->rowind[sj->nnz++] = entrow[k];
+				last = entrow[k];
+			}
+			sj->slot[k] = sj->nnz - 1;
+		}
+	}
+	sj->colptr[n] = sj->nnz;
+
+	ASC_FREE(entcol);
+	ASC_FREE(entrow);
+	ASC_FREE(order);
+	ASC_FREE(pos);
+
+#ifdef SJEX_DEBUG
+	CONSOLE_DEBUG("Sparse iteration matrix: order %d, %d nonzeros",n,sj->nnz);
+#endif
+	return sj;
+}
+
+void integrator_ida_sjac_destroy(IntegratorIdaSparseJac *sj){
+	if(sj==NULL)return;
+	ASC_FREE(sj->colptr);
+	ASC_FREE(sj->rowind);
+	ASC_FREE(sj->value);
+	ASC_FREE(sj->relstart);
+	ASC_FREE(sj->slot);
+	ASC_FREE(sj->variables);
+	ASC_FREE(sj->derivatives);
+	ASC_FREE(sj);
+}
+
+/**
+	Evaluate the values of the iteration matrix c_j*dF/dy' + dF/dy at
+	(tt,yy,yp) into the fixed sparsity structure enginedata->sjac, which
+	is built on the first call. Shared by the IDAASCEND linear solver and
+	the full Jacobian preconditioner.
+
+	@return 0 on success, 1 on a (recoverable) evaluation error.
+*/
+int integrator_ida_sjac_eval(IntegratorSystem *integ, realtype tt
+		, N_Vector yy, N_Vector yp, realtype c_j
+){
+	IntegratorIdaData *enginedata;
+	IntegratorIdaSparseJac *sj;
+	struct var_variable **variables;
+	double *derivatives;
+	char *relname;
+	int i, j, p, s, count, status, is_error = 0;
+
+	enginedata = integrator_ida_enginedata(integ);
+
+	/* pass the values of everything back to the compiler */
+	integrator_set_t(integ, (double)tt);
+	integrator_set_y(integ, NV_DATA_S(yy));
+	integrator_set_ydot(integ, NV_DATA_S(yp));
+
+	/* perform bounds checking on all variables */
+	if(slv_check_bounds(integ->system, 0, -1, NULL)){
+		return 1;
+	}
+
+	if(enginedata->sjac == NULL){
+		enginedata->sjac = integrator_ida_sjac_create(integ);
+	}
+	sj = enginedata->sjac;
+	variables = sj->variables;
+	derivatives = sj->derivatives;
+
+	for(p = 0; p < sj->nnz; ++p)sj->value[p] = 0.0;
+
+	for(i = 0; i < sj->n; ++i){
+		status = relman_diff3(enginedata->rellist[i], &enginedata->vfilter
+			, derivatives, variables, &count, enginedata->safeeval
+		);
+		if(status){
+			relname = rel_make_name(integ->system, enginedata->rellist[i]);
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Calculation error in rel '%s'",relname);
+			ASC_FREE(relname);
+			is_error = 1;
+			break;
+		}
+		asc_assert(count == sj->relstart[i+1] - sj->relstart[i]);
+		for(j = 0; j < count; ++j){
+			s = sj->slot[sj->relstart[i] + j];
+			if(s < 0)continue;
+			if(var_deriv(variables[j])){
+				sj->value[s] += derivatives[j] * c_j;
+			}else{
+				sj->value[s] += derivatives[j];
+			}
+		}
+	}
+
+	if(!is_error){
+		for(j = 0; j < sj->n; ++j){
+			for(p = sj->colptr[j]; p < sj->colptr[j+1]; ++p){
+				if(isnan(sj->value[p])){
+					ERROR_REPORTER_HERE(ASC_PROG_ERR,"NAN detected in jacobian J[%d,%d]",sj->rowind[p],j);
+					is_error = 1;
+				}
+			}
+		}
+	}
+
+	if(is_error){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"There were derivative evaluation errors in the sparse jacobian");
+		return 1;
+	}
+	return 0;
+}
+
+/**
+	Copy the values of the sparse iteration matrix into Jac, using original
+	row numbers equal to the rellist index and original column numbers
+	equal to the y index.
+*/
+void integrator_ida_sjac_fill(const IntegratorIdaSparseJac *sj, mtx_matrix_t Jac){
+	mtx_coord_t coord;
+	int j, p;
+	for(j = 0; j < sj->n; ++j){
+		coord.col = j;
+		for(p = sj->colptr[j]; p < sj->colptr[j+1]; ++p){
+			coord.row = sj->rowind[p];
+			mtx_fill_org_value(Jac, &coord, sj->value[p]);
+		}
+	}
+}
+
+/**
+	Sparse Jacobian evaluation for the IDAASCEND sparse direct linear
+	solver. Fills Jac (which must be empty on entry) with the iteration
+	matrix c_j*dF/dy' + dF/dy, as integrator_ida_sjac_fill.
+
+	Every structural nonzero is inserted, even if its current value is
+	zero, so the pattern seen by the linear solver never changes and its
+	ordering can be reused from one step to the next.
+*/
 int integrator_ida_sjex(long int Neq, realtype tt
 		, N_Vector yy, N_Vector yp, N_Vector rr
 		, realtype c_j, void *jac_data, mtx_matrix_t Jac
 		, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3
 ){
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return -1;
+	IntegratorSystem *integ;
+	IntegratorIdaData *enginedata;
+
+	integ = (IntegratorSystem *)jac_data;
+	enginedata = integrator_ida_enginedata(integ);
+
+	if(integrator_ida_sjac_eval(integ, tt, yy, yp, c_j)){
+		return 1;
+	}
+	asc_assert(enginedata->sjac->n == Neq);
+	integrator_ida_sjac_fill(enginedata->sjac, Jac);
+	return 0;
 }
 
 /* root finding function */
@@ -21,6 +21,7 @@
 
 #include "ida.h"
 #include "idalinear.h"
+#include "idatypes.h"
 
 /* residual function forward declaration */
 int integrator_ida_fex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr, void *res_data);
@@ -48,6 +49,17 @@ int integrator_ida_djex(long int Neq, realtype tt
 /* sparse jacobian evaluation for ASCEND's sparse direct solver */
 IntegratorSparseJacFn integrator_ida_sjex;
 
+/* evaluate the iteration matrix into enginedata->sjac, building it if need be */
+int integrator_ida_sjac_eval(IntegratorSystem *integ, realtype tt
+		, N_Vector yy, N_Vector yp, realtype c_j
+);
+
+/* copy the values of the iteration matrix into an mtx */
+void integrator_ida_sjac_fill(const IntegratorIdaSparseJac *sj, mtx_matrix_t Jac);
+
+/* free the sparsity structure built by integrator_ida_sjex (NULL is OK) */
+void integrator_ida_sjac_destroy(IntegratorIdaSparseJac *sj);
+
 /* boundary-detection function */
 int integrator_ida_rootfn(realtype tt, N_Vector yy, N_Vector yp, realtype *gout, void *g_data);
 
@@ -2,6 +2,9 @@
 
 #include <ascend/utilities/error.h>
 #include <ascend/general/ascMalloc.h>
+#include <ascend/linear/mtx_perms.h>
+#include <ascend/linear/mtx_reorder.h>
+#include <ascend/linear/linsolqr.h>
 
 /** FIXME should the following be moved to ida.h? */
 #include <sundials/sundials_math.h>
@@ -17,8 +20,17 @@ typedef struct IntegratorIdaAscendMemStruct{
 	unsigned long          integ_nje;
 	unsigned long          integ_nre;
 	mtx_matrix_t           integ_sparse_jac_matrix;
+	linsolqr_system_t      integ_linsys;  /* factors of the jacobian */
+	real64                *integ_rhs;     /* rhs array registered with integ_linsys */
+	int                    integ_ordered; /* set once the matrix has been reordered */
+	IntegratorJacobian    *integ_jacobian; /* workspace counting the setups, or NULL */
 } IntegratorIdaAscendMem;
 
+/* factorisation method: the same default as QRSlv */
+#define IDAASCEND_FMETHOD ranki_ba2
+
+/* #define SETUP_DEBUG */
+
 /* readability replacements (see also ida_dense.c from SUNDIALS distro */
 
 #define linit        (IDA_mem->ida_linit)
@@ -38,11 +50,17 @@ typedef struct IntegratorIdaAscendMemStruct{
 #define jacfn        (iamem->integ_jacfn)
 #define jacdata      (iamem->integ_jac_data)
 #define JJ           (iamem->integ_sparse_jac_matrix)
+#define linsys       (iamem->integ_linsys)
+#define rhs          (iamem->integ_rhs)
+#define ordered      (iamem->integ_ordered)
+#define jacws        (iamem->integ_jacobian)
+#define setupNonNull (IDA_mem->ida_setupNonNull)
 
 #define MSGD_IDAMEM_NULL "Integrator memory is NULL."
 #define MSGD_MEM_FAIL    "A memory request failed."
 #define MSGD_LMEM_NULL   "IDAASCEND memory is NULL."
 #define MSGD_JACFN_UNDEF "The sparse jacobian evaluation routine has not been provided."
+#define MSGD_STRUCT_SING "The iteration matrix is structurally singular."
 
 /*------------------------------------
   Internal setup/evaluation routines required by IDA. As documented in IDA Manual Ch. 8
@@ -73,14 +91,14 @@ int IDAASCEND(void *ida_mem, long _neq){
 	}
 	IDA_mem = (IDAMem)ida_mem;
 
-	iamem = ASC_NEW(IntegratorIdaAscendMem);
+	/* free linsolver memory with the previous lfree fn, if allocated */
+	if(lfree != NULL)lfree(IDA_mem);
+
+	iamem = ASC_NEW_CLEAR(IntegratorIdaAscendMem);
 	if(iamem == NULL){
+		IDAProcessError(IDA_mem, IDAASCEND_MEM_FAIL, "IDAASCEND", __FUNCTION__, MSGD_MEM_FAIL);
 		return IDAASCEND_MEM_FAIL;
 	}
-	lmem = (void *)iamem;
-
-	/* free linsolver memory with the previous lfree fn, if allocated */
-	if(lfree != NULL)lfree(ida_mem);
 
 	/* set the internal-use linear solver function pointers for IDA */
 	linit  = &integrator_ida_linit;
@@ -91,10 +109,30 @@ int IDAASCEND(void *ida_mem, long _neq){
 
 	/* no jacobian assigned, initially (we will throw an error if the user doesn't assign it though) */
 	jacfn = NULL;
+	jacdata = NULL;
 	lastflag = IDAASCEND_SUCCESS;
 	neq = _neq;
 
-	/* allocate memory required for Jacobian mtx_matrix_t ?? */
+	/* the jacobian matrix, and the linsolqr system that will factor it */
+	JJ = mtx_create();
+	mtx_set_order(JJ, (int32)neq);
+	linsys = linsolqr_create_default();
+	rhs = ASC_NEW_ARRAY_CLEAR(real64, neq > 0 ? neq : 1);
+	if(JJ == NULL || linsys == NULL || rhs == NULL){
+		if(linsys != NULL)linsolqr_destroy(linsys);
+		if(JJ != NULL)mtx_destroy(JJ);
+		if(rhs != NULL)ASC_FREE(rhs);
+		ASC_FREE(iamem);
+		IDAProcessError(IDA_mem, IDAASCEND_MEM_FAIL, "IDAASCEND", __FUNCTION__, MSGD_MEM_FAIL);
+		return IDAASCEND_MEM_FAIL;
+	}
+	linsolqr_set_matrix(linsys, JJ);
+	linsolqr_prep(linsys, linsolqr_fmethod_to_fclass(IDAASCEND_FMETHOD));
+	linsolqr_add_rhs(linsys, rhs, FALSE);
+	ordered = 0;
+
+	lmem = (void *)iamem;
+	setupNonNull = TRUE;
 
 	return IDAASCEND_SUCCESS;
 }
@@ -116,6 +154,28 @@ int IDAASCENDSetJacFn(void *ida_mem, IntegratorSparseJacFn *_jacfn, void *_jac_d
 	iamem = (IntegratorIdaAscendMem *)lmem;
 
 	jacfn = _jacfn;
+	jacdata = _jac_data;
+
+	return IDAASCEND_SUCCESS;
+}
+
+int IDAASCENDSetJacobianWorkspace(void *ida_mem, IntegratorJacobian *jac){
+	IDAMem IDA_mem;
+	IntegratorIdaAscendMem *iamem;
+
+	if(ida_mem == NULL){
+		IDAProcessError(NULL, IDAASCEND_MEM_NULL, "IDAASCEND", __FUNCTION__, MSGD_IDAMEM_NULL);
+		return(IDAASCEND_MEM_NULL);
+	}
+	IDA_mem = (IDAMem)ida_mem;
+
+	if(lmem == NULL){
+		IDAProcessError(ida_mem, IDAASCEND_LMEM_NULL, "IDAASCEND", __FUNCTION__, MSGD_LMEM_NULL);
+		return(IDAASCEND_LMEM_NULL);
+	}
+	iamem = (IntegratorIdaAscendMem *)lmem;
+
+	jacws = jac;
 
 	return IDAASCEND_SUCCESS;
 }
@@ -156,6 +216,9 @@ char *IDAASCENDGetReturnFlagName(int flag){
 		FLAG(IDAASCEND_JACFN_UNDEF);
 		FLAG(IDAASCEND_JACFN_UNRECVR);
 		FLAG(IDAASCEND_JACFN_RECVR);
+		FLAG(IDAASCEND_SINGULAR);
+		FLAG(IDAASCEND_STRUCT_SINGULAR);
+		FLAG(IDAASCEND_SOLVE_FAIL);
 		default:
 			sprintf(name,"Unknown flag value '%d'",flag);
 	}
@@ -171,14 +234,57 @@ char *IDAASCENDGetReturnFlagName(int flag){
 int integrator_ida_linit(IDAMem IDA_mem){
   	IntegratorIdaAscendMem *iamem;
 	iamem = (IntegratorIdaAscendMem *)lmem;
-  
+
 	CONSOLE_DEBUG("Initialising IDA linear solver");
 	nje = 0;
 	nre = 0;
-	jacfn = NULL;
 
-	/* initialise anything else in the IntegratorIdaAscendMem that needs it */
+	/* the jacobian function was assigned by IDAASCENDSetJacFn */
+	if(jacfn == NULL){
+		IDAProcessError(IDA_mem, IDAASCEND_JACFN_UNDEF, "IDAASCEND", __FUNCTION__, MSGD_JACFN_UNDEF);
+		lastflag = IDAASCEND_JACFN_UNDEF;
+		return -1;
+	}
+
+	lastflag = IDAASCEND_SUCCESS;
+	return 0;
+}
+
+/**
+	Structural analysis of the jacobian, done once on the first call to
+	lsetup. Output assignment and block-lower-triangular partitioning are
+	followed by SPK1 reordering of each diagonal block, exactly as QRSlv
+	does for its blocks. The resulting permutation of JJ is kept by all
+	subsequent evaluations (which replace the elements but not the
+	permutation), so later factorisations are numeric only.
+*/
+static int integrator_ida_lreorder(IntegratorIdaAscendMem *iamem){
+	mtx_region_t reg;
+	int32 b, nblocks, rank;
+
+	mtx_output_assign(JJ, (int32)neq, (int32)neq);
+	rank = mtx_symbolic_rank(JJ);
+	if(rank < neq){
+		ERROR_REPORTER_HERE(ASC_USER_ERROR,"Iteration matrix is structurally"
+			" singular (rank %d, %ld equations)",rank,neq
+		);
+		return 1;
+	}
+	mtx_partition(JJ);
+	nblocks = mtx_number_of_blocks(JJ);
+	for(b = 0; b < nblocks; ++b){
+		mtx_block(JJ, b, &reg);
+		if(reg.row.high > reg.row.low){
+			mtx_reorder(JJ, &reg, mtx_SPK1);
+		}
+	}
+#ifdef SETUP_DEBUG
+	CONSOLE_DEBUG("Iteration matrix has %d diagonal blocks",nblocks);
+#endif
 
+	reg.row.low = reg.col.low = 0;
+	reg.row.high = reg.col.high = (int32)neq - 1;
+	linsolqr_reorder(linsys, &reg, natural);
 	return 0;
 }
 
@@ -187,12 +293,11 @@ int integrator_ida_lsetup(IDAMem IDA_mem
 	, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3
 ){
 	int retval;
+	mtx_region_t reg;
 
   	IntegratorIdaAscendMem *iamem;
 	iamem = (IntegratorIdaAscendMem *)lmem;
 
-	CONSOLE_DEBUG("Setting up IDA linear problem");
-
 	if(jacfn==NULL){
 		lastflag = IDAASCEND_JACFN_UNDEF;
 		return -1; /* unrecoverable */
@@ -200,29 +305,58 @@ int integrator_ida_lsetup(IDAMem IDA_mem
 
 	/* Increment nje counter. */
 	nje++;
+	if(jacws != NULL)integrator_jacobian_begin(jacws, linsys);
 
-	/* clear the jacobian matrix */
-	/* ... */
+	/* clear the jacobian matrix: elements go (or, once the matrix has been
+	packed, are zeroed), the permutation stays */
+	reg.row.low = reg.col.low = 0;
+	reg.row.high = reg.col.high = (int32)neq - 1;
+	mtx_clear_region(JJ, &reg);
 
 	/* evaluate the jacobian */
-	retval = jacfn(neq, tn, yyp, ypp, rrp, cj, jacdata, JJ, 
+	retval = jacfn(neq, tn, yyp, ypp, rrp, cj, jacdata, JJ,
 		tmp1, tmp2, tmp3
 	);
 
 	if(retval < 0){
 		lastflag = IDAASCEND_JACFN_UNRECVR;
-		return -1;
+		retval = -1;
+		goto done;
 	}
 	if (retval > 0) {
 		lastflag = IDAASCEND_JACFN_RECVR;
-		return +1;
+		retval = +1;
+		goto done;
 	}
 
-	/* do block decomposition, LU factorisation or whatever, return success or fail flag */
-	/* ... */
+	/* symbolic analysis, first time only */
+	if(!ordered){
+		if(integrator_ida_lreorder(iamem)){
+			IDAProcessError(IDA_mem, IDAASCEND_STRUCT_SINGULAR, "IDAASCEND", __FUNCTION__, MSGD_STRUCT_SING);
+			lastflag = IDAASCEND_STRUCT_SINGULAR;
+			retval = -1;
+			goto done;
+		}
+		ordered = 1;
+		/* the pattern is fixed from now on: pack it for the refills */
+		mtx_freeze(JJ);
+	}
 
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return(-1);
+	/* numeric factorisation in the existing order */
+	linsolqr_matrix_was_changed(linsys);
+	if(linsolqr_factor(linsys, IDAASCEND_FMETHOD)){
+		lastflag = IDAASCEND_SINGULAR;
+		retval = +1;
+	}else if(linsolqr_rank(linsys) < neq){
+		/* numerically singular at this step size: let IDA try again */
+		lastflag = IDAASCEND_SINGULAR;
+		retval = +1;
+	}else{
+		lastflag = IDAASCEND_SUCCESS;
+	}
+done:
+	if(jacws != NULL)integrator_jacobian_end(jacws);
+	return retval;
 }
 
 /**
@@ -236,36 +370,49 @@ int integrator_ida_lsolve(IDAMem IDA_mem
 	, N_Vector b, N_Vector weight
 	, N_Vector ycur, N_Vector ypcur, N_Vector rrcur
 ){
-#ifdef STILL_NEED_TO_IMPLEMENT_THIS_STUFF
 	realtype *bd;
-  
+	long i;
+
   	IntegratorIdaAscendMem *iamem;
 	iamem = (IntegratorIdaAscendMem *)lmem;
-  
-	/* retrieve the data array for the RHS vector, 'b' */
+
+	/* retrieve the data array for the RHS vector, 'b' (indexed by rel) */
 	bd = N_VGetArrayPointer(b);
+	for(i = 0; i < neq; ++i){
+		rhs[i] = bd[i];
+	}
+	linsolqr_rhs_was_changed(linsys, rhs);
 
-	/* call the necessary linsolqr routine here */
-	/* ... */
-	/* For IDADENSE, it's: DenseGETRS(JJ, pivots, bd); */
+	if(linsolqr_solve(linsys, rhs)){
+		lastflag = IDAASCEND_SOLVE_FAIL;
+		return -1;
+	}
+
+	/* solution comes back indexed by column, ie by y index */
+	linsolqr_copy_solution(linsys, rhs, bd);
 
-	/* not sure what this is doing yet */
-	/* For IDADENSE, it's: Scale the correction to account for change in cj. */
+	/* scale the correction to account for change in cj (as IDADENSE) */
 	if(cjratio != ONE){
 		N_VScale(TWO/(ONE + cjratio), b, b);
 	}
-#endif
 
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return -1;
+	lastflag = IDAASCEND_SUCCESS;
+	return 0;
 }
 
 int integrator_ida_lfree(IDAMem IDA_mem){
+  	IntegratorIdaAscendMem *iamem;
 	CONSOLE_DEBUG("Freeing IDA linear solver data");
 
-	/* free jacobian mtx_matrix_t data ?? */
-
 	if(lmem!=NULL){
+		iamem = (IntegratorIdaAscendMem *)lmem;
+		if(linsys != NULL){
+			linsolqr_remove_rhs(linsys, rhs);
+			linsolqr_set_matrix(linsys, NULL);
+			linsolqr_destroy(linsys);
+		}
+		if(JJ != NULL)mtx_destroy(JJ);
+		if(rhs != NULL)ASC_FREE(rhs);
 		ASC_FREE(lmem);
 		lmem=NULL;
 	}
@@ -19,7 +19,13 @@
 	ASCEND linsolqr routines internally, and takes advantage of the block
 	decomposition functionality available in ASCEND.
 
-	EXPERIMENTAL -- INCOMPLETE -- UNDER DEVELOPMENT
+	The sparsity pattern of the iteration matrix is assumed not to change
+	during an integration. On the first setup call the matrix is output
+	assigned, partitioned into block lower triangular form and each block
+	SPK1-reordered; that ordering is then kept, and every later setup does
+	only a numeric ranki_ba2 refactorisation. The Jacobian function must
+	therefore insert every structural nonzero on every call, even if its
+	value is zero.
 
 	This file and idalinear.c are modelled fairly closely on ida_dense.c from
 	the SUNDIALS distribution, which maps out the expected use of ida_lmem
@@ -33,9 +39,11 @@
 #include "ida.h"
 
 #include <ascend/linear/mtx.h>
+#include <ascend/integrator/integrator.h>
 
 /**
-	Function prototype for sparse jacobian evaluation as required by this linear solver
+	Function prototype for sparse jacobian evaluation as required by this linear solver.
+	Jac is empty on entry; fill it using original row/column numbers.
 */
 typedef int IntegratorSparseJacFn(long int Neq, realtype tt
 		, N_Vector yy, N_Vector yp, N_Vector rr
@@ -46,12 +54,15 @@ typedef int IntegratorSparseJacFn(long int Neq, realtype tt
 #define IDAASCEND_SUCCESS 0
 
 #define IDAASCEND_JACFN_RECVR 1
+#define IDAASCEND_SINGULAR 2
 
 #define IDAASCEND_MEM_NULL -1
 #define IDAASCEND_LMEM_NULL -2
 #define IDAASCEND_MEM_FAIL -4
 #define IDAASCEND_JACFN_UNDEF -5
 #define IDAASCEND_JACFN_UNRECVR -6
+#define IDAASCEND_STRUCT_SINGULAR -7
+#define IDAASCEND_SOLVE_FAIL -8
 
 /*------------------------------------
   User functions (called from ida.c in this directory)
@@ -69,6 +80,12 @@ int IDAASCEND(void *ida_mem, long size);
 */
 int IDAASCENDSetJacFn(void *ida_mem, IntegratorSparseJacFn *jacfn, void *jac_data);
 
+/**
+	Count the setups and factorisations in the integrator's Jacobian
+	workspace (optional). @see integrator_jacobian_stats
+*/
+int IDAASCENDSetJacobianWorkspace(void *ida_mem, IntegratorJacobian *jac);
+
 /**
 	@param flag variable into which the last flag is returned
 	@return non-zero if unable to retrieve the last flag successfully (eg if ida_mem is NULL)
@@ -26,6 +26,7 @@
 
 #include "idaprec.h"
 #include "idaio.h"
+#include "idacalc.h"
 
 #include <ascend/general/platform.h>
 #include <ascend/system/relman.h>
@@ -86,8 +87,17 @@ const IntegratorIdaPrec prec_jacobi = {
 
 /*----------------------------------------------
   FULL JACOBIAN PRECONDITIONER -- EXPERIMENTAL.
+
+  P is the iteration matrix c_j*dF/dy' + dF/dy itself, evaluated into the
+  same fixed sparsity structure as the 'ASCEND' linear solver uses. P is
+  SPK1-reordered and frozen on the first setup; later setups only
+  overwrite its values and refactor it, which linsolqr does in the
+  recorded pivot order where it can.
 */
 
+/* factorisation method: the same default as QRSlv */
+#define PREC_FMETHOD ranki_ba2
+
 static void integrator_ida_pcreate_jacobian(IntegratorSystem *integ){
 	IntegratorIdaData *enginedata =integ->enginedata;
 	IntegratorIdaPrecDataJacobian *precdata;
@@ -95,11 +105,15 @@ static void integrator_ida_pcreate_jacobian(IntegratorSystem *integ){
 	mtx_matrix_t P;
 	asc_assert(integ->n_y);
 	precdata->L = linsolqr_create_default();
+	precdata->rhs = ASC_NEW_ARRAY_CLEAR(real64, integ->n_y);
+	precdata->ordered = 0;
 
 	/* allocate matrix to be used by linsolqr */
 	P = mtx_create();
 	mtx_set_order(P, integ->n_y);
 	linsolqr_set_matrix(precdata->L, P);
+	linsolqr_prep(precdata->L, linsolqr_fmethod_to_fclass(PREC_FMETHOD));
+	linsolqr_add_rhs(precdata->L, precdata->rhs, FALSE);
 
 	enginedata->pfree = &integrator_ida_pfree_jacobian;
 	enginedata->precdata = precdata;
@@ -113,8 +127,11 @@ void integrator_ida_pfree_jacobian(IntegratorIdaData *enginedata){
 	if(enginedata->precdata){
 		precdata = (IntegratorIdaPrecDataJacobian *)enginedata->precdata;
 		P = linsolqr_get_matrix(precdata->L);
+		linsolqr_remove_rhs(precdata->L, precdata->rhs);
+		linsolqr_set_matrix(precdata->L, NULL);
 		mtx_destroy(P);
 		linsolqr_destroy(precdata->L);
+		ASC_FREE(precdata->rhs);
 		ASC_FREE(precdata);
 		enginedata->precdata = NULL;
 
@@ -126,7 +143,7 @@ void integrator_ida_pfree_jacobian(IntegratorIdaData *enginedata){
 /**
 	EXPERIMENTAL. Full Jacobian preconditioner for use with IDA Krylov solvers
 
-	'setup' function.
+	'setup' function: evaluate and factor P.
 */
 static int integrator_ida_psetup_jacobian(realtype tt,
 		 N_Vector yy, N_Vector yp, N_Vector rr,
@@ -134,80 +151,65 @@ static int integrator_ida_psetup_jacobian(realtype tt,
 		 N_Vector tmp1, N_Vector tmp2,
 		 N_Vector tmp3
 ){
-	int i, j, res;
 	IntegratorSystem *integ;
 	IntegratorIdaData *enginedata;
 	IntegratorIdaPrecDataJacobian *precdata;
+	IntegratorJacobian *jac;
 	linsolqr_system_t L;
 	mtx_matrix_t P;
-	struct rel_relation **relptr;
+	mtx_region_t R;
+	int res = 0;
 
 	integ = (IntegratorSystem *)p_data;
 	enginedata = integ->enginedata;
 	precdata = (IntegratorIdaPrecDataJacobian *)(enginedata->precdata);
-	double *derivatives;
-	struct var_variable **variables;
-	int count, status;
-	char *relname;
-	mtx_coord_t C;
+	jac = integ->jacobian;
+	asc_assert(jac != NULL);
 
 	L = precdata->L;
 	P = linsolqr_get_matrix(L);
-	mtx_clear(P);
-
-	CONSOLE_DEBUG("Setting up Jacobian preconditioner");
-
-	variables = ASC_NEW_ARRAY(struct var_variable*, NV_LENGTH_S(yy) * 2);
-	derivatives = ASC_NEW_ARRAY(double, NV_LENGTH_S(yy) * 2);
+	R.row.low = R.col.low = 0;
+	R.row.high = R.col.high = mtx_order(P) - 1;
 
-	/**
-		@TODO FIXME here we are using the very inefficient and contorted approach
-		of calculating the whole jacobian, then extracting just the diagonal elements.
-	*/
+	integrator_jacobian_begin(jac, L);
 
-	for(i=0, relptr = enginedata->rellist;
-			i< enginedata->nrels && relptr != NULL;
-			++i, ++relptr
-	){
-		/* get derivatives for this particular relation */
-		status = relman_diff3(*relptr, &enginedata->vfilter, derivatives, variables, &count, enginedata->safeeval);
-		if(status){
-			relname = rel_make_name(integ->system, *relptr);
-			CONSOLE_DEBUG("ERROR calculating preconditioner derivatives for relation '%s'",relname);
-			ASC_FREE(relname);
-			break;
-		}
-		/* CONSOLE_DEBUG("Got %d derivatives from relation %d",count,i); */
-		/* find the diagonal elements */
-		for(j=0; j<count; ++j){
-			if(var_deriv(variables[j])){
-				mtx_fill_value(P, mtx_coord(&C, i, var_sindex(variables[j])), c_j * derivatives[j]);
-			}else{
-				mtx_fill_value(P, mtx_coord(&C, i, var_sindex(variables[j])), derivatives[j]);
-			}
-		}
+	if(integrator_ida_sjac_eval(integ, tt, yy, yp, c_j)){
+		CONSOLE_DEBUG("Error found when evaluating derivatives");
+		res = 1; /* recoverable */
+		goto done;
 	}
 
-	mtx_assemble(P);
+	/* elements go (or, once P is frozen, are zeroed), the permutation stays */
+	mtx_clear_region(P, &R);
+	integrator_ida_sjac_fill(enginedata->sjac, P);
 
-	if(status){
-		CONSOLE_DEBUG("Error found when evaluating derivatives");
-		res = 1; goto finish; /* recoverable */
+	if(!precdata->ordered){
+		/* symbolic work, first time only */
+		linsolqr_set_region(L, R);
+		linsolqr_reorder(L, &R, spk1);
+		mtx_freeze(P);
+		precdata->ordered = 1;
+#ifdef PREC_DEBUG
+		integrator_ida_write_incidence(integ);
+#endif
 	}
 
-	integrator_ida_write_incidence(integ);
-
-	res = 0;
-finish:
-	ASC_FREE(variables);
-	ASC_FREE(derivatives);
+	linsolqr_matrix_was_changed(L);
+	if(linsolqr_factor(L, PREC_FMETHOD)){
+		res = 1;
+	}else if(linsolqr_rank(L) < mtx_order(P)){
+		/* singular at this step size: let IDA try again */
+		res = 1;
+	}
+done:
+	integrator_jacobian_end(jac);
 	return res;
 };
 
 /**
 	EXPERIMENTAL. Full Jacobian preconditioner for use with IDA Krylov solvers
 
-	'solve' function.
+	'solve' function: solve P z = r using the factors from the setup.
 */
 static int integrator_ida_psolve_jacobian(realtype tt,
 		 N_Vector yy, N_Vector yp, N_Vector rr,
@@ -218,26 +220,24 @@ static int integrator_ida_psolve_jacobian(realtype tt,
 	IntegratorSystem *integ;
 	IntegratorIdaData *data;
 	IntegratorIdaPrecDataJacobian *precdata;
+	realtype *r;
+	long i, n;
 	integ = (IntegratorSystem *)p_data;
 	data = integ->enginedata;
 	precdata = (IntegratorIdaPrecDataJacobian *)(data->precdata);
 	linsolqr_system_t L = precdata->L;
 
-	linsolqr_add_rhs(L,NV_DATA_S(rvec),FALSE);
-
-	mtx_region_t R;
-	R.row.low = R.col.low = 0;
-	R.row.high = R.col.high = mtx_order(linsolqr_get_matrix(L)) - 1;
-    linsolqr_set_region(L,R);
-
-    linsolqr_prep(L,linsolqr_fmethod_to_fclass(linsolqr_fmethod(L)));
-    linsolqr_reorder(L, &R, linsolqr_rmethod(L));
-
-	/// @TODO more here
-
-	linsolqr_remove_rhs(L,NV_DATA_S(rvec));
-
-	CONSOLE_DEBUG("Solving Jacobian preconditioner (c_j = %f)",c_j);
+	/* the rhs is indexed by rel, the solution by y index */
+	r = NV_DATA_S(rvec);
+	n = NV_LENGTH_S(rvec);
+	for(i = 0; i < n; ++i){
+		precdata->rhs[i] = r[i];
+	}
+	linsolqr_rhs_was_changed(L, precdata->rhs);
+	if(linsolqr_solve(L, precdata->rhs)){
+		return -1;
+	}
+	linsolqr_copy_solution(L, precdata->rhs, NV_DATA_S(zvec));
 	return 0;
 };
 
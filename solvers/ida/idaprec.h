@@ -51,6 +51,8 @@ typedef struct IntegratorIdaPrecStruct{
 */
 typedef struct IntegratorIdaPrecDJFStruct{
 	linsolqr_system_t L;
+	real64 *rhs;  /**< rhs vector registered with L */
+	int ordered;  /**< set once P has been reordered and frozen */
 } IntegratorIdaPrecDataJacobian;
 
 /**	@todo FIXME seems that this pfree function is not being used anywhere?? */
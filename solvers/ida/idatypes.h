@@ -39,6 +39,25 @@ typedef void IntegratorIdaPrecFreeFn(struct IntegratorIdaDataStruct *enginedata)
 typedef int IdaFlagFn(void *, int *);
 typedef char *IdaFlagNameFn(int);
 
+/**
+	Fixed sparsity structure of the IDA iteration matrix c_j*dF/dy' + dF/dy,
+	stored by columns, with a map from each relation's filtered incidences
+	to the nonzero that receives its derivative. Built once per integration
+	by integrator_ida_sjex, so that later Jacobian evaluations only have to
+	write values. @see idacalc.c
+*/
+typedef struct IntegratorIdaSparseJacStruct{
+	int n;                /**< order of the matrix (= number of rels = n_y) */
+	int nnz;              /**< number of structural nonzeros */
+	int *colptr;          /**< n+1 offsets into rowind/value for each column */
+	int *rowind;          /**< row (index into rellist) of each nonzero */
+	double *value;        /**< value of each nonzero */
+	int *relstart;        /**< n+1 offsets into slot for each relation */
+	int *slot;            /**< nonzero for each filtered incidence, or -1 */
+	struct var_variable **variables; /**< scratch for relman_diff3 */
+	double *derivatives;  /**< scratch for relman_diff3 */
+} IntegratorIdaSparseJac;
+
 /**
 	Struct containing any stuff that IDA needs that doesn't fit into the
 	common IntegratorSystem struct.
@@ -47,6 +66,7 @@ typedef struct IntegratorIdaDataStruct{
 
 	struct rel_relation **rellist;   /**< NULL terminated list of ACTIVE rels */
 	int nrels; /* number of ACTIVE rels */
+	int32 *relok;                    /**< per-relation calc_ok flags from relman_eval_batch */
 
 	struct bnd_boundary **bndlist;	 /**< NULL-terminated list of boundaries, for use in the root-finding  code */
 	int nbnds; /* number of boundaries */
@@ -56,6 +76,7 @@ typedef struct IntegratorIdaDataStruct{
 	rel_filter_t rfilter;            /**< Used to filter relations from solver's rellist (@TODO needs work) */
 	void *precdata;                  /**< For use by the preconditioner */
 	IntegratorIdaPrecFreeFn *pfree;	 /**< Store instructions here on how to free precdata */
+	IntegratorIdaSparseJac *sjac;    /**< For use by the 'ASCEND' sparse linear solver */
 
 	/* Error flag look-up data */
 	IdaFlagFn *flagfn;
@@ -32,6 +32,8 @@
 #endif
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <ascend/solver/solver.h>
 
@@ -49,8 +51,6 @@
 #include <ascend/general/tm_time.h>
 #include <ascend/general/env.h>
 
-#include <ascend/general/ltmatrix.h>
-
 #include <IpStdCInterface.h>
 
 ASC_DLLSPEC SolverRegisterFn ipopt_register;
@@ -139,6 +139,22 @@ struct IpoptSystemStruct{
 	Index nnzJ; /* number of non zeros in the jacobian of the constraints */
 	Index nnzH; /* number of non-zeros in the hessian of the objective */
 
+	/*
+		Sparse Hessian of the Lagrangian (exact mode only). Relation k
+		(k=0 the objective, k>0 constraint k-1) contributes the packed lower
+		triangle over its nonlinear incidences hess_pos[hess_posstart[k]..],
+		whose entries are added into values[hess_slot[hess_slotstart[k]..]].
+	*/
+	Index *hess_row;              /* sparsity pattern, length nnzH */
+	Index *hess_col;
+	int32 hess_nrels;             /* number of contributing relations */
+	struct rel_relation **hess_rels;
+	int32 *hess_posstart;         /* length hess_nrels+1 */
+	unsigned long *hess_pos;      /* incidence positions, see relman_hess_pattern */
+	int32 *hess_slotstart;        /* length hess_nrels+1 */
+	Index *hess_slot;             /* position in values[] of each packed entry */
+	double *hess_scratch;         /* packed triangle of the largest relation */
+
 #if 0
 	Number* x_L;                  /* lower bounds on x */
 	Number* x_U;                  /* upper bounds on x */
@@ -163,6 +179,7 @@ static int ipopt_get_default_parameters(slv_system_t server, SlvClientToken asys
 
 static void ipopt_iteration_begins(IpoptSystem *sys);
 static void ipopt_iteration_ends(IpoptSystem *sys);
+static void ipopt_hess_destroy(IpoptSystem *sys);
 
 /*------------------------------------------------------------------------------
   SYSTEM SETUP/DESTROY, STATUS AND SOLVER ELIGIBILITY
@@ -254,6 +271,7 @@ static int32 ipopt_destroy(slv_system_t server, SlvClientToken asys){
 	sys = SYS(asys);
 	slv_destroy_parms(&(sys->p));
 	if(sys->s.cost) ascfree(sys->s.cost);
+	ipopt_hess_destroy(sys);
 	ASC_FREE(sys);
 	ERROR_REPORTER_HERE(ASC_PROG_WARNING,"ipopt_destroy still needs debugging");
 	return 0;
@@ -820,6 +838,131 @@ Bool ipopt_eval_jac_g(Index n, Number* x, Bool new_x, Index m
 	return TRUE;
 }
 
+/*------------------------------------------------------------------------------
+  HESSIAN OF THE LAGRANGIAN
+*/
+
+static void ipopt_hess_destroy(IpoptSystem *sys){
+#define HFREE(P) if(sys->P!=NULL){ASC_FREE(sys->P); sys->P = NULL;}
+	HFREE(hess_row); HFREE(hess_col); HFREE(hess_rels);
+	HFREE(hess_posstart); HFREE(hess_pos);
+	HFREE(hess_slotstart); HFREE(hess_slot); HFREE(hess_scratch);
+#undef HFREE
+	sys->hess_nrels = 0;
+}
+
+/** pack a lower-triangle coordinate into one sortable key */
+#define HESS_KEY(R,C) (((long long)(R) << 32) | (unsigned)(C))
+
+static int hess_key_cmp(const void *a, const void *b){
+	long long ka = *(const long long *)a, kb = *(const long long *)b;
+	return (ka > kb) - (ka < kb);
+}
+
+/**
+	Work out the sparsity structure of the Hessian of the Lagrangian from
+	the nonlinear incidences of the objective and each constraint (see
+	relman_hess_pattern), and the mapping from each relation's packed
+	second derivatives into IPOPT's values[] array. Sets sys->nnzH.
+	@return 0 on success.
+*/
+static int ipopt_hess_analyse(IpoptSystem *sys){
+	struct var_variable **incidence_list;
+	struct rel_relation *rel;
+	long long *keys, *uniq, key;
+	unsigned long *pos;
+	int32 k, a, b, cnt, maxlen = 0, npos = 0, nslot = 0, nuniq, lo, hi, mid;
+	int32 si, sj;
+
+	ipopt_hess_destroy(sys);
+
+	sys->hess_nrels = sys->m + 1;
+	sys->hess_rels = ASC_NEW_ARRAY(struct rel_relation *,sys->hess_nrels);
+	sys->hess_posstart = ASC_NEW_ARRAY(int32,sys->hess_nrels + 1);
+	sys->hess_slotstart = ASC_NEW_ARRAY(int32,sys->hess_nrels + 1);
+	sys->hess_rels[0] = sys->obj;
+	for(k = 1; k < sys->hess_nrels; ++k){
+		sys->hess_rels[k] = sys->rlist[k-1];
+	}
+	for(k = 0; k < sys->hess_nrels; ++k){
+		cnt = rel_n_incidences(sys->hess_rels[k]);
+		npos += cnt;
+		if(cnt > maxlen)maxlen = cnt;
+	}
+
+	/* nonlinear incidences of each relation */
+	sys->hess_pos = ASC_NEW_ARRAY(unsigned long,npos + 1);
+	npos = 0;
+	maxlen = 0;
+	for(k = 0; k < sys->hess_nrels; ++k){
+		sys->hess_posstart[k] = npos;
+		sys->hess_slotstart[k] = nslot;
+		cnt = relman_hess_pattern(sys->hess_rels[k],&(sys->vfilt),sys->hess_pos + npos);
+		npos += cnt;
+		nslot += (cnt*(cnt+1))/2;
+		if(cnt > maxlen)maxlen = cnt;
+	}
+	sys->hess_posstart[k] = npos;
+	sys->hess_slotstart[k] = nslot;
+	sys->hess_scratch = ASC_NEW_ARRAY(double,(maxlen*(maxlen+1))/2 + 1);
+
+	/* global coordinates of every packed entry, then sort and merge */
+	keys = ASC_NEW_ARRAY(long long,nslot + 1);
+	uniq = ASC_NEW_ARRAY(long long,nslot + 1);
+	if(keys==NULL || uniq==NULL || sys->hess_scratch==NULL){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Insufficient memory for Hessian structure");
+		if(keys)ASC_FREE(keys);
+		if(uniq)ASC_FREE(uniq);
+		ipopt_hess_destroy(sys);
+		return 1;
+	}
+	nslot = 0;
+	for(k = 0; k < sys->hess_nrels; ++k){
+		rel = sys->hess_rels[k];
+		incidence_list = (struct var_variable**)rel_incidence_list(rel);
+		pos = sys->hess_pos + sys->hess_posstart[k];
+		cnt = sys->hess_posstart[k+1] - sys->hess_posstart[k];
+		for(a = 0; a < cnt; ++a){
+			si = var_sindex(incidence_list[pos[a]]);
+			for(b = 0; b <= a; ++b){
+				sj = var_sindex(incidence_list[pos[b]]);
+				keys[nslot++] = (si >= sj) ? HESS_KEY(si,sj) : HESS_KEY(sj,si);
+			}
+		}
+	}
+	memcpy(uniq,keys,nslot*sizeof(long long));
+	qsort(uniq,nslot,sizeof(long long),hess_key_cmp);
+	nuniq = 0;
+	for(a = 0; a < nslot; ++a){
+		if(nuniq == 0 || uniq[nuniq-1] != uniq[a]){
+			uniq[nuniq++] = uniq[a];
+		}
+	}
+
+	sys->nnzH = nuniq;
+	sys->hess_row = ASC_NEW_ARRAY(Index,nuniq + 1);
+	sys->hess_col = ASC_NEW_ARRAY(Index,nuniq + 1);
+	for(a = 0; a < nuniq; ++a){
+		sys->hess_row[a] = (Index)(uniq[a] >> 32);
+		sys->hess_col[a] = (Index)(uniq[a] & 0xffffffffLL);
+	}
+	sys->hess_slot = ASC_NEW_ARRAY(Index,nslot + 1);
+	for(a = 0; a < nslot; ++a){
+		key = keys[a];
+		lo = 0; hi = nuniq - 1;
+		while(lo < hi){
+			mid = (lo + hi) / 2;
+			if(uniq[mid] < key)lo = mid + 1; else hi = mid;
+		}
+		asc_assert(uniq[lo] == key);
+		sys->hess_slot[a] = lo;
+	}
+
+	ASC_FREE(keys);
+	ASC_FREE(uniq);
+	return 0;
+}
+
 Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 		, Number obj_factor, Index m, Number* lambda
 		, Bool new_lambda, Index nele_hess, Index* iRow
@@ -829,16 +972,9 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 	IpoptSystem *sys;
 	sys = SYS(user_data);
 
-	int res,count;
-
-	struct var_variable **incidence_list;
-
-	ltmatrix *hess_matrix;
-
-	unsigned long i;
-
-	Index row;
-	Index col;
+	int res;
+	int32 k, t, cnt, ntri;
+	double factor;
 	Index idx;
 
 	//CONSOLE_DEBUG("IN FUNCTION ipopt_eval_h");
@@ -848,6 +984,7 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 	asc_assert(sys!=NULL);
 	asc_assert(n==sys->n);
 	asc_assert(nele_hess==sys->nnzH);
+	asc_assert(sys->hess_row!=NULL || nele_hess==0);
 
 	if(new_x){
 		res = ipopt_update_model(sys,x);
@@ -856,90 +993,39 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 
 	if(values == NULL){
 		asc_assert(iRow !=NULL && jCol != NULL);
-
-		CONSOLE_DEBUG("Determining sparsity structure of the hessian of the lagrangian");
-
-		/* identify the sparsity structure of the Hessian (note: only the lower-
-		left part is required by IPOPT , because the Hessian is symmetric) */
-		//CONSOLE_DEBUG("Analysing of Hessian matrix sparsity structure not implemented");
-		//CONSOLE_DEBUG("Dense Hessian Calculations being performed");
-
-		idx = 0;
-
-		for (row = 0; row < n; row++) {
-			for (col = 0; col <= row; col++) {
-				iRow[idx] = row;
-				jCol[idx] = col;
-				idx++;
-			}
+		/* structure was found in ipopt_hess_analyse (only the lower-left
+		part is required by IPOPT, because the Hessian is symmetric) */
+		for(idx = 0; idx < nele_hess; idx++){
+			iRow[idx] = sys->hess_row[idx];
+			jCol[idx] = sys->hess_col[idx];
 		}
-		asc_assert(idx == nele_hess);
-
-		CONSOLE_DEBUG("Done with sparsity calc, there are %d elements",idx);
-	}
-	else{
+	}else{
 		asc_assert(jCol==NULL && iRow==NULL);
 		asc_assert(lambda!=NULL);
+		asc_assert(m==sys->m);
 
-		/** Array of LT matrix */
-		hess_matrix = ltmatrix_create(LTMATRIX_LOWER,n);
-
-		//CONSOLE_DEBUG("Order of Hessian MATRIX [%d x %d]",n,n);
-
-		/** Correction for objective function **/
-		//CONSOLE_DEBUG("Correction for Objective Relation underway");
-		relman_hess(sys->obj,&(sys->vfilt),hess_matrix,&count,n,SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL));
-
-		idx = 0;
-
-		for (row = 0; row < n; row++) {
-			for (col = 0; col <= row; col++) {
-				values[idx] = ltmatrix_get_element(hess_matrix,row,col) * (obj_factor);
-				idx++;
-			}
+		for(idx = 0; idx < nele_hess; idx++){
+			values[idx] = 0.0;
 		}
-		asc_assert(idx == nele_hess);
-
-
-		/** Correction for m-relations **/
-
-
-		for(i=0; i<m; i++){
-			/** @TODO Initialize the Hess Matrix Elements to zero */
-			ltmatrix_clear(hess_matrix);
-
-			incidence_list = (struct var_variable**) rel_incidence_list(sys->rlist[i]);
-			if(incidence_list!=NULL){
-				//CONSOLE_DEBUG("Correction for Constraint Relation [%lu] underway",i);
-				relman_hess(sys->rlist[i],&(sys->vfilt),hess_matrix,&count,n,SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL));
-
-				idx=0;
-
-				for (row = 0; row < n; row++) {
-					for (col = 0; col <= row; col++) {
-						values[idx] +=  ltmatrix_get_element(hess_matrix,row,col) * (lambda[i]);
-						idx++;
-					}
-				}
-				asc_assert(idx == nele_hess);
 
+		for(k = 0; k < sys->hess_nrels; k++){
+			factor = (k == 0) ? obj_factor : lambda[k-1];
+			cnt = sys->hess_posstart[k+1] - sys->hess_posstart[k];
+			if(factor == 0.0 || cnt == 0)continue;
+			if(relman_hess_sparse(sys->hess_rels[k]
+					, sys->hess_pos + sys->hess_posstart[k], cnt
+					, sys->hess_scratch, SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL)
+			)){
+				return FALSE;
 			}
-			else{
-				ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unused Relation???");
-				ltmatrix_destroy(hess_matrix);
-				return FALSE; //I'm not sure about the action to take.
+			ntri = (cnt*(cnt+1))/2;
+			for(t = 0; t < ntri; t++){
+				values[sys->hess_slot[sys->hess_slotstart[k] + t]] += factor * sys->hess_scratch[t];
 			}
 		}
-
-		//CONSOLE_DEBUG("Hessian Matrix evaluation successful");
-
-		ltmatrix_destroy(hess_matrix);
-
-		/* evaluate the Hessian matrix */
-		//CONSOLE_DEBUG("Evaluation of Hessian matrix Completed");
 	}
 
-	return TRUE; /* fail: not yet implemented */
+	return TRUE;
 }
 
 /*------------------------------------------------------------------------------
@@ -1021,11 +1107,12 @@ static int ipopt_presolve(slv_system_t server, SlvClientToken asys){
 
 	//CONSOLE_DEBUG("got objective rel %p",sys->obj);
 
-	/* calculate nnz for hessian matrix @todo FIXME */
+	/* sparsity structure of the hessian of the lagrangian */
 
 	if(strcmp(SLV_PARAM_CHAR(&(sys->p),IPOPT_PARAM_HESS_APPROX),"exact")==0){
-		/** @todo fix rtot to be 'm' instead */
-		sys->nnzH = ((sys->n)*((sys->n)+1))/2; //dense Hessian count
+		if(ipopt_hess_analyse(sys)){
+			return -5;
+		}
 	}else{
 		//CONSOLE_DEBUG("Skipping relman_hessian_count as hessian method is not exact.");
 		//sys->nnzH = sys->n * sys->m;
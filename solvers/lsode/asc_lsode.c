@@ -122,6 +122,7 @@ extern ASC_EXPORT int lsode_register(void){
 #define LSODE_FEX fex
 #define GETCOMMON get_lsode_common
 #define XASCWV xascwv
+#define SRCOM srcom
 #else
 /* sun, __alpha, __sgi, ... */
 #define LSODE lsode_
@@ -129,6 +130,7 @@ extern ASC_EXPORT int lsode_register(void){
 #define LSODE_FEX fex_
 #define GETCOMMON get_lsode_common_
 #define XASCWV xascwv_
+#define SRCOM srcom_
 #endif
 
 #if defined(CRAY) || (defined(__WIN32__) && !defined(__MINGW32_VERSION))
@@ -137,7 +139,9 @@ extern ASC_EXPORT int lsode_register(void){
 #undef LSODE_FEX
 #undef GETCOMMON
 #undef XASCWV
+#undef SRCOM
 #define XASCWV XASCWV
+#define SRCOM SRCOM
 #define LSODE LSODE
 #define LSODE_JEX JEX
 #define LSODE_FEX FEX
@@ -147,7 +151,9 @@ extern ASC_EXPORT int lsode_register(void){
 #if defined(__MINGW32__) || defined(__MINGW64__)
 #undef LSODE
 #undef XASCWV
+#undef SRCOM
 #define XASCWV xascwv_
+#define SRCOM srcom_
 #define LSODE lsode_
 #endif
 
@@ -171,11 +177,16 @@ void InitTolNames(void){
 */
 
 /**
-	Because LSODE doesn't seem to make an allowance for 'client data' we
-	have to store this as a 'local global' and fish it out when we're in the
+	LSODE makes no allowance for 'client data', but it passes its NEQ
+	argument through to FEX and JEX untouched, and allows NEQ to be an
+	array with the number of equations in NEQ(1). So we pass the address
+	of one of these, and fish the IntegratorSystem out of it in the
 	callbacks.
 */
-static IntegratorSystem *l_lsode_blsys = 0;
+typedef struct IntegratorLsodeNeqStruct{
+	int neq; /**< must come first: LSODE reads this as NEQ(1) */
+	IntegratorSystem *blsys;
+} IntegratorLsodeNeq;
 
 typedef enum{
 	lsode_none=0		/* true on first call */
@@ -194,10 +205,12 @@ typedef enum{
 	Enumeration to tell ASCEND if anything failed in a FEX or JEX call.
 */
 
+/* sizes of the arrays for SRCOM; see lsode.f */
+#define LSODE_LENRSAV 218
+#define LSODE_LENISAV 41
+
 typedef struct IntegratorLsodeDataStruct{
 	long n_eqns;                     /**< dimension of state vector */
-	int *input_indices;              /**< vector of state vars indexes */
-	int *output_indices;             /**< vector of derivative var indexes */
 	struct var_variable **y_vars;    /**< NULL-terminated list of states vars */
 	struct var_variable **ydot_vars; /**< NULL-terminated list of derivative vars*/
 	struct rel_relation **rlist;     /**< NULL-terminated list of relevant rels
@@ -210,31 +223,34 @@ typedef struct IntegratorLsodeDataStruct{
 	int partitioned;                       /* partioned func evals or not */
 
 	clock_t lastwrite;                     /* time of last call to the reporter 'write' function */
+	short fex_clockcheck;                  /* FEX calls, for the clock check */
+	short jex_clockcheck;                  /* JEX calls, for the clock check */
+
+	double rsav[LSODE_LENRSAV];            /**< COMMON /LS0001/ between LSODE calls */
+	int isav[LSODE_LENISAV];               /**< ditto, and COMMON /EH0001/ */
 } IntegratorLsodeData;
 
 /**<
-	Global data structure for LSODE.
+	Data structure for LSODE, one per IntegratorSystem.
 
-	@NOTE LSODE is not reentrant! @ENDNOTE
+	@NOTE The Fortran LSODE keeps its own state in COMMON /LS0001/. That is
+	threadprivate (see lsode.f), and between LSODE calls it is kept here,
+	with SRCOM, so that integrations on other threads or nested inside
+	this one's callbacks don't disturb it. @ENDNOTE
 */
 
-/** Macro to declare a local var and fetch the 'enginedata' stuff into it from l_lsode_blsys. */
-#define LSODEDATA_GET(N) \
+/**
+	Macro to declare local vars B and N and fetch the IntegratorSystem and
+	its 'enginedata' into them from the NEQ argument of a callback.
+*/
+#define LSODEDATA_GET(NEQ,B,N) \
+	IntegratorSystem *B; \
 	IntegratorLsodeData *N; \
-	asc_assert(l_lsode_blsys!=NULL); \
-	N = (IntegratorLsodeData *)l_lsode_blsys->enginedata; \
+	B = ((IntegratorLsodeNeq *)(NEQ))->blsys; \
+	asc_assert(B!=NULL); \
+	N = (IntegratorLsodeData *)B->enginedata; \
 	asc_assert(N!=NULL)
 
-/** Macro to set the globa l_lsode_blsys to the currently blsys ptr. */
-#define LSODEDATA_SET(N) \
-	asc_assert(l_lsode_blsys==NULL); \
-	asc_assert(N!=NULL); \
-	l_lsode_blsys = N
-
-#define LSODEDATA_RELEASE() \
-	asc_assert(l_lsode_blsys!=NULL); \
-	l_lsode_blsys = NULL;
-
 /*----------------------------
   Function types that LSODE wants to use
 */
@@ -272,6 +288,12 @@ void LSODE(LsodeEvalFn*,int *neq ,double *y ,double *x
 	  ,LsodeJacobianFn *jex ,int *mf
 );
 
+/**
+	Save (job = 1) or restore (job = 2) LSODE's COMMON blocks for the
+	calling thread. Also a Fortran function.
+*/
+void SRCOM(double *rsav, int *isav, int *job);
+
 /*------------------------------------------------------
   Memory allocation/free
 */
@@ -280,8 +302,6 @@ static void integrator_lsode_create(IntegratorSystem *blsys){
 	IntegratorLsodeData *d;
 	d = ASC_NEW_CLEAR(IntegratorLsodeData);
 	d->n_eqns=0;
-	d->input_indices=NULL;
-	d->output_indices=NULL;
 	d->y_vars=NULL;
 	d->ydot_vars=NULL;
 	d->rlist=NULL;
@@ -298,12 +318,6 @@ static void integrator_lsode_free(void *enginedata){
 	IntegratorLsodeData d;
 	d = *((IntegratorLsodeData *)enginedata);
 
-	if(d.input_indices)ASC_FREE(d.input_indices);
-	d.input_indices = NULL;
-
-	if(d.output_indices)ASC_FREE(d.output_indices);
-	d.output_indices = NULL;
-
 	if(d.y_vars)ASC_FREE(d.y_vars);
 	d.y_vars = NULL;
 
@@ -454,7 +468,6 @@ static int integrator_lsode_setup_diffs(IntegratorSystem *blsys) {
 	unsigned long nch,i;
 
 	struct var_variable **vp;
-	int *ip;
 
 	IntegratorLsodeData *enginedata;
 	asc_assert(blsys!=NULL);
@@ -466,17 +479,15 @@ static int integrator_lsode_setup_diffs(IntegratorSystem *blsys) {
 		Put the
 		Let us now process what we consider *inputs* to the problem as
 		far as ASCEND is concerned; i.e. the state vars or the y_vars's
-		if you prefer.
+		if you prefer. Their indices (and those of the derivatives) were
+		mapped once by integrator_analyse, in blsys->jacobian.
 	*/
 	nch = enginedata->n_eqns;
 
 	vp = enginedata->y_vars;
-	ip = enginedata->input_indices;
 	for (i=0;i<nch;i++) {
 		*vp = (struct var_variable *)blsys->y[i];
-		*ip = var_sindex(*vp);
 		vp++;
-		ip++;
 	}
 	*vp = NULL;	/* terminate */
 
@@ -484,13 +495,10 @@ static int integrator_lsode_setup_diffs(IntegratorSystem *blsys) {
 		Let us now go for the outputs, ie the derivative terms.
 	*/
 	vp = enginedata->ydot_vars;
-	ip = enginedata->output_indices;
 	for (i=0;i<nch;i++) {
 		*vp = (struct var_variable *)blsys->ydot[i];
-		*ip = var_sindex(*vp);
 		vp++;		/* dont assume that a var is synonymous with */
-		ip++;		/* an Instance; that might/will change soon */
-	}
+	}			/* an Instance; that might/will change soon */
 	*vp = NULL;		/* terminate */
 
 	return 0;
@@ -661,11 +669,9 @@ static int integrator_lsode_derivatives(IntegratorSystem *blsys
 		, int ninputs
 		, int noutputs
 ){
-  static int n_calls = 0;
   linsolqr_system_t linsys;	/* stuff for the linear system & matrix */
   mtx_matrix_t mtx;
-  int32 capacity;
-  real64 *scratch_vector = NULL;
+  IntegratorJacobian *jac;
   int result=0;
   IntegratorLsodeData *enginedata;
 
@@ -673,11 +679,9 @@ static int integrator_lsode_derivatives(IntegratorSystem *blsys
   enginedata = (IntegratorLsodeData *)blsys->enginedata;
   asc_assert(enginedata!=NULL);
   asc_assert(DENSEMATRIX_DATA(enginedata->dydot_dy)!=NULL);
-  asc_assert(enginedata->input_indices!=NULL);
-
-  int *inputs_ndx_list = enginedata->input_indices;
-  int *outputs_ndx_list = enginedata->output_indices;
-  asc_assert(ninputs == blsys->n_y);
+  jac = blsys->jacobian;
+  asc_assert(jac!=NULL);
+  asc_assert(ninputs == jac->n && noutputs == jac->n);
 
   (void)NumberFreeVars(NULL);		/* used to re-init the system */
   (void)NumberIncludedRels(NULL);	/* used to re-init the system */
@@ -686,46 +690,51 @@ static int integrator_lsode_derivatives(IntegratorSystem *blsys
     return 1;
   }
 
-  result = Compute_J(blsys->system);
-  if (result) {
-    FPRINTF(stderr,"Early termination due to failure in calc Jacobian\n");
-    return 1;
-  }
-
   linsys = slv_get_linsolqr_sys(blsys->system);	/* get the linear system */
   if (linsys==NULL) {
     FPRINTF(stderr,"Early termination due to missing linsolqr system.\n");
     return 1;
   }
+  integrator_jacobian_begin(jac,linsys);
+
+  result = Compute_J(blsys->system);
+  if (result) {
+    FPRINTF(stderr,"Early termination due to failure in calc Jacobian\n");
+    goto done;
+  }
+
   mtx = slv_get_sys_mtx(blsys->system);	/* get the matrix */
   if (mtx==NULL) {
     FPRINTF(stderr,"Early termination due to missing mtx in linsolqr.\n");
-    return 1;
+    result = 1;
+    goto done;
+  }
+  /* the rhs is zeroed again by Compute_dy_dx_smart after each solve */
+  if (integrator_jacobian_reserve(jac,mtx_capacity(mtx))) {
+    FPRINTF(stderr,"Early termination due to lack of memory.\n");
+    result = 1;
+    goto done;
   }
-  capacity = mtx_capacity(mtx);
-  scratch_vector = ASC_NEW_ARRAY_CLEAR(real64,capacity);
-  linsolqr_add_rhs(linsys,scratch_vector,FALSE);
+  linsolqr_add_rhs(linsys,jac->rhs,FALSE);
 
   result = LUFactorJacobian(blsys->system);
   if (result) {
     FPRINTF(stderr,"Early termination due to failure in LUFactorJacobian\n");
     goto error;
   }
-  result = Compute_dy_dx_smart(blsys->system, scratch_vector, enginedata->dydot_dy,
-                               inputs_ndx_list, ninputs,
-                               outputs_ndx_list, noutputs);
+  result = Compute_dy_dx_smart(blsys->system, jac->rhs, enginedata->dydot_dy,
+                               jac->y_sindex, ninputs,
+                               jac->ydot_sindex, noutputs);
 
-  linsolqr_remove_rhs(linsys,scratch_vector);
   if (result) {
     FPRINTF(stderr,"Early termination due to failure in Compute_dy_dx\n");
     goto error;
   }
 
 error:
-  n_calls++;
-  if(scratch_vector){
-    ascfree((char *)scratch_vector);
-  }
+  linsolqr_remove_rhs(linsys,jac->rhs);
+done:
+  integrator_jacobian_end(jac);
   return result;
 }
 
@@ -736,13 +745,11 @@ error:
 	function calls.  This code below attempts to handle these cases.
 */
 static void LSODE_FEX( int *n_eq ,double *t ,double *y ,double *ydot){
-	static short clockcheck = 0;
-  slv_status_t status;
-  LSODEDATA_GET(lsodedata);
+  LSODEDATA_GET(n_eq,blsys,lsodedata);
 
   /*  slv_parameters_t parameters; pity lsode doesn't allow error returns */
   /* int i; */
-  unsigned long res;
+  int res;
 
 #ifdef TIMING_DEBUG
   clock_t time1,time2;
@@ -758,50 +765,31 @@ static void LSODE_FEX( int *n_eq ,double *t ,double *y ,double *ydot){
   /*
  	t[1]=t[0]; can't do this. lsode calls us with a different t than the t we sent in.
   */
-  integrator_set_t(l_lsode_blsys, t[0]);
-  integrator_set_y(l_lsode_blsys, y);
+  integrator_set_t(blsys, t[0]);
+  integrator_set_y(blsys, y);
 
 #ifdef TIMING_DEBUG
   time2 = clock();
 #endif
 
-  switch(lsodedata->lastcall) {
-  case lsode_none:		/* first call */
-	CONSOLE_DEBUG("FIRST CALL...");
-
-  case lsode_derivative:
-    if (lsodedata->partitioned) {
-			/* CONSOLE_DEBUG("PRE-SOLVE"); */
-      slv_presolve(l_lsode_blsys->system);
-    } else {
-			/** @TODO this doesn't ever seem to be called */
-			CONSOLE_DEBUG("RE-SOLVE");
-      slv_resolve(l_lsode_blsys->system);
-    }
-    break;
-  default:
-  case lsode_function:
-    slv_resolve(l_lsode_blsys->system);
-    break;
-  }
-
-  if((res = slv_solve(l_lsode_blsys->system))){
-		CONSOLE_DEBUG("solver returns error %ld",res);
-	}
+  /*
+	Solve for the derivatives, warm-started from the previous calls (or
+	directly, if they are explicit in the states). The first call, and
+	the first after a partitioned derivative evaluation, presolve.
+  */
+  res = integrator_solve_algebraic(blsys
+    , lsodedata->lastcall == lsode_derivative && lsodedata->partitioned
+  );
 
-  slv_get_status(l_lsode_blsys->system, &status);
   CONSOLE_DEBUG("Calling slv_check_bounds with lo = 0, hi = -1");
-  if(slv_check_bounds(l_lsode_blsys->system,0,-1,"")){
+  if(slv_check_bounds(blsys->system,0,-1,"")){
     lsodedata->status = lsode_nok;
   }
 
-  /* pass the solver status to the integrator */
-  res = integrator_checkstatus(status);
-
 	/* Do we need to do clock check? */
-	if((++clockcheck % ASC_CLOCK_CHECK_PERIOD)==0){
+	if((++lsodedata->fex_clockcheck % ASC_CLOCK_CHECK_PERIOD)==0){
 		if((clock() - lsodedata->lastwrite) > ASC_CLOCK_MAX_GUI_WAIT){
-			integrator_output_write(l_lsode_blsys);
+			integrator_output_write(blsys);
 			lsodedata->lastwrite = clock(); /* don't count the update time, or we might never get anything done */
 		}
 	}
@@ -829,7 +817,7 @@ static void LSODE_FEX( int *n_eq ,double *t ,double *y ,double *ydot){
     lsodedata->status = lsode_ok;
     /* ERROR_REPORTER_HERE(ASC_PROG_NOTE,"lsodedata->status = %d",lsodedata->status); */
   }
-  integrator_get_ydot(l_lsode_blsys, ydot);
+  integrator_get_ydot(blsys, ydot);
 
   lsodedata->lastcall = lsode_function;
 #ifdef TIMING_DEBUG
@@ -844,11 +832,10 @@ static void LSODE_FEX( int *n_eq ,double *t ,double *y ,double *ydot){
 static void LSODE_JEX(int *neq ,double *t, double *y
 		, int *ml ,int *mu ,double *pd, int *nrpd
 ){
-	static short clockcheck = 0;
   int nok = 0;
   int i,j;
 
-  LSODEDATA_GET(lsodedata);
+  LSODEDATA_GET(neq,blsys,lsodedata);
 
   UNUSED_PARAMETER(t);
   UNUSED_PARAMETER(y);
@@ -866,7 +853,7 @@ static void LSODE_JEX(int *neq ,double *t, double *y
    * Make the real call.
    */
 
-  nok = integrator_lsode_derivatives(l_lsode_blsys
+  nok = integrator_lsode_derivatives(blsys
 		, *neq
 		, *nrpd
   );
@@ -883,13 +870,13 @@ static void LSODE_JEX(int *neq ,double *t, double *y
   }
 
 	/* Do we need to do clock check? */
-	if((++clockcheck % ASC_CLOCK_CHECK_PERIOD)==0){
+	if((++lsodedata->jex_clockcheck % ASC_CLOCK_CHECK_PERIOD)==0){
 		/* do we need to update the GUI? */
 #ifdef TIMING_DEBUG
 		CONSOLE_DEBUG("CLOCK = %ld", clock());
 #endif
 		if((clock() - lsodedata->lastwrite) > ASC_CLOCK_MAX_GUI_WAIT){
-			integrator_output_write(l_lsode_blsys);
+			integrator_output_write(blsys);
 			lsodedata->lastwrite = clock(); /* don't count the update time, or we might never get anything done */
 		}
 	}
@@ -916,11 +903,11 @@ static void LSODE_JEX(int *neq ,double *t, double *y
 }
 
 /**
-	The public function: here we do the actual integration, I guess.
+	The integration itself, for integrator_lsode_solve.
 
 	Return 0 on success
 */
-static int integrator_lsode_solve(IntegratorSystem *blsys
+static int integrator_lsode_run(IntegratorSystem *blsys
 		, unsigned long start_index, unsigned long finish_index
 ){
 
@@ -938,11 +925,12 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 	double * rwork;
 	int * iwork;
 	double *y, *abtol, *reltol, *obs, *dydx;
-	int my_neq;
+	IntegratorLsodeNeq my_neq;
 	int reporterstatus;
 	const char *method; /* Table 3.1 in D&UoLSODE */
 	int miter; /* Table 3.2 in D&UoLSODE */
 	int maxord; /* page 92 in D&UoLSODE */
+	int save = 1, restore = 2; /* SRCOM jobs */
 
 	d = (IntegratorLsodeData *)(blsys->enginedata);
 
@@ -950,8 +938,6 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 	d->n_eqns = blsys->n_y;
 	assert(d->n_eqns>0);
 
-	d->input_indices = ASC_NEW_ARRAY_CLEAR(int, d->n_eqns);
-	d->output_indices = ASC_NEW_ARRAY_CLEAR(int, d->n_eqns);
 	d->dydot_dy = densematrix_create(d->n_eqns,d->n_eqns);
 
 	d->y_vars = ASC_NEW_ARRAY(struct var_variable *,d->n_eqns+1);
@@ -1085,7 +1071,9 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
   integrator_output_write(blsys);
   integrator_output_write_obs(blsys);
 
-  my_neq = (int)neq;
+  /* LSODE hands this back to FEX and JEX as NEQ */
+  my_neq.neq = (int)neq;
+  my_neq.blsys = blsys;
 
   /*
 	First time entering lsode, x is input. After that,
@@ -1131,20 +1119,22 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 
       d->lastwrite = clock();
 
-      /* provides some rudimentary locking to prevent reentrance*/
-      LSODEDATA_SET(blsys);
-
-      LSODE(&(LSODE_FEX), &my_neq, y, x, &xend,
+      /* carry on from where our last call left off */
+      if(istate != 1)SRCOM(d->rsav, d->isav, &restore);
+      LSODE(&(LSODE_FEX), &my_neq.neq, y, x, &xend,
             &itol, reltol, abtol, &itask, &istate,
             &iopt ,rwork, &lrw, iwork, &liw, &(LSODE_JEX), &mf);
-
-      /* clear the global var */
-      LSODEDATA_RELEASE();
+      SRCOM(d->rsav, d->isav, &save);
+# ifdef ASC_SIGNAL_TRAPS
+      Asc_SignalFPECheck();
+# endif
 
       CONSOLE_DEBUG("...");
 
 # ifdef ASC_SIGNAL_TRAPS
     }else{
+      Asc_SignalHandlerPopDefault(SIGFPE);
+      Asc_SignalHandlerPopDefault(SIGINT);
       if(s_fpe){
         ERROR_REPORTER_HERE(ASC_PROG_ERR,"Integration terminated due to float error in LSODE call.");
         lsode_free_mem(y,reltol,abtol,rwork,iwork,obs,dydx);
@@ -1225,9 +1215,7 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
            x1 usually wouldn't be x0 precisely if the x1/x0
            scheme worked, which it doesn't anyway. */
 
-        LSODEDATA_SET(blsys);
-        LSODE_FEX(&my_neq, x, y, dydx);
-        LSODEDATA_RELEASE();
+        LSODE_FEX(&my_neq.neq, x, y, dydx);
 
         /* calculate observations, if any, at returned x and y. */
         obs = integrator_get_observations(blsys, obs);
@@ -1270,6 +1258,30 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
   return 0; /* success */
 }
 
+/**
+	The public function: here we do the actual integration, I guess.
+
+	LSODE's COMMON blocks are put back as they were on the way out, in case
+	this integration was started from a callback of another one on this
+	thread.
+
+	Return 0 on success
+*/
+static int integrator_lsode_solve(IntegratorSystem *blsys
+		, unsigned long start_index, unsigned long finish_index
+){
+	double rsav[LSODE_LENRSAV];
+	int isav[LSODE_LENISAV];
+	int job, res;
+
+	job = 1;
+	SRCOM(rsav, isav, &job);
+	res = integrator_lsode_run(blsys, start_index, finish_index);
+	job = 2;
+	SRCOM(rsav, isav, &job);
+	return res;
+}
+
 /**
 	Function XASCWV is an error reporting function replacing the XERRWV
 	routine in lsode.f. The call signature is the same with the original Fortran
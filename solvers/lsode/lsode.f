@@ -973,6 +973,9 @@ c for communication.  the block is declared in subroutines
 c lsode, intdy, stode, prepj, and solsy.  groups of variables are
 c replaced by dummy arrays in the common declarations in routines
 c where those variables are not used.
+c for ascend the blocks are declared threadprivate, so that (compiled
+c with -fopenmp) each thread has its own copy and lsode can run on
+c several threads at once.
 c-----------------------------------------------------------------------
       common /ls0001/ rowns(209),
      1   ccmax, el0, h, hmin, hmxi, hu, rc, tn, uround,
@@ -980,6 +983,7 @@ c-----------------------------------------------------------------------
      3   mxstep, mxhnil, nhnil, ntrep, nslast, nyh, iowns(6),
      4   icf, ierpj, iersl, jcur, jstart, kflag, l, meth, miter,
      5   maxord, maxcor, msbp, mxncf, n, nq, nst, nfe, nje, nqu
+c$omp threadprivate (/ls0001/)
 c
       data  mord(1),mord(2)/12,5/, mxstp0/500/, mxhnl0/10/
 
@@ -1538,6 +1542,7 @@ clll. optimize
      3   iownd(14), iowns(6),
      4   icf, ierpj, iersl, jcur, jstart, kflag, l, meth, miter,
      5   maxord, maxcor, msbp, mxncf, n, nq, nst, nfe, nje, nqu
+c$omp threadprivate (/ls0001/)
 c-----------------------------------------------------------------------
 c this routine manages the solution of the linear system arising from
 c a chord iteration.  it is called if miter .ne. 0.
@@ -1613,6 +1618,7 @@ Ckaa  double precision time1, time2
      3   iownd(14), iowns(6),
      4   icf, ierpj, iersl, jcur, jstart, kflag, l, meth, miter,
      5   maxord, maxcor, msbp, mxncf, n, nq, nst, nfe, nje, nqu
+c$omp threadprivate (/ls0001/)
 c-----------------------------------------------------------------------
 c prepj is called by stode to compute and process the matrix
 c p = i - h*el(1)*j , where j is an approximation to the jacobian.
@@ -1790,6 +1796,7 @@ clll. optimize
      3   ialth, ipup, lmax, meo, nqnyh, nslp,
      4   icf, ierpj, iersl, jcur, jstart, kflag, l, meth, miter,
      5   maxord, maxcor, msbp, mxncf, n, nq, nst, nfe, nje, nqu
+c$omp threadprivate (/ls0001/)
 c-----------------------------------------------------------------------
 c stode performs one step of the integration of an initial value
 c problem for a system of ordinary differential equations.
@@ -2388,6 +2395,7 @@ clll. optimize
      3   iownd(14), iowns(6),
      4   icf, ierpj, iersl, jcur, jstart, kflag, l, meth, miter,
      5   maxord, maxcor, msbp, mxncf, n, nq, nst, nfe, nje, nqu
+c$omp threadprivate (/ls0001/)
 c-----------------------------------------------------------------------
 c intdy computes interpolated values of the k-th derivative of the
 c dependent variable vector y, and stores it in dky.  this routine
@@ -2590,11 +2598,57 @@ c-----------------------------------------------------------------------
       double precision rowns, rcomm
       common /ls0001/ rowns(209), rcomm(9),
      1   illin, iduma(10), ntrep, idumb(2), iowns(6), icomm(19)
+c$omp threadprivate (/ls0001/)
       common /eh0001/ mesflg, lunit
+c$omp threadprivate (/eh0001/)
       data illin/0/, ntrep/0/
       data mesflg/1/, lunit/6/
 c
 c----------------------- end of block data -----------------------------
+      end
+      subroutine srcom (rsav, isav, job)
+c-----------------------------------------------------------------------
+c this routine saves or restores (depending on job) the contents of
+c the common blocks ls0001 and eh0001, which are used internally
+c by lsode.
+c
+c rsav = real array of length 218 or more.
+c isav = integer array of length 41 or more.
+c job  = flag indicating to save or restore the common blocks..
+c        job  = 1 if common is to be saved (written to rsav/isav)
+c        job  = 2 if common is to be restored (read from rsav/isav)
+c        a call with job = 2 presumes a prior call with job = 1.
+c-----------------------------------------------------------------------
+      integer isav, job
+      integer ieh, ils
+      integer i, lenils, lenrls
+      double precision rsav,   rls
+      dimension rsav(1), isav(1)
+      common /ls0001/ rls(218), ils(39)
+c$omp threadprivate (/ls0001/)
+      common /eh0001/ ieh(2)
+c$omp threadprivate (/eh0001/)
+      parameter (lenrls = 218, lenils = 39)
+c
+      if (job .eq. 2) go to 100
+c
+      do 10 i = 1,lenrls
+ 10     rsav(i) = rls(i)
+      do 20 i = 1,lenils
+ 20     isav(i) = ils(i)
+      isav(lenils+1) = ieh(1)
+      isav(lenils+2) = ieh(2)
+      return
+c
+ 100  continue
+      do 110 i = 1,lenrls
+ 110    rls(i) = rsav(i)
+      do 120 i = 1,lenils
+ 120    ils(i) = isav(i)
+      ieh(1) = isav(lenils+1)
+      ieh(2) = isav(lenils+2)
+      return
+c----------------------- end of subroutine srcom -----------------------
       end
       subroutine ewset (n, itol, rtol, atol, ycur, ewt)
 clll. optimize
@@ -98,6 +98,8 @@ enum QRSLV_PARAMS{
 	,LINTIME
 	,TRUNCATE
 	,REORDER_OPTION
+	,AMD_CUTOFF
+	,PAR_BLOCK_SIZE
 	,TOO_SMALL
 	,CNLOW
 	,CNHIGH
@@ -197,6 +199,30 @@ struct reduced_data {
   boolean          accurate;     /* Ready to re-compute ? */
 };
 
+/*
+	Scratch space of a worker thread for solving blocks concurrently
+*/
+struct par_worker {
+  linsolqr_system_t      lsys;         /* Linear system of the worker */
+  mtx_matrix_t           mtx;          /* Jacobian of the block */
+  int32                  cap;          /* Order of mtx and vectors */
+  int32                  gcap;         /* Length of grad */
+  real64                 *rhs;         /* Residuals, then Newton step */
+  real64                 *x, *x0;      /* Current and initial values */
+  real64                 *lo, *hi;     /* Bounds */
+  real64                 *res;         /* Residuals */
+  real64                 *grad;        /* Gradient of a relation */
+};
+
+struct par_data {
+  slv_block_dag_t        *dag;         /* Block dependencies, made when needed */
+  char                   *state;       /* PAR_* state of each block */
+  int32                  *level;       /* Wave in which a queued block is solved */
+  struct slv_block_cost  *cost;        /* Cost of each block solved concurrently */
+  struct par_worker      *w;           /* Scratch space, one per pool thread */
+  int32                  nw;           /* Number of workers */
+};
+
 struct qrslv_system_structure {
 
   /* Problem definition */
@@ -204,6 +230,7 @@ struct qrslv_system_structure {
   struct rel_relation         *obj;    /* Objective function: NULL = none */
   struct var_variable         **vlist; /* Variable list (NULL terminated) */
   struct rel_relation         **rlist; /* Relation list (NULL terminated) */
+  struct rel_relation         **blockrels; /* Relations of current block, by row */
 
   /* Solver information */
   int                    integrity;    /* ? Has the system been created */
@@ -225,6 +252,7 @@ struct qrslv_system_structure {
   struct jacobian_data   J;            /* linearized system */
   struct hessian_data    *B;           /* Curvature information */
   struct reduced_data    ZBZ;          /* Reduced hessian */
+  struct par_data        par;          /* Concurrent solution of blocks */
 
   struct vec_vector     nominals;     /* Variable nominals */
   struct vec_vector     weights;      /* Relation weights */
@@ -524,21 +552,21 @@ static boolean calc_inequalities( qrslv_system_t sys){
 	@return 0 on failure, non-zero on success
 */
 static boolean calc_residuals( qrslv_system_t sys){
-  int32 row;
+  int32 row, low, nrows;
   struct rel_relation *rel;
   double time0;
   boolean calc_ok = TRUE;
-  int calc_ok_1;
 
   if(sys->residuals.accurate)return TRUE;
 
-  row = sys->residuals.rng->low;
+  low = sys->residuals.rng->low;
+  nrows = sys->residuals.rng->high - low + 1;
   time0=tm_cpu_time();
 #ifdef ASC_SIGNAL_TRAPS
   Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
 #endif
 
-  for( ; row <= sys->residuals.rng->high; row++ ) {
+  for(row = low; row <= sys->residuals.rng->high; row++ ) {
     rel = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
 #if DEBUG
     if(!rel) {
@@ -550,14 +578,21 @@ static boolean calc_residuals( qrslv_system_t sys){
       );
     }
 #endif
-    sys->residuals.vec[row] = relman_eval(rel,&calc_ok_1,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC));
-    if(!calc_ok_1){
-        calc_ok = FALSE;
+    sys->blockrels[row - low] = rel;
+  }
+
+  /* the residuals of the block may be computed in parallel */
+  if(nrows > 0 && relman_eval_batch(sys->blockrels, nrows
+      , &(sys->residuals.vec[low]), NULL, SLV_PARAM_BOOL(&(sys->p),SAFE_CALC))
+  ){
+    calc_ok = FALSE;
 #if DEBUG
-        CONSOLE_DEBUG("error calculating residual for row %d",row);
+    CONSOLE_DEBUG("error calculating residuals in rows %d..%d",low,low+nrows-1);
 #endif
-    }
+  }
 
+  for(row = 0; row < nrows; row++ ) {
+    rel = sys->blockrels[row];
     if(strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"ABSOLUTE") == 0) {
       relman_calc_satisfied(rel,SLV_PARAM_REAL(&(sys->p),FEAS_TOL));
     }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"RELNOM_SCALE") == 0) {
@@ -584,10 +619,9 @@ static boolean calc_residuals( qrslv_system_t sys){
 	It is initially unscaled.
 */
 static boolean calc_J( qrslv_system_t sys){
-  int32 row;
+  int32 row, nrows;
   var_filter_t vfilter;
   double time0;
-  real64 resid;
 
   if(sys->J.accurate)return TRUE;
 
@@ -596,10 +630,20 @@ static boolean calc_J( qrslv_system_t sys){
   vfilter.matchvalue = (VAR_INBLOCK | VAR_ACTIVE);
   time0=tm_cpu_time();
   mtx_clear_region(sys->J.mtx,&(sys->J.reg));
+  nrows = 0;
   for( row = sys->J.reg.row.low; row <= sys->J.reg.row.high; row++ ) {
-    struct rel_relation *rel;
-    rel = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
-    relman_diffs(rel,&vfilter,sys->J.mtx,&resid,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC));
+    sys->blockrels[nrows++] = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
+  }
+  relman_diffs_batch(sys->blockrels,nrows,&vfilter,sys->J.mtx,NULL
+    ,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC)
+  );
+  /* pack the jacobian once the pattern of a block is known, so that later
+     evaluations just overwrite it. Each new block creates elements outside
+     the packing; repack once there are enough of them. */
+  if(!mtx_is_frozen(sys->J.mtx)
+    || 4*mtx_frozen_misses(sys->J.mtx) > mtx_frozen_nnz(sys->J.mtx)
+  ){
+    mtx_freeze(sys->J.mtx);
   }
   sys->s.block.jactime += (tm_cpu_time() - time0);
   sys->s.block.jacs++;
@@ -2411,6 +2455,417 @@ static void change_maxstep( qrslv_system_t sys, real64 maxstep){
 }
 
 
+/*------------------------------------------------------------------------------
+  CONCURRENT SOLUTION OF INDEPENDENT BLOCKS
+
+  In BLT form a block needs only the values of the variables of the blocks
+  it depends on (see slv_block_dag_create), so blocks with no path between
+  them can be solved at the same time. When QRSlv moves to a block it has
+  not yet looked at, that block and the later blocks which depend only on
+  blocks already solved, or on each other, are solved ahead on the relman
+  thread pool, one task per block and one wave per level of dependency.
+
+  Each task is a damped Newton iteration with the worker's own matrix and
+  linsolqr system, which keeps within the variable bounds and stops when
+  the residuals meet the same test as block_feasible. Only small blocks
+  of relations that can be evaluated from any thread (relman_threadable)
+  are taken. A block that fails is put back as it was and left for the
+  usual iteration, and so are the blocks which depend on it. QRSlv then
+  finds the blocks solved ahead already converged as it walks through
+  them, and their cost is that of the worker.
+*/
+
+#define PAR_UNTRIED 0 /* not yet looked at */
+#define PAR_SOLVED  1 /* solved by a worker */
+#define PAR_SERIAL  2 /* left for the usual iteration */
+#define PAR_WAITING 3 /* can be solved by a worker once its deps are */
+#define PAR_QUEUED  4 /* to be solved by a worker in this sweep */
+
+struct par_sweep {
+  qrslv_system_t         sys;
+  const mtx_block_t      *blocks;
+  int32                  *task;        /* Blocks of the current wave */
+  char                   *ok;          /* ? Did each task converge */
+  real64                 tol;          /* FEAS_TOL */
+  boolean                scaled;       /* ? Tolerance relative to rel nominal */
+  boolean                safe;
+  boolean                bounds;       /* ? Keep within variable bounds */
+  int32                  maxit;
+  int32                  maxminor;
+};
+
+static void par_worker_destroy(struct par_worker *w){
+  if(w->lsys != NULL) {
+    linsolqr_set_matrix(w->lsys,NULL);
+    linsolqr_destroy(w->lsys);
+    mtx_destroy(w->mtx);
+  }
+  destroy_array(w->rhs);
+  destroy_array(w->x);
+  destroy_array(w->x0);
+  destroy_array(w->lo);
+  destroy_array(w->hi);
+  destroy_array(w->res);
+  destroy_array(w->grad);
+  memset(w,0,sizeof(struct par_worker));
+}
+
+/**
+	Make sure that the worker can take blocks of up to n rows with up to
+	gn incidences per relation. Called from the main thread only.
+*/
+static void par_worker_ensure(qrslv_system_t sys,struct par_worker *w
+		,int32 n, int32 gn
+){
+  if(n > w->cap) {
+    par_worker_destroy(w);
+    w->cap = n;
+    w->lsys = linsolqr_create();
+    w->mtx = mtx_create();
+    mtx_set_order(w->mtx,n);
+    linsolqr_set_matrix(w->lsys,w->mtx);
+    /* ranki_ba2 keeps its workspace in a global, so use kw2 */
+    linsolqr_prep(w->lsys,linsolqr_fmethod_to_fclass(ranki_kw2));
+    w->rhs = ASC_NEW_ARRAY(real64,n);
+    linsolqr_add_rhs(w->lsys,w->rhs,FALSE);
+    w->x = ASC_NEW_ARRAY(real64,n);
+    w->x0 = ASC_NEW_ARRAY(real64,n);
+    w->lo = ASC_NEW_ARRAY(real64,n);
+    w->hi = ASC_NEW_ARRAY(real64,n);
+    w->res = ASC_NEW_ARRAY(real64,n);
+  }
+  if(gn > w->gcap) {
+    destroy_array(w->grad);
+    w->grad = ASC_NEW_ARRAY(real64,gn);
+    w->gcap = gn;
+  }
+  linsolqr_set_pivot_zero(w->lsys, SLV_PARAM_REAL(&(sys->p),SING_TOL));
+  linsolqr_set_drop_tolerance(w->lsys, sys->p.tolerance.drop);
+  linsolqr_set_pivot_tolerance(w->lsys, SLV_PARAM_REAL(&(sys->p),PIVOT_TOL));
+}
+
+static void par_destroy(qrslv_system_t sys){
+  slv_block_dag_destroy(sys->par.dag);
+  sys->par.dag = NULL;
+  destroy_array(sys->par.state);
+  sys->par.state = NULL;
+  destroy_array(sys->par.level);
+  sys->par.level = NULL;
+  destroy_array(sys->par.cost);
+  sys->par.cost = NULL;
+}
+
+static void par_destroy_workers(qrslv_system_t sys){
+  int32 k;
+  for(k = 0; k < sys->par.nw; ++k) {
+    par_worker_destroy(&(sys->par.w[k]));
+  }
+  destroy_array(sys->par.w);
+  sys->par.w = NULL;
+  sys->par.nw = 0;
+}
+
+/**
+	Forget which blocks were solved, eg because the values have changed.
+*/
+static void par_reset(qrslv_system_t sys){
+  int32 nb = sys->s.block.number_of;
+  if(sys->par.state == NULL && nb > 0) {
+    sys->par.state = ASC_NEW_ARRAY(char,nb);
+    sys->par.level = ASC_NEW_ARRAY(int32,nb);
+    sys->par.cost = ASC_NEW_ARRAY(struct slv_block_cost,nb);
+  }
+  if(sys->par.state != NULL) {
+    memset(sys->par.state,PAR_UNTRIED,nb);
+  }
+}
+
+/**
+	Residuals of block rows r0..r0+n-1 into w->res, and the sum of their
+	squares into *norm2.
+	@return 0 if ok
+*/
+static int par_calc_residuals(struct par_sweep *sw, struct par_worker *w
+		,int32 r0, int32 n, real64 *norm2, struct slv_block_cost *cost
+){
+  int32 i;
+  double time0 = tm_cpu_time();
+  *norm2 = 0.0;
+  for(i = 0; i < n; ++i) {
+    if(relman_eval_threaded(sw->sys->rlist[r0+i],&(w->res[i]),NULL,sw->safe)) {
+      return 1;
+    }
+    *norm2 += w->res[i]*w->res[i];
+  }
+  cost->funcs++;
+  cost->functime += tm_cpu_time() - time0;
+  return !asc_finite(*norm2);
+}
+
+/** As block_feasible, for the residuals in w->res */
+static boolean par_converged(struct par_sweep *sw, struct par_worker *w
+		,int32 r0, int32 n
+){
+  int32 i;
+  real64 tol;
+  for(i = 0; i < n; ++i) {
+    tol = sw->tol;
+    if(sw->scaled) tol *= rel_nominal(sw->sys->rlist[r0+i]);
+    if(!(fabs(w->res[i]) <= tol)) return FALSE;
+  }
+  return TRUE;
+}
+
+/** pool task: solve one block of the wave */
+static void par_solve_task(void *data, int task, int thread){
+  struct par_sweep *sw = (struct par_sweep *)data;
+  qrslv_system_t sys = sw->sys;
+  struct par_worker *w = &(sys->par.w[thread]);
+  int32 b = sw->task[task];
+  struct slv_block_cost *cost = &(sys->par.cost[b]);
+  int32 r0 = sw->blocks->block[b].row.low;
+  int32 c0 = sw->blocks->block[b].col.low;
+  int32 n = sw->blocks->block[b].row.high - r0 + 1;
+  struct rel_relation *rel;
+  struct var_variable *var;
+  const struct var_variable **incid;
+  mtx_region_t reg;
+  mtx_coord_t coord;
+  real64 norm2, newnorm2, t, xn;
+  int32 i, j, k, it;
+  double time0 = tm_cpu_time(), time1;
+  boolean ok = FALSE;
+
+  memset(cost,0,sizeof(struct slv_block_cost));
+  cost->size = n;
+  cost->reorder_method = -1;
+  mtx_region(&reg,0,n-1,0,n-1);
+  mtx_reset_perm(w->mtx);
+  mtx_clear_region(w->mtx,mtx_ENTIRE_MATRIX);
+  for(j = 0; j < n; ++j) {
+    var = sys->vlist[c0+j];
+    w->x[j] = w->x0[j] = var_value(var);
+    w->lo[j] = var_lower_bound(var);
+    w->hi[j] = var_upper_bound(var);
+    if(sw->bounds) {
+      xn = MIN(MAX(w->x[j],w->lo[j]),w->hi[j]);
+      if(xn != w->x[j]) {
+        w->x[j] = xn;
+        var_set_value(var,xn);
+      }
+    }
+  }
+
+  if(par_calc_residuals(sw,w,r0,n,&norm2,cost)) goto done;
+  for(it = 0; ; ++it) {
+    if(par_converged(sw,w,r0,n)) {
+      ok = TRUE;
+      break;
+    }
+    if(it >= sw->maxit) break;
+
+    /* Jacobian, in org rows and cols 0..n-1 */
+    time1 = tm_cpu_time();
+    mtx_clear_region(w->mtx,&reg);
+    for(i = 0; i < n; ++i) {
+      rel = sys->rlist[r0+i];
+      if(relman_eval_threaded(rel,&(w->res[i]),w->grad,sw->safe)) goto done;
+      incid = rel_incidence_list(rel);
+      coord.row = i;
+      for(k = 0; k < rel_n_incidences(rel); ++k) {
+        coord.col = var_sindex(incid[k]) - c0;
+        if(coord.col < 0 || coord.col >= n) continue;
+        mtx_fill_org_value(w->mtx,&coord,w->grad[k]);
+      }
+    }
+    cost->jacs++;
+    cost->jactime += tm_cpu_time() - time1;
+
+    linsolqr_matrix_was_changed(w->lsys);
+    if(linsolqr_reorder(w->lsys,&reg,spk1)) goto done;
+    if(linsolqr_factor(w->lsys,ranki_kw2)) goto done;
+    if(linsolqr_rank(w->lsys) < n) goto done;
+    for(i = 0; i < n; ++i) {
+      w->rhs[i] = -w->res[i];
+    }
+    linsolqr_rhs_was_changed(w->lsys,w->rhs);
+    linsolqr_solve(w->lsys,w->rhs);
+
+    /* halve the step until the residuals go down */
+    for(t = 1.0, k = 0; ; t *= 0.5, ++k) {
+      for(j = 0; j < n; ++j) {
+        xn = w->x[j] + t*linsolqr_var_value(w->lsys,w->rhs,j);
+        if(sw->bounds) xn = MIN(MAX(xn,w->lo[j]),w->hi[j]);
+        var_set_value(sys->vlist[c0+j],xn);
+      }
+      if(!par_calc_residuals(sw,w,r0,n,&newnorm2,cost) && newnorm2 < norm2) {
+        break;
+      }
+      if(k >= sw->maxminor) goto done;
+    }
+    norm2 = newnorm2;
+    for(j = 0; j < n; ++j) {
+      w->x[j] = var_value(sys->vlist[c0+j]);
+    }
+    cost->iterations++;
+  }
+
+done:
+  if(!ok) {
+    for(j = 0; j < n; ++j) {
+      var_set_value(sys->vlist[c0+j],w->x0[j]);
+    }
+  }
+  cost->resid = sqrt(norm2);
+  cost->time = tm_cpu_time() - time0;
+  sw->ok[task] = (char)ok;
+  if(thread != 0) {
+    /* nothing of the pool threads' own is kept between sweeps */
+    mtx_free_reused_mem();
+  }
+}
+
+/**
+	Check whether block b is small enough and made of relations that the
+	workers can evaluate, returning the most incidences of any of its
+	relations in *gn.
+*/
+static boolean par_block_eligible(qrslv_system_t sys, const mtx_region_t *reg
+		,int32 *gn
+){
+  int32 r, n = reg->row.high - reg->row.low + 1;
+  if(n != reg->col.high - reg->col.low + 1
+      || n > SLV_PARAM_INT(&(sys->p),PAR_BLOCK_SIZE)
+  ) {
+    return FALSE;
+  }
+  *gn = 1;
+  for(r = reg->row.low; r <= reg->row.high; ++r) {
+    if(!relman_threadable(sys->rlist[r])) return FALSE;
+    *gn = MAX(*gn,rel_n_incidences(sys->rlist[r]));
+  }
+  return TRUE;
+}
+
+/**
+	Called on moving to a block. If it hasn't been looked at, solve it and
+	the later blocks that are ready ahead, on the worker threads.
+*/
+static void par_solve_ahead(qrslv_system_t sys){
+  struct par_data *par = &(sys->par);
+  struct par_sweep sw;
+  threadpool_t *pool;
+  int32 cur = sys->s.block.current_block;
+  int32 nb = sys->s.block.number_of;
+  int32 b, k, d, lev, nlev, nqueued, ntask, maxn, maxg, gn, oldtiming;
+
+  if(par->state == NULL || cur >= nb
+      || (par->state[cur] != PAR_UNTRIED && par->state[cur] != PAR_WAITING)
+  ) {
+    return;
+  }
+  if(nb < 2 || OPTIMIZING(sys) || SLV_PARAM_INT(&(sys->p),PAR_BLOCK_SIZE) <= 0
+      || (pool = relman_get_pool()) == NULL
+  ) {
+    memset(par->state,PAR_SERIAL,nb);
+    return;
+  }
+  if(par->dag == NULL) {
+    par->dag = slv_block_dag_create(SERVER);
+    if(par->dag == NULL || par->dag->nblocks != nb) {
+      memset(par->state,PAR_SERIAL,nb);
+      return;
+    }
+  }
+  sw.blocks = slv_get_solvers_blocks(SERVER);
+
+  /* queue the blocks which are ready, or will be once those before them
+     in the queue are solved */
+  nqueued = nlev = 0;
+  maxn = maxg = 1;
+  for(b = cur; b < nb; ++b) {
+    if(par->state[b] == PAR_UNTRIED) {
+      par->state[b] = par_block_eligible(sys,&(sw.blocks->block[b]),&gn)
+        ? PAR_WAITING : PAR_SERIAL;
+    }
+    if(par->state[b] != PAR_WAITING) continue;
+    lev = 0;
+    for(k = par->dag->start[b]; k < par->dag->start[b+1]; ++k) {
+      d = par->dag->dep[k];
+      if(d < cur || par->state[d] == PAR_SOLVED) continue;
+      if(par->state[d] != PAR_QUEUED) break;
+      lev = MAX(lev,par->level[d] + 1);
+    }
+    if(k < par->dag->start[b+1]) continue;
+    par->state[b] = PAR_QUEUED;
+    par->level[b] = lev;
+    nlev = MAX(nlev,lev + 1);
+    ++nqueued;
+    par_block_eligible(sys,&(sw.blocks->block[b]),&gn);
+    maxn = MAX(maxn,sw.blocks->block[b].row.high - sw.blocks->block[b].row.low + 1);
+    maxg = MAX(maxg,gn);
+  }
+  if(nqueued < 2) {
+    /* nothing to gain: leave this block to the usual iteration */
+    for(b = cur; b < nb; ++b) {
+      if(par->state[b] == PAR_QUEUED) par->state[b] = PAR_WAITING;
+    }
+    par->state[cur] = PAR_SERIAL;
+    return;
+  }
+
+  if(par->w == NULL) {
+    par->nw = threadpool_size(pool);
+    par->w = ASC_NEW_ARRAY_CLEAR(struct par_worker,par->nw);
+  }
+  for(k = 0; k < par->nw; ++k) {
+    par_worker_ensure(sys,&(par->w[k]),maxn,maxg);
+  }
+  sw.sys = sys;
+  sw.task = ASC_NEW_ARRAY(int32,nqueued);
+  sw.ok = ASC_NEW_ARRAY(char,nqueued);
+  sw.tol = SLV_PARAM_REAL(&(sys->p),FEAS_TOL);
+  sw.scaled = (strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"RELNOM_SCALE") == 0);
+  sw.safe = SLV_PARAM_BOOL(&(sys->p),SAFE_CALC);
+  sw.bounds = !(sys->p.ignore_bounds);
+  sw.maxit = SLV_PARAM_INT(&(sys->p),ITER_LIMIT);
+  sw.maxminor = SLV_PARAM_INT(&(sys->p),MAX_MINOR);
+
+  oldtiming = g_linsolqr_timing;
+  g_linsolqr_timing = SLV_PARAM_BOOL(&(sys->p),LINTIME);
+#ifdef ASC_SIGNAL_TRAPS
+  Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
+#endif
+  for(lev = 0; lev < nlev; ++lev) {
+    ntask = 0;
+    for(b = cur; b < nb; ++b) {
+      if(par->state[b] != PAR_QUEUED || par->level[b] != lev) continue;
+      for(k = par->dag->start[b]; k < par->dag->start[b+1]; ++k) {
+        d = par->dag->dep[k];
+        if(d >= cur && par->state[d] != PAR_SOLVED) break;
+      }
+      if(k < par->dag->start[b+1]) {
+        par->state[b] = PAR_WAITING; /* a dep failed */
+      }else{
+        sw.task[ntask++] = b;
+      }
+    }
+    if(ntask == 0) continue;
+    threadpool_run(pool,ntask,&par_solve_task,&sw);
+    for(k = 0; k < ntask; ++k) {
+      par->state[sw.task[k]] = sw.ok[k] ? PAR_SOLVED : PAR_SERIAL;
+    }
+  }
+#ifdef ASC_SIGNAL_TRAPS
+  Asc_SignalHandlerPop(SIGFPE,SIG_IGN);
+#endif
+  g_linsolqr_timing = oldtiming;
+  ascfree(sw.task);
+  ascfree(sw.ok);
+
+  if(par->state[cur] != PAR_SOLVED) par->state[cur] = PAR_SERIAL;
+}
+
 /*------------------------------------------------------------------------------
   BLOCK ROUTINES
 */
@@ -2500,6 +2955,22 @@ static void move_to_next_block( qrslv_system_t sys){
     sys->s.block.funcs = 0;
     sys->s.block.jacs = 0;
 
+    if(!OPTIMIZING(sys)) {
+      par_solve_ahead(sys);
+      if(sys->par.state != NULL
+          && sys->par.state[sys->s.block.current_block] == PAR_SOLVED
+      ) {
+        /* solved ahead, so start from the cost of the worker */
+        ci = sys->s.block.current_block;
+        sys->s.block.iteration = sys->par.cost[ci].iterations;
+        sys->s.block.cpu_elapsed = sys->par.cost[ci].time;
+        sys->s.block.functime = sys->par.cost[ci].functime;
+        sys->s.block.jactime = sys->par.cost[ci].jactime;
+        sys->s.block.funcs = sys->par.cost[ci].funcs;
+        sys->s.block.jacs = sys->par.cost[ci].jacs;
+      }
+    }
+
     if(SLV_PARAM_BOOL(&(sys->p),SHOW_LESS_IMPT) && (SLV_PARAM_BOOL(&(sys->p),LIFDS) ||
       sys->s.block.current_size > 1)) {
       debug_delimiter(LIF(sys));
@@ -2650,6 +3121,12 @@ static void reorder_new_block(qrslv_system_t sys){
   if(sys->s.block.current_block < sys->s.block.number_of ) {
     if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"SPK1") == 0) {
       method = 2;
+    }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"AMD") == 0) {
+      method = 3;
+    }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"COLAMD") == 0) {
+      method = 4;
+    }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"AUTO") == 0) {
+      method = 5;
     }else{
       method = 1;
     }
@@ -2672,6 +3149,17 @@ static void reorder_new_block(qrslv_system_t sys){
     if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"SPK1") == 0) {
       sys->s.cost[sys->s.block.current_block].reorder_method = 2;
       slv_spk1_reorder_block(SERVER,sys->s.block.current_block,1);
+    }else if(method == 3 || method == 4) {
+      sys->s.cost[sys->s.block.current_block].reorder_method = method;
+      slv_reorder_block(SERVER,sys->s.block.current_block
+        ,(method == 3 ? mtx_AMD : mtx_COLAMD), NULL
+      );
+    }else if(method == 5) {
+      enum mtx_reorder_method used;
+      sys->s.cost[sys->s.block.current_block].reorder_method = 5;
+      slv_least_fill_reorder_block(SERVER,sys->s.block.current_block
+        ,SLV_PARAM_INT(&(sys->p),AMD_CUTOFF), &used
+      );
     }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),REORDER_OPTION),"TEAR_DROP") == 0) {
       sys->s.cost[sys->s.block.current_block].reorder_method = 1;
       slv_tear_drop_reorder_block(SERVER,sys->s.block.current_block
@@ -2830,7 +3318,7 @@ int32 qrslv_get_default_parameters(slv_system_t server, SlvClientToken asys
   }
 
   parameters->num_parms = 0;
-  asc_assert(qrslv_PA_SIZE==44);
+  asc_assert(qrslv_PA_SIZE==46);
   /* begin defining parameters */
 
   slv_param_bool(parameters,IGNORE_BOUNDS
@@ -3054,7 +3542,25 @@ int32 qrslv_get_default_parameters(slv_system_t server, SlvClientToken asys
   	,(SlvParameterInitChar){{"reorder"
   		,"reorder method",1
   		,"Block reordering algorithm."
-  	}, "SPK1"}, (char*[]){"SPK1","TEAR_DROP","OVER_TEAR",NULL}
+  	}, "SPK1"}, (char*[]){"SPK1","TEAR_DROP","OVER_TEAR","AMD","COLAMD","AUTO",NULL}
+  );
+
+  slv_param_int(parameters,AMD_CUTOFF
+  	,(SlvParameterInitInt){{"amdcutoff"
+  		,"block size cutoff (AUTO)",2
+  		,"With reorder AUTO, blocks of at least this size are ordered by both"
+  		" SPK1 and AMD, keeping whichever is predicted to give less fill"
+  	}, 200, 0, 1000000}
+  );
+
+  slv_param_int(parameters,PAR_BLOCK_SIZE
+  	,(SlvParameterInitInt){{"parblocksize"
+  		,"largest block solved concurrently",2
+  		,"Blocks up to this size that do not depend on each other are solved"
+  		" at the same time on the relman worker threads (ASCEND_NUM_THREADS),"
+  		" each by a plain Newton iteration with step halving rather than the"
+  		" usual QRSlv step control. 0 (the default) solves all blocks in turn."
+  	}, 0, 0, 1000000}
   );
 
   slv_param_real(parameters,TOO_SMALL
@@ -3272,6 +3778,7 @@ static void destroy_vectors( qrslv_system_t sys)
    destroy_array(sys->mulstep2.vec);
    destroy_array(sys->varstep.vec);
    destroy_array(sys->mulstep.vec);
+   destroy_array(sys->blockrels);
 }
 
 static int qrslv_eligible_solver(slv_system_t server)
@@ -3467,6 +3974,7 @@ qrslv_system_t sys;
   sys->variables.rng = &(sys->J.reg.col);
   sys->residuals.vec = ASC_NEW_ARRAY_OR_NULL(real64,sys->cap);
   sys->residuals.rng = &(sys->J.reg.row);
+  sys->blockrels = ASC_NEW_ARRAY_OR_NULL(struct rel_relation *,sys->cap);
   if(OPTIMIZING(sys)){
     sys->gradient.vec = ASC_NEW_ARRAY_OR_NULL(real64,sys->cap);
     sys->gradient.rng = &(sys->J.reg.col);
@@ -3657,6 +4165,7 @@ static int qrslv_presolve(slv_system_t server, SlvClientToken asys){
     sys->J.old_partition = SLV_PARAM_BOOL(&(sys->p),PARTITION);
     destroy_matrices(sys);
     destroy_vectors(sys);
+    par_destroy(sys);
     create_matrices(server,sys);
     create_vectors(sys);
 
@@ -3682,6 +4191,8 @@ static int qrslv_presolve(slv_system_t server, SlvClientToken asys){
     reset_cost(sys->s.cost,sys->s.costsize);
   }
 
+  par_reset(sys);
+
   /* set to go to first unconverged block */
   sys->s.block.current_block = -1;
   sys->s.block.current_size = 0;
@@ -3750,6 +4261,8 @@ static int qrslv_resolve(slv_system_t server, SlvClientToken asys){
   sys->s.converged = sys->s.diverged = sys->s.inconsistent = FALSE;
   sys->s.block.previous_total_size = 0;
 
+  par_reset(sys);
+
   /* go to first unconverged block */
   sys->s.block.current_block = -1;
   sys->s.block.current_size = 0;
@@ -4225,6 +4738,8 @@ static int qrslv_destroy(slv_system_t server, SlvClientToken asys){
   slv_destroy_parms(&(sys->p));
   destroy_matrices(sys);
   destroy_vectors(sys);
+  par_destroy(sys);
+  par_destroy_workers(sys);
   sys->integrity = DESTROYED;
   if(sys->s.cost) ascfree(sys->s.cost);
   ascfree( (POINTER)asys );
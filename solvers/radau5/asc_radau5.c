@@ -88,26 +88,23 @@ typedef struct IntegratorRadau5DataStruct
 }
 IntegratorRadau5Data;
 
-/** DONT KNOW IF THIS STUFF IS NEEDED*/
-static IntegratorSystem *l_blsys = 0;
-/** Macro to declare a local var and fetch the 'enginedata' stuff into it from l_radau5_blsys. */
-#define RADAU5DATA_GET(N) \
+/**
+	RADAU5 passes its RPAR argument through to the callbacks untouched, so
+	instead of an array of reals we hand it the IntegratorSystem.
+*/
+#define RADAU5_RPAR(B) ((double *)(void *)(B))
+
+/**
+	Macro to declare local vars B and N and fetch the IntegratorSystem and
+	its 'enginedata' into them from the RPAR argument of a callback.
+*/
+#define RADAU5DATA_GET(RPAR,B,N) \
+	IntegratorSystem *B; \
 	IntegratorRadau5Data *N; \
-	asc_assert(l_blsys!=NULL); \
-	N = (IntegratorRadau5Data *)l_blsys->enginedata; \
+	B = (IntegratorSystem *)(void *)(RPAR); \
+	asc_assert(B!=NULL); \
+	N = (IntegratorRadau5Data *)B->enginedata; \
 	asc_assert(N!=NULL)
-
-/** Macro to set the global l_radau5_blsys to the currently blsys ptr. */
-#define RADAU5DATA_SET(N) \
-	asc_assert(l_blsys==NULL); \
-	asc_assert(N!=NULL); \
-	l_blsys = N
-
-#define RADAU5DATA_RELEASE() \
-	asc_assert(l_blsys!=NULL); \
-	l_blsys = NULL;
-
-/** END DONT KNOW STUFF */
 /**
 ALLOCATE AND FREE MEMORY 
 */
@@ -312,7 +309,7 @@ static void integrator_radau5_fex(
 		double *rpar, int* ipar)
 {
 	slv_status_t status;
-	RADAU5DATA_GET(radau5data);
+	RADAU5DATA_GET(rpar,blsys,radau5data);
 	int i;
 	unsigned long res;
 
@@ -320,24 +317,24 @@ static void integrator_radau5_fex(
 	//CONSOLE_DEBUG("t = %e",*t);
 	//CONSOLE_DEBUG("t = %p",blsys);
 	/* pass the time and the unknowns back to the System */
-	integrator_set_t (l_blsys, *t);
+	integrator_set_t (blsys, *t);
 	//CONSOLE_DEBUG("%e",*t);
-	integrator_set_y (l_blsys, y);
+	integrator_set_y (blsys, y);
 
 	//CONSOLE_DEBUG("t = %p",t);
 
-	asc_assert(l_blsys->system);
+	asc_assert(blsys->system);
 
-	slv_resolve(l_blsys->system);
+	slv_resolve(blsys->system);
 
-	if((res = slv_solve(l_blsys->system))){
+	if((res = slv_solve(blsys->system))){
 		CONSOLE_DEBUG("solver returns error %ld",res);
 	}
 
-	slv_get_status(l_blsys->system, &status);
+	slv_get_status(blsys->system, &status);
 
 
-	if(slv_check_bounds(l_blsys->system,0,-1,"")){
+	if(slv_check_bounds(blsys->system,0,-1,"")){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Variables went outside boundaries...");
 		// TODO relay that system has gone out of bounds
 	}
@@ -345,7 +342,7 @@ static void integrator_radau5_fex(
 	/* pass the NLA solver status to the integrator */
 	res = integrator_checkstatus(status);
 
-	integrator_output_write(l_blsys);
+	integrator_output_write(blsys);
 
   	if(res){
 		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Failed to solve for derivatives (%d)",res);
@@ -364,7 +361,7 @@ static void integrator_radau5_fex(
 		/* ERROR_REPORTER_HERE(ASC_PROG_NOTE,"lsodedata->status = %d",lsodedata->status); */
 	}
 
-	integrator_get_ydot(l_blsys, ydot);
+	integrator_get_ydot(blsys, ydot);
 	//CONSOLE_DEBUG("Check");
 
 #ifdef RADAU5_DEBUG
@@ -406,22 +403,22 @@ static void integrator_radau5_solout(int *nr,double *xold,double *x,
 	
 	double t = *x;
 	double ts;
-	RADAU5DATA_GET(d);
+	RADAU5DATA_GET(rpar,blsys,d);
 
-	ts = integrator_getsample(l_blsys,d->currentsample);
+	ts = integrator_getsample(blsys,d->currentsample);
 
 	if(t>ts){
 		//CONSOLE_DEBUG("t=%f > ts=%f (currentsample = %ld",t,ts,d->currentsample);
-		integrator_output_write_obs(l_blsys);
+		integrator_output_write_obs(blsys);
 		while(t>ts){
 			d->currentsample++;
-			l_blsys->currentstep++;
-			ts = integrator_getsample(l_blsys,d->currentsample);
+			blsys->currentstep++;
+			ts = integrator_getsample(blsys,d->currentsample);
 		}
 	}
 
 	//CONSOLE_DEBUG("t = %f, y[0] = %f",t,y[0]);
-	integrator_output_write(l_blsys);
+	integrator_output_write(blsys);
 
 }
 /** END DEFINING*/
@@ -536,7 +533,6 @@ unsigned long start_index, unsigned long finish_index
 	int i,idid;
 	double x,xend;
 	double h,hmax;
-	double rpar=0.0;
 	int mljac = my_neq;
 	int mujac=0;
 	int mlmas=0;
@@ -544,6 +540,8 @@ unsigned long start_index, unsigned long finish_index
 	int ipar=0;
 	int iout=1;
 	double *y, atol, rtol, *obs;
+	double comrsav[4];
+	int comisav[11], comsave = 1, comrestore = 2; /* for radsrc_ */
 
 # ifdef memory_debug
 	CONSOLE_DEBUG("lwork = %d,liwork= %d,equations = %d",lwork,liwork,my_neq);
@@ -613,10 +611,15 @@ unsigned long start_index, unsigned long finish_index
 	# endif /* ASC_SIGNAL_TRAPS */
 	d->lastwrite = clock();
 #ifdef PARAMETER_DEBUG
-	CONSOLE_DEBUG("printing everythin %d %e %e %e %d %d %d %d %d %e %d %d",my_neq,x,xend,h,mljac,mujac,mlmas,mumas,iout,rpar,ipar,idid);
+	CONSOLE_DEBUG("printing everythin %d %e %e %e %d %d %d %d %d %e %d %d",my_neq,x,xend,h,mljac,mujac,mlmas,mumas,iout,0.0,ipar,idid);
 #endif
 	CONSOLE_DEBUG("solving started");
-	RADAU5DATA_SET(blsys);
+	/*
+		COMMON /CONRA5/ and /LINAL/ are threadprivate (see radau5.f) and set
+		up afresh by each RADAU5 call; keep the caller's, in case this
+		integration was started from a callback of another on this thread.
+	*/
+	radsrc_(comrsav, comisav, &comsave);
 	radau5_( &my_neq, &integrator_radau5_fex,	// Function
 		&x, y, &xend, &h, &rtol, &atol, &itol,
 		&integrator_radau5_jex,	// jacobian
@@ -624,14 +627,20 @@ unsigned long start_index, unsigned long finish_index
 		&integrator_radau5_mex,	// mass matrix
 		 &imas, &mlmas, &mumas,
 		&integrator_radau5_solout,// sol_out 
-		 &iout, work, &lwork, iwork, &liwork, &rpar, &ipar, &idid);
-	RADAU5DATA_RELEASE();
+		 &iout, work, &lwork, iwork, &liwork, RADAU5_RPAR(blsys), &ipar, &idid);
+	radsrc_(comrsav, comisav, &comrestore);
+# ifdef ASC_SIGNAL_TRAPS
+	Asc_SignalFPECheck();
+# endif
 	res = idid; // res takes idid value
 	free(work);
 	free(iwork); 
 	CONSOLE_DEBUG("solving ended");
 # ifdef ASC_SIGNAL_TRAPS
 		}else{
+			radsrc_(comrsav, comisav, &comrestore);
+			Asc_SignalHandlerPopDefault(SIGFPE);
+			Asc_SignalHandlerPopDefault(SIGINT);
 			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Integration terminated due to float error in RADAU5 call.");
 			RADAU5_FREE;//DOPRI5_FREE; /* FIXME what's this for? */
 			return 6;
@@ -9,6 +9,7 @@ C
      &          IP1(NM1),IPHES(N)
       LOGICAL CALHES
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,14,15), IJOB
 C
@@ -214,6 +215,7 @@ C
       DIMENSION FJAC(LDJAC,N),FMAS(LDMAS,NM1),
      &          E2R(LDE1,NM1),E2I(LDE1,NM1),IP2(NM1)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,14,15), IJOB
 C
@@ -462,6 +464,7 @@ C
       DIMENSION FJAC(LDJAC,N),FMAS(LDMAS,NM1),E1(LDE1,NM1),
      &          IP1(NM1),IPHES(N),Z1(N),F1(N)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,13,15), IJOB
 C
@@ -673,6 +676,7 @@ C
      &          IP2(NM1),IPHES(N),Z2(N),Z3(N),F2(N),F3(N)
       DIMENSION E2R(LDE1,NM1),E2I(LDE1,NM1)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,13,15), IJOB
 C
@@ -952,6 +956,7 @@ C
      &          E2R(LDE1,NM1),E2I(LDE1,NM1),IP1(NM1),IP2(NM1),
      &          IPHES(N),Z1(N),Z2(N),Z3(N),F1(N),F2(N),F3(N)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,13,15), IJOB
 C
@@ -1280,6 +1285,7 @@ C
       DIMENSION CONT(N),RPAR(1),IPAR(1)
       LOGICAL FIRST,REJECT
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
       HEE1=DD1/H
       HEE2=DD2/H
       HEE3=DD3/H
@@ -1611,6 +1617,7 @@ C
       DIMENSION DD(NS),CONT(N),RPAR(1),IPAR(1)
       LOGICAL FIRST,REJECT
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
       GOTO (1,2,3,4,5,6,7,55,55,55,11,12,13,14,15), IJOB
 C
    1  CONTINUE
@@ -1994,6 +2001,7 @@ C
      &          IP(NM1),DY(N),AK(N),FX(N),YNEW(N)
       LOGICAL STAGE1
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       IF (HD.EQ.0.D0) THEN
          DO  I=1,N
@@ -2204,6 +2212,7 @@ C
       DIMENSION FJAC(LDJAC,N),FMAS(LDMAS,NM1),E(LDE,NM1),DEL(N)
       DIMENSION IP(NM1),IPHES(N)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
 C
       GOTO (1,2,1,2,1,55,7,55,55,55,11,12,11,12,11), IJOB
 C
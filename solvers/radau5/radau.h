@@ -15,6 +15,10 @@ void radau5_(int *N,
 /* Interface to the FORTRAN function for contignuous output.(see above) */
 double contr5_(int *I, double *S, double *CONT, int *LRC);
 
+/* FORTRAN function. Saves (JOB=1) or restores (JOB=2) the COMMON blocks
+   of RADAU5 for the calling thread; RSAV has length 4, ISAV 11. */
+void radsrc_(double *RSAV, int *ISAV, int *JOB);
+
 /* FORTRAN function.
    Prints the FORTRAN interpretation of the (n,m)-matrix A */
 void PRINT_MAT(int *n, int *m, double *A);
@@ -684,7 +684,9 @@ C ----------------------------------------------------------
       DIMENSION ATOL(*),RTOL(*),RPAR(*),IPAR(*)
       INTEGER IP1(NM1),IP2(NM1),IPHES(NM1)
       COMMON /CONRA5/NN,NN2,NN3,NN4,XSOL,HSOL,C2M1,C1M1
+C$OMP THREADPRIVATE(/CONRA5/)
       COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
       LOGICAL REJECT,FIRST,IMPLCT,BANDED,CALJAC,STARTN,CALHES
       LOGICAL INDEX1,INDEX2,INDEX3,LAST,PRED
       EXTERNAL FCN
@@ -1137,6 +1139,7 @@ C ----------------------------------------------------------
       IMPLICIT DOUBLE PRECISION (A-H,O-Z)
       DIMENSION CONT(LRC)
       COMMON /CONRA5/NN,NN2,NN3,NN4,XSOL,HSOL,C2M1,C1M1
+C$OMP THREADPRIVATE(/CONRA5/)
       S=(X-XSOL)/HSOL
       CONTR5=CONT(I)+S*(CONT(I+NN)+(S-C2M1)*(CONT(I+NN2)
      &     +(S-C1M1)*CONT(I+NN3)))
@@ -1146,3 +1149,54 @@ C
 C     END OF FUNCTION CONTR5
 C
 C ***********************************************************
+C
+      SUBROUTINE RADSRC(RSAV,ISAV,JOB)
+C ----------------------------------------------------------
+C     SAVES (JOB=1) OR RESTORES (JOB=2) THE CONTENTS OF THE
+C     COMMON BLOCKS CONRA5 AND LINAL OF THE CALLING THREAD.
+C     RSAV MUST HAVE LENGTH 4 AND ISAV LENGTH 11 OR MORE.
+C ----------------------------------------------------------
+      IMPLICIT DOUBLE PRECISION (A-H,O-Z)
+      DIMENSION RSAV(4),ISAV(11)
+      COMMON /CONRA5/NN,NN2,NN3,NN4,XSOL,HSOL,C2M1,C1M1
+C$OMP THREADPRIVATE(/CONRA5/)
+      COMMON/LINAL/MLE,MUE,MBJAC,MBB,MDIAG,MDIFF,MBDIAG
+C$OMP THREADPRIVATE(/LINAL/)
+      IF (JOB.EQ.2) GOTO 100
+      RSAV(1)=XSOL
+      RSAV(2)=HSOL
+      RSAV(3)=C2M1
+      RSAV(4)=C1M1
+      ISAV(1)=NN
+      ISAV(2)=NN2
+      ISAV(3)=NN3
+      ISAV(4)=NN4
+      ISAV(5)=MLE
+      ISAV(6)=MUE
+      ISAV(7)=MBJAC
+      ISAV(8)=MBB
+      ISAV(9)=MDIAG
+      ISAV(10)=MDIFF
+      ISAV(11)=MBDIAG
+      RETURN
+ 100  XSOL=RSAV(1)
+      HSOL=RSAV(2)
+      C2M1=RSAV(3)
+      C1M1=RSAV(4)
+      NN=ISAV(1)
+      NN2=ISAV(2)
+      NN3=ISAV(3)
+      NN4=ISAV(4)
+      MLE=ISAV(5)
+      MUE=ISAV(6)
+      MBJAC=ISAV(7)
+      MBB=ISAV(8)
+      MDIAG=ISAV(9)
+      MDIFF=ISAV(10)
+      MBDIAG=ISAV(11)
+      RETURN
+      END
+C
+C     END OF SUBROUTINE RADSRC
+C
+C ***********************************************************
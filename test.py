@@ -20,7 +20,7 @@
 # this is still experimental.
 
 import unittest
-import os, sys
+import os, sys, tempfile, array
 from pathlib import Path
 import math
 import atexit
@@ -250,6 +250,39 @@ class TestSolver(AscendSelfTester):
 		self.assertAlmostEqual( float(M.z), 4.61043629206)
 
 
+class TestEnsemble(Ascend):
+
+	def testsweep(self):
+		self.L.load('johnpye/testlog10.a4c')
+		T = self.L.findType('testlog10')
+		M = T.getSimulation('sim',True)
+		M.build()
+		E = ascpy.Ensemble(M)
+		E.addParameter('x')
+		E.addOutput('y')
+		E.addOutput('z')
+		xs = [1.5 + 0.5*j for j in range(40)]
+		E.addCases([[x] for x in xs])
+		views = []
+		for n in [1,4]:
+			E.setNumProcesses(n)
+			E.solve(ascpy.Solver('QRSlv'))
+			assert E.getNumOK() == len(xs)
+			y = E.getOutputColumn(0)
+			z = E.getOutputColumn(1)
+			assert len(y) == len(xs) and y.format == 'd'
+			for j,x in enumerate(xs):
+				self.assertAlmostEqual(y[j], math.log10(x))
+				self.assertAlmostEqual(z[j], math.log(x))
+			views.append(y)
+		# the view from the first run is unchanged by the second, and
+		# outlives the Ensemble
+		del E
+		for j,x in enumerate(xs):
+			self.assertAlmostEqual(views[0][j], math.log10(x))
+		# the simulation is left as it was
+		self.assertAlmostEqual(float(M.x), 10)
+
 class TestBinTokens(AscendSelfTester):
 
 	def test1(self):
@@ -467,6 +500,47 @@ class TestLSODE(Ascend):
 		assert abs(M.R - 832) < 1.0
 		assert abs(M.F - 21.36) < 0.1
 
+	def testobservations(self):
+		self.L.load('johnpye/lotka.a4c')
+		M = self.L.findType('lotka').getSimulation('sim',True)
+		M.setSolver(ascpy.Solver("QRSlv"))
+		I = ascpy.Integrator(M)
+		I.setEngine('LSODE')
+		I.setReporter(ascpy.IntegratorReporterCxx(I))
+		I.setLinearTimesteps(ascpy.Units("s"), 0, 200, 5)
+		I.analyse()
+		I.solve()
+		n = I.getNumObservations()
+		assert n >= 5
+		t = I.getObservationTimes()
+		assert len(t) == n and t.format == 'd'
+		assert abs(t[-1] - 200) < 1e-8
+		rows = I.getObservations()
+		for i in range(I.getNumObservedVars()):
+			c = I.getObservationColumn(i)
+			assert list(c) == [r[i] for r in rows]
+		c0 = list(c)
+
+		# again, written to a file in small blocks (the run continues from
+		# where the last one finished, so only the times will match)
+		fn = os.path.join(tempfile.gettempdir(),'lotka_obs.bin')
+		I.setObservationFile(fn,2)
+		I.solve()
+		assert I.getNumObservations() == n
+		w = I.getNumObservedVars() + 1
+		data = array.array('d')
+		with open(fn,'rb') as f:
+			data.frombytes(f.read())
+		os.remove(fn)
+		assert len(data) == n*w
+		for j in range(n):
+			assert data[j*w] == rows[j][-1]
+
+		# views keep their values through the next solve, and outlive I
+		assert list(c) == c0
+		del I
+		assert list(t) == [r[-1] for r in rows]
+
 	def testwritegraph(self):
 		self.L.load('johnpye/lotka.a4c')
 		M = self.L.findType('lotka').getSimulation('sim',1)